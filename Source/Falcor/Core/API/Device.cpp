@@ -382,7 +382,8 @@ inline Device::ShaderModel querySupportedShaderModel(gfx::IDevice* pDevice)
 Device::Device(const Desc& desc) : mDesc(desc)
 {
     // Create a global slang session passed to GFX and used for compiling programs in ProgramManager.
-    slang::createGlobalSession(mSlangGlobalSession.writeRef());
+    if (SLANG_FAILED(slang::createGlobalSession(mSlangGlobalSession.writeRef())))
+        throw RuntimeError("Failed to create Slang global session");
 
     if (mDesc.type == Type::Default)
         mDesc.type = getDefaultDeviceType();
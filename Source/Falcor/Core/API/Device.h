@@ -99,6 +99,12 @@ public:
         /// The full path to the root directory for the shader cache. An empty string will disable the cache.
         std::string shaderCachePath = (getRuntimeDirectory() / ".shadercache").string();
 
+        /// The full path to the root directory for the kernel cache used by the program manager. An empty string will disable the cache.
+        std::string kernelCachePath = (getRuntimeDirectory() / ".kernelcache").string();
+
+        /// The maximum total size of the kernel cache in bytes. Least recently used kernels are evicted when it is exceeded.
+        uint64_t maxKernelCacheSize = 512ull * 1024 * 1024;
+
 #if FALCOR_HAS_D3D12
         /// GUID list for experimental features
         std::vector<GUID> experimentalFeatures;
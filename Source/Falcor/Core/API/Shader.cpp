@@ -28,16 +28,23 @@
 #include "Shader.h"
 #include "Device.h"
 #include "GFXAPI.h"
+#include "Core/Program/KernelCache.h"
 
 namespace Falcor
 {
 struct ShaderData
 {
-    Shader::Blob pBlob;
     Slang::ComPtr<slang::IComponentType> pLinkedSlangEntryPoint;
-    ISlangBlob* getBlob()
+    std::shared_ptr<KernelCache> pKernelCache;
+    std::optional<SHA1::MD> cacheKey;
+    std::optional<std::vector<uint8_t>> code;
+
+    const std::vector<uint8_t>& getCode()
     {
-        if (!pBlob)
+        if (!code && pKernelCache && cacheKey)
+            code = pKernelCache->get(*cacheKey);
+
+        if (!code)
         {
             Slang::ComPtr<ISlangBlob> pSlangBlob;
             Slang::ComPtr<ISlangBlob> pDiagnostics;
@@ -46,9 +53,13 @@ struct ShaderData
             {
                 throw RuntimeError(std::string("Shader compilation failed. \n") + (const char*)pDiagnostics->getBufferPointer());
             }
-            pBlob = Shader::Blob(pSlangBlob.get());
+            const uint8_t* pData = static_cast<const uint8_t*>(pSlangBlob->getBufferPointer());
+            code = std::vector<uint8_t>(pData, pData + pSlangBlob->getBufferSize());
+
+            if (pKernelCache && cacheKey)
+                pKernelCache->set(*cacheKey, code->data(), code->size());
         }
-        return pBlob.get();
+        return *code;
     }
 };
 
@@ -63,7 +74,9 @@ bool Shader::init(
     Slang::ComPtr<slang::IComponentType> slangEntryPoint,
     const std::string& entryPointName,
     CompilerFlags flags,
-    std::string& log
+    std::string& log,
+    std::shared_ptr<KernelCache> pKernelCache,
+    std::optional<SHA1::MD> cacheKey
 )
 {
     // In GFX, we do not generate actual shader code at program creation.
@@ -75,18 +88,22 @@ bool Shader::init(
     // Since most users/render-passes do not need to get shader kernel code, we defer
     // the call to slang's `getEntryPointCode` function until it is actually needed.
     // to avoid redundant shader compiler invocation.
-    mpPrivateData->pBlob = nullptr;
+    // If a kernel cache is given, the code is looked up in the cache first and stored in it after compilation,
+    // which avoids running the downstream compiler in later runs.
+    mpPrivateData->code.reset();
     mpPrivateData->pLinkedSlangEntryPoint = slangEntryPoint;
+    mpPrivateData->pKernelCache = std::move(pKernelCache);
+    mpPrivateData->cacheKey = cacheKey;
     return slangEntryPoint != nullptr;
 }
 
 Shader::BlobData Shader::getBlobData() const
 {
-    auto blob = mpPrivateData->getBlob();
+    const auto& code = mpPrivateData->getCode();
 
     BlobData result;
-    result.data = blob->getBufferPointer();
-    result.size = blob->getBufferSize();
+    result.data = code.data();
+    result.size = code.size();
     return result;
 }
 } // namespace Falcor
@@ -30,10 +30,12 @@
 #include "Core/Macros.h"
 #include "Core/Assert.h"
 #include "Core/Object.h"
+#include "Utils/CryptoUtils.h"
 
 #include <initializer_list>
 #include <memory>
 #include <map>
+#include <optional>
 #include <string>
 #include <cstddef> // std::nullptr_t
 
@@ -41,6 +43,8 @@ struct ISlangBlob;
 
 namespace Falcor
 {
+class KernelCache;
+
 /**
  * Falcor shader types
  */
@@ -272,6 +276,8 @@ public:
      * @param[in] linkedSlangEntryPoint The Slang IComponentType that defines the shader entry point.
      * @param[in] type The Type of the shader
      * @param[out] log This string will contain the error log message in case shader compilation failed
+     * @param[in] pKernelCache Optional. Persistent cache used for the kernel code returned by getBlobData().
+     * @param[in] cacheKey Optional. Key identifying the kernel code in the kernel cache. The cache is only used if a key is given.
      * @return If success, a new shader object, otherwise nullptr
      */
     static ref<Shader> create(
@@ -279,12 +285,14 @@ public:
         ShaderType type,
         const std::string& entryPointName,
         CompilerFlags flags,
-        std::string& log
+        std::string& log,
+        std::shared_ptr<KernelCache> pKernelCache = nullptr,
+        std::optional<SHA1::MD> cacheKey = {}
     )
     {
         ref<Shader> pShader = ref<Shader>(new Shader(type));
         pShader->mEntryPointName = entryPointName;
-        return pShader->init(linkedSlangEntryPoint, entryPointName, flags, log) ? pShader : nullptr;
+        return pShader->init(linkedSlangEntryPoint, entryPointName, flags, log, std::move(pKernelCache), cacheKey) ? pShader : nullptr;
     }
 
     virtual ~Shader();
@@ -307,7 +315,9 @@ protected:
         Slang::ComPtr<slang::IComponentType> linkedSlangEntryPoint,
         const std::string& entryPointName,
         CompilerFlags flags,
-        std::string& log
+        std::string& log,
+        std::shared_ptr<KernelCache> pKernelCache,
+        std::optional<SHA1::MD> cacheKey
     );
     Shader(ShaderType Type);
     ShaderType mType;
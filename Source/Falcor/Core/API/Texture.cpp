@@ -37,6 +37,8 @@
 #include "Utils/Logger.h"
 #include "Utils/Threading.h"
 #include "Utils/Math/Common.h"
+#include "Utils/Image/AsyncImageWriter.h"
+#include "Utils/Image/AsyncTextureLoader.h"
 #include "Utils/Image/ImageIO.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "Core/Pass/FullScreenPass.h"
@@ -49,8 +51,6 @@ namespace Falcor
 {
 namespace
 {
-static constexpr bool kTopDown = true; // Memory layout when loading from file
-
 Texture::BindFlags updateBindFlags(
     ref<Device> pDevice,
     Texture::BindFlags flags,
@@ -219,87 +219,7 @@ ref<Texture> Texture::createMippedFromFiles(
     Texture::BindFlags bindFlags
 )
 {
-    std::vector<Bitmap::UniqueConstPtr> mips;
-    mips.reserve(paths.size());
-    size_t combinedSize = 0;
-    std::filesystem::path fullPathMip0;
-
-    for (const auto& path : paths)
-    {
-        Bitmap::UniqueConstPtr pBitmap;
-        if (hasExtension(path, "dds"))
-        {
-            pBitmap = ImageIO::loadBitmapFromDDS(path);
-        }
-        else
-        {
-            pBitmap = Bitmap::createFromFile(path, kTopDown);
-        }
-        if (!pBitmap)
-        {
-            logWarning("Error loading mip {}. Loading failed for image file '{}'.", mips.size(), path);
-            break;
-        }
-
-        if (!mips.empty())
-        {
-            if (mips.back()->getFormat() != pBitmap->getFormat())
-            {
-                logWarning("Error loading mip {} from file {}. Texture format of all mip levels must match.", mips.size(), path);
-                break;
-            }
-            if (std::max(mips.back()->getWidth() / 2, 1u) != pBitmap->getWidth() ||
-                std::max(mips.back()->getHeight() / 2, 1u) != pBitmap->getHeight())
-            {
-                logWarning(
-                    "Error loading mip {} from file {}. Image resolution must decrease by half. ({}, {}) != ({}, {})/2", mips.size(), path,
-                    pBitmap->getWidth(), pBitmap->getHeight(), mips.back()->getWidth(), mips.back()->getHeight()
-                );
-                break;
-            }
-        }
-        else
-        {
-            fullPathMip0 = path;
-        }
-        combinedSize += pBitmap->getSize();
-        mips.emplace_back(std::move(pBitmap));
-    }
-
-    ref<Texture> pTex;
-    if (!mips.empty())
-    {
-        // Combine all the mip data into a single buffer
-        size_t copyDst = 0;
-        std::unique_ptr<uint8_t[]> combinedData(new uint8_t[combinedSize]);
-        for (auto& mip : mips)
-        {
-            std::memcpy(&combinedData[copyDst], mip->getData(), mip->getSize());
-            copyDst += mip->getSize();
-        }
-
-        ResourceFormat texFormat = mips[0]->getFormat();
-        if (loadAsSrgb)
-            texFormat = linearToSrgbFormat(texFormat);
-
-        // Create mip mapped latent texture
-        pTex =
-            Texture::create2D(pDevice, mips[0]->getWidth(), mips[0]->getHeight(), texFormat, 1, mips.size(), combinedData.get(), bindFlags);
-    }
-
-    if (pTex != nullptr)
-    {
-        pTex->setSourcePath(fullPathMip0);
-
-        // Log debug info.
-        std::string str = fmt::format(
-            "Loaded texture: size={}x{} mips={} format={} path={}", pTex->getWidth(), pTex->getHeight(), pTex->getMipCount(),
-            to_string(pTex->getFormat()), fullPathMip0
-        );
-        logDebug(str);
-    }
-
-    return pTex;
+    return AsyncTextureLoader::loadTexture(pDevice, paths, false, loadAsSrgb, bindFlags);
 }
 
 ref<Texture> Texture::createFromFile(
@@ -310,56 +230,9 @@ ref<Texture> Texture::createFromFile(
     Texture::BindFlags bindFlags
 )
 {
-    std::filesystem::path fullPath;
-    if (!findFileInDataDirectories(path, fullPath))
-    {
-        logWarning("Error when loading image file. Can't find image file '{}'.", path);
-        return nullptr;
-    }
-
-    ref<Texture> pTex;
-    if (hasExtension(fullPath, "dds"))
-    {
-        try
-        {
-            pTex = ImageIO::loadTextureFromDDS(pDevice, fullPath, loadAsSrgb);
-        }
-        catch (const std::exception& e)
-        {
-            logWarning("Error loading '{}': {}", fullPath, e.what());
-        }
-    }
-    else
-    {
-        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(fullPath, kTopDown);
-        if (pBitmap)
-        {
-            ResourceFormat texFormat = pBitmap->getFormat();
-            if (loadAsSrgb)
-            {
-                texFormat = linearToSrgbFormat(texFormat);
-            }
-
-            pTex = Texture::create2D(
-                pDevice, pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1,
-                pBitmap->getData(), bindFlags
-            );
-        }
-    }
-
-    if (pTex != nullptr)
-    {
-        pTex->setSourcePath(fullPath);
-
-        // Log debug info.
-        std::string str = fmt::format(
-            "Loaded texture: size={}x{} mips={} format={} path={}", pTex->getWidth(), pTex->getHeight(), pTex->getMipCount(),
-            to_string(pTex->getFormat()), fullPath
-        );
-        logDebug(str);
-    }
-
-    return pTex;
+    return AsyncTextureLoader::loadTexture(
+        pDevice, fstd::span<const std::filesystem::path>(&path, 1), generateMipLevels, loadAsSrgb, bindFlags
+    );
 }
 
 Texture::Texture(
@@ -513,6 +386,42 @@ void Texture::captureToFile(
     Bitmap::ExportFlags exportFlags,
     bool async
 )
+{
+    ResourceFormat resourceFormat;
+    std::vector<uint8_t> textureData = readCaptureData(mipLevel, arraySlice, format, resourceFormat);
+
+    uint32_t width = getWidth(mipLevel);
+    uint32_t height = getHeight(mipLevel);
+
+    auto func = [=]() { Bitmap::saveImage(path, width, height, format, exportFlags, resourceFormat, true, (void*)textureData.data()); };
+
+    if (async)
+        Threading::dispatchTask(func);
+    else
+        func();
+}
+
+void Texture::captureToFile(
+    uint32_t mipLevel,
+    uint32_t arraySlice,
+    const std::filesystem::path& path,
+    Bitmap::FileFormat format,
+    Bitmap::ExportFlags exportFlags,
+    AsyncImageWriter& writer
+)
+{
+    ResourceFormat resourceFormat;
+    std::vector<uint8_t> textureData = readCaptureData(mipLevel, arraySlice, format, resourceFormat);
+
+    writer.write(path, getWidth(mipLevel), getHeight(mipLevel), format, exportFlags, resourceFormat, std::move(textureData));
+}
+
+std::vector<uint8_t> Texture::readCaptureData(
+    uint32_t mipLevel,
+    uint32_t arraySlice,
+    Bitmap::FileFormat format,
+    ResourceFormat& resourceFormat
+)
 {
     if (format == Bitmap::FileFormat::DdsFile)
     {
@@ -527,8 +436,6 @@ void Texture::captureToFile(
     // Handle the special case where we have an HDR texture with less then 3 channels.
     FormatType type = getFormatType(mFormat);
     uint32_t channels = getFormatChannelCount(mFormat);
-    std::vector<uint8_t> textureData;
-    ResourceFormat resourceFormat = mFormat;
 
     if (type == FormatType::Float && channels < 3)
     {
@@ -537,24 +444,15 @@ void Texture::captureToFile(
             ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource
         );
         pContext->blit(getSRV(mipLevel, 1, arraySlice, 1), pOther->getRTV(0, 0, 1));
-        textureData = pContext->readTextureSubresource(pOther.get(), 0);
         resourceFormat = ResourceFormat::RGBA32Float;
+        return pContext->readTextureSubresource(pOther.get(), 0);
     }
     else
     {
         uint32_t subresource = getSubresourceIndex(arraySlice, mipLevel);
-        textureData = pContext->readTextureSubresource(this, subresource);
+        resourceFormat = mFormat;
+        return pContext->readTextureSubresource(this, subresource);
     }
-
-    uint32_t width = getWidth(mipLevel);
-    uint32_t height = getHeight(mipLevel);
-
-    auto func = [=]() { Bitmap::saveImage(path, width, height, format, exportFlags, resourceFormat, true, (void*)textureData.data()); };
-
-    if (async)
-        Threading::dispatchTask(func);
-    else
-        func();
 }
 
 void Texture::uploadInitData(RenderContext* pRenderContext, const void* pData, bool autoGenMips)
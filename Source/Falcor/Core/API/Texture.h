@@ -34,12 +34,14 @@
 #include "Core/Macros.h"
 #include "Utils/Image/Bitmap.h"
 #include <filesystem>
+#include <vector>
 #include <fstd/span.h>
 
 namespace Falcor
 {
 class Sampler;
 class RenderContext;
+class AsyncImageWriter;
 
 /**
  * Abstracts the API texture objects
@@ -355,6 +357,26 @@ public:
         bool async = true
     );
 
+    /**
+     * Capture the texture to an image file using an asynchronous image writer.
+     * The texture is read back on the calling thread. Encoding and writing the file is done by the writer threads.
+     * Blocks while the writer queue is full.
+     * @param[in] mipLevel Requested mip-level
+     * @param[in] arraySlice Requested array-slice
+     * @param[in] path Path of the file to save.
+     * @param[in] fileFormat Destination image file format (e.g., PNG, PFM, etc.)
+     * @param[in] exportFlags Save flags, see Bitmap::ExportFlags
+     * @param[in] writer Image writer used for saving the file.
+     */
+    void captureToFile(
+        uint32_t mipLevel,
+        uint32_t arraySlice,
+        const std::filesystem::path& path,
+        Bitmap::FileFormat format,
+        Bitmap::ExportFlags exportFlags,
+        AsyncImageWriter& writer
+    );
+
     /**
      * Generates mipmaps for a specified texture object.
      * @param[in] pContext Used render context.
@@ -404,6 +426,7 @@ protected:
     );
     void apiInit(const void* pData, bool autoGenMips);
     void uploadInitData(RenderContext* pRenderContext, const void* pData, bool autoGenMips);
+    std::vector<uint8_t> readCaptureData(uint32_t mipLevel, uint32_t arraySlice, Bitmap::FileFormat format, ResourceFormat& resourceFormat);
 
     Slang::ComPtr<gfx::ITextureResource> mGfxTextureResource;
 
@@ -43,6 +43,9 @@
 #define _GNU_SOURCE // needed for dladdr()
 #endif
 #include <dlfcn.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
 
 #include <mutex>
 
@@ -555,6 +558,28 @@ uint32_t popcount(uint32_t a)
     return (uint32_t)__builtin_popcount(a);
 }
 
+const CpuFeatures& getCpuFeatures()
+{
+    static const CpuFeatures features = []()
+    {
+        CpuFeatures f;
+#if defined(__x86_64__) || defined(__i386__)
+        // __builtin_cpu_supports() also checks that the OS saves the AVX registers.
+        __builtin_cpu_init();
+        f.sse41 = __builtin_cpu_supports("sse4.1");
+        f.avx = __builtin_cpu_supports("avx");
+        f.avx2 = __builtin_cpu_supports("avx2");
+        f.fma = __builtin_cpu_supports("fma");
+        // F16C is not queryable through __builtin_cpu_supports() on all supported compilers.
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            f.f16c = f.avx && (ecx & bit_F16C) != 0;
+#endif
+        return f;
+    }();
+    return features;
+}
+
 SharedLibraryHandle loadSharedLibrary(const std::filesystem::path& path)
 {
     return dlopen(path.c_str(), RTLD_LAZY);
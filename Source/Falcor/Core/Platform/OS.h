@@ -499,6 +499,24 @@ FALCOR_API uint32_t bitScanForward(uint32_t a);
  */
 FALCOR_API uint32_t popcount(uint32_t a);
 
+/**
+ * Instruction set extensions supported by the CPU and enabled by the OS.
+ */
+struct CpuFeatures
+{
+    bool sse41 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool f16c = false;
+    bool fma = false;
+};
+
+/**
+ * Get the instruction set extensions supported by the CPU.
+ * The features are queried on the first call. All features are reported as unsupported on non-x86 CPUs.
+ */
+FALCOR_API const CpuFeatures& getCpuFeatures();
+
 /**
  * Read the contents of a file into a string.
  * Throws an exception if the file cannot be read.
@@ -42,6 +42,8 @@
 #include <shellscalingapi.h>
 #include <ShlObj_core.h>
 #include <winioctl.h>
+#include <intrin.h>
+#include <immintrin.h>
 
 #include <string>
 #include <vector>
@@ -924,6 +926,38 @@ uint32_t popcount(uint32_t a)
     return __popcnt(a);
 }
 
+const CpuFeatures& getCpuFeatures()
+{
+    static const CpuFeatures features = []()
+    {
+        CpuFeatures f;
+#if defined(_M_X64) || defined(_M_IX86)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        if (maxLeaf < 1)
+            return f;
+
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        // The OS must save the YMM registers on context switches for AVX to be usable.
+        const bool osAvx = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        f.sse41 = (info[2] & (1 << 19)) != 0;
+        f.avx = osAvx && (info[2] & (1 << 28)) != 0;
+        f.fma = f.avx && (info[2] & (1 << 12)) != 0;
+        f.f16c = f.avx && (info[2] & (1 << 29)) != 0;
+
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            f.avx2 = f.avx && (info[1] & (1 << 5)) != 0;
+        }
+#endif
+        return f;
+    }();
+    return features;
+}
+
 SharedLibraryHandle loadSharedLibrary(const std::filesystem::path& path)
 {
     return LoadLibraryW(path.c_str());
@@ -0,0 +1,314 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "KernelCache.h"
+#include "Core/Assert.h"
+#include "Utils/Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+namespace Falcor
+{
+
+namespace
+{
+const char kMagic[4] = {'F', 'K', 'C', '1'};
+const char kEntryExtension[] = ".kernel";
+const char kTempExtension[] = ".tmp";
+
+/// Maximum size of a single cache entry. Larger sizes in an entry header are treated as corruption.
+const uint64_t kMaxEntrySize = 1ull << 30;
+
+struct EntryHeader
+{
+    char magic[4];
+    uint32_t reserved = 0;
+    uint64_t size = 0;
+    SHA1::MD hash;
+};
+
+/// Scoped lock of both the in-process mutex and the inter-process lock file.
+class ScopedLock
+{
+public:
+    ScopedLock(std::mutex& mutex, LockFile& lockFile, LockFile::LockType lockType) : mLock(mutex), mLockFile(lockFile)
+    {
+        mLocked = mLockFile.isOpen() && mLockFile.lock(lockType);
+    }
+
+    ~ScopedLock()
+    {
+        if (mLocked)
+            mLockFile.unlock();
+    }
+
+private:
+    std::lock_guard<std::mutex> mLock;
+    LockFile& mLockFile;
+    bool mLocked = false;
+};
+} // namespace
+
+KernelCache::KernelCache(const std::filesystem::path& directory, uint64_t maxSize) : mDirectory(directory), mMaxSize(maxSize)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(mDirectory, ec);
+    if (!std::filesystem::is_directory(mDirectory, ec))
+    {
+        logWarning("Failed to create kernel cache directory '{}'. Kernel cache is disabled.", mDirectory);
+        return;
+    }
+
+    if (!mLockFile.open(mDirectory / "lock"))
+        logWarning("Failed to open lock file in kernel cache directory '{}'. Concurrent use by multiple processes is unsafe.", mDirectory);
+
+    mEnabled = true;
+
+    ScopedLock lock(mMutex, mLockFile, LockFile::LockType::Exclusive);
+    scanDirectory();
+}
+
+std::optional<std::vector<uint8_t>> KernelCache::get(const Key& key)
+{
+    if (!mEnabled)
+        return {};
+
+    ScopedLock lock(mMutex, mLockFile, LockFile::LockType::Shared);
+
+    std::filesystem::path path = getEntryPath(key);
+    std::optional<std::vector<uint8_t>> data;
+    {
+        std::error_code ec;
+        uint64_t fileSize = std::filesystem::file_size(path, ec);
+        std::ifstream fs(path, std::ios::binary);
+        EntryHeader header;
+        // Validate the stored size against the file size before allocating the buffer.
+        if (!ec && fs.read(reinterpret_cast<char*>(&header), sizeof(header)) && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+            header.size <= kMaxEntrySize && header.size == fileSize - sizeof(header))
+        {
+            std::vector<uint8_t> buffer(header.size);
+            bool valid = fs.read(reinterpret_cast<char*>(buffer.data()), buffer.size()).good();
+            if (valid && SHA1::compute(buffer.data(), buffer.size()) == header.hash)
+                data = std::move(buffer);
+        }
+    }
+
+    std::error_code ec;
+    if (data)
+    {
+        // Mark the entry as recently used.
+        auto now = std::filesystem::file_time_type::clock::now();
+        std::filesystem::last_write_time(path, now, ec);
+        touchEntry(path, sizeof(EntryHeader) + data->size(), now);
+        mStats.hitCount++;
+    }
+    else
+    {
+        // Discard invalid entries. Another process may still hold the shared lock, so this is allowed to fail.
+        if (std::filesystem::exists(path, ec))
+            std::filesystem::remove(path, ec);
+        removeEntry(path);
+        mStats.missCount++;
+    }
+
+    return data;
+}
+
+void KernelCache::set(const Key& key, const void* pData, size_t size)
+{
+    if (!mEnabled)
+        return;
+
+    if (size > kMaxEntrySize)
+    {
+        logWarning("Kernel cache entry of {} bytes exceeds the maximum entry size. Not caching.", size);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // Write the entry to a uniquely named temporary file first so that readers never see a partial entry.
+    static thread_local std::mt19937_64 rng{std::random_device{}()};
+    std::filesystem::path path = getEntryPath(key);
+    std::filesystem::path tempPath = path;
+    tempPath.replace_extension(fmt::format("{:016x}{}", rng(), kTempExtension));
+
+    EntryHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.size = size;
+    header.hash = SHA1::compute(pData, size);
+
+    {
+        std::ofstream fs(tempPath, std::ios::binary | std::ios::trunc);
+        fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fs.write(reinterpret_cast<const char*>(pData), size);
+        if (!fs.good())
+        {
+            fs.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            logWarning("Failed to write kernel cache entry '{}'.", tempPath);
+            return;
+        }
+    }
+
+    bool locked = mLockFile.isOpen() && mLockFile.lock(LockFile::LockType::Exclusive);
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+    }
+    else
+    {
+        touchEntry(path, sizeof(header) + size, std::filesystem::file_time_type::clock::now());
+        mStats.storeCount++;
+        evict();
+    }
+
+    if (locked)
+        mLockFile.unlock();
+}
+
+void KernelCache::clear()
+{
+    if (!mEnabled)
+        return;
+
+    ScopedLock lock(mMutex, mLockFile, LockFile::LockType::Exclusive);
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(mDirectory, ec))
+    {
+        if (entry.path().extension() == kEntryExtension)
+            std::filesystem::remove(entry.path(), ec);
+    }
+
+    mLRU.clear();
+    mEntries.clear();
+    mSize = 0;
+}
+
+uint64_t KernelCache::getSize() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSize;
+}
+
+KernelCache::Stats KernelCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+void KernelCache::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats = {};
+}
+
+std::filesystem::path KernelCache::getEntryPath(const Key& key) const
+{
+    return mDirectory / (SHA1::toString(key) + kEntryExtension);
+}
+
+void KernelCache::scanDirectory()
+{
+    std::vector<Entry> entries;
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(mDirectory, ec))
+    {
+        auto lastUse = entry.last_write_time(ec);
+        if (ec)
+            continue;
+        if (entry.path().extension() == kTempExtension)
+        {
+            // Temporary files are renamed or removed right after being written. Old ones were left behind by a crashed process.
+            if (now - lastUse > kStaleTempFileAge)
+                std::filesystem::remove(entry.path(), ec);
+        }
+        else if (entry.path().extension() == kEntryExtension)
+        {
+            uint64_t size = entry.file_size(ec);
+            if (!ec)
+                entries.push_back({entry.path(), size, lastUse});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse > b.lastUse; });
+    for (const auto& entry : entries)
+    {
+        mLRU.push_back(entry);
+        mEntries[entry.path] = std::prev(mLRU.end());
+        mSize += entry.size;
+    }
+}
+
+void KernelCache::touchEntry(const std::filesystem::path& path, uint64_t size, std::filesystem::file_time_type lastUse)
+{
+    removeEntry(path);
+    mLRU.push_front({path, size, lastUse});
+    mEntries[path] = mLRU.begin();
+    mSize += size;
+}
+
+void KernelCache::removeEntry(const std::filesystem::path& path)
+{
+    auto it = mEntries.find(path);
+    if (it == mEntries.end())
+        return;
+    mSize -= it->second->size;
+    mLRU.erase(it->second);
+    mEntries.erase(it);
+}
+
+void KernelCache::evict()
+{
+    // Evict the least recently used known entries. Entries that another process used since they were last seen
+    // here are moved to the front instead, so that the use order is shared between processes.
+    std::error_code ec;
+    while (mSize > mMaxSize && !mLRU.empty())
+    {
+        const std::filesystem::path path = mLRU.back().path;
+        auto lastUse = std::filesystem::last_write_time(path, ec);
+        if (!ec && lastUse > mLRU.back().lastUse)
+        {
+            uint64_t size = std::filesystem::file_size(path, ec);
+            touchEntry(path, ec ? mLRU.back().size : size, lastUse);
+            continue;
+        }
+        if (std::filesystem::remove(path, ec))
+            mStats.evictionCount++;
+        removeEntry(path);
+    }
+}
+
+} // namespace Falcor
@@ -0,0 +1,152 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/Platform/LockFile.h"
+#include "Utils/CryptoUtils.h"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Falcor
+{
+
+/**
+ * Persistent, content-addressed cache for compiled shader kernels.
+ *
+ * Entries are stored as individual files in a cache directory and are addressed by a SHA1 key that
+ * the caller computes from everything that affects the compiled code. The total size of the entries
+ * is bounded; when it is exceeded the least recently used entries are evicted.
+ *
+ * The cache directory can be shared between processes. Entries are written to temporary files and
+ * moved into place, and a lock file in the cache directory serializes modifications.
+ * Each entry stores a hash of its data so that truncated or corrupted entries are detected and discarded.
+ *
+ * The directory is scanned once when the cache is opened. After that each instance tracks the size and
+ * use order of the entries it knows about, so storing an entry doesn't rescan the directory. Entries
+ * written by other processes are accounted for when they are looked up or the next time the cache is opened.
+ *
+ * The cache does not depend on a GPU device.
+ */
+class FALCOR_API KernelCache
+{
+public:
+    using Key = SHA1::MD;
+
+    struct Stats
+    {
+        uint64_t hitCount = 0;      ///< Number of lookups that found a valid entry.
+        uint64_t missCount = 0;     ///< Number of lookups that did not find a valid entry.
+        uint64_t storeCount = 0;    ///< Number of entries written.
+        uint64_t evictionCount = 0; ///< Number of entries evicted to respect the size limit.
+    };
+
+    /**
+     * Constructor. Creates the cache directory if it doesn't exist.
+     * Temporary files left behind by interrupted writes are removed once they are older than kStaleTempFileAge.
+     * If the directory can't be created the cache is disabled and all lookups miss.
+     * @param[in] directory Cache directory.
+     * @param[in] maxSize Maximum total size of all entries in bytes.
+     */
+    KernelCache(const std::filesystem::path& directory, uint64_t maxSize);
+
+    /**
+     * Look up an entry. A successful lookup marks the entry as recently used.
+     * @param[in] key Entry key.
+     * @return Returns the entry data or an empty optional if there is no valid entry.
+     */
+    std::optional<std::vector<uint8_t>> get(const Key& key);
+
+    /**
+     * Store an entry, replacing an existing entry with the same key.
+     * Least recently used entries are evicted afterwards if the cache exceeds its maximum size.
+     * @param[in] key Entry key.
+     * @param[in] pData Entry data.
+     * @param[in] size Size of the entry data in bytes.
+     */
+    void set(const Key& key, const void* pData, size_t size);
+
+    /**
+     * Remove all entries.
+     */
+    void clear();
+
+    /**
+     * Get the total size of all entries known to this instance in bytes.
+     */
+    uint64_t getSize() const;
+
+    /**
+     * Check if the cache is enabled, i.e. the cache directory is accessible.
+     */
+    bool isEnabled() const { return mEnabled; }
+
+    const std::filesystem::path& getDirectory() const { return mDirectory; }
+    uint64_t getMaxSize() const { return mMaxSize; }
+
+    /**
+     * Get lookup and store statistics of this cache instance.
+     */
+    Stats getStats() const;
+    void resetStats();
+
+    /// Minimum age of a temporary file before it is considered left behind by an interrupted write.
+    static constexpr std::chrono::hours kStaleTempFileAge{1};
+
+private:
+    struct Entry
+    {
+        std::filesystem::path path;
+        uint64_t size;
+        std::filesystem::file_time_type lastUse;
+    };
+
+    std::filesystem::path getEntryPath(const Key& key) const;
+    void scanDirectory();
+    void touchEntry(const std::filesystem::path& path, uint64_t size, std::filesystem::file_time_type lastUse);
+    void removeEntry(const std::filesystem::path& path);
+    void evict();
+
+    std::filesystem::path mDirectory;
+    uint64_t mMaxSize;
+    bool mEnabled = false;
+
+    mutable std::mutex mMutex;
+    mutable LockFile mLockFile;
+    std::list<Entry> mLRU; ///< Known entries, most recently used first.
+    std::map<std::filesystem::path, std::list<Entry>::iterator> mEntries;
+    uint64_t mSize = 0; ///< Total size of the known entries in bytes.
+    Stats mStats;
+};
+
+} // namespace Falcor
@@ -29,10 +29,16 @@
 #include "Core/API/Device.h"
 #include "Core/Platform/OS.h"
 #include "Utils/Logger.h"
+#include "Utils/Threading.h"
 #include "Utils/Timing/CpuTimer.h"
 
 #include <slang.h>
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
 namespace Falcor
 {
 
@@ -100,14 +106,215 @@ inline bool doSlangReflection(
     return true;
 }
 
-ProgramManager::ProgramManager(Device* pDevice) : mpDevice(pDevice) {}
+ProgramManager::ProgramManager(Device* pDevice) : mpDevice(pDevice)
+{
+    const auto& desc = mpDevice->getDesc();
+    if (!desc.kernelCachePath.empty())
+    {
+        mpKernelCache = std::make_shared<KernelCache>(desc.kernelCachePath, desc.maxKernelCacheSize);
+        if (!mpKernelCache->isEnabled())
+            mpKernelCache.reset();
+    }
+}
 
 ref<const ProgramVersion> ProgramManager::createProgramVersion(const Program& program, std::string& log) const
 {
     CpuTimer timer;
     timer.update();
 
-    auto pSlangRequest = createSlangCompileRequest(program);
+    program.mFileTimeMap.clear(); // TODO @skallweit
+
+    auto pVersion = compileProgramVersion(program, program.getDefineList(), mpDevice->getSlangGlobalSession(), log, program.mFileTimeMap);
+    if (!pVersion)
+        return nullptr;
+
+    if (std::string programDesc = getPermutationProgramDesc(program); !programDesc.empty())
+        mRecordedPermutations.push_back({std::move(programDesc), program.getDefineList()});
+
+    timer.update();
+    double time = timer.delta();
+    mCompilationStats.programVersionCount++;
+    mCompilationStats.programVersionTotalTime += time;
+    mCompilationStats.programVersionMaxTime = std::max(mCompilationStats.programVersionMaxTime, time);
+    logDebug("Created program version in {:.3f} s: {}", timer.delta(), pVersion->getName());
+
+    return pVersion;
+}
+
+void ProgramManager::prewarmPrograms(const std::vector<ProgramPermutation>& permutations)
+{
+    // Skip permutations that are already compiled or requested more than once.
+    std::vector<const ProgramPermutation*> pendingPermutations;
+    std::set<std::pair<const Program*, Program::ProgramVersionKey>> keys;
+    for (const auto& permutation : permutations)
+    {
+        FALCOR_ASSERT(permutation.pProgram);
+        const Program& program = *permutation.pProgram;
+        Program::ProgramVersionKey key{permutation.defines, program.mTypeConformanceList};
+        if (program.mProgramVersions.count(key) == 0 && keys.emplace(&program, key).second)
+            pendingPermutations.push_back(&permutation);
+    }
+    if (pendingPermutations.empty())
+        return;
+
+    logInfo("Prewarming {} program permutations on {} threads.", pendingPermutations.size(), Threading::getThreadCount());
+
+    CpuTimer timer;
+    timer.update();
+
+    struct Result
+    {
+        ref<const ProgramVersion> pVersion;
+        std::string log;
+        Program::string_time_map fileTimeMap;
+        double time = 0.0;
+    };
+
+    // Slang sessions are not thread-safe, so each task compiles with a global session that no other task uses at the same time.
+    std::vector<Threading::Future<Result>> futures;
+    futures.reserve(pendingPermutations.size());
+    for (const ProgramPermutation* pPermutation : pendingPermutations)
+    {
+        futures.push_back(Threading::dispatchTask(
+            [this, pPermutation]()
+            {
+                Result result;
+                CpuTimer taskTimer;
+                taskTimer.update();
+                Slang::ComPtr<slang::IGlobalSession> pSlangGlobalSession = acquireWorkerSlangGlobalSession();
+                try
+                {
+                    result.pVersion = compileProgramVersion(
+                        *pPermutation->pProgram, pPermutation->defines, pSlangGlobalSession, result.log, result.fileTimeMap
+                    );
+                }
+                catch (const std::exception& e)
+                {
+                    result.log += e.what();
+                }
+                releaseWorkerSlangGlobalSession(pSlangGlobalSession);
+                taskTimer.update();
+                result.time = taskTimer.delta();
+                return result;
+            }
+        ));
+    }
+
+    // Collect the results in order on the calling thread, which is the only thread modifying the programs.
+    size_t compiledCount = 0;
+    double maxTime = 0.0;
+    double totalTime = 0.0;
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        Result result = futures[i].get();
+        const ProgramPermutation& permutation = *pendingPermutations[i];
+        const Program& program = *permutation.pProgram;
+
+        if (!result.pVersion)
+        {
+            logWarning("Failed to prewarm program permutation:\n{}\n\n{}", program.getProgramDescString(), result.log);
+            continue;
+        }
+
+        program.mProgramVersions[Program::ProgramVersionKey{permutation.defines, program.mTypeConformanceList}] = result.pVersion;
+        program.mFileTimeMap.insert(result.fileTimeMap.begin(), result.fileTimeMap.end());
+
+        compiledCount++;
+        maxTime = std::max(maxTime, result.time);
+        totalTime += result.time;
+        mCompilationStats.programVersionCount++;
+        mCompilationStats.programVersionTotalTime += result.time;
+        mCompilationStats.programVersionMaxTime = std::max(mCompilationStats.programVersionMaxTime, result.time);
+        logInfo("Prewarmed program permutation {}/{} in {:.3f} s: {}", i + 1, futures.size(), result.time, result.pVersion->getName());
+    }
+
+    timer.update();
+    logInfo(
+        "Prewarmed {} program permutations in {:.3f} s (longest {:.3f} s, sum {:.3f} s).", compiledCount, timer.delta(), maxTime,
+        totalTime
+    );
+}
+
+std::vector<ProgramManager::ProgramPermutation> ProgramManager::getPendingPermutations() const
+{
+    std::vector<ProgramPermutation> permutations;
+    for (Program* pProgram : mLoadedPrograms)
+    {
+        if (pProgram->mLinkRequired &&
+            pProgram->mProgramVersions.count(Program::ProgramVersionKey{pProgram->getDefineList(), pProgram->mTypeConformanceList}) == 0)
+            permutations.push_back({ref<Program>(pProgram), pProgram->getDefineList()});
+    }
+    return permutations;
+}
+
+std::vector<ProgramManager::PermutationRecord> ProgramManager::takeRecordedPermutations()
+{
+    return std::exchange(mRecordedPermutations, {});
+}
+
+std::vector<ProgramManager::ProgramPermutation> ProgramManager::findPermutations(const std::vector<PermutationRecord>& records) const
+{
+    std::multimap<std::string, Program*> programs;
+    for (Program* pProgram : mLoadedPrograms)
+    {
+        if (std::string programDesc = getPermutationProgramDesc(*pProgram); !programDesc.empty())
+            programs.emplace(std::move(programDesc), pProgram);
+    }
+
+    std::vector<ProgramPermutation> permutations;
+    for (const auto& record : records)
+    {
+        auto [begin, end] = programs.equal_range(record.programDesc);
+        for (auto it = begin; it != end; ++it)
+            permutations.push_back({ref<Program>(it->second), record.defines});
+    }
+    return permutations;
+}
+
+std::string ProgramManager::getPermutationProgramDesc(const Program& program)
+{
+    // Programs created from strings have no stable identity across runs.
+    for (const auto& source : program.mDesc.mSources)
+    {
+        if (source.getType() != Program::ShaderModule::Type::File)
+            return {};
+    }
+    return program.getProgramDescString();
+}
+
+Slang::ComPtr<slang::IGlobalSession> ProgramManager::acquireWorkerSlangGlobalSession() const
+{
+    {
+        std::lock_guard<std::mutex> lock(mWorkerSlangGlobalSessionsMutex);
+        if (!mWorkerSlangGlobalSessions.empty())
+        {
+            Slang::ComPtr<slang::IGlobalSession> pSlangGlobalSession = mWorkerSlangGlobalSessions.back();
+            mWorkerSlangGlobalSessions.pop_back();
+            return pSlangGlobalSession;
+        }
+    }
+
+    Slang::ComPtr<slang::IGlobalSession> pSlangGlobalSession;
+    if (SLANG_FAILED(slang::createGlobalSession(pSlangGlobalSession.writeRef())))
+        throw RuntimeError("Failed to create Slang global session");
+    return pSlangGlobalSession;
+}
+
+void ProgramManager::releaseWorkerSlangGlobalSession(Slang::ComPtr<slang::IGlobalSession> pSlangGlobalSession) const
+{
+    std::lock_guard<std::mutex> lock(mWorkerSlangGlobalSessionsMutex);
+    mWorkerSlangGlobalSessions.push_back(std::move(pSlangGlobalSession));
+}
+
+ref<const ProgramVersion> ProgramManager::compileProgramVersion(
+    const Program& program,
+    const Program::DefineList& defines,
+    slang::IGlobalSession* pSlangGlobalSession,
+    std::string& log,
+    Program::string_time_map& fileTimeMap
+) const
+{
+    auto pSlangRequest = createSlangCompileRequest(program, defines, pSlangGlobalSession);
     if (pSlangRequest == nullptr)
         return nullptr;
 
@@ -154,9 +361,11 @@ ref<const ProgramVersion> ProgramManager::createProgramVersion(const Program& pr
     {
         std::string depFilePath = spGetDependencyFilePath(pSlangRequest, ii);
         if (std::filesystem::exists(depFilePath))
-            program.mFileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
+            fileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
     }
 
+    SHA1::MD sourceHash = mpKernelCache ? computeSourceHash(program, defines, pSlangRequest) : SHA1::MD{};
+
     // Note: the `ProgramReflection` needs to be able to refer back to the
     // `ProgramVersion`, but the `ProgramVersion` can't be initialized
     // until we have its reflection. We cut that dependency knot by
@@ -190,14 +399,8 @@ ref<const ProgramVersion> ProgramManager::createProgramVersion(const Program& pr
     }
 
     auto descStr = program.getProgramDescString();
-    pVersion->init(program.getDefineList(), pReflector, descStr, pSlangEntryPoints);
-
-    timer.update();
-    double time = timer.delta();
-    mCompilationStats.programVersionCount++;
-    mCompilationStats.programVersionTotalTime += time;
-    mCompilationStats.programVersionMaxTime = std::max(mCompilationStats.programVersionMaxTime, time);
-    logDebug("Created program version in {:.3f} s: {}", timer.delta(), descStr);
+    pVersion->init(defines, pReflector, descStr, pSlangEntryPoints);
+    pVersion->mSourceHash = sourceHash;
 
     return pVersion;
 }
@@ -427,14 +630,41 @@ ref<const ProgramKernels> ProgramManager::createProgramKernels(
     doSlangReflection(programVersion, pSpecializedSlangProgram, pLinkedEntryPoints, pReflector, log);
 
     // Create Shader objects for each entry point and cache them here.
+    // The kernel cache key of each entry point extends the source hash of the program version by the specialization applied here.
     std::vector<ref<Shader>> allShaders;
     for (uint32_t i = 0; i < allEntryPointCount; i++)
     {
         auto pLinkedEntryPoint = pLinkedEntryPoints[i];
         auto entryPointDesc = program.mDesc.mEntryPoints[i];
 
-        ref<Shader> shader =
-            Shader::create(pLinkedEntryPoint, entryPointDesc.stage, entryPointDesc.exportName, program.mDesc.getCompilerFlags(), log);
+        std::optional<KernelCache::Key> cacheKey;
+        if (mpKernelCache)
+        {
+            SHA1 sha1;
+            sha1.update(programVersion.getSourceHash().data(), programVersion.getSourceHash().size());
+            auto updateString = [&sha1](const std::string& str)
+            {
+                sha1.update(uint64_t(str.size()));
+                sha1.update(str);
+            };
+            Program::TypeConformanceList typeConformances = program.mTypeConformanceList;
+            typeConformances.add(program.mDesc.mGroups[entryPointDesc.groupIndex].typeConformances);
+            for (const auto& [typeConformance, id] : typeConformances)
+            {
+                updateString(typeConformance.mTypeName);
+                updateString(typeConformance.mInterfaceName);
+                sha1.update(id);
+            }
+            updateString(entryPointDesc.name);
+            updateString(entryPointDesc.exportName);
+            sha1.update(uint32_t(entryPointDesc.stage));
+            cacheKey = sha1.finalize();
+        }
+
+        ref<Shader> shader = Shader::create(
+            pLinkedEntryPoint, entryPointDesc.stage, entryPointDesc.exportName, program.mDesc.getCompilerFlags(), log, mpKernelCache,
+            cacheKey
+        );
         if (!shader)
             return nullptr;
 
@@ -584,9 +814,89 @@ ProgramManager::ForcedCompilerFlags ProgramManager::getForcedCompilerFlags()
     return mForcedCompilerFlags;
 }
 
-SlangCompileRequest* ProgramManager::createSlangCompileRequest(const Program& program) const
+SHA1::MD ProgramManager::computeSourceHash(
+    const Program& program,
+    const Program::DefineList& defines,
+    SlangCompileRequest* pSlangRequest
+) const
+{
+    // Version of the hashed data layout. Increment when changing what is hashed below.
+    const uint32_t kSourceHashVersion = 1;
+
+    SHA1 sha1;
+    auto updateString = [&sha1](const std::string& str)
+    {
+        sha1.update(uint64_t(str.size()));
+        sha1.update(str);
+    };
+
+    sha1.update(kSourceHashVersion);
+    updateString(spGetBuildTagString());
+
+    // Compiler settings.
+    Shader::CompilerFlags compilerFlags = program.mDesc.getCompilerFlags();
+    compilerFlags &= ~mForcedCompilerFlags.disabled;
+    compilerFlags |= mForcedCompilerFlags.enabled;
+    sha1.update(uint32_t(mpDevice->getType()));
+    updateString(program.mDesc.mShaderModel);
+    sha1.update(uint32_t(compilerFlags));
+    sha1.update(uint32_t(program.mDesc.getCompilerFlags()));
+    sha1.update(mGenerateDebugInfo);
+    for (const auto& arg : program.mDesc.mCompilerArguments)
+        updateString(arg);
+    updateString(program.mDesc.mLanguagePrelude);
+
+    // Defines.
+    for (const Program::DefineList* pDefines : {&mGlobalDefineList, &defines})
+    {
+        sha1.update(uint64_t(pDefines->size()));
+        for (const auto& [name, value] : *pDefines)
+        {
+            updateString(name);
+            updateString(value);
+        }
+    }
+
+    // Sources. The contents of files are covered by the dependency list below.
+    for (const auto& src : program.mDesc.mSources)
+    {
+        sha1.update(uint32_t(src.getType()));
+        sha1.update(src.source.createTranslationUnit);
+        updateString(src.source.moduleName);
+        updateString(src.source.filePath.string());
+        updateString(src.source.modulePath);
+        updateString(src.source.str);
+    }
+    for (const auto& entryPoint : program.mDesc.mEntryPoints)
+    {
+        sha1.update(entryPoint.sourceIndex);
+        updateString(entryPoint.name);
+        sha1.update(uint32_t(entryPoint.stage));
+    }
+
+    // Contents of all source files and transitively imported modules.
+    std::vector<std::string> depFilePaths;
+    int depFileCount = spGetDependencyFileCount(pSlangRequest);
+    for (int ii = 0; ii < depFileCount; ++ii)
+        depFilePaths.push_back(spGetDependencyFilePath(pSlangRequest, ii));
+    std::sort(depFilePaths.begin(), depFilePaths.end());
+    depFilePaths.erase(std::unique(depFilePaths.begin(), depFilePaths.end()), depFilePaths.end());
+    for (const auto& depFilePath : depFilePaths)
+    {
+        updateString(depFilePath);
+        if (std::filesystem::exists(depFilePath))
+            updateString(readFile(depFilePath));
+    }
+
+    return sha1.finalize();
+}
+
+SlangCompileRequest* ProgramManager::createSlangCompileRequest(
+    const Program& program,
+    const Program::DefineList& defines,
+    slang::IGlobalSession* pSlangGlobalSession
+) const
 {
-    slang::IGlobalSession* pSlangGlobalSession = mpDevice->getSlangGlobalSession();
     FALCOR_ASSERT(pSlangGlobalSession);
 
     slang::SessionDesc sessionDesc;
@@ -670,7 +980,7 @@ SlangCompileRequest* ProgramManager::createSlangCompileRequest(const Program& pr
     // Add global followed by program specific defines.
     for (const auto& shaderDefine : mGlobalDefineList)
         addSlangDefine(shaderDefine.first.c_str(), shaderDefine.second.c_str());
-    for (const auto& shaderDefine : program.getDefineList())
+    for (const auto& shaderDefine : defines)
         addSlangDefine(shaderDefine.first.c_str(), shaderDefine.second.c_str());
 
     // Add a `#define`s based on the target and shader model.
@@ -696,8 +1006,6 @@ SlangCompileRequest* ProgramManager::createSlangCompileRequest(const Program& pr
     pSlangGlobalSession->createSession(sessionDesc, pSlangSession.writeRef());
     FALCOR_ASSERT(pSlangSession);
 
-    program.mFileTimeMap.clear(); // TODO @skallweit
-
     if (!program.mDesc.mLanguagePrelude.empty())
     {
         if (targetDesc.format == SLANG_DXIL)
@@ -27,9 +27,12 @@
  **************************************************************************/
 #pragma once
 #include "Program.h"
+#include "KernelCache.h"
 #include "Core/API/fwd.h"
 
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Falcor
 {
@@ -59,12 +62,63 @@ public:
         double programKernelsTotalTime = 0.0;
     };
 
+    /**
+     * A program together with the defines of one of its versions.
+     */
+    struct ProgramPermutation
+    {
+        ref<Program> pProgram;
+        Program::DefineList defines;
+    };
+
+    /**
+     * A permutation compiled on demand, identified by the program description instead of the program object.
+     * Records can be stored and matched against the programs of a later run.
+     */
+    struct PermutationRecord
+    {
+        std::string programDesc; ///< Program description as returned by Program::getProgramDescString().
+        Program::DefineList defines;
+    };
+
     Program::Desc applyForcedCompilerFlags(Program::Desc desc) const;
     void registerProgramForReload(Program* program);
     void unregisterProgramForReload(Program* program);
 
     ref<const ProgramVersion> createProgramVersion(const Program& program, std::string& log) const;
 
+    /**
+     * Compile program versions ahead of their first use.
+     * The permutations are compiled concurrently on the thread pool. Each worker compiles with its own Slang global session.
+     * The resulting versions are stored in their programs and used once a program is linked with the same defines.
+     * Permutations that are already compiled are skipped. Compilation errors are logged as warnings and are reported again
+     * when the version is used. Must be called from the thread that uses the programs.
+     * @param[in] permutations List of program permutations.
+     */
+    void prewarmPrograms(const std::vector<ProgramPermutation>& permutations);
+
+    /**
+     * Get the permutations of all loaded programs whose current defines have not been compiled yet.
+     * @return List of program permutations.
+     */
+    std::vector<ProgramPermutation> getPendingPermutations() const;
+
+    /**
+     * Get the permutations compiled on demand since the last call and clear the list.
+     * This includes the defines that passes set right before executing, which are not known when the programs are created.
+     * Prewarmed permutations and programs created from source strings are not recorded.
+     * @return List of permutation records in the order they were compiled.
+     */
+    std::vector<PermutationRecord> takeRecordedPermutations();
+
+    /**
+     * Find the loaded programs matching a list of permutation records.
+     * Records that don't match any loaded program are skipped. A record matching several programs yields a permutation for each.
+     * @param[in] records List of permutation records.
+     * @return List of program permutations.
+     */
+    std::vector<ProgramPermutation> findPermutations(const std::vector<PermutationRecord>& records) const;
+
     ref<const ProgramKernels> createProgramKernels(
         const Program& program,
         const ProgramVersion& programVersion,
@@ -125,18 +179,46 @@ public:
     const CompilationStats& getCompilationStats() { return mCompilationStats; }
     void resetCompilationStats() { mCompilationStats = {}; }
 
+    /**
+     * Get the persistent cache for compiled kernel code.
+     * @return The kernel cache or nullptr if the cache is disabled.
+     */
+    KernelCache* getKernelCache() const { return mpKernelCache.get(); }
+
 private:
-    SlangCompileRequest* createSlangCompileRequest(const Program& program) const;
+    ref<const ProgramVersion> compileProgramVersion(
+        const Program& program,
+        const Program::DefineList& defines,
+        slang::IGlobalSession* pSlangGlobalSession,
+        std::string& log,
+        Program::string_time_map& fileTimeMap
+    ) const;
+    SlangCompileRequest* createSlangCompileRequest(
+        const Program& program,
+        const Program::DefineList& defines,
+        slang::IGlobalSession* pSlangGlobalSession
+    ) const;
+    SHA1::MD computeSourceHash(const Program& program, const Program::DefineList& defines, SlangCompileRequest* pSlangRequest) const;
+    static std::string getPermutationProgramDesc(const Program& program);
+    Slang::ComPtr<slang::IGlobalSession> acquireWorkerSlangGlobalSession() const;
+    void releaseWorkerSlangGlobalSession(Slang::ComPtr<slang::IGlobalSession> pSlangGlobalSession) const;
 
     Device* mpDevice;
 
     std::vector<Program*> mLoadedPrograms;
     mutable CompilationStats mCompilationStats;
+    mutable std::vector<PermutationRecord> mRecordedPermutations;
 
     Program::DefineList mGlobalDefineList;
     bool mGenerateDebugInfo = false;
     ForcedCompilerFlags mForcedCompilerFlags;
 
+    std::shared_ptr<KernelCache> mpKernelCache;
+
+    /// Slang global sessions used for compiling on worker threads. Sessions are taken from the list while in use.
+    mutable std::vector<Slang::ComPtr<slang::IGlobalSession>> mWorkerSlangGlobalSessions;
+    mutable std::mutex mWorkerSlangGlobalSessionsMutex;
+
     mutable uint32_t mHitGroupID = 0;
 };
 
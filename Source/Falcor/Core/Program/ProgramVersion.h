@@ -32,6 +32,7 @@
 #include "Core/API/fwd.h"
 #include "Core/API/Shader.h"
 #include "Core/API/Handles.h"
+#include "Utils/CryptoUtils.h"
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -200,6 +201,12 @@ public:
     slang::IComponentType* getSlangGlobalScope() const;
     slang::IComponentType* getSlangEntryPoint(uint32_t index) const;
 
+    /**
+     * Get the hash of all inputs that affect the compiled code of this version.
+     * This includes the contents of all source files and imported modules, the defines and the compiler settings.
+     */
+    const SHA1::MD& getSourceHash() const { return mSourceHash; }
+
 protected:
     friend class Program;
     friend class RtProgram;
@@ -222,6 +229,7 @@ protected:
     std::string mName;
     Slang::ComPtr<slang::IComponentType> mpSlangGlobalScope;
     std::vector<Slang::ComPtr<slang::IComponentType>> mpSlangEntryPoints;
+    SHA1::MD mSourceHash = {};
 
     // Cached version of compiled kernels for this program version
     mutable std::unordered_map<std::string, ref<const ProgramKernels>> mpKernels;
@@ -35,6 +35,7 @@
 #include "Utils/Algorithm/DirectedGraphTraversal.h"
 #include "Utils/Scripting/Scripting.h"
 #include "Utils/Scripting/ScriptBindings.h"
+#include "Utils/Timing/Profiler.h"
 
 namespace Falcor
 {
@@ -94,6 +95,7 @@ void RenderGraph::setScene(const ref<Scene>& pScene)
     for (auto& it : mNodeData)
     {
         it.second.pPass->setScene(mpDevice->getRenderContext(), pScene);
+        mDirtyPasses.insert(it.second.pPass.get());
     }
     mRecompile = true;
 }
@@ -121,7 +123,11 @@ uint32_t RenderGraph::addPass(const ref<RenderPass>& pPass, const std::string& p
         mNameToIndex[passName] = passIndex;
     }
 
-    pPass->mPassChangedCB = [this]() { mRecompile = true; };
+    pPass->mPassChangedCB = [this, pPass = pPass.get()]()
+    {
+        mRecompile = true;
+        mDirtyPasses.insert(pPass);
+    };
     pPass->mName = passName;
 
     if (mpScene)
@@ -192,7 +198,11 @@ void RenderGraph::updatePass(const std::string& passName, const Dictionary& dict
     std::string passTypeName = pOldPass->getType();
     auto pPass = RenderPass::create(passTypeName, mpDevice, dict);
     pPassIt->second.pPass = pPass;
-    pPass->mPassChangedCB = [this]() { mRecompile = true; };
+    pPass->mPassChangedCB = [this, pPass = pPass.get()]()
+    {
+        mRecompile = true;
+        mDirtyPasses.insert(pPass);
+    };
     pPass->mName = pOldPass->getName();
 
     if (mpScene)
@@ -460,12 +470,17 @@ bool RenderGraph::compile(RenderContext* pRenderContext, std::string& log)
 {
     if (!mRecompile)
         return true;
-    mpExe = nullptr;
+
+    FALCOR_PROFILE(pRenderContext, "RenderGraph::compile");
+
+    // The previous compilation result is used to only compile the passes affected by the changes and to reuse resources.
+    auto pPreviousExe = std::move(mpExe);
 
     try
     {
-        mpExe = RenderGraphCompiler::compile(*this, pRenderContext, mCompilerDeps);
+        mpExe = RenderGraphCompiler::compile(*this, pRenderContext, mCompilerDeps, pPreviousExe.get(), mDirtyPasses);
         mRecompile = false;
+        mDirtyPasses.clear();
         return true;
     }
     catch (const std::exception& e)
@@ -561,6 +576,20 @@ void RenderGraph::update(const ref<RenderGraph>& pGraph)
     }
 }
 
+void RenderGraph::setResourceAliasingEnabled(bool enabled)
+{
+    if (mCompilerDeps.resourceAliasing == enabled)
+        return;
+    mCompilerDeps.resourceAliasing = enabled;
+    mRecompile = true;
+}
+
+const ResourceAliasingPlanner::Stats& RenderGraph::getResourceAliasingStats() const
+{
+    FALCOR_ASSERT(mpExe);
+    return mpExe->getResourceAliasingStats();
+}
+
 void RenderGraph::setInput(const std::string& name, const ref<Resource>& pResource)
 {
     str_pair strPair;
@@ -786,6 +815,7 @@ FALCOR_SCRIPT_BINDING(RenderGraph)
     // RenderGraph
     pybind11::class_<RenderGraph, ref<RenderGraph>> renderGraph(m, "RenderGraph");
     renderGraph.def_property("name", &RenderGraph::getName, &RenderGraph::setName);
+    renderGraph.def_property("resource_aliasing", &RenderGraph::isResourceAliasingEnabled, &RenderGraph::setResourceAliasingEnabled);
 
     renderGraph.def(
         "create_pass",
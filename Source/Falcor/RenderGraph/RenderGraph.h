@@ -299,6 +299,23 @@ public:
      */
     void setName(const std::string& name) { mName = name; }
 
+    /**
+     * Check if transient resources with non-overlapping lifetimes share memory.
+     */
+    bool isResourceAliasingEnabled() const { return mCompilerDeps.resourceAliasing; }
+
+    /**
+     * Enable/disable sharing memory between transient resources with non-overlapping lifetimes.
+     * Disabling it keeps the contents of every pass output alive for the whole frame, which is useful for debugging. Triggers a
+     * recompilation of the graph.
+     */
+    void setResourceAliasingEnabled(bool enabled);
+
+    /**
+     * Get memory statistics of the graph-owned resources of the last compilation. The graph must have been compiled.
+     */
+    const ResourceAliasingPlanner::Stats& getResourceAliasingStats() const;
+
     /**
      * Compile the graph.
      */
@@ -380,6 +397,7 @@ private:
     std::unique_ptr<RenderGraphExe> mpExe;           ///< Helper for allocating resources and executing the graph.
     RenderGraphCompiler::Dependencies mCompilerDeps; ///< Data needed by the graph compiler.
     bool mRecompile = false; ///< Set to true to trigger a recompilation after any graph changes (topology/scene/size/passes/etc.)
+    std::unordered_set<const RenderPass*> mDirtyPasses; ///< Passes that requested a recompilation since the last compilation.
 
     friend class RenderGraphUI;
     friend class RenderGraphExporter;
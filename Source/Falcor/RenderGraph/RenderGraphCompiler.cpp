@@ -29,7 +29,9 @@
 #include "RenderGraph.h"
 #include "RenderPasses/ResolvePass.h"
 #include "Utils/Algorithm/DirectedGraphTraversal.h"
+#include "Utils/Logger.h"
 #include "Utils/StringUtils.h"
+#include "Utils/Timing/Profiler.h"
 
 namespace Falcor
 {
@@ -39,6 +41,12 @@ bool canAutoResolve(const RenderPassReflection::Field& src, const RenderPassRefl
 {
     return src.getSampleCount() > 1 && dst.getSampleCount() == 1;
 }
+
+bool isSameCompileData(const RenderPass::CompileData& a, const RenderPass::CompileData& b)
+{
+    return all(a.defaultTexDims == b.defaultTexDims) && a.defaultTexFormat == b.defaultTexFormat &&
+           a.connectedResources == b.connectedResources;
+}
 } // namespace
 
 RenderGraphCompiler::RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies)
@@ -48,29 +56,53 @@ RenderGraphCompiler::RenderGraphCompiler(RenderGraph& graph, const Dependencies&
 std::unique_ptr<RenderGraphExe> RenderGraphCompiler::compile(
     RenderGraph& graph,
     RenderContext* pRenderContext,
-    const Dependencies& dependencies
+    const Dependencies& dependencies,
+    const RenderGraphExe* pPreviousExe,
+    const std::unordered_set<const RenderPass*>& dirtyPasses
 )
 {
     RenderGraphCompiler c = RenderGraphCompiler(graph, dependencies);
 
     // Register the external resources
     auto pResourcesCache = std::make_unique<ResourceCache>();
+    pResourcesCache->setAliasingEnabled(dependencies.resourceAliasing);
     for (const auto& [name, pRes] : dependencies.externalResources)
         pResourcesCache->registerExternalResource(name, pRes);
 
-    c.resolveExecutionOrder();
-    c.compilePasses(pRenderContext);
+    {
+        FALCOR_PROFILE(pRenderContext, "resolveExecutionOrder");
+        c.resolveExecutionOrder();
+    }
+    {
+        FALCOR_PROFILE(pRenderContext, "compilePasses");
+        c.compilePasses(pRenderContext, pPreviousExe, dirtyPasses);
+    }
     if (c.insertAutoPasses())
+    {
+        // Keep track of the compiled passes across the re-resolve
+        auto executionList = std::move(c.mExecutionList);
         c.resolveExecutionOrder();
+        for (auto& p : c.mExecutionList)
+        {
+            for (const auto& prev : executionList)
+                if (prev.pPass == p.pPass)
+                    p.compiledWith = prev.compiledWith;
+        }
+    }
     c.validateGraph();
-    c.allocateResources(pRenderContext->getDevice(), pResourcesCache.get());
+    {
+        FALCOR_PROFILE(pRenderContext, "allocateResources");
+        c.allocateResources(
+            pRenderContext->getDevice(), pResourcesCache.get(), pPreviousExe ? pPreviousExe->mpResourceCache.get() : nullptr
+        );
+    }
 
     auto pExe = std::make_unique<RenderGraphExe>();
     pExe->mExecutionList.reserve(c.mExecutionList.size());
 
     for (auto e : c.mExecutionList)
     {
-        pExe->insertPass(e.name, e.pPass);
+        pExe->insertPass(e.name, e.pPass, e.compiledWith);
     }
     c.restoreCompilationChanges();
     pExe->mpResourceCache = std::move(pResourcesCache);
@@ -260,15 +292,8 @@ bool RenderGraphCompiler::insertAutoPasses()
     return addedPasses;
 }
 
-void RenderGraphCompiler::allocateResources(ref<Device> pDevice, ResourceCache* pResourceCache)
+void RenderGraphCompiler::allocateResources(ref<Device> pDevice, ResourceCache* pResourceCache, const ResourceCache* pPreviousResourceCache)
 {
-    // Build list to look up execution order index from the pass
-    std::unordered_map<RenderPass*, uint32_t> passToIndex;
-    for (size_t i = 0; i < mExecutionList.size(); i++)
-    {
-        passToIndex.emplace(mExecutionList[i].pPass.get(), uint32_t(i));
-    }
-
     for (size_t i = 0; i < mExecutionList.size(); i++)
     {
         uint32_t nodeIndex = mExecutionList[i].index;
@@ -335,13 +360,12 @@ void RenderGraphCompiler::allocateResources(ref<Device> pDevice, ResourceCache*
             std::string srcFieldName = mGraph.mNodeData[pEdge->getSourceNode()].name + '.' + edgeData.srcField;
             std::string dstFieldName = mGraph.mNodeData[nodeIndex].name + '.' + dstField.getName();
 
-            const auto& pSrcPass = mGraph.mNodeData[pEdge->getSourceNode()].pPass.get();
-            const auto& srcReflection = mExecutionList[passToIndex.at(pSrcPass)].reflector;
-            pResourceCache->registerField(dstFieldName, dstField, passToIndex[pSrcPass], srcFieldName);
+            // The resource is used until this pass executes, so extend its lifetime to the current execution index
+            pResourceCache->registerField(dstFieldName, dstField, uint32_t(i), srcFieldName);
         }
     }
 
-    pResourceCache->allocateResources(pDevice, mDependencies.defaultResourceProps);
+    pResourceCache->allocateResources(pDevice, mDependencies.defaultResourceProps, pPreviousResourceCache);
 }
 
 void RenderGraphCompiler::restoreCompilationChanges()
@@ -434,27 +458,58 @@ RenderPass::CompileData RenderGraphCompiler::prepPassCompilationData(const PassD
     return compileData;
 }
 
-void RenderGraphCompiler::compilePasses(RenderContext* pRenderContext)
+void RenderGraphCompiler::compilePasses(
+    RenderContext* pRenderContext,
+    const RenderGraphExe* pPreviousExe,
+    const std::unordered_set<const RenderPass*>& dirtyPasses
+)
 {
+    // Passes from the previous compilation that did not request a recompile only need to be compiled again if their compile data changed.
+    // Changes to a pass therefore only propagate to the passes whose connected resources are affected by it.
+    if (pPreviousExe)
+    {
+        for (auto& p : mExecutionList)
+        {
+            if (dirtyPasses.count(p.pPass.get()) != 0)
+                continue;
+            for (const auto& prev : pPreviousExe->mExecutionList)
+            {
+                if (prev.pPass == p.pPass)
+                {
+                    p.compiledWith = prev.compileData;
+                    break;
+                }
+            }
+        }
+    }
+
+    uint32_t compiledCount = 0;
     while (1)
     {
         std::string log;
         bool success = true;
         for (auto& p : mExecutionList)
         {
+            auto compileData = prepPassCompilationData(p);
+            if (p.compiledWith && isSameCompileData(*p.compiledWith, compileData))
+                continue;
+
             try
             {
-                p.pPass->compile(pRenderContext, prepPassCompilationData(p));
+                compiledCount++;
+                p.pPass->compile(pRenderContext, compileData);
+                p.compiledWith = compileData;
             }
             catch (const std::exception& e)
             {
                 log += std::string(e.what()) + "\n";
+                p.compiledWith.reset();
                 success = false;
             }
         }
 
         if (success)
-            return;
+            break;
 
         // Retry
         bool changed = false;
@@ -471,8 +526,10 @@ void RenderGraphCompiler::compilePasses(RenderContext* pRenderContext)
         if (!changed)
         {
             reportError("Graph compilation failed.\n" + log);
-            return;
+            break;
         }
     }
+
+    logDebug("RenderGraphCompiler: Compiled {} passes for an execution list of {} passes.", compiledCount, mExecutionList.size());
 }
 } // namespace Falcor
@@ -31,7 +31,9 @@
 #include "ResourceCache.h"
 #include "RenderGraphExe.h"
 #include "Core/Macros.h"
+#include <optional>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -46,8 +48,26 @@ public:
     {
         ResourceCache::DefaultProperties defaultResourceProps;
         ResourceCache::ResourcesMap externalResources;
+        bool resourceAliasing = true; ///< Share memory between transient resources with non-overlapping lifetimes.
     };
-    static std::unique_ptr<RenderGraphExe> compile(RenderGraph& graph, RenderContext* pRenderContext, const Dependencies& dependencies);
+    /**
+     * Compile a render graph.
+     * If the result of a previous compilation is given, passes that are not marked as dirty and whose compile data is unchanged
+     * are not compiled again, and resources with unchanged properties are reused.
+     * @param[in] graph The render graph.
+     * @param[in] pRenderContext The render context.
+     * @param[in] dependencies Data needed by the compiler.
+     * @param[in] pPreviousExe Optional. Result of the previous compilation of the graph.
+     * @param[in] dirtyPasses Passes that need to be compiled even if their compile data is unchanged.
+     * @return The compiled graph.
+     */
+    static std::unique_ptr<RenderGraphExe> compile(
+        RenderGraph& graph,
+        RenderContext* pRenderContext,
+        const Dependencies& dependencies,
+        const RenderGraphExe* pPreviousExe = nullptr,
+        const std::unordered_set<const RenderPass*>& dirtyPasses = {}
+    );
 
 private:
     RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies);
@@ -62,6 +82,7 @@ private:
         ref<RenderPass> pPass;
         std::string name;
         RenderPassReflection reflector;
+        std::optional<RenderPass::CompileData> compiledWith; ///< Compile data of the last successful compilation of the pass.
     };
     std::vector<PassData> mExecutionList;
 
@@ -73,9 +94,13 @@ private:
     } mCompilationChanges;
 
     void resolveExecutionOrder();
-    void compilePasses(RenderContext* pRenderContext);
+    void compilePasses(
+        RenderContext* pRenderContext,
+        const RenderGraphExe* pPreviousExe,
+        const std::unordered_set<const RenderPass*>& dirtyPasses
+    );
     bool insertAutoPasses();
-    void allocateResources(ref<Device> pDevice, ResourceCache* pResourceCache);
+    void allocateResources(ref<Device> pDevice, ResourceCache* pResourceCache, const ResourceCache* pPreviousResourceCache);
     void validateGraph() const;
     void restoreCompilationChanges();
     RenderPass::CompileData prepPassCompilationData(const PassData& passData);
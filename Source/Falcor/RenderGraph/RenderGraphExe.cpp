@@ -45,6 +45,17 @@ void RenderGraphExe::execute(const Context& ctx)
 
 void RenderGraphExe::renderUI(RenderContext* pRenderContext, Gui::Widgets& widget)
 {
+    if (auto resourceGroup = widget.group("Graph Resources"))
+    {
+        const auto& stats = mpResourceCache->getAliasingStats();
+        const double kMB = 1024.0 * 1024.0;
+        resourceGroup.text(fmt::format("Resources: {} in {} allocations", stats.requestCount, stats.slotCount));
+        resourceGroup.text(
+            fmt::format("Allocated: {:.1f} MB (without sharing {:.1f} MB)", stats.allocatedBytes / kMB, stats.summedBytes / kMB)
+        );
+        resourceGroup.text(fmt::format("Peak in use: {:.1f} MB", stats.peakBytes / kMB));
+    }
+
     for (const auto& p : mExecutionList)
     {
         const auto& pPass = p.pPass;
@@ -93,9 +104,19 @@ void RenderGraphExe::onHotReload(HotReloadFlags reloaded)
     }
 }
 
-void RenderGraphExe::insertPass(const std::string& name, const ref<RenderPass>& pPass)
+void RenderGraphExe::insertPass(
+    const std::string& name,
+    const ref<RenderPass>& pPass,
+    const std::optional<RenderPass::CompileData>& compileData
+)
 {
-    mExecutionList.push_back(Pass(name, pPass));
+    mExecutionList.push_back(Pass(name, pPass, compileData));
+}
+
+const ResourceAliasingPlanner::Stats& RenderGraphExe::getResourceAliasingStats() const
+{
+    FALCOR_ASSERT(mpResourceCache);
+    return mpResourceCache->getAliasingStats();
 }
 
 ref<Resource> RenderGraphExe::getResource(const std::string& name) const
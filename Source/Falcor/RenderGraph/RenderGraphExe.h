@@ -35,6 +35,7 @@
 #include "Utils/UI/Gui.h"
 #include "Utils/InternalDictionary.h"
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -94,19 +95,27 @@ public:
      */
     void setInput(const std::string& name, const ref<Resource>& pResource);
 
+    /**
+     * Get memory statistics of the graph-owned resources, including the savings from sharing resources between fields.
+     */
+    const ResourceAliasingPlanner::Stats& getResourceAliasingStats() const;
+
 private:
     friend class RenderGraphCompiler;
 
-    void insertPass(const std::string& name, const ref<RenderPass>& pPass);
+    void insertPass(const std::string& name, const ref<RenderPass>& pPass, const std::optional<RenderPass::CompileData>& compileData);
 
     struct Pass
     {
         std::string name;
         ref<RenderPass> pPass;
+        std::optional<RenderPass::CompileData> compileData; ///< Data the pass was successfully compiled with, if any.
 
     private:
         friend class RenderGraphExe; // Force RenderGraphCompiler to use insertPass() by hiding this Ctor from it
-        Pass(const std::string& name_, const ref<RenderPass>& pPass_) : name(name_), pPass(pPass_) {}
+        Pass(const std::string& name_, const ref<RenderPass>& pPass_, const std::optional<RenderPass::CompileData>& compileData_)
+            : name(name_), pPass(pPass_), compileData(compileData_)
+        {}
     };
 
     std::vector<Pass> mExecutionList;
@@ -0,0 +1,118 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "ResourceAliasingPlanner.h"
+#include "Core/Assert.h"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+namespace Falcor
+{
+ResourceAliasingPlanner::Plan ResourceAliasingPlanner::plan(const std::vector<Request>& requests)
+{
+    Plan plan;
+    plan.slots.resize(requests.size());
+    plan.stats.requestCount = (uint32_t)requests.size();
+
+    // Process the requests in order of their first use.
+    std::vector<uint32_t> order(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(
+        order.begin(),
+        order.end(),
+        [&](uint32_t a, uint32_t b) { return requests[a].firstUse < requests[b].firstUse; }
+    );
+
+    // For each group, keep the slots ordered by the last use of the request currently assigned to them.
+    using SlotQueue = std::priority_queue<std::pair<uint32_t, uint32_t>, std::vector<std::pair<uint32_t, uint32_t>>, std::greater<>>;
+    std::unordered_map<uint32_t, SlotQueue> groupSlots;
+
+    auto createSlot = [&plan]()
+    {
+        plan.slotSizes.push_back(0);
+        return (uint32_t)plan.slotSizes.size() - 1;
+    };
+
+    for (uint32_t i : order)
+    {
+        const auto& request = requests[i];
+        FALCOR_ASSERT(request.firstUse <= request.lastUse);
+
+        uint32_t slot;
+        if (request.exclusive)
+        {
+            slot = createSlot();
+        }
+        else
+        {
+            // Reuse a slot if the lifetime of its current request ended before this one starts.
+            auto& slots = groupSlots[request.group];
+            if (!slots.empty() && slots.top().first < request.firstUse)
+            {
+                slot = slots.top().second;
+                slots.pop();
+            }
+            else
+            {
+                slot = createSlot();
+            }
+            slots.push({request.lastUse, slot});
+        }
+
+        plan.slots[i] = slot;
+        plan.slotSizes[slot] = std::max(plan.slotSizes[slot], request.sizeInBytes);
+        plan.stats.summedBytes += request.sizeInBytes;
+    }
+
+    plan.stats.slotCount = (uint32_t)plan.slotSizes.size();
+    plan.stats.allocatedBytes = std::accumulate(plan.slotSizes.begin(), plan.slotSizes.end(), uint64_t(0));
+
+    // Sweep over the lifetimes to find the peak memory in use. Lifetimes are inclusive so a request ending
+    // at time t is released at t + 1, before any request starting at t + 1 is added.
+    std::vector<std::pair<uint64_t, int64_t>> events;
+    events.reserve(requests.size() * 2);
+    for (const auto& request : requests)
+    {
+        events.push_back({request.firstUse, (int64_t)request.sizeInBytes});
+        events.push_back({uint64_t(request.lastUse) + 1, -(int64_t)request.sizeInBytes});
+    }
+    std::sort(events.begin(), events.end());
+
+    int64_t bytes = 0;
+    for (const auto& [time, delta] : events)
+    {
+        bytes += delta;
+        plan.stats.peakBytes = std::max(plan.stats.peakBytes, (uint64_t)bytes);
+    }
+
+    return plan;
+}
+} // namespace Falcor
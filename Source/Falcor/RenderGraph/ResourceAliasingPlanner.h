@@ -0,0 +1,80 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Plans how render graph resources with non-overlapping lifetimes can share the same backing resource.
+ *
+ * Each request describes one resource by the range of execution indices it is used in and a compatibility group.
+ * Only requests of the same group can share a slot; the caller assigns groups such that resources in a group
+ * have identical descriptions. Within a group the requests are assigned to slots by greedy interval partitioning,
+ * which yields the minimum number of slots for interval lifetimes.
+ *
+ * The planner is a pure CPU component and does not create any resources.
+ */
+class FALCOR_API ResourceAliasingPlanner
+{
+public:
+    struct Request
+    {
+        uint32_t firstUse = 0;     ///< First execution index the resource is used in.
+        uint32_t lastUse = 0;      ///< Last execution index the resource is used in (inclusive).
+        uint64_t sizeInBytes = 0;  ///< Size of the resource in bytes.
+        uint32_t group = 0;        ///< Compatibility group. Only requests with the same group can share a slot.
+        bool exclusive = false;    ///< If true the request gets its own slot (persistent or externally visible resources).
+    };
+
+    struct Stats
+    {
+        uint32_t requestCount = 0;   ///< Number of requests.
+        uint32_t slotCount = 0;      ///< Number of slots, i.e. resources that need to be created.
+        uint64_t summedBytes = 0;    ///< Sum of the sizes of all requests. This is the memory used without aliasing.
+        uint64_t allocatedBytes = 0; ///< Sum of the sizes of all slots. This is the memory used with the plan.
+        uint64_t peakBytes = 0;      ///< Maximum sum of the sizes of all requests in use at the same time. Lower bound for any plan.
+    };
+
+    struct Plan
+    {
+        std::vector<uint32_t> slots;     ///< Slot index for each request.
+        std::vector<uint64_t> slotSizes; ///< Size of each slot in bytes.
+        Stats stats;                     ///< Memory statistics.
+    };
+
+    /**
+     * Compute a plan for a set of requests.
+     * @param[in] requests List of requests.
+     * @return The plan.
+     */
+    static Plan plan(const std::vector<Request>& requests);
+};
+} // namespace Falcor
@@ -30,6 +30,8 @@
 #include "Core/API/Texture.h"
 #include "Core/API/Buffer.h"
 #include "Utils/Logger.h"
+#include <algorithm>
+#include <unordered_set>
 
 namespace Falcor
 {
@@ -106,7 +108,9 @@ void ResourceCache::registerField(
         FALCOR_ASSERT(mNameToIndex.count(name) == 0);
         mNameToIndex[name] = (uint32_t)mResourceData.size();
         bool resolveBindFlags = (field.getBindFlags() == ResourceBindFlags::None);
-        mResourceData.push_back({field, {timePoint, timePoint}, nullptr, resolveBindFlags, name});
+        bool transient = !is_set(field.getFlags(), RenderPassReflection::Field::Flags::Persistent) &&
+                         !is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Internal);
+        mResourceData.push_back({field, {timePoint, timePoint}, nullptr, resolveBindFlags, name, transient, {}});
     }
     else // Add alias
     {
@@ -116,30 +120,36 @@ void ResourceCache::registerField(
         mergeTimePoint(mResourceData[index].lifetime, timePoint);
         mResourceData[index].pResource = nullptr;
         mResourceData[index].resolveBindFlags = mResourceData[index].resolveBindFlags || (field.getBindFlags() == ResourceBindFlags::None);
+        mResourceData[index].transient =
+            mResourceData[index].transient && !is_set(field.getFlags(), RenderPassReflection::Field::Flags::Persistent);
     }
 }
 
-inline ref<Resource> createResourceForPass(
+namespace
+{
+using ResourceDesc = ResourceCache::ResourceDesc;
+
+ResourceDesc resolveResourceDesc(
     ref<Device> pDevice,
     const ResourceCache::DefaultProperties& params,
     const RenderPassReflection::Field& field,
-    bool resolveBindFlags,
-    const std::string& resourceName
+    bool resolveBindFlags
 )
 {
-    uint32_t width = field.getWidth() ? field.getWidth() : params.dims.x;
-    uint32_t height = field.getHeight() ? field.getHeight() : params.dims.y;
-    uint32_t depth = field.getDepth() ? field.getDepth() : 1;
-    uint32_t sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
-    auto bindFlags = field.getBindFlags();
-    auto arraySize = field.getArraySize();
-    auto mipLevels = field.getMipCount();
-
-    ResourceFormat format = ResourceFormat::Unknown;
+    ResourceDesc desc;
+    desc.type = field.getType();
+    desc.width = field.getWidth() ? field.getWidth() : params.dims.x;
+    desc.height = field.getHeight() ? field.getHeight() : params.dims.y;
+    desc.depth = field.getDepth() ? field.getDepth() : 1;
+    desc.sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
+    desc.bindFlags = field.getBindFlags();
+    desc.arraySize = field.getArraySize();
+    desc.mipLevels = field.getMipCount();
+    desc.format = ResourceFormat::Unknown;
 
     if (field.getType() != RenderPassReflection::Field::Type::RawBuffer)
     {
-        format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
+        desc.format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
         if (resolveBindFlags)
         {
             ResourceBindFlags mask = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
@@ -147,41 +157,89 @@ inline ref<Resource> createResourceForPass(
             bool isInternal = is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Internal);
             if (isOutput || isInternal)
                 mask |= Resource::BindFlags::DepthStencil | Resource::BindFlags::RenderTarget;
-            auto supported = pDevice->getFormatBindFlags(format);
+            auto supported = pDevice->getFormatBindFlags(desc.format);
             mask &= supported;
-            bindFlags |= mask;
+            desc.bindFlags |= mask;
         }
     }
     else // RawBuffer
     {
         if (resolveBindFlags)
-            bindFlags = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
+            desc.bindFlags = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
+    }
+    return desc;
+}
+
+/**
+ * Estimate the size of a resource in bytes. Only used for reporting, so alignment and padding are ignored.
+ */
+uint64_t estimateSizeInBytes(const ResourceDesc& desc)
+{
+    if (desc.type == RenderPassReflection::Field::Type::RawBuffer)
+        return desc.width;
+
+    uint32_t width = desc.width;
+    uint32_t height = desc.type == RenderPassReflection::Field::Type::Texture1D ? 1 : desc.height;
+    uint32_t depth = desc.type == RenderPassReflection::Field::Type::Texture3D ? desc.depth : 1;
+    uint32_t layers = desc.type == RenderPassReflection::Field::Type::Texture3D ? 1 : desc.arraySize;
+    if (desc.type == RenderPassReflection::Field::Type::TextureCube)
+        layers *= 6;
+
+    uint32_t mipLevels = desc.mipLevels;
+    if (mipLevels == Resource::kMaxPossible || desc.sampleCount > 1)
+    {
+        uint32_t fullChain = 1;
+        for (uint32_t dim = std::max({width, height, depth}); dim > 1; dim >>= 1)
+            fullChain++;
+        mipLevels = desc.sampleCount > 1 ? 1 : fullChain;
     }
+
+    uint32_t blockWidth = getFormatWidthCompressionRatio(desc.format);
+    uint32_t blockHeight = getFormatHeightCompressionRatio(desc.format);
+    uint64_t bytes = 0;
+    for (uint32_t mip = 0; mip < mipLevels; mip++)
+    {
+        uint64_t w = (std::max(width >> mip, 1u) + blockWidth - 1) / blockWidth;
+        uint64_t h = (std::max(height >> mip, 1u) + blockHeight - 1) / blockHeight;
+        uint64_t d = std::max(depth >> mip, 1u);
+        bytes += w * h * d;
+    }
+    return bytes * layers * desc.sampleCount * getFormatBytesPerBlock(desc.format);
+}
+
+ref<Resource> createResource(ref<Device> pDevice, const ResourceDesc& desc, const std::string& resourceName)
+{
     ref<Resource> pResource;
 
-    switch (field.getType())
+    switch (desc.type)
     {
     case RenderPassReflection::Field::Type::RawBuffer:
-        pResource = Buffer::create(pDevice, width, bindFlags, Buffer::CpuAccess::None);
+        pResource = Buffer::create(pDevice, desc.width, desc.bindFlags, Buffer::CpuAccess::None);
         break;
     case RenderPassReflection::Field::Type::Texture1D:
-        pResource = Texture::create1D(pDevice, width, format, arraySize, mipLevels, nullptr, bindFlags);
+        pResource = Texture::create1D(pDevice, desc.width, desc.format, desc.arraySize, desc.mipLevels, nullptr, desc.bindFlags);
         break;
     case RenderPassReflection::Field::Type::Texture2D:
-        if (sampleCount > 1)
+        if (desc.sampleCount > 1)
         {
-            pResource = Texture::create2DMS(pDevice, width, height, format, sampleCount, arraySize, bindFlags);
+            pResource =
+                Texture::create2DMS(pDevice, desc.width, desc.height, desc.format, desc.sampleCount, desc.arraySize, desc.bindFlags);
         }
         else
         {
-            pResource = Texture::create2D(pDevice, width, height, format, arraySize, mipLevels, nullptr, bindFlags);
+            pResource = Texture::create2D(
+                pDevice, desc.width, desc.height, desc.format, desc.arraySize, desc.mipLevels, nullptr, desc.bindFlags
+            );
         }
         break;
     case RenderPassReflection::Field::Type::Texture3D:
-        pResource = Texture::create3D(pDevice, width, height, depth, format, mipLevels, nullptr, bindFlags);
+        pResource =
+            Texture::create3D(pDevice, desc.width, desc.height, desc.depth, desc.format, desc.mipLevels, nullptr, desc.bindFlags);
         break;
     case RenderPassReflection::Field::Type::TextureCube:
-        pResource = Texture::createCube(pDevice, width, height, format, arraySize, mipLevels, nullptr, bindFlags);
+        pResource = Texture::createCube(
+            pDevice, desc.width, desc.height, desc.format, desc.arraySize, desc.mipLevels, nullptr, desc.bindFlags
+        );
         break;
     default:
         FALCOR_UNREACHABLE();
@@ -190,15 +248,99 @@ inline ref<Resource> createResourceForPass(
     pResource->setName(resourceName);
     return pResource;
 }
+} // namespace
 
-void ResourceCache::allocateResources(ref<Device> pDevice, const DefaultProperties& params)
+void ResourceCache::allocateResources(ref<Device> pDevice, const DefaultProperties& params, const ResourceCache* pPreviousCache)
 {
-    for (auto& data : mResourceData)
+    // Resolve the descriptions of all resources that need to be created.
+    // Fields with identical descriptions form a group and may share a resource if their lifetimes don't overlap.
+    std::vector<uint32_t> pending;
+    std::vector<ResourceDesc> descs;
+    std::vector<ResourceAliasingPlanner::Request> requests;
+    for (uint32_t i = 0; i < (uint32_t)mResourceData.size(); i++)
     {
-        if ((data.pResource == nullptr) && (data.field.isValid()))
+        auto& data = mResourceData[i];
+        if ((data.pResource != nullptr) || (data.field.isValid() == false))
+            continue;
+
+        data.desc = resolveResourceDesc(pDevice, params, data.field, data.resolveBindFlags);
+        uint32_t group = uint32_t(std::find(descs.begin(), descs.end(), data.desc) - descs.begin());
+        if (group == descs.size())
+            descs.push_back(data.desc);
+
+        // Graph outputs have their lifetime extended to the end of the graph execution.
+        bool graphOutput = data.lifetime.second == uint32_t(-1);
+        bool external = mExternalResources.count(data.name) != 0;
+
+        ResourceAliasingPlanner::Request request;
+        request.firstUse = data.lifetime.first;
+        request.lastUse = data.lifetime.second;
+        request.sizeInBytes = estimateSizeInBytes(data.desc);
+        request.group = group;
+        request.exclusive = !mAliasingEnabled || !data.transient || graphOutput || external;
+        requests.push_back(request);
+        pending.push_back(i);
+    }
+
+    auto plan = ResourceAliasingPlanner::plan(requests);
+    mAliasingStats = plan.stats;
+
+    // Name each resource after all the fields sharing it.
+    std::vector<std::string> slotNames(plan.stats.slotCount);
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        auto& slotName = slotNames[plan.slots[i]];
+        slotName += (slotName.empty() ? "" : ", ") + mResourceData[pending[i]].name;
+    }
+
+    // Take over resources from the previous cache for fields whose description did not change.
+    // Each previous resource is used for at most one slot, as the previous cache may have shared it differently.
+    std::vector<ref<Resource>> slotResources(plan.stats.slotCount);
+    uint32_t reusedCount = 0;
+    if (pPreviousCache)
+    {
+        std::unordered_set<const Resource*> usedResources;
+        for (size_t i = 0; i < pending.size(); i++)
         {
-            data.pResource = createResourceForPass(pDevice, params, data.field, data.resolveBindFlags, data.name);
+            uint32_t slot = plan.slots[i];
+            const auto& data = mResourceData[pending[i]];
+            auto it = pPreviousCache->mNameToIndex.find(data.name);
+            if (slotResources[slot] != nullptr || it == pPreviousCache->mNameToIndex.end())
+                continue;
+
+            const auto& previousData = pPreviousCache->mResourceData[it->second];
+            if (previousData.pResource == nullptr || !(previousData.desc == data.desc) ||
+                usedResources.count(previousData.pResource.get()) != 0)
+                continue;
+
+            slotResources[slot] = previousData.pResource;
+            slotResources[slot]->setName(slotNames[slot]);
+            usedResources.insert(previousData.pResource.get());
+            reusedCount++;
         }
     }
+
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        uint32_t slot = plan.slots[i];
+        if (slotResources[slot] == nullptr)
+            slotResources[slot] = createResource(pDevice, descs[requests[i].group], slotNames[slot]);
+        mResourceData[pending[i]].pResource = slotResources[slot];
+    }
+
+    if (reusedCount > 0)
+        logDebug("ResourceCache: Reused {} of {} resources from the previous compilation.", reusedCount, plan.stats.slotCount);
+
+    if (plan.stats.slotCount < plan.stats.requestCount)
+    {
+        logDebug(
+            "ResourceCache: {} resources share {} allocations, {:.1f} MB instead of {:.1f} MB (peak in use {:.1f} MB).",
+            plan.stats.requestCount,
+            plan.stats.slotCount,
+            plan.stats.allocatedBytes / (1024.0 * 1024.0),
+            plan.stats.summedBytes / (1024.0 * 1024.0),
+            plan.stats.peakBytes / (1024.0 * 1024.0)
+        );
+    }
 }
 } // namespace Falcor
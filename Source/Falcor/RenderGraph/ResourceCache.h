@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "RenderPassReflection.h"
+#include "ResourceAliasingPlanner.h"
 #include "Core/Macros.h"
 #include "Core/API/fwd.h"
 #include "Core/API/Resource.h"
@@ -51,6 +52,29 @@ public:
         ResourceFormat format = ResourceFormat::Unknown; ///< Format to use for texture creation
     };
 
+    /**
+     * Fully resolved description of a resource created for a field.
+     */
+    struct ResourceDesc
+    {
+        RenderPassReflection::Field::Type type = RenderPassReflection::Field::Type::Texture2D;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 0;
+        uint32_t sampleCount = 0;
+        uint32_t arraySize = 0;
+        uint32_t mipLevels = 0;
+        ResourceFormat format = ResourceFormat::Unknown;
+        ResourceBindFlags bindFlags = ResourceBindFlags::None;
+
+        bool operator==(const ResourceDesc& other) const
+        {
+            return type == other.type && width == other.width && height == other.height && depth == other.depth &&
+                   sampleCount == other.sampleCount && arraySize == other.arraySize && mipLevels == other.mipLevels &&
+                   format == other.format && bindFlags == other.bindFlags;
+        }
+    };
+
     /**
      * Add/Remove reference to a graph input resource not owned by the cache
      * @param[in] name The resource's name
@@ -86,8 +110,24 @@ public:
     /**
      * Allocate all resources that need to be created/updated.
      * This includes new resources, resources whose properties have been updated since last allocation call.
+     * @param[in] pDevice GPU device.
+     * @param[in] params Default properties for fields that don't specify them.
+     * @param[in] pPreviousCache Optional. Cache of a previous compilation of the same graph. Resources of fields with the same name and
+     * description are taken over from it instead of being created.
      */
-    void allocateResources(ref<Device> pDevice, const DefaultProperties& params);
+    void allocateResources(ref<Device> pDevice, const DefaultProperties& params, const ResourceCache* pPreviousCache = nullptr);
+
+    /**
+     * Enable/disable sharing of resources between fields with non-overlapping lifetimes.
+     * Fields that are persistent, internal, graph outputs or overridden by external resources are never shared.
+     * Takes effect on the next call to allocateResources().
+     */
+    void setAliasingEnabled(bool enabled) { mAliasingEnabled = enabled; }
+
+    /**
+     * Get memory statistics of the last call to allocateResources().
+     */
+    const ResourceAliasingPlanner::Stats& getAliasingStats() const { return mAliasingStats; }
 
     /**
      * Clears all registered field/resource properties and allocated resources.
@@ -102,6 +142,8 @@ private:
         ref<Resource> pResource;                // The resource
         bool resolveBindFlags;                  // Whether or not we should resolve the field's bind-flags before creating the resource
         std::string name;                       // Full name of the resource, including the pass name
+        bool transient;                         // Whether or not the contents are only needed within the lifetime, allowing sharing
+        ResourceDesc desc;                      // Description the resource was created with
     };
 
     // Resources and properties for fields within (and therefore owned by) a render graph
@@ -110,6 +152,9 @@ private:
 
     // References to output resources not to be allocated by the render graph
     ResourcesMap mExternalResources;
+
+    bool mAliasingEnabled = true;
+    ResourceAliasingPlanner::Stats mAliasingStats;
 };
 
 } // namespace Falcor
@@ -43,43 +43,100 @@ namespace Falcor
     {
         mLeafUpdater = ComputePass::create(mpDevice, kShaderFile, "updateLeafNodes");
         mInternalUpdater = ComputePass::create(mpDevice, kShaderFile, "updateInternalNodes");
+        mpStagingFence = GpuFence::create(mpDevice);
     }
 
-    // TODO: Only update the ones that moved.
     void LightBVH::refit(RenderContext* pRenderContext)
     {
         FALCOR_PROFILE(pRenderContext, "LightBVH::refit()");
 
         FALCOR_ASSERT(mIsValid);
 
-        // Update all leaf nodes.
+        refitNodes(pRenderContext, mpNodeIndicesBuffer, mPerDepthRefitEntryInfo);
+
+        mRefitStats.refitCount++;
+        mRefitStats.lastRefitNodeCount = (uint32_t)mNodeIndices.size();
+        mRefitStats.lastRefitWasFull = true;
+    }
+
+    void LightBVH::refit(RenderContext* pRenderContext, const std::vector<uint32_t>& updatedLights)
+    {
+        FALCOR_PROFILE(pRenderContext, "LightBVH::refit()");
+
+        FALCOR_ASSERT(mIsValid);
+
+        LightBVHRefitPlanner::Plan plan;
+        {
+            FALCOR_PROFILE(pRenderContext, "LightBVH::planRefit()");
+
+            const auto& meshLights = mpLightCollection->getMeshLights();
+            std::vector<LightBVHRefitPlanner::TriangleRange> triangleRanges;
+            triangleRanges.reserve(updatedLights.size());
+            for (uint32_t lightIdx : updatedLights)
+            {
+                FALCOR_ASSERT(lightIdx < meshLights.size());
+                triangleRanges.push_back({ meshLights[lightIdx].triangleOffset, meshLights[lightIdx].triangleCount });
+            }
+            plan = mRefitPlanner.plan(triangleRanges);
+        }
+
+        // Uploading the node list is only worth it for a small part of the tree. Otherwise refit all nodes.
+        const bool fullRefit = plan.nodeIndices.size() > mNodeIndices.size() / 2;
+        if (fullRefit)
+        {
+            refitNodes(pRenderContext, mpNodeIndicesBuffer, mPerDepthRefitEntryInfo);
+        }
+        else if (!plan.nodeIndices.empty())
+        {
+            if (!mpRefitNodeIndicesBuffer || mpRefitNodeIndicesBuffer->getElementCount() < plan.nodeIndices.size())
+            {
+                // Allocate for the worst case to avoid reallocating when more lights start moving.
+                mpRefitNodeIndicesBuffer = Buffer::createStructured(mpDevice, sizeof(uint32_t), (uint32_t)mNodeIndices.size(), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
+                mpRefitNodeIndicesBuffer->setName("LightBVH::mpRefitNodeIndicesBuffer");
+            }
+            mpRefitNodeIndicesBuffer->setBlob(plan.nodeIndices.data(), 0, plan.nodeIndices.size() * sizeof(uint32_t));
+
+            refitNodes(pRenderContext, mpRefitNodeIndicesBuffer, plan.perDepthRefitEntryInfo);
+        }
+
+        mRefitStats.refitCount++;
+        mRefitStats.lastRefitNodeCount = fullRefit ? (uint32_t)mNodeIndices.size() : (uint32_t)plan.nodeIndices.size();
+        mRefitStats.lastRefitWasFull = fullRefit;
+    }
+
+    void LightBVH::refitNodes(RenderContext* pRenderContext, const ref<Buffer>& pNodeIndicesBuffer, const std::vector<RefitEntryInfo>& perDepthRefitEntryInfo)
+    {
+        FALCOR_ASSERT(perDepthRefitEntryInfo.size() == mBVHStats.treeHeight + 1);
+
+        // Update the leaf nodes.
         {
             auto var = mLeafUpdater->getRootVar()["CB"];
             mpLightCollection->setShaderData(var["gLights"]);
             setShaderData(var["gLightBVH"]);
-            var["gNodeIndices"] = mpNodeIndicesBuffer;
+            var["gNodeIndices"] = pNodeIndicesBuffer;
 
-            const uint32_t nodeCount = mPerDepthRefitEntryInfo.back().count;
+            const uint32_t nodeCount = perDepthRefitEntryInfo.back().count;
             FALCOR_ASSERT(nodeCount > 0);
-            var["gFirstNodeOffset"] = mPerDepthRefitEntryInfo.back().offset;
+            var["gFirstNodeOffset"] = perDepthRefitEntryInfo.back().offset;
             var["gNodeCount"] = nodeCount;
 
             mLeafUpdater->execute(pRenderContext, nodeCount, 1, 1);
         }
 
-        // Update all internal nodes.
+        // Update the internal nodes.
         {
             auto var = mInternalUpdater->getRootVar()["CB"];
             mpLightCollection->setShaderData(var["gLights"]);
             setShaderData(var["gLightBVH"]);
-            var["gNodeIndices"] = mpNodeIndicesBuffer;
+            var["gNodeIndices"] = pNodeIndicesBuffer;
 
             // Note that mBVHStats.treeHeight may be 0, in which case there is a single leaf and no internal nodes.
+            // Levels can be empty for incremental refits, if none of the moved triangles is below them.
             for (int depth = (int)mBVHStats.treeHeight - 1; depth >= 0; --depth)
             {
-                const uint32_t nodeCount = mPerDepthRefitEntryInfo[depth].count;
-                FALCOR_ASSERT(nodeCount > 0);
-                var["gFirstNodeOffset"] = mPerDepthRefitEntryInfo[depth].offset;
+                const uint32_t nodeCount = perDepthRefitEntryInfo[depth].count;
+                if (nodeCount == 0) continue;
+                var["gFirstNodeOffset"] = perDepthRefitEntryInfo[depth].offset;
                 var["gNodeCount"] = nodeCount;
 
                 mInternalUpdater->execute(pRenderContext, nodeCount, 1, 1);
@@ -87,12 +144,18 @@ namespace Falcor
         }
 
         mIsCpuDataValid = false;
+        mStagingBufferValid = false;
     }
 
     void LightBVH::renderUI(Gui::Widgets& widget)
     {
         // Render the BVH stats.
         renderStats(widget, getStats());
+
+        const std::string refitStr =
+            "  Refit count:         " + std::to_string(mRefitStats.refitCount) + "\n" +
+            "  Last refit nodes:    " + std::to_string(mRefitStats.lastRefitNodeCount) + (mRefitStats.lastRefitWasFull ? " (full)" : "");
+        widget.text(refitStr);
     }
 
     void LightBVH::renderStats(Gui::Widgets& widget, const BVHStats& stats) const
@@ -137,8 +200,11 @@ namespace Falcor
         mPerDepthRefitEntryInfo.clear();
         mMaxTriangleCountPerLeaf = 0;
         mBVHStats = BVHStats();
+        mRefitStats = RefitStats();
+        mRefitPlanner.clear();
         mIsValid = false;
         mIsCpuDataValid = false;
+        mStagingBufferValid = false;
     }
 
     void LightBVH::traverseBVH(const NodeFunction& evalInternal, const NodeFunction& evalLeaf, uint32_t rootNodeIndex)
@@ -165,11 +231,12 @@ namespace Falcor
         }
     }
 
-    void LightBVH::finalize()
+    void LightBVH::finalize(const std::vector<uint32_t>& triangleIndices, uint32_t triangleCount)
     {
         // This function is called after BVH build has finished.
         computeStats();
         updateNodeIndices();
+        mRefitPlanner.setTree(mNodes, triangleIndices, triangleCount);
     }
 
     void LightBVH::computeStats()
@@ -303,16 +370,46 @@ namespace Falcor
         mIsCpuDataValid = true;
     }
 
+    void LightBVH::prepareSyncDataToCPU(RenderContext* pRenderContext) const
+    {
+        if (!mIsValid || mIsCpuDataValid || mStagingBufferValid) return;
+
+        const uint64_t stagingSize = mNodes.size() * sizeof(mNodes[0]);
+        if (!mpStagingBuffer || mpStagingBuffer->getSize() < stagingSize)
+        {
+            mpStagingBuffer = Buffer::create(mpDevice, stagingSize, Resource::BindFlags::None, Buffer::CpuAccess::Read);
+            mpStagingBuffer->setName("LightBVH::mpStagingBuffer");
+        }
+
+        pRenderContext->copyBufferRegion(mpStagingBuffer.get(), 0, mpBVHNodesBuffer.get(), 0, stagingSize);
+
+        // Submit command list and insert signal.
+        pRenderContext->flush(false);
+        mpStagingFence->gpuSignal(pRenderContext->getLowLevelData()->getCommandQueue());
+
+        mStagingBufferValid = true;
+    }
+
     void LightBVH::syncDataToCPU() const
     {
         if (!mIsValid || mIsCpuDataValid) return;
 
-        // TODO: This is slow because of the flush. We should copy to a staging buffer
-        // after the data is updated on the GPU and map the staging buffer here instead.
-        const void* const ptr = mpBVHNodesBuffer->map(Buffer::MapType::Read);
         FALCOR_ASSERT(mNodes.size() > 0 && mNodes.size() <= mpBVHNodesBuffer->getElementCount());
-        std::memcpy(mNodes.data(), ptr, mNodes.size() * sizeof(mNodes[0]));
-        mpBVHNodesBuffer->unmap();
+        if (mStagingBufferValid)
+        {
+            // Wait for the copy scheduled by prepareSyncDataToCPU() to finish.
+            mpStagingFence->syncCpu();
+            const void* const ptr = mpStagingBuffer->map(Buffer::MapType::Read);
+            std::memcpy(mNodes.data(), ptr, mNodes.size() * sizeof(mNodes[0]));
+            mpStagingBuffer->unmap();
+        }
+        else
+        {
+            // This is slow because of the flush. Call prepareSyncDataToCPU() ahead of time if possible.
+            const void* const ptr = mpBVHNodesBuffer->map(Buffer::MapType::Read);
+            std::memcpy(mNodes.data(), ptr, mNodes.size() * sizeof(mNodes[0]));
+            mpBVHNodesBuffer->unmap();
+        }
         mIsCpuDataValid = true;
     }
 
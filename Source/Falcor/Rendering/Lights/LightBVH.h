@@ -27,8 +27,10 @@
  **************************************************************************/
 #pragma once
 #include "LightBVHTypes.slang"
+#include "LightBVHRefitPlanner.h"
 #include "Core/Macros.h"
 #include "Core/API/Buffer.h"
+#include "Core/API/GpuFence.h"
 #include "Scene/Lights/LightCollection.h"
 #include "Utils/Math/AABB.h"
 #include "Utils/Math/Vector.h"
@@ -84,6 +86,21 @@ namespace Falcor
         */
         void refit(RenderContext* pRenderContext);
 
+        /** Refit the BVH nodes affected by a set of updated mesh lights, without changing the hierarchy.
+            Only the leaf nodes holding triangles of the updated lights and their ancestors are refit.
+            If a large part of the tree is affected, all nodes are refit instead.
+            The BVH needs to have been built before trying to refit it.
+            \param[in] pRenderContext The render context.
+            \param[in] updatedLights Indices of the mesh lights whose triangles have moved.
+        */
+        void refit(RenderContext* pRenderContext, const std::vector<uint32_t>& updatedLights);
+
+        /** Schedule a copy of the BVH nodes to the CPU.
+            Reading the nodes on the CPU later does not stall the GPU, as long as the BVH is not refit in between.
+            \param[in] pRenderContext The render context.
+        */
+        void prepareSyncDataToCPU(RenderContext* pRenderContext) const;
+
         /** Perform a depth-first traversal of the BVH and run a function on each node.
             \param[in] evalInternal Function called on each internal node.
             \param[in] evalLeaf Function called on each leaf node.
@@ -104,10 +121,21 @@ namespace Falcor
             uint32_t triangleCount = 0;                      ///< Number of triangles inside the BVH.
         };
 
+        struct RefitStats
+        {
+            uint32_t refitCount = 0;                         ///< Number of refits since the BVH was built.
+            uint32_t lastRefitNodeCount = 0;                 ///< Number of nodes updated by the last refit.
+            bool lastRefitWasFull = false;                   ///< True if the last refit updated all nodes.
+        };
+
         /** Returns stats.
         */
         const BVHStats& getStats() const { return mBVHStats; }
 
+        /** Returns refit stats.
+        */
+        const RefitStats& getRefitStats() const { return mRefitStats; }
+
         /** Is the BVH valid.
             \return true if the BVH is ready for use.
         */
@@ -123,9 +151,12 @@ namespace Falcor
         void setShaderData(const ShaderVar& var) const;
 
     protected:
-        void finalize();
+        using RefitEntryInfo = LightBVHRefitPlanner::RefitEntryInfo;
+
+        void finalize(const std::vector<uint32_t>& triangleIndices, uint32_t triangleCount);
         void computeStats();
         void updateNodeIndices();
+        void refitNodes(RenderContext* pRenderContext, const ref<Buffer>& pNodeIndicesBuffer, const std::vector<RefitEntryInfo>& perDepthRefitEntryInfo);
         void renderStats(Gui::Widgets& widget, const BVHStats& stats) const;
 
         void uploadCPUBuffers(const std::vector<uint32_t>& triangleIndices, const std::vector<uint64_t>& triangleBitmasks);
@@ -135,12 +166,6 @@ namespace Falcor
         */
         void clear();
 
-        struct RefitEntryInfo
-        {
-            uint32_t offset = 0;    ///< Offset into the 'mpNodeIndicesBuffer' buffer.
-            uint32_t count = 0;     ///< The number of nodes at each level.
-        };
-
         // Internal state
         ref<Device>                           mpDevice;
         ref<const LightCollection>            mpLightCollection;
@@ -154,14 +179,20 @@ namespace Falcor
         std::vector<RefitEntryInfo>           mPerDepthRefitEntryInfo;  ///< Array containing for each level the number of internal nodes as well as the corresponding offset into 'mpNodeIndicesBuffer'; the very last entry contains the same data, but for all leaf nodes instead.
         uint32_t                              mMaxTriangleCountPerLeaf = 0; ///< After the BVH is built, this contains the maximum light count per leaf node.
         BVHStats                              mBVHStats;
+        RefitStats                            mRefitStats;
+        LightBVHRefitPlanner                  mRefitPlanner;            ///< Finds the nodes affected by moving lights for incremental refits.
         bool                                  mIsValid = false;         ///< True when the BVH has been built.
         mutable bool                          mIsCpuDataValid = false;  ///< Indicates whether the CPU-side data matches the GPU buffers.
+        mutable bool                          mStagingBufferValid = false; ///< Indicates whether the staging buffer holds a copy of the current nodes.
 
         // GPU resources
         ref<Buffer>                           mpBVHNodesBuffer;         ///< Buffer holding all BVH nodes.
         ref<Buffer>                           mpTriangleIndicesBuffer;  ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
         ref<Buffer>                           mpTriangleBitmasksBuffer; ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child.
         ref<Buffer>                           mpNodeIndicesBuffer;      ///< Buffer holding all node indices sorted by tree depth. This is used for BVH refit.
+        ref<Buffer>                           mpRefitNodeIndicesBuffer; ///< Buffer holding the node indices of the current incremental refit, laid out as 'mpNodeIndicesBuffer'.
+        mutable ref<Buffer>                   mpStagingBuffer;          ///< Staging buffer used for reading back the BVH nodes.
+        ref<GpuFence>                         mpStagingFence;           ///< Fence used for waiting on the staging buffer being filled in.
 
         friend LightBVHBuilder;
     };
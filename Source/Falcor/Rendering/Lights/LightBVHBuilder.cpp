@@ -29,10 +29,12 @@
 #include "Core/Assert.h"
 #include "Core/Errors.h"
 #include "Utils/Logger.h"
+#include "Utils/Threading.h"
 #include "Utils/Timing/Profiler.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "Utils/Math/MathConstants.slangh"
 #include <algorithm>
+#include <exception>
 
 namespace
 {
@@ -46,6 +48,13 @@ namespace
     const uint32_t kMaxLeafTriangleCount = 1 << PackedNode::kTriangleCountBits;
     const uint32_t kMaxLeafTriangleOffset = 1 << PackedNode::kTriangleOffsetBits;
 
+    // Nodes with at least this many triangles build their right subtree as a separate task.
+    const uint32_t kMinParallelBuildTriangleCount = 1 << 12;
+
+    // Nodes with at least this many triangles bin their triangles in parallel.
+    const uint32_t kMinParallelBinningTriangleCount = 1 << 16;
+    const uint32_t kBinningChunkSize = 1 << 14;
+
     inline float safeACos(float v)
     {
         return std::acos(std::clamp(v, -1.0f, 1.0f));
@@ -218,6 +227,106 @@ namespace
         return dims.x * dims.y * dims.z;
     }
 
+    /** Fill bins with the triangles in a range.
+        The Bin type aggregates triangles with operator|=. After a bin is filled, initCone() is called on it
+        followed by growCone() for each of its triangles.
+        Each bin visits its triangles in their order in the range, so the result is identical whether the binning runs
+        serially or in parallel. Large ranges are sorted by bin with a stable counting sort, after which the bins are
+        filled in parallel.
+        \param[in] triangles Triangle data.
+        \param[in] begin First triangle in the range.
+        \param[in] end One past the last triangle in the range.
+        \param[in] getBinId Function returning the bin index of a triangle.
+        \param[in,out] bins Bins to fill. They are reset before filling.
+        \param[in] parallel Allow filling the bins in parallel.
+    */
+    template<typename Bin, typename GetBinId>
+    void fillBins(const LightBVHBuilder::TriangleSortData* triangles, uint32_t begin, uint32_t end, const GetBinId& getBinId, std::vector<Bin>& bins, bool parallel)
+    {
+        for (Bin& bin : bins) bin = Bin();
+
+        const uint32_t triangleCount = end - begin;
+        if (!parallel || triangleCount < kMinParallelBinningTriangleCount)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                bins[getBinId(triangles[i])] |= triangles[i];
+            }
+            for (Bin& bin : bins) bin.initCone();
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                bins[getBinId(triangles[i])].growCone(triangles[i]);
+            }
+            return;
+        }
+
+        const uint32_t binCount = (uint32_t)bins.size();
+        const uint32_t chunkCount = std::min((Threading::getThreadCount() + 1) * 4, (triangleCount + kBinningChunkSize - 1) / kBinningChunkSize);
+        auto getChunkRange = [&](uint32_t chunk)
+        {
+            return std::make_pair(uint32_t(uint64_t(triangleCount) * chunk / chunkCount), uint32_t(uint64_t(triangleCount) * (chunk + 1) / chunkCount));
+        };
+
+        // Compute the bin indices and a histogram per chunk.
+        std::vector<uint32_t> binIds(triangleCount);
+        std::vector<uint32_t> chunkOffsets(size_t(chunkCount) * binCount, 0);
+        Threading::parallelFor(0, chunkCount, [&](size_t chunk)
+        {
+            auto [chunkBegin, chunkEnd] = getChunkRange((uint32_t)chunk);
+            uint32_t* histogram = chunkOffsets.data() + chunk * binCount;
+            for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                uint32_t binId = getBinId(triangles[begin + i]);
+                binIds[i] = binId;
+                histogram[binId]++;
+            }
+        });
+
+        // Turn the histograms into output offsets. Chunks are laid out in order within each bin to keep the sort stable.
+        std::vector<uint32_t> binOffsets(binCount + 1);
+        uint32_t offset = 0;
+        for (uint32_t binId = 0; binId < binCount; ++binId)
+        {
+            binOffsets[binId] = offset;
+            for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                uint32_t& chunkOffset = chunkOffsets[size_t(chunk) * binCount + binId];
+                uint32_t count = chunkOffset;
+                chunkOffset = offset;
+                offset += count;
+            }
+        }
+        binOffsets[binCount] = offset;
+        FALCOR_ASSERT(offset == triangleCount);
+
+        // Sort the triangles by bin.
+        std::vector<uint32_t> sortedTriangles(triangleCount);
+        Threading::parallelFor(0, chunkCount, [&](size_t chunk)
+        {
+            auto [chunkBegin, chunkEnd] = getChunkRange((uint32_t)chunk);
+            uint32_t* offsets = chunkOffsets.data() + chunk * binCount;
+            for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                sortedTriangles[offsets[binIds[i]]++] = begin + i;
+            }
+        });
+
+        // Fill the bins.
+        Threading::parallelFor(0, binCount, [&](size_t binId)
+        {
+            Bin& bin = bins[binId];
+            for (uint32_t i = binOffsets[binId]; i < binOffsets[binId + 1]; ++i)
+            {
+                bin |= triangles[sortedTriangles[i]];
+            }
+            bin.initCone();
+            for (uint32_t i = binOffsets[binId]; i < binOffsets[binId + 1]; ++i)
+            {
+                bin.growCone(triangles[sortedTriangles[i]]);
+            }
+        });
+    }
+
     const Gui::DropdownList kSplitHeuristicList =
     {
         { (uint32_t)LightBVHBuilder::SplitHeuristic::Equal, "Equal" },
@@ -247,9 +356,19 @@ namespace Falcor
         if (triangles.empty()) return;
 
         // Create list of triangles that should be included in BVH.
+        std::vector<TriangleSortData> trianglesData = prepareTriangles(triangles);
+
+        // If there are no non-culled triangles, we're done.
+        if (trianglesData.empty()) return;
+
+        upload(bvh, buildNodes(trianglesData, static_cast<uint32_t>(triangles.size())));
+    }
+
+    std::vector<LightBVHBuilder::TriangleSortData> LightBVHBuilder::prepareTriangles(const std::vector<LightCollection::MeshLightTriangle>& triangles) const
+    {
         // For each triangle, precompute data we need for the build.
-        BuildingData data(bvh.mNodes);
-        data.trianglesData.reserve(triangles.size());
+        std::vector<TriangleSortData> trianglesData;
+        trianglesData.reserve(triangles.size());
 
         for (size_t i = 0; i < triangles.size(); i++)
         {
@@ -266,55 +385,87 @@ namespace Falcor
                 tri.flux = triangles[i].flux;
                 tri.triangleIndex = static_cast<uint32_t>(i);
 
-                data.trianglesData.push_back(tri);
+                trianglesData.push_back(tri);
             }
         }
 
-        // If there are no non-culled triangles, we're done.
-        if (data.trianglesData.empty()) return;
+        return trianglesData;
+    }
+
+    void LightBVHBuilder::upload(LightBVH& bvh, BuildResult&& result) const
+    {
+        bvh.clear();
+        if (result.nodes.empty()) return;
+
+        // The BVH is ready, mark it as valid and upload the data.
+        bvh.mNodes = std::move(result.nodes);
+        bvh.mIsValid = true;
+        bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
+        bvh.uploadCPUBuffers(result.triangleIndices, result.triangleBitmasks);
+
+        // Computate metadata.
+        bvh.finalize(result.triangleIndices, static_cast<uint32_t>(result.triangleBitmasks.size()));
+    }
+
+    LightBVHBuilder::BuildResult LightBVHBuilder::buildNodes(fstd::span<const TriangleSortData> triangles, uint32_t triangleCount, bool parallel) const
+    {
+        BuildResult result;
+        if (triangles.empty()) return result;
 
         // Validate options.
         if (mOptions.maxTriangleCountPerLeaf > kMaxLeafTriangleCount)
         {
             throw RuntimeError("Max triangle count per leaf exceeds the maximum supported ({})", kMaxLeafTriangleCount);
         }
-        if (data.trianglesData.size() > kMaxLeafTriangleOffset + kMaxLeafTriangleCount)
+        if (triangles.size() > kMaxLeafTriangleOffset + kMaxLeafTriangleCount)
         {
             throw RuntimeError("Emissive triangle count exceeds the maximum supported ({})", kMaxLeafTriangleOffset + kMaxLeafTriangleCount);
         }
 
+        BuildingData data;
+        data.parallel = parallel;
+        data.trianglesData.assign(triangles.begin(), triangles.end());
+
         // Allocate temporary memory for the BVH build.
         // To be grossly conservative, assume each triangle requires two nodes.
         // This is only system RAM and shouldn't be that much, so it's not worth being more careful about it.
         // TODO: Better estimate of how many nodes we will need.
-        data.nodes.clear();
-        data.nodes.reserve(2 * data.trianglesData.size());
-        data.triangleIndices.reserve(data.trianglesData.size());
+        result.nodes.reserve(2 * data.trianglesData.size());
+
+        // Leaf nodes are created in the order of their triangle ranges, so each leaf writes its triangle indices at the start of its range.
+        data.triangleIndices.resize(data.trianglesData.size());
 
         const uint64_t invalidBitmask = std::numeric_limits<uint64_t>::max();
-        data.triangleBitmasks.resize(triangles.size(), invalidBitmask); // This is sized based on input triangle count, as it's indexed by global triangle index.
+        data.triangleBitmasks.resize(triangleCount, invalidBitmask); // This is sized based on input triangle count, as it's indexed by global triangle index.
 
-        // Build the tree.
-        SplitHeuristicFunction splitFunc = getSplitFunction(mOptions.splitHeuristicSelection);
-        buildInternal(mOptions, splitFunc, 0ull, 0, Range(0, static_cast<uint32_t>(data.trianglesData.size())), data);
-        FALCOR_ASSERT(!data.nodes.empty());
+        // Build the tree. The lighting cones are computed bottom-up while building.
+        const Range rootRange(0, static_cast<uint32_t>(data.trianglesData.size()));
+        float3 coneDirection;
+        float cosConeAngle;
+        switch (mOptions.splitHeuristicSelection)
+        {
+        case SplitHeuristic::Equal:
+            buildInternal<SplitHeuristic::Equal>(mOptions, 0ull, 0, rootRange, data, result.nodes, coneDirection, cosConeAngle);
+            break;
+        case SplitHeuristic::BinnedSAH:
+            buildInternal<SplitHeuristic::BinnedSAH>(mOptions, 0ull, 0, rootRange, data, result.nodes, coneDirection, cosConeAngle);
+            break;
+        case SplitHeuristic::BinnedSAOH:
+            buildInternal<SplitHeuristic::BinnedSAOH>(mOptions, 0ull, 0, rootRange, data, result.nodes, coneDirection, cosConeAngle);
+            break;
+        default:
+            throw RuntimeError("Unsupported SplitHeuristic: {}", static_cast<uint32_t>(mOptions.splitHeuristicSelection));
+        }
+        FALCOR_ASSERT(!result.nodes.empty());
 
         size_t numValid = 0;
         for (auto mask : data.triangleBitmasks)
             if (mask != invalidBitmask) numValid++;
         FALCOR_ASSERT(numValid == data.trianglesData.size());
 
-        // Compute per-node light bounding cones.
-        float cosConeAngle;
-        computeLightingConesInternal(0, data, cosConeAngle);
-
-        // The BVH is ready, mark it as valid and upload the data.
-        bvh.mIsValid = true;
-        bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
-        bvh.uploadCPUBuffers(data.triangleIndices, data.triangleBitmasks);
-
-        // Computate metadata.
-        bvh.finalize();
+        result.triangleIndices = std::move(data.triangleIndices);
+        result.triangleBitmasks = std::move(data.triangleBitmasks);
+        return result;
     }
 
     bool LightBVHBuilder::renderUI(Gui::Widgets& widget)
@@ -358,7 +509,8 @@ namespace Falcor
         return optionsChanged;
     }
 
-    uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data)
+    template<LightBVHBuilder::SplitHeuristic kSplitHeuristic>
+    uint32_t LightBVHBuilder::buildInternal(const Options& options, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data, std::vector<PackedNode>& nodes, float3& coneDirection, float& cosConeAngle) const
     {
         FALCOR_ASSERT(triangleRange.begin < triangleRange.end);
 
@@ -372,10 +524,8 @@ namespace Falcor
         }
         FALCOR_ASSERT(nodeBounds.valid());
 
-        data.currentNodeFlux = nodeFlux;
-
         bool trySplitting = triangleRange.length() > (options.createLeavesASAP ? options.maxTriangleCountPerLeaf : 1);
-        const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, options) : SplitResult();
+        const SplitResult splitResult = trySplitting ? computeSplit<kSplitHeuristic>(data, triangleRange, nodeBounds, nodeFlux, options) : SplitResult();
 
         // If we should split, then create an internal node and split.
         if (splitResult.isValid())
@@ -387,14 +537,13 @@ namespace Falcor
             std::nth_element(std::begin(data.trianglesData) + triangleRange.begin, std::begin(data.trianglesData) + splitResult.triangleIndex, std::begin(data.trianglesData) + triangleRange.end, comp);
 
             // Allocate internal node.
-            FALCOR_ASSERT(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
+            FALCOR_ASSERT(nodes.size() < std::numeric_limits<uint32_t>::max());
+            const uint32_t nodeIndex = (uint32_t)nodes.size();
+            nodes.push_back({});
 
             InternalNode node = {};
             node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
             node.attribs.flux = nodeFlux;
-            // The lighting normal bounding cone will be computed later when all leaf nodes have been created.
 
             if (depth >= kMaxBVHDepth)
             {
@@ -403,13 +552,60 @@ namespace Falcor
                 throw RuntimeError("BVH depth of {} reached. Maximum of {} allowed.", depth + 1, kMaxBVHDepth);
             }
 
-            uint32_t leftIndex = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, Range(triangleRange.begin, splitResult.triangleIndex), data);
-            uint32_t rightIndex = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, Range(splitResult.triangleIndex, triangleRange.end), data);
+            const Range leftRange(triangleRange.begin, splitResult.triangleIndex);
+            const Range rightRange(splitResult.triangleIndex, triangleRange.end);
+            float3 leftConeDirection, rightConeDirection;
+            float leftCosConeAngle = kInvalidCosConeAngle, rightCosConeAngle = kInvalidCosConeAngle;
+            uint32_t leftIndex, rightIndex;
+
+            if (data.parallel && triangleRange.length() >= kMinParallelBuildTriangleCount)
+            {
+                // Build the right subtree as a separate task. Its nodes are appended after the left subtree once both are done,
+                // which results in the same node order as a serial build.
+                std::vector<PackedNode> rightNodes;
+                auto rightTask = Threading::dispatchTask([&]()
+                {
+                    buildInternal<kSplitHeuristic>(options, bitmask | (1ull << depth), depth + 1, rightRange, data, rightNodes, rightConeDirection, rightCosConeAngle);
+                });
+                // The right task references local state, so wait for it before propagating errors from the left subtree.
+                std::exception_ptr pLeftException;
+                try
+                {
+                    leftIndex = buildInternal<kSplitHeuristic>(options, bitmask | (0ull << depth), depth + 1, leftRange, data, nodes, leftConeDirection, leftCosConeAngle);
+                }
+                catch (...)
+                {
+                    pLeftException = std::current_exception();
+                }
+                rightTask.finish();
+                if (pLeftException) std::rethrow_exception(pLeftException);
+
+                FALCOR_ASSERT(nodes.size() + rightNodes.size() < std::numeric_limits<uint32_t>::max());
+                rightIndex = (uint32_t)nodes.size();
+                for (PackedNode& rightNode : rightNodes)
+                {
+                    // Offset the right child index in place. Unpacking and repacking the node would requantize its attributes.
+                    if (!rightNode.isLeaf()) rightNode.data[0].x += rightIndex;
+                }
+                nodes.insert(nodes.end(), rightNodes.begin(), rightNodes.end());
+            }
+            else
+            {
+                leftIndex = buildInternal<kSplitHeuristic>(options, bitmask | (0ull << depth), depth + 1, leftRange, data, nodes, leftConeDirection, leftCosConeAngle);
+                rightIndex = buildInternal<kSplitHeuristic>(options, bitmask | (1ull << depth), depth + 1, rightRange, data, nodes, rightConeDirection, rightCosConeAngle);
+            }
 
             FALCOR_ASSERT(leftIndex == nodeIndex + 1); // The left node should always be placed immediately after the current node.
             node.rightChildIdx = rightIndex;
 
-            data.nodes[nodeIndex].setInternalNode(node);
+            // TODO: Asserts in coneUnion
+            //coneDirection = coneUnion(leftConeDirection, leftCosConeAngle,
+            coneDirection = coneUnionOld(leftConeDirection, leftCosConeAngle,
+                rightConeDirection, rightCosConeAngle, cosConeAngle);
+            node.attribs.coneDirection = coneDirection;
+            node.attribs.cosConeAngle = cosConeAngle;
+
+            nodes[nodeIndex].setInternalNode(node);
             return nodeIndex;
         }
         else // No split => create leaf node
@@ -417,9 +613,9 @@ namespace Falcor
             FALCOR_ASSERT(triangleRange.length() <= options.maxTriangleCountPerLeaf);
 
             // Allocate leaf node.
-            FALCOR_ASSERT(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
+            FALCOR_ASSERT(nodes.size() < std::numeric_limits<uint32_t>::max());
+            const uint32_t nodeIndex = (uint32_t)nodes.size();
+            nodes.push_back({});
 
             LeafNode node = {};
             node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
@@ -429,55 +625,24 @@ namespace Falcor
             node.attribs.cosConeAngle = cosTheta;
 
             node.triangleCount = triangleRange.length();
-            node.triangleOffset = (uint32_t)data.triangleIndices.size();
+            node.triangleOffset = triangleRange.begin;
             FALCOR_ASSERT(node.triangleCount < kMaxLeafTriangleCount);
             FALCOR_ASSERT(node.triangleOffset < kMaxLeafTriangleOffset);
 
-            for (uint32_t triangleIdx = triangleRange.begin, index = 0; triangleIdx < triangleRange.end; ++triangleIdx, ++index)
+            for (uint32_t triangleIdx = triangleRange.begin; triangleIdx < triangleRange.end; ++triangleIdx)
             {
                 uint32_t globalTriangleIndex = data.trianglesData[triangleIdx].triangleIndex;
-                data.triangleIndices.push_back(globalTriangleIndex);
+                data.triangleIndices[triangleIdx] = globalTriangleIndex;
                 data.triangleBitmasks[globalTriangleIndex] = bitmask;
             }
-            FALCOR_ASSERT(data.triangleIndices.size() == node.triangleOffset + node.triangleCount);
 
-            data.nodes[nodeIndex].setLeafNode(node);
-            return nodeIndex;
-        }
-    }
-
-    float3 LightBVHBuilder::computeLightingConesInternal(const uint32_t nodeIndex, BuildingData& data, float& cosConeAngle)
-    {
-        if (!data.nodes[nodeIndex].isLeaf())
-        {
-            auto node = data.nodes[nodeIndex].getInternalNode();
-
-            uint32_t leftIndex = nodeIndex + 1;
-            uint32_t rightIndex = node.rightChildIdx;
-
-            float leftNodeCosConeAngle = kInvalidCosConeAngle;
-            float3 leftNodeConeDirection = computeLightingConesInternal(leftIndex, data, leftNodeCosConeAngle);
-            float rightNodeCosConeAngle = kInvalidCosConeAngle;
-            float3 rightNodeConeDirection = computeLightingConesInternal(rightIndex, data, rightNodeCosConeAngle);
-
-            // TODO: Asserts in coneUnion
-            //float3 coneDirection = coneUnion(leftNodeConeDirection, leftNodeCosConeAngle,
-            float3 coneDirection = coneUnionOld(leftNodeConeDirection, leftNodeCosConeAngle,
-                rightNodeConeDirection, rightNodeCosConeAngle, cosConeAngle);
-
-            // Update bounding cone.
-            node.attribs.cosConeAngle = cosConeAngle;
-            node.attribs.coneDirection = coneDirection;
-            data.nodes[nodeIndex].setNodeAttributes(node.attribs);
+            nodes[nodeIndex].setLeafNode(node);
 
-            return coneDirection;
-        }
-        else
-        {
-            // Load bounding cone.
-            auto attribs = data.nodes[nodeIndex].getNodeAttributes();
+            // The parent cones are computed from the stored (quantized) leaf cones.
+            const SharedNodeAttributes attribs = nodes[nodeIndex].getNodeAttributes();
+            coneDirection = attribs.coneDirection;
             cosConeAngle = attribs.cosConeAngle;
-            return attribs.coneDirection;
+            return nodeIndex;
         }
     }
 
@@ -506,7 +671,20 @@ namespace Falcor
         return coneDirection;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/)
+    template<LightBVHBuilder::SplitHeuristic kSplitHeuristic>
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplit(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters)
+    {
+        if constexpr (kSplitHeuristic == SplitHeuristic::Equal)
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, nodeFlux, parameters);
+        else if constexpr (kSplitHeuristic == SplitHeuristic::BinnedSAH)
+            return computeSplitWithBinnedSAH(data, triangleRange, nodeBounds, nodeFlux, parameters);
+        else if constexpr (kSplitHeuristic == SplitHeuristic::BinnedSAOH)
+            return computeSplitWithBinnedSAOH(data, triangleRange, nodeBounds, nodeFlux, parameters);
+        else
+            FALCOR_UNREACHABLE();
+    }
+
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, float /*nodeFlux*/, const Options& /*parameters*/)
     {
         // Find the largest dimension.
         float3 dimensions = nodeBounds.extent();
@@ -533,7 +711,7 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         FALCOR_ASSERT(!overallBestSplit.second.isValid());
@@ -551,6 +729,9 @@ namespace Falcor
                 triangleCount += rhs.triangleCount;
                 return *this;
             }
+            // The SAH does not use lighting cones.
+            void initCone() {}
+            void growCone(const TriangleSortData& /*tri*/) {}
         };
 
         FALCOR_ASSERT(parameters.binCount > 1);
@@ -574,15 +755,8 @@ namespace Falcor
                 return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
             };
 
-            // Reset the bins.
-            for (Bin& bin : bins) bin = Bin();
-
             // Fill the bins with all triangles.
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-            {
-                const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
-            }
+            fillBins(data.trianglesData.data(), triangleRange.begin, triangleRange.end, getBinId, bins, data.parallel);
 
             // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
             // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
@@ -646,7 +820,7 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, nodeFlux, parameters);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
@@ -688,7 +862,7 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         FALCOR_ASSERT(!overallBestSplit.second.isValid());
@@ -717,6 +891,20 @@ namespace Falcor
                 // Note: cosConeAngle should be computed separately after the final cone direction is known
                 return *this;
             }
+
+            // Compute the lighting cone for the bin.
+            // The cone direction is the average direction over all lights in the bin and the cone angle is grown to include all.
+            // If the vector is zero length (no lights or if all directions cancelled out), the cone is marked as invalid.
+            // TODO: Switch to a more sophisticated algorithm to get narrower cones.
+            void initCone()
+            {
+                cosConeAngle = length(coneDirection) < FLT_MIN ? kInvalidCosConeAngle : 1.0f;
+                coneDirection = normalize(coneDirection);
+            }
+            void growCone(const TriangleSortData& tri)
+            {
+                cosConeAngle = computeCosConeAngle(coneDirection, cosConeAngle, tri.coneDirection, tri.cosConeAngle);
+            }
         };
 
         FALCOR_ASSERT(parameters.binCount > 1);
@@ -744,31 +932,8 @@ namespace Falcor
                 return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
             };
 
-            // Reset the bins.
-            for (Bin& bin : bins) bin = Bin();
-
-            // Fill the bins with all triangles.
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-            {
-                const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
-            }
-
-            // Compute the lighting cones for each bin.
-            // The cone direction is the average direction over all lights in the bin and the cone angle is grown to include all.
-            // If the vector is zero length (no lights or if all directions cancelled out), the cone is marked as invalid.
-            // TODO: Switch to a more sophisticated algorithm to get narrower cones.
-            for (Bin& bin : bins)
-            {
-                bin.cosConeAngle = length(bin.coneDirection) < FLT_MIN ? kInvalidCosConeAngle : 1.0f;
-                bin.coneDirection = normalize(bin.coneDirection);
-            }
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-            {
-                const auto& td = data.trianglesData[i];
-                Bin& bin = bins[getBinId(td)];
-                bin.cosConeAngle = computeCosConeAngle(bin.coneDirection, bin.cosConeAngle, td.coneDirection, td.cosConeAngle);
-            }
+            // Fill the bins with all triangles and compute the lighting cones for each bin.
+            fillBins(data.trianglesData.data(), triangleRange.begin, triangleRange.end, getBinId, bins, data.parallel);
 
             // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
             // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
@@ -857,7 +1022,7 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAOH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, nodeFlux, parameters);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
@@ -867,26 +1032,38 @@ namespace Falcor
             // Evaluate the cost metric for the node. This requires us to first compute the cone angle.
             float cosTheta = kInvalidCosConeAngle;
             computeLightingCone(triangleRange, data, cosTheta);
-            float leafCost = evalSAOH(nodeBounds, data.currentNodeFlux, cosTheta, parameters);
+            float leafCost = evalSAOH(nodeBounds, nodeFlux, cosTheta, parameters);
             if (leafCost <= overallBestSplit.first) return SplitResult();
         }
 
         return overallBestSplit.second;
     }
 
-    LightBVHBuilder::SplitHeuristicFunction LightBVHBuilder::getSplitFunction(SplitHeuristic heuristic)
+    float LightBVHBuilder::evalCost(fstd::span<const PackedNode> nodes) const
     {
-        switch (heuristic)
+        if (nodes.empty()) return 0.f;
+
+        auto evalNode = [this](const PackedNode& node)
         {
-        case SplitHeuristic::Equal:
-            return computeSplitWithEqual;
-        case SplitHeuristic::BinnedSAH:
-            return computeSplitWithBinnedSAH;
-        case SplitHeuristic::BinnedSAOH:
-            return computeSplitWithBinnedSAOH;
-        default:
-            throw RuntimeError("Unsupported SplitHeuristic: {}", static_cast<uint32_t>(heuristic));
-        }
+            SharedNodeAttributes attribs = node.getNodeAttributes();
+            float3 aabbMin, aabbMax;
+            attribs.getAABB(aabbMin, aabbMax);
+            return evalSAOH(AABB(aabbMin, aabbMax), attribs.flux, attribs.cosConeAngle, mOptions);
+        };
+
+        const float rootCost = evalNode(nodes[0]);
+        if (rootCost <= 0.f) return 0.f;
+
+        double cost = 0.0;
+        for (const PackedNode& node : nodes) cost += evalNode(node);
+        return static_cast<float>(cost / rootCost);
+    }
+
+    float LightBVHBuilder::evalCost(const LightBVH& bvh) const
+    {
+        if (!bvh.isValid()) return 0.f;
+        bvh.syncDataToCPU();
+        return evalCost(bvh.mNodes);
     }
 
     FALCOR_SCRIPT_BINDING(LightBVHBuilder)
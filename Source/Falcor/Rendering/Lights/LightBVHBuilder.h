@@ -31,7 +31,7 @@
 #include "Utils/Math/AABB.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/UI/Gui.h"
-#include <functional>
+#include <fstd/span.h> // TODO C++20: Replace with <span>
 #include <limits>
 #include <memory>
 #include <vector>
@@ -78,11 +78,72 @@ namespace Falcor
         */
         LightBVHBuilder(const Options& options);
 
+        /** Per-light data used for building the BVH.
+        */
+        struct TriangleSortData
+        {
+            AABB bounds;                                    ///< World-space bounding box for the light source(s).
+            float3 center = {};                             ///< Center point.
+            float3 coneDirection = {};                      ///< Light emission normal direction.
+            float cosConeAngle = 1.f;                       ///< Cosine normal bounding cone (half) angle.
+            float flux = 0.f;                               ///< Precomputed triangle flux (note, this takes doublesidedness into account).
+            uint32_t triangleIndex = MeshLightData::kInvalidIndex; ///< Index into global triangle list.
+        };
+
+        /** BVH data generated by buildNodes().
+        */
+        struct BuildResult
+        {
+            std::vector<PackedNode> nodes;                  ///< BVH nodes in depth-first order. The left child of an internal node is stored immediately after it.
+            std::vector<uint32_t> triangleIndices;          ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
+            std::vector<uint64_t> triangleBitmasks;         ///< Per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child. Indexed by global triangle index.
+        };
+
         /** Build the BVH.
             \param[in,out] bvh The light BVH to build.
         */
         void build(RenderContext* pRenderContext, LightBVH& bvh);
 
+        /** Build the BVH nodes for a list of lights.
+            This runs entirely on the CPU and does not need a GPU device. Large subtrees are built in parallel on the
+            thread pool, but the result is identical to a serial build.
+            Lights are not culled here. When pre-integration is enabled, lights with zero flux should be removed by the caller.
+            \param[in] triangles Lights to include in the BVH.
+            \param[in] triangleCount Total number of lights. All global triangle indices must be smaller than this.
+            \param[in] parallel Build large subtrees and bin large nodes on the thread pool. The serial build is the reference
+                        the parallel build is tested against.
+            \return The generated BVH data. The result is empty if there are no lights.
+        */
+        BuildResult buildNodes(fstd::span<const TriangleSortData> triangles, uint32_t triangleCount, bool parallel = true) const;
+
+        /** Prepare the build data for a list of emissive triangles.
+            Triangles with zero flux are culled if pre-integration is enabled.
+            \param[in] triangles Global list of emissive triangles.
+            \return List of lights to pass to buildNodes().
+        */
+        std::vector<TriangleSortData> prepareTriangles(const std::vector<LightCollection::MeshLightTriangle>& triangles) const;
+
+        /** Replace the contents of a light BVH by BVH data generated by buildNodes().
+            \param[in,out] bvh The light BVH to update.
+            \param[in] result The BVH data. If the result is empty, the BVH is left invalid.
+        */
+        void upload(LightBVH& bvh, BuildResult&& result) const;
+
+        /** Estimate the quality of a BVH with the SAOH cost metric.
+            The cost is the sum of the SAOH costs of all nodes relative to the cost of the root node. Lower is better.
+            Refitting a BVH to moving lights increases the cost, which can be used to decide when to rebuild it.
+            \param[in] nodes BVH nodes in depth-first order.
+            \return The cost, or zero if there are no nodes.
+        */
+        float evalCost(fstd::span<const PackedNode> nodes) const;
+
+        /** Estimate the quality of a BVH with the SAOH cost metric.
+            This reads back the BVH nodes from the GPU.
+            \param[in] bvh The light BVH.
+            \return The cost, or zero if the BVH is not valid.
+        */
+        float evalCost(const LightBVH& bvh) const;
+
         bool renderUI(Gui::Widgets& widget);
 
         const Options& getOptions() const { return mOptions; }
@@ -110,56 +171,35 @@ namespace Falcor
             }
         };
 
-        struct TriangleSortData
-        {
-            AABB bounds;                                    ///< World-space bounding box for the light source(s).
-            float3 center = {};                             ///< Center point.
-            float3 coneDirection = {};                      ///< Light emission normal direction.
-            float cosConeAngle = 1.f;                       ///< Cosine normal bounding cone (half) angle.
-            float flux = 0.f;                               ///< Precomputed triangle flux (note, this takes doublesidedness into account).
-            uint32_t triangleIndex = MeshLightData::kInvalidIndex; ///< Index into global triangle list.
-        };
-
+        /** Data shared by all subtrees during the build.
+            Subtrees built in parallel only access the parts of the arrays that belong to their triangle range.
+        */
         struct BuildingData
         {
-            std::vector<PackedNode>& nodes;                 ///< BVH nodes generated by the builder.
             std::vector<TriangleSortData> trianglesData;    ///< Compact list of triangles to include in build.
             std::vector<uint32_t> triangleIndices;          ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
             std::vector<uint64_t> triangleBitmasks;         ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child; this array gets filled in during the build process. Indexed by global triangle index.
-            float currentNodeFlux = 0.f;                    ///< Used by computeSAOHSplit() as the leaf creation cost.
-
-            BuildingData(std::vector<PackedNode>& bvhNodes) : nodes(bvhNodes) {}
+            bool parallel = true;                           ///< Build large subtrees and bin large nodes on the thread pool.
         };
 
-        /** Compute the split according to a specified heuristic.
-            \param[in] data Prepared light data.
-            \param[in] triangleRange Range of triangles to process.
-            \param[in] nodeBounds Bounds for the node to be splitted.
-            \param[in] parameters Various parameters defining how the building should occur.
-        */
-        using SplitHeuristicFunction = std::function<SplitResult(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)>;
-
         /** Renders the UI with builder options.
         */
         bool renderOptions(Gui::Widgets& widget, Options& options) const;
 
         /** Recursive BVH build.
-            \param[in] splitHeuristic The splitting heuristic to be used.
+            Nodes are appended to the given node list, with node indices relative to the start of the list.
+            Subtrees with many triangles build their right child as a separate task into a temporary list, which is appended once done.
             \param[in] bitmask Bit pattern retracing the tree traversal to reach the node to be built: 0=left child, 1=right child.
             \param[in] depth Depth of the node to be built
             \param[in] triangleRange Range of triangles to process.
             \param[in,out] data Prepared light data.
+            \param[in,out] nodes Node list to append the nodes of the subtree to.
+            \param[out] coneDirection Direction of the lighting cone for the node.
+            \param[out] cosConeAngle Cosine of the cone angle of the lighting cone for the node, or kInvalidCosConeAngle if the cone is invalid.
             \return Index of the allocated node.
         */
-        uint32_t buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data);
-
-        /** Recursive computation of lighting cones for all internal nodes.
-            \param[in] nodeIndex Index of the current node.
-            \param[in,out] data Updated node data.
-            \param[out] cosConeAngle Cosine of the cone angle of the lighting cone for the current node, or kInvalidCosConeAngle if the cone is invalid.
-            \return direction of the lighting cone for the current node.
-        */
-        float3 computeLightingConesInternal(const uint32_t nodeIndex, BuildingData& data, float& cosConeAngle);
+        template<SplitHeuristic kSplitHeuristic>
+        uint32_t buildInternal(const Options& options, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data, std::vector<PackedNode>& nodes, float3& coneDirection, float& cosConeAngle) const;
 
         /** Compute lighting cone for a range of triangles.
             \param[in] triangleRange Range of triangles to process.
@@ -169,12 +209,20 @@ namespace Falcor
         */
         static float3 computeLightingCone(const Range& triangleRange, const BuildingData& data, float& cosTheta);
 
-        // See the documentation of SplitHeuristicFunction.
-        static SplitResult computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/);
-        static SplitResult computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters);
-        static SplitResult computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters);
+        /** Compute the split according to a specified heuristic.
+            \param[in] data Prepared light data.
+            \param[in] triangleRange Range of triangles to process.
+            \param[in] nodeBounds Bounds for the node to be splitted.
+            \param[in] nodeFlux Total flux of the node, used as the leaf creation cost.
+            \param[in] parameters Various parameters defining how the building should occur.
+        */
+        template<SplitHeuristic kSplitHeuristic>
+        static SplitResult computeSplit(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters);
 
-        static SplitHeuristicFunction getSplitFunction(SplitHeuristic heuristic);
+        // See the documentation of computeSplit().
+        static SplitResult computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, float /*nodeFlux*/, const Options& /*parameters*/);
+        static SplitResult computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters);
+        static SplitResult computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters);
 
         // Configuration
         Options mOptions;
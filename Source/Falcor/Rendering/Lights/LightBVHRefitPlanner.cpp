@@ -0,0 +1,145 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "LightBVHRefitPlanner.h"
+#include "Core/Assert.h"
+#include "Core/Errors.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    void LightBVHRefitPlanner::setTree(fstd::span<const PackedNode> nodes, fstd::span<const uint32_t> triangleIndices, uint32_t triangleCount)
+    {
+        clear();
+        if (nodes.empty()) return;
+
+        const uint32_t nodeCount = (uint32_t)nodes.size();
+        mParents.assign(nodeCount, kInvalidIndex);
+        mDepths.assign(nodeCount, 0);
+        mTriangleLeaves.assign(triangleCount, kInvalidIndex);
+        mMarks.assign(nodeCount, 0);
+
+        // Nodes are stored in depth-first order, so each node is visited after its parent.
+        for (uint32_t nodeIndex = 0; nodeIndex < nodeCount; ++nodeIndex)
+        {
+            const PackedNode& node = nodes[nodeIndex];
+            const uint32_t depth = mDepths[nodeIndex];
+
+            if (node.isLeaf())
+            {
+                const LeafNode leaf = node.getLeafNode();
+                FALCOR_CHECK_ARG_LE(leaf.triangleOffset + leaf.triangleCount, triangleIndices.size());
+                for (uint32_t i = leaf.triangleOffset; i < leaf.triangleOffset + leaf.triangleCount; ++i)
+                {
+                    FALCOR_CHECK_ARG_LT(triangleIndices[i], triangleCount);
+                    mTriangleLeaves[triangleIndices[i]] = nodeIndex;
+                }
+                mTreeHeight = std::max(mTreeHeight, depth);
+            }
+            else
+            {
+                const uint32_t children[2] = { nodeIndex + 1, node.getInternalNode().rightChildIdx };
+                for (uint32_t childIndex : children)
+                {
+                    FALCOR_CHECK_ARG_MSG(childIndex > nodeIndex && childIndex < nodeCount, "Invalid child index {} for node {}", childIndex, nodeIndex);
+                    mParents[childIndex] = nodeIndex;
+                    mDepths[childIndex] = depth + 1;
+                }
+            }
+        }
+    }
+
+    void LightBVHRefitPlanner::clear()
+    {
+        mParents.clear();
+        mDepths.clear();
+        mTriangleLeaves.clear();
+        mMarks.clear();
+        mPlanIndex = 0;
+        mTreeHeight = 0;
+    }
+
+    LightBVHRefitPlanner::Plan LightBVHRefitPlanner::plan(fstd::span<const TriangleRange> triangleRanges)
+    {
+        Plan plan;
+        if (mParents.empty()) return plan;
+
+        // Tag the nodes visited by this plan instead of clearing a flag per node for each plan.
+        if (++mPlanIndex == 0)
+        {
+            std::fill(mMarks.begin(), mMarks.end(), 0);
+            mPlanIndex = 1;
+        }
+
+        // Mark the leaves holding the moved triangles and walk up to the root. The walk stops at the first node
+        // that is already marked, as all its ancestors are marked too.
+        std::vector<uint32_t> leafNodes;
+        std::vector<uint32_t> internalNodes;
+        for (const TriangleRange& range : triangleRanges)
+        {
+            FALCOR_CHECK_ARG_LE((size_t)range.offset + range.count, mTriangleLeaves.size());
+            for (uint32_t triangleIndex = range.offset; triangleIndex < range.offset + range.count; ++triangleIndex)
+            {
+                const uint32_t leafIndex = mTriangleLeaves[triangleIndex];
+                if (leafIndex == kInvalidIndex || mMarks[leafIndex] == mPlanIndex) continue;
+
+                mMarks[leafIndex] = mPlanIndex;
+                leafNodes.push_back(leafIndex);
+
+                for (uint32_t nodeIndex = mParents[leafIndex]; nodeIndex != kInvalidIndex && mMarks[nodeIndex] != mPlanIndex; nodeIndex = mParents[nodeIndex])
+                {
+                    mMarks[nodeIndex] = mPlanIndex;
+                    internalNodes.push_back(nodeIndex);
+                }
+            }
+        }
+
+        if (leafNodes.empty()) return plan;
+
+        // Sort the nodes by depth. Within a level, nodes are sorted by index to keep the memory accesses coherent.
+        std::sort(leafNodes.begin(), leafNodes.end());
+        std::sort(internalNodes.begin(), internalNodes.end());
+
+        plan.perDepthRefitEntryInfo.resize(mTreeHeight + 1);
+        for (uint32_t nodeIndex : internalNodes) ++plan.perDepthRefitEntryInfo[mDepths[nodeIndex]].count;
+        plan.perDepthRefitEntryInfo.back().count = (uint32_t)leafNodes.size();
+
+        std::vector<uint32_t> perDepthOffset(plan.perDepthRefitEntryInfo.size(), 0);
+        for (size_t i = 1; i < plan.perDepthRefitEntryInfo.size(); ++i)
+        {
+            const RefitEntryInfo& prev = plan.perDepthRefitEntryInfo[i - 1];
+            perDepthOffset[i] = plan.perDepthRefitEntryInfo[i].offset = prev.offset + prev.count;
+        }
+
+        plan.nodeIndices.resize(internalNodes.size() + leafNodes.size());
+        for (uint32_t nodeIndex : internalNodes) plan.nodeIndices[perDepthOffset[mDepths[nodeIndex]]++] = nodeIndex;
+        std::copy(leafNodes.begin(), leafNodes.end(), plan.nodeIndices.begin() + perDepthOffset.back());
+        FALCOR_ASSERT(perDepthOffset.back() == internalNodes.size());
+
+        return plan;
+    }
+}
@@ -0,0 +1,116 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "LightBVHTypes.slang"
+#include "Core/Macros.h"
+#include <fstd/span.h> // TODO C++20: Replace with <span>
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Plans incremental refits of a light BVH.
+
+        The planner keeps the topology of the tree (parent and depth of each node, and the leaf holding each triangle).
+        Given the triangles that have moved, it lists the leaf nodes holding them and all their ancestors, laid out the
+        same way as the node indices used by LightBVH::refit(). All other nodes keep valid bounds and need no update.
+
+        The planner is a pure CPU component and does not create any resources.
+    */
+    class FALCOR_API LightBVHRefitPlanner
+    {
+    public:
+        struct RefitEntryInfo
+        {
+            uint32_t offset = 0;    ///< Offset into the node index list.
+            uint32_t count = 0;     ///< The number of nodes at each level.
+        };
+
+        /** Range of global triangle indices.
+        */
+        struct TriangleRange
+        {
+            uint32_t offset = 0;    ///< First triangle index.
+            uint32_t count = 0;     ///< Number of triangles.
+        };
+
+        /** Nodes to refit.
+            The indices are stored as follows:
+            <-- Internal nodes at level 0 --> | ... | <-- Internal nodes at level (treeHeight - 1) --> | <-- Leaf nodes -->
+        */
+        struct Plan
+        {
+            std::vector<uint32_t> nodeIndices;                  ///< Indices of the nodes to refit, sorted by tree depth.
+            std::vector<RefitEntryInfo> perDepthRefitEntryInfo; ///< For each level the range of internal nodes in 'nodeIndices'; the last entry holds the leaf nodes. Levels may be empty.
+        };
+
+        /** Set the tree to plan refits for.
+            \param[in] nodes BVH nodes in depth-first order.
+            \param[in] triangleIndices Triangle indices sorted by leaf node.
+            \param[in] triangleCount Total number of triangles. Triangles that are not in any leaf are ignored when planning.
+        */
+        void setTree(fstd::span<const PackedNode> nodes, fstd::span<const uint32_t> triangleIndices, uint32_t triangleCount);
+
+        /** Reset to an empty tree.
+        */
+        void clear();
+
+        /** Compute the nodes that need to be refit after some triangles have moved.
+            \param[in] triangleRanges Ranges of triangles that have moved.
+            \return The nodes to refit. The plan is empty if none of the triangles is in the tree.
+        */
+        Plan plan(fstd::span<const TriangleRange> triangleRanges);
+
+        /** Returns the number of nodes in the tree.
+        */
+        uint32_t getNodeCount() const { return (uint32_t)mParents.size(); }
+
+        /** Returns the number of edges on the longest path between the root node and a leaf.
+        */
+        uint32_t getTreeHeight() const { return mTreeHeight; }
+
+        /** Returns the parent of a node, or kInvalidIndex for the root node.
+        */
+        uint32_t getParent(uint32_t nodeIndex) const { return mParents[nodeIndex]; }
+
+        /** Returns the leaf node holding a triangle, or kInvalidIndex if the triangle is not in the tree.
+        */
+        uint32_t getLeaf(uint32_t triangleIndex) const { return mTriangleLeaves[triangleIndex]; }
+
+        static constexpr uint32_t kInvalidIndex = 0xffffffff;
+
+    private:
+        std::vector<uint32_t> mParents;         ///< Parent of each node.
+        std::vector<uint32_t> mDepths;          ///< Depth of each node.
+        std::vector<uint32_t> mTriangleLeaves;  ///< Leaf node of each global triangle.
+        uint32_t mTreeHeight = 0;
+
+        std::vector<uint32_t> mMarks;           ///< Per-node tag of the last plan that visited the node.
+        uint32_t mPlanIndex = 0;                ///< Tag of the current plan.
+    };
+}
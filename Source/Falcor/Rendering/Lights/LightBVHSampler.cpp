@@ -65,16 +65,98 @@ namespace Falcor
             mpBVHBuilder->build(pRenderContext, *mpBVH);
             mNeedsRebuild = false;
             samplerChanged = true;
+
+            // Drop any pending background rebuild, it was started with outdated lights or options.
+            mRebuildTask = {};
+            resetQualityMonitor();
         }
-        else if (needsRefit)
+        else
         {
-            mpBVH->refit(pRenderContext);
-            samplerChanged = true;
+            // Evaluate the BVH cost using the nodes copied at the end of a previous update.
+            if (mQualityCheckPending) checkQuality(pRenderContext);
+
+            // Swap in the BVH rebuilt in the background once it is ready.
+            // All nodes are refit afterwards, as the lights may have moved since the rebuild was started.
+            bool needsFullRefit = false;
+            if (mRebuildTask.isValid() && !mRebuildTask.isRunning())
+            {
+                FALCOR_PROFILE(pRenderContext, "LightBVHSampler::swapBVH");
+                mpBVHBuilder->upload(*mpBVH, mRebuildTask.get());
+                mRebuildTask = {};
+                resetQualityMonitor();
+                needsFullRefit = true;
+                samplerChanged = true;
+            }
+
+            if ((needsRefit || needsFullRefit) && mpBVH->isValid())
+            {
+                if (needsFullRefit || !mOptions.incrementalRefit) mpBVH->refit(pRenderContext);
+                else mpBVH->refit(pRenderContext, mpScene->getLightCollection(pRenderContext)->getUpdatedLights());
+                samplerChanged = true;
+
+                // Schedule a readback of the nodes to evaluate the BVH cost on a later update.
+                if (mOptions.rebuildCostThreshold > 0.f && !mRebuildTask.isValid() && ++mRefitsSinceQualityCheck >= mOptions.qualityCheckInterval)
+                {
+                    mpBVH->prepareSyncDataToCPU(pRenderContext);
+                    mQualityCheckPending = true;
+                    mRefitsSinceQualityCheck = 0;
+                }
+            }
         }
 
         return samplerChanged;
     }
 
+    void LightBVHSampler::resetQualityMonitor()
+    {
+        mReferenceCost = 0.f;
+        mCostRatio = 1.f;
+        mRefitsSinceQualityCheck = 0;
+        mQualityCheckPending = false;
+    }
+
+    void LightBVHSampler::checkQuality(RenderContext* pRenderContext)
+    {
+        FALCOR_PROFILE(pRenderContext, "LightBVHSampler::checkQuality");
+
+        mQualityCheckPending = false;
+        const float cost = mpBVHBuilder->evalCost(*mpBVH);
+        if (cost <= 0.f) return;
+
+        // The refit computes looser lighting cones than the builder. The reference cost is therefore measured
+        // on refit nodes, rather than on the nodes created by the build.
+        if (mReferenceCost == 0.f)
+        {
+            mReferenceCost = cost;
+            return;
+        }
+
+        mCostRatio = cost / mReferenceCost;
+        if (mCostRatio > mOptions.rebuildCostThreshold) startBackgroundRebuild(pRenderContext);
+    }
+
+    void LightBVHSampler::startBackgroundRebuild(RenderContext* pRenderContext)
+    {
+        FALCOR_PROFILE(pRenderContext, "LightBVHSampler::startBackgroundRebuild");
+        FALCOR_ASSERT(!mRebuildTask.isValid());
+
+        // Reading back the triangles waits for the GPU, but this only happens when the BVH quality has degraded.
+        const auto& pLightCollection = mpScene->getLightCollection(pRenderContext);
+        pLightCollection->prepareSyncCPUData(pRenderContext);
+        const auto& triangles = pLightCollection->getMeshLightTriangles(pRenderContext);
+
+        std::vector<LightBVHBuilder::TriangleSortData> trianglesData = mpBVHBuilder->prepareTriangles(triangles);
+        if (trianglesData.empty()) return;
+
+        // The task works on copies of the builder and the light data, so that it is not affected by later updates.
+        const uint32_t triangleCount = static_cast<uint32_t>(triangles.size());
+        mRebuildTask = Threading::dispatchTask(
+            [builder = *mpBVHBuilder, trianglesData = std::move(trianglesData), triangleCount]()
+            { return builder.buildNodes(trianglesData, triangleCount); }
+        );
+        mBackgroundRebuildCount++;
+    }
+
     Program::DefineList LightBVHSampler::getDefines() const
     {
         // Call the base class first.
@@ -132,9 +214,23 @@ namespace Falcor
         }
 
 
+        if (auto updateGroup = widgets.group("BVH update options"))
+        {
+            updateGroup.checkbox("Incremental refit", mOptions.incrementalRefit);
+            updateGroup.tooltip("Only refit the BVH nodes holding lights that have moved.");
+            updateGroup.var("Rebuild cost threshold", mOptions.rebuildCostThreshold, 0.f, 100.f, 0.01f);
+            updateGroup.tooltip("Rebuild the BVH in the background once refitting has increased its SAOH cost by this factor. Set to 0 to disable.");
+            updateGroup.var("Quality check interval", mOptions.qualityCheckInterval, 1u, 1000u);
+        }
+
         if (auto statGroup = widgets.group("BVH statistics"))
         {
             mpBVH->renderUI(statGroup);
+
+            const std::string monitorStr =
+                "  Cost ratio:          " + std::to_string(mCostRatio) + "\n" +
+                "  Background rebuilds: " + std::to_string(mBackgroundRebuildCount) + (mRebuildTask.isValid() ? " (running)" : "");
+            statGroup.text(monitorStr);
         }
 
         return optionsChanged;
@@ -165,6 +261,9 @@ namespace Falcor
         options.field(disableNodeFlux);
         options.field(useUniformTriangleSampling);
         options.field(solidAngleBoundMethod);
+        options.field(incrementalRefit);
+        options.field(rebuildCostThreshold);
+        options.field(qualityCheckInterval);
 #undef field
     }
 }
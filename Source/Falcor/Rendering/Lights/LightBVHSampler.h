@@ -33,6 +33,7 @@
 #include "Core/Macros.h"
 #include "Utils/Math/AABB.h"
 #include "Scene/Lights/LightCollection.h"
+#include "Utils/Threading.h"
 #include <memory>
 
 namespace Falcor
@@ -67,6 +68,11 @@ namespace Falcor
 
             SolidAngleBoundMethod solidAngleBoundMethod = SolidAngleBoundMethod::Sphere; ///< Method to use to bound the solid angle subtended by a cluster.
 
+            // Update options
+            bool        incrementalRefit = true;            ///< Only refit the BVH nodes holding lights that have moved. Only used when refitting is allowed.
+            float       rebuildCostThreshold = 1.5f;        ///< Rebuild the BVH in the background once refitting has increased its SAOH cost by this factor. Set to 0 to disable.
+            uint32_t    qualityCheckInterval = 16;          ///< Number of refits between two evaluations of the BVH cost.
+
             // Note: Empty constructor needed for clang due to the use of the nested struct constructor in the parent constructor.
             Options() {}
         };
@@ -105,6 +111,10 @@ namespace Falcor
         const Options& getOptions() const { return mOptions; }
 
     protected:
+        void resetQualityMonitor();
+        void checkQuality(RenderContext* pRenderContext);
+        void startBackgroundRebuild(RenderContext* pRenderContext);
+
         /// Configuration options.
         Options mOptions;
 
@@ -114,5 +124,15 @@ namespace Falcor
 
         /// Trigger rebuild on the next call to update(). We should always build on the first call, so the initial value is true.
         bool mNeedsRebuild = true;
+
+        // Quality monitor
+        float mReferenceCost = 0.f;             ///< BVH cost measured at the first check after the BVH was built, or zero if not measured yet.
+        float mCostRatio = 1.f;                 ///< Ratio between the last measured BVH cost and the reference cost.
+        uint32_t mRefitsSinceQualityCheck = 0;  ///< Number of refits since the BVH cost was last evaluated.
+        bool mQualityCheckPending = false;      ///< True when the BVH nodes are being copied to the CPU for evaluating the cost.
+        uint32_t mBackgroundRebuildCount = 0;   ///< Number of BVH rebuilds started by the quality monitor.
+
+        /// BVH being rebuilt on the thread pool. The result replaces the current BVH once the build has finished.
+        Threading::Future<LightBVHBuilder::BuildResult> mRebuildTask;
     };
 }
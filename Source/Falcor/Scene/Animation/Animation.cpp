@@ -31,6 +31,7 @@
 #include "Utils/Math/Common.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "Scene/Transform.h"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -113,30 +114,35 @@ namespace Falcor
 
     float4x4 Animation::animate(double currentTime)
     {
+        FALCOR_ASSERT(getKeyframeCount() > 0);
+        const size_t lastIndex = getKeyframeCount() - 1;
+        const double firstKeyframeTime = getKeyframeTime(0);
+        const double lastKeyframeTime = getKeyframeTime(lastIndex);
+
         // Calculate the sample time.
         double time = currentTime;
-        if (time < mKeyframes.front().time || time > mKeyframes.back().time)
+        if (time < firstKeyframeTime || time > lastKeyframeTime)
         {
             time = calcSampleTime(currentTime);
         }
 
         // Determine if the animation behaves linearly outside of defined keyframes.
-        bool isLinearPostInfinity = time > mKeyframes.back().time && this->getPostInfinityBehavior() == Behavior::Linear;
-        bool isLinearPreInfinity = time < mKeyframes.front().time && this->getPreInfinityBehavior() == Behavior::Linear;
+        bool isLinearPostInfinity = time > lastKeyframeTime && this->getPostInfinityBehavior() == Behavior::Linear;
+        bool isLinearPreInfinity = time < firstKeyframeTime && this->getPreInfinityBehavior() == Behavior::Linear;
 
         Keyframe interpolated;
 
-        if (isLinearPreInfinity && mKeyframes.size() > 1)
+        if (isLinearPreInfinity && lastIndex > 0)
         {
-            const auto& k0 = mKeyframes.front();
+            const auto k0 = getKeyframeByIndex(0);
             auto k1 = interpolate(mInterpolationMode, k0.time + kEpsilonTime);
             double segmentDuration = k1.time - k0.time;
             float t = (float)((time - k0.time) / segmentDuration);
             interpolated = interpolateLinear(k0, k1, t);
         }
-        else if (isLinearPostInfinity && mKeyframes.size() > 1)
+        else if (isLinearPostInfinity && lastIndex > 0)
         {
-            const auto& k1 = mKeyframes.back();
+            const auto k1 = getKeyframeByIndex(lastIndex);
             auto k0 = interpolate(mInterpolationMode, k1.time - kEpsilonTime);
             double segmentDuration = k1.time - k0.time;
             float t = (float)((time - k0.time) / segmentDuration);
@@ -155,38 +161,91 @@ namespace Falcor
         return transform;
     }
 
-    Animation::Keyframe Animation::interpolate(InterpolationMode mode, double time) const
+    void Animation::compress(const AnimationClip::Options& options)
     {
-        FALCOR_ASSERT(!mKeyframes.empty());
+        if (mpClip) decompress();
+
+        std::vector<double> times(mKeyframes.size());
+        std::vector<float3> translations(mKeyframes.size());
+        std::vector<float3> scalings(mKeyframes.size());
+        std::vector<quatf> rotations(mKeyframes.size());
+        for (size_t i = 0; i < mKeyframes.size(); i++)
+        {
+            times[i] = mKeyframes[i].time;
+            translations[i] = mKeyframes[i].translation;
+            scalings[i] = mKeyframes[i].scaling;
+            rotations[i] = mKeyframes[i].rotation;
+        }
 
-        // Validate cached frame index.
-        size_t frameIndex = std::clamp(mCachedFrameIndex, (size_t)0, mKeyframes.size() - 1);
-        if (time < mKeyframes[frameIndex].time) frameIndex = 0;
+        mpClip = std::make_unique<AnimationClip>(times, translations, scalings, rotations, options);
+        mKeyframes = {};
+    }
+
+    size_t Animation::getMemoryUsageInBytes() const
+    {
+        return mpClip ? mpClip->getMemoryUsageInBytes() : mKeyframes.size() * sizeof(Keyframe);
+    }
 
-        // Find frame index.
-        while (frameIndex < mKeyframes.size() - 1)
+    Animation::Keyframe Animation::getKeyframeByIndex(size_t index) const
+    {
+        if (!mpClip) return mKeyframes[index];
+        return Keyframe{ mpClip->getTime(index), mpClip->getTranslation(index), mpClip->getScaling(index), mpClip->getRotation(index) };
+    }
+
+    size_t Animation::searchKeyframe(double time) const
+    {
+        if (mpClip) return mpClip->findKeyframe(time);
+        auto it = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), time, [] (double t, const Keyframe& k) { return t < k.time; });
+        return it == mKeyframes.begin() ? 0 : (size_t)(it - mKeyframes.begin()) - 1;
+    }
+
+    size_t Animation::findKeyframe(double time) const
+    {
+        const size_t count = getKeyframeCount();
+        FALCOR_ASSERT(count > 0);
+
+        // Playback usually stays in the cached segment or advances to the next one.
+        // Otherwise locate the segment by binary search, so seeking backwards is as fast as seeking forwards.
+        size_t frameIndex = std::min(mCachedFrameIndex, count - 1);
+        auto inSegment = [&] (size_t i) { return (i == 0 || getKeyframeTime(i) <= time) && (i + 1 == count || getKeyframeTime(i + 1) > time); };
+        if (!inSegment(frameIndex))
         {
-            if (mKeyframes[frameIndex + 1].time > time) break;
-            frameIndex++;
+            if (frameIndex + 1 < count && inSegment(frameIndex + 1)) frameIndex++;
+            else frameIndex = searchKeyframe(time);
         }
 
-        // Cache frame index;
         mCachedFrameIndex = frameIndex;
+        return frameIndex;
+    }
+
+    void Animation::decompress()
+    {
+        FALCOR_ASSERT(mpClip);
+        mKeyframes.resize(mpClip->getKeyframeCount());
+        for (size_t i = 0; i < mKeyframes.size(); i++) mKeyframes[i] = getKeyframeByIndex(i);
+        mpClip.reset();
+    }
+
+    Animation::Keyframe Animation::interpolate(InterpolationMode mode, double time) const
+    {
+        const size_t count = getKeyframeCount();
+        FALCOR_ASSERT(count > 0);
+
+        size_t frameIndex = findKeyframe(time);
 
         // Compute index of adjacent frame including optional warping.
-        auto adjacentFrame = [this] (size_t frame, int32_t offset = 1)
+        auto adjacentFrame = [this, count] (size_t frame, int32_t offset = 1)
         {
-            size_t count = mKeyframes.size();
             return mEnableWarping ? (frame + count + offset) % count : std::clamp(frame + offset, (size_t)0, count - 1);
         };
 
-        if (mode == InterpolationMode::Linear || mKeyframes.size() < 4)
+        if (mode == InterpolationMode::Linear || count < 4)
         {
             size_t i0 = frameIndex;
             size_t i1 = adjacentFrame(i0);
 
-            const Keyframe& k0 = mKeyframes[i0];
-            const Keyframe& k1 = mKeyframes[i1];
+            const Keyframe k0 = getKeyframeByIndex(i0);
+            const Keyframe k1 = getKeyframeByIndex(i1);
 
             double segmentDuration = k1.time - k0.time;
             if (mEnableWarping && segmentDuration < 0.0) segmentDuration += mDuration;
@@ -201,10 +260,10 @@ namespace Falcor
             size_t i2 = adjacentFrame(i1, 1);
             size_t i3 = adjacentFrame(i1, 2);
 
-            const Keyframe& k0 = mKeyframes[i0];
-            const Keyframe& k1 = mKeyframes[i1];
-            const Keyframe& k2 = mKeyframes[i2];
-            const Keyframe& k3 = mKeyframes[i3];
+            const Keyframe k0 = getKeyframeByIndex(i0);
+            const Keyframe k1 = getKeyframeByIndex(i1);
+            const Keyframe k2 = getKeyframeByIndex(i2);
+            const Keyframe k3 = getKeyframeByIndex(i3);
 
             double segmentDuration = k2.time - k1.time;
             if (mEnableWarping && segmentDuration < 0.0) segmentDuration += mDuration;
@@ -225,8 +284,8 @@ namespace Falcor
     double Animation::calcSampleTime(double currentTime)
     {
         double modifiedTime = currentTime;
-        double firstKeyframeTime = mKeyframes.front().time;
-        double lastKeyframeTime = mKeyframes.back().time;
+        double firstKeyframeTime = getKeyframeTime(0);
+        double lastKeyframeTime = getKeyframeTime(getKeyframeCount() - 1);
         double duration = lastKeyframeTime - firstKeyframeTime;
 
         FALCOR_ASSERT(currentTime < firstKeyframeTime || currentTime > lastKeyframeTime);
@@ -257,59 +316,27 @@ namespace Falcor
     {
         FALCOR_ASSERT(keyframe.time <= mDuration);
 
-        if (mKeyframes.size() == 0 || mKeyframes[0].time > keyframe.time)
-        {
-            mKeyframes.insert(mKeyframes.begin(), keyframe);
-        }
-        else if (mKeyframes.back().time < keyframe.time)
-        {
-            mKeyframes.push_back(keyframe);
-        }
-        else
-        {
-            for (size_t i = 0; i < mKeyframes.size(); i++)
-            {
-                auto& current = mKeyframes[i];
-                // If we already have a key-frame at the same time, replace it
-                if (current.time == keyframe.time)
-                {
-                    current = keyframe;
-                    return;
-                }
-
-                // If this is not the last frame, Check if we are in between frames
-                if (i < mKeyframes.size() - 1)
-                {
-                    auto& Next = mKeyframes[i + 1];
-                    if (current.time < keyframe.time && Next.time > keyframe.time)
-                    {
-                        mKeyframes.insert(mKeyframes.begin() + i + 1, keyframe);
-                        return;
-                    }
-                }
-            }
-
-            // If we got here, need to push it to the end of the list
-            mKeyframes.push_back(keyframe);
-        }
+        if (mpClip) decompress();
+
+        // Insert the keyframe in sorted order. If we already have a keyframe at the same time, replace it.
+        auto it = std::lower_bound(mKeyframes.begin(), mKeyframes.end(), keyframe.time, [] (const Keyframe& k, double t) { return k.time < t; });
+        if (it != mKeyframes.end() && it->time == keyframe.time) *it = keyframe;
+        else mKeyframes.insert(it, keyframe);
     }
 
-    const Animation::Keyframe& Animation::getKeyframe(double time) const
+    Animation::Keyframe Animation::getKeyframe(double time) const
     {
-        for (const auto& k : mKeyframes)
+        if (getKeyframeCount() > 0)
         {
-            if (k.time == time) return k;
+            size_t index = searchKeyframe(time);
+            if (getKeyframeTime(index) == time) return getKeyframeByIndex(index);
         }
         throw ArgumentError("'time' ({}) does not refer to an existing keyframe", time);
     }
 
     bool Animation::doesKeyframeExists(double time) const
     {
-        for (const auto& k : mKeyframes)
-        {
-            if (k.time == time) return true;
-        }
-        return false;
+        return getKeyframeCount() > 0 && getKeyframeTime(searchKeyframe(time)) == time;
     }
 
     void Animation::renderUI(Gui::Widgets& widget)
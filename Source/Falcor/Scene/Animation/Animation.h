@@ -28,6 +28,7 @@
 #pragma once
 #include "Core/Macros.h"
 #include "Core/Object.h"
+#include "AnimationClip.h"
 #include "Scene/SceneIDs.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Math/Matrix.h"
@@ -125,6 +126,7 @@ namespace Falcor
 
         /** Add a keyframe.
             If there's already a keyframe at the requested time, this call will override the existing frame.
+            If the animation is compressed, it is decompressed first.
             \param[in] keyframe Keyframe.
         */
         void addKeyframe(const Keyframe& keyframe);
@@ -134,7 +136,7 @@ namespace Falcor
             \param[in] time Time of the keyframe.
             \return Returns the keyframe.
         */
-        const Keyframe& getKeyframe(double time) const;
+        Keyframe getKeyframe(double time) const;
 
         /** Check if a keyframe exists at the specified time.
             \param[in] time Time of the keyframe.
@@ -148,11 +150,38 @@ namespace Falcor
         */
         float4x4 animate(double currentTime);
 
+        /** Compress the keyframes into an animation clip.
+            The clip replaces the keyframe list. Translations, scalings and rotations are quantized within the error bounds
+            given by the options, which changes the animation by at most that amount. Uniformly spaced keyframe times
+            are snapped to the uniform grid.
+            \param[in] options Compression options.
+        */
+        void compress(const AnimationClip::Options& options = AnimationClip::Options());
+
+        /** Returns true if the keyframes are stored as a compressed animation clip.
+        */
+        bool isCompressed() const { return mpClip != nullptr; }
+
+        /** Get the compressed animation clip, or nullptr if the animation is not compressed.
+        */
+        const AnimationClip* getClip() const { return mpClip.get(); }
+
+        /** Get the memory used for storing the keyframes in bytes.
+        */
+        size_t getMemoryUsageInBytes() const;
+
         /* Render the UI.
         */
         void renderUI(Gui::Widgets& widget);
 
     private:
+        size_t getKeyframeCount() const { return mpClip ? mpClip->getKeyframeCount() : mKeyframes.size(); }
+        double getKeyframeTime(size_t index) const { return mpClip ? mpClip->getTime(index) : mKeyframes[index].time; }
+        Keyframe getKeyframeByIndex(size_t index) const;
+        size_t searchKeyframe(double time) const;
+        size_t findKeyframe(double time) const;
+        void decompress();
+
         Keyframe interpolate(InterpolationMode mode, double time) const;
         double calcSampleTime(double currentTime);
 
@@ -166,7 +195,8 @@ namespace Falcor
         InterpolationMode mInterpolationMode = InterpolationMode::Linear;
         bool mEnableWarping = false;
 
-        std::vector<Keyframe> mKeyframes;
+        std::vector<Keyframe> mKeyframes;           ///< Keyframes sorted by time. Empty if the animation is compressed.
+        std::unique_ptr<AnimationClip> mpClip;      ///< Compressed keyframes, or nullptr if not compressed.
         mutable size_t mCachedFrameIndex = 0;
 
         friend class SceneCache;
@@ -0,0 +1,202 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "AnimationClip.h"
+#include "Core/Errors.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Relative deviation from the average time step below which keyframe times are considered uniform.
+        const double kUniformTimeTolerance = 1e-6;
+
+        template<typename T>
+        void encodeQuantized(const std::vector<float4>& values, uint32_t components, float4 offset, float4 scale, std::vector<uint8_t>& data)
+        {
+            const float maxValue = (float)std::numeric_limits<T>::max();
+            data.resize(values.size() * components * sizeof(T));
+            T* pDst = reinterpret_cast<T*>(data.data());
+            for (const float4& v : values)
+            {
+                for (uint32_t c = 0; c < components; c++)
+                {
+                    float q = scale[c] > 0.f ? std::round((v[c] - offset[c]) / scale[c]) : 0.f;
+                    *pDst++ = (T)std::clamp(q, 0.f, maxValue);
+                }
+            }
+        }
+
+        template<typename T>
+        float4 decodeQuantized(const std::vector<uint8_t>& data, size_t index, uint32_t components, float4 offset, float4 scale)
+        {
+            T q[4] = {};
+            std::memcpy(q, data.data() + index * components * sizeof(T), components * sizeof(T));
+            float4 v(0.f);
+            for (uint32_t c = 0; c < components; c++) v[c] = offset[c] + (float)q[c] * scale[c];
+            return v;
+        }
+    }
+
+    AnimationClip::AnimationClip(const std::vector<double>& times, const std::vector<float3>& translations, const std::vector<float3>& scalings, const std::vector<quatf>& rotations, const Options& options)
+        : mKeyframeCount(times.size())
+    {
+        FALCOR_CHECK_ARG_EQ(translations.size(), times.size());
+        FALCOR_CHECK_ARG_EQ(scalings.size(), times.size());
+        FALCOR_CHECK_ARG_EQ(rotations.size(), times.size());
+        FALCOR_CHECK_ARG_MSG(std::is_sorted(times.begin(), times.end()), "Keyframe times must be in increasing order.");
+
+        // Store times as start time and time step if they are uniformly spaced.
+        if (mKeyframeCount >= 2)
+        {
+            mStartTime = times.front();
+            mTimeStep = (times.back() - times.front()) / (double)(mKeyframeCount - 1);
+            mUniformTimes = mTimeStep > 0.0;
+            for (size_t i = 0; i < mKeyframeCount && mUniformTimes; i++)
+            {
+                mUniformTimes = std::abs(times[i] - (mStartTime + i * mTimeStep)) <= kUniformTimeTolerance * mTimeStep;
+            }
+        }
+        if (!mUniformTimes) mTimes = times;
+
+        std::vector<float4> values(mKeyframeCount);
+        for (size_t i = 0; i < mKeyframeCount; i++) values[i] = float4(translations[i], 0.f);
+        mTranslation.encode(values, 3, options.translationError);
+        for (size_t i = 0; i < mKeyframeCount; i++) values[i] = float4(scalings[i], 0.f);
+        mScaling.encode(values, 3, options.scalingError);
+        for (size_t i = 0; i < mKeyframeCount; i++) values[i] = float4(rotations[i].x, rotations[i].y, rotations[i].z, rotations[i].w);
+        mRotation.encode(values, 4, options.rotationError);
+    }
+
+    quatf AnimationClip::getRotation(size_t index) const
+    {
+        float4 v = mRotation.decode(index);
+        quatf q(v.x, v.y, v.z, v.w);
+        return mRotation.encoding == Encoding::Float ? q : normalize(q);
+    }
+
+    size_t AnimationClip::findKeyframe(double time) const
+    {
+        if (mKeyframeCount == 0) return 0;
+
+        size_t index = 0;
+        if (mUniformTimes)
+        {
+            // Compute the index directly and correct for rounding of the time step.
+            double t = std::floor((time - mStartTime) / mTimeStep);
+            index = (size_t)std::clamp(t, 0.0, (double)(mKeyframeCount - 1));
+            while (index > 0 && getTime(index) > time) index--;
+            while (index + 1 < mKeyframeCount && getTime(index + 1) <= time) index++;
+        }
+        else
+        {
+            size_t upper = std::upper_bound(mTimes.begin(), mTimes.end(), time) - mTimes.begin();
+            index = upper > 0 ? upper - 1 : 0;
+        }
+        return index;
+    }
+
+    size_t AnimationClip::getMemoryUsageInBytes() const
+    {
+        return sizeof(AnimationClip) + mTimes.size() * sizeof(double) + mTranslation.data.size() + mScaling.data.size() + mRotation.data.size();
+    }
+
+    void AnimationClip::Channel::encode(const std::vector<float4>& values, uint32_t components, float maxError)
+    {
+        componentCount = components;
+        data.clear();
+
+        float4 minValue(std::numeric_limits<float>::max());
+        float4 maxValue(std::numeric_limits<float>::lowest());
+        for (const float4& v : values)
+        {
+            minValue = min(minValue, v);
+            maxValue = max(maxValue, v);
+        }
+
+        float maxExtent = 0.f;
+        for (uint32_t c = 0; c < components; c++) maxExtent = std::max(maxExtent, maxValue[c] - minValue[c]);
+
+        // Eliminate channels that stay within the error bound of their midpoint.
+        if (values.empty() || maxExtent <= 2.f * maxError)
+        {
+            encoding = Encoding::Constant;
+            offset = values.empty() ? float4(0.f) : (minValue + maxValue) * 0.5f;
+            scale = float4(0.f);
+            return;
+        }
+
+        // Use the smallest quantization with a rounding error (half a step) within the error bound.
+        offset = minValue;
+        if (maxExtent / 255.f * 0.5f <= maxError)
+        {
+            encoding = Encoding::Quantized8;
+            scale = (maxValue - minValue) / 255.f;
+            encodeQuantized<uint8_t>(values, components, offset, scale, data);
+        }
+        else if (maxExtent / 65535.f * 0.5f <= maxError)
+        {
+            encoding = Encoding::Quantized16;
+            scale = (maxValue - minValue) / 65535.f;
+            encodeQuantized<uint16_t>(values, components, offset, scale, data);
+        }
+        else
+        {
+            encoding = Encoding::Float;
+            offset = float4(0.f);
+            scale = float4(0.f);
+            data.resize(values.size() * components * sizeof(float));
+            for (size_t i = 0; i < values.size(); i++) std::memcpy(data.data() + i * components * sizeof(float), &values[i], components * sizeof(float));
+        }
+    }
+
+    float4 AnimationClip::Channel::decode(size_t index) const
+    {
+        switch (encoding)
+        {
+        case Encoding::Constant:
+            return offset;
+        case Encoding::Quantized8:
+            return decodeQuantized<uint8_t>(data, index, componentCount, offset, scale);
+        case Encoding::Quantized16:
+            return decodeQuantized<uint16_t>(data, index, componentCount, offset, scale);
+        case Encoding::Float:
+        {
+            float4 v(0.f);
+            std::memcpy(&v, data.data() + index * componentCount * sizeof(float), componentCount * sizeof(float));
+            return v;
+        }
+        default:
+            FALCOR_UNREACHABLE();
+            return float4(0.f);
+        }
+    }
+}
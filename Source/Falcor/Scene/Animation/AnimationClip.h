@@ -0,0 +1,144 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/Vector.h"
+#include "Utils/Math/Quaternion.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** Compact keyframe storage for animations.
+
+        The keyframes are stored as separate channels for time, translation, scaling and rotation (struct-of-arrays).
+        Channels that don't change over the clip are stored as a single value. The other channels are quantized to
+        8 or 16 bits per component if that stays within the requested error bound, and are stored as floats otherwise.
+        Uniformly spaced keyframe times are stored as start time and time step, which allows locating a keyframe in
+        constant time. Other keyframe times are located by binary search.
+    */
+    class FALCOR_API AnimationClip
+    {
+    public:
+        /** Maximum absolute error per component allowed when quantizing a channel.
+            The decoded values can additionally differ by the float rounding error.
+        */
+        struct Options
+        {
+            float translationError = 1e-4f;     ///< Maximum error of the translation components.
+            float scalingError = 1e-4f;         ///< Maximum error of the scaling components.
+            float rotationError = 1e-4f;        ///< Maximum error of the rotation quaternion components before normalization.
+
+            // Note: Empty constructor needed for clang due to the use of the nested struct constructor in the parent constructor.
+            Options() {}
+        };
+
+        enum class Encoding : uint32_t
+        {
+            Constant,       ///< Single value for all keyframes.
+            Quantized8,     ///< 8 bits per component.
+            Quantized16,    ///< 16 bits per component.
+            Float,          ///< 32-bit float per component.
+        };
+
+        AnimationClip() = default;
+
+        /** Create a clip from keyframe data.
+            \param[in] times Keyframe times in increasing order.
+            \param[in] translations Translation per keyframe.
+            \param[in] scalings Scaling per keyframe.
+            \param[in] rotations Rotation per keyframe.
+            \param[in] options Compression options.
+        */
+        AnimationClip(const std::vector<double>& times, const std::vector<float3>& translations, const std::vector<float3>& scalings, const std::vector<quatf>& rotations, const Options& options = Options());
+
+        /** Get the number of keyframes.
+        */
+        size_t getKeyframeCount() const { return mKeyframeCount; }
+
+        /** Get the time of a keyframe.
+        */
+        double getTime(size_t index) const { return mUniformTimes ? mStartTime + index * mTimeStep : mTimes[index]; }
+
+        /** Get the translation of a keyframe.
+        */
+        float3 getTranslation(size_t index) const { return mTranslation.decode(index).xyz(); }
+
+        /** Get the scaling of a keyframe.
+        */
+        float3 getScaling(size_t index) const { return mScaling.decode(index).xyz(); }
+
+        /** Get the rotation of a keyframe.
+        */
+        quatf getRotation(size_t index) const;
+
+        /** Find the last keyframe at or before a given time.
+            \param[in] time Time in seconds.
+            \return Returns the keyframe index, or 0 if the time is before the first keyframe.
+        */
+        size_t findKeyframe(double time) const;
+
+        /** Returns true if the keyframes are uniformly spaced in time.
+        */
+        bool hasUniformTimes() const { return mUniformTimes; }
+
+        /** Get the encoding of the translation, scaling and rotation channels.
+        */
+        Encoding getTranslationEncoding() const { return mTranslation.encoding; }
+        Encoding getScalingEncoding() const { return mScaling.encoding; }
+        Encoding getRotationEncoding() const { return mRotation.encoding; }
+
+        /** Get the total memory usage in bytes.
+        */
+        size_t getMemoryUsageInBytes() const;
+
+    private:
+        struct Channel
+        {
+            Encoding encoding = Encoding::Constant;
+            uint32_t componentCount = 0;
+            float4 offset = float4(0.f);    ///< Constant value, or start of the quantization range.
+            float4 scale = float4(0.f);     ///< Quantization step per component.
+            std::vector<uint8_t> data;      ///< Encoded components of all keyframes.
+
+            void encode(const std::vector<float4>& values, uint32_t components, float maxError);
+            float4 decode(size_t index) const;
+        };
+
+        size_t mKeyframeCount = 0;
+        bool mUniformTimes = false;
+        double mStartTime = 0.0;
+        double mTimeStep = 0.0;
+        std::vector<double> mTimes;         ///< Keyframe times. Empty if the times are uniform.
+
+        Channel mTranslation;
+        Channel mScaling;
+        Channel mRotation;
+
+        friend class SceneCache;
+    };
+}
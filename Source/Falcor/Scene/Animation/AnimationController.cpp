@@ -27,6 +27,8 @@
  **************************************************************************/
 #include "AnimationController.h"
 #include "Core/API/RenderContext.h"
+#include "Utils/Threading.h"
+#include "Utils/Math/MatrixSIMD.h"
 #include "Utils/Timing/Profiler.h"
 #include "Scene/Scene.h"
 #include <fstream>
@@ -39,6 +41,14 @@ namespace Falcor
         const std::string kInverseTransposeWorldMatrices = "inverseTransposeWorldMatrices";
         const std::string kPrevWorldMatrices = "prevWorldMatrices";
         const std::string kPrevInverseTransposeWorldMatrices = "prevInverseTransposeWorldMatrices";
+
+        const size_t kMinAnimationsPerTask = 64;    ///< Minimum number of animations evaluated by a single task.
+        const size_t kMinNodesPerTask = 1024;       ///< Minimum number of scene graph nodes updated by a single task.
+
+        float4x4 inverseTranspose(const float4x4& m)
+        {
+            return math::isAffine(m) ? math::inverseTransposeAffineSIMD(m) : transpose(inverse(m));
+        }
     }
 
     AnimationController::AnimationController(ref<Device> pDevice, Scene* pScene, const StaticVertexVector& staticVertexData, const SkinningVertexVector& skinningVertexData, uint32_t prevVertexCount, const std::vector<ref<Animation>>& animations)
@@ -51,9 +61,10 @@ namespace Falcor
         , mMatricesChanged(pScene->mSceneGraph.size())
         , mpScene(pScene)
     {
-        // Create GPU resources.
         FALCOR_ASSERT(mLocalMatrices.size() <= std::numeric_limits<uint32_t>::max());
+        levelizeSceneGraph();
 
+        // Create GPU resources.
         if (!mLocalMatrices.empty())
         {
             mpWorldMatricesBuffer = Buffer::createStructured(mpDevice, sizeof(float4x4), (uint32_t)mLocalMatrices.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
@@ -182,6 +193,34 @@ namespace Falcor
         }
     }
 
+    void AnimationController::levelizeSceneGraph()
+    {
+        // Group the scene graph nodes by depth so that each level only depends on the levels above it.
+        // Parents are stored before their children, so the depths can be computed in a single pass.
+        const auto& sceneGraph = mpScene->mSceneGraph;
+        std::vector<uint32_t> depths(sceneGraph.size());
+        uint32_t levelCount = 0;
+        for (size_t i = 0; i < sceneGraph.size(); i++)
+        {
+            NodeID parent = sceneGraph[i].parent;
+            FALCOR_ASSERT(parent == NodeID::Invalid() || parent.get() < i);
+            depths[i] = parent != NodeID::Invalid() ? depths[parent.get()] + 1 : 0;
+            levelCount = std::max(levelCount, depths[i] + 1);
+        }
+
+        // Counting sort of the nodes by depth, keeping the original node order within each level.
+        mLevelOffsets.assign(levelCount + 1, 0);
+        for (uint32_t depth : depths) mLevelOffsets[depth + 1]++;
+        for (uint32_t level = 0; level < levelCount; level++) mLevelOffsets[level + 1] += mLevelOffsets[level];
+
+        mLevelNodes.resize(sceneGraph.size());
+        std::vector<uint32_t> writeOffsets(mLevelOffsets.begin(), mLevelOffsets.end() - 1);
+        for (uint32_t i = 0; i < (uint32_t)sceneGraph.size(); i++)
+        {
+            mLevelNodes[writeOffsets[depths[i]]++] = i;
+        }
+    }
+
     void AnimationController::initLocalMatrices()
     {
         for (size_t i = 0; i < mLocalMatrices.size(); i++)
@@ -288,11 +327,16 @@ namespace Falcor
 
     void AnimationController::updateLocalMatrices(double time)
     {
-        for (auto& pAnimation : mAnimations)
+        // Evaluate the animations in parallel. The results are written in order afterwards,
+        // so that the last animation wins if multiple animations target the same node.
+        mAnimatedMatrices.resize(mAnimations.size());
+        Threading::parallelFor(0, mAnimations.size(), [&](size_t i) { mAnimatedMatrices[i] = mAnimations[i]->animate(time); }, kMinAnimationsPerTask);
+
+        for (size_t i = 0; i < mAnimations.size(); i++)
         {
-            NodeID nodeID = pAnimation->getNodeID();
+            NodeID nodeID = mAnimations[i]->getNodeID();
             FALCOR_ASSERT(nodeID.get() < mLocalMatrices.size());
-            mLocalMatrices[nodeID.get()] = pAnimation->animate(time);
+            mLocalMatrices[nodeID.get()] = mAnimatedMatrices[i];
             mMatricesChanged[nodeID.get()] = true;
         }
     }
@@ -301,30 +345,32 @@ namespace Falcor
     {
         const auto& sceneGraph = mpScene->mSceneGraph;
 
-        for (size_t i = 0; i < mGlobalMatrices.size(); i++)
+        auto updateNode = [&](uint32_t i)
         {
+            NodeID parent = sceneGraph[i].parent;
+
             // Propagate matrix change flag to children.
-            if (sceneGraph[i].parent != NodeID::Invalid())
+            if (parent != NodeID::Invalid())
             {
-                mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[sceneGraph[i].parent.get()];
+                mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[parent.get()];
             }
 
-            if (!mMatricesChanged[i] && !updateAll) continue;
+            if (!mMatricesChanged[i] && !updateAll) return;
 
-            mGlobalMatrices[i] = mLocalMatrices[i];
-
-            if (mpScene->mSceneGraph[i].parent != NodeID::Invalid())
-            {
-                mGlobalMatrices[i] = mul(mGlobalMatrices[sceneGraph[i].parent.get()], mGlobalMatrices[i]);
-            }
-
-            mInvTransposeGlobalMatrices[i] = transpose(inverse(mGlobalMatrices[i]));
+            mGlobalMatrices[i] = parent != NodeID::Invalid() ? math::mulSIMD(mGlobalMatrices[parent.get()], mLocalMatrices[i]) : mLocalMatrices[i];
+            mInvTransposeGlobalMatrices[i] = inverseTranspose(mGlobalMatrices[i]);
 
             if (mpSkinningPass)
             {
-                mSkinningMatrices[i] = mul(mGlobalMatrices[i], sceneGraph[i].localToBindSpace);
-                mInvTransposeSkinningMatrices[i] = transpose(inverse(mSkinningMatrices[i]));
+                mSkinningMatrices[i] = math::mulSIMD(mGlobalMatrices[i], sceneGraph[i].localToBindSpace);
+                mInvTransposeSkinningMatrices[i] = inverseTranspose(mSkinningMatrices[i]);
             }
+        };
+
+        // Nodes on the same level only depend on their parents on the levels above and are updated in parallel.
+        for (size_t level = 0; level + 1 < mLevelOffsets.size(); level++)
+        {
+            Threading::parallelFor(mLevelOffsets[level], mLevelOffsets[level + 1], [&](size_t j) { updateNode(mLevelNodes[j]); }, kMinNodesPerTask);
         }
     }
 
@@ -145,6 +145,7 @@ namespace Falcor
     private:
         friend class SceneBuilder;
 
+        void levelizeSceneGraph();
         void initLocalMatrices();
         void updateLocalMatrices(double time);
         void updateWorldMatrices(bool updateAll = false);
@@ -163,7 +164,10 @@ namespace Falcor
         std::vector<float4x4> mLocalMatrices;
         std::vector<float4x4> mGlobalMatrices;
         std::vector<float4x4> mInvTransposeGlobalMatrices;
-        std::vector<bool> mMatricesChanged;         ///< Flag per matrix, true if matrix changed since last frame.
+        std::vector<uint8_t> mMatricesChanged;      ///< Flag per matrix, true if matrix changed since last frame. Stored as bytes to allow updating nodes in parallel.
+        std::vector<float4x4> mAnimatedMatrices;    ///< Local matrices evaluated by each animation.
+        std::vector<uint32_t> mLevelNodes;          ///< Scene graph node indices sorted by depth in the hierarchy.
+        std::vector<uint32_t> mLevelOffsets;        ///< Offset of the first node of each depth level in mLevelNodes, followed by the total node count.
 
         bool mFirstUpdate = true;       ///< True if this is the first update.
         bool mEnabled = true;           ///< True if animations are enabled.
@@ -336,26 +336,47 @@ namespace Falcor
 
         if (textures.empty()) return;
 
-        // Analyze the textures.
-        logInfo("Analyzing {} material textures.", textures.size());
-
-        RenderContext* pRenderContext = mpDevice->getRenderContext();
-
-        TextureAnalyzer analyzer(mpDevice);
-        auto pResults = Buffer::create(mpDevice, textures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::UnorderedAccess);
-        analyzer.analyze(pRenderContext, textures, pResults);
-
-        // Copy result to staging buffer for readback.
-        // This is mostly to avoid a full flush and the associated perf warning.
-        // We do not have any other useful GPU work, but unrelated GPU tasks can be in flight.
-        auto pResultsStaging = Buffer::create(mpDevice, textures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::None, Buffer::CpuAccess::Read);
-        pRenderContext->copyResource(pResultsStaging.get(), pResults.get());
-        pRenderContext->flush(false);
-        mpFence->gpuSignal(pRenderContext->getLowLevelData()->getCommandQueue());
-
-        // Wait for results to become available. Then optimize the materials.
-        mpFence->syncCpu();
-        const TextureAnalyzer::Result* results = static_cast<const TextureAnalyzer::Result*>(pResultsStaging->map(Buffer::MapType::Read));
+        // Use the analysis computed when the textures were loaded where available.
+        std::vector<TextureAnalyzer::Result> results(textures.size());
+        std::vector<size_t> gpuIndices;
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            auto analysis = mpTextureManager->getTextureDesc(mpTextureManager->findTexture(textures[i].get())).analysis;
+            if (analysis) results[i] = *analysis;
+            else gpuIndices.push_back(i);
+        }
+
+        logInfo("Analyzing {} material textures ({} analyzed during loading).", textures.size(), textures.size() - gpuIndices.size());
+
+        // Analyze the remaining textures on the GPU.
+        if (!gpuIndices.empty())
+        {
+            std::vector<ref<Texture>> gpuTextures;
+            gpuTextures.reserve(gpuIndices.size());
+            for (size_t i : gpuIndices) gpuTextures.push_back(textures[i]);
+
+            RenderContext* pRenderContext = mpDevice->getRenderContext();
+
+            TextureAnalyzer analyzer(mpDevice);
+            auto pResults = Buffer::create(mpDevice, gpuTextures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::UnorderedAccess);
+            analyzer.analyze(pRenderContext, gpuTextures, pResults);
+
+            // Copy result to staging buffer for readback.
+            // This is mostly to avoid a full flush and the associated perf warning.
+            // We do not have any other useful GPU work, but unrelated GPU tasks can be in flight.
+            auto pResultsStaging = Buffer::create(mpDevice, gpuTextures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::None, Buffer::CpuAccess::Read);
+            pRenderContext->copyResource(pResultsStaging.get(), pResults.get());
+            pRenderContext->flush(false);
+            mpFence->gpuSignal(pRenderContext->getLowLevelData()->getCommandQueue());
+
+            // Wait for results to become available.
+            mpFence->syncCpu();
+            const TextureAnalyzer::Result* gpuResults = static_cast<const TextureAnalyzer::Result*>(pResultsStaging->map(Buffer::MapType::Read));
+            for (size_t i = 0; i < gpuIndices.size(); i++) results[gpuIndices[i]] = gpuResults[i];
+            pResultsStaging->unmap();
+        }
+
+        // Optimize the materials.
         Material::TextureOptimizationStats stats = {};
 
         for (size_t i = 0; i < textures.size(); i++)
@@ -363,8 +384,6 @@ namespace Falcor
             materialSlots[i].first->optimizeTexture(materialSlots[i].second, results[i], stats);
         }
 
-        pResultsStaging->unmap();
-
         // Log optimization stats.
         if (size_t totalRemoved = std::accumulate(stats.texturesRemoved.begin(), stats.texturesRemoved.end(), 0ull); totalRemoved > 0)
         {
@@ -452,6 +471,12 @@ namespace Falcor
             mSamplersChanged = false;
         }
 
+        // Stream texture mips in and out based on the requests since the last update.
+        if (mpTextureManager->updateResidency(mpDevice->getRenderContext()))
+        {
+            flags |= Material::UpdateFlags::ResourcesChanged;
+        }
+
         // Update textures.
         if (forceUpdate || is_set(flags, Material::UpdateFlags::ResourcesChanged))
         {
@@ -549,6 +574,8 @@ namespace Falcor
         s.textureTexelCount = textureStats.textureTexelCount;
         s.textureTexelChannelCount = textureStats.textureTexelChannelCount;
         s.textureMemoryInBytes = textureStats.textureMemoryInBytes;
+        s.textureDedupCount = textureStats.textureDedupCount;
+        s.textureDedupMemoryInBytes = textureStats.textureDedupMemoryInBytes;
 
         return s;
     }
@@ -68,6 +68,8 @@ namespace Falcor
             uint64_t textureTexelCount = 0;             ///< Total number of texels in all textures.
             uint64_t textureTexelChannelCount = 0;      ///< Total number of texel channels in all textures.
             uint64_t textureMemoryInBytes = 0;          ///< Total memory in bytes used by the textures.
+            uint64_t textureDedupCount = 0;             ///< Number of texture loads that reuse a texture with identical contents.
+            uint64_t textureDedupMemoryInBytes = 0;     ///< Memory in bytes saved by reusing textures with identical contents.
         };
 
         /** Constructor. Throws an exception if creation failed.
@@ -204,6 +206,7 @@ namespace Falcor
 
         /** Optimize materials.
             This function analyzes textures and replaces constant textures by uniform material parameters.
+            Textures loaded by the texture manager are analyzed while loading. Only the remaining textures are analyzed on the GPU.
         */
         void optimizeMaterials();
 
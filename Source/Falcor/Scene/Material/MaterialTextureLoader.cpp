@@ -30,6 +30,19 @@
 
 namespace Falcor
 {
+    namespace
+    {
+        /** Get the usage of a material texture, which determines its format when textures are baked.
+        */
+        TextureBaker::Usage getTextureUsage(Material::TextureSlot slot, const Material::TextureSlotInfo& info)
+        {
+            if (slot == Material::TextureSlot::Normal) return TextureBaker::Usage::Normal;
+            if (slot == Material::TextureSlot::Index) return TextureBaker::Usage::Lossless;
+            if (info.mask == TextureChannelFlags::Red) return TextureBaker::Usage::Scalar;
+            return TextureBaker::Usage::Color;
+        }
+    }
+
     MaterialTextureLoader::MaterialTextureLoader(TextureManager& textureManager, bool useSrgb)
         : mUseSrgb(useSrgb)
         , mTextureManager(textureManager)
@@ -50,10 +63,12 @@ namespace Falcor
             return;
         }
 
-        bool srgb = mUseSrgb && pMaterial->getTextureSlotInfo(slot).srgb;
+        const auto& slotInfo = pMaterial->getTextureSlotInfo(slot);
+        bool srgb = mUseSrgb && slotInfo.srgb;
 
         // Request texture to be loaded.
-        auto handle = mTextureManager.loadTexture(path, true, srgb);
+        auto usage = getTextureUsage(slot, slotInfo);
+        auto handle = mTextureManager.loadTexture(path, true, srgb, Resource::BindFlags::ShaderResource, true, nullptr, nullptr, usage);
 
         // Store assignment to material for later.
         mTextureAssignments.emplace_back(TextureAssignment{ pMaterial, slot, handle });
@@ -41,6 +41,7 @@
 #include "Utils/StringUtils.h"
 #include "Utils/ObjectIDPython.h"
 #include "Utils/Math/Common.h"
+#include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Timing/Profiler.h"
@@ -63,6 +64,9 @@ namespace Falcor
         // The target is max 0.5GB intermediate memory per BLAS group. Note that this is not a strict limit.
         const size_t kMaxBLASBuildMemory = 1ull << 29;
 
+        // Frame height in pixels assumed when choosing texture mips to stream in.
+        const float kTextureResidencyFrameHeight = 2160.f;
+
         const std::string kParameterBlockName = "gScene";
         const std::string kGeometryInstanceBufferName = "geometryInstances";
         const std::string kMeshBufferName = "meshes";
@@ -81,6 +85,7 @@ namespace Falcor
         const std::string kGridVolumesBufferName = "gridVolumes";
 
         const std::string kStats = "stats";
+        const std::string kBuildTimes = "buildTimes";
         const std::string kBounds = "bounds";
         const std::string kAnimations = "animations";
         const std::string kLoopAnimations = "loopAnimations";
@@ -1728,6 +1733,45 @@ namespace Falcor
         return flags;
     }
 
+    void Scene::updateTextureResidency()
+    {
+        auto& textureManager = mpMaterials->getTextureManager();
+        if (!textureManager.isResidencyEnabled() || mCameras.empty()) return;
+
+        const auto& pCamera = getCamera();
+        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        const float3 cameraPos = pCamera->getPosition();
+        const float pixelAngle = focalLengthToFovY(pCamera->getFocalLength(), pCamera->getFrameHeight()) / kTextureResidencyFrameHeight;
+
+        // Find the closest use of each material, as distance relative to the size of the mesh instance.
+        std::vector<float> relativeDistances(mpMaterials->getMaterialCount(), std::numeric_limits<float>::infinity());
+        for (const auto& inst : mGeometryInstanceData)
+        {
+            if (inst.getType() != GeometryType::TriangleMesh && inst.getType() != GeometryType::DisplacedTriangleMesh) continue;
+
+            AABB bounds = mMeshBBs[inst.geometryID].transform(globalMatrices[inst.globalMatrixID]);
+            float size = length(bounds.extent());
+            if (!(size > 0.f)) continue;
+
+            float distance = std::max(0.f, length(bounds.center() - cameraPos) - 0.5f * size);
+            relativeDistances[inst.materialID] = std::min(relativeDistances[inst.materialID], distance / size);
+        }
+
+        for (uint32_t materialID = 0; materialID < (uint32_t)relativeDistances.size(); materialID++)
+        {
+            if (std::isinf(relativeDistances[materialID])) continue;
+
+            const auto& pMaterial = mpMaterials->getMaterial(MaterialID::fromSlang(materialID));
+            for (uint32_t slot = 0; slot < (uint32_t)Material::TextureSlot::Count; slot++)
+            {
+                auto pTexture = pMaterial->getTexture((Material::TextureSlot)slot);
+                if (!pTexture) continue;
+                auto handle = textureManager.findTexture(pTexture.get());
+                textureManager.requestMipLevelFromDistance(handle, 1.f, relativeDistances[materialID], pixelAngle);
+            }
+        }
+    }
+
     Scene::UpdateFlags Scene::updateGeometry(RenderContext* pRenderContext, bool forceUpdate)
     {
         UpdateFlags flags = updateProceduralPrimitives(forceUpdate);
@@ -1756,6 +1800,7 @@ namespace Falcor
 
         // Perform updates that may affect the scene defines.
         updateGeometryTypes();
+        updateTextureResidency();
         mUpdates |= updateMaterials(false);
 
         // Update scene defines.
@@ -2107,6 +2152,8 @@ namespace Falcor
                 << "  Texture count (compressed): " << s.materials.textureCompressedCount << std::endl
                 << "  Texture texel count: " << s.materials.textureTexelCount << std::endl
                 << "  Texture memory: " << formatByteSize(s.materials.textureMemoryInBytes) << std::endl
+                << "  Texture duplicates: " << s.materials.textureDedupCount << std::endl
+                << "  Texture memory saved by duplicates: " << formatByteSize(s.materials.textureDedupMemoryInBytes) << std::endl
                 << "  Bytes/texel (average): " << std::fixed << std::setprecision(2) << bytesPerTexel << std::endl
                 << "  Channels/texel (average): " << std::fixed << std::setprecision(2) << channelsPerTexel << std::endl
                 << std::endl;
@@ -4045,6 +4092,8 @@ namespace Falcor
         d["textureTexelCount"] = stats.materials.textureTexelCount;
         d["textureTexelChannelCount"] = stats.materials.textureTexelChannelCount;
         d["textureMemoryInBytes"] = stats.materials.textureMemoryInBytes;
+        d["textureDedupCount"] = stats.materials.textureDedupCount;
+        d["textureDedupMemoryInBytes"] = stats.materials.textureDedupMemoryInBytes;
 
         // Raytracing stats
         d["blasGroupCount"] = stats.blasGroupCount;
@@ -4112,6 +4161,12 @@ namespace Falcor
         pybind11::class_<Scene, ref<Scene>> scene(m, "Scene");
 
         scene.def_property_readonly(kStats.c_str(), [](const Scene* pScene) { return toPython(pScene->getSceneStats()); });
+        scene.def_property_readonly(kBuildTimes.c_str(), [](const Scene* pScene)
+        {
+            pybind11::dict d;
+            for (const auto& [name, duration] : pScene->getBuildTimes()) d[name.c_str()] = duration;
+            return d;
+        });
         scene.def_property_readonly(kBounds.c_str(), &Scene::getSceneBounds, pybind11::return_value_policy::copy);
         scene.def_property(kCamera.c_str(), &Scene::getCamera, &Scene::setCamera);
         scene.def_property(kEnvMap.c_str(), &Scene::getEnvMap, &Scene::setEnvMap);
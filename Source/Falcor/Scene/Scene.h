@@ -493,6 +493,17 @@ namespace Falcor
         */
         const SceneStats& getSceneStats() const { return mSceneStats; }
 
+        /** Get the timings of the scene builder post-processing stages that created this scene.
+            \return List of (stage name, time in seconds) pairs. Empty if the scene was loaded from the scene cache.
+        */
+        const std::vector<std::pair<std::string, double>>& getBuildTimes() const { return mBuildTimes; }
+
+        /** Set the timings of the scene builder post-processing stages.
+            This is called by the scene builder after the scene has been created, so that the timings include all stages.
+            \param[in] buildTimes List of (stage name, time in seconds) pairs.
+        */
+        void setBuildTimes(std::vector<std::pair<std::string, double>> buildTimes) { mBuildTimes = std::move(buildTimes); }
+
         /** Get the render settings.
         */
         const RenderSettings& getRenderSettings() const { return mRenderSettings; }
@@ -1202,6 +1213,12 @@ namespace Falcor
         UpdateFlags updateGridVolumes(bool forceUpdate);
         UpdateFlags updateEnvMap(bool forceUpdate);
         UpdateFlags updateMaterials(bool forceUpdate);
+
+        /** Request texture mips for streaming based on the distance of the geometry instances to the camera.
+            Only has an effect if texture residency is enabled in the texture manager.
+        */
+        void updateTextureResidency();
+
         UpdateFlags updateGeometry(RenderContext* pRenderContext, bool forceUpdate);
         UpdateFlags updateProceduralPrimitives(bool forceUpdate);
         UpdateFlags updateRaytracingAABBData(bool forceUpdate);
@@ -1307,6 +1324,7 @@ namespace Falcor
         AABB mSceneBB;                                              ///< Bounding boxes of the entire scene in world space.
         SceneStats mSceneStats;                                     ///< Scene statistics.
         Metadata mMetadata;                                         ///< Importer-provided metadata.
+        std::vector<std::pair<std::string, double>> mBuildTimes;    ///< Timings of the scene builder post-processing stages.
         RenderSettings mRenderSettings;                             ///< Render settings.
         RenderSettings mPrevRenderSettings;
         Shader::DefineList mSceneDefines;                           ///< Current list of defines that need to be set on any program accessing the scene.
@@ -27,10 +27,14 @@
  **************************************************************************/
 #include "SceneBuilder.h"
 #include "SceneCache.h"
+#include "TangentCache.h"
 #include "Importer.h"
+#include "VertexWelder.h"
 #include "Curves/CurveConfig.h"
 #include "Material/StandardMaterial.h"
 #include "Utils/Logger.h"
+#include "Utils/CryptoUtils.h"
+#include "Utils/Threading.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Image/TextureAnalyzer.h"
 #include "Utils/Timing/TimeReport.h"
@@ -38,7 +42,10 @@
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/ObjectIDPython.h"
 #include <mikktspace.h>
+#include <atomic>
 #include <filesystem>
+#include <map>
+#include <mutex>
 #include <cmath>
 
 namespace Falcor
@@ -53,6 +60,9 @@ namespace Falcor
         // We'll log a warning if the maximum quantization error exceeds this value.
         const float kMaxTexelError = 0.5f;
 
+        // Minimum number of vertices per task when processing the vertices of a single mesh in parallel.
+        const size_t kParallelVertexGrainSize = 1ull << 14;
+
         int largestAxis(const float3& v)
         {
             if (v.x >= v.y && v.x >= v.z) return 0;
@@ -147,6 +157,54 @@ namespace Falcor
             }
         };
 
+        template<typename T>
+        void hashAttribute(SHA1& sha1, const SceneBuilder::Mesh& mesh, const SceneBuilder::Mesh::Attribute<T>& attribute)
+        {
+            sha1.update((uint32_t)attribute.frequency);
+            if (!attribute.pData) return;
+            size_t count = 0;
+            switch (attribute.frequency)
+            {
+            case SceneBuilder::Mesh::AttributeFrequency::Constant: count = 1; break;
+            case SceneBuilder::Mesh::AttributeFrequency::Uniform: count = mesh.faceCount; break;
+            case SceneBuilder::Mesh::AttributeFrequency::Vertex: count = mesh.vertexCount; break;
+            case SceneBuilder::Mesh::AttributeFrequency::FaceVarying: count = mesh.indexCount; break;
+            default: break;
+            }
+            sha1.update(attribute.pData, count * sizeof(T));
+        }
+
+        /** Compute the tangent cache key of a mesh from all mesh data that is used for tangent generation.
+        */
+        TangentCache::Key computeTangentCacheKey(const SceneBuilder::Mesh& mesh)
+        {
+            SHA1 sha1;
+            sha1.update(mesh.faceCount);
+            sha1.update(mesh.vertexCount);
+            sha1.update(mesh.indexCount);
+            sha1.update(mesh.pIndices, mesh.indexCount * sizeof(uint32_t));
+            hashAttribute(sha1, mesh, mesh.positions);
+            hashAttribute(sha1, mesh, mesh.normals);
+            hashAttribute(sha1, mesh, mesh.texCrds);
+            return sha1.finalize();
+        }
+
+        /** Copy the data of a mesh attribute and point the attribute to the copy.
+        */
+        template<typename T>
+        void copyAttribute(SceneBuilder::Mesh& mesh, SceneBuilder::Mesh::Attribute<T>& attribute, std::vector<T>& data)
+        {
+            if (attribute.pData && attribute.frequency != SceneBuilder::Mesh::AttributeFrequency::None)
+            {
+                data.assign(attribute.pData, attribute.pData + mesh.getAttributeCount(attribute));
+                attribute.pData = data.data();
+            }
+            else
+            {
+                attribute.pData = nullptr;
+            }
+        }
+
         void validateVertex(const SceneBuilder::Mesh::Vertex& v, size_t& invalidCount, size_t& zeroCount)
         {
             auto isInvalid = [](const auto& x)
@@ -162,19 +220,6 @@ namespace Falcor
             if (isZero(v.normal) || isZero(v.tangent.xyz())) zeroCount++;
         }
 
-        bool compareVertices(const SceneBuilder::Mesh::Vertex& lhs, const SceneBuilder::Mesh::Vertex& rhs, float threshold = 1e-6f)
-        {
-            if (any(lhs.position != rhs.position)) return false; // Position need to be exact to avoid cracks
-            if (lhs.tangent.w != rhs.tangent.w) return false;
-            if (lhs.curveRadius != rhs.curveRadius) return false;
-            if (any(lhs.boneIDs != rhs.boneIDs)) return false;
-            if (any(abs(lhs.normal - rhs.normal) > float3(threshold))) return false;
-            if (any(abs(lhs.tangent.xyz() - rhs.tangent.xyz()) > float3(threshold))) return false;
-            if (any(abs(lhs.texCrd - rhs.texCrd) > float2(threshold))) return false;
-            if (any(abs(lhs.boneWeights - rhs.boneWeights) > float4(threshold))) return false;
-            return true;
-        }
-
         std::vector<uint32_t> compact16BitIndices(const std::vector<uint32_t>& indices)
         {
             if (indices.empty()) return {};
@@ -191,7 +236,7 @@ namespace Falcor
 
         SceneCache::Key computeSceneCacheKey(const std::filesystem::path& path, SceneBuilder::Flags buildFlags)
         {
-            SceneBuilder::Flags cacheFlags = buildFlags & (~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache));
+            SceneBuilder::Flags cacheFlags = buildFlags & (~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache | SceneBuilder::Flags::DeferTangentGeneration));
             SHA1 sha1;
             auto pathStr = path.string();
             sha1.update(pathStr.data(), pathStr.size());
@@ -208,6 +253,26 @@ namespace Falcor
     {
         mpFence = GpuFence::create(mpDevice);
         mSceneData.pMaterials = std::make_unique<MaterialSystem>(mpDevice);
+
+        // Stream texture mips under a memory budget if requested.
+        if (auto budgetMB = mSettings.getOption<uint64_t>("TextureResidency:budgetMB"))
+        {
+            TextureResidency::Options options;
+            options.budgetInBytes = *budgetMB << 20;
+            uint64_t maxStreamInMB = mSettings.getOption<uint64_t>("TextureResidency:maxStreamInMB", options.maxStreamInBytesPerUpdate >> 20);
+            options.maxStreamInBytesPerUpdate = maxStreamInMB << 20;
+            options.mipTailDimension = mSettings.getOption<uint32_t>("TextureResidency:mipTailDimension", options.mipTailDimension);
+            mSceneData.pMaterials->getTextureManager().enableResidency(options);
+        }
+
+        // Load textures from block-compressed files baked to a persistent cache if requested.
+        if (mSettings.getOption<bool>("TextureBaker:enabled", false))
+        {
+            TextureBaker::Options options;
+            options.cacheDirectory = mSettings.getOption<std::string>("TextureBaker:cacheDirectory", "");
+            options.compactColor = mSettings.getOption<bool>("TextureBaker:compactColor", options.compactColor);
+            mSceneData.pMaterials->getTextureManager().enableTextureBaking(options);
+        }
     }
 
     SceneBuilder::SceneBuilder(ref<Device> pDevice, const std::filesystem::path& path, const Settings& settings, Flags buildFlags)
@@ -256,6 +321,7 @@ namespace Falcor
         }
 
         mSceneData.path = fullPath;
+        addDependency(fullPath);
         if (auto importer = Importer::create(getExtensionFromPath(fullPath)))
         {
             importer->importScene(fullPath, *this, dict);
@@ -266,6 +332,13 @@ namespace Falcor
         }
     }
 
+    void SceneBuilder::addDependency(const std::filesystem::path& path)
+    {
+        if (path.empty()) return;
+        std::lock_guard<std::mutex> lock(mDependenciesMutex);
+        mDependencies.push_back(std::filesystem::absolute(path));
+    }
+
     ref<Scene> SceneBuilder::getScene()
     {
         if (mpScene) return mpScene;
@@ -273,6 +346,9 @@ namespace Falcor
         // Finish loading textures. This blocks until all textures are loaded and assigned.
         mpMaterialTextureLoader.reset();
 
+        // Register the loaded textures as scene cache dependencies before any stage removes or replaces them.
+        if (mWriteSceneCache) addTextureDependencies();
+
         // If no meshes were added, we create a dummy mesh to keep the scene generation working.
         // Scenes with no meshes can be useful for example when using volumes in isolation.
         if (mMeshes.empty())
@@ -288,42 +364,48 @@ namespace Falcor
         }
 
         // Post-process the scene data.
-        TimeReport timeReport;
+        // Each stage is timed individually. The results are available through getTimeReport().
+        mTimeReport.reset();
+        auto runStage = [this](const std::string& name, void (SceneBuilder::*stage)())
+        {
+            (this->*stage)();
+            mTimeReport.measure(name);
+        };
+
+        // Process meshes that were deferred in addMesh(). This generates their tangents in parallel.
+        runStage("processDeferredMeshes", &SceneBuilder::processDeferredMeshes);
 
         // Prepare displacement maps. This either removes them (if requested in build flags)
         // or makes sure that normal maps are removed if displacement is in use.
-        prepareDisplacementMaps();
-
-        prepareSceneGraph();
-        prepareMeshes();
-        removeUnusedMeshes();
-        flattenStaticMeshInstances();
-        pretransformStaticMeshes();
-        unifyTriangleWinding();
-        optimizeSceneGraph();
-        calculateMeshBoundingBoxes();
-        createMeshGroups();
-        optimizeGeometry();
-        sortMeshes();
-        createGlobalBuffers();
-        createCurveGlobalBuffers();
-        collectVolumeGrids();
-        removeDuplicateSDFGrids();
-
-        timeReport.measure("Post processing geometry");
-
-        optimizeMaterials();
-        removeDuplicateMaterials();
-        quantizeTexCoords();
-
-        timeReport.measure("Optimizing materials");
+        runStage("prepareDisplacementMaps", &SceneBuilder::prepareDisplacementMaps);
+
+        runStage("prepareSceneGraph", &SceneBuilder::prepareSceneGraph);
+        runStage("prepareMeshes", &SceneBuilder::prepareMeshes);
+        runStage("removeUnusedMeshes", &SceneBuilder::removeUnusedMeshes);
+        runStage("flattenStaticMeshInstances", &SceneBuilder::flattenStaticMeshInstances);
+        runStage("pretransformStaticMeshes", &SceneBuilder::pretransformStaticMeshes);
+        runStage("unifyTriangleWinding", &SceneBuilder::unifyTriangleWinding);
+        runStage("optimizeSceneGraph", &SceneBuilder::optimizeSceneGraph);
+        runStage("calculateMeshBoundingBoxes", &SceneBuilder::calculateMeshBoundingBoxes);
+        runStage("createMeshGroups", &SceneBuilder::createMeshGroups);
+        runStage("optimizeGeometry", &SceneBuilder::optimizeGeometry);
+        runStage("sortMeshes", &SceneBuilder::sortMeshes);
+        runStage("createGlobalBuffers", &SceneBuilder::createGlobalBuffers);
+        runStage("createCurveGlobalBuffers", &SceneBuilder::createCurveGlobalBuffers);
+        runStage("collectVolumeGrids", &SceneBuilder::collectVolumeGrids);
+        runStage("removeDuplicateSDFGrids", &SceneBuilder::removeDuplicateSDFGrids);
+
+        runStage("optimizeMaterials", &SceneBuilder::optimizeMaterials);
+        runStage("removeDuplicateMaterials", &SceneBuilder::removeDuplicateMaterials);
+        runStage("quantizeTexCoords", &SceneBuilder::quantizeTexCoords);
+        runStage("compressAnimations", &SceneBuilder::compressAnimations);
 
         // Prepare scene resources.
-        createSceneGraph();
-        createMeshData();
-        createMeshBoundingBoxes();
-        createCurveData();
-        calculateCurveBoundingBoxes();
+        runStage("createSceneGraph", &SceneBuilder::createSceneGraph);
+        runStage("createMeshData", &SceneBuilder::createMeshData);
+        runStage("createMeshBoundingBoxes", &SceneBuilder::createMeshBoundingBoxes);
+        runStage("createCurveData", &SceneBuilder::createCurveData);
+        runStage("calculateCurveBoundingBoxes", &SceneBuilder::calculateCurveBoundingBoxes);
 
         // Create instance data.
         uint32_t tlasInstanceIndex = 0;
@@ -333,20 +415,25 @@ namespace Falcor
         for (auto& sdfInstanceData : mSceneData.sdfGridInstances) sdfInstanceData.instanceIndex = tlasInstanceIndex++;
 
         mSceneData.useCompressedHitInfo = is_set(mFlags, Flags::UseCompressedHitInfo);
+        mTimeReport.measure("createInstanceData");
 
         // Write scene cache if requested.
         if (mWriteSceneCache)
         {
-            SceneCache::writeCache(mSceneData, mSceneCacheKey);
-            timeReport.measure("Writing cache");
+            SceneCache::writeCache(mSceneData, mSceneCacheKey, createSceneCacheManifest());
+            mTimeReport.measure("writeCache");
         }
 
         // Create the scene object.
         mpScene = Scene::create(mpDevice, std::move(mSceneData));
         mSceneData = {};
 
-        timeReport.measure("Creating resources");
-        timeReport.printToLog();
+        mTimeReport.measure("createScene");
+        mTimeReport.addTotal();
+        mTimeReport.printToLog();
+
+        // Pass the timings to the scene after the last stage, so that they include scene creation and the total.
+        mpScene->setBuildTimes(mTimeReport.getMeasurements());
 
         return mpScene;
     }
@@ -355,7 +442,45 @@ namespace Falcor
 
     MeshID SceneBuilder::addMesh(const Mesh& mesh)
     {
-        return addProcessedMesh(processMesh(mesh));
+        const bool needsTangents = !(is_set(mFlags, Flags::UseOriginalTangentSpace) || mesh.useOriginalTangentSpace) || !mesh.tangents.pData;
+        if (!is_set(mFlags, Flags::DeferTangentGeneration) || !needsTangents)
+        {
+            return addProcessedMesh(processMesh(mesh));
+        }
+
+        // Defer processing to getScene(). The caller retains the ownership of the mesh data, so we need to copy it.
+        checkArgument(mesh.pMaterial != nullptr, "The mesh '{}' is missing a material", mesh.name);
+        checkArgument(mesh.pIndices != nullptr, "The mesh '{}' is missing indices", mesh.name);
+
+        DeferredMesh& deferred = *mDeferredMeshes.emplace_back(std::make_unique<DeferredMesh>());
+        deferred.mesh = mesh;
+        deferred.indices.assign(mesh.pIndices, mesh.pIndices + mesh.indexCount);
+        deferred.mesh.pIndices = deferred.indices.data();
+        copyAttribute(deferred.mesh, deferred.mesh.positions, deferred.positions);
+        copyAttribute(deferred.mesh, deferred.mesh.normals, deferred.normals);
+        copyAttribute(deferred.mesh, deferred.mesh.tangents, deferred.tangents);
+        copyAttribute(deferred.mesh, deferred.mesh.texCrds, deferred.texCrds);
+        copyAttribute(deferred.mesh, deferred.mesh.curveRadii, deferred.curveRadii);
+        copyAttribute(deferred.mesh, deferred.mesh.boneIDs, deferred.boneIDs);
+        copyAttribute(deferred.mesh, deferred.mesh.boneWeights, deferred.boneWeights);
+
+        // Add a placeholder mesh that is replaced in processDeferredMeshes().
+        // The material is added now to keep the material IDs the same as without deferred processing.
+        MeshSpec spec;
+        spec.name = mesh.name;
+        spec.topology = mesh.topology;
+        spec.materialId = addMaterial(mesh.pMaterial);
+        spec.isFrontFaceCW = mesh.isFrontFaceCW;
+        spec.skeletonNodeID = mesh.skeletonNodeId;
+        mMeshes.push_back(spec);
+
+        if (mMeshes.size() > std::numeric_limits<uint32_t>::max())
+        {
+            throw RuntimeError("Trying to build a scene that exceeds supported number of meshes");
+        }
+
+        deferred.meshID = MeshID(mMeshes.size() - 1);
+        return deferred.meshID;
     }
 
     MeshID SceneBuilder::addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial)
@@ -475,17 +600,9 @@ namespace Falcor
         }
 
         // Build new vertex/index buffers by merging identical vertices.
-        // The search is based on the topology defined by the original index buffer.
-        //
-        // A linked-list of vertices is built for each original vertex index.
-        // We iterate over all vertices and first check if a vertex is identical to any of the other vertices
-        // using the same original vertex index. If not, a new vertex is inserted and added to the list.
-        // The 'heads' array point to the first vertex in each list, and each vertex has an associated next-pointer.
-        // This ensures that adding to the linked lists do not require any dynamic memory allocation.
-        //
-        const uint32_t invalidIndex = 0xffffffff;
-        std::vector<std::pair<Mesh::Vertex, uint32_t>> vertices;
-        std::vector<uint32_t> indices(mesh.indexCount);
+        // The search is based on the topology defined by the original index buffer, see VertexWelder.
+        std::vector<Mesh::Vertex> vertices;
+        std::vector<uint32_t> indices;
 
         if (pAttributeIndices)
         {
@@ -494,56 +611,22 @@ namespace Falcor
 
         if (mesh.mergeDuplicateVertices)
         {
-            vertices.reserve(mesh.vertexCount);
+            VertexWelder::Result result = VertexWelder::weld(mesh, VertexWelder::Mode::ParallelHash);
+            vertices = std::move(result.vertices);
+            indices = std::move(result.indices);
 
-            std::vector<uint32_t> heads(mesh.vertexCount, invalidIndex);
-
-            for (uint32_t face = 0; face < mesh.faceCount; face++)
+            if (pAttributeIndices)
             {
-                for (uint32_t vert = 0; vert < 3; vert++)
+                for (uint32_t corner : result.corners)
                 {
-                    const Mesh::Vertex v = mesh.getVertex(face, vert);
-                    const uint32_t origIndex = mesh.pIndices[face * 3 + vert];
-
-                    // Iterate over vertex list to check if it already exists.
-                    FALCOR_ASSERT(origIndex < heads.size());
-                    uint32_t index = heads[origIndex];
-                    bool found = false;
-
-                    while (index != invalidIndex)
-                    {
-                        if (compareVertices(v, vertices[index].first))
-                        {
-                            found = true;
-                            break;
-                        }
-                        index = vertices[index].second;
-                    }
-
-                    // Insert new vertex if we couldn't find it.
-                    if (!found)
-                    {
-                        FALCOR_ASSERT(vertices.size() < std::numeric_limits<uint32_t>::max());
-                        index = (uint32_t)vertices.size();
-                        vertices.push_back({ v, heads[origIndex] });
-
-                        if (pAttributeIndices)
-                        {
-                            pAttributeIndices->push_back(mesh.getAttributeIndices(face, vert));
-                            FALCOR_ASSERT(vertices.size() == pAttributeIndices->size());
-                        }
-
-                        heads[origIndex] = index;
-                    }
-
-                    // Store new vertex index.
-                    indices[face * 3 + vert] = index;
+                    pAttributeIndices->push_back(mesh.getAttributeIndices(corner / 3, corner % 3));
                 }
+                FALCOR_ASSERT(vertices.size() == pAttributeIndices->size());
             }
         }
         else
         {
-            vertices = { mesh.vertexCount, std::make_pair(Mesh::Vertex{}, invalidIndex) };
+            vertices.resize(mesh.vertexCount);
 
             for (uint32_t face = 0; face < mesh.faceCount; face++)
             {
@@ -553,7 +636,7 @@ namespace Falcor
                     const uint32_t index = mesh.getAttributeIndex(mesh.positions, face, vert);
 
                     FALCOR_ASSERT(index < vertices.size());
-                    vertices[index].first = v;
+                    vertices[index] = v;
 
                     if (pAttributeIndices)
                     {
@@ -582,7 +665,7 @@ namespace Falcor
         size_t zeroCount = 0;
         for (const auto& v : vertices)
         {
-            validateVertex(v.first, invalidCount, zeroCount);
+            validateVertex(v, invalidCount, zeroCount);
         }
         if (invalidCount > 0) logWarning("The mesh '{}' has inf/nan vertex attributes at {} vertices. Please fix the asset.", mesh.name, invalidCount);
         if (zeroCount > 0) logWarning("The mesh '{}' has zero-length normals/tangents at {} vertices. Please fix the asset.", mesh.name, zeroCount);
@@ -609,7 +692,7 @@ namespace Falcor
         {
             uint32_t index = isIndexed ? i : indices[i];
             FALCOR_ASSERT(index < vertices.size());
-            const Mesh::Vertex& v = vertices[index].first;
+            const Mesh::Vertex& v = vertices[index];
 
             {
                 StaticVertexData s;
@@ -638,7 +721,16 @@ namespace Falcor
 
     void SceneBuilder::generateTangents(Mesh& mesh, std::vector<float4>& tangents) const
     {
-        tangents = MikkTSpaceWrapper::generateTangents(mesh);
+        // Reuse previously generated tangents if the same mesh data was seen before.
+        // Entries are also persisted next to the scene cache if scene caching is enabled.
+        const bool hasInputs = mesh.normals.pData && mesh.positions.pData && mesh.texCrds.pData && mesh.pIndices;
+        const bool persistent = is_set(mFlags, Flags::UseCache);
+        const TangentCache::Key key = hasInputs ? computeTangentCacheKey(mesh) : TangentCache::Key{};
+        if (!hasInputs || !TangentCache::get().lookup(key, tangents, persistent))
+        {
+            tangents = MikkTSpaceWrapper::generateTangents(mesh);
+            if (hasInputs && !tangents.empty()) TangentCache::get().insert(key, tangents, persistent);
+        }
         if (!tangents.empty())
         {
             FALCOR_ASSERT(tangents.size() == mesh.indexCount);
@@ -653,6 +745,18 @@ namespace Falcor
     }
 
     MeshID SceneBuilder::addProcessedMesh(const ProcessedMesh& mesh)
+    {
+        mMeshes.push_back(createMeshSpec(mesh));
+
+        if (mMeshes.size() > std::numeric_limits<uint32_t>::max())
+        {
+            throw RuntimeError("Trying to build a scene that exceeds supported number of meshes");
+        }
+
+        return MeshID(mMeshes.size() - 1);
+    }
+
+    SceneBuilder::MeshSpec SceneBuilder::createMeshSpec(const ProcessedMesh& mesh)
     {
         const bool isIndexed = !is_set(mFlags, Flags::NonIndexedVertices);
 
@@ -686,14 +790,7 @@ namespace Falcor
             spec.prevVertexCount = spec.skinningVertexCount;
         }
 
-        mMeshes.push_back(spec);
-
-        if (mMeshes.size() > std::numeric_limits<uint32_t>::max())
-        {
-            throw RuntimeError("Trying to build a scene that exceeds supported number of meshes");
-        }
-
-        return MeshID(mMeshes.size() - 1);
+        return spec;
     }
 
     void SceneBuilder::setCachedMeshes(std::vector<CachedMesh>&& cachedMeshes)
@@ -840,6 +937,11 @@ namespace Falcor
     void SceneBuilder::loadMaterialTexture(const ref<Material>& pMaterial, Material::TextureSlot slot, const std::filesystem::path& path)
     {
         checkArgument(pMaterial != nullptr, "'pMaterial' is missing");
+
+        // Register the requested file even if it doesn't exist, so that adding it later invalidates the scene cache.
+        std::filesystem::path fullPath;
+        addDependency(findFileInDataDirectories(path, fullPath) ? fullPath : path);
+
         if (!mpMaterialTextureLoader)
         {
             mpMaterialTextureLoader.reset(new MaterialTextureLoader(mSceneData.pMaterials->getTextureManager(), !is_set(mFlags, Flags::AssumeLinearSpaceTextures)));
@@ -1216,6 +1318,31 @@ namespace Falcor
         return true;
     }
 
+    void SceneBuilder::processDeferredMeshes()
+    {
+        if (mDeferredMeshes.empty()) return;
+
+        // Generate tangents and process the meshes in parallel.
+        // processMesh() is thread safe and produces the same result as when called from addMesh().
+        std::vector<ProcessedMesh> processedMeshes(mDeferredMeshes.size());
+        Threading::parallelFor(0, mDeferredMeshes.size(), [&](size_t i)
+        {
+            processedMeshes[i] = processMesh(mDeferredMeshes[i]->mesh);
+        });
+
+        // Replace the placeholder meshes. Instances were already added to the placeholders.
+        for (size_t i = 0; i < mDeferredMeshes.size(); i++)
+        {
+            MeshSpec& mesh = mMeshes[mDeferredMeshes[i]->meshID.get()];
+            MeshSpec spec = createMeshSpec(processedMeshes[i]);
+            spec.instances = std::move(mesh.instances);
+            mesh = std::move(spec);
+        }
+
+        logInfo("Processed {} meshes with deferred tangent generation.", mDeferredMeshes.size());
+        mDeferredMeshes.clear();
+    }
+
     void SceneBuilder::prepareDisplacementMaps()
     {
         for (const auto& pMaterial : mSceneData.pMaterials->getMaterials())
@@ -1552,7 +1679,8 @@ namespace Falcor
         NodeID identityNodeID = addNode(Node{ "Identity", float4x4::identity(), float4x4::identity() });
         auto& identityNode = mSceneGraph[identityNodeID.get()];
 
-        size_t transformedMeshCount = 0;
+        // Meshes whose vertices need to be transformed. The vertex data is transformed in parallel after the scene graph is updated.
+        std::vector<std::pair<MeshID, float4x4>> transformedMeshes;
         for (MeshID meshID{ 0 }; meshID.get() < (uint32_t)mMeshes.size(); ++meshID)
         {
             auto& mesh = mMeshes[meshID.get()];
@@ -1586,22 +1714,7 @@ namespace Falcor
             {
                 FALCOR_ASSERT(!mesh.staticData.empty());
                 FALCOR_ASSERT((size_t)mesh.vertexCount == mesh.staticData.size());
-
-                float3x3 invTranspose3x3 = float3x3(transpose(inverse(transform)));
-                float3x3 transform3x3 = float3x3(transform);
-
-                for (auto& v : mesh.staticData)
-                {
-                    v.position = transformPoint(transform, v.position);
-                    v.normal = normalize(transformVector(invTranspose3x3, v.normal));
-                    v.tangent = float4(normalize(transformVector(transform3x3, v.tangent.xyz())), v.tangent.w);
-                    // TODO: We should flip the sign of v.tangent.w if flippedWinding is true.
-                    // Leaving that out for now for consistency with the shader code that needs the same fix.
-
-                    v.curveRadius = length(transformVector(transform3x3, float3(v.curveRadius, 0.f, 0.f)));
-                }
-
-                transformedMeshCount++;
+                transformedMeshes.emplace_back(meshID, transform);
             }
 
             // Unlink mesh from its previous transform node.
@@ -1618,7 +1731,56 @@ namespace Falcor
             mesh.instances.insert(identityNodeID);
         }
 
-        if (transformedMeshCount > 0) logInfo("Pre-transformed {} static meshes to world space.", transformedMeshCount);
+        // Transform the vertex data. Meshes and vertex ranges are independent so this is done in parallel.
+        Threading::parallelFor(0, transformedMeshes.size(), [&](size_t i)
+        {
+            const auto& [meshID, transform] = transformedMeshes[i];
+            auto& staticData = mMeshes[meshID.get()].staticData;
+
+            float3x3 invTranspose3x3 = float3x3(transpose(inverse(transform)));
+            float3x3 transform3x3 = float3x3(transform);
+
+            Threading::parallelForRange(0, staticData.size(), [&](size_t begin, size_t end)
+            {
+                for (size_t j = begin; j < end; ++j)
+                {
+                    auto& v = staticData[j];
+                    v.position = transformPoint(transform, v.position);
+                    v.normal = normalize(transformVector(invTranspose3x3, v.normal));
+                    v.tangent = float4(normalize(transformVector(transform3x3, v.tangent.xyz())), v.tangent.w);
+                    // TODO: We should flip the sign of v.tangent.w if flippedWinding is true.
+                    // Leaving that out for now for consistency with the shader code that needs the same fix.
+
+                    v.curveRadius = length(transformVector(transform3x3, float3(v.curveRadius, 0.f, 0.f)));
+                }
+            }, kParallelVertexGrainSize);
+        });
+
+        if (!transformedMeshes.empty()) logInfo("Pre-transformed {} static meshes to world space.", transformedMeshes.size());
+    }
+
+    void SceneBuilder::addTextureDependencies()
+    {
+        auto addTexture = [&](const ref<Texture>& pTexture)
+        {
+            if (pTexture) addDependency(pTexture->getSourcePath());
+        };
+
+        for (const auto& pMaterial : mSceneData.pMaterials->getMaterials())
+        {
+            for (uint32_t i = 0; i < (uint32_t)Material::TextureSlot::Count; i++)
+            {
+                addTexture(pMaterial->getTexture((Material::TextureSlot)i));
+            }
+        }
+        if (mSceneData.pEnvMap) addTexture(mSceneData.pEnvMap->getEnvMap());
+    }
+
+    SceneCache::Manifest SceneBuilder::createSceneCacheManifest()
+    {
+        // Hashing file contents is optional as it can be slow for large scenes.
+        bool hashContents = mSettings.getOption("SceneCache:hashContents", false);
+        return SceneCache::createManifest(mDependencies, hashContents);
     }
 
     void SceneBuilder::flipTriangleWinding(MeshSpec& mesh)
@@ -1686,27 +1848,28 @@ namespace Falcor
         // Note that this pass needs to run *after* pre-transformation of static meshes to world space,
         // as those transforms may flip the winding.
 
-        size_t flippedMeshCount = 0;
-        for (uint32_t meshID = 0; meshID < (uint32_t)mMeshes.size(); meshID++)
+        std::atomic<size_t> flippedMeshCount = 0;
+        Threading::parallelFor(0, mMeshes.size(), [&](size_t meshID)
         {
             auto& mesh = mMeshes[meshID];
 
             // Skip meshes that are already front face counter-clockwise.
-            if (mesh.isFrontFaceCW == false) continue;
+            if (mesh.isFrontFaceCW == false) return;
 
             flipTriangleWinding(mesh);
             FALCOR_ASSERT(!mesh.isFrontFaceCW);
 
             flippedMeshCount++;
-        }
+        });
 
-        if (flippedMeshCount > 0) logInfo("Flipped triangle winding for {} out of {} meshes.", flippedMeshCount, mMeshes.size());
+        if (flippedMeshCount > 0) logInfo("Flipped triangle winding for {} out of {} meshes.", flippedMeshCount.load(), mMeshes.size());
     }
 
     void SceneBuilder::calculateMeshBoundingBoxes()
     {
-        for (auto& mesh : mMeshes)
+        Threading::parallelFor(0, mMeshes.size(), [&](size_t meshID)
         {
+            auto& mesh = mMeshes[meshID];
             FALCOR_ASSERT(!mesh.staticData.empty());
             FALCOR_ASSERT((size_t)mesh.vertexCount == mesh.staticData.size());
 
@@ -1717,7 +1880,7 @@ namespace Falcor
             }
 
             mesh.boundingBox = meshBB;
-        }
+        });
     }
 
     void SceneBuilder::createMeshGroups()
@@ -2311,31 +2474,56 @@ namespace Falcor
             throw RuntimeError("Trying to build a scene that exceeds supported mesh data size.");
         }
 
-        mSceneData.meshIndexData.reserve(totalIndexDataCount);
-        mSceneData.meshStaticData.reserve(totalStaticVertexCount);
-        mSceneData.meshSkinningData.reserve(totalSkinningVertexCount);
-
-        // Copy all vertex and index data into the global buffers.
+        // Compute the offsets of all meshes into the global buffers.
+        uint32_t indexDataOffset = 0;
+        uint32_t staticVertexOffset = 0;
+        uint32_t skinningVertexOffset = 0;
         for (auto& mesh : mMeshes)
         {
-            mesh.staticVertexOffset = (uint32_t)mSceneData.meshStaticData.size();
-            mesh.skinningVertexOffset = (uint32_t)mSceneData.meshSkinningData.size();
+            mesh.staticVertexOffset = staticVertexOffset;
+            mesh.skinningVertexOffset = skinningVertexOffset;
             mesh.prevVertexOffset = mesh.skinningVertexOffset;
-
-            // Insert the static vertex data in the global array.
-            // The vertices are automatically converted to their packed format in this step.
-            mSceneData.meshStaticData.insert(mSceneData.meshStaticData.end(), mesh.staticData.begin(), mesh.staticData.end());
+            staticVertexOffset += (uint32_t)mesh.staticData.size();
 
             if (isIndexed)
             {
-                mesh.indexOffset = (uint32_t)mSceneData.meshIndexData.size();
-                mSceneData.meshIndexData.insert(mSceneData.meshIndexData.end(), mesh.indexData.begin(), mesh.indexData.end());
+                mesh.indexOffset = indexDataOffset;
+                indexDataOffset += (uint32_t)mesh.indexData.size();
             }
 
             if (mesh.isSkinned())
             {
                 FALCOR_ASSERT(!mesh.skinningData.empty());
-                mSceneData.meshSkinningData.insert(mSceneData.meshSkinningData.end(), mesh.skinningData.begin(), mesh.skinningData.end());
+                skinningVertexOffset += (uint32_t)mesh.skinningData.size();
+            }
+        }
+
+        mSceneData.meshIndexData.resize(indexDataOffset);
+        mSceneData.meshStaticData.resize(staticVertexOffset);
+        mSceneData.meshSkinningData.resize(skinningVertexOffset);
+
+        // Copy all vertex and index data into the global buffers.
+        // Each mesh writes to its own precomputed range, so this is done in parallel.
+        Threading::parallelFor(0, mMeshes.size(), [&](size_t meshID)
+        {
+            auto& mesh = mMeshes[meshID];
+
+            // Copy the static vertex data to the global array.
+            // The vertices are converted to their packed format in this step.
+            Threading::parallelForRange(0, mesh.staticData.size(), [&](size_t begin, size_t end)
+            {
+                PackedStaticVertexData* pDst = mSceneData.meshStaticData.data() + mesh.staticVertexOffset;
+                for (size_t i = begin; i < end; ++i) pDst[i].pack(mesh.staticData[i]);
+            }, kParallelVertexGrainSize);
+
+            if (isIndexed)
+            {
+                std::copy(mesh.indexData.begin(), mesh.indexData.end(), mSceneData.meshIndexData.begin() + mesh.indexOffset);
+            }
+
+            if (mesh.isSkinned())
+            {
+                std::copy(mesh.skinningData.begin(), mesh.skinningData.end(), mSceneData.meshSkinningData.begin() + mesh.skinningVertexOffset);
 
                 // Patch vertex index references.
                 for (uint32_t i = 0; i < mesh.skinningData.size(); ++i)
@@ -2345,10 +2533,10 @@ namespace Falcor
             }
 
             // Free the mesh local data.
-            mesh.indexData.clear();
-            mesh.staticData.clear();
-            mesh.skinningData.clear();
-        }
+            mesh.indexData = {};
+            mesh.staticData = {};
+            mesh.skinningData = {};
+        });
 
         // Initialize offsets for prev vertex data for vertex-animated meshes
         uint32_t prevOffset = (uint32_t)mSceneData.meshSkinningData.size();
@@ -2469,8 +2657,11 @@ namespace Falcor
         // Match texture coordinate quantization for textured emissives to format of PackedEmissiveTriangle.
         // This is to avoid mismatch when sampling and evaluating emissive triangles.
         // Note that non-emissive meshes are unmodified and use full precision texcoords.
-        for (auto& mesh : mMeshes)
+        // Meshes are processed in parallel. Warnings are collected per mesh and logged in mesh order afterwards.
+        std::vector<std::string> warnings(mMeshes.size());
+        Threading::parallelFor(0, mMeshes.size(), [&](size_t meshID)
         {
+            const auto& mesh = mMeshes[meshID];
             const auto& pMaterial = mSceneData.pMaterials->getMaterial(mesh.materialId)->toBasicMaterial();
             if (pMaterial && pMaterial->getEmissiveTexture() != nullptr)
             {
@@ -2493,7 +2684,7 @@ namespace Falcor
                 float2 maxAbsCrd = max(abs(minTexCrd), abs(maxTexCrd));
                 if (maxAbsCrd.x > HLF_MAX || maxAbsCrd.y > HLF_MAX)
                 {
-                    logWarning("Texture coordinates for emissive textured mesh '{}' are outside the representable range, expect rendering errors.", mesh.name);
+                    warnings[meshID] = fmt::format("Texture coordinates for emissive textured mesh '{}' are outside the representable range, expect rendering errors.", mesh.name);
                 }
                 else
                 {
@@ -2505,7 +2696,7 @@ namespace Falcor
 
                     if (maxTexelError > kMaxTexelError)
                     {
-                        logWarning(
+                        warnings[meshID] = fmt::format(
                             "Texture coordinates for emissive textured mesh '{}' have a large quantization error of {} texels."
                             "The coordinate range is [{},{}] x [{},{}] for maximum texture dimensions ({},{}).",
                             mesh.name, maxTexelError,
@@ -2514,9 +2705,25 @@ namespace Falcor
                     }
                 }
             }
+        });
+
+        for (const auto& warning : warnings)
+        {
+            if (!warning.empty()) logWarning(warning);
         }
     }
 
+    void SceneBuilder::compressAnimations()
+    {
+        if (!is_set(mFlags, Flags::CompressAnimations)) return;
+
+        // Animations are compressed independently in parallel.
+        Threading::parallelFor(0, mSceneData.animations.size(), [&](size_t i)
+        {
+            if (!mSceneData.animations[i]->isCompressed()) mSceneData.animations[i]->compress();
+        });
+    }
+
     void SceneBuilder::removeDuplicateSDFGrids()
     {
         // Removes duplicate SDF grids.
@@ -2837,6 +3044,8 @@ namespace Falcor
         flags.value("DontUseDisplacement", SceneBuilder::Flags::DontUseDisplacement);
         flags.value("UseCompressedHitInfo", SceneBuilder::Flags::UseCompressedHitInfo);
         flags.value("TessellateCurvesIntoPolyTubes", SceneBuilder::Flags::TessellateCurvesIntoPolyTubes);
+        flags.value("DeferTangentGeneration", SceneBuilder::Flags::DeferTangentGeneration);
+        flags.value("CompressAnimations", SceneBuilder::Flags::CompressAnimations);
         flags.value("UseCache", SceneBuilder::Flags::UseCache);
         flags.value("RebuildCache", SceneBuilder::Flags::RebuildCache);
         ScriptBindings::addEnumBinaryOperators(flags);
@@ -2860,6 +3069,7 @@ namespace Falcor
         sceneBuilder.def("replaceMaterial", &SceneBuilder::replaceMaterial, "material"_a, "replacement"_a);
         sceneBuilder.def("getMaterial", &SceneBuilder::getMaterial, "name"_a);
         sceneBuilder.def("loadMaterialTexture", &SceneBuilder::loadMaterialTexture, "material"_a, "slot"_a, "path"_a);
+        sceneBuilder.def("addDependency", &SceneBuilder::addDependency, "path"_a);
         sceneBuilder.def("waitForMaterialTextureLoading", &SceneBuilder::waitForMaterialTextureLoading);
         sceneBuilder.def("addGridVolume", &SceneBuilder::addGridVolume, "gridVolume"_a, "nodeID"_a = NodeID::kInvalidID);
         sceneBuilder.def("addVolume", &SceneBuilder::addGridVolume, "gridVolume"_a, "nodeID"_a = NodeID::kInvalidID); // PYTHONDEPRECATED
@@ -41,11 +41,13 @@
 #include "Utils/Math/Vector.h"
 #include "Utils/Math/Matrix.h"
 #include "Utils/Settings.h"
+#include "Utils/Timing/TimeReport.h"
 
 #include <pybind11/pytypes.h>
 
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -76,6 +78,8 @@ namespace Falcor
             DontUseDisplacement             = 0x4000,   ///< Don't use displacement mapping.
             UseCompressedHitInfo            = 0x8000,   ///< Use compressed hit info (on scenes with triangle meshes only).
             TessellateCurvesIntoPolyTubes   = 0x10000,  ///< Tessellate curves into poly-tubes (the default is linear swept spheres).
+            DeferTangentGeneration          = 0x20000,  ///< Defer processing of meshes that need tangent generation from addMesh() to getScene(), where the tangents for all meshes are generated in parallel.
+            CompressAnimations              = 0x40000,  ///< Store animation keyframes as compressed animation clips. Keyframes are quantized within a small error bound, which reduces memory use for long animations.
 
             UseCache                        = 0x10000000, ///< Enable scene caching. This caches the runtime scene representation on disk to reduce load time.
             RebuildCache                    = 0x20000000, ///< Rebuild scene cache.
@@ -341,11 +345,25 @@ namespace Falcor
         */
         void import(const std::filesystem::path& path, const pybind11::dict& dict = pybind11::dict());
 
+        /** Register an input file the scene depends on.
+            The files are recorded in the scene cache manifest, and the cache is invalidated if any of them changes.
+            Imported scene files and material textures are registered automatically. Importers should register any
+            other files they read (e.g. included files or external geometry).
+            This function is thread safe.
+            \param path The file path.
+        */
+        void addDependency(const std::filesystem::path& path);
+
         /** Get the scene. Make sure to add all the objects before calling this function
             \return nullptr if something went wrong, otherwise a new Scene object
         */
         ref<Scene> getScene();
 
+        /** Get the timing breakdown of the last call to getScene().
+            There is one measurement per post-processing stage.
+        */
+        const TimeReport& getTimeReport() const { return mTimeReport; }
+
         const ref<Device>& getDevice() const { return mpDevice; }
 
         const Settings& getSettings() const { return mSettings; }
@@ -383,6 +401,8 @@ namespace Falcor
 
         /** Add a mesh.
             Throws an exception if something went wrong.
+            If the DeferTangentGeneration flag is set and the mesh needs tangent generation, the mesh data is copied
+            and processing is deferred to getScene(). Errors in the mesh data are then reported from getScene().
             \param mesh The mesh to add.
             \return The ID of the mesh in the scene. Note that all of the instances share the same mesh ID.
         */
@@ -724,6 +744,23 @@ namespace Falcor
             std::vector<StaticCurveVertexData> staticData;
         };
 
+        /** Mesh whose processing is deferred to getScene(), see Flags::DeferTangentGeneration.
+            The mesh description references the data owned by this struct.
+        */
+        struct DeferredMesh
+        {
+            MeshID meshID;
+            Mesh mesh;
+            std::vector<uint32_t> indices;
+            std::vector<float3> positions;
+            std::vector<float3> normals;
+            std::vector<float4> tangents;
+            std::vector<float2> texCrds;
+            std::vector<float> curveRadii;
+            std::vector<uint4> boneIDs;
+            std::vector<float4> boneWeights;
+        };
+
         using SceneGraph = std::vector<InternalNode>;
         using MeshList = std::vector<MeshSpec>;
         using MeshGroup = Scene::MeshGroup;
@@ -740,10 +777,13 @@ namespace Falcor
         ref<Scene> mpScene;
         SceneCache::Key mSceneCacheKey;
         bool mWriteSceneCache = false;  ///< True if scene cache should be written after import.
+        std::vector<std::filesystem::path> mDependencies; ///< Input files for the scene cache manifest.
+        std::mutex mDependenciesMutex;
 
         SceneGraph mSceneGraph;
 
         MeshList mMeshes;
+        std::vector<std::unique_ptr<DeferredMesh>> mDeferredMeshes; ///< Meshes whose processing is deferred to getScene().
         MeshGroupList mMeshGroups; ///< Groups of meshes. Each group represents all the geometries in a BLAS for ray tracing.
 
         CurveList mCurves;
@@ -751,12 +791,16 @@ namespace Falcor
         std::unique_ptr<MaterialTextureLoader> mpMaterialTextureLoader;
         ref<GpuFence> mpFence;
 
+        TimeReport mTimeReport;    ///< Per-stage timings of the post-processing in getScene().
+
         // Helpers
         bool doesNodeHaveAnimation(NodeID nodeID) const;
         void updateLinkedObjects(NodeID oldNodeID, NodeID newNodeID);
         bool collapseNodes(NodeID parentNodeID, NodeID childNodeID);
         bool mergeNodes(NodeID dstNodeID, NodeID srcNodeID);
         void flipTriangleWinding(MeshSpec& mesh);
+        void addTextureDependencies();
+        SceneCache::Manifest createSceneCacheManifest();
         void updateSDFGridID(SdfGridID oldID, SdfGridID newID);
 
         /** Split a mesh by the given axis-aligned splitting plane.
@@ -775,7 +819,10 @@ namespace Falcor
         MeshGroupList splitMeshGroupMedian(MeshGroup& meshGroup) const;
         MeshGroupList splitMeshGroupMidpointMeshes(MeshGroup& meshGroup);
 
+        MeshSpec createMeshSpec(const ProcessedMesh& mesh);
+
         // Post processing
+        void processDeferredMeshes();
         void prepareDisplacementMaps();
         void prepareSceneGraph();
         void prepareMeshes();
@@ -795,6 +842,7 @@ namespace Falcor
         void collectVolumeGrids();
         void quantizeTexCoords();
         void removeDuplicateSDFGrids();
+        void compressAnimations();
 
         // Scene setup
         void createMeshData();
@@ -30,20 +30,31 @@
 #include "Material/HairMaterial.h"
 #include "Material/ClothMaterial.h"
 #include "Material/MaterialTextureLoader.h"
+#include "Core/Platform/OS.h"
+#include "Core/Platform/MemoryMappedFile.h"
 #include "Utils/Logger.h"
+#include "Utils/Threading.h"
 
+#include <lz4.h>
 #include <lz4_stream/lz4_stream.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <type_traits>
 
 namespace Falcor
 {
     namespace
     {
-        /** Specfies the current cache file version.
-            This needs to be incremented every time the file format changes!
+        /** Specfies the cache file versions.
+            These need to be incremented every time the file format changes!
+            kVersionV1 is the single-stream format (SceneCache::Format::V1), kVersionV2 the chunked format (SceneCache::Format::V2).
         */
-        const uint32_t kVersion = 25;
+        const uint32_t kVersionV1 = 28;
+        const uint32_t kVersionV2 = 29;
 
         /** Scene cache directory (subdirectory in the application data directory).
         */
@@ -51,6 +62,13 @@ namespace Falcor
 
         const size_t kBlockSize = 1 * 1024 * 1024;
 
+        // V2 format: Blobs are split into chunks of at most kChunkSize bytes that are compressed independently.
+        // Arrays smaller than kMinBulkSize bytes are serialized inline.
+        const size_t kChunkSize = 4 * 1024 * 1024;
+        const size_t kMinBulkSize = 64 * 1024;
+        const size_t kChunkAlignment = 64;
+        const uint64_t kMaxLZ4Ratio = 255; ///< Upper bound on the LZ4 decompression ratio, used to validate chunk sizes.
+
         const char* kMagic = "FalcorS$";
         struct Header
         {
@@ -59,9 +77,88 @@ namespace Falcor
 
             bool isValid() const
             {
-                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
+                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && (version == kVersionV1 || version == kVersionV2);
+            }
+        };
+
+        /** Chunk table entry of the V2 format.
+            Blob 0 holds the serialized scene data, the remaining blobs hold one bulk array each.
+        */
+        struct ChunkDesc
+        {
+            uint32_t blob = 0;          ///< Blob index.
+            uint32_t compressed = 0;    ///< 1 if the chunk is LZ4 compressed, 0 if stored uncompressed.
+            uint64_t blobOffset = 0;    ///< Offset of the chunk within the blob in bytes.
+            uint64_t size = 0;          ///< Uncompressed size in bytes.
+            uint64_t fileOffset = 0;    ///< Offset of the stored data in the file in bytes. Aligned to kChunkAlignment.
+            uint64_t storedSize = 0;    ///< Stored size in bytes.
+        };
+
+        /** Read-only stream buffer over a block of memory.
+        */
+        class MemoryStreamBuf : public std::streambuf
+        {
+        public:
+            MemoryStreamBuf(const void* pData, size_t size)
+            {
+                char* p = const_cast<char*>(static_cast<const char*>(pData));
+                setg(p, p, p + size);
+            }
+
+        protected:
+            pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+            {
+                if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+                char* base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::end ? egptr() : gptr();
+                char* p = base + off;
+                if (p < eback() || p > egptr()) return pos_type(off_type(-1));
+                setg(eback(), p, egptr());
+                return pos_type(off_type(p - eback()));
+            }
+
+            pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+            {
+                return seekoff(off_type(pos), std::ios_base::beg, which);
             }
         };
+
+        Header createHeader(uint32_t version)
+        {
+            Header header;
+            std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+            header.version = version;
+            return header;
+        }
+
+        std::optional<SHA1::MD> hashFileContents(const std::filesystem::path& path)
+        {
+            std::ifstream fs(path, std::ios_base::binary);
+            if (!fs) return {};
+
+            SHA1 sha1;
+            std::vector<char> buffer(kBlockSize);
+            while (fs)
+            {
+                fs.read(buffer.data(), buffer.size());
+                sha1.update(buffer.data(), (size_t)fs.gcount());
+            }
+            return sha1.finalize();
+        }
+
+        SceneCache::ManifestEntry createManifestEntry(const std::filesystem::path& path, bool hashContents)
+        {
+            SceneCache::ManifestEntry entry;
+            entry.path = path;
+            std::error_code ec;
+            entry.exists = std::filesystem::is_regular_file(path, ec);
+            if (entry.exists)
+            {
+                entry.size = std::filesystem::file_size(path, ec);
+                entry.modifiedTime = (int64_t)getFileModifiedTime(path);
+                if (hashContents) entry.contentHash = hashFileContents(path);
+            }
+            return entry;
+        }
     }
 
     /** Wrapper around std::ostream to ease serialization of basic types.
@@ -69,7 +166,15 @@ namespace Falcor
     class SceneCache::OutputStream
     {
     public:
-        OutputStream(std::ostream& stream) : mStream(stream) {}
+        /** Array that is written to a separate blob (V2 format only).
+        */
+        struct BulkArray
+        {
+            const void* pData;
+            size_t size;
+        };
+
+        OutputStream(std::ostream& stream, std::vector<BulkArray>* pBulkArrays = nullptr) : mStream(stream), mpBulkArrays(pBulkArrays) {}
 
         void write(const void* data, size_t len)
         {
@@ -117,8 +222,34 @@ namespace Falcor
             if (hasValue) write(opt.value());
         }
 
+        /** Write a large array of trivially copyable elements.
+            If bulk arrays are enabled, only the element count is written to the stream and the data is written to a separate blob.
+            Otherwise this is the same as write().
+        */
+        template<typename T>
+        void writeBulk(const std::vector<T>& vec)
+        {
+            static_assert(std::is_trivially_copyable<T>::value);
+            if (!mpBulkArrays)
+            {
+                write(vec);
+                return;
+            }
+
+            bool isBulk = vec.size() * sizeof(T) >= kMinBulkSize;
+            write(isBulk);
+            if (!isBulk)
+            {
+                write(vec);
+                return;
+            }
+            write((uint64_t)vec.size());
+            mpBulkArrays->push_back({ vec.data(), vec.size() * sizeof(T) });
+        }
+
     private:
         std::ostream& mStream;
+        std::vector<BulkArray>* mpBulkArrays;
     };
 
     /** Wrapper around std::istream to ease serialization of basic types.
@@ -126,7 +257,24 @@ namespace Falcor
     class SceneCache::InputStream
     {
     public:
-        InputStream(std::istream& stream) : mStream(stream) {}
+        /** Destination of an array that is read from a separate blob (V2 format only).
+        */
+        struct BulkArray
+        {
+            void* pData;
+            size_t size;
+        };
+
+        /** Create an input stream.
+            \param[in] stream Underlying stream.
+            \param[in] pBulkArrays Destinations of bulk arrays (V2 format only).
+            \param[in] pBulkSizes Sizes of the bulk array blobs from the chunk table. Bulk arrays are validated against them.
+        */
+        InputStream(std::istream& stream, std::vector<BulkArray>* pBulkArrays = nullptr, const std::vector<uint64_t>* pBulkSizes = nullptr)
+            : mStream(stream)
+            , mpBulkArrays(pBulkArrays)
+            , mpBulkSizes(pBulkSizes)
+        {}
 
         void read(void* data, size_t len)
         {
@@ -142,6 +290,7 @@ namespace Falcor
         void read(std::string& value)
         {
             uint64_t len = read<uint64_t>();
+            checkSize(len, 1);
             value.resize(len);
             read(value.data(), len);
         }
@@ -165,8 +314,10 @@ namespace Falcor
         void read(std::vector<T>& vec)
         {
             uint64_t len = read<uint64_t>();
+            constexpr bool kTrivial = std::is_trivial<T>::value && !std::is_same<T, bool>::value;
+            checkSize(len, kTrivial ? sizeof(T) : 1);
             vec.resize(len);
-            if constexpr (std::is_trivial<T>::value && !std::is_same<T, bool>::value)
+            if constexpr (kTrivial)
             {
                 read(vec.data(), len * sizeof(T));
             }
@@ -188,10 +339,92 @@ namespace Falcor
             }
         }
 
+        /** Read an array written with OutputStream::writeBulk().
+            For bulk arrays, the vector is resized and its data is registered for decoding after the stream has been read.
+            The vector must not be copied or resized before then.
+        */
+        template<typename T>
+        void readBulk(std::vector<T>& vec)
+        {
+            static_assert(std::is_trivially_copyable<T>::value);
+            if (!mpBulkArrays || !read<bool>())
+            {
+                read(vec);
+                return;
+            }
+            // The blob size is known from the chunk table, so the length must match it exactly.
+            uint64_t len = read<uint64_t>();
+            size_t index = mpBulkArrays->size();
+            if (!isGood() || !mpBulkSizes || index >= mpBulkSizes->size() || len > (*mpBulkSizes)[index] / sizeof(T) ||
+                len * sizeof(T) != (*mpBulkSizes)[index])
+            {
+                throw RuntimeError("Invalid bulk array in scene cache file.");
+            }
+            vec.resize(len);
+            mpBulkArrays->push_back({ vec.data(), len * sizeof(T) });
+        }
+
+        bool isGood() const { return mStream.good(); }
+
+        /** Get the number of bytes left in the underlying stream.
+            Used to validate sizes read from the stream before allocating memory for them.
+        */
+        uint64_t getRemainingSize()
+        {
+            auto pos = mStream.tellg();
+            if (pos == std::istream::pos_type(-1)) return 0;
+            mStream.seekg(0, std::ios_base::end);
+            auto end = mStream.tellg();
+            mStream.seekg(pos);
+            return end > pos ? uint64_t(end - pos) : 0;
+        }
+
     private:
+        /** Check that an array of the given length can be stored in the rest of the stream before allocating memory for it.
+            Streams that can't seek (V1 format) are not checked.
+        */
+        void checkSize(uint64_t count, uint64_t minElementSize)
+        {
+            if (!isGood()) throw RuntimeError("Invalid data in scene cache file.");
+            if (mStream.tellg() == std::istream::pos_type(-1)) return;
+            if (count > getRemainingSize() / minElementSize) throw RuntimeError("Invalid data in scene cache file.");
+        }
+
         std::istream& mStream;
+        std::vector<BulkArray>* mpBulkArrays;
+        const std::vector<uint64_t>* mpBulkSizes;
     };
 
+    SceneCache::Manifest SceneCache::createManifest(const std::vector<std::filesystem::path>& paths, bool hashContents)
+    {
+        std::vector<std::filesystem::path> uniquePaths = paths;
+        std::sort(uniquePaths.begin(), uniquePaths.end());
+        uniquePaths.erase(std::unique(uniquePaths.begin(), uniquePaths.end()), uniquePaths.end());
+
+        Manifest manifest(uniquePaths.size());
+        Threading::parallelFor(0, uniquePaths.size(), [&](size_t i)
+        {
+            manifest[i] = createManifestEntry(uniquePaths[i], hashContents);
+        });
+        return manifest;
+    }
+
+    bool SceneCache::isManifestValid(const Manifest& manifest)
+    {
+        std::atomic<bool> valid{ true };
+        Threading::parallelFor(0, manifest.size(), [&](size_t i)
+        {
+            if (!valid) return;
+            const auto& entry = manifest[i];
+            if (createManifestEntry(entry.path, entry.contentHash.has_value()) != entry)
+            {
+                logInfo("Scene cache input '{}' has changed.", entry.path);
+                valid = false;
+            }
+        });
+        return valid;
+    }
+
     bool SceneCache::hasValidCache(const Key& key)
     {
         auto cachePath = getCachePath(key);
@@ -204,10 +437,24 @@ namespace Falcor
         // Verify header.
         Header header;
         fs.read(reinterpret_cast<char*>(&header), sizeof(header));
-        return !fs.eof() && header.isValid();
+        if (fs.eof() || !header.isValid()) return false;
+
+        // Verify that none of the input files changed.
+        InputStream stream(fs);
+        Manifest manifest;
+        try
+        {
+            manifest = readManifest(stream);
+        }
+        catch (const RuntimeError&)
+        {
+            return false;
+        }
+        if (!fs) return false;
+        return isManifestValid(manifest);
     }
 
-    void SceneCache::writeCache(const Scene::SceneData& sceneData, const Key& key)
+    void SceneCache::writeCache(const Scene::SceneData& sceneData, const Key& key, const Manifest& manifest, Format format)
     {
         auto cachePath = getCachePath(key);
 
@@ -221,15 +468,17 @@ namespace Falcor
         if (fs.bad()) throw RuntimeError("Failed to create scene cache file '{}'.", cachePath);
 
         // Write header (uncompressed).
-        Header header;
-        std::memcpy(header.magic, kMagic, sizeof(Header::magic));
-        header.version = kVersion;
+        Header header = createHeader(format == Format::V1 ? kVersionV1 : kVersionV2);
         fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-        // Write cache (compressed).
-        lz4_stream::basic_ostream<kBlockSize> zs(fs);
-        OutputStream stream(zs);
-        writeSceneData(stream, sceneData);
+        // Write manifest (uncompressed). This allows checking the inputs without decompressing the cache.
+        {
+            OutputStream stream(fs);
+            writeManifest(stream, manifest);
+        }
+
+        if (format == Format::V1) writeCacheV1(fs, sceneData);
+        else writeCacheV2(fs, sceneData);
         if (fs.bad()) throw RuntimeError("Failed to write scene cache file to '{}'.", cachePath);
     }
 
@@ -248,11 +497,198 @@ namespace Falcor
         fs.read(reinterpret_cast<char*>(&header), sizeof(header));
         if (!header.isValid()) throw RuntimeError("Invalid header in scene cache file '{}'.", cachePath);
 
+        if (header.version == kVersionV2)
+        {
+            fs.close();
+            return readCacheV2(cachePath, pDevice);
+        }
+
+        // Skip manifest (uncompressed).
+        {
+            InputStream stream(fs);
+            readManifest(stream);
+        }
+
+        auto sceneData = readCacheV1(fs, pDevice);
+        if (fs.bad()) throw RuntimeError("Failed to read scene cache file from '{}'.", cachePath);
+        return sceneData;
+    }
+
+    void SceneCache::writeCacheV1(std::ostream& fs, const Scene::SceneData& sceneData)
+    {
+        // Write cache (compressed).
+        lz4_stream::basic_ostream<kBlockSize> zs(fs);
+        OutputStream stream(zs);
+        writeSceneData(stream, sceneData);
+    }
+
+    Scene::SceneData SceneCache::readCacheV1(std::istream& fs, ref<Device> pDevice)
+    {
         // Read cache (compressed).
         lz4_stream::basic_istream<kBlockSize, kBlockSize> zs(fs);
         InputStream stream(zs);
+        return readSceneData(stream, pDevice);
+    }
+
+    void SceneCache::writeCacheV2(std::ostream& fs, const Scene::SceneData& sceneData)
+    {
+        // The V2 format stores the following after the manifest:
+        //  - Chunk table (uint64_t count followed by ChunkDesc entries).
+        //  - Chunk data, each chunk aligned to kChunkAlignment bytes from the start of the file.
+        // Blob 0 holds the serialized scene data with the bulk arrays replaced by their element count.
+        // Blobs 1..N hold the bulk arrays in the order they are serialized.
+
+        // Serialize scene data and collect bulk arrays.
+        std::vector<OutputStream::BulkArray> blobs;
+        std::ostringstream mainStream;
+        {
+            OutputStream stream(mainStream, &blobs);
+            writeSceneData(stream, sceneData);
+        }
+        const std::string mainData = mainStream.str();
+        blobs.insert(blobs.begin(), OutputStream::BulkArray{ mainData.data(), mainData.size() });
+
+        // Split blobs into chunks.
+        std::vector<ChunkDesc> chunks;
+        for (size_t blob = 0; blob < blobs.size(); ++blob)
+        {
+            for (size_t offset = 0; offset < blobs[blob].size; offset += kChunkSize)
+            {
+                ChunkDesc chunk;
+                chunk.blob = (uint32_t)blob;
+                chunk.blobOffset = offset;
+                chunk.size = std::min(kChunkSize, blobs[blob].size - offset);
+                chunks.push_back(chunk);
+            }
+        }
+
+        // Compress chunks in parallel. Chunks that don't compress are stored uncompressed.
+        std::vector<std::vector<char>> compressedData(chunks.size());
+        Threading::parallelFor(0, chunks.size(), [&](size_t i)
+        {
+            auto& chunk = chunks[i];
+            const char* pSrc = static_cast<const char*>(blobs[chunk.blob].pData) + chunk.blobOffset;
+            auto& dst = compressedData[i];
+            dst.resize(LZ4_compressBound((int)chunk.size));
+            int compressedSize = LZ4_compress_default(pSrc, dst.data(), (int)chunk.size, (int)dst.size());
+            if (compressedSize > 0 && (size_t)compressedSize < chunk.size)
+            {
+                dst.resize(compressedSize);
+                chunk.compressed = 1;
+                chunk.storedSize = compressedSize;
+            }
+            else
+            {
+                dst = {};
+                chunk.storedSize = chunk.size;
+            }
+        });
+
+        // Assign file offsets.
+        auto align = [](uint64_t offset) { return (offset + kChunkAlignment - 1) / kChunkAlignment * kChunkAlignment; };
+        uint64_t offset = align((uint64_t)fs.tellp() + sizeof(uint64_t) + chunks.size() * sizeof(ChunkDesc));
+        for (auto& chunk : chunks)
+        {
+            chunk.fileOffset = offset;
+            offset = align(offset + chunk.storedSize);
+        }
+
+        // Write chunk table and chunks.
+        OutputStream stream(fs);
+        stream.write((uint64_t)chunks.size());
+        for (const auto& chunk : chunks) stream.write(chunk);
+
+        const char padding[kChunkAlignment] = {};
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            const auto& chunk = chunks[i];
+            fs.write(padding, chunk.fileOffset - (uint64_t)fs.tellp());
+            if (chunk.compressed) fs.write(compressedData[i].data(), chunk.storedSize);
+            else fs.write(static_cast<const char*>(blobs[chunk.blob].pData) + chunk.blobOffset, chunk.storedSize);
+        }
+    }
+
+    Scene::SceneData SceneCache::readCacheV2(const std::filesystem::path& path, ref<Device> pDevice)
+    {
+        MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!file.isOpen()) throw RuntimeError("Failed to open scene cache file '{}'.", path);
+        const char* pFileData = static_cast<const char*>(file.getData());
+        const size_t fileSize = file.getMappedSize();
+
+        // Read header, manifest and chunk table.
+        MemoryStreamBuf fileBuf(pFileData, fileSize);
+        std::istream fs(&fileBuf);
+        Header header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        InputStream fileStream(fs);
+        readManifest(fileStream);
+        uint64_t chunkCount = fileStream.read<uint64_t>();
+        if (chunkCount > fileSize / sizeof(ChunkDesc)) throw RuntimeError("Invalid chunk table in scene cache file '{}'.", path);
+        std::vector<ChunkDesc> chunks(chunkCount);
+        for (auto& chunk : chunks) fileStream.read(chunk);
+        if (!fileStream.isGood()) throw RuntimeError("Invalid chunk table in scene cache file '{}'.", path);
+
+        // Validate the chunk table before allocating any blob memory. Chunks must be stored in the order written by writeCacheV2(),
+        // i.e. each blob is covered by consecutive chunks without gaps. A compressed chunk can't expand by more than the maximum LZ4
+        // ratio, so the total blob size is bounded by the file size.
+        std::vector<uint64_t> blobSizes(1, 0);
+        for (const auto& chunk : chunks)
+        {
+            if (chunk.blob == blobSizes.size() && chunk.blobOffset == 0) blobSizes.push_back(0);
+            bool valid = chunk.fileOffset <= fileSize && chunk.storedSize <= fileSize - chunk.fileOffset && chunk.size <= kChunkSize;
+            valid = valid && chunk.blob + 1 == blobSizes.size() && chunk.blobOffset == blobSizes.back();
+            valid = valid && (chunk.compressed ? chunk.size <= chunk.storedSize * kMaxLZ4Ratio : chunk.size == chunk.storedSize);
+            if (!valid) throw RuntimeError("Invalid chunk in scene cache file '{}'.", path);
+            blobSizes.back() += chunk.size;
+        }
+
+        // Decode a set of chunks in parallel into the blob destinations.
+        auto decodeChunks = [&](const std::vector<InputStream::BulkArray>& blobs, bool mainBlob)
+        {
+            std::atomic<bool> failed{ false };
+            Threading::parallelFor(0, chunks.size(), [&](size_t i)
+            {
+                const auto& chunk = chunks[i];
+                if ((chunk.blob == 0) != mainBlob) return;
+                if (chunk.blob >= blobs.size() || chunk.blobOffset + chunk.size > blobs[chunk.blob].size)
+                {
+                    failed = true;
+                    return;
+                }
+
+                char* pDst = static_cast<char*>(blobs[chunk.blob].pData) + chunk.blobOffset;
+                const char* pSrc = pFileData + chunk.fileOffset;
+                if (chunk.compressed)
+                {
+                    int size = LZ4_decompress_safe(pSrc, pDst, (int)chunk.storedSize, (int)chunk.size);
+                    if (size != (int)chunk.size) failed = true;
+                }
+                else
+                {
+                    if (chunk.storedSize != chunk.size) failed = true;
+                    else std::memcpy(pDst, pSrc, chunk.size);
+                }
+            });
+            if (failed) throw RuntimeError("Failed to decode scene cache file '{}'.", path);
+        };
+
+        // Decode and parse the scene data. Bulk arrays are registered as blobs 1..N while parsing.
+        std::vector<char> mainData(blobSizes[0]);
+        std::vector<InputStream::BulkArray> blobs = { { mainData.data(), mainData.size() } };
+        decodeChunks(blobs, true);
+
+        MemoryStreamBuf mainBuf(mainData.data(), mainData.size());
+        std::istream mainStream(&mainBuf);
+        InputStream stream(mainStream, &blobs, &blobSizes);
         auto sceneData = readSceneData(stream, pDevice);
-        if (fs.bad()) throw RuntimeError("Failed to read scene cache file from '{}'.", cachePath);
+
+        // Check that the scene data references all blobs in the chunk table.
+        if (blobs.size() != blobSizes.size()) throw RuntimeError("Missing data in scene cache file '{}'.", path);
+
+        // Decode bulk arrays directly into the scene data.
+        decodeChunks(blobs, false);
+
         return sceneData;
     }
 
@@ -261,6 +697,46 @@ namespace Falcor
         return getAppDataDirectory() / kDirectory / SHA1::toString(key);
     }
 
+    // Manifest
+
+    void SceneCache::writeManifest(OutputStream& stream, const Manifest& manifest)
+    {
+        stream.write((uint64_t)manifest.size());
+        for (const auto& entry : manifest)
+        {
+            stream.write(entry.path);
+            stream.write(entry.exists);
+            stream.write(entry.size);
+            stream.write(entry.modifiedTime);
+            stream.write(entry.contentHash);
+        }
+    }
+
+    SceneCache::Manifest SceneCache::readManifest(InputStream& stream)
+    {
+        // Validate all sizes against the remaining stream size so that a corrupt file can't trigger huge allocations.
+        // Each entry stores at least the path length, the exists flag, size, modification time and hash flag.
+        const uint64_t kMinEntrySize = sizeof(uint64_t) + sizeof(bool) + sizeof(uint64_t) + sizeof(int64_t) + sizeof(bool);
+        uint64_t remaining = stream.getRemainingSize();
+        uint64_t count = stream.read<uint64_t>();
+        if (!stream.isGood() || count > remaining / kMinEntrySize) throw RuntimeError("Invalid manifest in scene cache file.");
+
+        Manifest manifest(count);
+        for (auto& entry : manifest)
+        {
+            uint64_t pathLength = stream.read<uint64_t>();
+            if (!stream.isGood() || pathLength > remaining) throw RuntimeError("Invalid manifest in scene cache file.");
+            std::string path(pathLength, '\0');
+            stream.read(path.data(), pathLength);
+            entry.path = path;
+            stream.read(entry.exists);
+            stream.read(entry.size);
+            stream.read(entry.modifiedTime);
+            stream.read(entry.contentHash);
+        }
+        return manifest;
+    }
+
     // SceneData
 
     void SceneCache::writeSceneData(OutputStream& stream, const Scene::SceneData& sceneData)
@@ -341,22 +817,22 @@ namespace Falcor
             stream.write(cachedMesh.meshID);
             stream.write(cachedMesh.timeSamples);
             stream.write((uint32_t)cachedMesh.vertexData.size());
-            for (const auto& data : cachedMesh.vertexData) stream.write(data);
+            for (const auto& data : cachedMesh.vertexData) stream.writeBulk(data);
         }
         stream.write(sceneData.useCompressedHitInfo);
         stream.write(sceneData.has16BitIndices);
         stream.write(sceneData.has32BitIndices);
         stream.write(sceneData.meshDrawCount);
-        stream.write(sceneData.meshIndexData);
-        stream.write(sceneData.meshStaticData);
-        stream.write(sceneData.meshSkinningData);
+        stream.writeBulk(sceneData.meshIndexData);
+        stream.writeBulk(sceneData.meshStaticData);
+        stream.writeBulk(sceneData.meshSkinningData);
 
         writeMarker(stream, "Curves");
         stream.write(sceneData.curveDesc);
         stream.write(sceneData.curveBBs);
         stream.write(sceneData.curveInstanceData);
-        stream.write(sceneData.curveIndexData);
-        stream.write(sceneData.curveStaticData);
+        stream.writeBulk(sceneData.curveIndexData);
+        stream.writeBulk(sceneData.curveStaticData);
 
         stream.write((uint32_t)sceneData.cachedCurves.size());
         for (const auto& cachedCurve : sceneData.cachedCurves)
@@ -364,9 +840,9 @@ namespace Falcor
             stream.write(cachedCurve.tessellationMode);
             stream.write(cachedCurve.geometryID);
             stream.write(cachedCurve.timeSamples);
-            stream.write(cachedCurve.indexData);
+            stream.writeBulk(cachedCurve.indexData);
             stream.write((uint32_t)cachedCurve.vertexData.size());
-            for (const auto& data : cachedCurve.vertexData) stream.write(data);
+            for (const auto& data : cachedCurve.vertexData) stream.writeBulk(data);
         }
 
         writeMarker(stream, "CustomPrimitives");
@@ -462,22 +938,22 @@ namespace Falcor
             stream.read(cachedMesh.meshID);
             stream.read(cachedMesh.timeSamples);
             cachedMesh.vertexData.resize(stream.read<uint32_t>());
-            for (auto& data : cachedMesh.vertexData) stream.read(data);
+            for (auto& data : cachedMesh.vertexData) stream.readBulk(data);
         }
         stream.read(sceneData.useCompressedHitInfo);
         stream.read(sceneData.has16BitIndices);
         stream.read(sceneData.has32BitIndices);
         stream.read(sceneData.meshDrawCount);
-        stream.read(sceneData.meshIndexData);
-        stream.read(sceneData.meshStaticData);
-        stream.read(sceneData.meshSkinningData);
+        stream.readBulk(sceneData.meshIndexData);
+        stream.readBulk(sceneData.meshStaticData);
+        stream.readBulk(sceneData.meshSkinningData);
 
         readMarker(stream, "Curves");
         stream.read(sceneData.curveDesc);
         stream.read(sceneData.curveBBs);
         stream.read(sceneData.curveInstanceData);
-        stream.read(sceneData.curveIndexData);
-        stream.read(sceneData.curveStaticData);
+        stream.readBulk(sceneData.curveIndexData);
+        stream.readBulk(sceneData.curveStaticData);
 
         sceneData.cachedCurves.resize(stream.read<uint32_t>());
         for (auto& cachedCurve : sceneData.cachedCurves)
@@ -485,9 +961,9 @@ namespace Falcor
             stream.read(cachedCurve.tessellationMode);
             stream.read(cachedCurve.geometryID);
             stream.read(cachedCurve.timeSamples);
-            stream.read(cachedCurve.indexData);
+            stream.readBulk(cachedCurve.indexData);
             cachedCurve.vertexData.resize(stream.read<uint32_t>());
-            for (auto& data : cachedCurve.vertexData) stream.read(data);
+            for (auto& data : cachedCurve.vertexData) stream.readBulk(data);
         }
 
         readMarker(stream, "CustomPrimitives");
@@ -919,6 +1395,8 @@ namespace Falcor
         stream.write(pAnimation->mInterpolationMode);
         stream.write(pAnimation->mEnableWarping);
         stream.write(pAnimation->mKeyframes);
+        stream.write(pAnimation->isCompressed());
+        if (pAnimation->isCompressed()) writeAnimationClip(stream, *pAnimation->mpClip);
     }
 
     ref<Animation> SceneCache::readAnimation(InputStream& stream)
@@ -932,9 +1410,47 @@ namespace Falcor
         stream.read(pAnimation->mInterpolationMode);
         stream.read(pAnimation->mEnableWarping);
         stream.read(pAnimation->mKeyframes);
+        bool isCompressed = stream.read<bool>();
+        if (isCompressed) pAnimation->mpClip = readAnimationClip(stream);
         return pAnimation;
     }
 
+    void SceneCache::writeAnimationClip(OutputStream& stream, const AnimationClip& clip)
+    {
+        stream.write(clip.mKeyframeCount);
+        stream.write(clip.mUniformTimes);
+        stream.write(clip.mStartTime);
+        stream.write(clip.mTimeStep);
+        stream.write(clip.mTimes);
+        for (const AnimationClip::Channel* pChannel : { &clip.mTranslation, &clip.mScaling, &clip.mRotation })
+        {
+            stream.write(pChannel->encoding);
+            stream.write(pChannel->componentCount);
+            stream.write(pChannel->offset);
+            stream.write(pChannel->scale);
+            stream.write(pChannel->data);
+        }
+    }
+
+    std::unique_ptr<AnimationClip> SceneCache::readAnimationClip(InputStream& stream)
+    {
+        auto pClip = std::make_unique<AnimationClip>();
+        stream.read(pClip->mKeyframeCount);
+        stream.read(pClip->mUniformTimes);
+        stream.read(pClip->mStartTime);
+        stream.read(pClip->mTimeStep);
+        stream.read(pClip->mTimes);
+        for (AnimationClip::Channel* pChannel : { &pClip->mTranslation, &pClip->mScaling, &pClip->mRotation })
+        {
+            stream.read(pChannel->encoding);
+            stream.read(pChannel->componentCount);
+            stream.read(pChannel->offset);
+            stream.read(pChannel->scale);
+            stream.read(pChannel->data);
+        }
+        return pClip;
+    }
+
     // Marker
 
     void SceneCache::writeMarker(OutputStream& stream, const std::string& id)
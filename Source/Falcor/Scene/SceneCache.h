@@ -42,6 +42,7 @@
 #include "Utils/CryptoUtils.h"
 
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -56,7 +57,50 @@ namespace Falcor
     public:
         using Key = SHA1::MD;
 
+        /** Scene cache file format.
+        */
+        enum class Format
+        {
+            V1,     ///< All scene data is serialized into a single LZ4 stream. Supported for reading old caches.
+            V2,     ///< Bulk vertex/index data is stored in independently compressed, aligned chunks that are decoded in parallel.
+        };
+
+        /** Record of an input file the cached scene depends on.
+        */
+        struct ManifestEntry
+        {
+            std::filesystem::path path;             ///< Absolute file path.
+            bool exists = false;                    ///< True if the file existed when the cache was written.
+            uint64_t size = 0;                      ///< File size in bytes.
+            int64_t modifiedTime = 0;               ///< Last modification time (see getFileModifiedTime()).
+            std::optional<SHA1::MD> contentHash;    ///< Optional hash of the file contents.
+
+            bool operator==(const ManifestEntry& other) const
+            {
+                return path == other.path && exists == other.exists && size == other.size && modifiedTime == other.modifiedTime && contentHash == other.contentHash;
+            }
+        };
+
+        /** List of all input files of a cached scene.
+            The manifest is stored in the cache file header and checked when looking up the cache.
+        */
+        using Manifest = std::vector<ManifestEntry>;
+
+        /** Create a manifest describing the current state of a set of files.
+            \param[in] paths File paths. Duplicates are removed.
+            \param[in] hashContents If true, the file contents are hashed in addition to checking size and modification time.
+            \return The manifest.
+        */
+        static Manifest createManifest(const std::vector<std::filesystem::path>& paths, bool hashContents);
+
+        /** Check if a manifest still matches the files on disk.
+            \param[in] manifest Manifest.
+            \return Returns true if none of the files changed.
+        */
+        static bool isManifestValid(const Manifest& manifest);
+
         /** Check if there is a valid scene cache for a given cache key.
+            The cache is only valid if none of the files in its manifest changed.
             \param[in] key Cache key.
             \return Returns true if a valid cache exists.
         */
@@ -65,10 +109,12 @@ namespace Falcor
         /** Write a scene cache.
             \param[in] sceneData Scene data.
             \param[in] key Cache key.
+            \param[in] manifest Manifest of input files the scene depends on.
+            \param[in] format File format to write.
         */
-        static void writeCache(const Scene::SceneData& sceneData, const Key& key);
+        static void writeCache(const Scene::SceneData& sceneData, const Key& key, const Manifest& manifest = {}, Format format = Format::V2);
 
-        /** Read a scene cache.
+        /** Read a scene cache. Both file formats are supported.
             \param[in] pDevice GPU device.
             \param[in] key Cache key.
             \return Returns the loaded scene data.
@@ -81,6 +127,14 @@ namespace Falcor
 
         static std::filesystem::path getCachePath(const Key& key);
 
+        static void writeCacheV1(std::ostream& fs, const Scene::SceneData& sceneData);
+        static void writeCacheV2(std::ostream& fs, const Scene::SceneData& sceneData);
+        static Scene::SceneData readCacheV1(std::istream& fs, ref<Device> pDevice);
+        static Scene::SceneData readCacheV2(const std::filesystem::path& path, ref<Device> pDevice);
+
+        static void writeManifest(OutputStream& stream, const Manifest& manifest);
+        static Manifest readManifest(InputStream& stream);
+
         static void writeSceneData(OutputStream& stream, const Scene::SceneData& sceneData);
         static Scene::SceneData readSceneData(InputStream& stream, ref<Device> pDevice);
 
@@ -118,6 +172,9 @@ namespace Falcor
         static void writeAnimation(OutputStream& stream, const ref<Animation>& pAnimation);
         static ref<Animation> readAnimation(InputStream& stream);
 
+        static void writeAnimationClip(OutputStream& stream, const AnimationClip& clip);
+        static std::unique_ptr<AnimationClip> readAnimationClip(InputStream& stream);
+
         static void writeMarker(OutputStream& stream, const std::string& id);
         static void readMarker(InputStream& stream, const std::string& id);
     };
@@ -0,0 +1,189 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "TangentCache.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Tangent cache directory (subdirectory in the application data directory, next to the scene cache).
+        */
+        const std::string kDirectory = "NVIDIA/Falcor/TangentCache";
+
+        const char kMagic[4] = { 'F', 'T', 'C', '1' };
+        const char kEntryExtension[] = ".tangents";
+        const char kTempExtension[] = ".tmp";
+
+        struct EntryHeader
+        {
+            char magic[4];
+            uint32_t reserved = 0;
+            uint64_t count = 0;
+            SHA1::MD hash;
+        };
+    }
+
+    TangentCache::TangentCache(const std::filesystem::path& directory, size_t maxMemorySize)
+        : mDirectory(directory)
+        , mMaxMemorySize(maxMemorySize)
+    {}
+
+    TangentCache& TangentCache::get()
+    {
+        static TangentCache cache(getAppDataDirectory() / kDirectory);
+        return cache;
+    }
+
+    bool TangentCache::lookup(const Key& key, std::vector<float4>& tangents, bool persistent)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = mEntries.find(key);
+            if (it != mEntries.end())
+            {
+                mLRU.splice(mLRU.begin(), mLRU, it->second);
+                tangents = it->second->tangents;
+                mStats.memoryHits++;
+                return true;
+            }
+        }
+
+        // Read the persistent entry. The stored count is validated against the file size before allocating.
+        std::optional<std::vector<float4>> data;
+        if (persistent)
+        {
+            const std::filesystem::path path = getEntryPath(key);
+            std::error_code ec;
+            const uint64_t fileSize = std::filesystem::file_size(path, ec);
+            std::ifstream fs(path, std::ios::binary);
+            EntryHeader header;
+            if (!ec && fs.read(reinterpret_cast<char*>(&header), sizeof(header)) && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                (fileSize - sizeof(header)) % sizeof(float4) == 0 && header.count == (fileSize - sizeof(header)) / sizeof(float4))
+            {
+                std::vector<float4> buffer(header.count);
+                bool valid = fs.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(float4)).good();
+                if (valid && SHA1::compute(buffer.data(), buffer.size() * sizeof(float4)) == header.hash)
+                    data = std::move(buffer);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!data)
+        {
+            mStats.misses++;
+            return false;
+        }
+        mStats.diskHits++;
+        insertMemory(key, *data);
+        tangents = std::move(*data);
+        return true;
+    }
+
+    void TangentCache::insert(const Key& key, const std::vector<float4>& tangents, bool persistent)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            insertMemory(key, tangents);
+        }
+
+        if (!persistent) return;
+
+        std::error_code ec;
+        std::filesystem::create_directories(mDirectory, ec);
+
+        // Write the entry to a uniquely named temporary file first so that readers never see a partial entry.
+        static thread_local std::mt19937_64 rng{ std::random_device{}() };
+        const std::filesystem::path path = getEntryPath(key);
+        std::filesystem::path tempPath = path;
+        tempPath.replace_extension(fmt::format("{:016x}{}", rng(), kTempExtension));
+
+        EntryHeader header;
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.count = tangents.size();
+        header.hash = SHA1::compute(tangents.data(), tangents.size() * sizeof(float4));
+
+        {
+            std::ofstream fs(tempPath, std::ios::binary | std::ios::trunc);
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            fs.write(reinterpret_cast<const char*>(tangents.data()), tangents.size() * sizeof(float4));
+            if (!fs.good())
+            {
+                fs.close();
+                std::filesystem::remove(tempPath, ec);
+                logWarning("Failed to write tangent cache entry '{}'.", tempPath);
+                return;
+            }
+        }
+
+        std::filesystem::rename(tempPath, path, ec);
+        if (ec) std::filesystem::remove(tempPath, ec);
+    }
+
+    void TangentCache::clearMemory()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLRU.clear();
+        mEntries.clear();
+        mMemorySize = 0;
+    }
+
+    TangentCache::Stats TangentCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    void TangentCache::insertMemory(const Key& key, const std::vector<float4>& tangents)
+    {
+        const size_t size = tangents.size() * sizeof(float4);
+        if (size > mMaxMemorySize || mEntries.find(key) != mEntries.end()) return;
+
+        mLRU.push_front({ key, tangents });
+        mEntries[key] = mLRU.begin();
+        mMemorySize += size;
+
+        while (mMemorySize > mMaxMemorySize)
+        {
+            const auto& entry = mLRU.back();
+            mMemorySize -= entry.tangents.size() * sizeof(float4);
+            mEntries.erase(entry.key);
+            mLRU.pop_back();
+        }
+    }
+
+    std::filesystem::path TangentCache::getEntryPath(const Key& key) const
+    {
+        return mDirectory / (SHA1::toString(key) + kEntryExtension);
+    }
+}
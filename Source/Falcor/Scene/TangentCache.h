@@ -0,0 +1,114 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/CryptoUtils.h"
+#include "Utils/Math/Vector.h"
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace Falcor
+{
+    /** Cache of generated tangents, keyed on a hash of the mesh data used for tangent generation.
+
+        Entries are kept in memory up to a size limit, evicting the least recently used entries first. Entries can
+        optionally be persisted to disk, one file per entry, so that re-importing the same meshes in a later run
+        also skips tangent generation.
+    */
+    class FALCOR_API TangentCache
+    {
+    public:
+        using Key = SHA1::MD;
+
+        struct Stats
+        {
+            uint64_t memoryHits = 0;    ///< Number of lookups served from memory.
+            uint64_t diskHits = 0;      ///< Number of lookups served from disk.
+            uint64_t misses = 0;        ///< Number of lookups that found no entry.
+        };
+
+        /** Constructor.
+            \param[in] directory Directory for persistent entries.
+            \param[in] maxMemorySize Maximum total size in bytes of the entries kept in memory.
+        */
+        TangentCache(const std::filesystem::path& directory, size_t maxMemorySize = kDefaultMaxMemorySize);
+
+        /** Get the process-wide cache used by SceneBuilder.
+            Persistent entries are stored next to the scene cache in the application data directory.
+        */
+        static TangentCache& get();
+
+        /** Look up the tangents for a key.
+            \param[in] key Hash of the mesh data.
+            \param[out] tangents Cached tangents. Only written if an entry is found.
+            \param[in] persistent Also look for the entry on disk if it is not in memory.
+            \return True if an entry was found.
+        */
+        bool lookup(const Key& key, std::vector<float4>& tangents, bool persistent);
+
+        /** Add the tangents for a key.
+            \param[in] key Hash of the mesh data.
+            \param[in] tangents Tangents to cache.
+            \param[in] persistent Also write the entry to disk.
+        */
+        void insert(const Key& key, const std::vector<float4>& tangents, bool persistent);
+
+        /** Remove all entries from memory. Persistent entries are kept.
+        */
+        void clearMemory();
+
+        Stats getStats() const;
+
+        const std::filesystem::path& getDirectory() const { return mDirectory; }
+
+        static constexpr size_t kDefaultMaxMemorySize = 256ull << 20;
+
+    private:
+        struct Entry
+        {
+            Key key;
+            std::vector<float4> tangents;
+        };
+
+        void insertMemory(const Key& key, const std::vector<float4>& tangents);
+        std::filesystem::path getEntryPath(const Key& key) const;
+
+        std::filesystem::path mDirectory;
+        size_t mMaxMemorySize;
+
+        mutable std::mutex mMutex;
+        std::list<Entry> mLRU;                                  ///< Entries in memory, most recently used first.
+        std::map<Key, std::list<Entry>::iterator> mEntries;
+        size_t mMemorySize = 0;
+        Stats mStats;
+    };
+}
@@ -0,0 +1,404 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "VertexWelder.h"
+#include "Core/Assert.h"
+#include "Core/Errors.h"
+#include "Utils/Threading.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Falcor
+{
+    namespace
+    {
+        using Mesh = SceneBuilder::Mesh;
+        using Vertex = SceneBuilder::Mesh::Vertex;
+
+        const uint32_t kInvalidIndex = 0xffffffff;
+
+        // Minimum number of face corners per partition when welding in parallel.
+        const size_t kMinCornersPerPartition = 1 << 15;
+
+        // Vertices are bucketed by the sum of their thresholded attributes (normal, texture coordinate). If all those
+        // attributes differ by at most the merge threshold, the sums differ by at most 5x the threshold. With a cell
+        // size well above that, matching vertices always fall into the same or adjacent cells.
+        const double kCellSize = 16e-6;
+        const double kMaxCellKey = 1e9;
+        const int64_t kSpecialCell = std::numeric_limits<int64_t>::min();
+
+        /** Compute the bucket cell of a vertex.
+            Returns kSpecialCell for vertices with non-finite or very large attributes. These can't be bucketed reliably.
+        */
+        int64_t getCell(const Vertex& v)
+        {
+            double sum = (double)v.normal.x + (double)v.normal.y + (double)v.normal.z + (double)v.texCrd.x + (double)v.texCrd.y;
+            if (!(std::abs(sum) < kMaxCellKey)) return kSpecialCell; // Also catches NaN.
+            if (!std::isfinite(v.normal.x) || !std::isfinite(v.normal.y) || !std::isfinite(v.normal.z) ||
+                !std::isfinite(v.texCrd.x) || !std::isfinite(v.texCrd.y))
+            {
+                return kSpecialCell;
+            }
+            return (int64_t)std::floor(sum / kCellSize);
+        }
+
+        inline uint64_t hashKey(uint32_t origIndex, int64_t cell)
+        {
+            // 64-bit mix (from MurmurHash3 finalizer). The table is indexed by the low bits.
+            uint64_t hash = ((uint64_t)origIndex * 0x9e3779b97f4a7c15ull) ^ (uint64_t)cell;
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdull;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ull;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        /** Welding state for a set of original vertex indices.
+
+            As in the reference implementation, vertices are kept in a linked list per original vertex index, with the
+            most recently inserted vertex first. The reference search returns the first match in that list, i.e. the
+            most recently inserted matching vertex.
+
+            In addition, each vertex is linked into a sub-list keyed on (original vertex index, cell), see getCell().
+            The sub-lists are found through an open-addressing hash table. A query only needs to search the sub-lists of
+            its own and the two adjacent cells, plus the sub-list of special vertices that can't be bucketed. Taking the
+            most recently inserted match over those sub-lists gives the same result as the reference search. Queries
+            for special vertices fall back to searching the full list.
+        */
+        class HashWelder
+        {
+        public:
+            HashWelder(const Mesh& mesh, std::vector<uint32_t>& heads, size_t expectedVertexCount)
+                : mMesh(mesh)
+                , mHeads(heads)
+            {
+                mVertices.reserve(expectedVertexCount);
+                resizeTable(std::max<size_t>(16, expectedVertexCount * 2));
+            }
+
+            /** Weld the vertex at the given face corner.
+                \return Local index of the vertex.
+            */
+            uint32_t weld(uint32_t corner)
+            {
+                const uint32_t face = corner / 3;
+                const uint32_t vert = corner % 3;
+                const Vertex v = mMesh.getVertex(face, vert);
+                const uint32_t origIndex = mMesh.pIndices[corner];
+                FALCOR_ASSERT(origIndex < mHeads.size());
+                const int64_t cell = getCell(v);
+
+                uint32_t found = kInvalidIndex;
+                if (cell == kSpecialCell)
+                {
+                    // Search the full list for the original vertex index.
+                    found = findInList(v, mHeads[origIndex], mNext);
+                }
+                else
+                {
+                    // Search the sub-lists of the neighboring cells and the special vertices. Keep the most recent match.
+                    const int64_t cells[4] = { cell - 1, cell, cell + 1, kSpecialCell };
+                    for (int64_t c : cells)
+                    {
+                        uint32_t index = findInList(v, mTable[findSlot(origIndex, c)].head, mCellNext);
+                        if (index != kInvalidIndex && (found == kInvalidIndex || index > found)) found = index;
+                    }
+                }
+                if (found != kInvalidIndex) return found;
+
+                // Insert new vertex.
+                if (mVertices.size() >= std::numeric_limits<uint32_t>::max()) throw RuntimeError("Mesh '{}' has too many vertices.", mMesh.name);
+                const uint32_t index = (uint32_t)mVertices.size();
+                mVertices.push_back(v);
+                mCorners.push_back(corner);
+                mNext.push_back(mHeads[origIndex]);
+                mHeads[origIndex] = index;
+
+                size_t slot = findSlot(origIndex, cell);
+                auto& entry = mTable[slot];
+                if (entry.head == kInvalidIndex)
+                {
+                    entry.origIndex = origIndex;
+                    entry.cell = cell;
+                    mUsedSlots++;
+                }
+                mCellNext.push_back(entry.head);
+                entry.head = index;
+
+                if (mUsedSlots * 2 > mTable.size()) resizeTable(mTable.size() * 2);
+
+                return index;
+            }
+
+            std::vector<Vertex>& getVertices() { return mVertices; }
+            std::vector<uint32_t>& getCorners() { return mCorners; }
+
+        private:
+            struct Entry
+            {
+                int64_t cell = 0;
+                uint32_t origIndex = 0;
+                uint32_t head = kInvalidIndex;  ///< First vertex in the sub-list, or kInvalidIndex if the slot is empty.
+            };
+
+            uint32_t findInList(const Vertex& v, uint32_t index, const std::vector<uint32_t>& next) const
+            {
+                while (index != kInvalidIndex)
+                {
+                    if (VertexWelder::compareVertices(v, mVertices[index])) return index;
+                    index = next[index];
+                }
+                return kInvalidIndex;
+            }
+
+            /** Find the slot for a key. Returns either the slot holding the key or the empty slot where it would be inserted.
+            */
+            size_t findSlot(uint32_t origIndex, int64_t cell) const
+            {
+                size_t slot = hashKey(origIndex, cell) & mTableMask;
+                while (mTable[slot].head != kInvalidIndex && (mTable[slot].origIndex != origIndex || mTable[slot].cell != cell))
+                {
+                    slot = (slot + 1) & mTableMask;
+                }
+                return slot;
+            }
+
+            void resizeTable(size_t size)
+            {
+                size_t capacity = 1;
+                while (capacity < size) capacity <<= 1;
+
+                std::vector<Entry> oldTable(capacity);
+                std::swap(mTable, oldTable);
+                mTableMask = capacity - 1;
+                for (const auto& entry : oldTable)
+                {
+                    if (entry.head != kInvalidIndex) mTable[findSlot(entry.origIndex, entry.cell)] = entry;
+                }
+            }
+
+            const Mesh& mMesh;
+            std::vector<uint32_t>& mHeads;      ///< List heads per original vertex index. Shared between partitions.
+
+            std::vector<Vertex> mVertices;      ///< Unique vertices.
+            std::vector<uint32_t> mCorners;     ///< First face corner per vertex.
+            std::vector<uint32_t> mNext;        ///< Next vertex in the list of the same original vertex index.
+            std::vector<uint32_t> mCellNext;    ///< Next vertex in the sub-list of the same original vertex index and cell.
+
+            std::vector<Entry> mTable;          ///< Open-addressing hash table (linear probing) of sub-list heads.
+            size_t mTableMask = 0;
+            size_t mUsedSlots = 0;
+        };
+
+        VertexWelder::Result weldLinkedList(const Mesh& mesh)
+        {
+            // A linked-list of vertices is built for each original vertex index.
+            // We iterate over all vertices and first check if a vertex is identical to any of the other vertices
+            // using the same original vertex index. If not, a new vertex is inserted and added to the list.
+            // The 'heads' array point to the first vertex in each list, and each vertex has an associated next-pointer.
+            // This ensures that adding to the linked lists do not require any dynamic memory allocation.
+            VertexWelder::Result result;
+            result.vertices.reserve(mesh.vertexCount);
+            result.indices.resize(mesh.indexCount);
+
+            std::vector<uint32_t> heads(mesh.vertexCount, kInvalidIndex);
+            std::vector<uint32_t> next;
+            next.reserve(mesh.vertexCount);
+
+            for (uint32_t face = 0; face < mesh.faceCount; face++)
+            {
+                for (uint32_t vert = 0; vert < 3; vert++)
+                {
+                    const Vertex v = mesh.getVertex(face, vert);
+                    const uint32_t origIndex = mesh.pIndices[face * 3 + vert];
+
+                    // Iterate over vertex list to check if it already exists.
+                    FALCOR_ASSERT(origIndex < heads.size());
+                    uint32_t index = heads[origIndex];
+                    bool found = false;
+
+                    while (index != kInvalidIndex)
+                    {
+                        if (VertexWelder::compareVertices(v, result.vertices[index]))
+                        {
+                            found = true;
+                            break;
+                        }
+                        index = next[index];
+                    }
+
+                    // Insert new vertex if we couldn't find it.
+                    if (!found)
+                    {
+                        FALCOR_ASSERT(result.vertices.size() < std::numeric_limits<uint32_t>::max());
+                        index = (uint32_t)result.vertices.size();
+                        result.vertices.push_back(v);
+                        result.corners.push_back(face * 3 + vert);
+                        next.push_back(heads[origIndex]);
+                        heads[origIndex] = index;
+                    }
+
+                    // Store new vertex index.
+                    result.indices[face * 3 + vert] = index;
+                }
+            }
+
+            return result;
+        }
+
+        VertexWelder::Result weldHash(const Mesh& mesh)
+        {
+            VertexWelder::Result result;
+            result.indices.resize(mesh.indexCount);
+
+            std::vector<uint32_t> heads(mesh.vertexCount, kInvalidIndex);
+            HashWelder welder(mesh, heads, mesh.vertexCount);
+            for (uint32_t corner = 0; corner < mesh.indexCount; ++corner) result.indices[corner] = welder.weld(corner);
+
+            result.vertices = std::move(welder.getVertices());
+            result.corners = std::move(welder.getCorners());
+            return result;
+        }
+
+        VertexWelder::Result weldParallelHash(const Mesh& mesh)
+        {
+            // Vertices with different original vertex indices are never merged. We partition the original vertex
+            // indices into contiguous ranges and weld each partition independently. Within a partition the face corners
+            // are processed in the original order, so each partition makes the same decisions as the serial algorithm.
+            // Finally the unique vertices are ordered by their first face corner to match the serial output.
+            const size_t cornerCount = mesh.indexCount;
+            const size_t partitionCount = std::min<size_t>(Threading::getThreadCount() * 4, std::max<size_t>(1, cornerCount / kMinCornersPerPartition));
+            if (partitionCount <= 1) return weldHash(mesh);
+
+            auto getPartition = [&](uint32_t origIndex) { return (uint32_t)((uint64_t)origIndex * partitionCount / mesh.vertexCount); };
+
+            // Sort the face corners by partition (stable counting sort).
+            std::vector<uint32_t> partitionOffsets(partitionCount + 1, 0);
+            for (size_t corner = 0; corner < cornerCount; ++corner)
+            {
+                if (mesh.pIndices[corner] >= mesh.vertexCount) throw RuntimeError("Mesh '{}' has out-of-range vertex indices.", mesh.name);
+                partitionOffsets[getPartition(mesh.pIndices[corner]) + 1]++;
+            }
+            for (size_t p = 0; p < partitionCount; ++p) partitionOffsets[p + 1] += partitionOffsets[p];
+
+            std::vector<uint32_t> sortedCorners(cornerCount);
+            {
+                std::vector<uint32_t> writeOffsets(partitionOffsets.begin(), partitionOffsets.end() - 1);
+                for (uint32_t corner = 0; corner < (uint32_t)cornerCount; ++corner) sortedCorners[writeOffsets[getPartition(mesh.pIndices[corner])]++] = corner;
+            }
+
+            // Weld partitions in parallel. Each partition only touches the heads of its own original vertex indices.
+            std::vector<uint32_t> heads(mesh.vertexCount, kInvalidIndex);
+            std::vector<uint32_t> localIndices(cornerCount);
+            std::vector<std::vector<Vertex>> partitionVertices(partitionCount);
+            std::vector<std::vector<uint32_t>> partitionCorners(partitionCount);
+
+            Threading::parallelFor(0, partitionCount, [&](size_t p)
+            {
+                const uint32_t begin = partitionOffsets[p];
+                const uint32_t end = partitionOffsets[p + 1];
+                HashWelder welder(mesh, heads, (size_t)mesh.vertexCount / partitionCount);
+                for (uint32_t i = begin; i < end; ++i) localIndices[sortedCorners[i]] = welder.weld(sortedCorners[i]);
+                partitionVertices[p] = std::move(welder.getVertices());
+                partitionCorners[p] = std::move(welder.getCorners());
+            });
+
+            // Assign global vertex indices in order of first face corner.
+            std::vector<uint32_t> globalOffsets(partitionCount + 1, 0);
+            for (size_t p = 0; p < partitionCount; ++p) globalOffsets[p + 1] = globalOffsets[p] + (uint32_t)partitionVertices[p].size();
+            const size_t vertexCount = globalOffsets[partitionCount];
+
+            std::vector<uint8_t> isFirstCorner(cornerCount, 0);
+            for (const auto& corners : partitionCorners)
+            {
+                for (uint32_t corner : corners) isFirstCorner[corner] = 1;
+            }
+
+            // 'localToGlobal' is indexed by the partition-relative vertex index offset by 'globalOffsets'.
+            VertexWelder::Result result;
+            result.vertices.resize(vertexCount);
+            result.corners.resize(vertexCount);
+            result.indices.resize(cornerCount);
+            std::vector<uint32_t> localToGlobal(vertexCount);
+
+            uint32_t globalIndex = 0;
+            for (uint32_t corner = 0; corner < (uint32_t)cornerCount; ++corner)
+            {
+                if (!isFirstCorner[corner]) continue;
+                const uint32_t p = getPartition(mesh.pIndices[corner]);
+                const uint32_t local = localIndices[corner];
+                localToGlobal[globalOffsets[p] + local] = globalIndex;
+                result.vertices[globalIndex] = partitionVertices[p][local];
+                result.corners[globalIndex] = corner;
+                globalIndex++;
+            }
+            FALCOR_ASSERT(globalIndex == vertexCount);
+
+            Threading::parallelFor(0, cornerCount, [&](size_t corner)
+            {
+                const uint32_t p = getPartition(mesh.pIndices[corner]);
+                result.indices[corner] = localToGlobal[globalOffsets[p] + localIndices[corner]];
+            }, kMinCornersPerPartition);
+
+            return result;
+        }
+    }
+
+    VertexWelder::Result VertexWelder::weld(const SceneBuilder::Mesh& mesh, Mode mode)
+    {
+        FALCOR_ASSERT(mesh.pIndices != nullptr);
+        FALCOR_ASSERT(mesh.indexCount == mesh.faceCount * 3);
+
+        switch (mode)
+        {
+        case Mode::LinkedList:
+            return weldLinkedList(mesh);
+        case Mode::Hash:
+            return weldHash(mesh);
+        case Mode::ParallelHash:
+            return weldParallelHash(mesh);
+        default:
+            FALCOR_UNREACHABLE();
+            return {};
+        }
+    }
+
+    bool VertexWelder::compareVertices(const SceneBuilder::Mesh::Vertex& lhs, const SceneBuilder::Mesh::Vertex& rhs, float threshold)
+    {
+        if (any(lhs.position != rhs.position)) return false; // Position need to be exact to avoid cracks
+        if (lhs.tangent.w != rhs.tangent.w) return false;
+        if (lhs.curveRadius != rhs.curveRadius) return false;
+        if (any(lhs.boneIDs != rhs.boneIDs)) return false;
+        if (any(abs(lhs.normal - rhs.normal) > float3(threshold))) return false;
+        if (any(abs(lhs.tangent.xyz() - rhs.tangent.xyz()) > float3(threshold))) return false;
+        if (any(abs(lhs.texCrd - rhs.texCrd) > float2(threshold))) return false;
+        if (any(abs(lhs.boneWeights - rhs.boneWeights) > float4(threshold))) return false;
+        return true;
+    }
+}
@@ -0,0 +1,71 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "SceneBuilder.h"
+#include "Core/Macros.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Merges duplicate vertices of a SceneBuilder mesh and builds a new index buffer.
+
+        Only vertices referenced through the same original vertex index are candidates for merging.
+        Positions, tangent sign, curve radius and bone IDs must match exactly, the remaining attributes
+        must match within a small threshold. If several previously inserted vertices match, the most
+        recently inserted one is used. All modes produce identical results.
+    */
+    class FALCOR_API VertexWelder
+    {
+    public:
+        enum class Mode
+        {
+            LinkedList,     ///< Reference implementation. Linear search through a linked list of vertices per original vertex index.
+            Hash,           ///< Vertices are additionally bucketed by original vertex index and quantized attributes in an open-addressing hash table. Only nearby buckets are searched.
+            ParallelHash,   ///< Same as Hash, but the original vertex indices are partitioned and welded in parallel. Small meshes are welded serially.
+        };
+
+        struct Result
+        {
+            std::vector<SceneBuilder::Mesh::Vertex> vertices;   ///< Unique vertices in order of first reference.
+            std::vector<uint32_t> indices;                      ///< New index buffer with one index per face corner.
+            std::vector<uint32_t> corners;                      ///< For each unique vertex, the first face corner (face * 3 + vert) referencing it.
+        };
+
+        /** Merge duplicate vertices.
+            \param[in] mesh Mesh description. The mesh must be indexed.
+            \param[in] mode Welding algorithm to use.
+            \return The unique vertices and the new index buffer.
+        */
+        static Result weld(const SceneBuilder::Mesh& mesh, Mode mode = Mode::Hash);
+
+        /** Compare two vertices using the merge criteria described above.
+        */
+        static bool compareVertices(const SceneBuilder::Mesh::Vertex& lhs, const SceneBuilder::Mesh::Vertex& rhs, float threshold = 1e-6f);
+    };
+}
@@ -35,6 +35,7 @@
 #include "Utils/Math/Common.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Math/Matrix.h"
+#include "Utils/Threading.h"
 #include "GlobalState.h"
 
 #ifdef _MSC_VER
@@ -74,6 +75,16 @@ namespace Falcor
         {
             return int3(c[0], c[1], c[2]);
         }
+
+        using NanoVDBGridConverter = NanoVDBConverterBC4;
+
+        void computeGridStats(nanovdb::FloatGrid* pFloatGrid)
+        {
+            if (!pFloatGrid->hasMinMax())
+            {
+                nanovdb::gridStats(*pFloatGrid);
+            }
+        }
     }
 
     ref<Grid> Grid::createSphere(ref<Device> pDevice, float radius, float voxelSize, float blendRange)
@@ -90,26 +101,55 @@ namespace Falcor
 
     ref<Grid> Grid::createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
     {
-        std::filesystem::path fullPath;
-        if (!findFileInDataDirectories(path, fullPath))
-        {
-            logWarning("Error when loading grid. Can't find grid file '{}'.", path);
-            return nullptr;
-        }
+        auto handle = readFile(path, gridname);
+        if (!handle) return nullptr;
+        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+    }
 
-        if (hasExtension(fullPath, "nvdb"))
-        {
-            return createFromNanoVDBFile(pDevice, fullPath, gridname);
-        }
-        else if (hasExtension(fullPath, "vdb"))
+    std::vector<ref<Grid>> Grid::createFromFiles(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname)
+    {
+        struct LoadedGrid
         {
-            return createFromOpenVDBFile(pDevice, fullPath, gridname);
-        }
-        else
+            nanovdb::GridHandle<nanovdb::HostBuffer> handle;
+            std::unique_ptr<NanoVDBGridConverter> pConverter;
+        };
+
+        std::vector<ref<Grid>> grids(paths.size());
+
+        // Load the grids in batches to bound the amount of brick data waiting for upload. Within a batch, the grids are
+        // read and converted to bricks in parallel. The textures are then created in order on the calling thread.
+        const size_t batchSize = 2 * (Threading::getThreadCount() + 1);
+        std::vector<LoadedGrid> batch;
+
+        for (size_t batchStart = 0; batchStart < paths.size(); batchStart += batchSize)
         {
-            logWarning("Error when loading grid. Unsupported grid file '{}'.", fullPath);
-            return nullptr;
+            const size_t batchEnd = std::min(batchStart + batchSize, paths.size());
+            batch.clear();
+            batch.resize(batchEnd - batchStart);
+
+            Threading::parallelFor(batchStart, batchEnd, [&](size_t i)
+            {
+                auto& loaded = batch[i - batchStart];
+                loaded.handle = readFile(paths[i], gridname);
+                if (!loaded.handle) return;
+
+                auto pFloatGrid = loaded.handle.grid<float>();
+                computeGridStats(pFloatGrid);
+                loaded.pConverter = std::make_unique<NanoVDBGridConverter>(pFloatGrid);
+                loaded.pConverter->build();
+            });
+
+            for (size_t i = batchStart; i < batchEnd; ++i)
+            {
+                auto& loaded = batch[i - batchStart];
+                if (!loaded.pConverter) continue;
+                BrickedGrid brickedGrid = loaded.pConverter->createTextures(pDevice);
+                loaded.pConverter.reset();
+                grids[i] = ref<Grid>(new Grid(pDevice, std::move(loaded.handle), std::move(brickedGrid)));
+            }
         }
+
+        return grids;
     }
 
     void Grid::renderUI(Gui::Widgets& widget)
@@ -203,15 +243,19 @@ namespace Falcor
     }
 
     Grid::Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle)
+        : Grid(pDevice, std::move(gridHandle), BrickedGrid())
+    {
+        mBrickedGrid = NanoVDBGridConverter(mpFloatGrid).convert(mpDevice);
+    }
+
+    Grid::Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle, BrickedGrid brickedGrid)
         : mpDevice(pDevice)
         , mGridHandle(std::move(gridHandle))
         , mpFloatGrid(mGridHandle.grid<float>())
         , mAccessor(mpFloatGrid->getAccessor())
+        , mBrickedGrid(std::move(brickedGrid))
     {
-        if (!mpFloatGrid->hasMinMax())
-        {
-            nanovdb::gridStats(*mpFloatGrid);
-        }
+        computeGridStats(mpFloatGrid);
 
         // Keep both NanoVDB and brick textures resident in GPU memory for simplicity for now (~15% increased footprint).
         mpBuffer = Buffer::createStructured(
@@ -222,42 +266,64 @@ namespace Falcor
             Buffer::CpuAccess::None,
             mGridHandle.data()
         );
-        using NanoVDBGridConverter = NanoVDBConverterBC4;
-        mBrickedGrid = NanoVDBGridConverter(mpFloatGrid).convert(mpDevice);
     }
 
-    ref<Grid> Grid::createFromNanoVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::readFile(const std::filesystem::path& path, const std::string& gridname)
+    {
+        std::filesystem::path fullPath;
+        if (!findFileInDataDirectories(path, fullPath))
+        {
+            logWarning("Error when loading grid. Can't find grid file '{}'.", path);
+            return {};
+        }
+
+        if (hasExtension(fullPath, "nvdb"))
+        {
+            return readNanoVDBFile(fullPath, gridname);
+        }
+        else if (hasExtension(fullPath, "vdb"))
+        {
+            return readOpenVDBFile(fullPath, gridname);
+        }
+        else
+        {
+            logWarning("Error when loading grid. Unsupported grid file '{}'.", fullPath);
+            return {};
+        }
+    }
+
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::readNanoVDBFile(const std::filesystem::path& path, const std::string& gridname)
     {
         if (!nanovdb::io::hasGrid(path.string(), gridname))
         {
             logWarning("Error when loading grid. Can't find grid '{}' in '{}'.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         auto handle = nanovdb::io::readGrid(path.string(), gridname);
         if (!handle)
         {
             logWarning("Error when loading grid.");
-            return nullptr;
+            return {};
         }
 
         auto floatGrid = handle.grid<float>();
         if (!floatGrid || floatGrid->gridType() != nanovdb::GridType::Float)
         {
             logWarning("Error when loading grid. Grid '{}' in '{}' is not of type float.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (floatGrid->isEmpty())
         {
             logWarning("Grid '{}' in '{}' is empty.", gridname, path);
-            return nullptr;
+            return {};
         }
 
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return handle;
     }
 
-    ref<Grid> Grid::createFromOpenVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::readOpenVDBFile(const std::filesystem::path& path, const std::string& gridname)
     {
         openvdb::initialize();
 
@@ -279,25 +345,26 @@ namespace Falcor
         if (!baseGrid)
         {
             logWarning("Error when loading grid. Can't find grid '{}' in '{}'.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (!baseGrid->isType<openvdb::FloatGrid>())
         {
             logWarning("Error when loading grid. Grid '{}' in '{}' is not of type float.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (baseGrid->empty())
         {
             logWarning("Grid '{}' in '{}' is empty.", gridname, path);
-            return nullptr;
+            return {};
         }
 
+        // The OpenVDB grid is released once converted, before the bricks are built from the NanoVDB grid.
         openvdb::FloatGrid::Ptr floatGrid = openvdb::gridPtrCast<openvdb::FloatGrid>(baseGrid);
         auto handle = nanovdb::openToNanoVDB(floatGrid);
 
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return handle;
     }
 
 
@@ -49,6 +49,7 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace Falcor
 {
@@ -88,6 +89,15 @@ namespace Falcor
         */
         static ref<Grid> createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname);
 
+        /** Create grids from a list of files, e.g. the frames of a grid sequence.
+            The files are read and converted in parallel on the thread pool. GPU resources are created on the calling thread.
+            \param[in] pDevice GPU device.
+            \param[in] paths File paths of the grids. See createFromFile().
+            \param[in] gridname Name of the grid to load from each file.
+            \return List of grids in the same order as the paths. Grids that failed to load are nullptr.
+        */
+        static std::vector<ref<Grid>> createFromFiles(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname);
+
         /** Render the UI.
         */
         void renderUI(Gui::Widgets& widget);
@@ -135,6 +145,10 @@ namespace Falcor
         */
         const nanovdb::GridHandle<nanovdb::HostBuffer>& getGridHandle() const;
 
+        /** Get the brick textures of the grid.
+        */
+        const BrickedGrid& getBrickedGrid() const { return mBrickedGrid; }
+
         /** Get the (affine) NanoVDB transformation matrix.
         */
         float4x4 getTransform() const;
@@ -145,9 +159,11 @@ namespace Falcor
 
     private:
         Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle);
+        Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle, BrickedGrid brickedGrid);
 
-        static ref<Grid> createFromNanoVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
-        static ref<Grid> createFromOpenVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> readFile(const std::filesystem::path& path, const std::string& gridname);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> readNanoVDBFile(const std::filesystem::path& path, const std::string& gridname);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> readOpenVDBFile(const std::filesystem::path& path, const std::string& gridname);
 
         ref<Device> mpDevice;
 
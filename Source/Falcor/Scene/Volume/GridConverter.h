@@ -31,7 +31,7 @@
 #include "Core/API/Formats.h"
 #include "Utils/Logger.h"
 #include "Utils/HostDeviceShared.slangh"
-#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Timing/CpuTimer.h"
 
@@ -45,8 +45,7 @@
 #endif
 
 #include <algorithm>
-#include <atomic>
-#include <execution>
+#include <numeric>
 #include <vector>
 
 namespace Falcor
@@ -63,20 +62,31 @@ namespace Falcor
         NanoVDBToBricksConverter(const nanovdb::FloatGrid* grid);
         NanoVDBToBricksConverter(const NanoVDBToBricksConverter& rhs) = delete;
 
+        /** Convert the grid and create the brick textures.
+        */
         BrickedGrid convert(ref<Device> pDevice);
 
+        /** Convert the grid to bricks in host memory. This does not access the GPU and can run on any thread.
+        */
+        void build();
+
+        /** Create the brick textures from the data computed by build().
+        */
+        BrickedGrid createTextures(ref<Device> pDevice) const;
+
     private:
         const static uint32_t kBrickSize = 8; // Must be 8, to match both NanoVDB leaf size.
         const static int32_t kBC4Compress = kBitsPerTexel == 4;
 
-        void convertSlice(int z);
+        uint32_t computeSliceRanges(int z);
+        void encodeSlice(int z);
         void computeMip(int mip);
 
         inline uint3 getAtlasSizeBricks() const { return mAtlasSizeBricks; }
         inline uint3 getAtlasSizePixels() const { return mAtlasSizeBricks * kBrickSize; }
         inline uint32_t getAtlasMaxBrick() const { return mAtlasSizeBricks.x * mAtlasSizeBricks.y * mAtlasSizeBricks.z; }
 
-        inline ResourceFormat getAtlasFormat() {
+        inline ResourceFormat getAtlasFormat() const {
             switch (kBitsPerTexel) {
             case 4: return ResourceFormat::BC4Unorm;
             case 8: return ResourceFormat::R8Unorm;
@@ -90,12 +100,6 @@ namespace Falcor
             return float2(std::max(a.x, b.x), std::min(a.y, b.y));
         }
 
-        inline float2 unpackMajMin(const uint32_t* data)
-        {
-            const uint16_t* data16 = (const uint16_t*)data;
-            return float2(f16tof32(data16[0]), f16tof32(data16[1]));
-        }
-
         inline void expandMinorantMajorant(float value, float& min_inout, float& maj_inout)
         {
             if (value < min_inout) min_inout = value;
@@ -110,13 +114,14 @@ namespace Falcor
         std::vector<uint32_t> mRangeData;
         std::vector<uint32_t> mPtrData;
         std::vector<TexelType> mAtlasData;
-        std::atomic_uint32_t mNonEmptyCount;
+        std::vector<float2> mBrickMajMin;         ///< Majorant/minorant per brick of the finest level. Only used during build().
+        std::vector<uint32_t> mSliceBrickOffsets; ///< First atlas brick per slice. The last entry is the number of non-empty bricks.
+        uint32_t mNonEmptyCount = 0;
     };
 
     template <typename TexelType, unsigned int kBitsPerTexel>
     NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::NanoVDBToBricksConverter(const nanovdb::FloatGrid* grid)
     {
-        mNonEmptyCount.store(0);
         mpFloatGrid = grid;
         auto& voxelbox = mpFloatGrid->indexBBox();
         mBBMin = (int3(voxelbox.min().x(), voxelbox.min().y(), voxelbox.min().z())) & (~7);
@@ -140,16 +145,11 @@ namespace Falcor
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertSlice(int z)
+    uint32_t NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeSliceRanges(int z)
     {
-        uint3 atlasSizePixels = getAtlasSizePixels();
-        uint brickMax = getAtlasMaxBrick();
-        uint bricksPerSlice = mAtlasSizeBricks.x * mAtlasSizeBricks.y;
-        uint pixelsPerSlice = atlasSizePixels.x * atlasSizePixels.y;
-
         size_t offset = z * mLeafDim[0].x * mLeafDim[0].y;
-        uint32_t* rangedst = mRangeData.data() + offset;
-        uint32_t* ptrdst = mPtrData.data() + offset;
+        float2* majmindst = mBrickMajMin.data() + offset;
+        uint32_t nonEmptyCount = 0;
         auto a = mpFloatGrid->getAccessor();
         for (int y = 0; y < mLeafDim[0].y; ++y)
         {
@@ -159,7 +159,6 @@ namespace Falcor
                 auto val = a.getValue(ijk);
                 auto leaf = a.probeLeaf(ijk);
                 float minorant = val, majorant = val;
-                uint myleaf = 0;
                 if (leaf)
                 {
                     // Nanovdb only stores minorant/majorant for active voxels, but we need all of them... Grab the central 8x8x8 first the quick way.
@@ -177,8 +176,38 @@ namespace Falcor
                     for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, kBrickSize)), minorant, majorant);
                     for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, kBrickSize)), minorant, majorant);
 
-                    if (minorant != majorant) myleaf = mNonEmptyCount.fetch_add(1);
+                    if (minorant != majorant) ++nonEmptyCount;
                 }
+                *majmindst++ = float2(majorant, minorant);
+            } // x brick loop
+        } // y brick loop
+        return nonEmptyCount;
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::encodeSlice(int z)
+    {
+        uint3 atlasSizePixels = getAtlasSizePixels();
+        uint brickMax = getAtlasMaxBrick();
+        uint bricksPerSlice = mAtlasSizeBricks.x * mAtlasSizeBricks.y;
+        uint pixelsPerSlice = atlasSizePixels.x * atlasSizePixels.y;
+
+        size_t offset = z * mLeafDim[0].x * mLeafDim[0].y;
+        const float2* majminsrc = mBrickMajMin.data() + offset;
+        uint32_t* rangedst = mRangeData.data() + offset;
+        uint32_t* ptrdst = mPtrData.data() + offset;
+        uint32_t nextBrick = mSliceBrickOffsets[z];
+        auto a = mpFloatGrid->getAccessor();
+        for (int y = 0; y < mLeafDim[0].y; ++y)
+        {
+            for (int x = 0; x < mLeafDim[0].x; ++x)
+            {
+                nanovdb::Coord ijk = { x * 8 + mBBMin.x, y * 8 + mBBMin.y, z * 8 + mBBMin.z };
+                auto leaf = a.probeLeaf(ijk);
+                float majorant = majminsrc->x, minorant = majminsrc->y;
+                ++majminsrc;
+                uint myleaf = 0;
+                if (leaf && minorant != majorant) myleaf = nextBrick++;
                 if (majorant == minorant || myleaf >= brickMax || leaf == nullptr)
                 {
                     *rangedst++ = f32tof16(majorant) + (f32tof16(majorant) << 16); // force identical major and minor
@@ -250,8 +279,8 @@ namespace Falcor
     template <typename TexelType, unsigned int kBitsPerTexel>
     void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeMip(int mip)
     {
-        uint32_t* rangedst = mRangeData.data() + mLeafCount[mip - 1];
-        uint32_t* rangesrc = mRangeData.data() + ((mip > 1) ? mLeafCount[mip - 2] : 0);
+        const uint32_t srcOffset = (mip > 1) ? mLeafCount[mip - 2] : 0;
+        const uint32_t dstOffset = mLeafCount[mip - 1];
         int3 leafdim_src = mLeafDim[mip - 1];
         uint32_t rowstride_src = leafdim_src.x;
         uint32_t slicestride_src = leafdim_src.y * rowstride_src;
@@ -260,38 +289,75 @@ namespace Falcor
         uint32_t rowstride_tgt = leafdim_tgt.x;
         uint32_t slicestride_tgt = leafdim_tgt.y * rowstride_tgt;
 
-        for (int z = 0; z < leafdim_tgt.z; ++z, rangesrc += slicestride_src)
+        // Unpack the fp16 majorant/minorant pairs of the source level in bulk, combine them in fp32 and pack the result in bulk.
+        const size_t srcCount = dstOffset - srcOffset;
+        const size_t dstCount = size_t(slicestride_tgt) * leafdim_tgt.z;
+        std::vector<float2> majmin_src(srcCount);
+        std::vector<float2> majmin_dst(dstCount);
+        math::convertFloat16ToFloat32(
+            fstd::span<const float16_t>((const float16_t*)(mRangeData.data() + srcOffset), srcCount * 2),
+            fstd::span<float>((float*)majmin_src.data(), srcCount * 2)
+        );
+
+        Threading::parallelFor(0, leafdim_tgt.z, [&](size_t z)
         {
-            for (int y = 0; y < leafdim_tgt.y; ++y, rangesrc += rowstride_src)
+            for (int y = 0; y < leafdim_tgt.y; ++y)
             {
+                const float2* rangesrc = majmin_src.data() + 2 * (z * slicestride_src + y * rowstride_src);
+                float2* rangedst = majmin_dst.data() + z * slicestride_tgt + y * rowstride_tgt;
                 for (int x = 0; x < leafdim_tgt.x; ++x, rangesrc += 2)
                 {
-                    float2 majmin_dst = combineMajMin(
+                    *rangedst++ = combineMajMin(
                         combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc), unpackMajMin(rangesrc + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + rowstride_src), unpackMajMin(rangesrc + 1 + rowstride_src))
+                            combineMajMin(rangesrc[0], rangesrc[1]),
+                            combineMajMin(rangesrc[rowstride_src], rangesrc[1 + rowstride_src])
                         ),
                         combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src), unpackMajMin(rangesrc + slicestride_src + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src + rowstride_src), unpackMajMin(rangesrc + slicestride_src + 1 + rowstride_src))
+                            combineMajMin(rangesrc[slicestride_src], rangesrc[slicestride_src + 1]),
+                            combineMajMin(rangesrc[slicestride_src + rowstride_src], rangesrc[slicestride_src + 1 + rowstride_src])
                         )
                     );
-                    *rangedst++ = f32tof16(majmin_dst.x) + (f32tof16(majmin_dst.y) << 16);
                 } // x
             } // y
-        } // z
+        }); // z
+
+        math::convertFloat32ToFloat16(
+            fstd::span<const float>((const float*)majmin_dst.data(), dstCount * 2),
+            fstd::span<float16_t>((float16_t*)(mRangeData.data() + dstOffset), dstCount * 2)
+        );
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
     BrickedGrid NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convert(ref<Device> pDevice)
+    {
+        build();
+        return createTextures(pDevice);
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::build()
     {
         auto t0 = CpuTimer::getCurrentTimePoint();
-        auto range = NumericRange<int>(0, mLeafDim[0].z);
-        std::for_each(std::execution::par, range.begin(), range.end(), [&](int z) { convertSlice(z); });
+
+        // Compute the value range of all bricks and count the non-empty bricks per slice.
+        // Atlas bricks are then assigned in slice order using a prefix sum over the counts, so that the atlas layout
+        // does not depend on the order in which the slices are processed.
+        mBrickMajMin.resize(mLeafCount[0]);
+        mSliceBrickOffsets.assign(mLeafDim[0].z + 1, 0);
+        Threading::parallelFor(0, mLeafDim[0].z, [&](size_t z) { mSliceBrickOffsets[z + 1] = computeSliceRanges(int(z)); });
+        std::partial_sum(mSliceBrickOffsets.begin(), mSliceBrickOffsets.end(), mSliceBrickOffsets.begin());
+        mNonEmptyCount = mSliceBrickOffsets.back();
+        Threading::parallelFor(0, mLeafDim[0].z, [&](size_t z) { encodeSlice(int(z)); });
+        mBrickMajMin = {};
+
         for (int mip = 1; mip < 4; ++mip) computeMip(mip);
         double dt = CpuTimer::calcDuration(t0, CpuTimer::getCurrentTimePoint());
         logInfo("converted in {}ms: mNonEmptyCount {} vs max {}", dt, mNonEmptyCount, getAtlasMaxBrick());
+    }
 
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    BrickedGrid NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::createTextures(ref<Device> pDevice) const
+    {
         BrickedGrid bricks;
         bricks.range = Texture::create3D(pDevice, mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RG16Float, 4, mRangeData.data(), ResourceBindFlags::ShaderResource, false);
         bricks.indirection = Texture::create3D(pDevice, mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RGBA8Uint, 1, mPtrData.data(), ResourceBindFlags::ShaderResource, false);
@@ -31,6 +31,7 @@
 #include "Utils/Logger.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "GlobalState.h"
+#include <algorithm>
 #include <set>
 #include <filesystem>
 
@@ -127,12 +128,8 @@ namespace Falcor
 
     uint32_t GridVolume::loadGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty)
     {
-        GridSequence grids;
-        for (const auto& path : paths)
-        {
-            auto grid = Grid::createFromFile(mpDevice, path, gridname);
-            if (keepEmpty || grid) grids.push_back(grid);
-        }
+        GridSequence grids = Grid::createFromFiles(mpDevice, paths, gridname);
+        if (!keepEmpty) grids.erase(std::remove(grids.begin(), grids.end(), nullptr), grids.end());
         setGridSequence(slot, grids);
         return (uint32_t)grids.size();
     }
@@ -116,6 +116,7 @@ namespace Falcor
         bool loadGrid(GridSlot slot, const std::filesystem::path& path, const std::string& gridname);
 
         /** Load a sequence of grids from files to a grid slot.
+            The files are loaded in parallel, see Grid::createFromFiles().
             Note: This will replace any existing grid sequence for that slot.
             \param[in] slot Grid slot.
             \param[in] paths File paths of the grids. Can also include a full path or relative path from a data directory.
@@ -0,0 +1,206 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "AsyncImageWriter.h"
+#include "Core/Errors.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+double getElapsedSeconds(CpuTimer::TimePoint start)
+{
+    return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1e-3;
+}
+} // namespace
+
+AsyncImageWriter::AsyncImageWriter() : AsyncImageWriter(Options{}) {}
+
+AsyncImageWriter::AsyncImageWriter(const Options& options) : mOptions(options)
+{
+    FALCOR_CHECK_ARG_GT(mOptions.threadCount, 0);
+    for (uint32_t i = 0; i < mOptions.threadCount; ++i)
+    {
+        mThreads.emplace_back(&AsyncImageWriter::runWorker, this);
+    }
+}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+    terminateWorkers();
+}
+
+void AsyncImageWriter::write(
+    const std::filesystem::path& path,
+    uint32_t width,
+    uint32_t height,
+    Bitmap::FileFormat fileFormat,
+    Bitmap::ExportFlags exportFlags,
+    ResourceFormat resourceFormat,
+    std::vector<uint8_t> data
+)
+{
+    FALCOR_CHECK_ARG(!data.empty());
+
+    uint64_t size = data.size();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // Wait until there is space in the queue. Images being written count until they are written.
+    auto hasSpace = [&]() { return mStats.queuedBytes == 0 || mStats.queuedBytes + size <= mOptions.maxQueuedBytes; };
+    if (!hasSpace())
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        mSpaceCondition.wait(lock, hasSpace);
+        mStats.blockedTime += getElapsedSeconds(startTime);
+    }
+
+    mStats.queuedBytes += size;
+    mQueue.push(WriteRequest{path, width, height, fileFormat, exportFlags, resourceFormat, std::move(data)});
+    mWorkCondition.notify_one();
+}
+
+void AsyncImageWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    auto isIdle = [&]() { return mQueue.empty() && mActiveCount == 0; };
+    if (!isIdle())
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        mIdleCondition.wait(lock, isIdle);
+        mStats.blockedTime += getElapsedSeconds(startTime);
+    }
+}
+
+AsyncImageWriter::Stats AsyncImageWriter::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Stats stats = mStats;
+    stats.queueSize = mQueue.size();
+    return stats;
+}
+
+void AsyncImageWriter::runWorker()
+{
+    // This function is the entry point for writer threads.
+    // The threads wait on the queue and encode and write the oldest image when woken up.
+
+    while (true)
+    {
+        // Wait on condition until more work is ready.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkCondition.wait(lock, [&]() { return mTerminate || !mQueue.empty(); });
+
+        // Terminate thread if there is no more work to do.
+        if (mQueue.empty())
+            break;
+
+        WriteRequest request = std::move(mQueue.front());
+        mQueue.pop();
+        mActiveCount++;
+
+        lock.unlock();
+
+        // Encode and write the image (this part is running in parallel).
+        // The image is written to a uniquely named temporary file, which replaces the destination file only if writing
+        // succeeded. Bitmap::saveImage() reports errors without throwing, so check that the file was written.
+        static thread_local std::mt19937_64 rng{std::random_device{}()};
+        std::filesystem::path tempPath = request.path;
+        tempPath.replace_filename(fmt::format("{}.{:016x}.tmp{}", request.path.stem(), rng(), request.path.extension()));
+
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        uint64_t fileSize = 0;
+        bool success = false;
+        std::error_code ec;
+        try
+        {
+            Bitmap::saveImage(
+                tempPath,
+                request.width,
+                request.height,
+                request.fileFormat,
+                request.exportFlags,
+                request.resourceFormat,
+                true /* isTopDown */,
+                request.data.data()
+            );
+            fileSize = std::filesystem::file_size(tempPath, ec);
+            if (!ec)
+                std::filesystem::rename(tempPath, request.path, ec);
+            success = !ec;
+            if (ec)
+                logWarning("Failed to write image '{}': {}", request.path, ec.message());
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Failed to write image '{}': {}", request.path, e.what());
+        }
+        if (!success)
+            std::filesystem::remove(tempPath, ec);
+        double encodeTime = getElapsedSeconds(startTime);
+
+        // Release the pixel data before signaling completion.
+        const uint64_t size = request.data.size();
+        request.data = {};
+
+        lock.lock();
+
+        mActiveCount--;
+        mStats.queuedBytes -= size;
+        mSpaceCondition.notify_all();
+        mStats.encodeTime += encodeTime;
+        if (success)
+        {
+            mStats.writtenCount++;
+            mStats.bytesWritten += fileSize;
+        }
+        else
+        {
+            mStats.failedCount++;
+        }
+        if (mQueue.empty() && mActiveCount == 0)
+            mIdleCondition.notify_all();
+    }
+}
+
+void AsyncImageWriter::terminateWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTerminate = true;
+    }
+
+    mWorkCondition.notify_all();
+
+    for (auto& thread : mThreads)
+        thread.join();
+}
+} // namespace Falcor
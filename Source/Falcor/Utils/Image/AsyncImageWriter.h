@@ -0,0 +1,154 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Bitmap.h"
+#include "Core/Macros.h"
+#include "Core/API/Formats.h"
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Utility class to write images to disk asynchronously.
+ *
+ * Images are queued with their pixel data and encoded by a fixed set of writer threads, which are kept alive for the
+ * lifetime of the writer. The amount of pixel data waiting in the queue is capped. When the cap is reached, write()
+ * blocks until the writer threads have caught up, so a producer that is faster than the disk is throttled instead of
+ * growing the queue without bound.
+ */
+class FALCOR_API AsyncImageWriter
+{
+public:
+    struct Options
+    {
+        /// Number of writer threads.
+        uint32_t threadCount = 4;
+        /// Maximum size in bytes of pixel data waiting to be written or being written. Writing an image blocks while the
+        /// limit is reached. An image is always accepted if no other image is pending, even if it is larger than the limit.
+        uint64_t maxQueuedBytes = 1ull << 30;
+    };
+
+    struct Stats
+    {
+        size_t queueSize = 0;      ///< Number of images waiting to be written.
+        uint64_t queuedBytes = 0;  ///< Size of the pixel data waiting to be written or being written.
+        uint64_t writtenCount = 0; ///< Number of images written.
+        uint64_t failedCount = 0;  ///< Number of images that failed to be written.
+        uint64_t bytesWritten = 0; ///< Total size of the written image files.
+        double encodeTime = 0.0;   ///< Total time in seconds spent encoding and writing, summed over all writer threads.
+        double blockedTime = 0.0;  ///< Total time in seconds write() and flush() blocked the calling thread.
+    };
+
+    /**
+     * Constructor.
+     */
+    AsyncImageWriter();
+
+    /**
+     * Constructor.
+     * @param[in] options Writer options.
+     */
+    explicit AsyncImageWriter(const Options& options);
+
+    /**
+     * Destructor.
+     * Blocks until all queued images are written and all threads have terminated.
+     */
+    ~AsyncImageWriter();
+
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+    /**
+     * Queue an image for writing. Blocks while the queue is full.
+     * The image is written to a temporary file first, so an existing file at the path is only replaced once the new image
+     * has been written successfully. See Bitmap::saveImage() for a description of the image parameters.
+     * @param[in] path Path of the file to save.
+     * @param[in] width Image width in pixels.
+     * @param[in] height Image height in pixels.
+     * @param[in] fileFormat Destination image file format.
+     * @param[in] exportFlags Save flags, see Bitmap::ExportFlags.
+     * @param[in] resourceFormat Format of the pixel data.
+     * @param[in] data Pixel data in top-down row order. The writer takes ownership of the data.
+     */
+    void write(
+        const std::filesystem::path& path,
+        uint32_t width,
+        uint32_t height,
+        Bitmap::FileFormat fileFormat,
+        Bitmap::ExportFlags exportFlags,
+        ResourceFormat resourceFormat,
+        std::vector<uint8_t> data
+    );
+
+    /**
+     * Block until all queued images are written.
+     */
+    void flush();
+
+    /**
+     * Get writer statistics.
+     */
+    Stats getStats() const;
+
+private:
+    struct WriteRequest
+    {
+        std::filesystem::path path;
+        uint32_t width;
+        uint32_t height;
+        Bitmap::FileFormat fileFormat;
+        Bitmap::ExportFlags exportFlags;
+        ResourceFormat resourceFormat;
+        std::vector<uint8_t> data;
+    };
+
+    void runWorker();
+    void terminateWorkers();
+
+    Options mOptions;
+
+    mutable std::mutex mMutex;               ///< Mutex for synchronizing access to shared resources.
+    std::condition_variable mWorkCondition;  ///< Condition variable for writer threads to wait on.
+    std::condition_variable mSpaceCondition; ///< Condition variable for write() to wait on until the queue has space.
+    std::condition_variable mIdleCondition;  ///< Condition variable for flush() to wait on until all images are written.
+    std::vector<std::thread> mThreads;       ///< Writer threads.
+
+    // Internal state. Do not access outside of critical section.
+    std::queue<WriteRequest> mQueue; ///< Write request queue.
+    size_t mActiveCount = 0;         ///< Number of images currently being written.
+    bool mTerminate = false;         ///< Flag to terminate writer threads.
+    Stats mStats;                    ///< Writer statistics.
+};
+} // namespace Falcor
@@ -26,19 +26,243 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "AsyncTextureLoader.h"
+#include "ImageIO.h"
 #include "Core/API/Device.h"
-#include "Utils/Threading.h"
+#include "Core/API/RenderContext.h"
+#include "Core/Errors.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Math/Float16.h"
+#include "Utils/Math/XXHash.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace Falcor
 {
 namespace
 {
-constexpr size_t kUploadsPerFlush = 16; ///< Number of texture uploads before issuing a flush (to keep upload heap from growing).
+constexpr bool kTopDown = true; // Memory layout when loading from file
+
+/**
+ * Comparison function for ordering the decode queue heap. The top of the heap is the request with
+ * the highest priority, and the oldest request of equal priority.
+ */
+template<typename T>
+bool isLowerPriority(const T& lhs, const T& rhs)
+{
+    if (lhs.priority != rhs.priority)
+        return lhs.priority < rhs.priority;
+    return lhs.sequenceNumber > rhs.sequenceNumber;
+}
+
+double getElapsedSeconds(CpuTimer::TimePoint start)
+{
+    return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1e-3;
+}
+
+uint32_t getMipChainLength(uint32_t width, uint32_t height)
+{
+    uint32_t mipCount = 1;
+    while ((std::max(width, height) >> mipCount) > 0)
+        mipCount++;
+    return mipCount;
+}
+
+/**
+ * Check if an image format can be downsampled on the CPU.
+ * Supported are uncompressed formats with 8/16-bit unorm (optionally sRGB) and 16/32-bit float channels, which covers all formats
+ * of images decoded by Bitmap.
+ */
+bool isDownsampleSupported(ResourceFormat format)
+{
+    if (isCompressedFormat(format))
+        return false;
+    FormatType type = getFormatType(format);
+    uint32_t bits = 0;
+    for (uint32_t c = 0; c < getFormatChannelCount(format); c++)
+    {
+        uint32_t channelBits = getNumChannelBits(format, (int)c);
+        bool isUnorm = (type == FormatType::Unorm || type == FormatType::UnormSrgb) && (channelBits == 8 || channelBits == 16);
+        bool isFloat = type == FormatType::Float && (channelBits == 16 || channelBits == 32);
+        if (!isUnorm && !isFloat)
+            return false;
+        bits += channelBits;
+    }
+    return bits == getFormatBytesPerBlock(format) * 8;
+}
+
+float srgbToLinear(float v)
+{
+    return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float v)
+{
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.f / 2.4f) - 0.055f;
+}
+
+/**
+ * Downsample an image to a coarser mip level with a 2x2 box filter per level, like mip generation on the GPU.
+ * Each level is computed from the previous one in the image format, so only the image and its first reduced level are in memory
+ * at the same time. sRGB channels are filtered in linear space. The format must be supported by isDownsampleSupported().
+ * @param[in] bitmap Image to downsample.
+ * @param[in] format Format of the image data, including sRGB.
+ * @param[in] mipLevel Mip level to downsample to.
+ * @return Downsampled image.
+ */
+Bitmap::UniqueConstPtr downsampleBitmap(const Bitmap& bitmap, ResourceFormat format, uint32_t mipLevel)
+{
+    FALCOR_ASSERT(isDownsampleSupported(format));
+    const uint32_t channelCount = getFormatChannelCount(format);
+    const uint32_t bytesPerPixel = getFormatBytesPerBlock(format);
+    const bool isFloat = getFormatType(format) == FormatType::Float;
+    const bool isSrgb = isSrgbFormat(format);
+    uint32_t channelBits[4] = {};
+    uint32_t channelOffsets[4] = {};
+    for (uint32_t c = 0, offset = 0; c < channelCount; c++)
+    {
+        channelBits[c] = getNumChannelBits(format, (int)c);
+        channelOffsets[c] = offset;
+        offset += channelBits[c] / 8;
+    }
+
+    float srgbTable[256];
+    for (uint32_t i = 0; i < 256; i++)
+        srgbTable[i] = srgbToLinear(i / 255.f);
+
+    auto load = [&](const uint8_t* pPixel, uint32_t c)
+    {
+        const uint8_t* pSrc = pPixel + channelOffsets[c];
+        if (channelBits[c] == 8)
+            return (isSrgb && c < 3) ? srgbTable[*pSrc] : *pSrc / 255.f;
+        if (channelBits[c] == 16)
+        {
+            uint16_t bits;
+            std::memcpy(&bits, pSrc, sizeof(bits));
+            return isFloat ? math::float16ToFloat32(bits) : bits / 65535.f;
+        }
+        float value;
+        std::memcpy(&value, pSrc, sizeof(value));
+        return value;
+    };
+
+    auto store = [&](uint8_t* pPixel, uint32_t c, float value)
+    {
+        uint8_t* pDst = pPixel + channelOffsets[c];
+        if (channelBits[c] == 8)
+        {
+            value = (isSrgb && c < 3) ? linearToSrgb(value) : value;
+            *pDst = uint8_t(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+        }
+        else if (channelBits[c] == 16)
+        {
+            uint16_t bits = isFloat ? math::float32ToFloat16(value) : uint16_t(std::clamp(value, 0.f, 1.f) * 65535.f + 0.5f);
+            std::memcpy(pDst, &bits, sizeof(bits));
+        }
+        else
+        {
+            std::memcpy(pDst, &value, sizeof(value));
+        }
+    };
+
+    // Downsample one level at a time. Odd dimensions drop the last row/column like the GPU blit does.
+    uint32_t width = bitmap.getWidth();
+    uint32_t height = bitmap.getHeight();
+    const uint8_t* pSrcData = bitmap.getData();
+    size_t srcRowPitch = bitmap.getRowPitch();
+    std::vector<uint8_t> data;
+    for (uint32_t mip = 0; mip < mipLevel; mip++)
+    {
+        uint32_t dstWidth = std::max(1u, width / 2);
+        uint32_t dstHeight = std::max(1u, height / 2);
+        std::vector<uint8_t> dstData(size_t(dstWidth) * dstHeight * bytesPerPixel);
+        for (uint32_t y = 0; y < dstHeight; y++)
+        {
+            const uint8_t* pRow0 = pSrcData + size_t(std::min(2 * y, height - 1)) * srcRowPitch;
+            const uint8_t* pRow1 = pSrcData + size_t(std::min(2 * y + 1, height - 1)) * srcRowPitch;
+            for (uint32_t x = 0; x < dstWidth; x++)
+            {
+                size_t x0 = size_t(std::min(2 * x, width - 1)) * bytesPerPixel;
+                size_t x1 = size_t(std::min(2 * x + 1, width - 1)) * bytesPerPixel;
+                uint8_t* pDst = dstData.data() + (size_t(y) * dstWidth + x) * bytesPerPixel;
+                for (uint32_t c = 0; c < channelCount; c++)
+                {
+                    float sum = load(pRow0 + x0, c) + load(pRow0 + x1, c) + load(pRow1 + x0, c) + load(pRow1 + x1, c);
+                    store(pDst, c, 0.25f * sum);
+                }
+            }
+        }
+        data = std::move(dstData);
+        pSrcData = data.data();
+        srcRowPitch = size_t(dstWidth) * bytesPerPixel;
+        width = dstWidth;
+        height = dstHeight;
+    }
+
+    return Bitmap::create(width, height, bitmap.getFormat(), pSrcData);
 }
+} // namespace
+
+/**
+ * Texture data decoded to CPU memory, ready for upload.
+ */
+struct AsyncTextureLoader::DecodedTexture
+{
+    std::filesystem::path sourcePath;         ///< Full path of the texture file, or of mip0.
+    std::vector<Bitmap::UniqueConstPtr> mips; ///< Decoded mip levels. Empty for DDS files, which are read when uploading.
+    ResourceFormat format = ResourceFormat::Unknown;
+    TextureInfo info; ///< Description of the full resolution texture.
+    Analysis analysis;
+    uint64_t size = 0;        ///< Size of the decoded data in bytes.
+    uint64_t contentHash = 0; ///< Hash of the decoded data, or of the file contents for DDS files.
+    uint32_t skippedMips = 0; ///< Number of leading mip levels dropped from the decoded data.
+
+    /**
+     * Drop the decoded mip levels above the first mip level to load, so that only the data that is uploaded stays in memory.
+     * Single images are downsampled to the first mip level if the format supports it. DDS files are not affected.
+     * @param[in] firstMip First mip level to load, relative to the full resolution texture.
+     */
+    void skipMips(uint32_t firstMip)
+    {
+        if (mips.empty())
+            return;
 
-AsyncTextureLoader::AsyncTextureLoader(ref<Device> pDevice, size_t threadCount) : mpDevice(pDevice)
+        firstMip = std::min(firstMip, std::max(info.mipCount, 1u) - 1);
+        if (firstMip <= skippedMips)
+            return;
+
+        const uint32_t count = firstMip - skippedMips;
+        if (mips.size() > 1)
+        {
+            mips.erase(mips.begin(), mips.begin() + count);
+        }
+        else if (isDownsampleSupported(format))
+        {
+            mips[0] = downsampleBitmap(*mips[0], format, count);
+        }
+        else
+        {
+            return;
+        }
+        skippedMips = firstMip;
+
+        size = 0;
+        for (const auto& pMip : mips)
+            size += pMip->getSize();
+    }
+};
+
+AsyncTextureLoader::AsyncTextureLoader(ref<Device> pDevice, size_t threadCount)
+    : AsyncTextureLoader(pDevice, Options{threadCount})
+{}
+
+AsyncTextureLoader::AsyncTextureLoader(ref<Device> pDevice, const Options& options) : mpDevice(pDevice), mOptions(options)
 {
-    runWorkers(threadCount);
+    FALCOR_CHECK_ARG_GT(mOptions.threadCount, 0);
+    runWorkers(mOptions.threadCount);
 }
 
 AsyncTextureLoader::~AsyncTextureLoader()
@@ -52,13 +276,12 @@ std::future<ref<Texture>> AsyncTextureLoader::loadMippedFromFiles(
     fstd::span<const std::filesystem::path> paths,
     bool loadAsSrgb,
     Resource::BindFlags bindFlags,
-    LoadCallback callback
+    LoadCallback callback,
+    int priority,
+    CancellationToken cancellationToken
 )
 {
-    std::lock_guard<std::mutex> lock(mMutex);
-    mLoadRequestQueue.push(LoadRequest{{paths.begin(), paths.end()}, false, loadAsSrgb, bindFlags, callback});
-    mCondition.notify_one();
-    return mLoadRequestQueue.back().promise.get_future();
+    return enqueue(LoadRequest{{paths.begin(), paths.end()}, false, loadAsSrgb, bindFlags, callback, priority, cancellationToken});
 }
 
 std::future<ref<Texture>> AsyncTextureLoader::loadFromFile(
@@ -66,100 +289,459 @@ std::future<ref<Texture>> AsyncTextureLoader::loadFromFile(
     bool generateMipLevels,
     bool loadAsSrgb,
     Resource::BindFlags bindFlags,
-    LoadCallback callback
+    LoadCallback callback,
+    int priority,
+    CancellationToken cancellationToken
+)
+{
+    return enqueue(LoadRequest{{path}, generateMipLevels, loadAsSrgb, bindFlags, callback, priority, cancellationToken});
+}
+
+std::future<ref<Texture>> AsyncTextureLoader::loadMipRange(
+    fstd::span<const std::filesystem::path> paths,
+    bool generateMipLevels,
+    bool loadAsSrgb,
+    uint32_t firstMip,
+    uint32_t mipCount,
+    Resource::BindFlags bindFlags,
+    LoadCallback callback,
+    int priority,
+    CancellationToken cancellationToken
+)
+{
+    LoadRequest request{{paths.begin(), paths.end()}, generateMipLevels, loadAsSrgb, bindFlags, callback, priority, cancellationToken};
+    request.firstMip = firstMip;
+    request.mipCount = mipCount;
+    return enqueue(std::move(request));
+}
+
+AsyncTextureLoader::Stats AsyncTextureLoader::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Stats stats = mStats;
+    stats.decodeQueueSize = mDecodeQueue.size();
+    stats.uploadQueueSize = mUploadQueue.size();
+    return stats;
+}
+
+ref<Texture> AsyncTextureLoader::loadTexture(
+    ref<Device> pDevice,
+    fstd::span<const std::filesystem::path> paths,
+    bool generateMipLevels,
+    bool loadAsSRGB,
+    Resource::BindFlags bindFlags,
+    Analysis* pAnalysis,
+    const ContentHashCallback& contentHashCallback,
+    const FirstMipCallback& firstMipCallback
 )
 {
+    ref<Texture> pTexture;
+    auto pDecoded = decodeTexture(paths, generateMipLevels, loadAsSRGB, bool(contentHashCallback), pAnalysis != nullptr);
+    if (pDecoded && (!contentHashCallback || contentHashCallback(pDecoded->contentHash)))
+    {
+        uint32_t firstMip = firstMipCallback ? firstMipCallback(pDecoded->info) : 0;
+        pDecoded->skipMips(firstMip);
+        pTexture = uploadTexture(pDevice, *pDecoded, generateMipLevels, loadAsSRGB, bindFlags, firstMip);
+    }
+
+    if (pAnalysis)
+        *pAnalysis = pTexture ? pDecoded->analysis : Analysis();
+    return pTexture;
+}
+
+std::future<ref<Texture>> AsyncTextureLoader::enqueue(LoadRequest request)
+{
+    FALCOR_CHECK_ARG(!request.paths.empty());
+
     std::lock_guard<std::mutex> lock(mMutex);
-    mLoadRequestQueue.push(LoadRequest{{path}, generateMipLevels, loadAsSrgb, bindFlags, callback});
-    mCondition.notify_one();
-    return mLoadRequestQueue.back().promise.get_future();
+    request.sequenceNumber = mNextSequenceNumber++;
+    auto future = request.promise.get_future();
+    mDecodeQueue.push_back(std::move(request));
+    std::push_heap(mDecodeQueue.begin(), mDecodeQueue.end(), isLowerPriority<LoadRequest>);
+    mDecodeCondition.notify_one();
+    return future;
 }
 
-void AsyncTextureLoader::runWorkers(size_t threadCount)
+std::unique_ptr<AsyncTextureLoader::DecodedTexture> AsyncTextureLoader::decodeTexture(
+    fstd::span<const std::filesystem::path> paths,
+    bool generateMipLevels,
+    bool loadAsSRGB,
+    bool computeContentHash,
+    bool analyze
+)
+{
+    auto pDecoded = std::make_unique<DecodedTexture>();
+
+    try
+    {
+        if (paths.size() == 1)
+        {
+            if (!findFileInDataDirectories(paths[0], pDecoded->sourcePath))
+            {
+                logWarning("Error when loading image file. Can't find image file '{}'.", paths[0]);
+                return nullptr;
+            }
+
+            // DDS files are loaded directly into a texture when uploading. Only the header is read, and the file contents if requested.
+            if (hasExtension(pDecoded->sourcePath, "dds"))
+            {
+                auto ddsInfo = ImageIO::readDDSInfo(pDecoded->sourcePath, loadAsSRGB);
+                pDecoded->info = {ddsInfo.width, ddsInfo.height, ddsInfo.mipCount, ddsInfo.format};
+                pDecoded->format = ddsInfo.format;
+                pDecoded->size = std::filesystem::file_size(pDecoded->sourcePath);
+                if (computeContentHash)
+                {
+                    MemoryMappedFile file(pDecoded->sourcePath, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+                    if (!file.isOpen())
+                        throw RuntimeError("Failed to open file.");
+                    pDecoded->contentHash = xxHash64(file.getData(), file.getSize());
+                }
+                return pDecoded;
+            }
+
+            auto pBitmap = Bitmap::createFromFile(pDecoded->sourcePath, kTopDown);
+            if (!pBitmap)
+                return nullptr;
+            pDecoded->mips.emplace_back(std::move(pBitmap));
+        }
+        else
+        {
+            auto& mips = pDecoded->mips;
+            for (const auto& path : paths)
+            {
+                Bitmap::UniqueConstPtr pBitmap;
+                if (hasExtension(path, "dds"))
+                {
+                    pBitmap = ImageIO::loadBitmapFromDDS(path);
+                }
+                else
+                {
+                    pBitmap = Bitmap::createFromFile(path, kTopDown);
+                }
+                if (!pBitmap)
+                {
+                    logWarning("Error loading mip {}. Loading failed for image file '{}'.", mips.size(), path);
+                    break;
+                }
+
+                if (!mips.empty())
+                {
+                    if (mips.back()->getFormat() != pBitmap->getFormat())
+                    {
+                        logWarning("Error loading mip {} from file {}. Texture format of all mip levels must match.", mips.size(), path);
+                        break;
+                    }
+                    if (std::max(mips.back()->getWidth() / 2, 1u) != pBitmap->getWidth() ||
+                        std::max(mips.back()->getHeight() / 2, 1u) != pBitmap->getHeight())
+                    {
+                        logWarning(
+                            "Error loading mip {} from file {}. Image resolution must decrease by half. ({}, {}) != ({}, {})/2",
+                            mips.size(), path, pBitmap->getWidth(), pBitmap->getHeight(), mips.back()->getWidth(),
+                            mips.back()->getHeight()
+                        );
+                        break;
+                    }
+                }
+                else
+                {
+                    pDecoded->sourcePath = path;
+                }
+                mips.emplace_back(std::move(pBitmap));
+            }
+
+            if (mips.empty())
+                return nullptr;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        logWarning("Error loading '{}': {}", paths[0], e.what());
+        return nullptr;
+    }
+
+    const Bitmap& mip0 = *pDecoded->mips[0];
+    pDecoded->format = loadAsSRGB ? linearToSrgbFormat(mip0.getFormat()) : mip0.getFormat();
+    pDecoded->info.width = mip0.getWidth();
+    pDecoded->info.height = mip0.getHeight();
+    pDecoded->info.mipCount = pDecoded->mips.size() > 1 ? (uint32_t)pDecoded->mips.size()
+                              : generateMipLevels       ? getMipChainLength(mip0.getWidth(), mip0.getHeight())
+                                                        : 1;
+    pDecoded->info.format = pDecoded->format;
+    for (const auto& pMip : pDecoded->mips)
+        pDecoded->size += pMip->getSize();
+
+    if (computeContentHash)
+    {
+        pDecoded->contentHash = xxHash64(&pDecoded->format, sizeof(pDecoded->format));
+        for (const auto& pMip : pDecoded->mips)
+        {
+            const uint32_t dims[2] = {pMip->getWidth(), pMip->getHeight()};
+            pDecoded->contentHash = xxHash64(dims, sizeof(dims), pDecoded->contentHash);
+            pDecoded->contentHash = xxHash64(pMip->getData(), pMip->getSize(), pDecoded->contentHash);
+        }
+    }
+
+    // Analyze the texture contents while the image data is in memory.
+    if (analyze)
+    {
+        pDecoded->analysis =
+            TextureAnalyzer::analyzeImage(pDecoded->format, mip0.getWidth(), mip0.getHeight(), mip0.getData(), mip0.getRowPitch());
+    }
+
+    return pDecoded;
+}
+
+ref<Texture> AsyncTextureLoader::uploadTexture(
+    ref<Device> pDevice,
+    const DecodedTexture& decoded,
+    bool generateMipLevels,
+    bool loadAsSRGB,
+    Resource::BindFlags bindFlags,
+    uint32_t firstMip,
+    uint32_t mipCount
+)
 {
-    // Create a barrier to synchronize worker threads before issuing a global flush.
-    mFlushBarrier = std::make_shared<Barrier>(
-        threadCount,
-        [&]()
+    // Only the requested mips are uploaded. The first requested mip becomes mip 0 of the texture.
+    firstMip = std::min(firstMip, std::max(decoded.info.mipCount, 1u) - 1);
+    FALCOR_ASSERT(firstMip >= decoded.skippedMips);
+    const uint32_t baseMip = firstMip - decoded.skippedMips; // First mip to upload, relative to the decoded data.
+
+    ref<Texture> pTex;
+    if (decoded.mips.empty())
+    {
+        try
+        {
+            pTex = ImageIO::loadTextureFromDDS(pDevice, decoded.sourcePath, loadAsSRGB, firstMip, mipCount);
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Error loading '{}': {}", decoded.sourcePath, e.what());
+        }
+    }
+    else if (decoded.mips.size() == 1)
+    {
+        // Mips that were not dropped on the decode threads are reduced on the GPU.
+        const Bitmap& bitmap = *decoded.mips[0];
+        const uint32_t mipLevels = generateMipLevels ? Texture::kMaxPossible : 1;
+        pTex = Texture::create2D(pDevice, bitmap.getWidth(), bitmap.getHeight(), decoded.format, 1, mipLevels, bitmap.getData(), bindFlags);
+
+        if (pTex && baseMip > 0)
+        {
+            ref<Texture> pFull = pTex;
+            pTex = Texture::create2D(
+                pDevice, pFull->getWidth(baseMip), pFull->getHeight(baseMip), pFull->getFormat(), 1, pFull->getMipCount() - baseMip,
+                nullptr, bindFlags
+            );
+            std::lock_guard<std::mutex> lock(pDevice->getGlobalGfxMutex());
+            RenderContext* pRenderContext = pDevice->getRenderContext();
+            for (uint32_t mip = 0; mip < pTex->getMipCount(); mip++)
+            {
+                pRenderContext->copySubresource(
+                    pTex.get(), pTex->getSubresourceIndex(0, mip), pFull.get(), pFull->getSubresourceIndex(0, baseMip + mip)
+                );
+            }
+        }
+    }
+    else
+    {
+        // Combine the mip data of the requested mips into a single buffer
+        const size_t endMip = std::min<size_t>(decoded.mips.size(), size_t(baseMip) + mipCount);
+        size_t size = 0;
+        for (size_t mip = baseMip; mip < endMip; mip++)
+            size += decoded.mips[mip]->getSize();
+
+        size_t copyDst = 0;
+        std::unique_ptr<uint8_t[]> combinedData(new uint8_t[size]);
+        for (size_t mip = baseMip; mip < endMip; mip++)
         {
-            mpDevice->flushAndSync();
-            mFlushPending = false;
-            mUploadCounter = 0;
+            std::memcpy(&combinedData[copyDst], decoded.mips[mip]->getData(), decoded.mips[mip]->getSize());
+            copyDst += decoded.mips[mip]->getSize();
         }
-    );
 
+        // Create mip mapped latent texture
+        const Bitmap& base = *decoded.mips[baseMip];
+        pTex = Texture::create2D(
+            pDevice, base.getWidth(), base.getHeight(), decoded.format, 1, uint32_t(endMip - baseMip), combinedData.get(), bindFlags
+        );
+    }
+
+    if (pTex != nullptr)
+    {
+        pTex->setSourcePath(decoded.sourcePath);
+
+        // Log debug info.
+        logDebug(
+            "Loaded texture: size={}x{} mips={} format={} path={}", pTex->getWidth(), pTex->getHeight(), pTex->getMipCount(),
+            to_string(pTex->getFormat()), decoded.sourcePath
+        );
+    }
+
+    return pTex;
+}
+
+void AsyncTextureLoader::runWorkers(size_t threadCount)
+{
     for (size_t i = 0; i < threadCount; ++i)
     {
-        mThreads.emplace_back(&AsyncTextureLoader::runWorker, this);
+        mDecodeThreads.emplace_back(&AsyncTextureLoader::runDecodeWorker, this);
     }
+    mUploadThread = std::thread(&AsyncTextureLoader::runUploadWorker, this);
 }
 
-void AsyncTextureLoader::runWorker()
+void AsyncTextureLoader::runDecodeWorker()
 {
-    // This function is the entry point for worker threads.
-    // The workers wait on the load request queue and load a texture when woken up.
-    // To avoid the upload heap growing too large, we synchronize the threads and
-    // issue a global GPU flush at regular intervals.
+    // This function is the entry point for decode threads.
+    // The threads wait on the decode queue and decode the request with the highest priority when woken up.
+    // Decoding pauses while the size of the decoded images waiting for upload exceeds the limit.
 
     while (true)
     {
         // Wait on condition until more work is ready.
         std::unique_lock<std::mutex> lock(mMutex);
-        mCondition.wait(lock, [&]() { return mTerminate || !mLoadRequestQueue.empty() || mFlushPending; });
+        mDecodeCondition.wait(
+            lock,
+            [&]()
+            {
+                return (mTerminate && mDecodeQueue.empty()) ||
+                       (!mDecodeQueue.empty() && mStats.decodedBytesInFlight < mOptions.maxDecodedBytes);
+            }
+        );
+
+        // Terminate thread if there is no more work to do.
+        if (mDecodeQueue.empty())
+            break;
+
+        // Pop request with the highest priority from queue.
+        std::pop_heap(mDecodeQueue.begin(), mDecodeQueue.end(), isLowerPriority<LoadRequest>);
+        LoadRequest request = std::move(mDecodeQueue.back());
+        mDecodeQueue.pop_back();
+        mActiveDecodeCount++;
+
+        lock.unlock();
+
+        // Decode the texture (this part is running in parallel).
+        std::unique_ptr<DecodedTexture> pDecoded;
+        double decodeTime = 0.0;
+        if (!request.cancellationToken.isCancelled())
+        {
+            auto startTime = CpuTimer::getCurrentTimePoint();
+            pDecoded = decodeTexture(request.paths, request.generateMipLevels, request.loadAsSRGB, false, bool(request.callback));
+            // Drop the mips that are not loaded here, so that only the uploaded data counts towards the decoded bytes limit.
+            if (pDecoded)
+                pDecoded->skipMips(request.firstMip);
+            decodeTime = getElapsedSeconds(startTime);
+        }
+
+        lock.lock();
+
+        mActiveDecodeCount--;
+        mStats.decodeTime += decodeTime;
 
-        // Sync thread if a flush is pending.
-        if (mFlushPending)
+        if (pDecoded && !request.cancellationToken.isCancelled())
         {
+            // Pass the decoded texture on to the upload thread.
+            mStats.decodedCount++;
+            mStats.decodedBytes += pDecoded->size;
+            mStats.decodedBytesInFlight += pDecoded->size;
+            mUploadQueue.push(UploadRequest{std::move(request), std::move(pDecoded)});
             lock.unlock();
-            mFlushBarrier->wait();
-            mCondition.notify_one();
-            continue;
         }
+        else
+        {
+            if (request.cancellationToken.isCancelled())
+                mStats.cancelledCount++;
+            else
+                mStats.failedCount++;
+            lock.unlock();
 
-        // Terminate thread unless there is more work to do.
-        if (mTerminate && mLoadRequestQueue.empty() && !mFlushPending)
-            break;
+            finishRequest(request, nullptr, {});
+        }
+
+        // Notify the upload thread also if nothing was queued, as it terminates once decoding is finished.
+        mUploadCondition.notify_one();
+    }
+}
+
+void AsyncTextureLoader::runUploadWorker()
+{
+    // This function is the entry point for the upload thread.
+    // The thread waits on the upload queue and creates the textures from the decoded images.
+    // To avoid the upload heap growing too large, a GPU flush is issued at regular intervals.
+
+    uint64_t bytesSinceFlush = 0;
+    uint32_t uploadsSinceFlush = 0;
+
+    while (true)
+    {
+        // Wait on condition until more work is ready.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mUploadCondition.wait(
+            lock, [&]() { return !mUploadQueue.empty() || (mTerminate && mDecodeQueue.empty() && mActiveDecodeCount == 0); }
+        );
 
-        // Go back waiting if queue is currently empty.
-        if (mLoadRequestQueue.empty())
-            continue;
+        // Terminate thread if there is no more work to do.
+        if (mUploadQueue.empty())
+            break;
 
-        // Pop next load request from queue.
-        auto request = std::move(mLoadRequestQueue.front());
-        mLoadRequestQueue.pop();
+        UploadRequest upload = std::move(mUploadQueue.front());
+        mUploadQueue.pop();
 
         lock.unlock();
 
-        // Load the textures (this part is running in parallel).
+        // Create the texture.
         ref<Texture> pTexture;
-        if (request.paths.size() == 1)
-        {
-            pTexture =
-                Texture::createFromFile(mpDevice, request.paths[0], request.generateMipLevels, request.loadAsSRGB, request.bindFlags);
-        }
-        else
+        double uploadTime = 0.0;
+        const bool cancelled = upload.request.cancellationToken.isCancelled();
+        if (!cancelled)
         {
-            pTexture = Texture::createMippedFromFiles(mpDevice, request.paths, request.loadAsSRGB, request.bindFlags);
+            auto startTime = CpuTimer::getCurrentTimePoint();
+            pTexture = uploadTexture(
+                mpDevice, *upload.pDecoded, upload.request.generateMipLevels, upload.request.loadAsSRGB, upload.request.bindFlags,
+                upload.request.firstMip, upload.request.mipCount
+            );
+            uploadTime = getElapsedSeconds(startTime);
         }
 
-        request.promise.set_value(pTexture);
+        // Release the decoded image data.
+        const uint64_t size = upload.pDecoded->size;
+        const Analysis analysis = upload.pDecoded->analysis;
+        upload.pDecoded.reset();
+
+        lock.lock();
 
-        if (request.callback)
+        mStats.decodedBytesInFlight -= size;
+        mStats.uploadTime += uploadTime;
+        if (pTexture)
+        {
+            mStats.uploadedCount++;
+            mStats.uploadedBytes += size;
+        }
+        else if (cancelled)
         {
-            request.callback(pTexture);
+            mStats.cancelledCount++;
+        }
+        else
+        {
+            mStats.failedCount++;
         }
 
-        lock.lock();
+        lock.unlock();
+        mDecodeCondition.notify_all();
 
         // Issue a global flush if necessary.
-        // TODO: It would be better to check the size of the upload heap instead.
-        if (!mTerminate && pTexture != nullptr && ++mUploadCounter >= kUploadsPerFlush)
+        if (pTexture)
         {
-            mFlushPending = true;
-            mCondition.notify_all();
+            bytesSinceFlush += size;
+            if (++uploadsSinceFlush >= mOptions.uploadsPerFlush || bytesSinceFlush >= mOptions.uploadBytesPerFlush)
+            {
+                std::lock_guard<std::mutex> gfxLock(mpDevice->getGlobalGfxMutex());
+                mpDevice->flushAndSync();
+                bytesSinceFlush = 0;
+                uploadsSinceFlush = 0;
+            }
         }
 
-        mCondition.notify_one();
+        finishRequest(upload.request, pTexture, pTexture ? analysis : Analysis());
     }
 }
 
@@ -170,9 +752,22 @@ void AsyncTextureLoader::terminateWorkers()
         mTerminate = true;
     }
 
-    mCondition.notify_all();
+    mDecodeCondition.notify_all();
+    mUploadCondition.notify_all();
 
-    for (auto& thread : mThreads)
+    for (auto& thread : mDecodeThreads)
         thread.join();
+
+    mUploadThread.join();
+}
+
+void AsyncTextureLoader::finishRequest(LoadRequest& request, ref<Texture> pTexture, const Analysis& analysis)
+{
+    request.promise.set_value(pTexture);
+
+    if (request.callback)
+    {
+        request.callback(pTexture, analysis);
+    }
 }
 } // namespace Falcor
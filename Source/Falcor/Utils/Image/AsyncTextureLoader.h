@@ -30,11 +30,15 @@
 #include "Core/API/fwd.h"
 #include "Core/API/Resource.h"
 #include "Core/API/Texture.h"
+#include "TextureAnalyzer.h"
+#include <atomic>
 #include <condition_variable>
 #include <filesystem>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <thread>
 #include <vector>
@@ -42,25 +46,115 @@
 
 namespace Falcor
 {
-class Barrier;
-
 /**
- * Utility class to load textures asynchronously using multiple worker threads.
+ * Utility class to load textures asynchronously.
+ *
+ * Loading runs in two stages. Multiple decode threads read and decode the image files in order of request priority.
+ * The decoded images are passed to a single upload thread that creates the textures. The amount of decoded image data
+ * waiting to be uploaded is capped to limit memory usage, and the GPU is flushed at regular intervals to keep the upload
+ * heap from growing. The contents of the loaded textures are analyzed on the decode threads while the image data is in CPU memory.
  */
 class FALCOR_API AsyncTextureLoader
 {
 public:
-    using LoadCallback = std::function<void(ref<Texture> pTexture)>;
+    /// Analysis of the texture contents. Empty if the texture format can't be analyzed on the CPU, e.g. for DDS files.
+    using Analysis = std::optional<TextureAnalyzer::Result>;
+    using LoadCallback = std::function<void(ref<Texture> pTexture, const Analysis& analysis)>;
+    /// Callback called with the content hash of a decoded texture before the texture is created. Returns false to skip creating it.
+    using ContentHashCallback = std::function<bool(uint64_t contentHash)>;
+
+    /// Description of a texture at full resolution, before any mip levels are skipped.
+    struct TextureInfo
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipCount = 0; ///< Number of mip levels stored in the files, or of the full mip chain if mips are generated.
+        ResourceFormat format = ResourceFormat::Unknown;
+    };
+
+    /// Callback called with the description of a decoded texture before the texture is created. Returns the first mip level to create.
+    using FirstMipCallback = std::function<uint32_t(const TextureInfo& info)>;
+
+    /**
+     * Token for cancelling load requests.
+     * Copies of a token share the same state. A default constructed token can't be cancelled.
+     */
+    class CancellationToken
+    {
+    public:
+        CancellationToken() = default;
+
+        /**
+         * Create a new token that can be cancelled.
+         */
+        static CancellationToken create()
+        {
+            CancellationToken token;
+            token.mpCancelled = std::make_shared<std::atomic<bool>>(false);
+            return token;
+        }
+
+        void cancel()
+        {
+            if (mpCancelled)
+                mpCancelled->store(true);
+        }
+
+        bool isCancelled() const { return mpCancelled && mpCancelled->load(); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> mpCancelled;
+    };
+
+    struct Options
+    {
+        /// Number of decode threads.
+        size_t threadCount = std::thread::hardware_concurrency();
+        /// Maximum size in bytes of decoded images waiting to be uploaded, counting only the mips that are uploaded.
+        /// Decoding pauses while the limit is reached.
+        /// The limit can be exceeded by the images that are being decoded concurrently.
+        uint64_t maxDecodedBytes = 2ull << 30;
+        /// Number of bytes uploaded before issuing a GPU flush (to keep the upload heap from growing).
+        uint64_t uploadBytesPerFlush = 256ull << 20;
+        /// Number of textures uploaded before issuing a GPU flush.
+        uint32_t uploadsPerFlush = 16;
+    };
+
+    struct Stats
+    {
+        size_t decodeQueueSize = 0;        ///< Number of requests waiting to be decoded.
+        size_t uploadQueueSize = 0;        ///< Number of decoded textures waiting to be uploaded.
+        uint64_t decodedBytesInFlight = 0; ///< Size of decoded images waiting to be uploaded.
+        uint64_t decodedCount = 0;         ///< Number of decoded textures.
+        uint64_t decodedBytes = 0;         ///< Total size of decoded images.
+        double decodeTime = 0.0;           ///< Total time in seconds spent decoding, summed over all decode threads.
+        uint64_t uploadedCount = 0;        ///< Number of uploaded textures.
+        uint64_t uploadedBytes = 0;        ///< Total size of uploaded images.
+        double uploadTime = 0.0;           ///< Total time in seconds spent uploading.
+        uint64_t cancelledCount = 0;       ///< Number of cancelled requests.
+        uint64_t failedCount = 0;          ///< Number of requests that failed to load.
+
+        /// Decoded bytes per second of decode thread time.
+        double getDecodeThroughput() const { return decodeTime > 0.0 ? decodedBytes / decodeTime : 0.0; }
+        /// Uploaded bytes per second of upload thread time.
+        double getUploadThroughput() const { return uploadTime > 0.0 ? uploadedBytes / uploadTime : 0.0; }
+    };
 
     /**
      * Constructor.
-     * @param[in] threadCount Number of worker threads.
+     * @param[in] threadCount Number of decode threads.
      */
     AsyncTextureLoader(ref<Device> pDevice, size_t threadCount = std::thread::hardware_concurrency());
 
+    /**
+     * Constructor.
+     * @param[in] options Loader options.
+     */
+    AsyncTextureLoader(ref<Device> pDevice, const Options& options);
+
     /**
      * Destructor.
-     * Blocks until all threads have terminated.
+     * Blocks until all pending requests are processed and all threads have terminated.
      */
     ~AsyncTextureLoader();
 
@@ -70,13 +164,17 @@ public:
      * @param[in] loadAsSRGB Load the texture as sRGB format if supported, otherwise linear color.
      * @param[in] bindFlags The bind flags for the texture resource.
      * @param[in] callback Function called after the texture load has finished.
+     * @param[in] priority Requests with higher priority are loaded first. Requests of equal priority are loaded in order.
+     * @param[in] cancellationToken Token for cancelling the request. Cancelled requests return nullptr.
      * @return A future to a new texture, or nullptr if the texture failed to load.
      */
     std::future<ref<Texture>> loadMippedFromFiles(
         fstd::span<const std::filesystem::path> paths,
         bool loadAsSRGB,
         Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource,
-        LoadCallback callback = {}
+        LoadCallback callback = {},
+        int priority = 0,
+        CancellationToken cancellationToken = {}
     );
 
     /**
@@ -86,6 +184,8 @@ public:
      * @param[in] loadAsSRGB Load the texture as sRGB format if supported, otherwise linear color.
      * @param[in] bindFlags The bind flags for the texture resource.
      * @param[in] callback Function called after the texture load has finished.
+     * @param[in] priority Requests with higher priority are loaded first. Requests of equal priority are loaded in order.
+     * @param[in] cancellationToken Token for cancelling the request. Cancelled requests return nullptr.
      * @return A future to a new texture, or nullptr if the texture failed to load.
      */
     std::future<ref<Texture>> loadFromFile(
@@ -93,13 +193,75 @@ public:
         bool generateMipLevels,
         bool loadAsSRGB,
         Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource,
-        LoadCallback callback = {}
+        LoadCallback callback = {},
+        int priority = 0,
+        CancellationToken cancellationToken = {}
+    );
+
+    /**
+     * Request loading a range of mip levels of a texture.
+     * Only the requested mip levels reach the GPU, and the first requested mip level becomes mip 0 of the texture. DDS files and
+     * textures with mips loaded from separate files only upload the requested mips. For single images with generated mips, the
+     * first requested mip is downsampled on the decode threads and the coarser mips are generated from it on the GPU, so the
+     * texture holds all mips from the first requested one on. Skipped mips are dropped before the decoded data is queued for upload.
+     * @param[in] paths Full path of the texture, or list of full paths of all mips starting from mip0.
+     * @param[in] generateMipLevels Whether the full mip-chain should be generated. Ignored when loading multiple mips.
+     * @param[in] loadAsSRGB Load the texture as sRGB format if supported, otherwise linear color.
+     * @param[in] firstMip First mip level to load, relative to the full resolution texture.
+     * @param[in] mipCount Number of mip levels to load. Clamped to the number of available mip levels.
+     * @param[in] bindFlags The bind flags for the texture resource.
+     * @param[in] callback Function called after the texture load has finished.
+     * @param[in] priority Requests with higher priority are loaded first. Requests of equal priority are loaded in order.
+     * @param[in] cancellationToken Token for cancelling the request. Cancelled requests return nullptr.
+     * @return A future to a new texture, or nullptr if the texture failed to load.
+     */
+    std::future<ref<Texture>> loadMipRange(
+        fstd::span<const std::filesystem::path> paths,
+        bool generateMipLevels,
+        bool loadAsSRGB,
+        uint32_t firstMip,
+        uint32_t mipCount,
+        Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource,
+        LoadCallback callback = {},
+        int priority = 0,
+        CancellationToken cancellationToken = {}
+    );
+
+    /**
+     * Get loading statistics.
+     */
+    Stats getStats() const;
+
+    /**
+     * Load a texture on the calling thread. This is the implementation of Texture::createFromFile() and
+     * Texture::createMippedFromFiles(), and uses the same decode and upload steps as the asynchronous requests.
+     * If requested, the first mip level is analyzed using TextureAnalyzer::analyzeImage() before the texture is created.
+     * The content hash identifies textures with identical contents. It is computed from the format, dimensions and data of
+     * all decoded mip levels, or from the file contents for DDS files.
+     * @param[in] pDevice GPU device.
+     * @param[in] paths Full path of the texture, or list of full paths of all mips starting from mip0.
+     * @param[in] generateMipLevels Whether the full mip-chain should be generated. Ignored when loading multiple mips.
+     * @param[in] loadAsSRGB Load the texture as sRGB format if supported, otherwise linear color.
+     * @param[in] bindFlags The bind flags for the texture resource.
+     * @param[out] pAnalysis Optional. Set to the analysis of the texture contents. The contents are only analyzed if this is set.
+     * @param[in] contentHashCallback Optional. Called with the content hash after decoding. The texture is not created if it returns false.
+     * The content hash is only computed if this is set.
+     * @param[in] firstMipCallback Optional. Called after decoding to select the first mip level to create (see loadMipRange()).
+     * @return A new texture, or nullptr if the texture failed to load or was skipped.
+     */
+    static ref<Texture> loadTexture(
+        ref<Device> pDevice,
+        fstd::span<const std::filesystem::path> paths,
+        bool generateMipLevels,
+        bool loadAsSRGB,
+        Resource::BindFlags bindFlags,
+        Analysis* pAnalysis = nullptr,
+        const ContentHashCallback& contentHashCallback = {},
+        const FirstMipCallback& firstMipCallback = {}
     );
 
 private:
-    void runWorkers(size_t threadCount);
-    void runWorker();
-    void terminateWorkers();
+    struct DecodedTexture;
 
     struct LoadRequest
     {
@@ -108,21 +270,59 @@ private:
         bool loadAsSRGB;
         Resource::BindFlags bindFlags;
         LoadCallback callback;
+        int priority;
+        CancellationToken cancellationToken;
+        uint64_t sequenceNumber; ///< Order of the request. Used for loading requests of equal priority in order.
         std::promise<ref<Texture>> promise;
+        uint32_t firstMip = 0;                     ///< First mip level to load.
+        uint32_t mipCount = Texture::kMaxPossible; ///< Number of mip levels to load.
+    };
+
+    struct UploadRequest
+    {
+        LoadRequest request;
+        std::unique_ptr<DecodedTexture> pDecoded;
     };
 
+    static std::unique_ptr<DecodedTexture> decodeTexture(
+        fstd::span<const std::filesystem::path> paths,
+        bool generateMipLevels,
+        bool loadAsSRGB,
+        bool computeContentHash,
+        bool analyze
+    );
+    static ref<Texture> uploadTexture(
+        ref<Device> pDevice,
+        const DecodedTexture& decoded,
+        bool generateMipLevels,
+        bool loadAsSRGB,
+        Resource::BindFlags bindFlags,
+        uint32_t firstMip = 0,
+        uint32_t mipCount = Texture::kMaxPossible
+    );
+
+    std::future<ref<Texture>> enqueue(LoadRequest request);
+    void runWorkers(size_t threadCount);
+    void runDecodeWorker();
+    void runUploadWorker();
+    void terminateWorkers();
+    void finishRequest(LoadRequest& request, ref<Texture> pTexture, const Analysis& analysis);
+
     ref<Device> mpDevice;
+    Options mOptions;
 
-    std::mutex mMutex;                      ///< Mutex for synchronizing access to shared resources.
-    std::condition_variable mCondition;     ///< Condition variable for workers to wait on.
-    std::shared_ptr<Barrier> mFlushBarrier; ///< Barrier for flushing the GPU to upload textures.
-    std::vector<std::thread> mThreads;      ///< Worker threads.
+    mutable std::mutex mMutex;                ///< Mutex for synchronizing access to shared resources.
+    std::condition_variable mDecodeCondition; ///< Condition variable for decode threads to wait on.
+    std::condition_variable mUploadCondition; ///< Condition variable for the upload thread to wait on.
+    std::vector<std::thread> mDecodeThreads;  ///< Decode threads.
+    std::thread mUploadThread;                ///< Upload thread.
 
     // Internal state. Do not access outside of critical section.
-    std::queue<LoadRequest> mLoadRequestQueue; ///< Texture loading request queue.
-
-    bool mTerminate = false;     ///< Flag to terminate worker threads.
-    bool mFlushPending = false;  ///< Flag to indicate a GPU flush is pending.
-    uint32_t mUploadCounter = 0; ///< Counter to issue a flush every few uploads.
+    std::vector<LoadRequest> mDecodeQueue;  ///< Decode request queue. Heap ordered by priority.
+    std::queue<UploadRequest> mUploadQueue; ///< Upload request queue.
+    uint64_t mNextSequenceNumber = 0;       ///< Sequence number of the next request.
+    size_t mActiveDecodeCount = 0;          ///< Number of requests currently being decoded.
+    bool mTerminate = false;                ///< Flag to terminate worker threads.
+    Stats mStats;                           ///< Loading statistics.
 };
 } // namespace Falcor
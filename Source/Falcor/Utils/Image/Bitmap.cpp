@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "Bitmap.h"
+#include "PixelConversion.h"
 #include "Core/Macros.h"
 #include "Core/API/Texture.h"
 #include "Core/Platform/MemoryMappedFile.h"
@@ -61,95 +62,16 @@ static bool isConvertibleToRGBA32Float(ResourceFormat format)
     return isHalfFormat || isLargeIntFormat;
 }
 
-/**
- * Converts half float image to RGBA float image.
- */
-static std::vector<float> convertHalfToRGBA32Float(uint32_t width, uint32_t height, uint32_t channelCount, const void* pData)
-{
-    std::vector<float> newData(width * height * 4u, 0.f);
-    const float16_t* pSrc = reinterpret_cast<const float16_t*>(pData);
-    float* pDst = newData.data();
-
-    for (uint32_t i = 0; i < width * height; ++i)
-    {
-        for (uint32_t c = 0; c < channelCount; ++c)
-        {
-            *pDst++ = float(*pSrc++);
-        }
-        pDst += (4 - channelCount);
-    }
-
-    return newData;
-}
-
-/**
- * Converts integer image to RGBA float image.
- * Unsigned integers are normalized to [0,1], signed integers to [-1,1].
- */
-template<typename SrcT>
-static std::vector<float> convertIntToRGBA32Float(uint32_t width, uint32_t height, uint32_t channelCount, const void* pData)
-{
-    std::vector<float> newData(width * height * 4u, 0.f);
-    const SrcT* pSrc = reinterpret_cast<const SrcT*>(pData);
-    float* pDst = newData.data();
-
-    for (uint32_t i = 0; i < width * height; ++i)
-    {
-        for (uint32_t c = 0; c < channelCount; ++c)
-        {
-            *pDst++ = float(*pSrc++) / float(std::numeric_limits<SrcT>::max());
-        }
-        pDst += (4 - channelCount);
-    }
-
-    return newData;
-}
-
 /**
  * Converts an image of the given format to an RGBA float image.
  */
-static std::vector<float> convertToRGBA32Float(ResourceFormat format, uint32_t width, uint32_t height, const void* pData)
+static std::vector<float> convertImageToRGBA32Float(ResourceFormat format, uint32_t width, uint32_t height, const void* pData)
 {
     FALCOR_ASSERT(isConvertibleToRGBA32Float(format));
 
-    FormatType type = getFormatType(format);
-    uint32_t channelCount = getFormatChannelCount(format);
-    uint32_t channelBits = getNumChannelBits(format, 0);
-
-    std::vector<float> floatData;
-
-    if (type == FormatType::Float && channelBits == 16)
-    {
-        floatData = convertHalfToRGBA32Float(width, height, channelCount, pData);
-    }
-    else if (type == FormatType::Uint && channelBits == 16)
-    {
-        floatData = convertIntToRGBA32Float<uint16_t>(width, height, channelCount, pData);
-    }
-    else if (type == FormatType::Uint && channelBits == 32)
-    {
-        floatData = convertIntToRGBA32Float<uint32_t>(width, height, channelCount, pData);
-    }
-    else if (type == FormatType::Sint && channelBits == 16)
-    {
-        floatData = convertIntToRGBA32Float<int16_t>(width, height, channelCount, pData);
-    }
-    else if (type == FormatType::Sint && channelBits == 32)
-    {
-        floatData = convertIntToRGBA32Float<int32_t>(width, height, channelCount, pData);
-    }
-    else
-    {
-        FALCOR_UNREACHABLE();
-    }
-
-    // Default alpha channel to 1.
-    if (channelCount < 4)
-    {
-        for (uint32_t i = 0; i < width * height; ++i)
-            floatData[i * 4 + 3] = 1.f;
-    }
-
+    std::vector<float> floatData(size_t(width) * height * 4u);
+    const size_t srcRowPitch = size_t(width) * getFormatBytesPerBlock(format);
+    convertToRGBA32Float(format, width, height, pData, srcRowPitch, floatData.data(), size_t(width) * 4 * sizeof(float));
     return floatData;
 }
 
@@ -168,25 +90,11 @@ static FIBITMAP* convertToRGBAF(FIBITMAP* pDib)
     const unsigned src_pitch = FreeImage_GetPitch(pDib);
     const unsigned dst_pitch = FreeImage_GetPitch(pNew);
 
-    const BYTE* src_bits = (BYTE*)FreeImage_GetBits(pDib);
-    BYTE* dst_bits = (BYTE*)FreeImage_GetBits(pNew);
-
-    for (unsigned y = 0; y < height; y++)
-    {
-        const FIRGBF* src_pixel = (FIRGBF*)src_bits;
-        FIRGBAF* dst_pixel = (FIRGBAF*)dst_bits;
+    const float* src_bits = (const float*)FreeImage_GetBits(pDib);
+    float* dst_bits = (float*)FreeImage_GetBits(pNew);
 
-        for (unsigned x = 0; x < width; x++)
-        {
-            // Convert pixels directly, while adding a "dummy" alpha of 1.0
-            dst_pixel[x].red = src_pixel[x].red;
-            dst_pixel[x].green = src_pixel[x].green;
-            dst_pixel[x].blue = src_pixel[x].blue;
-            dst_pixel[x].alpha = 1.0F;
-        }
-        src_bits += src_pitch;
-        dst_bits += dst_pitch;
-    }
+    // Convert pixels directly, while adding a "dummy" alpha of 1.0
+    copyChannels<float>(width, height, src_bits, 3, src_pitch, dst_bits, 4, dst_pitch, 1.f);
     return pNew;
 }
 
@@ -523,7 +431,7 @@ void Bitmap::saveImage(
         std::vector<float> floatData;
         if (isConvertibleToRGBA32Float(resourceFormat))
         {
-            floatData = convertToRGBA32Float(resourceFormat, width, height, pData);
+            floatData = convertImageToRGBA32Float(resourceFormat, width, height, pData);
             pData = floatData.data();
             resourceFormat = ResourceFormat::RGBA32Float;
             bytesPerPixel = 16;
@@ -560,26 +468,13 @@ void Bitmap::saveImage(
         bool scanlineCopy = exportAlpha ? bytesPerPixel == 16 : bytesPerPixel == 12;
 
         pImage = FreeImage_AllocateT(exportAlpha ? FIT_RGBAF : FIT_RGBF, width, height);
-        BYTE* head = (BYTE*)pData;
-        for (unsigned y = 0; y < height; y++)
-        {
-            float* dstBits = (float*)FreeImage_GetScanLine(pImage, height - y - 1);
-            if (scanlineCopy)
-            {
-                std::memcpy(dstBits, head, bytesPerPixel * width);
-            }
-            else
-            {
-                FALCOR_ASSERT(exportAlpha == false);
-                for (unsigned x = 0; x < width; x++)
-                {
-                    dstBits[x * 3 + 0] = (((float*)head)[x * 4 + 0]);
-                    dstBits[x * 3 + 1] = (((float*)head)[x * 4 + 1]);
-                    dstBits[x * 3 + 2] = (((float*)head)[x * 4 + 2]);
-                }
-            }
-            head += bytesPerPixel * width;
-        }
+        FALCOR_ASSERT(scanlineCopy || exportAlpha == false);
+        const uint32_t srcChannelCount = bytesPerPixel / sizeof(float);
+        const uint32_t dstChannelCount = scanlineCopy ? srcChannelCount : 3;
+        // FreeImage stores the image bottom-up, write the rows in reverse order.
+        float* dstBits = (float*)FreeImage_GetScanLine(pImage, height - 1);
+        const ptrdiff_t dstPitch = -ptrdiff_t(FreeImage_GetPitch(pImage));
+        copyChannels<float>(width, height, (const float*)pData, srcChannelCount, bytesPerPixel * width, dstBits, dstChannelCount, dstPitch);
 
         if (fileFormat == Bitmap::FileFormat::ExrFile)
         {
@@ -0,0 +1,243 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "EXRWriter.h"
+#include "Core/Errors.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfThreading.h>
+#include <ImfTiledOutputFile.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace Falcor
+{
+namespace
+{
+const char* kChannelNames[] = {"R", "G", "B", "A"};
+
+Imf::Compression getImfCompression(EXRWriter::Compression compression)
+{
+    switch (compression)
+    {
+    case EXRWriter::Compression::None:
+        return Imf::NO_COMPRESSION;
+    case EXRWriter::Compression::RLE:
+        return Imf::RLE_COMPRESSION;
+    case EXRWriter::Compression::Zip:
+        return Imf::ZIP_COMPRESSION;
+    case EXRWriter::Compression::Piz:
+        return Imf::PIZ_COMPRESSION;
+    default:
+        FALCOR_UNREACHABLE();
+        return Imf::NO_COMPRESSION;
+    }
+}
+
+std::string getChannelName(const EXRWriter::Layer& layer, uint32_t channel)
+{
+    return layer.name.empty() ? kChannelNames[channel] : layer.name + "." + kChannelNames[channel];
+}
+} // namespace
+
+struct EXRWriter::File
+{
+    std::unique_ptr<Imf::TiledOutputFile> pFile;
+};
+
+EXRWriter::EXRWriter(const std::filesystem::path& path, uint32_t width, uint32_t height, const std::vector<Layer>& layers)
+    : EXRWriter(path, width, height, layers, Options())
+{}
+
+EXRWriter::EXRWriter(
+    const std::filesystem::path& path,
+    uint32_t width,
+    uint32_t height,
+    const std::vector<Layer>& layers,
+    const Options& options
+)
+    : mPath(path), mWidth(width), mHeight(height), mLayers(layers), mOptions(options)
+{
+    FALCOR_CHECK_ARG_MSG(width > 0 && height > 0, "Image size must be non-zero");
+    FALCOR_CHECK_ARG_MSG(!layers.empty(), "Image must have at least one layer");
+    FALCOR_CHECK_ARG_MSG(options.tileSize > 0, "Tile size must be non-zero");
+
+    Imf::Header header((int)width, (int)height);
+    header.setTileDescription(Imf::TileDescription(options.tileSize, options.tileSize, Imf::ONE_LEVEL));
+    header.compression() = getImfCompression(options.compression);
+    header.lineOrder() = Imf::INCREASING_Y;
+
+    for (const auto& layer : layers)
+    {
+        const uint32_t channels = (uint32_t)layer.channels;
+        FALCOR_CHECK_ARG_MSG(channels != 0 && channels <= (uint32_t)TextureChannelFlags::RGBA, "Layer '{}' has no channels", layer.name);
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            if ((channels & (1u << c)) == 0)
+                continue;
+            const std::string name = getChannelName(layer, c);
+            if (header.channels().findChannel(name))
+                throw ArgumentError("Channel '{}' is used by more than one layer", name);
+            header.channels().insert(name, Imf::Channel(layer.useHalf ? Imf::HALF : Imf::FLOAT));
+        }
+
+        mChannelCounts.push_back(popcount(channels));
+    }
+
+    // Tiles of a band are compressed in parallel on the OpenEXR thread pool. Only grow the pool as it is shared by all users.
+    const uint32_t threadCount = options.threadCount > 0 ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+    if (Imf::globalThreadCount() < int(threadCount))
+        Imf::setGlobalThreadCount(int(threadCount));
+
+    mpFile = std::make_unique<File>();
+    try
+    {
+        mpFile->pFile = std::make_unique<Imf::TiledOutputFile>(path.string().c_str(), header, int(threadCount));
+    }
+    catch (const std::exception& e)
+    {
+        throw RuntimeError("Failed to create EXR file '{}': {}", path, e.what());
+    }
+
+    mBandBuffers.resize(layers.size());
+    for (size_t i = 0; i < layers.size(); ++i)
+        mBandBuffers[i].resize((size_t)mWidth * mOptions.tileSize * mChannelCounts[i]);
+}
+
+EXRWriter::~EXRWriter()
+{
+    if (mpFile && !isComplete())
+        logWarning("EXR file '{}' is closed before all pixels have been written.", mPath);
+}
+
+void EXRWriter::writeRows(uint32_t layerIndex, uint32_t firstRow, uint32_t rowCount, const float* pData)
+{
+    writeRegion(layerIndex, uint2(0, firstRow), uint2(mWidth, rowCount), pData);
+}
+
+void EXRWriter::writeTile(uint32_t layerIndex, uint32_t tileX, uint32_t tileY, const float* pData)
+{
+    const uint2 offset = uint2(tileX, tileY) * mOptions.tileSize;
+    FALCOR_CHECK_ARG_MSG(offset.x < mWidth && offset.y < mHeight, "Tile ({}, {}) is outside of the image", tileX, tileY);
+    const uint2 extent = min(uint2(mOptions.tileSize), uint2(mWidth, mHeight) - offset);
+    writeRegion(layerIndex, offset, extent, pData);
+}
+
+void EXRWriter::finish()
+{
+    if (!mpFile)
+        return;
+    if (!isComplete())
+        throw RuntimeError("Cannot finish EXR file '{}' before all pixels have been written.", mPath);
+    mpFile.reset();
+}
+
+uint2 EXRWriter::getBandRows() const
+{
+    return uint2(mBandStart, std::min(mBandStart + mOptions.tileSize, mHeight));
+}
+
+void EXRWriter::writeRegion(uint32_t layerIndex, uint2 offset, uint2 extent, const float* pData)
+{
+    FALCOR_CHECK_ARG_MSG(layerIndex < mLayers.size(), "Layer index {} is out of range", layerIndex);
+    FALCOR_CHECK_ARG_MSG(pData != nullptr, "Pixel data must not be null");
+    if (!mpFile)
+        throw RuntimeError("EXR file '{}' is already closed.", mPath);
+
+    const uint2 bandRows = getBandRows();
+    FALCOR_CHECK_ARG_MSG(
+        offset.x + extent.x <= mWidth && offset.y >= bandRows.x && offset.y + extent.y <= bandRows.y,
+        "Region ({}, {}) with size ({}, {}) is outside of the current band (rows {} to {})",
+        offset.x,
+        offset.y,
+        extent.x,
+        extent.y,
+        bandRows.x,
+        bandRows.y
+    );
+
+    // Copy the pixels into the band buffer.
+    const uint32_t channelCount = mChannelCounts[layerIndex];
+    float* pBand = mBandBuffers[layerIndex].data();
+    const size_t rowSize = (size_t)extent.x * channelCount;
+    for (uint32_t y = 0; y < extent.y; ++y)
+    {
+        const size_t dstOffset = ((size_t)(offset.y - bandRows.x + y) * mWidth + offset.x) * channelCount;
+        std::memcpy(pBand + dstOffset, pData + y * rowSize, rowSize * sizeof(float));
+    }
+
+    // Write the band once it is complete for all layers. Regions are assumed not to overlap.
+    mBandPixelsWritten += (uint64_t)extent.x * extent.y;
+    if (mBandPixelsWritten == (uint64_t)mWidth * (bandRows.y - bandRows.x) * mLayers.size())
+        writeBand();
+}
+
+void EXRWriter::writeBand()
+{
+    const uint2 bandRows = getBandRows();
+
+    // The frame buffer slices are addressed with absolute pixel coordinates, so the base pointers are offset by the band start.
+    Imf::FrameBuffer frameBuffer;
+    for (size_t i = 0; i < mLayers.size(); ++i)
+    {
+        const uint32_t channels = (uint32_t)mLayers[i].channels;
+        const size_t xStride = mChannelCounts[i] * sizeof(float);
+        const size_t yStride = xStride * mWidth;
+        char* pBase = reinterpret_cast<char*>(mBandBuffers[i].data()) - bandRows.x * yStride;
+
+        for (uint32_t c = 0, index = 0; c < 4; ++c)
+        {
+            if ((channels & (1u << c)) == 0)
+                continue;
+            frameBuffer.insert(getChannelName(mLayers[i], c), Imf::Slice(Imf::FLOAT, pBase + index * sizeof(float), xStride, yStride));
+            ++index;
+        }
+    }
+
+    try
+    {
+        auto& file = *mpFile->pFile;
+        file.setFrameBuffer(frameBuffer);
+        const int tileY = int(bandRows.x / mOptions.tileSize);
+        file.writeTiles(0, file.numXTiles(0) - 1, tileY, tileY);
+    }
+    catch (const std::exception& e)
+    {
+        throw RuntimeError("Failed to write EXR file '{}': {}", mPath, e.what());
+    }
+
+    mBandStart = bandRows.y;
+    mBandPixelsWritten = 0;
+}
+} // namespace Falcor
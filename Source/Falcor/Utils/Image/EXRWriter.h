@@ -0,0 +1,171 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/API/Formats.h"
+#include "Utils/Math/Vector.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Streaming writer for tiled, multi-layer OpenEXR files.
+ *
+ * The image is written in bands of tiles from top to bottom. Pixel data is submitted per layer in row or tile chunks
+ * and is buffered until the band it belongs to is complete for all layers. The band is then compressed, with the tiles
+ * compressed in parallel, and written to the file. Only a single band of tiles is kept in memory, so the memory use
+ * does not depend on the image height.
+ *
+ * Each layer stores a subset of the RGBA channels. The channels are named "<layer>.R", "<layer>.G" and so on, or
+ * "R", "G", ... for a layer with an empty name.
+ */
+class FALCOR_API EXRWriter
+{
+public:
+    enum class Compression
+    {
+        None,
+        RLE,
+        Zip,
+        Piz,
+    };
+
+    struct Layer
+    {
+        std::string name;                                         ///< Layer name.
+        TextureChannelFlags channels = TextureChannelFlags::RGBA; ///< Channels stored in the layer.
+        bool useHalf = false;                                     ///< Store channels as 16-bit floats instead of 32-bit floats.
+    };
+
+    struct Options
+    {
+        /// Tile width and height in pixels. This is also the height of the bands in which the image is written.
+        uint32_t tileSize = 64;
+        /// Compression applied to each tile.
+        Compression compression = Compression::Zip;
+        /// Number of threads used for compressing tiles. Zero uses the hardware concurrency.
+        uint32_t threadCount = 0;
+    };
+
+    /**
+     * Create a file and write the header.
+     * @param[in] path Path of the file to write.
+     * @param[in] width Image width in pixels.
+     * @param[in] height Image height in pixels.
+     * @param[in] layers Image layers.
+     */
+    EXRWriter(const std::filesystem::path& path, uint32_t width, uint32_t height, const std::vector<Layer>& layers);
+
+    /**
+     * Create a file and write the header.
+     * @param[in] path Path of the file to write.
+     * @param[in] width Image width in pixels.
+     * @param[in] height Image height in pixels.
+     * @param[in] layers Image layers.
+     * @param[in] options Writer options.
+     */
+    EXRWriter(
+        const std::filesystem::path& path,
+        uint32_t width,
+        uint32_t height,
+        const std::vector<Layer>& layers,
+        const Options& options
+    );
+
+    /**
+     * Destructor. Closes the file. A warning is logged if not all pixels have been written.
+     */
+    ~EXRWriter();
+
+    EXRWriter(const EXRWriter&) = delete;
+    EXRWriter& operator=(const EXRWriter&) = delete;
+
+    /**
+     * Write a range of rows of a layer.
+     * The rows must lie within the current band, see getBandRows().
+     * @param[in] layerIndex Index of the layer.
+     * @param[in] firstRow First row to write.
+     * @param[in] rowCount Number of rows to write.
+     * @param[in] pData Pixel data with the channels of the layer interleaved, in top-down row order.
+     */
+    void writeRows(uint32_t layerIndex, uint32_t firstRow, uint32_t rowCount, const float* pData);
+
+    /**
+     * Write a tile of a layer.
+     * The tile must lie within the current band, see getBandRows(). Tiles at the right and bottom edges of the image
+     * are clipped to the image size.
+     * @param[in] layerIndex Index of the layer.
+     * @param[in] tileX Horizontal tile index.
+     * @param[in] tileY Vertical tile index.
+     * @param[in] pData Pixel data of the clipped tile with the channels of the layer interleaved, in top-down row order.
+     */
+    void writeTile(uint32_t layerIndex, uint32_t tileX, uint32_t tileY, const float* pData);
+
+    /**
+     * Close the file. Throws if not all pixels have been written.
+     */
+    void finish();
+
+    /**
+     * Get the range of rows of the band that is currently being written.
+     * @return First row and one past the last row of the band.
+     */
+    uint2 getBandRows() const;
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+    uint32_t getTileSize() const { return mOptions.tileSize; }
+
+    /**
+     * Check if all pixels have been written.
+     */
+    bool isComplete() const { return mBandStart >= mHeight; }
+
+private:
+    struct File;
+
+    void writeRegion(uint32_t layerIndex, uint2 offset, uint2 extent, const float* pData);
+    void writeBand();
+
+    std::filesystem::path mPath;
+    uint32_t mWidth;
+    uint32_t mHeight;
+    std::vector<Layer> mLayers;
+    Options mOptions;
+
+    std::unique_ptr<File> mpFile;                 ///< OpenEXR output file.
+    std::vector<std::vector<float>> mBandBuffers; ///< Pixel data of the current band per layer.
+    std::vector<uint32_t> mChannelCounts;         ///< Number of channels per layer.
+    uint32_t mBandStart = 0;                      ///< First row of the current band.
+    uint64_t mBandPixelsWritten = 0;              ///< Number of pixels written to the current band, summed over all layers.
+};
+} // namespace Falcor
@@ -26,10 +26,12 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "ImageIO.h"
+#include "PixelConversion.h"
 #include "Core/Errors.h"
 #include "Core/API/CopyContext.h"
 #include "Core/API/NativeFormats.h"
 #include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/Math/Common.h"
 #include "Utils/Math/ScalarMath.h"
 #include "Utils/Logger.h"
 
@@ -37,6 +39,7 @@
 #include <nvtt/nvtt.h>
 
 #include <filesystem>
+#include <fstream>
 
 namespace Falcor
 {
@@ -272,41 +275,20 @@ void setImage(
 
     modified.resize(4 * pixelCount);
 
-    T* src = (T*)subresourceData;
-    T* dst = (T*)modified.data();
-    for (uint32_t h = 0; h < image.height; ++h)
-    {
-        for (uint32_t w = 0; w < image.width; ++w)
-        {
-            uint32_t i = h * srcWidth + w;    // Source data index
-            uint32_t j = h * image.width + w; // Destination data index - Same as source index if no clamping is involved
-            if (channelCount == 1)
-            {
-                dst[j] = T(src[i]);
-            }
-            else if (channelCount == 2)
-            {
-                dst[4 * j] = reverseRB ? T(0) : T(src[2 * i]);
-                dst[4 * j + 1] = T(src[2 * i + 1]);
-                dst[4 * j + 2] = reverseRB ? T(src[2 * i]) : T(0);
-                dst[4 * j + 3] = T(0);
-            }
-            else if (channelCount == 3)
-            {
-                dst[4 * j] = reverseRB ? T(src[3 * i + 2]) : T(src[3 * i]);
-                dst[4 * j + 1] = T(src[3 * i + 1]);
-                dst[4 * j + 2] = reverseRB ? T(src[3 * i]) : T(src[3 * i + 2]);
-                dst[4 * j + 3] = T(0);
-            }
-            else if (channelCount == 4)
-            {
-                dst[4 * j] = reverseRB ? T(src[4 * i + 2]) : T(src[4 * i]);
-                dst[4 * j + 1] = T(src[4 * i + 1]);
-                dst[4 * j + 2] = reverseRB ? T(src[4 * i]) : T(src[4 * i + 2]);
-                dst[4 * j + 3] = T(src[4 * i + 3]);
-            }
-        }
-    }
+    // Single channel images are passed as is, all others are expanded to four channels.
+    const uint32_t dstChannelCount = channelCount == 1 ? 1 : 4;
+    copyChannels<T>(
+        image.width,
+        image.height,
+        (const T*)subresourceData,
+        channelCount,
+        srcWidth * channelCount * sizeof(T),
+        modified.data(),
+        dstChannelCount,
+        image.width * dstChannelCount * sizeof(T),
+        alpha,
+        reverseRB
+    );
 
     if (isCompressedFormat(image.format))
     {
@@ -570,7 +552,40 @@ Bitmap::UniqueConstPtr ImageIO::loadBitmapFromDDS(const std::filesystem::path& p
     return Bitmap::create(data.width, data.height, data.format, data.imageData.data());
 }
 
-ref<Texture> ImageIO::loadTextureFromDDS(ref<Device> pDevice, const std::filesystem::path& path, bool loadAsSrgb)
+ImageIO::DDSInfo ImageIO::readDDSInfo(const std::filesystem::path& path, bool loadAsSrgb)
+{
+    std::ifstream fs(path, std::ios::binary);
+    if (!fs)
+        throw RuntimeError("Failed to open DDS file '{}'.", path);
+
+    const size_t maxHeaderSize = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+    uint8_t header[maxHeaderSize] = {};
+    fs.read(reinterpret_cast<char*>(header), maxHeaderSize);
+    if (size_t(fs.gcount()) < sizeof(uint32_t) + sizeof(DDS_HEADER))
+        throw RuntimeError("Failed to read DDS header from '{}' (file too small).", path);
+
+    ImportData data;
+    size_t headerSize = maxHeaderSize;
+    readDDSHeader(data, header, headerSize, loadAsSrgb);
+
+    DDSInfo info;
+    info.type = data.type;
+    info.width = data.width;
+    info.height = data.height;
+    info.depth = data.depth;
+    info.arraySize = data.arraySize;
+    info.mipCount = data.mipLevels;
+    info.format = data.format;
+    return info;
+}
+
+ref<Texture> ImageIO::loadTextureFromDDS(
+    ref<Device> pDevice,
+    const std::filesystem::path& path,
+    bool loadAsSrgb,
+    uint32_t firstMip,
+    uint32_t mipCount
+)
 {
     ImportData data;
     try
@@ -591,7 +606,43 @@ ref<Texture> ImageIO::loadTextureFromDDS(ref<Device> pDevice, const std::filesys
         pTex = Texture::create1D(pDevice, data.width, data.format, data.arraySize, data.mipLevels, data.imageData.data());
         break;
     case Resource::Type::Texture2D:
-        pTex = Texture::create2D(pDevice, data.width, data.height, data.format, data.arraySize, data.mipLevels, data.imageData.data());
+        if (data.arraySize == 1 && (firstMip > 0 || mipCount < data.mipLevels))
+        {
+            // Skip the image data of the mips before the first mip. The mips of a single texture are stored consecutively.
+            if (firstMip >= data.mipLevels)
+            {
+                logWarning("Failed to load DDS image from '{}': Mip level {} does not exist.", path, firstMip);
+                return nullptr;
+            }
+            mipCount = std::min(mipCount, data.mipLevels - firstMip);
+            uint32_t blockWidth = getFormatWidthCompressionRatio(data.format);
+            uint32_t blockHeight = getFormatHeightCompressionRatio(data.format);
+            auto getMipSize = [&](uint32_t mip)
+            {
+                uint64_t blockCountX = div_round_up(std::max(1u, data.width >> mip), blockWidth);
+                uint64_t blockCountY = div_round_up(std::max(1u, data.height >> mip), blockHeight);
+                return blockCountX * blockCountY * getFormatBytesPerBlock(data.format);
+            };
+            uint64_t offset = 0;
+            for (uint32_t mip = 0; mip < firstMip; mip++)
+                offset += getMipSize(mip);
+            uint64_t size = 0;
+            for (uint32_t mip = firstMip; mip < firstMip + mipCount; mip++)
+                size += getMipSize(mip);
+            if (offset + size > data.imageData.size())
+            {
+                logWarning("Failed to load DDS image from '{}': File is too small for {} mip levels.", path, data.mipLevels);
+                return nullptr;
+            }
+            pTex = Texture::create2D(
+                pDevice, std::max(1u, data.width >> firstMip), std::max(1u, data.height >> firstMip), data.format, 1, mipCount,
+                data.imageData.data() + offset
+            );
+        }
+        else
+        {
+            pTex = Texture::create2D(pDevice, data.width, data.height, data.format, data.arraySize, data.mipLevels, data.imageData.data());
+        }
         break;
     case Resource::Type::TextureCube:
         pTex =
@@ -80,15 +80,46 @@ public:
      */
     static Bitmap::UniqueConstPtr loadBitmapFromDDS(const std::filesystem::path& path); // top down = true
 
+    /// Description of the image stored in a DDS file.
+    struct DDSInfo
+    {
+        Resource::Type type = Resource::Type::Texture2D;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 0;
+        uint32_t arraySize = 0;
+        uint32_t mipCount = 0;
+        ResourceFormat format = ResourceFormat::Unknown;
+    };
+
+    /**
+     * Read the header of a DDS file.
+     * Throws an exception if the file can't be read or the DDS header is malformed.
+     * @param[in] path Path of file to read.
+     * @param[in] loadAsSrgb If true, convert the image format property to a corresponding sRGB format if available.
+     * @return Description of the image.
+     */
+    static DDSInfo readDDSInfo(const std::filesystem::path& path, bool loadAsSrgb);
+
     /**
      * Load a DDS file to a Texture.
      * Throws an exception if the DDS file is malformed.
      * @param[in] path Path of file to load.
      * @param[in] loadAsSrgb If true, convert the image format property to a corresponding sRGB format if available. Image data is not
      * changed.
+     * @param[in] firstMip First mip level to load. Only the image data of the loaded mip levels is uploaded, and the first loaded
+     * mip level becomes mip 0 of the texture. Mip ranges are only supported for single 2D textures, other textures are loaded with
+     * all mip levels.
+     * @param[in] mipCount Number of mip levels to load. Clamped to the number of mip levels stored in the file.
      * @return Texture object containing image data if loading was successful. Otherwise, nullptr.
      */
-    static ref<Texture> loadTextureFromDDS(ref<Device> pDevice, const std::filesystem::path& path, bool loadAsSrgb);
+    static ref<Texture> loadTextureFromDDS(
+        ref<Device> pDevice,
+        const std::filesystem::path& path,
+        bool loadAsSrgb,
+        uint32_t firstMip = 0,
+        uint32_t mipCount = Texture::kMaxPossible
+    );
 
     /**
      * Saves a bitmap to a DDS file.
@@ -0,0 +1,301 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "PixelConversion.h"
+#include "Core/Errors.h"
+#include "Utils/Threading.h"
+#include "Utils/Math/ScalarTypes.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_PIXEL_CONVERSION_SSE2 1
+#include <emmintrin.h>
+#else
+#define FALCOR_PIXEL_CONVERSION_SSE2 0
+#endif
+
+namespace Falcor
+{
+namespace
+{
+/// Minimum number of pixels processed by a single task.
+const size_t kMinPixelsPerTask = 1 << 16;
+
+/// Number of pixels converted at once through a temporary buffer.
+const uint32_t kTempPixelCount = 256;
+
+/**
+ * Call func(y) for all rows of an image. Large images are split into tasks running on the thread pool.
+ */
+template<typename F>
+void forEachRow(uint32_t width, uint32_t height, F&& func)
+{
+    const size_t grainSize = std::max<size_t>(1, kMinPixelsPerTask / std::max(width, 1u));
+    Threading::parallelForRange(
+        0,
+        height,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t y = begin; y < end; ++y)
+                func(uint32_t(y));
+        },
+        grainSize
+    );
+}
+
+template<typename T>
+const T* getRow(const void* pData, ptrdiff_t rowPitch, uint32_t y)
+{
+    return reinterpret_cast<const T*>(static_cast<const uint8_t*>(pData) + rowPitch * ptrdiff_t(y));
+}
+
+template<typename T>
+T* getRow(void* pData, ptrdiff_t rowPitch, uint32_t y)
+{
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(pData) + rowPitch * ptrdiff_t(y));
+}
+
+template<typename U>
+void copyChannelsRow(const U* pSrc, uint32_t srcChannelCount, U* pDst, uint32_t dstChannelCount, uint32_t width, U alpha, bool swapRB)
+{
+    if (srcChannelCount == dstChannelCount && !swapRB)
+    {
+        std::memcpy(pDst, pSrc, size_t(width) * srcChannelCount * sizeof(U));
+        return;
+    }
+
+    uint32_t x = 0;
+
+#if FALCOR_PIXEL_CONVERSION_SSE2
+    // Move whole pixels as 16 byte vectors. The loads/stores touch one element of the next pixel,
+    // so the last pixel of the row is left to the scalar loop.
+    if constexpr (sizeof(U) == 4)
+    {
+        if (srcChannelCount == 3 && dstChannelCount == 4 && !swapRB)
+        {
+            const __m128i rgbMask = _mm_set_epi32(0, -1, -1, -1);
+            const __m128i alphaBits = _mm_set_epi32(int(alpha), 0, 0, 0);
+            for (; x + 1 < width; ++x)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 3 * x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 4 * x), _mm_or_si128(_mm_and_si128(v, rgbMask), alphaBits));
+            }
+        }
+        else if (srcChannelCount == 4 && dstChannelCount == 3 && !swapRB)
+        {
+            for (; x + 1 < width; ++x)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 3 * x), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 4 * x)));
+        }
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        U pixel[4] = {U(0), U(0), U(0), alpha};
+        for (uint32_t c = 0; c < srcChannelCount; ++c)
+            pixel[c] = pSrc[x * srcChannelCount + c];
+        if (swapRB)
+            std::swap(pixel[0], pixel[2]);
+        for (uint32_t c = 0; c < dstChannelCount; ++c)
+            pDst[x * dstChannelCount + c] = pixel[c];
+    }
+}
+
+template<typename U>
+void copyChannelsImpl(
+    uint32_t width,
+    uint32_t height,
+    const void* pSrc,
+    uint32_t srcChannelCount,
+    ptrdiff_t srcRowPitch,
+    void* pDst,
+    uint32_t dstChannelCount,
+    ptrdiff_t dstRowPitch,
+    U alpha,
+    bool swapRB
+)
+{
+    forEachRow(
+        width,
+        height,
+        [&](uint32_t y)
+        {
+            copyChannelsRow<U>(
+                getRow<U>(pSrc, srcRowPitch, y), srcChannelCount, getRow<U>(pDst, dstRowPitch, y), dstChannelCount, width, alpha, swapRB
+            );
+        }
+    );
+}
+
+void convertHalfRow(const float16_t* pSrc, uint32_t channelCount, float* pDst, uint32_t width, float alpha)
+{
+    if (channelCount == 4)
+    {
+        math::convertFloat16ToFloat32(fstd::span<const float16_t>(pSrc, size_t(width) * 4), fstd::span<float>(pDst, size_t(width) * 4));
+        return;
+    }
+
+    uint32_t alphaBits;
+    std::memcpy(&alphaBits, &alpha, sizeof(float));
+
+    float temp[kTempPixelCount * 3];
+    for (uint32_t x = 0; x < width; x += kTempPixelCount)
+    {
+        const uint32_t count = std::min(kTempPixelCount, width - x);
+        math::convertFloat16ToFloat32(
+            fstd::span<const float16_t>(pSrc + size_t(x) * channelCount, size_t(count) * channelCount),
+            fstd::span<float>(temp, size_t(count) * channelCount)
+        );
+        copyChannelsRow<uint32_t>(
+            reinterpret_cast<const uint32_t*>(temp), channelCount, reinterpret_cast<uint32_t*>(pDst + size_t(x) * 4), 4, count, alphaBits, false
+        );
+    }
+}
+
+template<typename T>
+void convertIntRow(const T* pSrc, uint32_t channelCount, float* pDst, uint32_t width, float alpha)
+{
+    const float maxValue = float(std::numeric_limits<T>::max());
+    if (channelCount == 4)
+    {
+        for (size_t i = 0; i < size_t(width) * 4; ++i)
+            pDst[i] = float(pSrc[i]) / maxValue;
+        return;
+    }
+
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        float pixel[4] = {0.f, 0.f, 0.f, alpha};
+        for (uint32_t c = 0; c < channelCount; ++c)
+            pixel[c] = float(pSrc[x * channelCount + c]) / maxValue;
+        for (uint32_t c = 0; c < 4; ++c)
+            pDst[x * 4 + c] = pixel[c];
+    }
+}
+} // namespace
+
+namespace detail
+{
+void copyChannels(
+    size_t elementSize,
+    uint32_t width,
+    uint32_t height,
+    const void* pSrc,
+    uint32_t srcChannelCount,
+    ptrdiff_t srcRowPitch,
+    void* pDst,
+    uint32_t dstChannelCount,
+    ptrdiff_t dstRowPitch,
+    uint32_t alphaBits,
+    bool swapRB
+)
+{
+    FALCOR_CHECK_ARG(srcChannelCount >= 1 && srcChannelCount <= 4);
+    FALCOR_CHECK_ARG(dstChannelCount >= 1 && dstChannelCount <= 4);
+
+    switch (elementSize)
+    {
+    case 1:
+        copyChannelsImpl<uint8_t>(
+            width, height, pSrc, srcChannelCount, srcRowPitch, pDst, dstChannelCount, dstRowPitch, uint8_t(alphaBits), swapRB
+        );
+        break;
+    case 2:
+        copyChannelsImpl<uint16_t>(
+            width, height, pSrc, srcChannelCount, srcRowPitch, pDst, dstChannelCount, dstRowPitch, uint16_t(alphaBits), swapRB
+        );
+        break;
+    case 4:
+        copyChannelsImpl<uint32_t>(width, height, pSrc, srcChannelCount, srcRowPitch, pDst, dstChannelCount, dstRowPitch, alphaBits, swapRB);
+        break;
+    default:
+        throw ArgumentError("Unsupported element size {}.", elementSize);
+    }
+}
+} // namespace detail
+
+void convertToRGBA32Float(
+    ResourceFormat format,
+    uint32_t width,
+    uint32_t height,
+    const void* pSrc,
+    ptrdiff_t srcRowPitch,
+    float* pDst,
+    ptrdiff_t dstRowPitch,
+    float alpha
+)
+{
+    const FormatType type = getFormatType(format);
+    const uint32_t channelCount = getFormatChannelCount(format);
+    const uint32_t channelBits = getNumChannelBits(format, 0);
+
+    auto convertRows = [&](auto convertRow)
+    {
+        forEachRow(
+            width,
+            height,
+            [&](uint32_t y) { convertRow(getRow<void>(pSrc, srcRowPitch, y), channelCount, getRow<float>(pDst, dstRowPitch, y), width, alpha); }
+        );
+    };
+
+    if (type == FormatType::Float && channelBits == 32)
+    {
+        copyChannels<float>(width, height, static_cast<const float*>(pSrc), channelCount, srcRowPitch, pDst, 4, dstRowPitch, alpha);
+    }
+    else if (type == FormatType::Float && channelBits == 16)
+    {
+        convertRows([](const void* pRow, uint32_t c, float* pDstRow, uint32_t w, float a)
+                    { convertHalfRow(static_cast<const float16_t*>(pRow), c, pDstRow, w, a); });
+    }
+    else if (type == FormatType::Uint && channelBits == 16)
+    {
+        convertRows([](const void* pRow, uint32_t c, float* pDstRow, uint32_t w, float a)
+                    { convertIntRow(static_cast<const uint16_t*>(pRow), c, pDstRow, w, a); });
+    }
+    else if (type == FormatType::Uint && channelBits == 32)
+    {
+        convertRows([](const void* pRow, uint32_t c, float* pDstRow, uint32_t w, float a)
+                    { convertIntRow(static_cast<const uint32_t*>(pRow), c, pDstRow, w, a); });
+    }
+    else if (type == FormatType::Sint && channelBits == 16)
+    {
+        convertRows([](const void* pRow, uint32_t c, float* pDstRow, uint32_t w, float a)
+                    { convertIntRow(static_cast<const int16_t*>(pRow), c, pDstRow, w, a); });
+    }
+    else if (type == FormatType::Sint && channelBits == 32)
+    {
+        convertRows([](const void* pRow, uint32_t c, float* pDstRow, uint32_t w, float a)
+                    { convertIntRow(static_cast<const int32_t*>(pRow), c, pDstRow, w, a); });
+    }
+    else
+    {
+        throw ArgumentError("Can't convert format '{}' to RGBA32Float.", to_string(format));
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,117 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/API/Formats.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Falcor
+{
+namespace detail
+{
+FALCOR_API void copyChannels(
+    size_t elementSize,
+    uint32_t width,
+    uint32_t height,
+    const void* pSrc,
+    uint32_t srcChannelCount,
+    ptrdiff_t srcRowPitch,
+    void* pDst,
+    uint32_t dstChannelCount,
+    ptrdiff_t dstRowPitch,
+    uint32_t alphaBits,
+    bool swapRB
+);
+} // namespace detail
+
+/**
+ * Copy an image with interleaved channels to an image with a different number of channels.
+ * Channels missing in the source are set to zero, except for a missing alpha channel which is set to the given value.
+ * Large images are processed in parallel on the thread pool. The common float RGB <-> RGBA cases use SIMD instructions.
+ * @param[in] width Image width in pixels.
+ * @param[in] height Image height in pixels.
+ * @param[in] pSrc Source image.
+ * @param[in] srcChannelCount Number of channels in the source image (1-4).
+ * @param[in] srcRowPitch Distance between source rows in bytes. Negative values are allowed for flipping the image.
+ * @param[out] pDst Destination image. Must not overlap the source.
+ * @param[in] dstChannelCount Number of channels in the destination image (1-4).
+ * @param[in] dstRowPitch Distance between destination rows in bytes. Negative values are allowed for flipping the image.
+ * @param[in] alpha Value written to the alpha channel if it is not present in the source.
+ * @param[in] swapRB Swap the first and third channel of the destination, e.g. for converting RGBA to BGRA.
+ */
+template<typename T>
+void copyChannels(
+    uint32_t width,
+    uint32_t height,
+    const T* pSrc,
+    uint32_t srcChannelCount,
+    ptrdiff_t srcRowPitch,
+    T* pDst,
+    uint32_t dstChannelCount,
+    ptrdiff_t dstRowPitch,
+    T alpha = T(0),
+    bool swapRB = false
+)
+{
+    static_assert(std::is_trivially_copyable_v<T> && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4));
+    uint32_t alphaBits = 0;
+    std::memcpy(&alphaBits, &alpha, sizeof(T));
+    detail::copyChannels(
+        sizeof(T), width, height, pSrc, srcChannelCount, srcRowPitch, pDst, dstChannelCount, dstRowPitch, alphaBits, swapRB
+    );
+}
+
+/**
+ * Convert an image to an RGBA float image.
+ * Supported are formats with 16-bit float, 32-bit float and 16/32-bit integer channels.
+ * Unsigned integers are normalized to [0,1], signed integers to [-1,1].
+ * Channels missing in the source are set to zero, except for a missing alpha channel which is set to the given value.
+ * Large images are processed in parallel on the thread pool.
+ * @param[in] format Format of the source image.
+ * @param[in] width Image width in pixels.
+ * @param[in] height Image height in pixels.
+ * @param[in] pSrc Source image.
+ * @param[in] srcRowPitch Distance between source rows in bytes.
+ * @param[out] pDst Destination image.
+ * @param[in] dstRowPitch Distance between destination rows in bytes.
+ * @param[in] alpha Value written to the alpha channel if it is not present in the source.
+ */
+FALCOR_API void convertToRGBA32Float(
+    ResourceFormat format,
+    uint32_t width,
+    uint32_t height,
+    const void* pSrc,
+    ptrdiff_t srcRowPitch,
+    float* pDst,
+    ptrdiff_t dstRowPitch,
+    float alpha = 1.f
+);
+} // namespace Falcor
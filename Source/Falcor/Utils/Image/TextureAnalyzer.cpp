@@ -26,7 +26,19 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "TextureAnalyzer.h"
+#include "PixelConversion.h"
 #include "Core/API/RenderContext.h"
+#include "Utils/Threading.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_TEXTURE_ANALYZER_SSE2 1
+#include <emmintrin.h>
+#else
+#define FALCOR_TEXTURE_ANALYZER_SSE2 0
+#endif
 
 namespace Falcor
 {
@@ -39,6 +51,241 @@ static_assert((uint32_t)TextureChannelFlags::Blue == 0x4);
 static_assert((uint32_t)TextureChannelFlags::Alpha == 0x8);
 
 const char kShaderFilename[] = "Utils/Image/TextureAnalyzer.cs.slang";
+
+/// Minimum number of texels analyzed by a single task.
+const size_t kMinTexelsPerTask = 1 << 16;
+
+/**
+ * Describes how texels of a format are decoded to float4, matching a Texture2D<float4> read on the GPU.
+ */
+struct TexelLayout
+{
+    FormatType type;
+    uint32_t channelCount;
+    uint32_t channelBits;
+    bool swapRB;      ///< Channels are stored in BGR order.
+    bool ignoreAlpha; ///< Alpha channel is unused and reads as one.
+};
+
+std::optional<TexelLayout> getTexelLayout(ResourceFormat format)
+{
+    if (format == ResourceFormat::Unknown || isCompressedFormat(format))
+        return {};
+
+    TexelLayout layout = {getFormatType(format), getFormatChannelCount(format), getNumChannelBits(format, 0), false, false};
+
+    // Only formats with equally sized, byte aligned channels are supported.
+    for (uint32_t i = 1; i < layout.channelCount; i++)
+    {
+        if (getNumChannelBits(format, i) != layout.channelBits)
+            return {};
+    }
+    if (layout.channelCount * layout.channelBits != getFormatBytesPerBlock(format) * 8)
+        return {};
+
+    switch (format)
+    {
+    case ResourceFormat::BGRA8Unorm:
+    case ResourceFormat::BGRA8UnormSrgb:
+        layout.swapRB = true;
+        break;
+    case ResourceFormat::BGRX8Unorm:
+    case ResourceFormat::BGRX8UnormSrgb:
+        layout.swapRB = true;
+        layout.ignoreAlpha = true;
+        break;
+    default:
+        break;
+    }
+
+    switch (layout.type)
+    {
+    case FormatType::Float:
+        return layout.channelBits == 16 || layout.channelBits == 32 ? std::make_optional(layout) : std::nullopt;
+    case FormatType::Unorm:
+    case FormatType::UnormSrgb:
+    case FormatType::Snorm:
+        return layout.channelBits == 8 || layout.channelBits == 16 ? std::make_optional(layout) : std::nullopt;
+    default:
+        return {};
+    }
+}
+
+float srgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : float(std::pow((c + 0.055) / 1.055, 2.4));
+}
+
+/**
+ * Decodes rows of image data to RGBA float texels.
+ * Missing channels are set to zero, except for a missing alpha channel which is set to one.
+ */
+class TexelDecoder
+{
+public:
+    TexelDecoder(ResourceFormat format, const TexelLayout& layout) : mFormat(format), mLayout(layout)
+    {
+        if (mLayout.channelBits != 8)
+            return;
+
+        // Build lookup tables for 8-bit formats. The alpha channel of sRGB formats is stored linearly.
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            float value = mLayout.type == FormatType::Snorm ? std::max(float(int8_t(i)) / 127.f, -1.f) : float(i) / 255.f;
+            mColorTable[i] = mLayout.type == FormatType::UnormSrgb ? srgbToLinear(value) : value;
+            mAlphaTable[i] = value;
+        }
+    }
+
+    void decodeRow(const void* pSrc, uint32_t width, float4* pDst) const
+    {
+        if (mLayout.type == FormatType::Float)
+        {
+            convertToRGBA32Float(mFormat, width, 1, pSrc, 0, &pDst[0].x, 0, 1.f);
+        }
+        else if (mLayout.channelBits == 8)
+        {
+            const uint8_t* pSrcTexels = static_cast<const uint8_t*>(pSrc);
+            decodeTexels(
+                width, pDst, [&](uint32_t offset, uint32_t c) { return (c == 3 ? mAlphaTable : mColorTable)[pSrcTexels[offset + c]]; }
+            );
+        }
+        else if (mLayout.type == FormatType::Snorm)
+        {
+            const int16_t* pSrcTexels = static_cast<const int16_t*>(pSrc);
+            decodeTexels(
+                width, pDst, [&](uint32_t offset, uint32_t c) { return std::max(float(pSrcTexels[offset + c]) / 32767.f, -1.f); }
+            );
+        }
+        else
+        {
+            const uint16_t* pSrcTexels = static_cast<const uint16_t*>(pSrc);
+            decodeTexels(width, pDst, [&](uint32_t offset, uint32_t c) { return float(pSrcTexels[offset + c]) / 65535.f; });
+        }
+
+        if (mLayout.swapRB || mLayout.ignoreAlpha)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                if (mLayout.swapRB)
+                    std::swap(pDst[x].x, pDst[x].z);
+                if (mLayout.ignoreAlpha)
+                    pDst[x].w = 1.f;
+            }
+        }
+    }
+
+private:
+    /**
+     * Decode texels with func(offset, channel) returning the value of a channel of the texel stored at the given element offset.
+     */
+    template<typename F>
+    void decodeTexels(uint32_t width, float4* pDst, F&& func) const
+    {
+        const uint32_t channelCount = mLayout.channelCount;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            float4 texel(0.f, 0.f, 0.f, 1.f);
+            for (uint32_t c = 0; c < channelCount; c++)
+                texel[c] = func(x * channelCount, c);
+            pDst[x] = texel;
+        }
+    }
+
+    ResourceFormat mFormat;
+    TexelLayout mLayout;
+    float mColorTable[256];
+    float mAlphaTable[256];
+};
+
+/**
+ * Partial analysis result of a range of texels.
+ */
+struct Statistics
+{
+    uint32_t varying = 0; ///< Channels that differ from the reference value (4 bits).
+    uint32_t pos = 0;     ///< Channels with positive values (4 bits).
+    uint32_t neg = 0;     ///< Channels with negative values (4 bits).
+    uint32_t inf = 0;     ///< Channels with infinite values (4 bits).
+    uint32_t nan = 0;     ///< Channels with NaN values (4 bits).
+    float4 minValue = float4(std::numeric_limits<float>::max());
+    float4 maxValue = float4(-std::numeric_limits<float>::max());
+
+    /**
+     * Accumulate a row of texels. NaN values are not included in the min/max values, like on the GPU.
+     */
+    void accumulate(const float4* pTexels, uint32_t count, const float4& ref)
+    {
+#if FALCOR_TEXTURE_ANALYZER_SSE2
+        const __m128 refValue = _mm_loadu_ps(&ref.x);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 infValue = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        __m128 varyingMask = zero, posMask = zero, negMask = zero, infMask = zero, nanMask = zero;
+        __m128 minV = _mm_loadu_ps(&minValue.x);
+        __m128 maxV = _mm_loadu_ps(&maxValue.x);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const __m128 v = _mm_loadu_ps(&pTexels[i].x);
+            varyingMask = _mm_or_ps(varyingMask, _mm_cmpneq_ps(v, refValue));
+            posMask = _mm_or_ps(posMask, _mm_cmpgt_ps(v, zero));
+            negMask = _mm_or_ps(negMask, _mm_cmplt_ps(v, zero));
+            infMask = _mm_or_ps(infMask, _mm_cmpeq_ps(_mm_and_ps(v, absMask), infValue));
+            nanMask = _mm_or_ps(nanMask, _mm_cmpunord_ps(v, v));
+            // The second operand is returned if either operand is NaN.
+            minV = _mm_min_ps(v, minV);
+            maxV = _mm_max_ps(v, maxV);
+        }
+
+        varying |= uint32_t(_mm_movemask_ps(varyingMask));
+        pos |= uint32_t(_mm_movemask_ps(posMask));
+        neg |= uint32_t(_mm_movemask_ps(negMask));
+        inf |= uint32_t(_mm_movemask_ps(infMask));
+        nan |= uint32_t(_mm_movemask_ps(nanMask));
+        _mm_storeu_ps(&minValue.x, minV);
+        _mm_storeu_ps(&maxValue.x, maxV);
+#else
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                const float v = pTexels[i][c];
+                const uint32_t bit = 1u << c;
+                if (!(v == ref[c]))
+                    varying |= bit;
+                if (v > 0.f)
+                    pos |= bit;
+                if (v < 0.f)
+                    neg |= bit;
+                if (std::isinf(v))
+                    inf |= bit;
+                if (std::isnan(v))
+                    nan |= bit;
+                if (v < minValue[c])
+                    minValue[c] = v;
+                if (v > maxValue[c])
+                    maxValue[c] = v;
+            }
+        }
+#endif
+    }
+
+    static Statistics combine(Statistics a, const Statistics& b)
+    {
+        a.varying |= b.varying;
+        a.pos |= b.pos;
+        a.neg |= b.neg;
+        a.inf |= b.inf;
+        a.nan |= b.nan;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            a.minValue[c] = std::min(a.minValue[c], b.minValue[c]);
+            a.maxValue[c] = std::max(a.maxValue[c], b.maxValue[c]);
+        }
+        return a;
+    }
+};
 } // namespace
 
 // Verify that the result struct matches the size expected by the shader.
@@ -111,6 +358,69 @@ void TextureAnalyzer::analyze(RenderContext* pRenderContext, const std::vector<r
     }
 }
 
+std::optional<TextureAnalyzer::Result> TextureAnalyzer::analyzeImage(
+    ResourceFormat format,
+    uint32_t width,
+    uint32_t height,
+    const void* pData,
+    size_t rowPitch
+)
+{
+    FALCOR_CHECK_ARG(width > 0 && height > 0);
+    FALCOR_CHECK_ARG(pData != nullptr);
+
+    auto layout = getTexelLayout(format);
+    if (!layout)
+        return {};
+
+    const TexelDecoder decoder(format, *layout);
+    auto getRow = [&](size_t y) { return static_cast<const uint8_t*>(pData) + y * rowPitch; };
+
+    // Read reference value from top-left texel.
+    float4 ref;
+    decoder.decodeRow(getRow(0), 1, &ref);
+
+    const size_t grainSize = std::max<size_t>(1, kMinTexelsPerTask / width);
+    Statistics stats = Threading::parallelReduce(
+        0,
+        height,
+        Statistics(),
+        [&](size_t begin, size_t end, Statistics partial)
+        {
+            std::vector<float4> texels(width);
+            for (size_t y = begin; y < end; y++)
+            {
+                decoder.decodeRow(getRow(y), width, texels.data());
+                partial.accumulate(texels.data(), width, ref);
+            }
+            return partial;
+        },
+        Statistics::combine,
+        grainSize
+    );
+
+    // Produce the result in the same format as the shader. See TextureAnalyzer.cs.slang.
+    Result result = {};
+    result.mask = stats.varying;
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        uint32_t range = 0;
+        range |= (stats.pos >> c) & 1 ? (uint32_t)Result::RangeFlags::Pos : 0;
+        range |= (stats.neg >> c) & 1 ? (uint32_t)Result::RangeFlags::Neg : 0;
+        range |= (stats.inf >> c) & 1 ? (uint32_t)Result::RangeFlags::Inf : 0;
+        range |= (stats.nan >> c) & 1 ? (uint32_t)Result::RangeFlags::NaN : 0;
+        result.mask |= range << (4 + 4 * c);
+
+        // Min/max values are clamped to zero. Channels with only NaN values end up as zero.
+        const bool hasValues = stats.minValue[c] <= stats.maxValue[c];
+        result.minValue[c] = hasValues ? std::max(stats.minValue[c], 0.f) : 0.f;
+        result.maxValue[c] = hasValues ? std::max(stats.maxValue[c], 0.f) : 0.f;
+    }
+    result.value = ref;
+
+    return result;
+}
+
 void TextureAnalyzer::clear(RenderContext* pRenderContext, ref<Buffer> pResult, uint64_t resultOffset, size_t resultCount) const
 {
     FALCOR_ASSERT(pRenderContext);
@@ -33,6 +33,7 @@
 #include "Core/Pass/ComputePass.h"
 #include "Utils/Math/Vector.h"
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace Falcor
@@ -131,6 +132,19 @@ public:
      */
     void analyze(RenderContext* pRenderContext, const std::vector<ref<Texture>>& inputs, ref<Buffer> pResult, bool clearResult = true);
 
+    /**
+     * Analyze 2D image data on the CPU.
+     * The result is identical to analyzing a texture of the given format created from the data on the GPU.
+     * Large images are processed in parallel on the thread pool.
+     * @param[in] format Format of the image data. Block-compressed, packed and integer formats are not supported.
+     * @param[in] width Image width in pixels.
+     * @param[in] height Image height in pixels.
+     * @param[in] pData Image data.
+     * @param[in] rowPitch Distance between rows in bytes.
+     * @return The analysis result, or an empty optional if the format is not supported.
+     */
+    static std::optional<Result> analyzeImage(ResourceFormat format, uint32_t width, uint32_t height, const void* pData, size_t rowPitch);
+
     /**
      * Helper function to clear the results buffer.
      * @param[in] pRenderContext The context.
@@ -0,0 +1,242 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "TextureBaker.h"
+#include "Bitmap.h"
+#include "PixelConversion.h"
+#include "TextureAnalyzer.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Math/XXHash.h"
+#include <random>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+const char kDefaultCacheDirectory[] = "NVIDIA/Falcor/TextureCache";
+const char kTempExtension[] = ".tmp";
+constexpr bool kTopDown = true; // Memory layout when loading from file
+
+/// Version of the baked files. Increment when changing how textures are baked to invalidate existing cache entries.
+constexpr uint32_t kBakeVersion = 2;
+
+struct CacheKeyData
+{
+    uint32_t version;
+    uint32_t usage;
+    uint32_t generateMips;
+    uint32_t compactColor;
+};
+
+/**
+ * Check if an image has an alpha channel with non-opaque texels.
+ * Images in formats that can't be analyzed on the CPU are assumed to be transparent if they have an alpha channel.
+ */
+bool hasTransparentTexels(const Bitmap& bitmap)
+{
+    const ResourceFormat format = bitmap.getFormat();
+    if (getFormatChannelCount(format) < 4 || format == ResourceFormat::BGRX8Unorm)
+        return false;
+
+    auto result = TextureAnalyzer::analyzeImage(format, bitmap.getWidth(), bitmap.getHeight(), bitmap.getData(), bitmap.getRowPitch());
+    return !result || result->minValue.w < 1.f;
+}
+
+/**
+ * Convert an image to a format that can be block-compressed by ImageIO::saveToDDS().
+ * 8-bit images are expanded to BGRA8. Other formats, except for 16-bit and 32-bit float RGBA, are converted to 32-bit float RGBA.
+ */
+Bitmap::UniqueConstPtr convertForCompression(Bitmap::UniqueConstPtr pBitmap)
+{
+    ResourceFormat format = pBitmap->getFormat();
+    uint32_t width = pBitmap->getWidth();
+    uint32_t height = pBitmap->getHeight();
+
+    switch (format)
+    {
+    case ResourceFormat::BGRA8Unorm:
+    case ResourceFormat::BGRX8Unorm:
+    case ResourceFormat::RGBA16Float:
+    case ResourceFormat::RGBA32Float:
+        return pBitmap;
+    default:
+        break;
+    }
+
+    if (getNumChannelBits(format, 0) == 8 && getFormatType(format) == FormatType::Unorm)
+    {
+        std::vector<uint8_t> data(size_t(width) * height * 4);
+        copyChannels<uint8_t>(
+            width, height, pBitmap->getData(), getFormatChannelCount(format), pBitmap->getRowPitch(), data.data(), 4, width * 4,
+            uint8_t(255), true
+        );
+        return Bitmap::create(width, height, ResourceFormat::BGRA8Unorm, data.data());
+    }
+
+    std::vector<float> data(size_t(width) * height * 4);
+    convertToRGBA32Float(format, width, height, pBitmap->getData(), pBitmap->getRowPitch(), data.data(), width * 4 * sizeof(float));
+    return Bitmap::create(width, height, ResourceFormat::RGBA32Float, reinterpret_cast<const uint8_t*>(data.data()));
+}
+} // namespace
+
+TextureBaker::TextureBaker() : TextureBaker(Options{}) {}
+
+TextureBaker::TextureBaker(const Options& options) : mOptions(options)
+{
+    mCacheDirectory = mOptions.cacheDirectory.empty() ? getAppDataDirectory() / kDefaultCacheDirectory : mOptions.cacheDirectory;
+
+    std::error_code ec;
+    std::filesystem::create_directories(mCacheDirectory, ec);
+    if (!std::filesystem::is_directory(mCacheDirectory, ec))
+        throw RuntimeError("Failed to create texture cache directory '{}'.", mCacheDirectory);
+}
+
+ImageIO::CompressionMode TextureBaker::chooseCompressionMode(ResourceFormat format, Usage usage, bool hasAlpha, bool compactColor)
+{
+    uint32_t channelCount = getFormatChannelCount(format);
+
+    if (usage == Usage::Lossless)
+        return ImageIO::CompressionMode::None;
+    if (usage == Usage::Normal)
+        return ImageIO::CompressionMode::BC5;
+
+    // BC6H only stores HDR color without alpha. The other formats are unorm and would clamp float images, which are
+    // therefore stored uncompressed.
+    const bool isFloat = getFormatType(format) == FormatType::Float;
+    if (usage == Usage::Scalar)
+        return isFloat ? ImageIO::CompressionMode::None : ImageIO::CompressionMode::BC4;
+    if (hasAlpha)
+        return isFloat ? ImageIO::CompressionMode::None : ImageIO::CompressionMode::BC7;
+    if (channelCount == 2)
+        return isFloat ? ImageIO::CompressionMode::None : ImageIO::CompressionMode::BC5;
+    if (channelCount == 1)
+        return isFloat ? ImageIO::CompressionMode::None : ImageIO::CompressionMode::BC4;
+    if (isFloat)
+        return ImageIO::CompressionMode::BC6;
+    return compactColor ? ImageIO::CompressionMode::BC1 : ImageIO::CompressionMode::BC7;
+}
+
+std::filesystem::path TextureBaker::bake(const std::filesystem::path& path, Usage usage, bool generateMips)
+{
+    if (hasExtension(path, "dds"))
+        return path;
+
+    auto key = std::make_tuple(path, usage, generateMips);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (auto it = mBakedPaths.find(key); it != mBakedPaths.end())
+            return it->second;
+    }
+
+    std::filesystem::path bakedPath;
+    try
+    {
+        bakedPath = bakeFile(path, usage, generateMips);
+    }
+    catch (const std::exception& e)
+    {
+        logWarning("Failed to bake texture '{}': {}", path, e.what());
+        mFailedCount++;
+    }
+
+    // Failures are recorded as well to not retry them.
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBakedPaths.emplace(key, bakedPath);
+    return bakedPath;
+}
+
+TextureBaker::Stats TextureBaker::getStats() const
+{
+    Stats stats;
+    stats.bakedCount = mBakedCount;
+    stats.cacheHitCount = mCacheHitCount;
+    stats.failedCount = mFailedCount;
+    return stats;
+}
+
+std::filesystem::path TextureBaker::bakeFile(const std::filesystem::path& path, Usage usage, bool generateMips)
+{
+    // Cache entries are addressed by the hash of the source file and the baking parameters.
+    std::string source = readFile(path);
+    CacheKeyData keyData = {kBakeVersion, uint32_t(usage), uint32_t(generateMips), uint32_t(mOptions.compactColor)};
+    uint64_t hash = xxHash64(source.data(), source.size());
+    hash = xxHash64(&keyData, sizeof(keyData), hash);
+    source = {};
+
+    std::filesystem::path bakedPath = mCacheDirectory / fmt::format("{:016x}.dds", hash);
+    std::error_code ec;
+    if (std::filesystem::exists(bakedPath, ec))
+    {
+        mCacheHitCount++;
+        return bakedPath;
+    }
+
+    Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(path, kTopDown);
+    if (!pBitmap)
+        throw RuntimeError("Failed to load image.");
+
+    bool hasAlpha = hasTransparentTexels(*pBitmap);
+    ImageIO::CompressionMode mode = chooseCompressionMode(pBitmap->getFormat(), usage, hasAlpha, mOptions.compactColor);
+
+    // Block compression with mips requires dimensions that are a multiple of the block size. Other images would be
+    // cropped by ImageIO::saveToDDS(), so they are stored uncompressed instead.
+    if (generateMips && (pBitmap->getWidth() % 4 != 0 || pBitmap->getHeight() % 4 != 0))
+        mode = ImageIO::CompressionMode::None;
+
+    pBitmap = convertForCompression(std::move(pBitmap));
+
+    // Write to a uniquely named temporary file first so that concurrent readers never see a partial file.
+    static thread_local std::mt19937_64 rng{std::random_device{}()};
+    std::filesystem::path tempPath = bakedPath;
+    tempPath.replace_extension(fmt::format("{:016x}{}.dds", rng(), kTempExtension));
+
+    try
+    {
+        ImageIO::saveToDDS(tempPath, *pBitmap, mode, generateMips);
+    }
+    catch (const std::exception&)
+    {
+        std::filesystem::remove(tempPath, ec);
+        throw;
+    }
+
+    // Another process may have baked the same texture in the meantime. Its file is identical and can be replaced.
+    std::filesystem::rename(tempPath, bakedPath, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        if (!std::filesystem::exists(bakedPath, ec))
+            throw RuntimeError("Failed to move baked texture to '{}'.", bakedPath);
+    }
+
+    logDebug("Baked texture '{}' to '{}'.", path, bakedPath);
+    mBakedCount++;
+    return bakedPath;
+}
+} // namespace Falcor
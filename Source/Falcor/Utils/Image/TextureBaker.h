@@ -0,0 +1,122 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "ImageIO.h"
+#include "Core/Macros.h"
+#include "Core/API/Formats.h"
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace Falcor
+{
+/**
+ * Converts source textures to block-compressed DDS files with a full mip chain.
+ *
+ * Baked textures are stored in a cache directory and are addressed by a hash of the source file contents and
+ * the baking parameters, so a texture is only baked once even if the source file is moved or copied. Loading
+ * a baked texture skips image decoding and mip generation. Compression runs on the CPU and doesn't need a GPU.
+ *
+ * The compression format is chosen based on the usage of the texture and the format of the source image
+ * (see chooseCompressionMode()). Mips are generated with a box filter in the color space of the source data.
+ *
+ * The cache directory can be shared between processes. Files are written to temporary files and moved into place.
+ * All operations are thread-safe.
+ */
+class FALCOR_API TextureBaker
+{
+public:
+    /// Usage of a texture. Determines the compression format.
+    enum class Usage
+    {
+        Color,    ///< Color data. Compressed to BC7, BC1 or BC6H.
+        Normal,   ///< Tangent space normal map. Compressed to BC5, Z is reconstructed when sampling.
+        Scalar,   ///< Single channel data. Compressed to BC4, or stored uncompressed if float.
+        Lossless, ///< Data that must not be compressed, such as indices. Stored uncompressed.
+    };
+
+    struct Options
+    {
+        std::filesystem::path cacheDirectory; ///< Cache directory. If empty, a directory in the app data directory is used.
+        bool compactColor = false;            ///< Compress opaque color textures to BC1 instead of BC7, halving their size.
+    };
+
+    struct Stats
+    {
+        uint64_t bakedCount = 0;    ///< Number of textures baked.
+        uint64_t cacheHitCount = 0; ///< Number of textures found in the cache.
+        uint64_t failedCount = 0;   ///< Number of textures that failed to bake.
+    };
+
+    TextureBaker();
+    explicit TextureBaker(const Options& options);
+
+    /**
+     * Choose the compression mode for a texture.
+     * Normal maps use BC5. Otherwise, images with alpha use BC7, two channel images use BC5, single channel images use BC4
+     * and float color images use BC6H. Float images that BC6H can't store, i.e., with alpha or fewer than three channels,
+     * are stored uncompressed.
+     * @param[in] format Format of the source image.
+     * @param[in] usage Usage of the texture.
+     * @param[in] hasAlpha True if the image has a non-opaque alpha channel.
+     * @param[in] compactColor Use BC1 for opaque color images.
+     * @return The compression mode.
+     */
+    static ImageIO::CompressionMode chooseCompressionMode(ResourceFormat format, Usage usage, bool hasAlpha, bool compactColor);
+
+    /**
+     * Bake a texture, or look up the result of an earlier bake.
+     * DDS files are returned as is. Errors are logged and result in an empty path.
+     * @param[in] path Path of the source image.
+     * @param[in] usage Usage of the texture.
+     * @param[in] generateMips Generate the full mip chain.
+     * @return Path of the baked DDS file, or an empty path if the texture can't be baked.
+     */
+    std::filesystem::path bake(const std::filesystem::path& path, Usage usage, bool generateMips = true);
+
+    const std::filesystem::path& getCacheDirectory() const { return mCacheDirectory; }
+
+    Stats getStats() const;
+
+private:
+    std::filesystem::path bakeFile(const std::filesystem::path& path, Usage usage, bool generateMips);
+
+    Options mOptions;
+    std::filesystem::path mCacheDirectory;
+
+    mutable std::mutex mMutex;
+    /// Map from source path and baking parameters to the baked path. Avoids hashing the source file again.
+    std::map<std::tuple<std::filesystem::path, Usage, bool>, std::filesystem::path> mBakedPaths;
+
+    std::atomic<uint64_t> mBakedCount{0};
+    std::atomic<uint64_t> mCacheHitCount{0};
+    std::atomic<uint64_t> mFailedCount{0};
+};
+} // namespace Falcor
@@ -27,10 +27,14 @@
  **************************************************************************/
 #include "TextureManager.h"
 #include "Core/API/Device.h"
+#include "Core/API/RenderContext.h"
 #include "Utils/Logger.h"
-#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/XXHash.h"
 
-#include <execution>
+#include <atomic>
+#include <set>
 
 // Temporarily disable asynchronous texture loader until Falcor supports parallel GPU work submission.
 // Until then `TextureManager` should only called from the main thread.
@@ -42,13 +46,52 @@ namespace
 {
 const size_t kMaxTextureHandleCount = std::numeric_limits<uint32_t>::max();
 static_assert(TextureManager::TextureHandle::kInvalidID >= kMaxTextureHandleCount);
+
+/**
+ * Compute a hash of the contents of texture files.
+ * This is used for finding duplicate textures before decoding them.
+ * @return Hash of all files, or an empty optional if a file can't be read.
+ */
+std::optional<uint64_t> computeFileHash(const std::vector<std::filesystem::path>& paths)
+{
+    uint64_t hash = 0;
+    try
+    {
+        for (const auto& path : paths)
+        {
+            std::string data = readFile(path);
+            hash = xxHash64(data.data(), data.size(), hash);
+        }
+    }
+    catch (const std::exception&)
+    {
+        return {};
+    }
+    return hash;
+}
+
+/**
+ * Erase all entries of a map with the given value.
+ */
+template<typename Map, typename Value>
+void eraseValue(Map& map, const Value& value)
+{
+    for (auto it = map.begin(); it != map.end();)
+        it = it->second == value ? map.erase(it) : std::next(it);
+}
 } // namespace
 
 TextureManager::TextureManager(ref<Device> pDevice, size_t maxTextureCount, size_t threadCount)
     : mpDevice(pDevice), mAsyncTextureLoader(pDevice, threadCount), mMaxTextureCount(std::min(maxTextureCount, kMaxTextureHandleCount))
 {}
 
-TextureManager::~TextureManager() {}
+TextureManager::~TextureManager()
+{
+    // Cancel mips still streaming in. The texture loader finishes its requests before it is destroyed.
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& resident : mResidentTextures)
+        resident.pendingToken.cancel();
+}
 
 TextureManager::TextureHandle TextureManager::addTexture(const ref<Texture>& pTexture)
 {
@@ -109,7 +152,8 @@ TextureManager::TextureHandle TextureManager::loadUdimTexture(
     Resource::BindFlags bindFlags,
     bool async,
     const SearchDirectories* searchDirectories,
-    size_t* loadedTextureCount
+    size_t* loadedTextureCount,
+    TextureBaker::Usage usage
 )
 {
     std::string filename = path.filename().string();
@@ -121,7 +165,7 @@ TextureManager::TextureHandle TextureManager::loadUdimTexture(
 
     auto pos = filename.find("<UDIM>");
     if (pos == std::string::npos)
-        return loadTexture(path, generateMipLevels, loadAsSRGB, bindFlags, async);
+        return loadTexture(path, generateMipLevels, loadAsSRGB, bindFlags, async, nullptr, nullptr, usage);
 
     std::filesystem::path dirpath = path.parent_path();
     filename.replace(pos, 6, "[1-9][0-9][0-9][0-9]");
@@ -161,7 +205,7 @@ TextureManager::TextureHandle TextureManager::loadUdimTexture(
         size_t udim = std::stol(udimStr);
         maxIndex = std::max<size_t>(maxIndex, udim);
         udimIndices.push_back(udim);
-        handles.push_back(loadTexture(it, generateMipLevels, loadAsSRGB, bindFlags, async));
+        handles.push_back(loadTexture(it, generateMipLevels, loadAsSRGB, bindFlags, async, nullptr, nullptr, usage));
 
         FALCOR_CHECK_ARG_GE_MSG(udim, 1001, "Texture {} is not a valid UDIM texture, as it violates the valid UDIM range of 1001-9999", it);
     }
@@ -185,11 +229,12 @@ TextureManager::TextureHandle TextureManager::loadTexture(
     Resource::BindFlags bindFlags,
     bool async,
     const SearchDirectories* searchDirectories,
-    size_t* loadedTextureCount
+    size_t* loadedTextureCount,
+    TextureBaker::Usage usage
 )
 {
     if (path.string().find("<UDIM>") != std::string::npos)
-        return loadUdimTexture(path, generateMipLevels, loadAsSRGB, bindFlags, async, searchDirectories, loadedTextureCount);
+        return loadUdimTexture(path, generateMipLevels, loadAsSRGB, bindFlags, async, searchDirectories, loadedTextureCount, usage);
 
     std::vector<std::filesystem::path> paths;
     auto addPath = [&](const std::filesystem::path& p)
@@ -237,7 +282,7 @@ TextureManager::TextureHandle TextureManager::loadTexture(
     }
 
     std::unique_lock<std::mutex> lock(mMutex);
-    const TextureKey textureKey(paths, generateMipLevels, loadAsSRGB, bindFlags);
+    const TextureKey textureKey(paths, generateMipLevels, loadAsSRGB, bindFlags, usage);
     if (auto it = mKeyToHandle.find(textureKey); it != mKeyToHandle.end())
     {
         // Texture is already managed. Return its handle.
@@ -270,7 +315,7 @@ TextureManager::TextureHandle TextureManager::loadTexture(
 
         // Function called by the async texture loader when loading finishes.
         // It's called by a worker thread so needs to acquire the mutex before changing any state.
-        auto callback = [=](ref<Texture> pTexture)
+        auto callback = [=](ref<Texture> pTexture, const AsyncTextureLoader::Analysis& analysis)
         {
             std::unique_lock<std::mutex> lock(mMutex);
 
@@ -278,6 +323,7 @@ TextureManager::TextureHandle TextureManager::loadTexture(
             auto& desc = getDesc(handle);
             desc.state = TextureState::Loaded;
             desc.pTexture = pTexture;
+            desc.analysis = analysis;
 
             // Add to texture-to-handle map.
             if (pTexture)
@@ -298,27 +344,77 @@ TextureManager::TextureHandle TextureManager::loadTexture(
         }
 #else
         // Load texture from main thread.
-        ref<Texture> pTexture;
-        if (paths.size() > 1)
+        // Textures with identical contents are loaded once. The hash of the files is checked first to skip decoding
+        // duplicates, then the hash of the decoded data is checked to skip creating duplicates.
+        const TextureKey loadKey = getLoadKey(textureKey);
+        std::optional<uint64_t> fileHash = computeFileHash(loadKey.fullPaths);
+        if (fileHash)
         {
-            pTexture = Texture::createMippedFromFiles(mpDevice, paths, loadAsSRGB, bindFlags);
+            if (auto it = mFileHashToHandle.find(ContentKey(*fileHash, textureKey)); it != mFileHashToHandle.end())
+            {
+                handle = it->second;
+                logDebug("Texture '{}' has identical file contents as an already loaded texture.", paths[0]);
+            }
         }
-        else
+
+        if (!handle)
         {
-            pTexture = Texture::createFromFile(mpDevice, paths[0], generateMipLevels, loadAsSRGB, bindFlags);
+            std::optional<ContentKey> contentKey;
+            auto contentHashCallback = [&](uint64_t contentHash)
+            {
+                contentKey = ContentKey(contentHash, textureKey);
+                if (auto it = mContentHashToHandle.find(*contentKey); it != mContentHashToHandle.end())
+                {
+                    handle = it->second;
+                    logDebug("Texture '{}' has identical image data as an already loaded texture.", paths[0]);
+                }
+                return !handle;
+            };
+
+            // Streamed textures only load their mip tail.
+            AsyncTextureLoader::TextureInfo info;
+            AsyncTextureLoader::FirstMipCallback firstMipCallback;
+            if (mpResidency)
+            {
+                firstMipCallback = [&](const AsyncTextureLoader::TextureInfo& decodedInfo)
+                {
+                    info = decodedInfo;
+                    return getTailMip(info);
+                };
+            }
+
+            AsyncTextureLoader::Analysis analysis;
+            ref<Texture> pTexture = AsyncTextureLoader::loadTexture(
+                mpDevice, loadKey.fullPaths, generateMipLevels, loadAsSRGB, bindFlags, &analysis, contentHashCallback, firstMipCallback
+            );
+
+            // Baked textures are identified by their source file. The baked file is only used for loading.
+            if (pTexture)
+                pTexture->setSourcePath(paths[0]);
+
+            if (!handle)
+            {
+                // Add new texture desc.
+                TextureDesc desc = {TextureState::Loaded, pTexture, analysis};
+                handle = addDesc(desc);
+
+                // Add to texture-to-handle and content-to-handle maps.
+                if (pTexture)
+                {
+                    mTextureToHandle[pTexture.get()] = handle;
+                    mContentHashToHandle[*contentKey] = handle;
+                }
+
+                addResidentTexture(handle, loadKey, info, mpDevice->getRenderContext());
+            }
         }
 
-        // Add new texture desc.
-        TextureDesc desc = {TextureState::Loaded, pTexture};
-        handle = addDesc(desc);
+        if (fileHash && getDesc(handle).pTexture)
+            mFileHashToHandle.emplace(ContentKey(*fileHash, textureKey), handle);
 
-        // Add to key-to-handle map.
+        // Add to key-to-handle map. Textures with identical contents have multiple keys.
         mKeyToHandle[textureKey] = handle;
 
-        // Add to texture-to-handle map.
-        if (pTexture)
-            mTextureToHandle[pTexture.get()] = handle;
-
         mCondition.notify_all();
 #endif
     }
@@ -364,7 +460,12 @@ void TextureManager::endDeferredLoading()
     struct Job
     {
         TextureKey key;
+        TextureKey loadKey; ///< Key with the paths of the files to load. These are the baked files if baking is enabled.
         TextureHandle handle;
+        std::optional<uint64_t> fileHash;
+        TextureHandle sharedHandle; ///< Handle of a texture with identical contents, or an invalid handle.
+        bool isFileDuplicate = false;
+        AsyncTextureLoader::TextureInfo info; ///< Description of the full resolution texture. Set for streamed textures.
     };
 
     // Get a list of textures to load.
@@ -373,7 +474,7 @@ void TextureManager::endDeferredLoading()
     {
         auto& desc = getDesc(handle);
         if (desc.state == TextureState::Referenced)
-            jobs.push_back(Job{key, handle});
+            jobs.push_back(Job{key, key, handle});
     }
 
     // Early out if there are no textures to load.
@@ -381,27 +482,69 @@ void TextureManager::endDeferredLoading()
     if (jobs.empty())
         return;
 
-    // Load textures in parallel.
+    // Bake and hash the texture files in parallel.
+    Threading::parallelFor(
+        0, jobs.size(),
+        [&](size_t i)
+        {
+            jobs[i].loadKey = getLoadKey(jobs[i].key);
+            jobs[i].fileHash = computeFileHash(jobs[i].loadKey.fullPaths);
+        }
+    );
+
+    // Textures with identical files are not loaded. They share the texture of an already loaded texture or of the first job loading it.
+    // The handles of the jobs have already been returned, so duplicates keep their handle.
+    for (auto& job : jobs)
+    {
+        if (!job.fileHash)
+            continue;
+        auto [it, inserted] = mFileHashToHandle.try_emplace(ContentKey(*job.fileHash, job.key), job.handle);
+        if (!inserted)
+        {
+            job.sharedHandle = it->second;
+            job.isFileDuplicate = true;
+        }
+    }
+
+    // Load textures in parallel. Textures with identical decoded data are not created.
+    std::mutex contentHashMutex;
     std::atomic<size_t> texturesLoaded;
-    NumericRange<size_t> jobRange(0, jobs.size());
-    std::for_each(
-        std::execution::par_unseq, jobRange.begin(), jobRange.end(),
+    Threading::parallelFor(
+        0, jobs.size(),
         [&](size_t i)
         {
-            const auto& job = jobs[i];
-            auto& desc = getDesc(job.handle);
-            if (job.key.fullPaths.size() == 1)
+            auto& job = jobs[i];
+            if (job.sharedHandle)
+                return;
+
+            auto contentHashCallback = [&](uint64_t contentHash)
             {
-                desc.pTexture = Texture::createFromFile(
-                    mpDevice, job.key.fullPaths[0], job.key.generateMipLevels, job.key.loadAsSRGB, job.key.bindFlags
-                );
-                logDebug("Loading texture from '{}'", job.key.fullPaths[0]);
-            }
-            else
+                std::lock_guard<std::mutex> lock(contentHashMutex);
+                auto [it, inserted] = mContentHashToHandle.try_emplace(ContentKey(contentHash, job.key), job.handle);
+                if (!inserted)
+                    job.sharedHandle = it->second;
+                return inserted;
+            };
+
+            // Streamed textures only load their mip tail.
+            AsyncTextureLoader::FirstMipCallback firstMipCallback;
+            if (mpResidency)
             {
-                desc.pTexture = Texture::createMippedFromFiles(mpDevice, job.key.fullPaths, job.key.loadAsSRGB, job.key.bindFlags);
-                logDebug("Loading mipped texture from '{}'", job.key.fullPaths[0]);
+                firstMipCallback = [&](const AsyncTextureLoader::TextureInfo& info)
+                {
+                    job.info = info;
+                    return getTailMip(info);
+                };
             }
+
+            auto& desc = getDesc(job.handle);
+            desc.pTexture = AsyncTextureLoader::loadTexture(
+                mpDevice, job.loadKey.fullPaths, job.key.generateMipLevels, job.key.loadAsSRGB, job.key.bindFlags, &desc.analysis,
+                contentHashCallback, firstMipCallback
+            );
+            if (desc.pTexture)
+                desc.pTexture->setSourcePath(job.key.fullPaths[0]);
+            logDebug("Loading {}texture from '{}'", job.key.fullPaths.size() > 1 ? "mipped " : "", job.key.fullPaths[0]);
             if (texturesLoaded.fetch_add(1) % 10 == 9)
             {
                 logDebug("Flush");
@@ -415,9 +558,60 @@ void TextureManager::endDeferredLoading()
     // Mark loaded textures and add them to lookup table.
     for (const auto& job : jobs)
     {
+        if (job.sharedHandle)
+            continue;
         auto& desc = getDesc(job.handle);
         desc.state = desc.pTexture ? TextureState::Loaded : TextureState::Invalid;
-        mTextureToHandle[desc.pTexture.get()] = job.handle;
+        if (desc.pTexture)
+        {
+            mTextureToHandle[desc.pTexture.get()] = job.handle;
+            addResidentTexture(job.handle, job.loadKey, job.info, mpDevice->getRenderContext());
+        }
+        else
+        {
+            eraseValue(mFileHashToHandle, job.handle);
+            eraseValue(mContentHashToHandle, job.handle);
+        }
+    }
+
+    // Share the textures of duplicates. Duplicates of identical files are resolved last, as they can refer to
+    // a job with identical decoded data.
+    auto shareTexture = [&](const Job& job)
+    {
+        TextureHandle sharedHandle = job.sharedHandle;
+        if (auto it = mSharedHandles.find(sharedHandle.getID()); it != mSharedHandles.end())
+            sharedHandle = it->second;
+
+        auto& desc = getDesc(job.handle);
+        desc = getDesc(sharedHandle);
+        if (desc.pTexture)
+        {
+            mSharedHandles[job.handle.getID()] = sharedHandle;
+            logDebug("Texture '{}' is identical to an already loaded texture.", job.key.fullPaths[0]);
+        }
+
+        // The file hash refers to the texture that is shared.
+        if (job.fileHash)
+        {
+            auto it = mFileHashToHandle.find(ContentKey(*job.fileHash, job.key));
+            if (it != mFileHashToHandle.end() && it->second == job.handle)
+            {
+                if (desc.pTexture)
+                    it->second = sharedHandle;
+                else
+                    mFileHashToHandle.erase(it);
+            }
+        }
+    };
+    for (const auto& job : jobs)
+    {
+        if (job.sharedHandle && !job.isFileDuplicate)
+            shareTexture(job);
+    }
+    for (const auto& job : jobs)
+    {
+        if (job.sharedHandle && job.isFileDuplicate)
+            shareTexture(job);
     }
 }
 
@@ -441,14 +635,52 @@ void TextureManager::removeTexture(const TextureHandle& handle)
 
     // Remove handle from maps.
     // Note not all handles exist in key-to-handle map so search for it. This can be optimized if needed.
-    auto it = std::find_if(mKeyToHandle.begin(), mKeyToHandle.end(), [handle](const auto& keyVal) { return keyVal.second == handle; });
-    if (it != mKeyToHandle.end())
-        mKeyToHandle.erase(it);
+    // Textures with identical contents loaded from different files have multiple keys.
+    eraseValue(mKeyToHandle, handle);
+    eraseValue(mFileHashToHandle, handle);
+    eraseValue(mContentHashToHandle, handle);
 
-    if (desc.pTexture)
+    // Handles sharing the texture of another handle are not in the texture-to-handle map.
+    if (mSharedHandles.erase(handle.getID()) == 0)
     {
-        FALCOR_ASSERT(mTextureToHandle.find(desc.pTexture.get()) != mTextureToHandle.end());
-        mTextureToHandle.erase(desc.pTexture.get());
+        // Streamed textures are identified by their mip tail texture.
+        const Texture* pTexture = desc.pTexture.get();
+        if (auto residentIt = mHandleToResidencyID.find(handle.getID()); residentIt != mHandleToResidencyID.end())
+        {
+            pTexture = mResidentTextures[residentIt->second].pTail.get();
+            mResidentTextures[residentIt->second].pendingToken.cancel();
+            mpResidency->removeTexture(residentIt->second);
+            mResidentTextures[residentIt->second] = {};
+            mHandleToResidencyID.erase(residentIt);
+        }
+
+        if (pTexture)
+        {
+            FALCOR_ASSERT(mTextureToHandle.find(pTexture) != mTextureToHandle.end());
+            mTextureToHandle.erase(pTexture);
+        }
+
+        // Handles sharing the texture keep it alive. The first one takes over the texture from the removed handle.
+        TextureHandle newOwner;
+        for (auto sharedIt = mSharedHandles.begin(); sharedIt != mSharedHandles.end();)
+        {
+            if (!(sharedIt->second == handle))
+            {
+                ++sharedIt;
+            }
+            else if (!newOwner)
+            {
+                newOwner = TextureHandle(sharedIt->first);
+                sharedIt = mSharedHandles.erase(sharedIt);
+            }
+            else
+            {
+                sharedIt->second = newOwner;
+                ++sharedIt;
+            }
+        }
+        if (newOwner)
+            mTextureToHandle[getDesc(newOwner).pTexture.get()] = newOwner;
     }
 
     // Clear texture desc.
@@ -458,6 +690,108 @@ void TextureManager::removeTexture(const TextureHandle& handle)
     mFreeList.push_back(handle);
 }
 
+void TextureManager::enableResidency(const TextureResidency::Options& options)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mpResidency)
+        throw RuntimeError("Texture residency is already enabled");
+    mpResidency = std::make_unique<TextureResidency>(options);
+}
+
+void TextureManager::enableTextureBaking(const TextureBaker::Options& options)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mpTextureBaker)
+        throw RuntimeError("Texture baking is already enabled");
+    mpTextureBaker = std::make_unique<TextureBaker>(options);
+}
+
+TextureBaker::Stats TextureManager::getTextureBakingStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mpTextureBaker ? mpTextureBaker->getStats() : TextureBaker::Stats{};
+}
+
+void TextureManager::setResidencyBudget(uint64_t budgetInBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mpResidency)
+        throw RuntimeError("Texture residency is not enabled");
+    mpResidency->setBudget(budgetInBytes);
+}
+
+void TextureManager::requestMipLevel(const TextureHandle& handle, uint32_t mip)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (auto id = getResidencyID(handle); id != TextureResidency::kInvalidID)
+        mpResidency->requestMip(id, mip);
+}
+
+void TextureManager::requestMipLevelFromDistance(const TextureHandle& handle, float objectSize, float distance, float pixelAngle)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (auto id = getResidencyID(handle); id != TextureResidency::kInvalidID)
+    {
+        const auto& resident = mResidentTextures[id];
+        uint32_t mip = TextureResidency::computeMipFromDistance(resident.width, resident.height, objectSize, distance, pixelAngle);
+        mpResidency->requestMip(id, mip);
+    }
+}
+
+bool TextureManager::updateResidency(RenderContext* pRenderContext)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mpResidency)
+        return false;
+
+    // Apply the mips that finished loading since the last update.
+    bool changed = false;
+    std::vector<StreamedMips> streamedMips = std::move(mStreamedMips);
+    mStreamedMips.clear();
+    for (const auto& streamed : streamedMips)
+        changed |= finishResidentMips(pRenderContext, streamed);
+
+    for (const auto& change : mpResidency->update())
+    {
+        auto& resident = mResidentTextures[change.id];
+        resident.targetMip = change.residentMip;
+
+        if (resident.targetMip < resident.currentMip)
+        {
+            // Mips streaming in are loaded asynchronously. A request in flight continues to the finer mips once it finishes.
+            if (!resident.pendingSerial)
+                requestResidentMips(change.id);
+            continue;
+        }
+
+        // Requests in flight are no longer needed once mips are evicted.
+        resident.pendingToken.cancel();
+        resident.pendingSerial = 0;
+        if (resident.targetMip == resident.currentMip)
+            continue;
+
+        if (resident.targetMip == resident.tailMip)
+        {
+            setResidentTexture(resident, resident.pTail);
+        }
+        else
+        {
+            ref<Texture> pCurrent = getDesc(resident.handle).pTexture;
+            setResidentTexture(resident, createResidentTexture(pRenderContext, pCurrent, resident.targetMip - resident.currentMip));
+        }
+        resident.currentMip = resident.targetMip;
+        changed = true;
+    }
+
+    return changed;
+}
+
+TextureResidency::Stats TextureManager::getResidencyStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mpResidency ? mpResidency->getStats() : TextureResidency::Stats{};
+}
+
 TextureManager::TextureDesc TextureManager::getTextureDesc(const TextureHandle& handle) const
 {
     if (handle.isUdim())
@@ -471,6 +805,13 @@ TextureManager::TextureDesc TextureManager::getTextureDesc(const TextureHandle&
     return mTextureDescs[handle.getID()];
 }
 
+TextureManager::TextureHandle TextureManager::findTexture(const Texture* pTexture) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mTextureToHandle.find(pTexture);
+    return it != mTextureToHandle.end() ? it->second : TextureHandle();
+}
+
 size_t TextureManager::getTextureDescCount() const
 {
     std::lock_guard<std::mutex> lock(mMutex);
@@ -526,9 +867,11 @@ TextureManager::Stats TextureManager::getStats() const
 {
     std::lock_guard<std::mutex> lock(mMutex);
     TextureManager::Stats s;
-    for (const auto& t : mTextureDescs)
+    for (uint32_t id = 0; id < mTextureDescs.size(); id++)
     {
-        if (!t.pTexture)
+        // Handles sharing the texture of another handle are counted as duplicates below.
+        const auto& t = mTextureDescs[id];
+        if (!t.pTexture || mSharedHandles.count(id) > 0)
             continue;
         uint64_t texelCount = t.pTexture->getTexelCount();
         uint32_t channelCount = getFormatChannelCount(t.pTexture->getFormat());
@@ -539,6 +882,27 @@ TextureManager::Stats TextureManager::getStats() const
         if (isCompressedFormat(t.pTexture->getFormat()))
             s.textureCompressedCount++;
     }
+    // Mip tails of streamed textures are kept in addition to the resident textures.
+    for (const auto& resident : mResidentTextures)
+    {
+        if (resident.pTail && mTextureDescs[resident.handle.getID()].pTexture != resident.pTail)
+            s.textureMemoryInBytes += resident.pTail->getTextureSizeInBytes();
+    }
+    // Textures with identical contents either share a handle with multiple keys or are shared by multiple handles.
+    auto addDuplicate = [&](const TextureHandle& handle)
+    {
+        s.textureDedupCount++;
+        if (const auto& pTexture = mTextureDescs[handle.getID()].pTexture)
+            s.textureDedupMemoryInBytes += pTexture->getTextureSizeInBytes();
+    };
+    std::vector<uint32_t> keyCounts(mTextureDescs.size(), 0);
+    for (const auto& [key, handle] : mKeyToHandle)
+    {
+        if (keyCounts[handle.getID()]++ > 0)
+            addDuplicate(handle);
+    }
+    for (const auto& [id, sharedHandle] : mSharedHandles)
+        addDuplicate(sharedHandle);
     return s;
 }
 
@@ -575,6 +939,209 @@ TextureManager::TextureDesc& TextureManager::getDesc(const TextureHandle& handle
     return mTextureDescs[handle.getID()];
 }
 
+uint32_t TextureManager::getTailMip(const AsyncTextureLoader::TextureInfo& info) const
+{
+    FALCOR_ASSERT(mpResidency);
+    uint32_t blockSize = std::max(getFormatWidthCompressionRatio(info.format), getFormatHeightCompressionRatio(info.format));
+    return TextureResidency::computeTailMip(info.width, info.height, info.mipCount, mpResidency->getOptions().mipTailDimension, blockSize);
+}
+
+void TextureManager::addResidentTexture(
+    const TextureHandle& handle,
+    const TextureKey& key,
+    const AsyncTextureLoader::TextureInfo& info,
+    RenderContext* pRenderContext
+)
+{
+    if (!mpResidency)
+        return;
+
+    auto& desc = getDesc(handle);
+    ref<Texture> pTexture = desc.pTexture;
+    if (!pTexture || pTexture->getType() != Resource::Type::Texture2D || pTexture->getArraySize() != 1)
+        return;
+
+    uint32_t tailMip = getTailMip(info);
+    if (tailMip == 0)
+        return;
+
+    // The loader normally creates the texture starting at the tail mip. Find the mip it starts at, and reduce it to the
+    // tail if the loader couldn't skip the finer mips.
+    auto isLoadedMip = [&](uint32_t mip)
+    { return pTexture->getWidth() == std::max(1u, info.width >> mip) && pTexture->getHeight() == std::max(1u, info.height >> mip); };
+    uint32_t loadedMip = 0;
+    while (loadedMip <= tailMip && !isLoadedMip(loadedMip))
+        loadedMip++;
+    if (loadedMip > tailMip || pTexture->getMipCount() != info.mipCount - loadedMip)
+    {
+        logWarning("Texture '{}' does not match its file description. It is not streamed.", key.fullPaths[0]);
+        return;
+    }
+
+    ResourceFormat format = pTexture->getFormat();
+    uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+    uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+    std::vector<uint64_t> mipSizes(info.mipCount);
+    for (uint32_t mip = 0; mip < info.mipCount; mip++)
+    {
+        uint64_t blockCountX = div_round_up(std::max(1u, info.width >> mip), blockWidth);
+        uint64_t blockCountY = div_round_up(std::max(1u, info.height >> mip), blockHeight);
+        mipSizes[mip] = blockCountX * blockCountY * getFormatBytesPerBlock(format);
+    }
+
+    // Only keep the mip tail resident. The mip tail texture identifies the texture for looking up the handle.
+    ResidentTexture resident;
+    resident.handle = handle;
+    resident.key = key;
+    resident.pTail = loadedMip < tailMip ? createResidentTexture(pRenderContext, pTexture, tailMip - loadedMip) : pTexture;
+    resident.width = info.width;
+    resident.height = info.height;
+    resident.mipCount = info.mipCount;
+    resident.tailMip = tailMip;
+    resident.currentMip = tailMip;
+    resident.targetMip = tailMip;
+
+    if (resident.pTail != pTexture)
+    {
+        mTextureToHandle.erase(pTexture.get());
+        mTextureToHandle[resident.pTail.get()] = handle;
+        desc.pTexture = resident.pTail;
+    }
+
+    TextureResidency::TextureID id = mpResidency->addTexture(std::move(mipSizes), tailMip);
+    if (id >= mResidentTextures.size())
+        mResidentTextures.resize(id + 1);
+    mResidentTextures[id] = std::move(resident);
+    mHandleToResidencyID[handle.getID()] = id;
+}
+
+ref<Texture> TextureManager::createResidentTexture(RenderContext* pRenderContext, const ref<Texture>& pTexture, uint32_t baseMip) const
+{
+    FALCOR_ASSERT(baseMip < pTexture->getMipCount());
+    ref<Texture> pResident = Texture::create2D(
+        mpDevice, pTexture->getWidth(baseMip), pTexture->getHeight(baseMip), pTexture->getFormat(), 1, pTexture->getMipCount() - baseMip,
+        nullptr, pTexture->getBindFlags()
+    );
+    for (uint32_t mip = 0; mip < pResident->getMipCount(); mip++)
+    {
+        pRenderContext->copySubresource(
+            pResident.get(), pResident->getSubresourceIndex(0, mip), pTexture.get(), pTexture->getSubresourceIndex(0, baseMip + mip)
+        );
+    }
+    pResident->setSourcePath(pTexture->getSourcePath());
+    return pResident;
+}
+
+void TextureManager::setResidentTexture(const ResidentTexture& resident, const ref<Texture>& pTexture)
+{
+    getDesc(resident.handle).pTexture = pTexture;
+
+    // Handles sharing the texture follow the resident mips.
+    for (const auto& [id, sharedHandle] : mSharedHandles)
+    {
+        if (sharedHandle == resident.handle)
+            mTextureDescs[id].pTexture = pTexture;
+    }
+}
+
+void TextureManager::requestResidentMips(TextureResidency::TextureID id)
+{
+    auto& resident = mResidentTextures[id];
+    FALCOR_ASSERT(resident.targetMip < resident.currentMip);
+    const auto& key = *resident.key;
+
+    resident.pendingMip = resident.targetMip;
+    resident.pendingSerial = mNextStreamSerial++;
+    resident.pendingToken = AsyncTextureLoader::CancellationToken::create();
+
+    // Function called by the async texture loader when loading finishes.
+    // It's called by the upload thread, so it only queues the loaded mips. They are applied in the next update.
+    auto callback = [this, id, serial = resident.pendingSerial](ref<Texture> pTexture, const AsyncTextureLoader::Analysis&)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStreamedMips.push_back({id, serial, pTexture});
+    };
+
+    // Only the mips missing from the current texture are loaded. Textures missing more mips are loaded first.
+    const uint32_t mipCount = resident.currentMip - resident.pendingMip;
+    mAsyncTextureLoader.loadMipRange(
+        key.fullPaths, key.generateMipLevels, key.loadAsSRGB, resident.pendingMip, mipCount, key.bindFlags, callback, (int)mipCount,
+        resident.pendingToken
+    );
+}
+
+bool TextureManager::finishResidentMips(RenderContext* pRenderContext, const StreamedMips& streamed)
+{
+    // Skip results of cancelled and superseded requests.
+    auto& resident = mResidentTextures[streamed.id];
+    if (resident.pendingSerial == 0 || resident.pendingSerial != streamed.serial)
+        return false;
+    resident.pendingSerial = 0;
+
+    const ref<Texture>& pLoaded = streamed.pTexture;
+    ref<Texture> pCurrent = getDesc(resident.handle).pTexture;
+    const uint32_t loadedMip = resident.pendingMip;
+    if (!pLoaded || pLoaded->getWidth() != std::max(1u, resident.width >> loadedMip) ||
+        pLoaded->getHeight() != std::max(1u, resident.height >> loadedMip) || pLoaded->getMipCount() < resident.currentMip - loadedMip ||
+        pLoaded->getFormat() != pCurrent->getFormat())
+    {
+        logWarning("Failed to stream in texture '{}'.", resident.key->fullPaths[0]);
+        resident.targetMip = resident.currentMip;
+        mpResidency->setResidentMip(streamed.id, resident.currentMip);
+        return false;
+    }
+
+    // Mips evicted by the policy while loading are not applied.
+    bool changed = false;
+    const uint32_t newMip = std::max(loadedMip, resident.targetMip);
+    if (newMip < resident.currentMip)
+    {
+        // Combine the loaded mips with the mips of the current texture.
+        ref<Texture> pTexture = Texture::create2D(
+            mpDevice, std::max(1u, resident.width >> newMip), std::max(1u, resident.height >> newMip), pCurrent->getFormat(), 1,
+            resident.mipCount - newMip, nullptr, pCurrent->getBindFlags()
+        );
+        for (uint32_t mip = newMip; mip < resident.mipCount; mip++)
+        {
+            const bool isLoaded = mip < resident.currentMip;
+            const Texture* pSrc = isLoaded ? pLoaded.get() : pCurrent.get();
+            uint32_t srcMip = isLoaded ? mip - loadedMip : mip - resident.currentMip;
+            pRenderContext->copySubresource(
+                pTexture.get(), pTexture->getSubresourceIndex(0, mip - newMip), pSrc, pSrc->getSubresourceIndex(0, srcMip)
+            );
+        }
+        pTexture->setSourcePath(pCurrent->getSourcePath());
+        setResidentTexture(resident, pTexture);
+        resident.currentMip = newMip;
+        changed = true;
+    }
+
+    // Continue with the mips requested while loading.
+    if (resident.targetMip < resident.currentMip)
+        requestResidentMips(streamed.id);
+    return changed;
+}
+
+TextureResidency::TextureID TextureManager::getResidencyID(const TextureHandle& handle) const
+{
+    if (!handle || handle.isUdim())
+        return TextureResidency::kInvalidID;
+    auto it = mHandleToResidencyID.find(handle.getID());
+    return it != mHandleToResidencyID.end() ? it->second : TextureResidency::kInvalidID;
+}
+
+TextureManager::TextureKey TextureManager::getLoadKey(const TextureKey& key) const
+{
+    // Textures with mips loaded from separate files are not baked.
+    TextureKey loadKey = key;
+    if (mpTextureBaker && key.fullPaths.size() == 1)
+    {
+        if (auto bakedPath = mpTextureBaker->bake(key.fullPaths[0], key.usage, key.generateMipLevels); !bakedPath.empty())
+            loadKey.fullPaths = {bakedPath};
+    }
+    return loadKey;
+}
+
 size_t TextureManager::getUdimRange(size_t requiredSize)
 {
     // But first look in the freed ranges for the smallest one that we can reuse
@@ -622,12 +1189,14 @@ void TextureManager::removeUdimTexture(const TextureHandle& handle)
 {
     size_t rangeStart = handle.getID();
     size_t rangeSize = mUdimIndirectionSize[rangeStart];
+    // Tiles with identical contents share a handle, which must only be removed once.
+    std::set<int32_t> removedIDs;
     for (size_t i = rangeStart; i < rangeStart + rangeSize; ++i)
     {
         if (mUdimIndirection[i] < 0)
             continue;
-        TextureHandle texHandle(mUdimIndirection[i]);
-        removeTexture(texHandle);
+        if (removedIDs.insert(mUdimIndirection[i]).second)
+            removeTexture(TextureHandle(mUdimIndirection[i]));
         mUdimIndirection[i] = -1;
     }
 
@@ -27,6 +27,8 @@
  **************************************************************************/
 #pragma once
 #include "AsyncTextureLoader.h"
+#include "TextureBaker.h"
+#include "TextureResidency.h"
 #include "Core/Macros.h"
 #include "Core/API/fwd.h"
 #include "Core/API/Resource.h"
@@ -37,6 +39,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
 
 namespace Falcor
@@ -52,6 +55,13 @@ class SearchDirectories;
  * Each managed texture is assigned a unique handle upon loading.
  * This handle is used in shader code to reference the given texture
  * in the array of GPU texture descriptors.
+ *
+ * Textures loaded from different files with identical contents are only loaded once.
+ * Files are first compared by a hash of the file contents, then by a hash of the decoded image data.
+ * Loading a duplicate returns the handle of the existing texture. Duplicates loaded within the same
+ * deferred loading section keep their own handle but share the texture resource.
+ *
+ * If texture baking is enabled, textures are loaded from block-compressed DDS files baked from the source files (see TextureBaker).
  */
 class FALCOR_API TextureManager
 {
@@ -66,11 +76,13 @@ public:
 
     struct Stats
     {
-        uint64_t textureCount = 0;             ///< Number of unique textures. A texture can be referenced by multiple materials.
-        uint64_t textureCompressedCount = 0;   ///< Number of unique compressed textures.
-        uint64_t textureTexelCount = 0;        ///< Total number of texels in all textures.
-        uint64_t textureTexelChannelCount = 0; ///< Total number of texel channels in all textures.
-        uint64_t textureMemoryInBytes = 0;     ///< Total memory in bytes used by the textures.
+        uint64_t textureCount = 0;              ///< Number of unique textures. A texture can be referenced by multiple materials.
+        uint64_t textureCompressedCount = 0;    ///< Number of unique compressed textures.
+        uint64_t textureTexelCount = 0;         ///< Total number of texels in all textures.
+        uint64_t textureTexelChannelCount = 0;  ///< Total number of texel channels in all textures.
+        uint64_t textureMemoryInBytes = 0;      ///< Total memory in bytes used by the textures.
+        uint64_t textureDedupCount = 0;         ///< Number of texture loads that reuse a texture with identical contents.
+        uint64_t textureDedupMemoryInBytes = 0; ///< Memory in bytes saved by reusing textures with identical contents.
     };
 
     /**
@@ -105,6 +117,7 @@ public:
     {
         TextureState state = TextureState::Invalid; ///< Current state of the texture.
         ref<Texture> pTexture;                      ///< Valid texture object when state is 'Loaded', or nullptr if loading failed.
+        AsyncTextureLoader::Analysis analysis;      ///< Analysis of the texture contents computed while loading, if available.
 
         bool isValid() const { return state != TextureState::Invalid; }
     };
@@ -139,6 +152,7 @@ public:
      * @param[in] async Load asynchronously, otherwise the function blocks until the texture data is loaded.
      * @param[in] searchDirectories Optionally can pass in search directories, will be used instead of the global data directories.
      * @param[out] loadedTextureCount Optionally can provided the number of actually loaded textures (2+ can happen with UDIMs)
+     * @param[in] usage Usage of the texture. Determines the compression format if texture baking is enabled.
      * @return Unique handle to the texture, or an invalid handle if the texture can't be found.
      */
     TextureHandle loadTexture(
@@ -148,7 +162,8 @@ public:
         Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource,
         bool async = true,
         const SearchDirectories* searchDirectories = nullptr,
-        size_t* loadedTextureCount = nullptr
+        size_t* loadedTextureCount = nullptr,
+        TextureBaker::Usage usage = TextureBaker::Usage::Color
     );
 
     /**
@@ -162,7 +177,8 @@ public:
         Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource,
         bool async = true,
         const SearchDirectories* searchDirectories = nullptr,
-        size_t* loadedTextureCount = nullptr
+        size_t* loadedTextureCount = nullptr,
+        TextureBaker::Usage usage = TextureBaker::Usage::Color
     );
 
     /**
@@ -193,6 +209,84 @@ public:
      */
     void removeTexture(const TextureHandle& handle);
 
+    /**
+     * Enable streaming of texture mips under a memory budget.
+     * Textures loaded from file afterwards only load their mip tail. Finer mips are streamed in when requested with
+     * requestMipLevel() and evicted in least-recently-used order when over budget (see TextureResidency).
+     * While streamed, getTexture() returns a texture whose mip 0 is the finest resident mip. The texture returned right
+     * after loading holds the mip tail. It is kept for the lifetime of the managed texture and can be used with addTexture()
+     * and findTexture() to look up the handle.
+     * @param[in] options Residency options.
+     */
+    void enableResidency(const TextureResidency::Options& options);
+
+    /**
+     * Check if streaming of texture mips is enabled.
+     * @return True if enabled.
+     */
+    bool isResidencyEnabled() const { return mpResidency != nullptr; }
+
+    /**
+     * Set the memory budget for streamed textures.
+     * @param[in] budgetInBytes Memory budget. Takes effect on the next call to updateResidency().
+     */
+    void setResidencyBudget(uint64_t budgetInBytes);
+
+    /**
+     * Request a mip level of a texture for the current frame.
+     * Requests for textures that are not streamed are ignored.
+     * @param[in] handle Texture handle.
+     * @param[in] mip Finest mip level needed, relative to the full resolution texture.
+     */
+    void requestMipLevel(const TextureHandle& handle, uint32_t mip);
+
+    /**
+     * Request the mip level of a texture needed for an object at a given distance from the camera.
+     * See TextureResidency::computeMipFromDistance().
+     * @param[in] handle Texture handle.
+     * @param[in] objectSize World space size of the object.
+     * @param[in] distance Distance from the camera to the object.
+     * @param[in] pixelAngle Angle subtended by a pixel in radians.
+     */
+    void requestMipLevelFromDistance(const TextureHandle& handle, float objectSize, float distance, float pixelAngle);
+
+    /**
+     * Stream texture mips in and out based on the requests since the last update.
+     * Mips streaming in are loaded asynchronously from the source files of the textures and are applied in a later update
+     * once loaded. Evicted mips are released immediately.
+     * @param[in] pRenderContext Render context used for copying mips.
+     * @return True if any texture changed, in which case setShaderData() needs to be called again.
+     */
+    bool updateResidency(RenderContext* pRenderContext);
+
+    /**
+     * Get stats for streamed textures.
+     * @return Residency stats, or empty stats if residency is not enabled.
+     */
+    TextureResidency::Stats getResidencyStats() const;
+
+    /**
+     * Enable baking of textures loaded from file.
+     * Single file textures loaded afterwards are converted to block-compressed DDS files with a full mip chain, which are
+     * stored in a persistent cache directory. Later loads of the same texture only load the DDS file. DDS files and textures
+     * with mips loaded from separate files are loaded as is. If baking a texture fails, it is loaded from its source file.
+     * Baked textures keep the path of their source file as source path, so they can be tracked for changes.
+     * @param[in] options Baking options.
+     */
+    void enableTextureBaking(const TextureBaker::Options& options);
+
+    /**
+     * Check if texture baking is enabled.
+     * @return True if enabled.
+     */
+    bool isTextureBakingEnabled() const { return mpTextureBaker != nullptr; }
+
+    /**
+     * Get stats for texture baking.
+     * @return Baking stats, or empty stats if baking is not enabled.
+     */
+    TextureBaker::Stats getTextureBakingStats() const;
+
     /**
      * Get a loaded texture. Call getTextureDesc() for more info.
      * @param[in] handle Texture handle.
@@ -207,6 +301,13 @@ public:
      */
     TextureDesc getTextureDesc(const TextureHandle& handle) const;
 
+    /**
+     * Find the handle of a managed texture.
+     * @param[in] pTexture The texture resource.
+     * @return Handle to the texture, or an invalid handle if the texture is not managed.
+     */
+    TextureHandle findTexture(const Texture* pTexture) const;
+
     /**
      * Get texture desc count.
      * @return Number of texture descs.
@@ -253,9 +354,16 @@ private:
         bool generateMipLevels;
         bool loadAsSRGB;
         Resource::BindFlags bindFlags;
-
-        TextureKey(const std::vector<std::filesystem::path>& paths, bool mips, bool srgb, Resource::BindFlags flags)
-            : fullPaths(paths), generateMipLevels(mips), loadAsSRGB(srgb), bindFlags(flags)
+        TextureBaker::Usage usage; ///< Textures with different usage are baked to different formats.
+
+        TextureKey(
+            const std::vector<std::filesystem::path>& paths,
+            bool mips,
+            bool srgb,
+            Resource::BindFlags flags,
+            TextureBaker::Usage textureUsage = TextureBaker::Usage::Color
+        )
+            : fullPaths(paths), generateMipLevels(mips), loadAsSRGB(srgb), bindFlags(flags), usage(textureUsage)
         {}
 
         bool operator<(const TextureKey& rhs) const
@@ -266,6 +374,60 @@ private:
                 return generateMipLevels < rhs.generateMipLevels;
             else if (loadAsSRGB != rhs.loadAsSRGB)
                 return loadAsSRGB < rhs.loadAsSRGB;
+            else if (bindFlags != rhs.bindFlags)
+                return bindFlags < rhs.bindFlags;
+            else
+                return usage < rhs.usage;
+        }
+    };
+
+    /// Managed texture whose mips are streamed.
+    struct ResidentTexture
+    {
+        TextureHandle handle;
+        std::optional<TextureKey> key; ///< Key for loading the texture from file.
+        ref<Texture> pTail;            ///< Texture holding only the mip tail. Always resident and used to identify the texture.
+        uint32_t width = 0;            ///< Width of the full resolution texture.
+        uint32_t height = 0;           ///< Height of the full resolution texture.
+        uint32_t mipCount = 0;         ///< Mip count of the full resolution texture.
+        uint32_t tailMip = 0;          ///< First mip of the mip tail.
+        uint32_t currentMip = 0;       ///< Finest mip of the current texture.
+        uint32_t targetMip = 0;        ///< Finest mip selected by the residency policy.
+        uint32_t pendingMip = 0;       ///< Finest mip of the load request in flight.
+        uint64_t pendingSerial = 0;    ///< Serial number of the load request in flight, or 0 if none.
+        AsyncTextureLoader::CancellationToken pendingToken; ///< Token for cancelling the load request in flight.
+    };
+
+    /// Mips of a streamed texture loaded by the async texture loader.
+    struct StreamedMips
+    {
+        TextureResidency::TextureID id;
+        uint64_t serial;
+        ref<Texture> pTexture;
+    };
+
+    /**
+     * Key to identify textures with identical contents loaded with identical flags.
+     */
+    struct ContentKey
+    {
+        uint64_t hash;
+        bool generateMipLevels;
+        bool loadAsSRGB;
+        Resource::BindFlags bindFlags;
+
+        ContentKey(uint64_t contentHash, const TextureKey& key)
+            : hash(contentHash), generateMipLevels(key.generateMipLevels), loadAsSRGB(key.loadAsSRGB), bindFlags(key.bindFlags)
+        {}
+
+        bool operator<(const ContentKey& rhs) const
+        {
+            if (hash != rhs.hash)
+                return hash < rhs.hash;
+            else if (generateMipLevels != rhs.generateMipLevels)
+                return generateMipLevels < rhs.generateMipLevels;
+            else if (loadAsSRGB != rhs.loadAsSRGB)
+                return loadAsSRGB < rhs.loadAsSRGB;
             else
                 return bindFlags < rhs.bindFlags;
         }
@@ -273,6 +435,19 @@ private:
 
     TextureHandle addDesc(const TextureDesc& desc);
     TextureDesc& getDesc(const TextureHandle& handle);
+    uint32_t getTailMip(const AsyncTextureLoader::TextureInfo& info) const;
+    void addResidentTexture(
+        const TextureHandle& handle,
+        const TextureKey& key,
+        const AsyncTextureLoader::TextureInfo& info,
+        RenderContext* pRenderContext
+    );
+    ref<Texture> createResidentTexture(RenderContext* pRenderContext, const ref<Texture>& pTexture, uint32_t baseMip) const;
+    void setResidentTexture(const ResidentTexture& resident, const ref<Texture>& pTexture);
+    void requestResidentMips(TextureResidency::TextureID id);
+    bool finishResidentMips(RenderContext* pRenderContext, const StreamedMips& streamed);
+    TextureResidency::TextureID getResidencyID(const TextureHandle& handle) const;
+    TextureKey getLoadKey(const TextureKey& key) const;
 
     ref<Device> mpDevice;
 
@@ -284,6 +459,9 @@ private:
     std::vector<TextureHandle> mFreeList;                     ///< List of unused handles.
     std::map<TextureKey, TextureHandle> mKeyToHandle;         ///< Map from texture key to handle.
     std::map<const Texture*, TextureHandle> mTextureToHandle; ///< Map from texture ptr to handle.
+    std::map<ContentKey, TextureHandle> mFileHashToHandle;    ///< Map from hash of the texture files to handle.
+    std::map<ContentKey, TextureHandle> mContentHashToHandle; ///< Map from hash of the decoded texture data to handle.
+    std::map<uint32_t, TextureHandle> mSharedHandles;         ///< Map from handle ID to the handle whose texture it shares.
     /// Map from UDIM-1001 to an actual textureID, -1 if the texture does not exist (e.g., there is 1001 and 1003, so 1002 [1] == -1)
     std::vector<int32_t> mUdimIndirection;
     /// For each udim indirection range, writes (at the first element), how long that range is (there is 0 everywhere else)
@@ -296,6 +474,14 @@ private:
 
     bool mUseDeferredLoading = false;
 
+    std::unique_ptr<TextureResidency> mpResidency;                      ///< Residency policy for streamed textures, or nullptr if disabled.
+    std::vector<ResidentTexture> mResidentTextures;                     ///< Streamed textures, indexed by residency ID.
+    std::map<uint32_t, TextureResidency::TextureID> mHandleToResidencyID; ///< Map from texture handle ID to residency ID.
+    std::vector<StreamedMips> mStreamedMips; ///< Mips loaded since the last residency update. Written by the texture loader.
+    uint64_t mNextStreamSerial = 1;          ///< Serial number of the next mip load request.
+
+    std::unique_ptr<TextureBaker> mpTextureBaker; ///< Baker for converting textures to DDS files, or nullptr if disabled.
+
     AsyncTextureLoader mAsyncTextureLoader; ///< Utility for asynchronous texture loading.
     size_t mLoadRequestsInProgress = 0;     ///< Number of load requests currently in progress.
 
@@ -0,0 +1,312 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "TextureResidency.h"
+#include "Core/Assert.h"
+#include "Core/Errors.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace Falcor
+{
+TextureResidency::TextureResidency() : TextureResidency(Options()) {}
+
+TextureResidency::TextureResidency(const Options& options) : mOptions(options) {}
+
+uint32_t TextureResidency::computeTailMip(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t mipTailDimension, uint32_t blockSize)
+{
+    FALCOR_CHECK_ARG_GT(blockSize, 0);
+
+    // Move the tail to coarser mips as long as the mips are larger than the tail dimension.
+    // All mips finer than the tail can become the base of a resident texture, so they need to be aligned to the format block size.
+    uint32_t tailMip = 0;
+    while (tailMip + 1 < mipCount && std::max(width >> tailMip, height >> tailMip) > mipTailDimension)
+    {
+        uint32_t w = std::max(1u, width >> (tailMip + 1));
+        uint32_t h = std::max(1u, height >> (tailMip + 1));
+        if (w % blockSize != 0 || h % blockSize != 0)
+            break;
+        tailMip++;
+    }
+    return tailMip;
+}
+
+uint32_t TextureResidency::computeMipFromDistance(uint32_t width, uint32_t height, float objectSize, float distance, float pixelAngle)
+{
+    if (!(objectSize > 0.f))
+        return 0;
+
+    // Number of texels covered by a pixel at the given distance.
+    float texelsPerPixel = std::max(width, height) * distance * pixelAngle / objectSize;
+    if (!(texelsPerPixel > 1.f))
+        return 0;
+    return (uint32_t)std::min(std::floor(std::log2(texelsPerPixel)), 31.f);
+}
+
+TextureResidency::TextureID TextureResidency::addTexture(std::vector<uint64_t> mipSizes, uint32_t tailMip)
+{
+    FALCOR_CHECK_ARG(!mipSizes.empty());
+    FALCOR_CHECK_ARG_LT(tailMip, mipSizes.size());
+
+    TextureID id;
+    if (!mFreeList.empty())
+    {
+        id = mFreeList.back();
+        mFreeList.pop_back();
+    }
+    else
+    {
+        if (mEntries.size() >= kInvalidID)
+            throw RuntimeError("Out of texture IDs");
+        id = (TextureID)mEntries.size();
+        mEntries.emplace_back();
+    }
+
+    // Store accumulated sizes so that the size of any resident range can be looked up directly.
+    for (size_t i = mipSizes.size() - 1; i > 0; i--)
+        mipSizes[i - 1] += mipSizes[i];
+
+    Entry& entry = mEntries[id];
+    entry = {};
+    entry.residentSizes = std::move(mipSizes);
+    entry.tailMip = tailMip;
+    entry.residentMip = tailMip;
+    entry.previousMip = tailMip;
+    entry.valid = true;
+
+    mStats.textureCount++;
+    mStats.residentBytes += entry.getResidentBytes();
+    mStats.tailBytes += entry.getResidentBytes();
+    mEvictionOrderValid = false;
+
+    return id;
+}
+
+void TextureResidency::removeTexture(TextureID id)
+{
+    Entry& entry = getEntry(id);
+    mStats.textureCount--;
+    mStats.residentBytes -= entry.getResidentBytes();
+    mStats.tailBytes -= entry.residentSizes[entry.tailMip];
+    entry = {};
+    mFreeList.push_back(id);
+    mEvictionOrderValid = false;
+}
+
+void TextureResidency::requestMip(TextureID id, uint32_t mip)
+{
+    Entry& entry = getEntry(id);
+    if (entry.requestedMip == kNoRequest)
+        mRequested.push_back(id);
+    entry.requestedMip = std::min({entry.requestedMip, mip, entry.tailMip});
+}
+
+std::vector<TextureResidency::Change> TextureResidency::update()
+{
+    mFrame++;
+    mStats.updateCount++;
+    mEvictionOrderValid = false;
+    mChanged.clear();
+
+    // Collect textures that are missing requested mips.
+    // Textures missing the most mips are streamed in first. Ties are broken by ID to make the result deterministic.
+    using Candidate = std::pair<uint32_t, TextureID>; // Missing mip count, texture ID
+    auto cmp = [](const Candidate& a, const Candidate& b) { return a.first != b.first ? a.first < b.first : a.second > b.second; };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(cmp)> candidates(cmp);
+
+    mStats.requestedBytes = 0;
+    for (TextureID id : mRequested)
+    {
+        Entry& entry = mEntries[id];
+        // Skip textures that have been removed and textures listed twice because their ID was reused.
+        if (!entry.valid || entry.requestedMip == kNoRequest || entry.lastUsedFrame == mFrame)
+            continue;
+        entry.lastUsedFrame = mFrame;
+        mStats.requestedBytes += entry.residentSizes[entry.requestedMip];
+        if (entry.requestedMip < entry.residentMip)
+            candidates.push({entry.residentMip - entry.requestedMip, id});
+    }
+
+    // Stream in one mip at a time, evicting other mips if over budget.
+    uint64_t streamedInBytes = 0;
+    while (!candidates.empty())
+    {
+        auto [missingCount, id] = candidates.top();
+        Entry& entry = mEntries[id];
+        uint32_t mip = entry.residentMip - 1;
+        uint64_t size = entry.residentSizes[mip] - entry.residentSizes[entry.residentMip];
+
+        if (streamedInBytes > 0 && streamedInBytes + size > mOptions.maxStreamInBytesPerUpdate)
+            break;
+        if (size > mOptions.budgetInBytes)
+            break;
+        if (mStats.residentBytes + size > mOptions.budgetInBytes && !evict(mOptions.budgetInBytes - size))
+            break;
+
+        candidates.pop();
+        changeResidentMip(id, mip);
+        streamedInBytes += size;
+        if (mip > entry.requestedMip)
+            candidates.push({missingCount - 1, id});
+    }
+
+    // Enforce the budget in case it was lowered. Evict requested mips if needed.
+    if (mStats.residentBytes > mOptions.budgetInBytes && !evict(mOptions.budgetInBytes))
+        evict(mOptions.budgetInBytes, true);
+
+    for (TextureID id : mRequested)
+        mEntries[id].requestedMip = kNoRequest;
+    mRequested.clear();
+
+    std::vector<Change> changes;
+    for (TextureID id : mChanged)
+    {
+        const Entry& entry = mEntries[id];
+        if (entry.residentMip != entry.previousMip)
+            changes.push_back({id, entry.previousMip, entry.residentMip});
+    }
+    return changes;
+}
+
+void TextureResidency::setResidentMip(TextureID id, uint32_t mip)
+{
+    Entry& entry = getEntry(id);
+    mip = std::min(mip, entry.tailMip);
+    mStats.residentBytes -= entry.getResidentBytes();
+    entry.residentMip = mip;
+    mStats.residentBytes += entry.getResidentBytes();
+    mEvictionOrderValid = false;
+}
+
+uint32_t TextureResidency::getResidentMip(TextureID id) const
+{
+    return getEntry(id).residentMip;
+}
+
+TextureResidency::Entry& TextureResidency::getEntry(TextureID id)
+{
+    FALCOR_CHECK_ARG(id < mEntries.size() && mEntries[id].valid);
+    return mEntries[id];
+}
+
+const TextureResidency::Entry& TextureResidency::getEntry(TextureID id) const
+{
+    FALCOR_CHECK_ARG(id < mEntries.size() && mEntries[id].valid);
+    return mEntries[id];
+}
+
+void TextureResidency::changeResidentMip(TextureID id, uint32_t mip)
+{
+    Entry& entry = mEntries[id];
+    if (entry.changedFrame != mFrame)
+    {
+        entry.changedFrame = mFrame;
+        entry.previousMip = entry.residentMip;
+        mChanged.push_back(id);
+    }
+
+    uint64_t prevBytes = entry.getResidentBytes();
+    if (mip < entry.residentMip)
+    {
+        mStats.streamInCount += entry.residentMip - mip;
+        mStats.streamedInBytes += entry.residentSizes[mip] - prevBytes;
+    }
+    else
+    {
+        mStats.evictionCount += mip - entry.residentMip;
+        mStats.evictedBytes += prevBytes - entry.residentSizes[mip];
+    }
+
+    entry.residentMip = mip;
+    mStats.residentBytes = mStats.residentBytes - prevBytes + entry.getResidentBytes();
+}
+
+bool TextureResidency::evict(uint64_t targetBytes, bool evictRequested)
+{
+    // Mips finer than this are evictable. Unless forced, mips requested in the current frame are kept.
+    auto getProtectedMip = [evictRequested](const Entry& entry)
+    { return evictRequested || entry.requestedMip == kNoRequest ? entry.tailMip : entry.requestedMip; };
+
+    if (!mEvictionOrderValid || mEvictionOrderEvictsRequested != evictRequested)
+    {
+        // Collect textures with evictable mips. Only textures with mips above their tail need to be considered.
+        mEvictionOrder.clear();
+        mEvictableBytes = 0;
+        for (TextureID id = 0; id < (TextureID)mEntries.size(); id++)
+        {
+            const Entry& entry = mEntries[id];
+            uint32_t protectedMip = getProtectedMip(entry);
+            if (entry.valid && entry.residentMip < protectedMip)
+            {
+                mEvictionOrder.push_back(id);
+                mEvictableBytes += entry.getResidentBytes() - entry.residentSizes[protectedMip];
+            }
+        }
+
+        // Sort in reverse order of eviction, i.e. the least recently used texture last.
+        // Ties are broken by evicting larger textures first.
+        std::sort(
+            mEvictionOrder.begin(),
+            mEvictionOrder.end(),
+            [this](TextureID a, TextureID b)
+            {
+                const Entry& ea = mEntries[a];
+                const Entry& eb = mEntries[b];
+                if (ea.lastUsedFrame != eb.lastUsedFrame)
+                    return ea.lastUsedFrame > eb.lastUsedFrame;
+                if (ea.getResidentBytes() != eb.getResidentBytes())
+                    return ea.getResidentBytes() < eb.getResidentBytes();
+                return a > b;
+            }
+        );
+        mEvictionOrderValid = true;
+        mEvictionOrderEvictsRequested = evictRequested;
+    }
+
+    // Don't evict anything if the target can't be reached.
+    if (mStats.residentBytes - mEvictableBytes > targetBytes)
+        return false;
+
+    // Evict the finest mips of the least recently used texture until it's down to its protected mip.
+    while (mStats.residentBytes > targetBytes)
+    {
+        FALCOR_ASSERT(!mEvictionOrder.empty());
+        TextureID id = mEvictionOrder.back();
+        const Entry& entry = mEntries[id];
+        if (entry.residentMip >= getProtectedMip(entry))
+        {
+            mEvictionOrder.pop_back();
+            continue;
+        }
+        uint64_t prevBytes = entry.getResidentBytes();
+        changeResidentMip(id, entry.residentMip + 1);
+        mEvictableBytes -= prevBytes - entry.getResidentBytes();
+    }
+    return true;
+}
+} // namespace Falcor
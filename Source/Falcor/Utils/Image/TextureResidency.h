@@ -0,0 +1,203 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Residency policy for streamed textures.
+ *
+ * This class decides which mip levels of a set of textures should be resident in GPU memory under a memory budget.
+ * It only tracks sizes and mip levels. Loading and releasing texture data is done by the owner (see TextureManager).
+ *
+ * The resident mip levels of a texture are always a contiguous range from a base mip level down to the coarsest mip.
+ * The mip tail, i.e. the mip levels from the tail mip and coarser, is always resident. Finer mips are streamed in when
+ * requested and evicted in least-recently-used order when the budget is exceeded.
+ *
+ * Usage per frame:
+ * - Call requestMip() for all textures that are used, with the finest mip level needed.
+ * - Call update() to get the list of textures whose resident mip level changed, and apply the changes.
+ *
+ * The class is not thread-safe.
+ */
+class FALCOR_API TextureResidency
+{
+public:
+    using TextureID = uint32_t;
+    static constexpr TextureID kInvalidID = std::numeric_limits<TextureID>::max();
+    static constexpr uint32_t kNoRequest = std::numeric_limits<uint32_t>::max();
+
+    struct Options
+    {
+        uint64_t budgetInBytes = 4ull << 30;               ///< Memory budget for all textures.
+        uint64_t maxStreamInBytesPerUpdate = 256ull << 20; ///< Maximum number of bytes streamed in per update, but at least one mip.
+        uint32_t mipTailDimension = 128;                   ///< Mips with width and height less or equal to this are part of the mip tail.
+    };
+
+    struct Stats
+    {
+        uint64_t textureCount = 0;    ///< Number of tracked textures.
+        uint64_t residentBytes = 0;   ///< Bytes of all resident mips.
+        uint64_t tailBytes = 0;       ///< Bytes of all mip tails.
+        uint64_t requestedBytes = 0;  ///< Bytes of the mips requested in the last update, including their mip tails.
+        uint64_t streamedInBytes = 0; ///< Total bytes streamed in.
+        uint64_t evictedBytes = 0;    ///< Total bytes evicted.
+        uint64_t streamInCount = 0;   ///< Total number of mips streamed in.
+        uint64_t evictionCount = 0;   ///< Total number of mips evicted.
+        uint64_t updateCount = 0;     ///< Number of updates.
+    };
+
+    /// Change of the resident mip level of a texture.
+    struct Change
+    {
+        TextureID id;
+        uint32_t previousMip; ///< Finest resident mip before the update.
+        uint32_t residentMip; ///< Finest resident mip after the update.
+
+        bool isStreamIn() const { return residentMip < previousMip; }
+    };
+
+    TextureResidency();
+    explicit TextureResidency(const Options& options);
+
+    /**
+     * Compute the first mip level of the mip tail.
+     * @param[in] width Width of mip 0 in texels.
+     * @param[in] height Height of mip 0 in texels.
+     * @param[in] mipCount Number of mip levels.
+     * @param[in] mipTailDimension Mips with width and height less or equal to this are part of the mip tail.
+     * @param[in] blockSize Block size of the format. The base mip of a resident range must have dimensions that are multiples of it.
+     * @return The tail mip level.
+     */
+    static uint32_t computeTailMip(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t mipTailDimension, uint32_t blockSize = 1);
+
+    /**
+     * Compute the mip level needed for an object using a texture, based on its distance to the camera.
+     * The texture is assumed to be mapped once over the extent of the object.
+     * @param[in] width Width of mip 0 in texels.
+     * @param[in] height Height of mip 0 in texels.
+     * @param[in] objectSize World space size of the object.
+     * @param[in] distance Distance from the camera to the object.
+     * @param[in] pixelAngle Angle subtended by a pixel in radians.
+     * @return The finest mip level needed.
+     */
+    static uint32_t computeMipFromDistance(uint32_t width, uint32_t height, float objectSize, float distance, float pixelAngle);
+
+    /**
+     * Add a texture. Initially only the mip tail is resident.
+     * @param[in] mipSizes Size in bytes of each mip level, from finest to coarsest.
+     * @param[in] tailMip First mip level of the mip tail.
+     * @return ID of the texture.
+     */
+    TextureID addTexture(std::vector<uint64_t> mipSizes, uint32_t tailMip);
+
+    /**
+     * Remove a texture.
+     * @param[in] id Texture ID.
+     */
+    void removeTexture(TextureID id);
+
+    /**
+     * Request a mip level of a texture for the current frame.
+     * Multiple requests in a frame are combined by using the finest requested mip.
+     * @param[in] id Texture ID.
+     * @param[in] mip Finest mip level needed. Clamped to the available mips.
+     */
+    void requestMip(TextureID id, uint32_t mip);
+
+    /**
+     * Update residency based on the requests since the last update.
+     * The returned changes are assumed to be applied by the caller. If applying a change fails, call setResidentMip() to correct the state.
+     * Textures are streamed in one mip at a time, in order of how many mips they are missing. To make room, mips of textures that
+     * were not requested are evicted in least-recently-used order, followed by mips finer than requested. If the budget is still
+     * exceeded (e.g. after lowering it), requested mips are evicted as well.
+     * @return List of textures whose resident mip changed.
+     */
+    std::vector<Change> update();
+
+    /**
+     * Set the resident mip level of a texture.
+     * @param[in] id Texture ID.
+     * @param[in] mip Finest resident mip level. Clamped to the tail mip.
+     */
+    void setResidentMip(TextureID id, uint32_t mip);
+
+    /**
+     * Get the resident mip level of a texture.
+     * @param[in] id Texture ID.
+     * @return Finest resident mip level.
+     */
+    uint32_t getResidentMip(TextureID id) const;
+
+    /**
+     * Set the memory budget.
+     * @param[in] budgetInBytes Memory budget. Takes effect on the next update.
+     */
+    void setBudget(uint64_t budgetInBytes) { mOptions.budgetInBytes = budgetInBytes; }
+
+    const Options& getOptions() const { return mOptions; }
+    const Stats& getStats() const { return mStats; }
+
+private:
+    struct Entry
+    {
+        std::vector<uint64_t> residentSizes; ///< Size in bytes of all mips from each mip level to the coarsest one.
+        uint32_t tailMip = 0;                ///< First mip of the mip tail.
+        uint32_t residentMip = 0;            ///< Finest resident mip.
+        uint32_t previousMip = 0;            ///< Finest resident mip at the start of the last update that changed it.
+        uint32_t requestedMip = kNoRequest;  ///< Finest requested mip in the current frame.
+        uint64_t lastUsedFrame = 0;          ///< Last update in which the texture was requested.
+        uint64_t changedFrame = 0;           ///< Last update in which the resident mip changed.
+        bool valid = false;
+
+        uint64_t getResidentBytes() const { return residentSizes[residentMip]; }
+    };
+
+    Entry& getEntry(TextureID id);
+    const Entry& getEntry(TextureID id) const;
+    void changeResidentMip(TextureID id, uint32_t mip);
+    bool evict(uint64_t targetBytes, bool evictRequested = false);
+
+    Options mOptions;
+    Stats mStats;
+    uint64_t mFrame = 0;
+
+    std::vector<Entry> mEntries;
+    std::vector<TextureID> mFreeList;
+    std::vector<TextureID> mRequested;     ///< Textures requested in the current frame.
+    std::vector<TextureID> mChanged;       ///< Textures whose resident mip changed in the current update.
+    std::vector<TextureID> mEvictionOrder; ///< Eviction candidates of the current update, in reverse order.
+    uint64_t mEvictableBytes = 0;          ///< Bytes that can be evicted from the eviction candidates.
+    bool mEvictionOrderValid = false;
+    bool mEvictionOrderEvictsRequested = false;
+};
+} // namespace Falcor
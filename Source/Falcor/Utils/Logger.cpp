@@ -29,6 +29,7 @@
 #include "Core/Assert.h"
 #include "Core/Platform/OS.h"
 #include <iostream>
+#include <mutex>
 
 namespace Falcor
 {
@@ -37,6 +38,7 @@ namespace
 Logger::Level sVerbosity = Logger::Level::Info;
 Logger::OutputFlags sOutputs = Logger::OutputFlags::Console | Logger::OutputFlags::File | Logger::OutputFlags::DebugWindow;
 std::filesystem::path sLogFilePath;
+std::mutex sMutex; ///< Serializes output from multiple threads.
 
 #if FALCOR_ENABLE_LOGGER
 bool sInitialized = false;
@@ -125,6 +127,7 @@ void Logger::log(Level level, const std::string_view msg)
     if (level <= sVerbosity)
     {
         std::string s = fmt::format("{} {}\n", getLogLevelString(level), msg);
+        std::lock_guard<std::mutex> lock(sMutex);
 
         // Write to console.
         if (is_set(sOutputs, OutputFlags::Console))
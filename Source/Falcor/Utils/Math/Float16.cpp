@@ -33,6 +33,22 @@
  */
 
 #include "Float16.h"
+#include "Core/Errors.h"
+#include "Core/Platform/OS.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_FLOAT16_SIMD 1
+#include <immintrin.h>
+#else
+#define FALCOR_FLOAT16_SIMD 0
+#endif
+
+// Functions using instruction set extensions beyond the compiler's target need to be annotated on GCC/Clang.
+#if FALCOR_MSVC
+#define FALCOR_FLOAT16_TARGET(isa)
+#else
+#define FALCOR_FLOAT16_TARGET(isa) __attribute__((target(isa)))
+#endif
 
 namespace Falcor
 {
@@ -261,5 +277,227 @@ float float16ToFloat32(uint16_t value)
     return result.f;
 }
 
+//
+// Bulk conversion.
+//
+// The SIMD kernels reproduce the scalar functions above bit by bit, including the "round half up" rounding and
+// NaN payloads. Hardware conversion (F16C) is therefore only used for float16 to float32, with NaNs patched up
+// afterwards. Its float32 to float16 conversion rounds to nearest even and would change results at ties.
+//
+
+namespace
+{
+using ConvertFloat16ToFloat32Func = void (*)(const uint16_t*, float*, size_t);
+using ConvertFloat32ToFloat16Func = void (*)(const float*, uint16_t*, size_t);
+
+void convertFloat16ToFloat32Scalar(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = float16ToFloat32(pSrc[i]);
+}
+
+void convertFloat32ToFloat16Scalar(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = float32ToFloat16(pSrc[i]);
+}
+
+#if FALCOR_FLOAT16_SIMD
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/// Converts four halfs stored in the low 16 bits of each lane.
+inline __m128 float16ToFloat32SSE2(__m128i h)
+{
+    const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+    const __m128i exponent = _mm_and_si128(h, _mm_set1_epi32(0x7c00));
+
+    // Move exponent and mantissa in place and rebias the exponent.
+    __m128i o = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13), _mm_set1_epi32(112 << 23));
+    // Infinity/NaN: extend the exponent to 255.
+    o = _mm_add_epi32(o, _mm_and_si128(_mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7c00)), _mm_set1_epi32(112 << 23)));
+    // Zero/denormal: add the implicit one and subtract it again in floating point to renormalize (exact).
+    const __m128 renormalized =
+        _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+    o = select(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()), _mm_castps_si128(renormalized), o);
+
+    return _mm_castsi128_ps(_mm_or_si128(o, sign));
+}
+
+/// Converts four floats to halfs returned in the low 16 bits of each lane.
+inline __m128i float32ToFloat16SSE2(__m128 v)
+{
+    const __m128i i = _mm_castps_si128(v);
+    const __m128i sign = _mm_and_si128(_mm_srli_epi32(i, 16), _mm_set1_epi32(0x8000));
+    const __m128i a = _mm_and_si128(i, _mm_set1_epi32(0x7fffffff));
+
+    // Normalized: rebias the exponent and round half up. A carry out of the mantissa increments the exponent.
+    __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_sub_epi32(a, _mm_set1_epi32(112 << 23)), _mm_set1_epi32(0x1000)), 13);
+    normal = select(_mm_cmpgt_epi32(normal, _mm_set1_epi32(0x7bff)), _mm_set1_epi32(0x7c00), normal);
+
+    // Denormalized or zero: scale to multiples of the smallest half denormal (exact) and round half up.
+    const __m128 y = _mm_mul_ps(_mm_castsi128_ps(a), _mm_set1_ps(16777216.f));
+    const __m128i t = _mm_cvttps_epi32(y);
+    const __m128 frac = _mm_sub_ps(y, _mm_cvtepi32_ps(t));
+    const __m128i denormal = _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpge_ps(frac, _mm_set1_ps(0.5f))));
+
+    // Infinity/NaN: keep the upper mantissa bits and make sure NaNs don't turn into infinities.
+    const __m128i m = _mm_srli_epi32(_mm_and_si128(i, _mm_set1_epi32(0x007fffff)), 13);
+    const __m128i nanFix = _mm_andnot_si128(
+        _mm_cmpeq_epi32(a, _mm_set1_epi32(0x7f800000)), _mm_and_si128(_mm_cmpeq_epi32(m, _mm_setzero_si128()), _mm_set1_epi32(1))
+    );
+    const __m128i special = _mm_or_si128(_mm_or_si128(m, nanFix), _mm_set1_epi32(0x7c00));
+
+    __m128i r = select(_mm_cmplt_epi32(a, _mm_set1_epi32(113 << 23)), denormal, normal);
+    r = select(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x7f7fffff)), special, r);
+    return _mm_or_si128(r, sign);
+}
+
+/// Packs eight 32-bit lanes holding 16-bit values (SSE2 only has a signed saturating pack).
+inline __m128i packUint16SSE2(__m128i lo, __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+void convertFloat16ToFloat32SSE2(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        _mm_storeu_ps(pDst + i, float16ToFloat32SSE2(_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+        _mm_storeu_ps(pDst + i + 4, float16ToFloat32SSE2(_mm_unpackhi_epi16(h, _mm_setzero_si128())));
+    }
+    convertFloat16ToFloat32Scalar(pSrc + i, pDst + i, count - i);
+}
+
+void convertFloat32ToFloat16SSE2(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i lo = float32ToFloat16SSE2(_mm_loadu_ps(pSrc + i));
+        const __m128i hi = float32ToFloat16SSE2(_mm_loadu_ps(pSrc + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), packUint16SSE2(lo, hi));
+    }
+    convertFloat32ToFloat16Scalar(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_FLOAT16_TARGET("avx2,f16c")
+void convertFloat16ToFloat32AVX2(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        __m256 f = _mm256_cvtph_ps(h);
+
+        // The hardware conversion quiets signaling NaNs, restore the original payload.
+        const __m256i h32 = _mm256_cvtepu16_epi32(h);
+        const __m256i isNan = _mm256_cmpgt_epi32(_mm256_and_si256(h32, _mm256_set1_epi32(0x7fff)), _mm256_set1_epi32(0x7c00));
+        if (!_mm256_testz_si256(isNan, isNan))
+        {
+            const __m256i nan = _mm256_or_si256(
+                _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(h32, _mm256_set1_epi32(0x8000)), 16), _mm256_set1_epi32(0x7f800000)),
+                _mm256_slli_epi32(_mm256_and_si256(h32, _mm256_set1_epi32(0x03ff)), 13)
+            );
+            f = _mm256_blendv_ps(f, _mm256_castsi256_ps(nan), _mm256_castsi256_ps(isNan));
+        }
+        _mm256_storeu_ps(pDst + i, f);
+    }
+    convertFloat16ToFloat32Scalar(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_FLOAT16_TARGET("avx2")
+void convertFloat32ToFloat16AVX2(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    const __m256i kSignMask = _mm256_set1_epi32(0x8000);
+    const __m256i kAbsMask = _mm256_set1_epi32(0x7fffffff);
+    const __m256i kMantissaMask = _mm256_set1_epi32(0x007fffff);
+    const __m256i kRebias = _mm256_set1_epi32(112 << 23);
+    const __m256i kRound = _mm256_set1_epi32(0x1000);
+    const __m256i kInfHalf = _mm256_set1_epi32(0x7c00);
+    const __m256i kMinNormal = _mm256_set1_epi32(113 << 23);
+    const __m256i kMaxFinite = _mm256_set1_epi32(0x7f7fffff);
+    const __m256i kInf = _mm256_set1_epi32(0x7f800000);
+    const __m256i kOne = _mm256_set1_epi32(1);
+    const __m256 kDenormScale = _mm256_set1_ps(16777216.f);
+    const __m256 kHalf = _mm256_set1_ps(0.5f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i v = _mm256_castps_si256(_mm256_loadu_ps(pSrc + i));
+        const __m256i sign = _mm256_and_si256(_mm256_srli_epi32(v, 16), kSignMask);
+        const __m256i a = _mm256_and_si256(v, kAbsMask);
+
+        __m256i normal = _mm256_srli_epi32(_mm256_add_epi32(_mm256_sub_epi32(a, kRebias), kRound), 13);
+        normal = _mm256_min_epi32(normal, kInfHalf);
+
+        const __m256 y = _mm256_mul_ps(_mm256_castsi256_ps(a), kDenormScale);
+        const __m256i t = _mm256_cvttps_epi32(y);
+        const __m256 frac = _mm256_sub_ps(y, _mm256_cvtepi32_ps(t));
+        const __m256i denormal = _mm256_sub_epi32(t, _mm256_castps_si256(_mm256_cmp_ps(frac, kHalf, _CMP_GE_OQ)));
+
+        const __m256i m = _mm256_srli_epi32(_mm256_and_si256(v, kMantissaMask), 13);
+        const __m256i nanFix =
+            _mm256_andnot_si256(_mm256_cmpeq_epi32(a, kInf), _mm256_and_si256(_mm256_cmpeq_epi32(m, _mm256_setzero_si256()), kOne));
+        const __m256i special = _mm256_or_si256(_mm256_or_si256(m, nanFix), kInfHalf);
+
+        __m256i r = _mm256_blendv_epi8(normal, denormal, _mm256_cmpgt_epi32(kMinNormal, a));
+        r = _mm256_blendv_epi8(r, special, _mm256_cmpgt_epi32(a, kMaxFinite));
+        r = _mm256_or_si256(r, sign);
+
+        const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), packed);
+    }
+    convertFloat32ToFloat16Scalar(pSrc + i, pDst + i, count - i);
+}
+
+#endif // FALCOR_FLOAT16_SIMD
+
+ConvertFloat16ToFloat32Func selectConvertFloat16ToFloat32()
+{
+#if FALCOR_FLOAT16_SIMD
+    const CpuFeatures& features = getCpuFeatures();
+    if (features.avx2 && features.f16c)
+        return convertFloat16ToFloat32AVX2;
+    return convertFloat16ToFloat32SSE2;
+#else
+    return convertFloat16ToFloat32Scalar;
+#endif
+}
+
+ConvertFloat32ToFloat16Func selectConvertFloat32ToFloat16()
+{
+#if FALCOR_FLOAT16_SIMD
+    if (getCpuFeatures().avx2)
+        return convertFloat32ToFloat16AVX2;
+    return convertFloat32ToFloat16SSE2;
+#else
+    return convertFloat32ToFloat16Scalar;
+#endif
+}
+} // namespace
+
+void convertFloat16ToFloat32(fstd::span<const float16_t> src, fstd::span<float> dst)
+{
+    FALCOR_CHECK_ARG_EQ(src.size(), dst.size());
+    static const ConvertFloat16ToFloat32Func func = selectConvertFloat16ToFloat32();
+    func(reinterpret_cast<const uint16_t*>(src.data()), dst.data(), src.size());
+}
+
+void convertFloat32ToFloat16(fstd::span<const float> src, fstd::span<float16_t> dst)
+{
+    FALCOR_CHECK_ARG_EQ(src.size(), dst.size());
+    static const ConvertFloat32ToFloat16Func func = selectConvertFloat32ToFloat16();
+    func(src.data(), reinterpret_cast<uint16_t*>(dst.data()), src.size());
+}
+
 } // namespace math
 } // namespace Falcor
@@ -29,6 +29,7 @@
 
 #include "Core/Macros.h"
 
+#include <fstd/span.h> // TODO C++20: Replace with <span>
 #include <cstdint>
 #include <limits>
 
@@ -100,6 +101,22 @@ private:
     uint16_t mBits;
 };
 
+/**
+ * Convert an array of 16-bit floats to 32-bit floats.
+ * The result is identical to converting each value with float16ToFloat32(). SIMD instructions are used if supported by the CPU.
+ * @param[in] src Source values.
+ * @param[out] dst Destination values. Must have the same size as src.
+ */
+FALCOR_API void convertFloat16ToFloat32(fstd::span<const float16_t> src, fstd::span<float> dst);
+
+/**
+ * Convert an array of 32-bit floats to 16-bit floats.
+ * The result is identical to converting each value with float32ToFloat16(). SIMD instructions are used if supported by the CPU.
+ * @param[in] src Source values.
+ * @param[out] dst Destination values. Must have the same size as src.
+ */
+FALCOR_API void convertFloat32ToFloat16(fstd::span<const float> src, fstd::span<float16_t> dst);
+
 #if FALCOR_MSVC
 #pragma warning(push)
 #pragma warning(disable : 4455) // disable warning about literal suffixes not starting with an underscore
@@ -313,6 +313,45 @@ template<typename T>
     return inverse * oneOverDet;
 }
 
+/// Check if a 4x4 matrix is affine, i.e. the last row is (0, 0, 0, 1).
+template<typename T>
+[[nodiscard]] inline bool isAffine(const matrix<T, 4, 4>& m)
+{
+    return m[3][0] == T(0) && m[3][1] == T(0) && m[3][2] == T(0) && m[3][3] == T(1);
+}
+
+/**
+ * Compute the transposed inverse of an affine 4x4 matrix.
+ * The rows of the inverse transposed upper 3x3 part are the cross products of its rows divided by the determinant,
+ * which is considerably cheaper than the generic inverse. The result is undefined for non-affine matrices.
+ */
+template<typename T>
+[[nodiscard]] inline matrix<T, 4, 4> inverseTransposeAffine(const matrix<T, 4, 4>& m)
+{
+    vector<T, 3> r0 = m[0].xyz();
+    vector<T, 3> r1 = m[1].xyz();
+    vector<T, 3> r2 = m[2].xyz();
+
+    vector<T, 3> c0 = cross(r1, r2);
+    vector<T, 3> c1 = cross(r2, r0);
+    vector<T, 3> c2 = cross(r0, r1);
+
+    T oneOverDet = T(1) / dot(r0, c0);
+    c0 = c0 * oneOverDet;
+    c1 = c1 * oneOverDet;
+    c2 = c2 * oneOverDet;
+
+    // The translation of the inverse is -inverse(A) * t, which ends up in the last row after transposing.
+    vector<T, 3> t = -((c0 * m[0][3] + c1 * m[1][3]) + c2 * m[2][3]);
+
+    return matrix<T, 4, 4>{
+        c0.x, c0.y, c0.z, T(0), // row 0
+        c1.x, c1.y, c1.z, T(0), // row 1
+        c2.x, c2.y, c2.z, T(0), // row 2
+        t.x,  t.y,  t.z,  T(1)  // row 3
+    };
+}
+
 /// Compute the (X * Y * Z) euler angles of a 4x4 matrix.
 template<typename T>
 void extractEulerAngleXYZ(const matrix<T, 4, 4>& m, float& angleX, float& angleY, float& angleZ)
@@ -0,0 +1,128 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "MatrixSIMD.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_MATRIX_SIMD 1
+#include <emmintrin.h>
+#else
+#define FALCOR_MATRIX_SIMD 0
+#endif
+
+namespace Falcor
+{
+namespace math
+{
+#if FALCOR_MATRIX_SIMD
+
+namespace
+{
+template<int X, int Y, int Z, int W>
+__m128 shuffle(__m128 v)
+{
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+}
+
+// Cross product of the xyz components, matching the operation order of cross().
+__m128 cross(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(
+        _mm_mul_ps(shuffle<1, 2, 0, 3>(a), shuffle<2, 0, 1, 3>(b)), _mm_mul_ps(shuffle<2, 0, 1, 3>(a), shuffle<1, 2, 0, 3>(b))
+    );
+}
+} // namespace
+
+float4x4 mulSIMD(const float4x4& lhs, const float4x4& rhs)
+{
+    const __m128 b0 = _mm_loadu_ps(rhs.data() + 0);
+    const __m128 b1 = _mm_loadu_ps(rhs.data() + 4);
+    const __m128 b2 = _mm_loadu_ps(rhs.data() + 8);
+    const __m128 b3 = _mm_loadu_ps(rhs.data() + 12);
+
+    float4x4 result;
+    for (int r = 0; r < 4; ++r)
+    {
+        // Each row of the result is a linear combination of the rows of rhs, summed in the same order as dot().
+        const __m128 a = _mm_loadu_ps(lhs.data() + 4 * r);
+        __m128 row = _mm_mul_ps(shuffle<0, 0, 0, 0>(a), b0);
+        row = _mm_add_ps(row, _mm_mul_ps(shuffle<1, 1, 1, 1>(a), b1));
+        row = _mm_add_ps(row, _mm_mul_ps(shuffle<2, 2, 2, 2>(a), b2));
+        row = _mm_add_ps(row, _mm_mul_ps(shuffle<3, 3, 3, 3>(a), b3));
+        _mm_storeu_ps(result.data() + 4 * r, row);
+    }
+    return result;
+}
+
+float4x4 inverseTransposeAffineSIMD(const float4x4& m)
+{
+    // The w components of the rows hold the translation.
+    const __m128 r0 = _mm_loadu_ps(m.data() + 0);
+    const __m128 r1 = _mm_loadu_ps(m.data() + 4);
+    const __m128 r2 = _mm_loadu_ps(m.data() + 8);
+
+    __m128 c0 = cross(r1, r2);
+    __m128 c1 = cross(r2, r0);
+    __m128 c2 = cross(r0, r1);
+
+    // Determinant as (x + y) + z, matching dot().
+    const __m128 p = _mm_mul_ps(r0, c0);
+    const __m128 det = _mm_add_ss(_mm_add_ss(p, shuffle<1, 1, 1, 1>(p)), shuffle<2, 2, 2, 2>(p));
+    const __m128 oneOverDet = shuffle<0, 0, 0, 0>(_mm_div_ss(_mm_set_ss(1.f), det));
+    c0 = _mm_mul_ps(c0, oneOverDet);
+    c1 = _mm_mul_ps(c1, oneOverDet);
+    c2 = _mm_mul_ps(c2, oneOverDet);
+
+    __m128 t = _mm_add_ps(_mm_mul_ps(c0, shuffle<3, 3, 3, 3>(r0)), _mm_mul_ps(c1, shuffle<3, 3, 3, 3>(r1)));
+    t = _mm_add_ps(t, _mm_mul_ps(c2, shuffle<3, 3, 3, 3>(r2)));
+    t = _mm_xor_ps(t, _mm_set1_ps(-0.f));
+
+    // Clear the w components and set the bottom right element to one.
+    const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    float4x4 result;
+    _mm_storeu_ps(result.data() + 0, _mm_and_ps(c0, xyzMask));
+    _mm_storeu_ps(result.data() + 4, _mm_and_ps(c1, xyzMask));
+    _mm_storeu_ps(result.data() + 8, _mm_and_ps(c2, xyzMask));
+    _mm_storeu_ps(result.data() + 12, _mm_or_ps(_mm_and_ps(t, xyzMask), _mm_set_ps(1.f, 0.f, 0.f, 0.f)));
+    return result;
+}
+
+#else // FALCOR_MATRIX_SIMD
+
+float4x4 mulSIMD(const float4x4& lhs, const float4x4& rhs)
+{
+    return mul(lhs, rhs);
+}
+
+float4x4 inverseTransposeAffineSIMD(const float4x4& m)
+{
+    return inverseTransposeAffine(m);
+}
+
+#endif // FALCOR_MATRIX_SIMD
+} // namespace math
+} // namespace Falcor
@@ -0,0 +1,159 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+#include "Core/Macros.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace Falcor
+{
+
+namespace detail
+{
+struct XXHash64Constants
+{
+    static constexpr uint64_t kPrime1 = UINT64_C(0x9E3779B185EBCA87);
+    static constexpr uint64_t kPrime2 = UINT64_C(0xC2B2AE3D27D4EB4F);
+    static constexpr uint64_t kPrime3 = UINT64_C(0x165667B19E3779F9);
+    static constexpr uint64_t kPrime4 = UINT64_C(0x85EBCA77C2B2AE63);
+    static constexpr uint64_t kPrime5 = UINT64_C(0x27D4EB2F165667C5);
+};
+
+inline uint64_t xxHashRotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t xxHashRead64(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t xxHashRead32(const uint8_t* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t xxHash64Round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXHash64Constants::kPrime2;
+    acc = xxHashRotl64(acc, 31);
+    return acc * XXHash64Constants::kPrime1;
+}
+
+inline uint64_t xxHash64MergeRound(uint64_t acc, uint64_t val)
+{
+    acc ^= xxHash64Round(0, val);
+    return acc * XXHash64Constants::kPrime1 + XXHash64Constants::kPrime4;
+}
+} // namespace detail
+
+/**
+ * Compute the 64-bit xxHash (XXH64) of a block of data.
+ * This is a non-cryptographic hash processing 32 bytes per iteration, which makes it much faster than FNVHash
+ * for hashing large amounts of data such as image contents. The result matches the reference implementation
+ * on little-endian platforms.
+ * @param[in] data Pointer to the data.
+ * @param[in] size Size of the data in bytes.
+ * @param[in] seed Seed value.
+ * @return The hash value.
+ */
+inline uint64_t xxHash64(const void* data, size_t size, uint64_t seed = 0)
+{
+    using C = detail::XXHash64Constants;
+    using namespace detail;
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* const end = p + size;
+    uint64_t h;
+
+    if (size >= 32)
+    {
+        const uint8_t* const limit = end - 32;
+        uint64_t v1 = seed + C::kPrime1 + C::kPrime2;
+        uint64_t v2 = seed + C::kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - C::kPrime1;
+
+        do
+        {
+            v1 = xxHash64Round(v1, xxHashRead64(p));
+            v2 = xxHash64Round(v2, xxHashRead64(p + 8));
+            v3 = xxHash64Round(v3, xxHashRead64(p + 16));
+            v4 = xxHash64Round(v4, xxHashRead64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = xxHashRotl64(v1, 1) + xxHashRotl64(v2, 7) + xxHashRotl64(v3, 12) + xxHashRotl64(v4, 18);
+        h = xxHash64MergeRound(h, v1);
+        h = xxHash64MergeRound(h, v2);
+        h = xxHash64MergeRound(h, v3);
+        h = xxHash64MergeRound(h, v4);
+    }
+    else
+    {
+        h = seed + C::kPrime5;
+    }
+
+    h += static_cast<uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= xxHash64Round(0, xxHashRead64(p));
+        h = xxHashRotl64(h, 27) * C::kPrime1 + C::kPrime4;
+    }
+
+    if (p + 4 <= end)
+    {
+        h ^= static_cast<uint64_t>(xxHashRead32(p)) * C::kPrime1;
+        h = xxHashRotl64(h, 23) * C::kPrime2 + C::kPrime3;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+    {
+        h ^= (*p) * C::kPrime5;
+        h = xxHashRotl64(h, 11) * C::kPrime1;
+    }
+
+    // Final avalanche.
+    h ^= h >> 33;
+    h *= C::kPrime2;
+    h ^= h >> 29;
+    h *= C::kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+} // namespace Falcor
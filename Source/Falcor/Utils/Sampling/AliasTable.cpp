@@ -27,9 +27,18 @@
  **************************************************************************/
 #include "AliasTable.h"
 #include "Core/Errors.h"
+#include "Utils/Threading.h"
+#include <algorithm>
 
 namespace Falcor
 {
+namespace
+{
+const uint32_t kInvalidIndex = 0xFFFFFFFFu;
+
+// Largest float below 1.0.
+const float kOneMinusEpsilon = 0.99999994f;
+
 // This builds an alias table via the O(N) algorithm from Vose 1991, "A linear algorithm for generating random
 // numbers with a given distribution," IEEE Transactions on Software Engineering 17(9), 972-975.
 //
@@ -44,34 +53,30 @@ namespace Falcor
 // The main complexity is dealing with corner cases, thanks to numerical precision issues, where you don't
 // have 2 valid entries to combine.  By definition, in these corner cases, all remaining unhandled samples
 // actually have the average weight (within numerical precision limits)
-AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng) : mCount((uint32_t)weights.size())
+//
+// The items are written to items[0..count) and reference the weights as indexOffset + i.
+// Returns the sum of the weights.
+double buildItems(fstd::span<const float> inputWeights, uint32_t indexOffset, AliasTable::Item* items)
 {
-    // Use >= since we reserve 0xFFFFFFFFu as an invalid flag marker during construction.
-    if (weights.size() >= std::numeric_limits<uint32_t>::max())
-        throw RuntimeError("Too many entries for alias table.");
-
-    std::uniform_int_distribution<uint32_t> rngDist;
-
-    mpWeights = Buffer::createStructured(
-        pDevice, sizeof(float), mCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, weights.data()
-    );
+    const uint32_t count = (uint32_t)inputWeights.size();
+    std::vector<float> weights(inputWeights.begin(), inputWeights.end());
 
     // Our working set / intermediate buffers (underweight & overweight); initialize to "invalid"
-    std::vector<uint32_t> lowIdx(mCount, 0xFFFFFFFFu);
-    std::vector<uint32_t> highIdx(mCount, 0xFFFFFFFFu);
+    std::vector<uint32_t> lowIdx(count, kInvalidIndex);
+    std::vector<uint32_t> highIdx(count, kInvalidIndex);
 
     // Sum element weights, use double to minimize precision issues
-    mWeightSum = 0.0;
+    double weightSum = 0.0;
     for (float f : weights)
-        mWeightSum += f;
+        weightSum += f;
 
     // Find the average weight
-    float avgWeight = float(mWeightSum / double(mCount));
+    float avgWeight = float(weightSum / double(count));
 
     // Initialize working set. Inset inputs into our lists of above-average or below-average weight elements.
-    int lowCount = 0;
-    int highCount = 0;
-    for (uint32_t i = 0; i < mCount; ++i)
+    uint32_t lowCount = 0;
+    uint32_t highCount = 0;
+    for (uint32_t i = 0; i < count; ++i)
     {
         if (weights[i] < avgWeight)
             lowIdx[lowCount++] = i;
@@ -80,14 +85,13 @@ AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt1
     }
 
     // Create alias table entries by merging above- and below-average samples
-    std::vector<AliasTable::Item> items(mCount);
-    for (uint32_t i = 0; i < mCount; ++i)
+    for (uint32_t i = 0; i < count; ++i)
     {
         // Usual case:  We have an above-average and below-average sample we can combine into one alias table entry
-        if ((lowIdx[i] != 0xFFFFFFFFu) && (highIdx[i] != 0xFFFFFFFFu))
+        if ((lowIdx[i] != kInvalidIndex) && (highIdx[i] != kInvalidIndex))
         {
             // Create an alias table tuple:
-            items[i] = {weights[lowIdx[i]] / avgWeight, highIdx[i], lowIdx[i], 0};
+            items[i] = {weights[lowIdx[i]] / avgWeight, indexOffset + highIdx[i], indexOffset + lowIdx[i], 0};
 
             // We've removed some weight from element highIdx[i]; update it's weight, then re-enter it
             // on the end of either the above-average or below-average lists.
@@ -108,13 +112,13 @@ AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt1
         //        treating these entries as having exactly avgWeight (as in case (a)) is the only right
         //        thing to do mathematically (other than re-generating the alias table using higher precision
         //        or trying to reduce catasrophic numerical cancellation in the "updatedWeight" computation above).
-        else if (highIdx[i] != 0xFFFFFFFFu)
+        else if (highIdx[i] != kInvalidIndex)
         {
-            items[i] = {1.0f, highIdx[i], highIdx[i], 0};
+            items[i] = {1.0f, indexOffset + highIdx[i], indexOffset + highIdx[i], 0};
         }
-        else if (lowIdx[i] != 0xFFFFFFFFu)
+        else if (lowIdx[i] != kInvalidIndex)
         {
-            items[i] = {1.0f, lowIdx[i], lowIdx[i], 0};
+            items[i] = {1.0f, indexOffset + lowIdx[i], indexOffset + lowIdx[i], 0};
         }
 
         // If there is neither a highIdx[i] or lowIdx[i] for some array element(s).  By construction,
@@ -125,25 +129,178 @@ AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt1
         }
     }
 
-    // TODO: We can simplify the alias table to implicitly store indexB (aka lowIdx[i]), so the AliasTable::Item
-    // structure would be 1 float + 1 uint32_t, rather than 128 bits.  This, of course, would change usage in shaders
-    // and elsewhere.  To do this, here you'd need to sort elements by indexB so that when looking up mpItems[j],
-    // indexB==j.  This works since, by construction, only one element in the table has indexB==j (for any j
-    // in [0...mCount-1]).  Alternatively, during the loop above, you could directly enter elements into the
-    // correct location in the alias table.
+    return weightSum;
+}
+
+// Pick one of the two indices of an item and rescale the random number to [0..1) for reuse.
+uint32_t selectItem(const AliasTable::Item& item, float& u)
+{
+    if (u >= item.threshold)
+    {
+        u = std::min((u - item.threshold) / (1.f - item.threshold), kOneMinusEpsilon);
+        return item.indexA;
+    }
+    u = std::min(u / item.threshold, kOneMinusEpsilon);
+    return item.indexB;
+}
+} // namespace
+
+AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, uint32_t blockSize)
+    : mpDevice(pDevice), mCount((uint32_t)weights.size()), mBlockSize(blockSize), mWeights(std::move(weights))
+{
+    // Use >= since we reserve 0xFFFFFFFFu as an invalid flag marker during construction.
+    if (mWeights.size() >= std::numeric_limits<uint32_t>::max())
+        throw RuntimeError("Too many entries for alias table.");
+    FALCOR_CHECK_ARG_GT(mBlockSize, 0u);
+
+    // Build all blocks in parallel, followed by the top-level table.
+    const uint32_t blockCount = mCount == 0 ? 0 : (mCount - 1) / mBlockSize + 1;
+    std::vector<uint32_t> blocks(blockCount);
+    for (uint32_t i = 0; i < blockCount; ++i)
+        blocks[i] = i;
 
-    // Stash the alias table in our GPU buffer
+    mBlockWeightSums.resize(blockCount);
+    mItems.resize(mCount);
+    buildBlocks(blocks);
+    buildBlockTable();
+
+    // Stash the alias table in our GPU buffers
+    mpWeights = Buffer::createStructured(
+        mpDevice, sizeof(float), mCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, mWeights.data()
+    );
     mpItems = Buffer::createStructured(
-        pDevice, sizeof(AliasTable::Item), mCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, items.data()
+        mpDevice, sizeof(AliasTable::Item), mCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, mItems.data()
+    );
+    mpBlockItems = Buffer::createStructured(
+        mpDevice, sizeof(AliasTable::Item), blockCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, mBlockItems.data()
     );
 }
 
+void AliasTable::updateWeights(fstd::span<const uint32_t> indices, fstd::span<const float> weights)
+{
+    FALCOR_CHECK_ARG_EQ(indices.size(), weights.size());
+
+    std::vector<uint32_t> blocks;
+    blocks.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        FALCOR_CHECK_ARG_LT(indices[i], mCount);
+        mWeights[indices[i]] = weights[i];
+        blocks.push_back(indices[i] / mBlockSize);
+    }
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    if (blocks.empty())
+        return;
+
+    buildBlocks(blocks);
+    buildBlockTable();
+    uploadBlocks(blocks);
+}
+
+bool AliasTable::setWeights(fstd::span<const float> weights)
+{
+    FALCOR_CHECK_ARG_EQ(weights.size(), mCount);
+
+    // Compare and copy the weights block by block, marking the blocks that changed.
+    const uint32_t blockCount = getBlockCount();
+    std::vector<uint8_t> changed(blockCount, 0);
+    Threading::parallelFor(
+        0,
+        blockCount,
+        [&](size_t block)
+        {
+            const size_t first = block * mBlockSize;
+            const size_t count = std::min<size_t>(mBlockSize, mCount - first);
+            if (!std::equal(weights.begin() + first, weights.begin() + first + count, mWeights.begin() + first))
+            {
+                std::copy(weights.begin() + first, weights.begin() + first + count, mWeights.begin() + first);
+                changed[block] = 1;
+            }
+        }
+    );
+
+    std::vector<uint32_t> blocks;
+    for (uint32_t i = 0; i < blockCount; ++i)
+        if (changed[i])
+            blocks.push_back(i);
+    if (blocks.empty())
+        return false;
+
+    buildBlocks(blocks);
+    buildBlockTable();
+    uploadBlocks(blocks);
+    return true;
+}
+
 void AliasTable::setShaderData(const ShaderVar& var) const
 {
     var["items"] = mpItems;
+    var["blockItems"] = mpBlockItems;
     var["weights"] = mpWeights;
     var["count"] = mCount;
+    var["blockCount"] = getBlockCount();
+    var["blockSize"] = mBlockSize;
     var["weightSum"] = (float)mWeightSum;
 }
 
+uint32_t AliasTable::sample(float2 rnd) const
+{
+    // Select a block using the top-level table and reuse the remaining part of rnd.x for the threshold test within
+    // the block. Keep in sync with AliasTable.slang.
+    const uint32_t blockCount = getBlockCount();
+    const float x = rnd.x * blockCount;
+    const uint32_t slot = std::min((uint32_t)x, blockCount - 1);
+    float u = std::min(x - slot, kOneMinusEpsilon);
+    const uint32_t block = selectItem(mBlockItems[slot], u);
+
+    const uint32_t first = block * mBlockSize;
+    const uint32_t count = std::min(mBlockSize, mCount - first);
+    const uint32_t index = std::min((uint32_t)(rnd.y * count), count - 1);
+    return selectItem(mItems[first + index], u);
+}
+
+void AliasTable::buildBlocks(const std::vector<uint32_t>& blocks)
+{
+    Threading::parallelFor(
+        0,
+        blocks.size(),
+        [&](size_t i)
+        {
+            const uint32_t first = blocks[i] * mBlockSize;
+            const uint32_t count = std::min(mBlockSize, mCount - first);
+            mBlockWeightSums[blocks[i]] = buildItems(fstd::span<const float>(mWeights.data() + first, count), first, mItems.data() + first);
+        }
+    );
+
+    mWeightSum = 0.0;
+    for (double blockWeightSum : mBlockWeightSums)
+        mWeightSum += blockWeightSum;
+}
+
+void AliasTable::buildBlockTable()
+{
+    std::vector<float> blockWeights(mBlockWeightSums.begin(), mBlockWeightSums.end());
+    mBlockItems.resize(blockWeights.size());
+    buildItems(blockWeights, 0, mBlockItems.data());
+}
+
+void AliasTable::uploadBlocks(const std::vector<uint32_t>& blocks)
+{
+    // Upload consecutive dirty blocks as a single range.
+    for (size_t i = 0; i < blocks.size();)
+    {
+        size_t j = i + 1;
+        while (j < blocks.size() && blocks[j] == blocks[j - 1] + 1)
+            ++j;
+
+        const size_t first = (size_t)blocks[i] * mBlockSize;
+        const size_t count = std::min<size_t>((size_t)blocks[j - 1] * mBlockSize + mBlockSize, mCount) - first;
+        mpItems->setBlob(mItems.data() + first, first * sizeof(Item), count * sizeof(Item));
+        mpWeights->setBlob(mWeights.data() + first, first * sizeof(float), count * sizeof(float));
+        i = j;
+    }
+
+    mpBlockItems->setBlob(mBlockItems.data(), 0, mBlockItems.size() * sizeof(Item));
+}
 } // namespace Falcor
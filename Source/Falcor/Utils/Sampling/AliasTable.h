@@ -29,25 +29,61 @@
 #include "Core/Macros.h"
 #include "Core/API/Buffer.h"
 #include "Core/Program/ShaderVar.h"
+#include "Utils/Math/Vector.h"
+#include <fstd/span.h> // TODO C++20: Replace with <span>
 #include <memory>
-#include <random>
+#include <vector>
 
 namespace Falcor
 {
 /**
  * Implements the alias method for sampling from a discrete probability distribution.
+ *
+ * The table is organized in two levels. The weights are split into blocks of up to blockSize consecutive entries,
+ * each of which stores its own alias table over the weights in the block. A small top-level alias table selects a
+ * block proportional to the block weight sums. Blocks are built independently and in parallel, and updating a subset
+ * of the weights only rebuilds and re-uploads the affected blocks and the top-level table.
  */
 class FALCOR_API AliasTable
 {
 public:
+    /// Default number of weights per block.
+    static constexpr uint32_t kDefaultBlockSize = 1u << 16;
+
+    /// Item structure for the table buffers.
+    struct Item
+    {
+        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
+        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
+        uint32_t indexB; ///< The original / permutation index, sampled uniformly in the block.
+        uint32_t _pad;
+    };
+
     /**
      * Create an alias table.
      * The weights don't need to be normalized to sum up to 1.
      * @param[in] pDevice GPU device.
      * @param[in] weights The weights we'd like to sample each entry proportional to.
-     * @param[in] rng The random number generator to use when creating the table.
+     * @param[in] blockSize Number of weights per block. Larger blocks sample with slightly higher precision, smaller
+     * blocks make weight updates cheaper.
      */
-    AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng);
+    AliasTable(ref<Device> pDevice, std::vector<float> weights, uint32_t blockSize = kDefaultBlockSize);
+
+    /**
+     * Update a subset of the weights.
+     * Only the blocks containing updated weights are rebuilt and uploaded to the GPU.
+     * @param[in] indices Indices of the weights to update.
+     * @param[in] weights New weights, one for each index.
+     */
+    void updateWeights(fstd::span<const uint32_t> indices, fstd::span<const float> weights);
+
+    /**
+     * Replace all weights.
+     * The new weights are compared against the current ones and only the blocks that changed are rebuilt and uploaded.
+     * @param[in] weights New weights. Must have the same count as the table.
+     * @return True if any weight changed.
+     */
+    bool setWeights(fstd::span<const float> weights);
 
     /**
      * Bind the alias table data to a given shader var.
@@ -55,6 +91,13 @@ public:
      */
     void setShaderData(const ShaderVar& var) const;
 
+    /**
+     * Sample from the table on the CPU. This matches the sampling done by AliasTable.slang.
+     * @param[in] rnd Two uniform random numbers in [0..1).
+     * @return Returns the sampled item index.
+     */
+    uint32_t sample(float2 rnd) const;
+
     /**
      * Get the number of weights in the table.
      */
@@ -65,19 +108,46 @@ public:
      */
     double getWeightSum() const { return mWeightSum; }
 
+    /**
+     * Get the original weight at a given index.
+     */
+    float getWeight(uint32_t index) const { return mWeights[index]; }
+
+    /**
+     * Get the number of weights per block.
+     */
+    uint32_t getBlockSize() const { return mBlockSize; }
+
+    /**
+     * Get the number of blocks.
+     */
+    uint32_t getBlockCount() const { return (uint32_t)mBlockWeightSums.size(); }
+
+    /**
+     * Get the per-block table items. Item i belongs to block i / blockSize and stores global weight indices.
+     */
+    const std::vector<Item>& getItems() const { return mItems; }
+
+    /**
+     * Get the top-level table items, selecting a block proportional to its weight sum.
+     */
+    const std::vector<Item>& getBlockItems() const { return mBlockItems; }
+
 private:
-    // Item structure for the mpItems buffer.
-    struct Item
-    {
-        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
-        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
-        uint32_t indexB; ///< The original / permutation index, sampled uniformly in [0...mCount-1]
-        uint32_t _pad;
-    };
+    void buildBlocks(const std::vector<uint32_t>& blocks);
+    void buildBlockTable();
+    void uploadBlocks(const std::vector<uint32_t>& blocks);
 
-    uint32_t mCount;       ///< Number of items in the alias table.
-    double mWeightSum;     ///< Total weight of all elements used to create the alias table.
-    ref<Buffer> mpItems;   ///< Buffer containing table items.
-    ref<Buffer> mpWeights; ///< Buffer containing item weights.
+    ref<Device> mpDevice;
+    uint32_t mCount;                        ///< Number of items in the alias table.
+    uint32_t mBlockSize;                    ///< Number of items per block.
+    double mWeightSum = 0.0;                ///< Total weight of all elements used to create the alias table.
+    std::vector<float> mWeights;            ///< Item weights.
+    std::vector<double> mBlockWeightSums;   ///< Weight sum of each block.
+    std::vector<Item> mItems;               ///< Per-block table items.
+    std::vector<Item> mBlockItems;          ///< Top-level table items.
+    ref<Buffer> mpItems;                    ///< Buffer containing table items.
+    ref<Buffer> mpBlockItems;               ///< Buffer containing top-level table items.
+    ref<Buffer> mpWeights;                  ///< Buffer containing item weights.
 };
 } // namespace Falcor
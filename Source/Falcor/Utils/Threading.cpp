@@ -27,70 +27,338 @@
  **************************************************************************/
 #include "Threading.h"
 #include "Core/Assert.h"
+#include "Core/Errors.h"
+#include <atomic>
+#include <deque>
+#include <exception>
 
 namespace Falcor
 {
+struct Threading::TaskState
+{
+    std::function<void(void)> func;
+    std::atomic<bool> done{false};
+    std::exception_ptr exception;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
 namespace
 {
+using TaskStatePtr = std::shared_ptr<Threading::TaskState>;
+
+struct Worker
+{
+    std::mutex mutex;
+    std::deque<TaskStatePtr> queue;
+    std::thread thread;
+};
+
 struct ThreadingData
 {
-    bool initialized = false;
-    std::vector<std::thread> threads;
-    uint32_t current;
+    std::atomic<bool> initialized{false};
+    bool stop = false;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex globalMutex;
+    std::deque<TaskStatePtr> globalQueue;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::condition_variable idleCondition;
+    int64_t queuedCount = 0;             ///< Number of tasks in the queues (protected by sleepMutex).
+    std::atomic<int64_t> activeCount{0}; ///< Number of tasks dispatched but not finished.
+
+    std::mutex startMutex;
+
+    ~ThreadingData()
+    {
+        // Stop the workers if the pool was not shut down explicitly.
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stop = true;
+        }
+        sleepCondition.notify_all();
+        for (auto& pWorker : workers)
+        {
+            if (pWorker->thread.joinable())
+                pWorker->thread.join();
+        }
+    }
 } gData; // TODO: REMOVEGLOBAL
+
+/// Index of the worker owned by the current thread, or -1 if the current thread is not a worker.
+thread_local int32_t tWorkerIndex = -1;
+
+TaskStatePtr popFront(std::mutex& mutex, std::deque<TaskStatePtr>& queue)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty())
+        return nullptr;
+    TaskStatePtr pTask = std::move(queue.front());
+    queue.pop_front();
+    return pTask;
+}
+
+TaskStatePtr popBack(std::mutex& mutex, std::deque<TaskStatePtr>& queue)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty())
+        return nullptr;
+    TaskStatePtr pTask = std::move(queue.back());
+    queue.pop_back();
+    return pTask;
+}
+
+/**
+ * Find a task to execute for the given worker.
+ * Order: own deque (LIFO), global injection queue (FIFO), then steal from other workers (FIFO).
+ */
+TaskStatePtr findTask(int32_t workerIndex)
+{
+    TaskStatePtr pTask;
+    const size_t workerCount = gData.workers.size();
+    if (workerIndex >= 0)
+    {
+        auto& worker = *gData.workers[workerIndex];
+        pTask = popBack(worker.mutex, worker.queue);
+    }
+    if (!pTask)
+        pTask = popFront(gData.globalMutex, gData.globalQueue);
+    for (size_t i = 1; !pTask && i <= workerCount; ++i)
+    {
+        size_t victim = (size_t(workerIndex + workerCount) + i) % workerCount;
+        if (int32_t(victim) == workerIndex)
+            continue;
+        auto& worker = *gData.workers[victim];
+        pTask = popFront(worker.mutex, worker.queue);
+    }
+    if (pTask)
+    {
+        std::lock_guard<std::mutex> lock(gData.sleepMutex);
+        --gData.queuedCount;
+    }
+    return pTask;
+}
+
+void executeTask(const TaskStatePtr& pTask)
+{
+    try
+    {
+        pTask->func();
+    }
+    catch (...)
+    {
+        pTask->exception = std::current_exception();
+    }
+    pTask->func = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(pTask->mutex);
+        pTask->done = true;
+    }
+    pTask->condition.notify_all();
+
+    if (--gData.activeCount == 0)
+    {
+        std::lock_guard<std::mutex> lock(gData.sleepMutex);
+        gData.idleCondition.notify_all();
+    }
+}
+
+void workerMain(int32_t workerIndex)
+{
+    tWorkerIndex = workerIndex;
+    while (true)
+    {
+        if (TaskStatePtr pTask = findTask(workerIndex))
+        {
+            executeTask(pTask);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(gData.sleepMutex);
+        gData.sleepCondition.wait(lock, []() { return gData.stop || gData.queuedCount > 0; });
+        if (gData.stop && gData.queuedCount == 0)
+            break;
+    }
+    tWorkerIndex = -1;
+}
+
+void waitForTask(const TaskStatePtr& pTask)
+{
+    if (tWorkerIndex >= 0)
+    {
+        // Help executing other tasks while waiting to avoid deadlocks with nested tasks.
+        while (!pTask->done)
+        {
+            if (TaskStatePtr pOther = findTask(tWorkerIndex))
+                executeTask(pOther);
+            else
+                std::this_thread::yield();
+        }
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lock(pTask->mutex);
+        pTask->condition.wait(lock, [&]() { return pTask->done.load(); });
+    }
+}
 } // namespace
 
 void Threading::start(uint32_t threadCount)
 {
+    std::lock_guard<std::mutex> lock(gData.startMutex);
     if (gData.initialized)
         return;
 
-    gData.threads.resize(threadCount);
+    if (threadCount == 0)
+        threadCount = getLogicalThreadCount();
+
+    gData.stop = false;
+    gData.workers.resize(threadCount);
+    for (auto& pWorker : gData.workers)
+        pWorker = std::make_unique<Worker>();
+    for (uint32_t i = 0; i < threadCount; ++i)
+        gData.workers[i]->thread = std::thread(workerMain, int32_t(i));
+
     gData.initialized = true;
 }
 
 void Threading::shutdown()
 {
-    for (auto& t : gData.threads)
+    std::lock_guard<std::mutex> lock(gData.startMutex);
+    if (!gData.initialized)
+        return;
+
+    FALCOR_ASSERT(tWorkerIndex < 0);
+
+    {
+        std::lock_guard<std::mutex> sleepLock(gData.sleepMutex);
+        gData.stop = true;
+    }
+    gData.sleepCondition.notify_all();
+
+    for (auto& pWorker : gData.workers)
     {
-        if (t.joinable())
-            t.join();
+        if (pWorker->thread.joinable())
+            pWorker->thread.join();
     }
+    gData.workers.clear();
 
     gData.initialized = false;
 }
 
-Threading::Task Threading::dispatchTask(const std::function<void(void)>& func)
+uint32_t Threading::getThreadCount()
+{
+    if (!gData.initialized)
+        start();
+    return (uint32_t)gData.workers.size();
+}
+
+bool Threading::isWorkerThread()
+{
+    return tWorkerIndex >= 0;
+}
+
+Threading::Task Threading::dispatchTask(std::function<void(void)> func)
 {
-    FALCOR_ASSERT(gData.initialized);
+    if (!gData.initialized)
+        start();
 
-    std::thread& t = gData.threads[gData.current];
-    if (t.joinable())
-        t.join();
-    t = std::thread(func);
-    gData.current = (gData.current + 1) % gData.threads.size();
+    auto pTask = std::make_shared<TaskState>();
+    pTask->func = std::move(func);
+    ++gData.activeCount;
 
-    return Task();
+    if (tWorkerIndex >= 0)
+    {
+        auto& worker = *gData.workers[tWorkerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(pTask);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(gData.globalMutex);
+        gData.globalQueue.push_back(pTask);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(gData.sleepMutex);
+        ++gData.queuedCount;
+    }
+    gData.sleepCondition.notify_one();
+
+    return Task(std::move(pTask));
 }
 
 void Threading::finish()
 {
-    for (auto& t : gData.threads)
+    if (!gData.initialized)
+        return;
+
+    if (tWorkerIndex >= 0)
     {
-        if (t.joinable())
-            t.join();
+        // Waiting for all tasks from within a task would wait for itself.
+        throw RuntimeError("Threading::finish() must not be called from a worker thread.");
     }
+
+    std::unique_lock<std::mutex> lock(gData.sleepMutex);
+    gData.idleCondition.wait(lock, []() { return gData.activeCount == 0; });
 }
 
-Threading::Task::Task() {}
+void Threading::runChunks(size_t chunkCount, const std::function<void(size_t)>& func)
+{
+    std::atomic<size_t> nextChunk{0};
+    std::mutex exceptionMutex;
+    std::exception_ptr exception;
+
+    auto runLoop = [&]()
+    {
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(1)) < chunkCount)
+        {
+            try
+            {
+                func(chunk);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exception)
+                    exception = std::current_exception();
+            }
+        }
+    };
+
+    // Dispatch helper tasks; the calling thread takes part in processing the chunks.
+    const size_t helperCount = std::min<size_t>(chunkCount - 1, getThreadCount());
+    std::vector<Task> helpers;
+    helpers.reserve(helperCount);
+    for (size_t i = 0; i < helperCount; ++i)
+        helpers.push_back(dispatchTask(runLoop));
+
+    runLoop();
+
+    for (auto& helper : helpers)
+        helper.finish();
 
-bool Threading::Task::isRunning()
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+bool Threading::Task::isRunning() const
 {
-    FALCOR_UNIMPLEMENTED();
+    return mpState && !mpState->done;
 }
 
 void Threading::Task::finish()
 {
-    FALCOR_UNIMPLEMENTED();
+    if (!mpState)
+        return;
+
+    waitForTask(mpState);
+
+    if (mpState->exception)
+        std::rethrow_exception(mpState->exception);
 }
 } // namespace Falcor
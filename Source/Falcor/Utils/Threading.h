@@ -27,64 +27,247 @@
  **************************************************************************/
 #pragma once
 #include "Core/Macros.h"
+#include <algorithm>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <cstdint>
 
 namespace Falcor
 {
+/**
+ * Global work-stealing thread pool.
+ *
+ * The pool consists of a fixed set of persistent worker threads. Each worker owns a task deque. Tasks dispatched from
+ * a worker thread are pushed to that worker's deque and popped in LIFO order, while idle workers steal from the
+ * front of other deques. Tasks dispatched from outside the pool go to a shared injection queue.
+ *
+ * Waiting on a task from within a worker thread executes other pending tasks while waiting, so tasks can dispatch
+ * and wait for nested tasks without deadlocking the pool.
+ *
+ * The pool is started lazily on first use if start() has not been called explicitly.
+ */
 class FALCOR_API Threading
 {
 public:
-    const static uint32_t kDefaultThreadCount = 16;
+    struct TaskState;
 
     /**
-     * Handle to a dispatched task
-     *
-     * TODO: Implementation
+     * Handle to a dispatched task.
+     * Handles are cheap to copy. A default constructed handle does not refer to any task.
      */
-    class Task
+    class FALCOR_API Task
     {
     public:
-        ///  Check if task is still executing
-        bool isRunning();
+        Task() = default;
+
+        /// Returns true if the handle refers to a task.
+        bool isValid() const { return mpState != nullptr; }
+
+        /// Check if task is still executing (or waiting to be executed).
+        bool isRunning() const;
 
-        /// Wait for task to finish executing
+        /**
+         * Wait for task to finish executing.
+         * If the task threw an exception, it is rethrown here.
+         */
         void finish();
 
+    protected:
+        Task(std::shared_ptr<TaskState> pState) : mpState(std::move(pState)) {}
+
+        std::shared_ptr<TaskState> mpState;
+        friend class Threading;
+    };
+
+    /**
+     * Handle to a dispatched task returning a value of type T.
+     */
+    template<typename T>
+    class Future : public Task
+    {
+    public:
+        Future() = default;
+
+        /**
+         * Wait for the task to finish and return its result.
+         * The result is moved out of the handle, so get() can only be called once.
+         */
+        T get()
+        {
+            finish();
+            return std::move(**mpResult);
+        }
+
     private:
-        Task();
+        Future(Task task, std::shared_ptr<std::optional<T>> pResult) : Task(std::move(task)), mpResult(std::move(pResult)) {}
+
+        std::shared_ptr<std::optional<T>> mpResult;
         friend class Threading;
     };
 
     /**
-     * Initializes the global thread pool
-     * @param[in] threadCount Number of threads in the pool
+     * Initializes the global thread pool. Does nothing if the pool is already running.
+     * @param[in] threadCount Number of worker threads in the pool. If zero, getLogicalThreadCount() is used.
      */
-    static void start(uint32_t threadCount = kDefaultThreadCount);
+    static void start(uint32_t threadCount = 0);
 
     /**
-     * Waits for all currently executing threads to finish
+     * Waits for all currently dispatched tasks to finish.
      */
     static void finish();
 
     /**
-     * Waits for all currently executing threads to finish and shuts down the thread pool
+     * Waits for all currently dispatched tasks to finish and shuts down the thread pool.
      */
     static void shutdown();
 
     /**
      * Returns the maximum number of concurrent threads supported by the hardware
      */
-    static uint32_t getLogicalThreadCount() { return std::thread::hardware_concurrency(); }
+    static uint32_t getLogicalThreadCount() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+    /**
+     * Returns the number of worker threads in the pool. Starts the pool if it is not running.
+     */
+    static uint32_t getThreadCount();
+
+    /**
+     * Returns true if the calling thread is one of the pool's worker threads.
+     */
+    static bool isWorkerThread();
 
     /**
      * Starts a task on an available thread.
      * @return Handle to the task
      */
-    static Task dispatchTask(const std::function<void(void)>& func);
+    static Task dispatchTask(std::function<void(void)> func);
+
+    /**
+     * Starts a task returning a value on an available thread.
+     * @return Handle to the task, which can be used to retrieve the result.
+     */
+    template<typename F, typename R = std::invoke_result_t<std::decay_t<F>>, std::enable_if_t<!std::is_void_v<R>, int> = 0>
+    static Future<R> dispatchTask(F&& func)
+    {
+        auto pResult = std::make_shared<std::optional<R>>();
+        Task task = dispatchTask(std::function<void(void)>([pResult, func = std::forward<F>(func)]() mutable { pResult->emplace(func()); }));
+        return Future<R>(std::move(task), std::move(pResult));
+    }
+
+    /**
+     * Execute a function for each index in [begin, end) in parallel.
+     * The range is split into contiguous chunks of at least grainSize indices. The calling thread participates in the
+     * work and the function returns once all indices have been processed.
+     * @param[in] begin First index.
+     * @param[in] end One past the last index.
+     * @param[in] func Function called as func(i) for each index.
+     * @param[in] grainSize Minimum number of indices per chunk.
+     */
+    template<typename F>
+    static void parallelFor(size_t begin, size_t end, F&& func, size_t grainSize = 1)
+    {
+        parallelForRange(
+            begin, end,
+            [&func](size_t rangeBegin, size_t rangeEnd)
+            {
+                for (size_t i = rangeBegin; i < rangeEnd; ++i)
+                    func(i);
+            },
+            grainSize
+        );
+    }
+
+    /**
+     * Execute a function for contiguous sub-ranges of [begin, end) in parallel.
+     * @param[in] begin First index.
+     * @param[in] end One past the last index.
+     * @param[in] func Function called as func(rangeBegin, rangeEnd) for each chunk.
+     * @param[in] grainSize Minimum number of indices per chunk.
+     */
+    template<typename F>
+    static void parallelForRange(size_t begin, size_t end, F&& func, size_t grainSize = 1)
+    {
+        if (end <= begin)
+            return;
+        const size_t chunkCount = getChunkCount(end - begin, grainSize);
+        if (chunkCount <= 1)
+        {
+            func(begin, end);
+            return;
+        }
+        runChunks(
+            chunkCount,
+            [&](size_t chunk)
+            {
+                auto [rangeBegin, rangeEnd] = getChunkRange(begin, end, chunkCount, chunk);
+                func(rangeBegin, rangeEnd);
+            }
+        );
+    }
+
+    /**
+     * Parallel reduction over [begin, end).
+     * Each chunk is reduced with func(rangeBegin, rangeEnd, identity) and the chunk results are combined with
+     * reduce(a, b) in chunk order. The chunk boundaries only depend on the range, grain size and thread count,
+     * so the result is deterministic for a given pool size.
+     * @param[in] begin First index.
+     * @param[in] end One past the last index.
+     * @param[in] identity Identity value of the reduction.
+     * @param[in] func Function called as func(rangeBegin, rangeEnd, identity) returning the reduced value of a chunk.
+     * @param[in] reduce Function combining two partial results.
+     * @param[in] grainSize Minimum number of indices per chunk.
+     */
+    template<typename T, typename F, typename R>
+    static T parallelReduce(size_t begin, size_t end, const T& identity, F&& func, R&& reduce, size_t grainSize = 1)
+    {
+        if (end <= begin)
+            return identity;
+        const size_t chunkCount = getChunkCount(end - begin, grainSize);
+        if (chunkCount <= 1)
+            return func(begin, end, identity);
+
+        std::vector<std::optional<T>> partials(chunkCount);
+        runChunks(
+            chunkCount,
+            [&](size_t chunk)
+            {
+                auto [rangeBegin, rangeEnd] = getChunkRange(begin, end, chunkCount, chunk);
+                partials[chunk].emplace(func(rangeBegin, rangeEnd, identity));
+            }
+        );
+
+        T result = std::move(*partials[0]);
+        for (size_t i = 1; i < chunkCount; ++i)
+            result = reduce(std::move(result), std::move(*partials[i]));
+        return result;
+    }
+
+private:
+    static size_t getChunkCount(size_t count, size_t grainSize)
+    {
+        // Over-subscribe the workers a bit to balance uneven work between chunks.
+        const size_t maxChunks = size_t(getThreadCount() + 1) * 4;
+        return std::min(maxChunks, (count + std::max<size_t>(grainSize, 1) - 1) / std::max<size_t>(grainSize, 1));
+    }
+
+    static std::pair<size_t, size_t> getChunkRange(size_t begin, size_t end, size_t chunkCount, size_t chunk)
+    {
+        const size_t count = end - begin;
+        return {begin + count * chunk / chunkCount, begin + count * (chunk + 1) / chunkCount};
+    }
+
+    /**
+     * Run func(chunk) for all chunks in [0, chunkCount) on the pool and wait for completion.
+     * The calling thread executes chunks as well. Exceptions are rethrown after all chunks have finished.
+     */
+    static void runChunks(size_t chunkCount, const std::function<void(size_t)>& func);
 };
 
 /**
@@ -71,6 +71,17 @@ public:
      */
     void addTotal(const std::string name = "Total");
 
+    /**
+     * Get the recorded measurements.
+     * @return List of (name, duration in seconds) pairs in the order they were recorded.
+     */
+    const std::vector<std::pair<std::string, double>>& getMeasurements() const { return mMeasurements; }
+
+    /**
+     * Get the total of all measurements as computed by the last call to addTotal().
+     */
+    double getTotal() const { return mTotal; }
+
 private:
     CpuTimer::TimePoint mLastMeasureTime;
     std::vector<std::pair<std::string, double>> mMeasurements;
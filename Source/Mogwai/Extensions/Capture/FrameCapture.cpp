@@ -41,6 +41,8 @@ namespace Mogwai
         const std::string kUI = "ui";
         const std::string kOutputs = "outputs";
         const std::string kCapture = "capture";
+        const std::string kFlush = "flush";
+        const std::string kStats = "stats";
 
         template<typename T>
         std::vector<typename T::value_type::first_type> getFirstOfPair(const T& pair)
@@ -63,6 +65,13 @@ namespace Mogwai
         : CaptureTrigger(pRenderer, "Frame Capture")
     {
         mpImageProcessing = std::make_unique<ImageProcessing>(pRenderer->getDevice());
+        mpImageWriter = std::make_unique<AsyncImageWriter>();
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        // Destroying the writer blocks until all queued images are written.
+        mpImageWriter.reset();
     }
 
     void FrameCapture::renderUI(Gui* pGui)
@@ -76,7 +85,19 @@ namespace Mogwai
             w.checkbox("Capture All Outputs", mCaptureAllOutputs);
             w.tooltip("Capture all available outputs instead of the marked ones only.");
 
+            w.checkbox("Multi-Layer EXR", mMultiLayerEXR);
+            w.tooltip("Write all outputs of a frame as layers of a single EXR file.");
+
             if (w.button("Capture Current Frame")) capture();
+
+            const auto stats = mpImageWriter->getStats();
+            std::string text;
+            text += fmt::format("Images written: {} ({} failed)\n", stats.writtenCount, stats.failedCount);
+            text += fmt::format("Bytes written: {}\n", formatByteSize(stats.bytesWritten));
+            text += fmt::format("Queued: {} ({})\n", stats.queueSize, formatByteSize(stats.queuedBytes));
+            text += fmt::format("Encode time: {:.2f} s\n", stats.encodeTime);
+            text += fmt::format("Render thread blocked: {:.2f} s", stats.blockedTime);
+            w.text(text);
         }
     }
 
@@ -95,6 +116,7 @@ namespace Mogwai
         auto printGraph = [](FrameCapture* pFC, RenderGraph* pGraph) { pybind11::print(pFC->graphFramesStr(pGraph)); };
         frameCapture.def(kPrintFrames.c_str(), printGraph, "graph"_a);
         frameCapture.def(kCapture.c_str(), &FrameCapture::capture);
+        frameCapture.def(kFlush.c_str(), &FrameCapture::flush);
         auto printAllGraphs = [](FrameCapture* pFC)
         {
             std::string s;
@@ -111,6 +133,23 @@ namespace Mogwai
         frameCapture.def_property("captureAllOutputs",
             [](FrameCapture* pFC){ return pFC->mCaptureAllOutputs;},
             [](FrameCapture* pFC, bool all){ pFC->mCaptureAllOutputs = all; });
+
+        frameCapture.def_property("multiLayerEXR",
+            [](FrameCapture* pFC){ return pFC->mMultiLayerEXR;},
+            [](FrameCapture* pFC, bool enabled){ pFC->mMultiLayerEXR = enabled; });
+
+        auto getStats = [](FrameCapture* pFC)
+        {
+            const auto stats = pFC->mpImageWriter->getStats();
+            pybind11::dict d;
+            d["writtenCount"] = stats.writtenCount;
+            d["failedCount"] = stats.failedCount;
+            d["bytesWritten"] = stats.bytesWritten;
+            d["encodeTime"] = stats.encodeTime;
+            d["blockedTime"] = stats.blockedTime;
+            return d;
+        };
+        frameCapture.def_property_readonly(kStats.c_str(), getStats);
     }
 
     std::string FrameCapture::getScriptVar() const
@@ -144,9 +183,16 @@ namespace Mogwai
             pGraph->execute(pRenderContext);
         }
 
-        for (uint32_t i = 0 ; i < pGraph->getOutputCount() ; i++)
+        if (mMultiLayerEXR)
         {
-            captureOutput(pRenderContext, pGraph, i);
+            captureMultiLayerEXR(pRenderContext, pGraph);
+        }
+        else
+        {
+            for (uint32_t i = 0 ; i < pGraph->getOutputCount() ; i++)
+            {
+                captureOutput(pRenderContext, pGraph, i);
+            }
         }
 
         if (mCaptureAllOutputs && !unmarkedOutputs.empty())
@@ -248,10 +294,122 @@ namespace Mogwai
             Bitmap::ExportFlags flags = Bitmap::ExportFlags::None;
             if (mask == TextureChannelFlags::RGBA) flags |= Bitmap::ExportFlags::ExportAlpha;
 
-            pTex->captureToFile(0, 0, filename, fileformat, flags);
+            pTex->captureToFile(0, 0, filename, fileformat, flags, *mpImageWriter);
         }
     }
 
+    void FrameCapture::captureMultiLayerEXR(RenderContext* pRenderContext, RenderGraph* pGraph)
+    {
+        // Create one layer per graph output holding all channels of its output masks.
+        std::vector<EXRWriter::Layer> layers;
+        std::vector<ref<Texture>> textures;
+        uint2 size(0);
+
+        for (uint32_t i = 0 ; i < pGraph->getOutputCount() ; i++)
+        {
+            const std::string outputName = pGraph->getOutputName(i);
+            const ref<Texture> pOutput = pGraph->getOutput(i)->asTexture();
+            if (!pOutput) throw RuntimeError("Graph output {} is not a texture", outputName);
+
+            const uint2 outputSize(pOutput->getWidth(), pOutput->getHeight());
+            if (layers.empty()) size = outputSize;
+            else if (any(outputSize != size))
+            {
+                logWarning("Graph output {} has a different size than the first output. Skipping.", outputName);
+                continue;
+            }
+
+            // Integer outputs can't be blitted into the floating-point staging texture without losing their values.
+            const ResourceFormat format = pOutput->getFormat();
+            const FormatType type = getFormatType(format);
+            if (type == FormatType::Uint || type == FormatType::Sint)
+            {
+                logWarning("Graph output {} has integer format {} which can't be written to a multi-layer EXR file. Skipping.", outputName, to_string(format));
+                continue;
+            }
+
+            TextureChannelFlags channels = TextureChannelFlags::None;
+            for (auto mask : pGraph->getOutputMasks(i)) channels |= mask;
+            for (uint32_t c = getFormatChannelCount(format); c < 4; c++) channels &= ~TextureChannelFlags(1u << c);
+            if (channels == TextureChannelFlags::None) continue;
+
+            // Half precision is sufficient for 16-bit float and 8-bit normalized formats.
+            const uint32_t bits = getNumChannelBits(format, 0);
+            const bool isNormalized = type == FormatType::Unorm || type == FormatType::UnormSrgb || type == FormatType::Snorm;
+
+            EXRWriter::Layer layer;
+            layer.name = outputName;
+            layer.channels = channels;
+            layer.useHalf = (type == FormatType::Float && bits <= 16) || (isNormalized && bits <= 8);
+            layers.push_back(layer);
+            textures.push_back(pOutput);
+        }
+
+        if (layers.empty()) return;
+
+        const auto path = getOutputPath() / (mBaseFilename + "." + std::to_string(mpRenderer->getGlobalClock().getFrame()) + ".exr");
+        EXRWriter writer(path, size.x, size.y, layers);
+
+        // Read back the outputs one band of rows at a time to keep the memory use independent of the image height.
+        // The band is converted to RGBA32Float in a staging texture per layer before it is read back. The staging textures
+        // are double buffered so that the readback of the next band is in flight while the current band is written.
+        const uint32_t bandHeight = writer.getTileSize();
+        const uint32_t bandCount = div_round_up(size.y, bandHeight);
+        const size_t layerCount = layers.size();
+        std::vector<ref<Texture>> staging(2 * layerCount);
+        for (auto& pStaging : staging)
+        {
+            pStaging = Texture::create2D(mpRenderer->getDevice(), size.x, bandHeight, ResourceFormat::RGBA32Float, 1, 1, nullptr, ResourceBindFlags::ShaderResource | ResourceBindFlags::RenderTarget);
+        }
+
+        std::vector<CopyContext::ReadTextureTask::SharedPtr> tasks(2 * layerCount);
+        auto readBand = [&](uint32_t band)
+        {
+            const uint32_t firstRow = band * bandHeight;
+            const uint32_t rowCount = std::min(bandHeight, size.y - firstRow);
+            for (size_t i = 0; i < layerCount; i++)
+            {
+                const size_t slot = (band % 2) * layerCount + i;
+                pRenderContext->blit(textures[i]->getSRV(0, 1, 0, 1), staging[slot]->getRTV(), uint4(0, firstRow, size.x, firstRow + rowCount), uint4(0, 0, size.x, rowCount), Sampler::Filter::Point);
+                tasks[slot] = pRenderContext->asyncReadTextureSubresource(staging[slot].get(), 0);
+            }
+        };
+
+        std::vector<float> pixels;
+        readBand(0);
+
+        for (uint32_t band = 0; band < bandCount; band++)
+        {
+            if (band + 1 < bandCount) readBand(band + 1);
+
+            const uint2 bandRows = writer.getBandRows();
+            const uint32_t rowCount = bandRows.y - bandRows.x;
+            FALCOR_ASSERT(bandRows.x == band * bandHeight);
+
+            for (size_t i = 0; i < layerCount; i++)
+            {
+                const size_t slot = (band % 2) * layerCount + i;
+                const std::vector<uint8_t> data = tasks[slot]->getData();
+                tasks[slot].reset();
+                const float* pSrc = reinterpret_cast<const float*>(data.data());
+
+                // Keep the channels of the layer.
+                pixels.clear();
+                for (size_t p = 0; p < (size_t)size.x * rowCount; p++)
+                {
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        if (is_set(layers[i].channels, TextureChannelFlags(1u << c))) pixels.push_back(pSrc[p * 4 + c]);
+                    }
+                }
+
+                writer.writeRows((uint32_t)i, bandRows.x, rowCount, pixels.data());
+            }
+        }
+
+        writer.finish();
+    }
+
     void FrameCapture::addFrames(const RenderGraph* pGraph, const uint64_vec& frames)
     {
         for (auto f : frames) addRange(pGraph, f, 1);
@@ -279,4 +437,9 @@ namespace Mogwai
         uint64_t frameID = mpRenderer->getGlobalClock().getFrame();
         triggerFrame(mpRenderer->getRenderContext(), pGraph, frameID);
     }
+
+    void FrameCapture::flush()
+    {
+        mpImageWriter->flush();
+    }
 }
@@ -28,6 +28,8 @@
 #pragma once
 #include "../../Mogwai.h"
 #include "CaptureTrigger.h"
+#include "Utils/Image/AsyncImageWriter.h"
+#include "Utils/Image/EXRWriter.h"
 #include "Utils/Image/ImageProcessing.h"
 
 namespace Mogwai
@@ -36,12 +38,14 @@ namespace Mogwai
     {
     public:
         static UniquePtr create(Renderer* pRenderer);
+        virtual ~FrameCapture();
         virtual void renderUI(Gui* pGui) override;
         virtual void registerScriptBindings(pybind11::module& m) override;
         virtual std::string getScriptVar() const override;
         virtual std::string getScript(const std::string& var) const override;
         virtual void triggerFrame(RenderContext* pRenderContext, RenderGraph* pGraph, uint64_t frameID) override;
         void capture();
+        void flush();
 
     private:
         FrameCapture(Renderer* pRenderer);
@@ -51,8 +55,11 @@ namespace Mogwai
         void addFrames(const std::string& graphName, const uint64_vec& frames);
         std::string graphFramesStr(const RenderGraph* pGraph);
         void captureOutput(RenderContext* pRenderContext, RenderGraph* pGraph, const uint32_t outputIndex);
+        void captureMultiLayerEXR(RenderContext* pRenderContext, RenderGraph* pGraph);
 
         bool mCaptureAllOutputs = false;
+        bool mMultiLayerEXR = false;
         std::unique_ptr<ImageProcessing> mpImageProcessing;
+        std::unique_ptr<AsyncImageWriter> mpImageWriter; ///< Encodes and writes captured images on separate threads.
     };
 }
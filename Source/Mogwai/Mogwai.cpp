@@ -29,16 +29,20 @@
 #include "Mogwai.h"
 #include "MogwaiSettings.h"
 #include "GlobalState.h"
+#include "Core/Program/ProgramManager.h"
 #include "Scene/Importer.h"
 #include "RenderGraph/RenderGraphImportExport.h"
 #include "RenderGraph/RenderPassStandardFlags.h"
 #include "Utils/Scripting/Scripting.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Settings.h"
+#include "Utils/CryptoUtils.h"
 
 #include <args.hxx>
+#include <nlohmann/json.hpp>
 
 #include <filesystem>
+#include <fstream>
 #include <algorithm>
 
 FALCOR_EXPORT_D3D12_AGILITY_SDK
@@ -55,6 +59,60 @@ namespace Mogwai
         const std::string kGraphNameSwitch = "--graph-name";
 
         const std::filesystem::path kAppDataPath = getAppDataDirectory() / "NVIDIA/Falcor/Mogwai.json";
+        const std::filesystem::path kProgramPermutationsDirectory = getAppDataDirectory() / "NVIDIA/Falcor/ProgramPermutations";
+
+        using PermutationRecord = ProgramManager::PermutationRecord;
+
+        /** Get the file storing the program permutations recorded for a graph and scene.
+        */
+        std::filesystem::path getProgramPermutationsPath(const RenderGraph* pGraph, const Scene* pScene)
+        {
+            SHA1 sha1;
+            sha1.update(pGraph->getName());
+            if (pScene) sha1.update(pScene->getPath().string());
+            return kProgramPermutationsDirectory / (SHA1::toString(sha1.finalize()) + ".json");
+        }
+
+        std::vector<PermutationRecord> loadProgramPermutations(const std::filesystem::path& path)
+        {
+            std::vector<PermutationRecord> records;
+            std::ifstream ifs(path);
+            if (!ifs.good()) return records;
+
+            try
+            {
+                const nlohmann::json j = nlohmann::json::parse(ifs);
+                for (const auto& record : j)
+                {
+                    PermutationRecord r;
+                    r.programDesc = record.at("program").get<std::string>();
+                    const auto& defines = record.at("defines");
+                    for (auto it = defines.begin(); it != defines.end(); ++it) r.defines.add(it.key(), it.value().get<std::string>());
+                    records.push_back(std::move(r));
+                }
+            }
+            catch (const std::exception& e)
+            {
+                logWarning("Failed to parse program permutations file '{}': {}", path, e.what());
+                records.clear();
+            }
+            return records;
+        }
+
+        void saveProgramPermutations(const std::filesystem::path& path, const std::vector<PermutationRecord>& records)
+        {
+            nlohmann::json j = nlohmann::json::array();
+            for (const auto& record : records)
+            {
+                j.push_back({ { "program", record.programDesc }, { "defines", std::map<std::string, std::string>(record.defines) } });
+            }
+
+            std::error_code ec;
+            std::filesystem::create_directories(path.parent_path(), ec);
+            std::ofstream ofs(path);
+            if (!ofs.good()) return;
+            ofs << j.dump(4);
+        }
     }
 
     size_t Renderer::DebugWindow::index = 0;
@@ -84,6 +142,7 @@ namespace Mogwai
 
     void Renderer::onShutdown()
     {
+        recordProgramPermutations();
         resetEditor();
         getDevice()->flushAndSync(); // Need to do that because clearing the graphs will try to release some state objects which might be in use
         mGraphs.clear();
@@ -358,6 +417,7 @@ namespace Mogwai
 
     void Renderer::setActiveGraph(uint32_t active)
     {
+        recordProgramPermutations();
         RenderGraph* pOld = getActiveGraph();
         mActiveGraph = active;
         RenderGraph* pNew = getActiveGraph();
@@ -370,6 +430,7 @@ namespace Mogwai
 
     void Renderer::removeGraph(const ref<RenderGraph>& pGraph)
     {
+        recordProgramPermutations();
         for (auto& e : mpExtensions) e->removeGraph(pGraph.get());
         size_t i = 0;
         for (; i < mGraphs.size(); i++) if (mGraphs[i].pGraph == pGraph) break;
@@ -556,6 +617,7 @@ namespace Mogwai
 
     void Renderer::setScene(const ref<Scene>& pScene)
     {
+        recordProgramPermutations();
         mpScene = pScene;
 
         if (mpScene)
@@ -642,6 +704,40 @@ namespace Mogwai
         pGraph->execute(pRenderContext);
     }
 
+    void Renderer::prewarmPrograms()
+    {
+        if (mActiveGraph >= mGraphs.size()) return;
+
+        // Compiling the graph creates the programs of its passes. Passes usually set most of their defines right before executing,
+        // so in addition to the pending permutations, the permutations recorded in previous runs of the same graph and scene are
+        // compiled. Programs that passes only create when executing are not covered.
+        RenderGraph* pGraph = mGraphs[mActiveGraph].pGraph.get();
+        pGraph->compile(getRenderContext());
+
+        ProgramManager* pProgramManager = getDevice()->getProgramManager();
+        auto permutations = pProgramManager->findPermutations(loadProgramPermutations(getProgramPermutationsPath(pGraph, mpScene.get())));
+        auto pendingPermutations = pProgramManager->getPendingPermutations();
+        permutations.insert(permutations.end(), pendingPermutations.begin(), pendingPermutations.end());
+        pProgramManager->prewarmPrograms(permutations);
+    }
+
+    void Renderer::recordProgramPermutations()
+    {
+        // Permutations compiled on demand are attributed to the graph and scene that were active since the last call.
+        ProgramManager* pProgramManager = getDevice()->getProgramManager();
+        auto records = pProgramManager->takeRecordedPermutations();
+        if (records.empty() || mActiveGraph >= mGraphs.size()) return;
+
+        auto path = getProgramPermutationsPath(mGraphs[mActiveGraph].pGraph.get(), mpScene.get());
+        auto allRecords = loadProgramPermutations(path);
+        for (auto& record : records)
+        {
+            auto isSame = [&](const PermutationRecord& r) { return r.programDesc == record.programDesc && r.defines == record.defines; };
+            if (std::none_of(allRecords.begin(), allRecords.end(), isSame)) allRecords.push_back(std::move(record));
+        }
+        saveProgramPermutations(path, allRecords);
+    }
+
     void Renderer::beginFrame(RenderContext* pRenderContext, const ref<Fbo>& pTargetFbo)
     {
         for (auto& pe : mpExtensions)  pe->beginFrame(pRenderContext, pTargetFbo);
@@ -169,6 +169,8 @@ namespace Mogwai
         void setScene(const ref<Scene>& pScene);
         ref<Scene> getScene() const;
         void executeActiveGraph(RenderContext* pRenderContext);
+        void prewarmPrograms();
+        void recordProgramPermutations();
         void beginFrame(RenderContext* pRenderContext, const ref<Fbo>& pTargetFbo);
         void endFrame(RenderContext* pRenderContext, const ref<Fbo>& pTargetFbo);
 
@@ -50,6 +50,7 @@ namespace Mogwai
         const std::string kKeyCallback = "keyCallback";
         const std::string kResizeFrameBuffer = "resizeFrameBuffer";
         const std::string kRenderFrame = "renderFrame";
+        const std::string kPrewarmPrograms = "prewarmPrograms";
         const std::string kActiveGraph = "activeGraph";
         const std::string kScene = "scene";
         const std::string kClock = "clock";
@@ -145,6 +146,7 @@ namespace Mogwai
 
         auto renderFrame = [](Renderer* pRenderer) { pRenderer->getProgressBar().close(); pRenderer->renderFrame(); };
         renderer.def(kRenderFrame.c_str(), renderFrame);
+        renderer.def(kPrewarmPrograms.c_str(), &Renderer::prewarmPrograms);
 
         renderer.def_property_readonly(kScene.c_str(), &Renderer::getScene);
         renderer.def_property_readonly(kActiveGraph.c_str(), &Renderer::getActiveGraph);
@@ -0,0 +1,338 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Core/Platform/OS.h"
+#include "Core/Program/KernelCache.h"
+#include "Core/Program/ProgramManager.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace Falcor
+{
+namespace
+{
+KernelCache::Key createKey(uint32_t index)
+{
+    return SHA1::compute(&index, sizeof(index));
+}
+
+std::vector<uint8_t> createData(uint32_t index, size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = uint8_t(index * 31 + i);
+    return data;
+}
+
+std::filesystem::path getEntryPath(const KernelCache& cache, const KernelCache::Key& key)
+{
+    return cache.getDirectory() / (SHA1::toString(key) + ".kernel");
+}
+
+std::filesystem::path createCacheDirectory()
+{
+    std::filesystem::path directory = getTempFilePath();
+    std::filesystem::remove_all(directory);
+    return directory;
+}
+} // namespace
+
+CPU_TEST(KernelCache_SetGet)
+{
+    std::filesystem::path directory = createCacheDirectory();
+    {
+        KernelCache cache(directory, 1024 * 1024);
+        ASSERT(cache.isEnabled());
+
+        EXPECT(!cache.get(createKey(0)));
+
+        auto data = createData(0, 1000);
+        cache.set(createKey(0), data.data(), data.size());
+        auto result = cache.get(createKey(0));
+        ASSERT(result);
+        EXPECT(*result == data);
+
+        // Replace entry.
+        data = createData(1, 500);
+        cache.set(createKey(0), data.data(), data.size());
+        result = cache.get(createKey(0));
+        ASSERT(result);
+        EXPECT(*result == data);
+
+        // Empty entry.
+        cache.set(createKey(1), nullptr, 0);
+        result = cache.get(createKey(1));
+        ASSERT(result);
+        EXPECT(result->empty());
+
+        auto stats = cache.getStats();
+        EXPECT_EQ(stats.hitCount, 3u);
+        EXPECT_EQ(stats.missCount, 1u);
+        EXPECT_EQ(stats.storeCount, 3u);
+        EXPECT_EQ(stats.evictionCount, 0u);
+
+        cache.resetStats();
+        EXPECT_EQ(cache.getStats().hitCount, 0u);
+    }
+
+    // Entries persist across instances.
+    {
+        KernelCache cache(directory, 1024 * 1024);
+        auto result = cache.get(createKey(0));
+        ASSERT(result);
+        EXPECT(*result == createData(1, 500));
+
+        cache.clear();
+        EXPECT_EQ(cache.getSize(), 0u);
+        EXPECT(!cache.get(createKey(0)));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+CPU_TEST(KernelCache_Eviction)
+{
+    std::filesystem::path directory = createCacheDirectory();
+    auto data = createData(0, 100);
+
+    // Determine the size of a single entry including its header.
+    uint64_t entrySize = 0;
+    {
+        KernelCache cache(directory, 1024 * 1024);
+        cache.set(createKey(0), data.data(), data.size());
+        entrySize = cache.getSize();
+        cache.clear();
+    }
+    EXPECT_GT(entrySize, data.size());
+
+    {
+        // Cache with room for three entries.
+        KernelCache cache(directory, 3 * entrySize);
+        for (uint32_t i = 0; i < 3; ++i)
+            cache.set(createKey(i), data.data(), data.size());
+        EXPECT_EQ(cache.getSize(), 3 * entrySize);
+        EXPECT_EQ(cache.getStats().evictionCount, 0u);
+
+        // Make the order of use deterministic, entry 0 is the oldest.
+        auto now = std::filesystem::file_time_type::clock::now();
+        for (uint32_t i = 0; i < 3; ++i)
+            std::filesystem::last_write_time(getEntryPath(cache, createKey(i)), now - std::chrono::hours(3 - i));
+
+        // Using entry 0 makes entry 1 the least recently used one.
+        EXPECT(cache.get(createKey(0)));
+        cache.set(createKey(3), data.data(), data.size());
+
+        EXPECT_EQ(cache.getStats().evictionCount, 1u);
+        EXPECT_EQ(cache.getSize(), 3 * entrySize);
+        EXPECT(cache.get(createKey(0)));
+        EXPECT(!cache.get(createKey(1)));
+        EXPECT(cache.get(createKey(2)));
+        EXPECT(cache.get(createKey(3)));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+CPU_TEST(KernelCache_Open)
+{
+    std::filesystem::path directory = createCacheDirectory();
+    auto data = createData(0, 100);
+
+    uint64_t entrySize = 0;
+    {
+        KernelCache cache(directory, 1024 * 1024);
+        for (uint32_t i = 0; i < 3; ++i)
+            cache.set(createKey(i), data.data(), data.size());
+        entrySize = std::filesystem::file_size(getEntryPath(cache, createKey(0)));
+    }
+
+    // Temporary files of interrupted writes are removed once they are old enough, fresh ones may still be in use.
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::path staleTempPath = directory / "stale.0123456789abcdef.tmp";
+    std::filesystem::path freshTempPath = directory / "fresh.0123456789abcdef.tmp";
+    std::ofstream(staleTempPath) << "stale";
+    std::ofstream(freshTempPath) << "fresh";
+    std::filesystem::last_write_time(staleTempPath, now - 2 * KernelCache::kStaleTempFileAge);
+
+    {
+        // Existing entries are accounted for when the cache is opened.
+        KernelCache cache(directory, 3 * entrySize);
+        EXPECT_EQ(cache.getSize(), 3 * entrySize);
+        EXPECT(!std::filesystem::exists(staleTempPath));
+        EXPECT(std::filesystem::exists(freshTempPath));
+
+        // Make entry 0 the least recently used one, then use it from another instance.
+        for (uint32_t i = 0; i < 3; ++i)
+            std::filesystem::last_write_time(getEntryPath(cache, createKey(i)), now - std::chrono::hours(3 - i));
+        KernelCache other(directory, 3 * entrySize);
+        EXPECT(other.get(createKey(0)));
+
+        // Evicting skips entry 0 as it was used by the other instance since this instance last saw it.
+        cache.set(createKey(3), data.data(), data.size());
+        EXPECT_EQ(cache.getStats().evictionCount, 1u);
+        EXPECT_EQ(cache.getSize(), 3 * entrySize);
+        EXPECT(cache.get(createKey(0)));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+CPU_TEST(KernelCache_Corruption)
+{
+    std::filesystem::path directory = createCacheDirectory();
+    {
+        KernelCache cache(directory, 1024 * 1024);
+        auto data = createData(0, 1000);
+
+        // Truncated entry.
+        cache.set(createKey(0), data.data(), data.size());
+        std::filesystem::path path = getEntryPath(cache, createKey(0));
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        EXPECT(!cache.get(createKey(0)));
+        EXPECT(!std::filesystem::exists(path));
+
+        // Modified entry.
+        cache.set(createKey(0), data.data(), data.size());
+        {
+            std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekp(-1, std::ios::end);
+            fs.put(char(data.back() + 1));
+        }
+        EXPECT(!cache.get(createKey(0)));
+        EXPECT(!std::filesystem::exists(path));
+
+        // Entry with a size in the header that doesn't match the file size.
+        cache.set(createKey(0), data.data(), data.size());
+        {
+            std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+            const uint64_t size = std::numeric_limits<uint64_t>::max();
+            fs.seekp(8); // Offset of the size in the entry header.
+            fs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        }
+        EXPECT(!cache.get(createKey(0)));
+        EXPECT(!std::filesystem::exists(path));
+
+        // Recovers after storing the entry again.
+        cache.set(createKey(0), data.data(), data.size());
+        auto result = cache.get(createKey(0));
+        ASSERT(result);
+        EXPECT(*result == data);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+CPU_TEST(KernelCache_Concurrency)
+{
+    std::filesystem::path directory = createCacheDirectory();
+    const uint32_t kThreadCount = 8;
+    const uint32_t kKeyCount = 16;
+    const uint32_t kIterationCount = 200;
+
+    // Each thread uses its own cache instance to emulate multiple processes sharing the cache directory.
+    // The size limit is small enough to trigger evictions.
+    std::atomic<uint32_t> errorCount = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kThreadCount; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                KernelCache cache(directory, kKeyCount * 1000);
+                std::mt19937 rng(t);
+                for (uint32_t i = 0; i < kIterationCount; ++i)
+                {
+                    uint32_t index = rng() % kKeyCount;
+                    auto data = createData(index, 100 + index * 10);
+                    if (auto result = cache.get(createKey(index)))
+                    {
+                        if (*result != data)
+                            errorCount++;
+                    }
+                    else
+                    {
+                        cache.set(createKey(index), data.data(), data.size());
+                    }
+                }
+            }
+        );
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(errorCount.load(), 0u);
+
+    // No temporary files are left behind.
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+        EXPECT(entry.path().extension() != ".tmp") << entry.path().string();
+
+    std::filesystem::remove_all(directory);
+}
+
+GPU_TEST(KernelCache_ProgramManager)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    KernelCache* pKernelCache = pDevice->getProgramManager()->getKernelCache();
+    if (!pKernelCache)
+        throw SkippingTestException("Kernel cache is disabled");
+
+    // Use a unique shader so that the first compilation is not served from the cache of a previous run.
+    std::string source = fmt::format(
+        "RWStructuredBuffer<uint> result;\n"
+        "[numthreads(1, 1, 1)] void main() {{ result[0] = {}u; }}\n",
+        std::random_device{}()
+    );
+
+    auto getBlobSize = [&]()
+    {
+        Program::Desc desc;
+        desc.addShaderString(source, "KernelCacheTest");
+        desc.csEntry("main");
+        ref<ComputeProgram> pProgram = ComputeProgram::create(pDevice, desc);
+        ref<ComputeVars> pVars = ComputeVars::create(pDevice, pProgram.get());
+        auto pKernels = pProgram->getActiveVersion()->getKernels(pDevice.get(), pVars.get());
+        return pKernels->getShader(ShaderType::Compute)->getBlobData().size;
+    };
+
+    pKernelCache->resetStats();
+
+    size_t size = getBlobSize();
+    EXPECT_GT(size, 0u);
+    EXPECT_EQ(pKernelCache->getStats().missCount, 1u);
+    EXPECT_EQ(pKernelCache->getStats().storeCount, 1u);
+
+    // Compiling the same program again is served from the cache.
+    EXPECT_EQ(getBlobSize(), size);
+    EXPECT_EQ(pKernelCache->getStats().hitCount, 1u);
+    EXPECT_EQ(pKernelCache->getStats().storeCount, 1u);
+}
+
+} // namespace Falcor
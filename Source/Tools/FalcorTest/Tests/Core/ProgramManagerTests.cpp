@@ -0,0 +1,150 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Core/Program/ProgramManager.h"
+#include <algorithm>
+
+namespace Falcor
+{
+namespace
+{
+const char kShaderFile[] = "Tests/Core/ProgramManagerTests.cs.slang";
+const uint32_t kPermutationCount = 8;
+} // namespace
+
+GPU_TEST(ProgramManager_Prewarm)
+{
+    ProgramManager* pProgramManager = ctx.getDevice()->getProgramManager();
+
+    ctx.createProgram(kShaderFile, "main", {{"VALUE", "0"}});
+    ref<ComputeProgram> pProgram(ctx.getProgram());
+
+    // Permutation 0 is already compiled and duplicates are skipped.
+    std::vector<ProgramManager::ProgramPermutation> permutations;
+    for (uint32_t i = 0; i < kPermutationCount; ++i)
+        permutations.push_back({pProgram, {{"VALUE", std::to_string(i)}}});
+    permutations.push_back(permutations[1]);
+
+    size_t versionCount = pProgramManager->getCompilationStats().programVersionCount;
+    pProgramManager->prewarmPrograms(permutations);
+    EXPECT_EQ(pProgramManager->getCompilationStats().programVersionCount, versionCount + kPermutationCount - 1);
+
+    // Prewarming again does nothing.
+    pProgramManager->prewarmPrograms(permutations);
+    EXPECT_EQ(pProgramManager->getCompilationStats().programVersionCount, versionCount + kPermutationCount - 1);
+
+    // Using the prewarmed permutations doesn't compile them again.
+    versionCount = pProgramManager->getCompilationStats().programVersionCount;
+    for (uint32_t i = 0; i < kPermutationCount; ++i)
+    {
+        pProgram->addDefine("VALUE", std::to_string(i));
+        ctx.createVars();
+        ctx.allocateStructuredBuffer("result", 1);
+        ctx.runProgram();
+
+        const uint32_t* pResult = ctx.mapBuffer<const uint32_t>("result");
+        EXPECT_EQ(pResult[0], i);
+        ctx.unmapBuffer("result");
+    }
+    EXPECT_EQ(pProgramManager->getCompilationStats().programVersionCount, versionCount);
+}
+
+GPU_TEST(ProgramManager_PendingPermutations)
+{
+    ProgramManager* pProgramManager = ctx.getDevice()->getProgramManager();
+
+    ctx.createProgram(kShaderFile, "main", {{"VALUE", "0"}});
+    ref<ComputeProgram> pProgram(ctx.getProgram());
+
+    auto isPending = [&]()
+    {
+        for (const auto& permutation : pProgramManager->getPendingPermutations())
+            if (permutation.pProgram == pProgram)
+                return true;
+        return false;
+    };
+
+    EXPECT(!isPending());
+
+    pProgram->addDefine("VALUE", "1");
+    EXPECT(isPending());
+
+    pProgramManager->prewarmPrograms(pProgramManager->getPendingPermutations());
+    EXPECT(!isPending());
+}
+
+GPU_TEST(ProgramManager_RecordedPermutations)
+{
+    ProgramManager* pProgramManager = ctx.getDevice()->getProgramManager();
+    pProgramManager->takeRecordedPermutations();
+
+    auto run = [&](ref<ComputeProgram> pProgram, uint32_t value)
+    {
+        pProgram->addDefine("VALUE", std::to_string(value));
+        ctx.createVars();
+        ctx.allocateStructuredBuffer("result", 1);
+        ctx.runProgram();
+
+        const uint32_t* pResult = ctx.mapBuffer<const uint32_t>("result");
+        EXPECT_EQ(pResult[0], value);
+        ctx.unmapBuffer("result");
+    };
+
+    // Defines that are only set right before executing are recorded when the permutation is compiled on demand.
+    ctx.createProgram(kShaderFile, "main", {{"VALUE", "0"}});
+    ref<ComputeProgram> pProgram(ctx.getProgram());
+    run(pProgram, 100);
+
+    auto records = pProgramManager->takeRecordedPermutations();
+    auto isRecorded = [&](const std::string& value)
+    {
+        return std::any_of(
+            records.begin(),
+            records.end(),
+            [&](const auto& record)
+            { return record.programDesc == pProgram->getProgramDescString() && record.defines == Program::DefineList{{"VALUE", value}}; }
+        );
+    };
+    EXPECT(isRecorded("0"));
+    EXPECT(isRecorded("100"));
+    EXPECT(pProgramManager->takeRecordedPermutations().empty());
+
+    // The records match a new instance of the program. Prewarming them avoids compiling on demand.
+    ctx.createProgram(kShaderFile, "main", {{"VALUE", "0"}}, Shader::CompilerFlags::None, "", false);
+    ref<ComputeProgram> pNewProgram(ctx.getProgram());
+    auto permutations = pProgramManager->findPermutations(records);
+    EXPECT_EQ(std::count_if(permutations.begin(), permutations.end(), [&](const auto& p) { return p.pProgram == pNewProgram; }), 2);
+    pProgramManager->prewarmPrograms(permutations);
+
+    size_t versionCount = pProgramManager->getCompilationStats().programVersionCount;
+    run(pNewProgram, 100);
+    EXPECT_EQ(pProgramManager->getCompilationStats().programVersionCount, versionCount);
+    EXPECT(pProgramManager->takeRecordedPermutations().empty());
+}
+
+} // namespace Falcor
@@ -0,0 +1,163 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "RenderGraph/RenderGraph.h"
+
+namespace Falcor
+{
+namespace
+{
+/**
+ * Pass that does nothing but count how often it is compiled.
+ */
+class CompileCountPass : public RenderPass
+{
+public:
+    FALCOR_PLUGIN_CLASS(CompileCountPass, "CompileCountPass", "Test pass counting compilations.");
+
+    CompileCountPass(ref<Device> pDevice) : RenderPass(pDevice) {}
+
+    RenderPassReflection reflect(const CompileData& compileData) override
+    {
+        RenderPassReflection reflector;
+        reflector.addInput("src", "Source").flags(RenderPassReflection::Field::Flags::Optional).texture2D(16, 16);
+        reflector.addOutput("dst", "Destination").format(mFormat).texture2D(16, 16);
+        return reflector;
+    }
+
+    void compile(RenderContext* pRenderContext, const CompileData& compileData) override { compileCount++; }
+
+    void execute(RenderContext* pRenderContext, const RenderData& renderData) override {}
+
+    void setFormat(ResourceFormat format)
+    {
+        mFormat = format;
+        requestRecompile();
+    }
+
+    void touch() { requestRecompile(); }
+
+    uint32_t compileCount = 0;
+
+private:
+    ResourceFormat mFormat = ResourceFormat::RGBA32Float;
+};
+} // namespace
+
+GPU_TEST(RenderGraph_IncrementalCompile)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = pDevice->getRenderContext();
+
+    auto pA = make_ref<CompileCountPass>(pDevice);
+    auto pB = make_ref<CompileCountPass>(pDevice);
+    auto pC = make_ref<CompileCountPass>(pDevice);
+
+    auto pGraph = RenderGraph::create(pDevice, "IncrementalCompile");
+    pGraph->addPass(pA, "A");
+    pGraph->addPass(pB, "B");
+    pGraph->addPass(pC, "C");
+    pGraph->addEdge("A.dst", "B.src");
+    pGraph->addEdge("B.dst", "C.src");
+    pGraph->markOutput("C.dst");
+
+    auto compile = [&]()
+    {
+        pA->compileCount = pB->compileCount = pC->compileCount = 0;
+        EXPECT(pGraph->compile(pRenderContext));
+    };
+
+    // Initial compilation compiles all passes.
+    compile();
+    EXPECT_EQ(pA->compileCount, 1u);
+    EXPECT_EQ(pB->compileCount, 1u);
+    EXPECT_EQ(pC->compileCount, 1u);
+    ref<Resource> pOutput = pGraph->getOutput("C.dst");
+    EXPECT(pOutput != nullptr);
+
+    // A pass requesting a recompile without changing its reflection only compiles that pass.
+    pB->touch();
+    compile();
+    EXPECT_EQ(pA->compileCount, 0u);
+    EXPECT_EQ(pB->compileCount, 1u);
+    EXPECT_EQ(pC->compileCount, 0u);
+    EXPECT(pGraph->getOutput("C.dst") == pOutput);
+
+    // Changing the output of A affects the connected resources of A and B only.
+    pA->setFormat(ResourceFormat::RGBA16Float);
+    compile();
+    EXPECT_EQ(pA->compileCount, 1u);
+    EXPECT_EQ(pB->compileCount, 1u);
+    EXPECT_EQ(pC->compileCount, 0u);
+    EXPECT(pGraph->getOutput("C.dst") == pOutput);
+
+    // Changing the graph output recreates its resource. The input of C is unchanged, so B is not affected.
+    pC->setFormat(ResourceFormat::RGBA16Float);
+    compile();
+    EXPECT_EQ(pA->compileCount, 0u);
+    EXPECT_EQ(pB->compileCount, 0u);
+    EXPECT_EQ(pC->compileCount, 1u);
+    EXPECT(pGraph->getOutput("C.dst") != pOutput);
+    EXPECT_EQ(pGraph->getOutput("C.dst")->asTexture()->getFormat(), ResourceFormat::RGBA16Float);
+
+    // Edge changes only affect the passes they connect.
+    pGraph->removeEdge("B.dst", "C.src");
+    compile();
+    EXPECT_EQ(pA->compileCount, 0u);
+    EXPECT_EQ(pB->compileCount, 0u);
+    EXPECT_EQ(pC->compileCount, 1u);
+}
+
+GPU_TEST(RenderGraph_ResourceAliasing)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = pDevice->getRenderContext();
+
+    // In a chain of four passes, the outputs of A and C have non-overlapping lifetimes and can share memory.
+    auto pGraph = RenderGraph::create(pDevice, "ResourceAliasing");
+    for (const char* name : {"A", "B", "C", "D"})
+        pGraph->addPass(make_ref<CompileCountPass>(pDevice), name);
+    pGraph->addEdge("A.dst", "B.src");
+    pGraph->addEdge("B.dst", "C.src");
+    pGraph->addEdge("C.dst", "D.src");
+    pGraph->markOutput("D.dst");
+
+    EXPECT(pGraph->isResourceAliasingEnabled());
+    EXPECT(pGraph->compile(pRenderContext));
+    const auto& aliased = pGraph->getResourceAliasingStats();
+    EXPECT_LT(aliased.slotCount, aliased.requestCount);
+    EXPECT_LT(aliased.allocatedBytes, aliased.summedBytes);
+
+    // Disabling aliasing recompiles the graph with one allocation per resource.
+    pGraph->setResourceAliasingEnabled(false);
+    EXPECT(pGraph->compile(pRenderContext));
+    const auto& separate = pGraph->getResourceAliasingStats();
+    EXPECT_EQ(separate.slotCount, separate.requestCount);
+    EXPECT_EQ(separate.allocatedBytes, separate.summedBytes);
+}
+} // namespace Falcor
@@ -0,0 +1,156 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "RenderGraph/ResourceAliasingPlanner.h"
+#include <algorithm>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+using Request = ResourceAliasingPlanner::Request;
+
+Request makeRequest(uint32_t firstUse, uint32_t lastUse, uint64_t sizeInBytes, uint32_t group = 0, bool exclusive = false)
+{
+    Request request;
+    request.firstUse = firstUse;
+    request.lastUse = lastUse;
+    request.sizeInBytes = sizeInBytes;
+    request.group = group;
+    request.exclusive = exclusive;
+    return request;
+}
+
+bool overlaps(const Request& a, const Request& b)
+{
+    return a.firstUse <= b.lastUse && b.firstUse <= a.lastUse;
+}
+} // namespace
+
+CPU_TEST(ResourceAliasingPlanner_Chain)
+{
+    // Each resource is produced by one pass and consumed by the next.
+    std::vector<Request> requests = {
+        makeRequest(0, 1, 100),
+        makeRequest(1, 2, 100),
+        makeRequest(2, 3, 100),
+        makeRequest(3, 4, 100),
+    };
+    auto plan = ResourceAliasingPlanner::plan(requests);
+
+    EXPECT_EQ(plan.stats.requestCount, 4u);
+    EXPECT_EQ(plan.stats.slotCount, 2u);
+    EXPECT_EQ(plan.slots[0], plan.slots[2]);
+    EXPECT_EQ(plan.slots[1], plan.slots[3]);
+    EXPECT_NE(plan.slots[0], plan.slots[1]);
+    EXPECT_EQ(plan.stats.summedBytes, 400u);
+    EXPECT_EQ(plan.stats.allocatedBytes, 200u);
+    EXPECT_EQ(plan.stats.peakBytes, 200u);
+}
+
+CPU_TEST(ResourceAliasingPlanner_Constraints)
+{
+    std::vector<Request> requests = {
+        makeRequest(0, 0, 100, 0),
+        makeRequest(1, 1, 100, 1),       // Different group.
+        makeRequest(2, 2, 100, 0, true), // Exclusive.
+        makeRequest(3, 3, 100, 0),
+        makeRequest(4, uint32_t(-1), 100, 0, true), // Graph output.
+    };
+    auto plan = ResourceAliasingPlanner::plan(requests);
+
+    EXPECT_EQ(plan.stats.slotCount, 4u);
+    EXPECT_EQ(plan.slots[0], plan.slots[3]);
+    EXPECT_NE(plan.slots[0], plan.slots[1]);
+    EXPECT_NE(plan.slots[0], plan.slots[2]);
+    EXPECT_NE(plan.slots[0], plan.slots[4]);
+    EXPECT_EQ(plan.stats.summedBytes, 500u);
+    EXPECT_EQ(plan.stats.allocatedBytes, 400u);
+    EXPECT_EQ(plan.stats.peakBytes, 100u);
+}
+
+CPU_TEST(ResourceAliasingPlanner_Random)
+{
+    std::mt19937 rng(1234);
+
+    for (uint32_t iteration = 0; iteration < 100; iteration++)
+    {
+        const uint32_t kPassCount = 32;
+        const uint32_t kGroupCount = 4;
+
+        std::vector<Request> requests(std::uniform_int_distribution<uint32_t>(1, 64)(rng));
+        for (auto& request : requests)
+        {
+            request.firstUse = std::uniform_int_distribution<uint32_t>(0, kPassCount - 1)(rng);
+            request.lastUse = std::uniform_int_distribution<uint32_t>(request.firstUse, kPassCount - 1)(rng);
+            request.group = std::uniform_int_distribution<uint32_t>(0, kGroupCount - 1)(rng);
+            request.sizeInBytes = (request.group + 1) * 1024;
+            request.exclusive = std::uniform_int_distribution<uint32_t>(0, 7)(rng) == 0;
+        }
+        auto plan = ResourceAliasingPlanner::plan(requests);
+        ASSERT_EQ(plan.slots.size(), requests.size());
+
+        // Requests sharing a slot must be compatible and have disjoint lifetimes.
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            for (size_t j = i + 1; j < requests.size(); j++)
+            {
+                if (plan.slots[i] != plan.slots[j])
+                    continue;
+                EXPECT(!requests[i].exclusive && !requests[j].exclusive);
+                EXPECT_EQ(requests[i].group, requests[j].group);
+                EXPECT(!overlaps(requests[i], requests[j]));
+            }
+        }
+
+        // The number of slots is optimal: per group it equals the maximum number of shared requests in use at the same time.
+        uint32_t expectedSlotCount = 0;
+        for (const auto& request : requests)
+            expectedSlotCount += request.exclusive ? 1 : 0;
+        for (uint32_t group = 0; group < kGroupCount; group++)
+        {
+            uint32_t maxInUse = 0;
+            for (uint32_t t = 0; t < kPassCount; t++)
+            {
+                uint32_t inUse = (uint32_t)std::count_if(
+                    requests.begin(),
+                    requests.end(),
+                    [&](const Request& r) { return !r.exclusive && r.group == group && r.firstUse <= t && t <= r.lastUse; }
+                );
+                maxInUse = std::max(maxInUse, inUse);
+            }
+            expectedSlotCount += maxInUse;
+        }
+        EXPECT_EQ(plan.stats.slotCount, expectedSlotCount);
+
+        EXPECT_LE(plan.stats.peakBytes, plan.stats.allocatedBytes);
+        EXPECT_LE(plan.stats.allocatedBytes, plan.stats.summedBytes);
+    }
+}
+} // namespace Falcor
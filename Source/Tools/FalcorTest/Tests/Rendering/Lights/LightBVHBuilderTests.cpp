@@ -0,0 +1,261 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Rendering/Lights/LightBVHBuilder.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+using SplitHeuristic = LightBVHBuilder::SplitHeuristic;
+using TriangleSortData = LightBVHBuilder::TriangleSortData;
+
+/** Synthetic emissive triangles scattered in a box.
+    A fraction of the triangles lies on a common plane to create nodes with zero extent along one axis.
+*/
+std::vector<TriangleSortData> createTriangles(uint32_t triangleCount)
+{
+    std::mt19937 rng(triangleCount);
+    std::uniform_real_distribution<float> u;
+
+    std::vector<TriangleSortData> triangles(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        float3 p = float3(u(rng), u(rng), u(rng)) * 100.f;
+        if (u(rng) < 0.3f)
+            p.y = 5.f;
+
+        TriangleSortData& tri = triangles[i];
+        float3 center(0.f);
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            float3 v = p + float3(u(rng), u(rng), u(rng)) * 0.5f;
+            tri.bounds |= v;
+            center += v;
+        }
+        tri.center = center / 3.f;
+        tri.coneDirection = normalize(float3(u(rng) - 0.5f, u(rng) - 0.5f, u(rng) - 0.5f));
+        tri.cosConeAngle = 1.f;
+        tri.flux = 0.1f + u(rng) * 10.f;
+        tri.triangleIndex = i;
+    }
+    return triangles;
+}
+
+/** Check that the BVH is a valid tree over all triangles.
+    Leaves are expected in depth-first order with contiguous triangle ranges, and the triangle bitmasks must match the
+    traversal path to the leaves.
+*/
+void validateBVH(CPUUnitTestContext& ctx, const LightBVHBuilder::BuildResult& result, uint32_t triangleCount, uint32_t maxTriangleCountPerLeaf)
+{
+    ASSERT(!result.nodes.empty());
+    ASSERT_EQ(result.triangleIndices.size(), triangleCount);
+    ASSERT_EQ(result.triangleBitmasks.size(), triangleCount);
+
+    std::vector<bool> visited(triangleCount, false);
+    uint32_t nextTriangleOffset = 0;
+    uint32_t leafCount = 0;
+
+    struct StackEntry
+    {
+        uint32_t nodeIndex;
+        uint32_t depth;
+        uint64_t bitmask;
+    };
+    std::vector<StackEntry> stack = {{0, 0, 0}};
+    while (!stack.empty())
+    {
+        StackEntry entry = stack.back();
+        stack.pop_back();
+        ASSERT_LT(entry.nodeIndex, result.nodes.size());
+        const PackedNode& node = result.nodes[entry.nodeIndex];
+
+        if (node.isLeaf())
+        {
+            LeafNode leaf = node.getLeafNode();
+            EXPECT_GT(leaf.triangleCount, 0u);
+            EXPECT_LE(leaf.triangleCount, maxTriangleCountPerLeaf);
+            EXPECT_EQ(leaf.triangleOffset, nextTriangleOffset);
+            nextTriangleOffset = leaf.triangleOffset + leaf.triangleCount;
+            ASSERT_LE(nextTriangleOffset, triangleCount);
+
+            for (uint32_t i = leaf.triangleOffset; i < leaf.triangleOffset + leaf.triangleCount; i++)
+            {
+                uint32_t triangleIndex = result.triangleIndices[i];
+                ASSERT_LT(triangleIndex, triangleCount);
+                EXPECT(!visited[triangleIndex]);
+                visited[triangleIndex] = true;
+                EXPECT_EQ(result.triangleBitmasks[triangleIndex], entry.bitmask);
+            }
+            leafCount++;
+        }
+        else
+        {
+            InternalNode internal = node.getInternalNode();
+            EXPECT_GT(internal.rightChildIdx, entry.nodeIndex + 1);
+            // Push the right child first so that the left subtree is visited first.
+            stack.push_back({internal.rightChildIdx, entry.depth + 1, entry.bitmask | (1ull << entry.depth)});
+            stack.push_back({entry.nodeIndex + 1, entry.depth + 1, entry.bitmask});
+        }
+    }
+
+    EXPECT_EQ(nextTriangleOffset, triangleCount);
+    EXPECT_EQ(result.nodes.size(), 2 * leafCount - 1);
+}
+
+/** Check that a BVH is identical to a reference BVH, node for node.
+*/
+void compareBVH(CPUUnitTestContext& ctx, const LightBVHBuilder::BuildResult& result, const LightBVHBuilder::BuildResult& reference)
+{
+    ASSERT_EQ(result.nodes.size(), reference.nodes.size());
+    for (size_t i = 0; i < result.nodes.size(); i++)
+    {
+        // Report the first differing node only, as all following nodes usually differ too.
+        if (std::memcmp(&result.nodes[i], &reference.nodes[i], sizeof(PackedNode)) != 0)
+        {
+            EXPECT(false) << "Node " << i << " differs from the reference (leaf=" << result.nodes[i].isLeaf() << ")";
+            break;
+        }
+    }
+    EXPECT(result.triangleIndices == reference.triangleIndices);
+    EXPECT(result.triangleBitmasks == reference.triangleBitmasks);
+}
+} // namespace
+
+CPU_TEST(LightBVHBuilder_Build)
+{
+    LightBVHBuilder::Options splitOptions;
+    splitOptions.maxTriangleCountPerLeaf = 4;
+    splitOptions.splitAlongLargest = true;
+    splitOptions.useVolumeOverSA = true;
+
+    // The larger count builds subtrees and bins the top-level nodes in parallel.
+    for (uint32_t triangleCount : {1u, 100u, 200000u})
+    {
+        const auto triangles = createTriangles(triangleCount);
+        for (SplitHeuristic heuristic : {SplitHeuristic::Equal, SplitHeuristic::BinnedSAH, SplitHeuristic::BinnedSAOH})
+        {
+            for (LightBVHBuilder::Options options : {LightBVHBuilder::Options{}, splitOptions})
+            {
+                options.splitHeuristicSelection = heuristic;
+                LightBVHBuilder builder(options);
+
+                auto result = builder.buildNodes(triangles, triangleCount);
+                validateBVH(ctx, result, triangleCount, options.maxTriangleCountPerLeaf);
+
+                // The parallel build must match the serial reference build.
+                compareBVH(ctx, result, builder.buildNodes(triangles, triangleCount, false));
+            }
+        }
+    }
+}
+
+CPU_TEST(LightBVHBuilder_Empty)
+{
+    LightBVHBuilder builder(LightBVHBuilder::Options{});
+    auto result = builder.buildNodes({}, 0);
+    EXPECT(result.nodes.empty());
+    EXPECT(result.triangleIndices.empty());
+}
+
+CPU_TEST(LightBVHBuilder_EvalCost)
+{
+    const uint32_t triangleCount = 10000;
+    auto triangles = createTriangles(triangleCount);
+    LightBVHBuilder builder(LightBVHBuilder::Options{});
+    const auto result = builder.buildNodes(triangles, triangleCount);
+
+    // No node costs more than the root node.
+    const float cost = builder.evalCost(result.nodes);
+    EXPECT_GE(cost, 1.f);
+    EXPECT_LE(cost, (float)result.nodes.size());
+    EXPECT_EQ(builder.evalCost(fstd::span<const PackedNode>()), 0.f);
+
+    // Scatter some of the lights and refit the bounds without changing the hierarchy.
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> u;
+    for (uint32_t i = 0; i < triangleCount; i += 4)
+    {
+        const float3 offset = float3(u(rng) - 0.5f, u(rng) - 0.5f, u(rng) - 0.5f) * 50.f;
+        triangles[i].bounds = AABB(triangles[i].bounds.minPoint + offset, triangles[i].bounds.maxPoint + offset);
+        triangles[i].center += offset;
+    }
+
+    std::vector<PackedNode> nodes = result.nodes;
+    for (uint32_t nodeIndex = (uint32_t)nodes.size(); nodeIndex-- > 0;)
+    {
+        // Children are stored after their parent, so they are refit first.
+        AABB bounds;
+        SharedNodeAttributes attribs = nodes[nodeIndex].getNodeAttributes();
+        if (nodes[nodeIndex].isLeaf())
+        {
+            LeafNode leaf = nodes[nodeIndex].getLeafNode();
+            for (uint32_t i = leaf.triangleOffset; i < leaf.triangleOffset + leaf.triangleCount; i++)
+                bounds |= triangles[result.triangleIndices[i]].bounds;
+        }
+        else
+        {
+            for (uint32_t childIndex : {nodeIndex + 1, nodes[nodeIndex].getInternalNode().rightChildIdx})
+            {
+                float3 aabbMin, aabbMax;
+                nodes[childIndex].getNodeAttributes().getAABB(aabbMin, aabbMax);
+                bounds |= AABB(aabbMin, aabbMax);
+            }
+        }
+        attribs.setAABB(bounds.minPoint, bounds.maxPoint);
+        nodes[nodeIndex].setNodeAttributes(attribs);
+    }
+
+    // The refit tree is worse than the original one, and a rebuild over the moved lights is better than the refit tree.
+    const float refitCost = builder.evalCost(nodes);
+    EXPECT_GT(refitCost, cost);
+    EXPECT_LT(builder.evalCost(builder.buildNodes(triangles, triangleCount).nodes), refitCost);
+}
+
+CPU_TEST(LightBVHBuilder_Benchmark, "Disabled for performance reasons")
+{
+    const uint32_t triangleCount = 4000000;
+    const auto triangles = createTriangles(triangleCount);
+    for (SplitHeuristic heuristic : {SplitHeuristic::Equal, SplitHeuristic::BinnedSAH, SplitHeuristic::BinnedSAOH})
+    {
+        LightBVHBuilder::Options options;
+        options.splitHeuristicSelection = heuristic;
+        LightBVHBuilder builder(options);
+
+        CpuTimer timer;
+        timer.update();
+        auto result = builder.buildNodes(triangles, triangleCount);
+        timer.update();
+        logInfo("LightBVHBuilder heuristic {}: {} triangles, {} nodes in {:.1f} ms", (int)heuristic, triangleCount, result.nodes.size(), timer.delta() * 1000.0);
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,299 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Rendering/Lights/LightBVHBuilder.h"
+#include "Rendering/Lights/LightBVHRefitPlanner.h"
+
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+using TriangleSortData = LightBVHBuilder::TriangleSortData;
+using TriangleRange = LightBVHRefitPlanner::TriangleRange;
+
+const uint32_t kTriangleCount = 20000;
+
+std::vector<TriangleSortData> createTriangles(uint32_t triangleCount)
+{
+    std::mt19937 rng(triangleCount);
+    std::uniform_real_distribution<float> u;
+
+    std::vector<TriangleSortData> triangles(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        float3 p = float3(u(rng), u(rng), u(rng)) * 100.f;
+        TriangleSortData& tri = triangles[i];
+        tri.bounds = AABB(p, p + float3(u(rng), u(rng), u(rng)));
+        tri.center = tri.bounds.center();
+        tri.coneDirection = normalize(float3(u(rng) - 0.5f, u(rng) - 0.5f, u(rng) - 0.5f));
+        tri.flux = 0.1f + u(rng);
+        tri.triangleIndex = i;
+    }
+    return triangles;
+}
+
+/** Recompute the bounds of a node from its triangles or children, like the refit kernels do.
+*/
+void refitNode(std::vector<PackedNode>& nodes, uint32_t nodeIndex, const std::vector<uint32_t>& triangleIndices, const std::vector<TriangleSortData>& triangles)
+{
+    PackedNode& node = nodes[nodeIndex];
+    AABB bounds;
+    if (node.isLeaf())
+    {
+        LeafNode leaf = node.getLeafNode();
+        for (uint32_t i = leaf.triangleOffset; i < leaf.triangleOffset + leaf.triangleCount; i++)
+            bounds |= triangles[triangleIndices[i]].bounds;
+        leaf.attribs.setAABB(bounds.minPoint, bounds.maxPoint);
+        node.setLeafNode(leaf);
+    }
+    else
+    {
+        InternalNode internal = node.getInternalNode();
+        for (uint32_t childIndex : {nodeIndex + 1, internal.rightChildIdx})
+        {
+            float3 aabbMin, aabbMax;
+            SharedNodeAttributes attribs = nodes[childIndex].getNodeAttributes();
+            attribs.getAABB(aabbMin, aabbMax);
+            bounds |= AABB(aabbMin, aabbMax);
+        }
+        internal.attribs.setAABB(bounds.minPoint, bounds.maxPoint);
+        node.setInternalNode(internal);
+    }
+}
+
+/** Refit all nodes. Children are stored after their parent, so the nodes are processed in reverse order.
+*/
+void refitAll(std::vector<PackedNode>& nodes, const std::vector<uint32_t>& triangleIndices, const std::vector<TriangleSortData>& triangles)
+{
+    for (uint32_t nodeIndex = (uint32_t)nodes.size(); nodeIndex-- > 0;)
+        refitNode(nodes, nodeIndex, triangleIndices, triangles);
+}
+
+/** Refit the nodes of a plan in the order used by LightBVH::refit(): all leaves, then the internal nodes from the deepest level up.
+*/
+void refitPlan(
+    std::vector<PackedNode>& nodes,
+    const LightBVHRefitPlanner::Plan& plan,
+    const std::vector<uint32_t>& triangleIndices,
+    const std::vector<TriangleSortData>& triangles
+)
+{
+    for (size_t depth = plan.perDepthRefitEntryInfo.size(); depth-- > 0;)
+    {
+        const auto& info = plan.perDepthRefitEntryInfo[depth];
+        for (uint32_t i = info.offset; i < info.offset + info.count; i++)
+            refitNode(nodes, plan.nodeIndices[i], triangleIndices, triangles);
+    }
+}
+
+/** Compute the depth of each node and the set of nodes to refit by traversing the tree.
+*/
+void findDirtyNodes(
+    const LightBVHBuilder::BuildResult& bvh,
+    const std::vector<bool>& movedTriangles,
+    std::vector<uint32_t>& depths,
+    std::vector<bool>& dirtyNodes
+)
+{
+    depths.assign(bvh.nodes.size(), 0);
+    dirtyNodes.assign(bvh.nodes.size(), false);
+
+    std::vector<uint32_t> path;
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 0}};
+    while (!stack.empty())
+    {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+        depths[nodeIndex] = depth;
+        path.resize(depth);
+        path.push_back(nodeIndex);
+
+        const PackedNode& node = bvh.nodes[nodeIndex];
+        if (node.isLeaf())
+        {
+            LeafNode leaf = node.getLeafNode();
+            for (uint32_t i = leaf.triangleOffset; i < leaf.triangleOffset + leaf.triangleCount; i++)
+            {
+                if (movedTriangles[bvh.triangleIndices[i]])
+                {
+                    for (uint32_t pathNodeIndex : path)
+                        dirtyNodes[pathNodeIndex] = true;
+                }
+            }
+        }
+        else
+        {
+            stack.push_back({node.getInternalNode().rightChildIdx, depth + 1});
+            stack.push_back({nodeIndex + 1, depth + 1});
+        }
+    }
+}
+} // namespace
+
+CPU_TEST(LightBVHRefitPlanner_Plan)
+{
+    const auto triangles = createTriangles(kTriangleCount);
+    LightBVHBuilder builder(LightBVHBuilder::Options{});
+    const auto bvh = builder.buildNodes(triangles, kTriangleCount);
+
+    LightBVHRefitPlanner planner;
+    planner.setTree(bvh.nodes, bvh.triangleIndices, kTriangleCount);
+    ASSERT_EQ(planner.getNodeCount(), bvh.nodes.size());
+    EXPECT_EQ(planner.getParent(0), LightBVHRefitPlanner::kInvalidIndex);
+
+    const std::vector<std::vector<TriangleRange>> testCases = {
+        {{1234, 1}},
+        {{0, 10}, {5000, 100}, {19990, 10}},
+        {{100, 50}, {120, 50}}, // Overlapping ranges.
+        {{0, kTriangleCount}},
+    };
+
+    for (const auto& ranges : testCases)
+    {
+        std::vector<bool> movedTriangles(kTriangleCount, false);
+        for (const auto& range : ranges)
+        {
+            for (uint32_t i = range.offset; i < range.offset + range.count; i++)
+                movedTriangles[i] = true;
+        }
+
+        std::vector<uint32_t> depths;
+        std::vector<bool> expectedNodes;
+        findDirtyNodes(bvh, movedTriangles, depths, expectedNodes);
+
+        const auto plan = planner.plan(ranges);
+        ASSERT_EQ(plan.perDepthRefitEntryInfo.size(), planner.getTreeHeight() + 1);
+
+        // Each affected node is listed exactly once, at its depth. Leaves are listed last.
+        std::vector<bool> plannedNodes(bvh.nodes.size(), false);
+        uint32_t offset = 0;
+        for (size_t depth = 0; depth < plan.perDepthRefitEntryInfo.size(); depth++)
+        {
+            const auto& info = plan.perDepthRefitEntryInfo[depth];
+            EXPECT_EQ(info.offset, offset);
+            offset += info.count;
+            ASSERT_LE(offset, plan.nodeIndices.size());
+
+            const bool isLeafLevel = depth + 1 == plan.perDepthRefitEntryInfo.size();
+            for (uint32_t i = info.offset; i < info.offset + info.count; i++)
+            {
+                const uint32_t nodeIndex = plan.nodeIndices[i];
+                ASSERT_LT(nodeIndex, bvh.nodes.size());
+                EXPECT(!plannedNodes[nodeIndex]);
+                plannedNodes[nodeIndex] = true;
+                EXPECT_EQ(bvh.nodes[nodeIndex].isLeaf(), isLeafLevel);
+                if (!isLeafLevel)
+                    EXPECT_EQ(depths[nodeIndex], depth);
+                if (i > info.offset)
+                    EXPECT_LT(plan.nodeIndices[i - 1], nodeIndex);
+            }
+        }
+        EXPECT_EQ(offset, plan.nodeIndices.size());
+        EXPECT(plannedNodes == expectedNodes);
+    }
+
+    // Moving all triangles refits the whole tree.
+    EXPECT_EQ(planner.plan(testCases.back()).nodeIndices.size(), bvh.nodes.size());
+    EXPECT(planner.plan({}).nodeIndices.empty());
+}
+
+CPU_TEST(LightBVHRefitPlanner_Refit)
+{
+    auto triangles = createTriangles(kTriangleCount);
+    LightBVHBuilder builder(LightBVHBuilder::Options{});
+    const auto bvh = builder.buildNodes(triangles, kTriangleCount);
+
+    LightBVHRefitPlanner planner;
+    planner.setTree(bvh.nodes, bvh.triangleIndices, kTriangleCount);
+
+    std::vector<PackedNode> nodes = bvh.nodes;
+    refitAll(nodes, bvh.triangleIndices, triangles);
+
+    // Move a few groups of lights over several frames. Refitting the planned nodes must give the same bounds as a full refit.
+    std::mt19937 rng(1);
+    for (uint32_t frame = 0; frame < 8; frame++)
+    {
+        std::vector<TriangleRange> ranges;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            TriangleRange range;
+            range.offset = rng() % (kTriangleCount - 8);
+            range.count = 1 + rng() % 8;
+            ranges.push_back(range);
+
+            const float3 offset = float3(float(rng() % 100), float(rng() % 100), float(rng() % 100)) * 0.1f;
+            for (uint32_t j = range.offset; j < range.offset + range.count; j++)
+                triangles[j].bounds = AABB(triangles[j].bounds.minPoint + offset, triangles[j].bounds.maxPoint + offset);
+        }
+
+        const auto plan = planner.plan(ranges);
+        EXPECT_LT(plan.nodeIndices.size(), bvh.nodes.size() / 4);
+
+        std::vector<PackedNode> expectedNodes = nodes;
+        refitAll(expectedNodes, bvh.triangleIndices, triangles);
+        refitPlan(nodes, plan, bvh.triangleIndices, triangles);
+
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            float3 aabbMin, aabbMax, expectedMin, expectedMax;
+            nodes[i].getNodeAttributes().getAABB(aabbMin, aabbMax);
+            expectedNodes[i].getNodeAttributes().getAABB(expectedMin, expectedMax);
+            EXPECT(all(aabbMin == expectedMin) && all(aabbMax == expectedMax)) << "frame " << frame << " node " << i;
+        }
+    }
+}
+
+CPU_TEST(LightBVHRefitPlanner_CulledTriangles)
+{
+    // Only every other triangle is part of the tree, as if the others had been culled.
+    const auto allTriangles = createTriangles(1000);
+    std::vector<TriangleSortData> triangles;
+    for (uint32_t i = 0; i < allTriangles.size(); i += 2)
+        triangles.push_back(allTriangles[i]);
+
+    LightBVHBuilder builder(LightBVHBuilder::Options{});
+    const auto bvh = builder.buildNodes(triangles, (uint32_t)allTriangles.size());
+
+    LightBVHRefitPlanner planner;
+    planner.setTree(bvh.nodes, bvh.triangleIndices, (uint32_t)allTriangles.size());
+    EXPECT_EQ(planner.getLeaf(1), LightBVHRefitPlanner::kInvalidIndex);
+    EXPECT_NE(planner.getLeaf(2), LightBVHRefitPlanner::kInvalidIndex);
+
+    const TriangleRange culled[] = {{1, 1}, {3, 1}, {999, 1}};
+    EXPECT(planner.plan(culled).nodeIndices.empty());
+
+    const TriangleRange mixed[] = {{1, 2}};
+    EXPECT_EQ(planner.plan(mixed).perDepthRefitEntryInfo.back().count, 1u);
+
+    // An empty planner has nothing to refit.
+    planner.clear();
+    EXPECT(planner.plan(mixed).nodeIndices.empty());
+}
+} // namespace Falcor
@@ -27,16 +27,67 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Sampling/AliasTable.h"
+#include "Utils/Timing/CpuTimer.h"
 
 #include <hypothesis/hypothesis.h>
 
 #include <iostream>
+#include <random>
 
 namespace Falcor
 {
 namespace
 {
-void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> specificWeights = {})
+std::vector<float> generateWeights(uint32_t N, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> uniform;
+    std::vector<float> weights(N);
+    for (auto& weight : weights)
+        weight = uniform(rng);
+    for (uint32_t i = 0; i < N / 100; ++i)
+        weights[(size_t)(uniform(rng) * N)] = 0.f;
+    return weights;
+}
+
+// Compute the probability of sampling each index from the table items.
+std::vector<double> computeProbabilities(const AliasTable& aliasTable)
+{
+    const auto& blockItems = aliasTable.getBlockItems();
+    const auto& items = aliasTable.getItems();
+    const uint32_t blockCount = aliasTable.getBlockCount();
+    const uint32_t blockSize = aliasTable.getBlockSize();
+
+    std::vector<double> blockProbabilities(blockCount, 0.0);
+    for (const auto& item : blockItems)
+    {
+        blockProbabilities[item.indexB] += item.threshold / (double)blockCount;
+        blockProbabilities[item.indexA] += (1.0 - item.threshold) / (double)blockCount;
+    }
+
+    std::vector<double> probabilities(aliasTable.getCount(), 0.0);
+    for (uint32_t i = 0; i < items.size(); ++i)
+    {
+        const uint32_t block = i / blockSize;
+        const uint32_t count = std::min(blockSize, aliasTable.getCount() - block * blockSize);
+        const double p = blockProbabilities[block] / count;
+        probabilities[items[i].indexB] += items[i].threshold * p;
+        probabilities[items[i].indexA] += (1.0 - items[i].threshold) * p;
+    }
+    return probabilities;
+}
+
+void testProbabilities(GPUUnitTestContext& ctx, const AliasTable& aliasTable, const std::vector<float>& weights)
+{
+    double weightSum = 0.0;
+    for (float weight : weights)
+        weightSum += weight;
+
+    std::vector<double> probabilities = computeProbabilities(aliasTable);
+    for (uint32_t i = 0; i < weights.size(); ++i)
+        EXPECT_LE(std::abs(probabilities[i] - weights[i] / weightSum), 1e-6) << "i = " << i;
+}
+
+void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> specificWeights = {}, uint32_t blockSize = AliasTable::kDefaultBlockSize)
 {
     ref<Device> pDevice = ctx.getDevice();
 
@@ -56,7 +107,7 @@ void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> spec
     }
 
     // Create alias table.
-    AliasTable aliasTable(pDevice, weights, rng);
+    AliasTable aliasTable(pDevice, weights, blockSize);
 
     // Compute weight sum.
     double weightSum = 0.0;
@@ -64,7 +115,10 @@ void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> spec
         weightSum += weight;
 
     EXPECT_EQ(aliasTable.getCount(), weights.size());
-    EXPECT_EQ(aliasTable.getWeightSum(), weightSum);
+    if (N <= blockSize)
+        EXPECT_EQ(aliasTable.getWeightSum(), weightSum);
+    else
+        EXPECT_LE(std::abs(aliasTable.getWeightSum() - weightSum), 1e-9 * weightSum);
 
     // Test sampling the alias table.
     {
@@ -147,5 +201,182 @@ GPU_TEST(AliasTable)
     testAliasTable(ctx, 2, {1.f, 2.f});
     testAliasTable(ctx, 100);
     testAliasTable(ctx, 1000);
+    testAliasTable(ctx, 1000, {}, 64);
+}
+
+GPU_TEST(AliasTable_Probabilities)
+{
+    std::mt19937 rng;
+    for (uint32_t blockSize : {1u, 7u, 64u, AliasTable::kDefaultBlockSize})
+    {
+        std::vector<float> weights = generateWeights(1000, rng);
+        AliasTable aliasTable(ctx.getDevice(), weights, blockSize);
+        EXPECT_EQ(aliasTable.getBlockCount(), (1000 + blockSize - 1) / blockSize);
+        testProbabilities(ctx, aliasTable, weights);
+
+        // Sample on the CPU and verify that all samples have non-zero weight.
+        std::uniform_real_distribution<float> uniform;
+        for (uint32_t i = 0; i < 10000; ++i)
+        {
+            uint32_t index = aliasTable.sample(float2(uniform(rng), uniform(rng)));
+            EXPECT_LT(index, 1000u);
+            EXPECT_GT(weights[index], 0.f);
+        }
+    }
+}
+
+GPU_TEST(AliasTable_SampleMatchesCPU)
+{
+    const uint32_t N = 1000;
+    const uint32_t sampleCount = 1u << 20;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+    for (uint32_t blockSize : {1u, 7u, 64u, AliasTable::kDefaultBlockSize})
+    {
+        std::vector<float> weights = generateWeights(N, rng);
+        AliasTable aliasTable(ctx.getDevice(), weights, blockSize);
+
+        std::vector<float> random(2 * sampleCount);
+        for (auto& u : random)
+            u = uniform(rng);
+
+        // Sample the two-level table on the GPU.
+        ctx.createProgram("Tests/Sampling/AliasTableTests.cs.slang", "testAliasTableSample");
+        ctx.allocateStructuredBuffer("sampleResult", sampleCount);
+        ctx.allocateStructuredBuffer("random", 2 * sampleCount, random.data());
+        aliasTable.setShaderData(ctx["CB"]["aliasTable"]);
+        ctx["CB"]["resultCount"] = sampleCount;
+        ctx.runProgram(sampleCount);
+
+        // Compare against the CPU sample() with the same random numbers. The GPU division may differ from the CPU
+        // in the last bit, which can flip the rare samples that land exactly on a threshold.
+        std::vector<uint32_t> histogram(N, 0);
+        uint32_t mismatchCount = 0;
+        const uint32_t* result = ctx.mapBuffer<const uint32_t>("sampleResult");
+        for (uint32_t i = 0; i < sampleCount; ++i)
+        {
+            EXPECT_LT(result[i], N);
+            if (result[i] >= N)
+                continue;
+            if (result[i] != aliasTable.sample(float2(random[i * 2], random[i * 2 + 1])))
+                mismatchCount++;
+            histogram[result[i]]++;
+        }
+        ctx.unmapBuffer("sampleResult");
+        EXPECT_LE(mismatchCount, sampleCount / 10000) << "blockSize = " << blockSize;
+
+        // Verify the GPU histogram against the sampling probabilities of the CPU table.
+        std::vector<double> probabilities = computeProbabilities(aliasTable);
+        std::vector<double> expFrequencies(N);
+        std::vector<double> obsFrequencies(N);
+        for (uint32_t i = 0; i < N; ++i)
+        {
+            expFrequencies[i] = probabilities[i] * sampleCount;
+            obsFrequencies[i] = (double)histogram[i];
+        }
+        const auto& [success, report] = hypothesis::chi2_test(N, obsFrequencies.data(), expFrequencies.data(), sampleCount, 5, 0.1);
+        if (!success)
+            std::cout << report << std::endl;
+        EXPECT(success) << "blockSize = " << blockSize;
+    }
+}
+
+GPU_TEST(AliasTable_UpdateWeights)
+{
+    const uint32_t N = 10000;
+    const uint32_t blockSize = 256;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+    std::vector<float> weights = generateWeights(N, rng);
+    AliasTable aliasTable(ctx.getDevice(), weights, blockSize);
+
+    // Setting the same weights doesn't change the table.
+    EXPECT(!aliasTable.setWeights(weights));
+
+    // Update a few weights, including setting an entire block to zero.
+    std::vector<uint32_t> indices;
+    std::vector<float> newWeights;
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        indices.push_back((uint32_t)(uniform(rng) * N));
+        newWeights.push_back(uniform(rng) * 10.f);
+    }
+    for (uint32_t i = 3 * blockSize; i < 4 * blockSize; ++i)
+    {
+        indices.push_back(i);
+        newWeights.push_back(0.f);
+    }
+    for (size_t i = 0; i < indices.size(); ++i)
+        weights[indices[i]] = newWeights[i];
+    aliasTable.updateWeights(indices, newWeights);
+
+    // The incrementally updated table must match a table built from scratch.
+    AliasTable reference(ctx.getDevice(), weights, blockSize);
+    auto equalItems = [](const std::vector<AliasTable::Item>& a, const std::vector<AliasTable::Item>& b)
+    {
+        return std::equal(
+            a.begin(), a.end(), b.begin(), b.end(),
+            [](const AliasTable::Item& x, const AliasTable::Item& y)
+            { return x.threshold == y.threshold && x.indexA == y.indexA && x.indexB == y.indexB; }
+        );
+    };
+    EXPECT(equalItems(aliasTable.getItems(), reference.getItems()));
+    EXPECT(equalItems(aliasTable.getBlockItems(), reference.getBlockItems()));
+    EXPECT_EQ(aliasTable.getWeightSum(), reference.getWeightSum());
+    testProbabilities(ctx, aliasTable, weights);
+
+    // Replace all weights with a single changed weight.
+    weights[N - 1] = 100.f;
+    EXPECT(aliasTable.setWeights(weights));
+    EXPECT_EQ(aliasTable.getWeight(N - 1), 100.f);
+    testProbabilities(ctx, aliasTable, weights);
+}
+
+GPU_TEST(AliasTable_Benchmark, "Disabled for performance reasons")
+{
+    const uint32_t N = 10'000'000;
+    const uint32_t sampleCount = 10'000'000;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+    std::vector<float> weights = generateWeights(N, rng);
+
+    auto startTime = CpuTimer::getCurrentTimePoint();
+    AliasTable aliasTable(ctx.getDevice(), weights);
+    double buildTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+    // Update 1000 random weights.
+    std::vector<uint32_t> indices(1000);
+    std::vector<float> newWeights(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        indices[i] = (uint32_t)(uniform(rng) * N);
+        newWeights[i] = uniform(rng);
+    }
+    startTime = CpuTimer::getCurrentTimePoint();
+    aliasTable.updateWeights(indices, newWeights);
+    double updateTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+    std::vector<float2> random(sampleCount);
+    for (auto& u : random)
+        u = float2(uniform(rng), uniform(rng));
+    uint64_t checksum = 0;
+    startTime = CpuTimer::getCurrentTimePoint();
+    for (const auto& u : random)
+        checksum += aliasTable.sample(u);
+    double sampleTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+    logInfo(
+        "AliasTable: {} entries in {} blocks, build {:.1f} ms, update of {} weights {:.2f} ms, {:.1f} M samples/s (checksum {})",
+        N,
+        aliasTable.getBlockCount(),
+        buildTime,
+        indices.size(),
+        updateTime,
+        sampleCount / (sampleTime * 1000.0),
+        checksum
+    );
 }
 } // namespace Falcor
@@ -0,0 +1,343 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Animation/Animation.h"
+#include "Scene/SceneCache.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+const double kTimeStep = 1.0 / 30.0;
+
+/** Create an animation with smoothly varying translation and rotation and constant scaling.
+    Keyframes are at multiples of kTimeStep, offset by a random fraction of the time step scaled by 'jitter'.
+*/
+ref<Animation> createAnimation(size_t keyframeCount, double jitter, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u;
+
+    ref<Animation> pAnimation = Animation::create("animation", NodeID(0), keyframeCount * kTimeStep);
+    for (size_t i = 0; i < keyframeCount; i++)
+    {
+        Animation::Keyframe keyframe;
+        keyframe.time = (i + jitter * u(rng)) * kTimeStep;
+        float t = float(keyframe.time);
+        keyframe.translation = float3(std::sin(t) * 5.f, std::cos(t * 0.5f) * 2.f, t);
+        keyframe.scaling = float3(2.f);
+        keyframe.rotation = math::quatFromAngleAxis(t * 0.7f, normalize(float3(1.f, 2.f, 3.f)));
+        pAnimation->addKeyframe(keyframe);
+    }
+    return pAnimation;
+}
+
+/** Create sample times covering the keyframes and some time before and after.
+*/
+std::vector<double> createSampleTimes(size_t count, double duration, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u(-0.1 * duration, 1.1 * duration);
+    std::vector<double> times(count);
+    for (auto& t : times) t = u(rng);
+    return times;
+}
+
+float maxDifference(const float4x4& a, const float4x4& b)
+{
+    float maxDiff = 0.f;
+    for (int r = 0; r < 4; r++)
+    {
+        for (int c = 0; c < 4; c++) maxDiff = std::max(maxDiff, std::abs(a[r][c] - b[r][c]));
+    }
+    return maxDiff;
+}
+
+float maxDifference(float4 a, float4 b)
+{
+    float4 d = abs(a - b);
+    return std::max(std::max(d.x, d.y), std::max(d.z, d.w));
+}
+} // namespace
+
+CPU_TEST(Animation_Keyframes)
+{
+    ref<Animation> pAnimation = createAnimation(100, 0.0, 1);
+
+    EXPECT(pAnimation->doesKeyframeExists(0.0));
+    EXPECT(pAnimation->doesKeyframeExists(50 * kTimeStep));
+    EXPECT(pAnimation->doesKeyframeExists(99 * kTimeStep));
+    EXPECT(!pAnimation->doesKeyframeExists(50.5 * kTimeStep));
+    EXPECT(!pAnimation->doesKeyframeExists(-1.0));
+    EXPECT_EQ(pAnimation->getKeyframe(50 * kTimeStep).time, 50 * kTimeStep);
+
+    bool failed = false;
+    try
+    {
+        pAnimation->getKeyframe(50.5 * kTimeStep);
+    }
+    catch (const ArgumentError&)
+    {
+        failed = true;
+    }
+    EXPECT(failed);
+
+    // Keyframes are kept sorted. Adding a keyframe at an existing time replaces it.
+    Animation::Keyframe keyframe;
+    keyframe.time = 50.5 * kTimeStep;
+    keyframe.translation = float3(1.f, 2.f, 3.f);
+    pAnimation->addKeyframe(keyframe);
+    EXPECT(pAnimation->doesKeyframeExists(50.5 * kTimeStep));
+    EXPECT_EQ(pAnimation->getKeyframe(50.5 * kTimeStep).translation.y, 2.f);
+    keyframe.translation.y = 4.f;
+    pAnimation->addKeyframe(keyframe);
+    EXPECT_EQ(pAnimation->getKeyframe(50.5 * kTimeStep).translation.y, 4.f);
+    EXPECT(pAnimation->doesKeyframeExists(50 * kTimeStep));
+    EXPECT(pAnimation->doesKeyframeExists(51 * kTimeStep));
+
+    // The animation passes through the new keyframe.
+    float4x4 transform = pAnimation->animate(50.5 * kTimeStep);
+    EXPECT_EQ(transform[1][3], 4.f);
+}
+
+CPU_TEST(Animation_SeekOrder)
+{
+    // The result must not depend on the order in which times are sampled.
+    for (auto mode : {Animation::InterpolationMode::Linear, Animation::InterpolationMode::Hermite})
+    {
+        ref<Animation> pAnimation = createAnimation(200, 0.5, 2);
+        pAnimation->setInterpolationMode(mode);
+        pAnimation->setPostInfinityBehavior(Animation::Behavior::Cycle);
+
+        std::vector<double> times = createSampleTimes(1000, pAnimation->getDuration(), 3);
+        std::vector<float4x4> reference(times.size());
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            ref<Animation> pFresh = createAnimation(200, 0.5, 2);
+            pFresh->setInterpolationMode(mode);
+            pFresh->setPostInfinityBehavior(Animation::Behavior::Cycle);
+            reference[i] = pFresh->animate(times[i]);
+        }
+
+        for (size_t i = 0; i < times.size(); i++) EXPECT_EQ(maxDifference(pAnimation->animate(times[i]), reference[i]), 0.f);
+        for (size_t i = times.size(); i-- > 0;) EXPECT_EQ(maxDifference(pAnimation->animate(times[i]), reference[i]), 0.f);
+    }
+}
+
+CPU_TEST(AnimationClip_Encoding)
+{
+    const size_t count = 500;
+    const AnimationClip::Options options;
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> u;
+
+    std::vector<double> times(count);
+    std::vector<float3> translations(count);
+    std::vector<float3> scalings(count);
+    std::vector<quatf> rotations(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        times[i] = i * kTimeStep;
+        translations[i] = float3(u(rng) * 0.01f, 0.f, 0.f);
+        scalings[i] = float3(1.f, 1.f + u(rng) * options.scalingError, 1.f);
+        rotations[i] = math::quatFromAngleAxis(u(rng) * 6.f, normalize(float3(u(rng), u(rng), 1.f)));
+    }
+
+    // Small translation range is quantized to 8 bits, scaling within the error bound is constant.
+    AnimationClip clip(times, translations, scalings, rotations, options);
+    EXPECT_EQ(clip.getKeyframeCount(), count);
+    EXPECT(clip.hasUniformTimes());
+    EXPECT(clip.getTranslationEncoding() == AnimationClip::Encoding::Quantized8);
+    EXPECT(clip.getScalingEncoding() == AnimationClip::Encoding::Constant);
+    EXPECT(clip.getRotationEncoding() == AnimationClip::Encoding::Quantized16);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_LE(std::abs(clip.getTime(i) - times[i]), 1e-9);
+        EXPECT_LE(maxDifference(float4(clip.getTranslation(i), 0.f), float4(translations[i], 0.f)), options.translationError * 1.01f);
+        EXPECT_LE(maxDifference(float4(clip.getScaling(i), 0.f), float4(scalings[i], 0.f)), options.scalingError * 1.01f);
+        quatf q = clip.getRotation(i);
+        quatf r = rotations[i];
+        EXPECT_LE(maxDifference(float4(q.x, q.y, q.z, q.w), float4(r.x, r.y, r.z, r.w)), 4.f * options.rotationError);
+    }
+
+    // Large translation range is stored as floats, non-uniform times are stored explicitly.
+    for (size_t i = 0; i < count; i++)
+    {
+        times[i] = (i + 0.5 * u(rng)) * kTimeStep;
+        translations[i].y = u(rng) * 100.f;
+    }
+    AnimationClip clip2(times, translations, scalings, rotations, options);
+    EXPECT(!clip2.hasUniformTimes());
+    EXPECT(clip2.getTranslationEncoding() == AnimationClip::Encoding::Float);
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(clip2.getTime(i), times[i]);
+        EXPECT_EQ(clip2.getTranslation(i).y, translations[i].y);
+    }
+    EXPECT_LT(clip2.getMemoryUsageInBytes(), count * sizeof(Animation::Keyframe));
+
+    // Keyframe lookup for uniform and non-uniform times.
+    for (const AnimationClip* pClip : {&clip, &clip2})
+    {
+        EXPECT_EQ(pClip->findKeyframe(-1.0), size_t(0));
+        EXPECT_EQ(pClip->findKeyframe(1e6), count - 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_EQ(pClip->findKeyframe(pClip->getTime(i)), i);
+            if (i + 1 < count) EXPECT_EQ(pClip->findKeyframe(0.5 * (pClip->getTime(i) + pClip->getTime(i + 1))), i);
+        }
+    }
+}
+
+CPU_TEST(Animation_Compress)
+{
+    for (double jitter : {0.0, 0.5})
+    {
+        for (auto mode : {Animation::InterpolationMode::Linear, Animation::InterpolationMode::Hermite})
+        {
+            ref<Animation> pReference = createAnimation(300, jitter, 5);
+            ref<Animation> pCompressed = createAnimation(300, jitter, 5);
+            for (auto pAnimation : {pReference, pCompressed})
+            {
+                pAnimation->setInterpolationMode(mode);
+                pAnimation->setPreInfinityBehavior(Animation::Behavior::Cycle);
+                pAnimation->setPostInfinityBehavior(Animation::Behavior::Oscillate);
+            }
+
+            pCompressed->compress();
+            EXPECT(pCompressed->isCompressed());
+            EXPECT(pCompressed->getClip() != nullptr);
+            EXPECT_EQ(pCompressed->getClip()->hasUniformTimes(), jitter == 0.0);
+            EXPECT_LT(pCompressed->getMemoryUsageInBytes(), pReference->getMemoryUsageInBytes());
+
+            std::vector<double> times = createSampleTimes(1000, pReference->getDuration(), 6);
+            for (double t : times) EXPECT_LE(maxDifference(pCompressed->animate(t), pReference->animate(t)), 2e-3f);
+        }
+    }
+
+    // Adding a keyframe decompresses the animation.
+    ref<Animation> pAnimation = createAnimation(100, 0.0, 7);
+    pAnimation->compress();
+    EXPECT(pAnimation->doesKeyframeExists(50 * kTimeStep));
+    Animation::Keyframe keyframe;
+    keyframe.time = 50.5 * kTimeStep;
+    pAnimation->addKeyframe(keyframe);
+    EXPECT(!pAnimation->isCompressed());
+    EXPECT(pAnimation->doesKeyframeExists(50.5 * kTimeStep));
+    EXPECT(pAnimation->doesKeyframeExists(51 * kTimeStep));
+}
+
+GPU_TEST(Animation_SceneCache)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    // Compressed animations with uniform and non-uniform keyframe times, and an uncompressed animation.
+    Scene::SceneData sceneData;
+    sceneData.pMaterials = std::make_unique<MaterialSystem>(pDevice);
+    for (double jitter : {0.0, 0.5})
+    {
+        ref<Animation> pAnimation = createAnimation(300, jitter, 9);
+        pAnimation->setInterpolationMode(Animation::InterpolationMode::Hermite);
+        pAnimation->setPreInfinityBehavior(Animation::Behavior::Cycle);
+        pAnimation->setPostInfinityBehavior(Animation::Behavior::Oscillate);
+        pAnimation->compress();
+        sceneData.animations.push_back(pAnimation);
+    }
+    sceneData.animations.push_back(createAnimation(100, 0.5, 10));
+
+    SHA1 sha1;
+    sha1.update("Animation_SceneCache");
+    sha1.update(getTempFilePath().string());
+    SceneCache::Key key = sha1.finalize();
+    SceneCache::writeCache(sceneData, key);
+    Scene::SceneData loaded = SceneCache::readCache(pDevice, key);
+    std::filesystem::remove(getAppDataDirectory() / "NVIDIA/Falcor/SceneCache" / SHA1::toString(key));
+
+    // The loaded animations evaluate to exactly the same transforms.
+    ASSERT_EQ(loaded.animations.size(), sceneData.animations.size());
+    for (size_t i = 0; i < sceneData.animations.size(); i++)
+    {
+        const ref<Animation>& pExpected = sceneData.animations[i];
+        const ref<Animation>& pLoaded = loaded.animations[i];
+        EXPECT_EQ(pLoaded->getName(), pExpected->getName());
+        EXPECT(pLoaded->getNodeID() == pExpected->getNodeID());
+        EXPECT_EQ(pLoaded->getDuration(), pExpected->getDuration());
+        EXPECT(pLoaded->getInterpolationMode() == pExpected->getInterpolationMode());
+        EXPECT_EQ(pLoaded->isCompressed(), pExpected->isCompressed());
+        EXPECT_EQ(pLoaded->getKeyframeCount(), pExpected->getKeyframeCount());
+        EXPECT_EQ(pLoaded->getMemoryUsageInBytes(), pExpected->getMemoryUsageInBytes());
+        if (pExpected->isCompressed()) EXPECT_EQ(pLoaded->getClip()->hasUniformTimes(), pExpected->getClip()->hasUniformTimes());
+
+        std::vector<double> times = createSampleTimes(1000, pExpected->getDuration(), uint32_t(11 + i));
+        for (double t : times) EXPECT_EQ(maxDifference(pLoaded->animate(t), pExpected->animate(t)), 0.f);
+    }
+}
+
+CPU_TEST(Animation_Benchmark, "Disabled for performance reasons")
+{
+    const size_t animationCount = 100;
+    const size_t keyframeCount = 10000;
+    const size_t sampleCount = 1000000;
+
+    for (bool compressed : {false, true})
+    {
+        std::vector<ref<Animation>> animations(animationCount);
+        size_t memoryUsage = 0;
+        for (size_t i = 0; i < animationCount; i++)
+        {
+            animations[i] = createAnimation(keyframeCount, 0.0, uint32_t(i));
+            if (compressed) animations[i]->compress();
+            memoryUsage += animations[i]->getMemoryUsageInBytes();
+        }
+
+        // Sequential playback followed by random access.
+        std::vector<double> randomTimes = createSampleTimes(sampleCount, keyframeCount * kTimeStep, 8);
+        float sum = 0.f;
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        for (size_t i = 0; i < sampleCount; i++) sum += animations[i % animationCount]->animate((i / animationCount) * 0.01)[0][3];
+        auto sequentialTime = CpuTimer::getCurrentTimePoint();
+        for (size_t i = 0; i < sampleCount; i++) sum += animations[i % animationCount]->animate(randomTimes[i])[0][3];
+        auto endTime = CpuTimer::getCurrentTimePoint();
+
+        double sequentialMs = CpuTimer::calcDuration(startTime, sequentialTime);
+        double randomMs = CpuTimer::calcDuration(sequentialTime, endTime);
+        logInfo(
+            "Animation {}: {} bytes, sequential {:.1f} Msamples/s, random {:.1f} Msamples/s (checksum {})",
+            compressed ? "compressed" : "keyframes", memoryUsage, sampleCount / (sequentialMs * 1000.0), sampleCount / (randomMs * 1000.0), sum
+        );
+    }
+}
+} // namespace Falcor
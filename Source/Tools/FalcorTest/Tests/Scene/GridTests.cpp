@@ -0,0 +1,151 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Volume/Grid.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4146 4244 4267 4275 4996 4456)
+#endif
+#include <nanovdb/util/IO.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+const std::string kGridName = "sphere_fog"; // Default grid name used by nanovdb::createFogVolumeSphere().
+
+std::vector<std::filesystem::path> writeSphereSequence(ref<Device> pDevice, uint32_t frameCount, float voxelSize)
+{
+    std::vector<std::filesystem::path> paths;
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        // Expanding sphere with a soft boundary, similar to the bounds of an explosion simulation.
+        const float radius = 1.f + float(i) / frameCount;
+        ref<Grid> pGrid = Grid::createSphere(pDevice, radius, voxelSize, 4.f);
+        paths.push_back(getTempFilePath().replace_extension("nvdb"));
+        nanovdb::io::writeGrid(paths.back().string(), pGrid->getGridHandle());
+    }
+    return paths;
+}
+
+std::vector<uint8_t> readTexture(GPUUnitTestContext& ctx, const ref<Texture>& pTexture)
+{
+    return ctx.getRenderContext()->readTextureSubresource(pTexture.get(), 0);
+}
+} // namespace
+
+GPU_TEST(Grid_DeterministicBricks)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    ref<Grid> pGridA = Grid::createSphere(pDevice, 1.f, 0.02f);
+    ref<Grid> pGridB = Grid::createSphere(pDevice, 1.f, 0.02f);
+
+    const auto indirection = readTexture(ctx, pGridA->getBrickedGrid().indirection);
+    EXPECT(indirection == readTexture(ctx, pGridB->getBrickedGrid().indirection));
+    EXPECT(readTexture(ctx, pGridA->getBrickedGrid().atlas) == readTexture(ctx, pGridB->getBrickedGrid().atlas));
+
+    // Atlas bricks are allocated in the order of the bricks in the grid. Brick 0 is not distinguishable from empty bricks,
+    // so the remaining non-empty bricks are expected to be numbered 1, 2, 3, ...
+    const ref<Texture>& pAtlas = pGridA->getBrickedGrid().atlas;
+    const uint32_t atlasWidthBricks = pAtlas->getWidth() / 8;
+    const uint32_t atlasHeightBricks = pAtlas->getHeight() / 8;
+    uint32_t expectedBrick = 1;
+    for (size_t i = 0; i < indirection.size(); i += 4)
+    {
+        const uint32_t brick = indirection[i] + (indirection[i + 1] + indirection[i + 2] * atlasHeightBricks) * atlasWidthBricks;
+        if (brick == 0)
+            continue;
+        EXPECT_EQ(brick, expectedBrick);
+        if (brick != expectedBrick)
+            break;
+        expectedBrick++;
+    }
+    EXPECT_GT(expectedBrick, 1u);
+}
+
+GPU_TEST(Grid_CreateFromFiles)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    auto paths = writeSphereSequence(pDevice, 4, 0.05f);
+    paths.push_back(getTempFilePath().replace_extension("nvdb"));
+    std::filesystem::remove(paths.back());
+
+    std::vector<ref<Grid>> grids = Grid::createFromFiles(pDevice, paths, kGridName);
+    ASSERT_EQ(grids.size(), paths.size());
+    EXPECT(grids.back() == nullptr);
+
+    for (size_t i = 0; i + 1 < paths.size(); i++)
+    {
+        ref<Grid> pGrid = Grid::createFromFile(pDevice, paths[i], kGridName);
+        ASSERT(pGrid != nullptr);
+        ASSERT(grids[i] != nullptr);
+        EXPECT_EQ(grids[i]->getVoxelCount(), pGrid->getVoxelCount());
+        EXPECT(readTexture(ctx, grids[i]->getBrickedGrid().indirection) == readTexture(ctx, pGrid->getBrickedGrid().indirection));
+        EXPECT(readTexture(ctx, grids[i]->getBrickedGrid().atlas) == readTexture(ctx, pGrid->getBrickedGrid().atlas));
+        std::filesystem::remove(paths[i]);
+    }
+}
+
+GPU_TEST(Grid_SequenceBenchmark, "Disabled for performance reasons")
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    const uint32_t frameCount = 120;
+    const auto paths = writeSphereSequence(pDevice, frameCount, 0.01f);
+
+    CpuTimer timer;
+    timer.update();
+    for (const auto& path : paths)
+        Grid::createFromFile(pDevice, path, kGridName);
+    timer.update();
+    const double serialTime = timer.delta();
+
+    std::vector<ref<Grid>> grids = Grid::createFromFiles(pDevice, paths, kGridName);
+    timer.update();
+    const double parallelTime = timer.delta();
+
+    logInfo(
+        "Grid sequence with {} frames: serial load {:.1f} ms, parallel load {:.1f} ms", frameCount, serialTime * 1000.0,
+        parallelTime * 1000.0
+    );
+    EXPECT_EQ(grids.size(), paths.size());
+
+    for (const auto& path : paths)
+        std::filesystem::remove(path);
+}
+} // namespace Falcor
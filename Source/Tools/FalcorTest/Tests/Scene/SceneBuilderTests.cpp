@@ -0,0 +1,233 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/TangentCache.h"
+#include "Scene/Material/StandardMaterial.h"
+#include "Utils/Threading.h"
+
+#include <cstring>
+
+namespace Falcor
+{
+namespace
+{
+const uint32_t kMeshCount = 48;
+
+/** Scene data copied back to the CPU for comparison.
+*/
+struct SceneSnapshot
+{
+    std::vector<std::vector<uint8_t>> vertexBuffers;
+    std::vector<uint8_t> indexBuffer;
+    std::vector<uint8_t> indexBuffer16;
+    std::vector<MeshDesc> meshes;
+    std::vector<GeometryInstanceData> instances;
+};
+
+std::vector<uint8_t> readBuffer(GPUUnitTestContext& ctx, const ref<Buffer>& pBuffer)
+{
+    if (!pBuffer)
+        return {};
+    auto pReadback = Buffer::create(ctx.getDevice(), pBuffer->getSize(), ResourceBindFlags::None, Buffer::CpuAccess::Read, nullptr);
+    ctx.getRenderContext()->copyBufferRegion(pReadback.get(), 0, pBuffer.get(), 0, pBuffer->getSize());
+    ctx.getRenderContext()->flush(true);
+    const uint8_t* pData = reinterpret_cast<const uint8_t*>(pReadback->map(Buffer::MapType::Read));
+    std::vector<uint8_t> data(pData, pData + pBuffer->getSize());
+    pReadback->unmap();
+    return data;
+}
+
+SceneSnapshot createSnapshot(GPUUnitTestContext& ctx, const ref<Scene>& pScene)
+{
+    SceneSnapshot snapshot;
+    if (const auto& pVao = pScene->getMeshVao())
+    {
+        for (uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+            snapshot.vertexBuffers.push_back(readBuffer(ctx, pVao->getVertexBuffer(i)));
+        snapshot.indexBuffer = readBuffer(ctx, pVao->getIndexBuffer());
+    }
+    if (const auto& pVao16 = pScene->getMeshVao16())
+        snapshot.indexBuffer16 = readBuffer(ctx, pVao16->getIndexBuffer());
+    for (uint32_t i = 0; i < pScene->getMeshCount(); i++)
+        snapshot.meshes.push_back(pScene->getMesh(MeshID(i)));
+    for (uint32_t i = 0; i < pScene->getGeometryInstanceCount(); i++)
+        snapshot.instances.push_back(pScene->getGeometryInstance(i));
+    return snapshot;
+}
+
+template<typename T>
+bool isEqual(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+bool isEqual(const SceneSnapshot& a, const SceneSnapshot& b)
+{
+    if (a.vertexBuffers.size() != b.vertexBuffers.size())
+        return false;
+    for (size_t i = 0; i < a.vertexBuffers.size(); i++)
+    {
+        if (!isEqual(a.vertexBuffers[i], b.vertexBuffers[i]))
+            return false;
+    }
+    return isEqual(a.indexBuffer, b.indexBuffer) && isEqual(a.indexBuffer16, b.indexBuffer16) && isEqual(a.meshes, b.meshes) &&
+           isEqual(a.instances, b.instances);
+}
+
+/** Build a scene with meshes of varying size. Some meshes are instanced, the others are static and get pretransformed.
+*/
+ref<Scene> buildScene(GPUUnitTestContext& ctx, SceneBuilder::Flags flags)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    SceneBuilder builder(pDevice, {}, flags);
+    auto pMaterial = StandardMaterial::create(pDevice, "Material");
+
+    for (uint32_t i = 0; i < kMeshCount; i++)
+    {
+        auto pMesh = TriangleMesh::createSphere(0.5f, 8 + 4 * i, 4 + 2 * (i % 7));
+        MeshID meshID = builder.addTriangleMesh(pMesh, pMaterial);
+        for (uint32_t j = 0; j < 1 + i % 3; j++)
+        {
+            SceneBuilder::Node node = {
+                "Node", math::matrixFromTranslation(float3(float(i), float(j), 0.f)), float4x4::identity(), float4x4::identity()};
+            builder.addMeshInstance(builder.addNode(node), meshID);
+        }
+    }
+
+    return builder.getScene();
+}
+} // namespace
+
+GPU_TEST(SceneBuilder_ParallelIdentical)
+{
+    // Build the scene with a single worker thread, then with the full thread pool.
+    // The tangent cache is cleared so that both builds generate their tangents.
+    Threading::shutdown();
+    Threading::start(1);
+    TangentCache::get().clearMemory();
+    SceneSnapshot serial = createSnapshot(ctx, buildScene(ctx, SceneBuilder::Flags::Default));
+
+    Threading::shutdown();
+    Threading::start();
+    TangentCache::get().clearMemory();
+    SceneSnapshot parallel = createSnapshot(ctx, buildScene(ctx, SceneBuilder::Flags::Default));
+
+    EXPECT_EQ(serial.meshes.size(), kMeshCount);
+    EXPECT(!serial.vertexBuffers.empty());
+    EXPECT(isEqual(serial, parallel));
+}
+
+GPU_TEST(SceneBuilder_DeferTangentGeneration)
+{
+    // The spheres have no tangents, so MikkTSpace runs for every mesh. Deferred meshes are processed in parallel
+    // in getScene() and must produce the same vertex data, including the tangents, as immediate processing.
+    TangentCache::get().clearMemory();
+    SceneSnapshot immediate = createSnapshot(ctx, buildScene(ctx, SceneBuilder::Flags::Default));
+    TangentCache::get().clearMemory();
+    SceneSnapshot deferred = createSnapshot(ctx, buildScene(ctx, SceneBuilder::Flags::DeferTangentGeneration));
+
+    EXPECT_EQ(deferred.meshes.size(), kMeshCount);
+    EXPECT(isEqual(immediate, deferred));
+}
+
+GPU_TEST(SceneBuilder_TangentCache)
+{
+    // The second import of identical meshes takes all tangents from the cache and must produce the same scene.
+    TangentCache::get().clearMemory();
+    const TangentCache::Stats before = TangentCache::get().getStats();
+    SceneSnapshot first = createSnapshot(ctx, buildScene(ctx, SceneBuilder::Flags::Default));
+    const TangentCache::Stats afterFirst = TangentCache::get().getStats();
+    SceneSnapshot second = createSnapshot(ctx, buildScene(ctx, SceneBuilder::Flags::Default));
+    const TangentCache::Stats afterSecond = TangentCache::get().getStats();
+
+    EXPECT_EQ(afterFirst.misses - before.misses, kMeshCount);
+    EXPECT_EQ(afterFirst.memoryHits, before.memoryHits);
+    EXPECT_EQ(afterSecond.misses, afterFirst.misses);
+    EXPECT_EQ(afterSecond.memoryHits - afterFirst.memoryHits, kMeshCount);
+    EXPECT(isEqual(first, second));
+}
+
+CPU_TEST(TangentCache_Persistent)
+{
+    const std::filesystem::path directory = getTempFilePath();
+    std::vector<float4> tangents(300);
+    for (size_t i = 0; i < tangents.size(); i++)
+        tangents[i] = float4(float(i), 0.5f, -1.f / float(i + 1), i % 2 ? 1.f : -1.f);
+    const TangentCache::Key key = SHA1::compute("mesh", 4);
+
+    {
+        TangentCache cache(directory);
+        cache.insert(key, tangents, true);
+    }
+
+    // A new cache instance finds the entry on disk only for persistent lookups.
+    {
+        TangentCache cache(directory);
+        std::vector<float4> result;
+        EXPECT(!cache.lookup(key, result, false));
+        ASSERT(cache.lookup(key, result, true));
+        ASSERT_EQ(result.size(), tangents.size());
+        EXPECT(std::memcmp(result.data(), tangents.data(), tangents.size() * sizeof(float4)) == 0);
+        EXPECT(cache.lookup(key, result, false));
+
+        const TangentCache::Stats stats = cache.getStats();
+        EXPECT_EQ(stats.misses, 1);
+        EXPECT_EQ(stats.diskHits, 1);
+        EXPECT_EQ(stats.memoryHits, 1);
+    }
+
+    // Truncated entries are ignored.
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+        std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) - 4);
+    {
+        TangentCache cache(directory);
+        std::vector<float4> result;
+        EXPECT(!cache.lookup(key, result, true));
+        EXPECT(result.empty());
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+GPU_TEST(SceneBuilder_BuildTimes)
+{
+    ref<Scene> pScene = buildScene(ctx, SceneBuilder::Flags::Default);
+
+    // The build times include all stages up to scene creation, followed by the total.
+    const auto& buildTimes = pScene->getBuildTimes();
+    ASSERT_GE(buildTimes.size(), size_t(2));
+    EXPECT_EQ(buildTimes[buildTimes.size() - 2].first, "createScene");
+    EXPECT_EQ(buildTimes.back().first, "Total");
+
+    double sum = 0.0;
+    for (size_t i = 0; i + 1 < buildTimes.size(); i++)
+        sum += buildTimes[i].second;
+    EXPECT_EQ(buildTimes.back().second, sum);
+}
+} // namespace Falcor
@@ -0,0 +1,279 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneCache.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+void writeFile(const std::filesystem::path& path, const std::string& contents)
+{
+    std::ofstream fs(path, std::ios_base::binary | std::ios_base::trunc);
+    fs << contents;
+}
+
+std::filesystem::path getCachePath(const SceneCache::Key& key)
+{
+    return getAppDataDirectory() / "NVIDIA/Falcor/SceneCache" / SHA1::toString(key);
+}
+
+SceneCache::Key createKey(const std::string& name)
+{
+    SHA1 sha1;
+    sha1.update(name);
+    sha1.update(getTempFilePath().string());
+    return sha1.finalize();
+}
+
+template<typename T>
+bool isEqual(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+/** Create scene data with synthetic mesh and curve geometry. Only the bulk arrays are populated.
+*/
+Scene::SceneData createSceneData(ref<Device> pDevice, size_t vertexCount)
+{
+    Scene::SceneData sceneData;
+    sceneData.pMaterials = std::make_unique<MaterialSystem>(pDevice);
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+
+    // Positions on a grid compress well, the remaining attributes are random and do not.
+    sceneData.meshStaticData.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        auto& v = sceneData.meshStaticData[i];
+        v.position = float3(float(i % 1024), float(i / 1024), 0.f);
+        v.packedNormalTangentCurveRadius = float3(u(rng), u(rng), u(rng));
+        v.texCrd = float2(u(rng), u(rng));
+    }
+    sceneData.meshIndexData.resize(vertexCount * 3 / 2);
+    for (size_t i = 0; i < sceneData.meshIndexData.size(); i++) sceneData.meshIndexData[i] = uint32_t((i * 7) % vertexCount);
+
+    // Small arrays are stored inline.
+    sceneData.meshSkinningData.resize(16);
+    sceneData.curveIndexData.resize(vertexCount / 4);
+    for (size_t i = 0; i < sceneData.curveIndexData.size(); i++) sceneData.curveIndexData[i] = uint32_t(i);
+    sceneData.curveStaticData.resize(vertexCount / 4);
+    for (auto& v : sceneData.curveStaticData) v.position = float3(u(rng), u(rng), u(rng));
+
+    return sceneData;
+}
+} // namespace
+
+GPU_TEST(SceneCache_Formats)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    Scene::SceneData sceneData = createSceneData(pDevice, 3000000);
+
+    for (auto format : {SceneCache::Format::V1, SceneCache::Format::V2})
+    {
+        SceneCache::Key key = createKey("SceneCache_Formats");
+        SceneCache::writeCache(sceneData, key, {}, format);
+        EXPECT(SceneCache::hasValidCache(key));
+
+        Scene::SceneData loaded = SceneCache::readCache(pDevice, key);
+        EXPECT(isEqual(sceneData.meshStaticData, loaded.meshStaticData));
+        EXPECT(isEqual(sceneData.meshIndexData, loaded.meshIndexData));
+        EXPECT(isEqual(sceneData.meshSkinningData, loaded.meshSkinningData));
+        EXPECT(isEqual(sceneData.curveIndexData, loaded.curveIndexData));
+        EXPECT(isEqual(sceneData.curveStaticData, loaded.curveStaticData));
+
+        std::filesystem::path cachePath = getCachePath(key);
+        if (format == SceneCache::Format::V2)
+        {
+            // Corrupt chunk offsets and sizes are rejected before allocating the blobs.
+            // The chunk table follows the header (12 bytes), the empty manifest (8 bytes) and the chunk count (8 bytes).
+            // Each ChunkDesc is 40 bytes with blobOffset at byte 8 and size at byte 16.
+            const uint64_t kChunkTableOffset = 28;
+            const uint64_t kChunkDescSize = 40;
+            uint64_t chunkCount = 0;
+            {
+                std::ifstream fs(cachePath, std::ios_base::binary);
+                fs.seekg(20);
+                fs.read(reinterpret_cast<char*>(&chunkCount), sizeof(chunkCount));
+            }
+            EXPECT_GT(chunkCount, 1u);
+
+            struct Corruption
+            {
+                uint64_t offset;
+                int64_t delta;
+            };
+            const Corruption corruptions[] = {
+                // Huge blob offset of the main blob.
+                {kChunkTableOffset + 8, int64_t(1) << 60},
+                // Last bulk array chunk smaller than the array length stored in the main blob.
+                {kChunkTableOffset + (chunkCount - 1) * kChunkDescSize + 16, -4},
+            };
+            for (const auto& corruption : corruptions)
+            {
+                SceneCache::writeCache(sceneData, key, {}, format);
+                {
+                    std::fstream fs(cachePath, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                    uint64_t value = 0;
+                    fs.seekg(corruption.offset);
+                    fs.read(reinterpret_cast<char*>(&value), sizeof(value));
+                    value += corruption.delta;
+                    fs.seekp(corruption.offset);
+                    fs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+                }
+                bool failed = false;
+                try
+                {
+                    SceneCache::readCache(pDevice, key);
+                }
+                catch (const RuntimeError&)
+                {
+                    failed = true;
+                }
+                EXPECT(failed);
+            }
+
+            // A truncated V2 cache file is rejected by the chunk table validation.
+            SceneCache::writeCache(sceneData, key, {}, format);
+            std::filesystem::resize_file(cachePath, std::filesystem::file_size(cachePath) / 2);
+            bool failed = false;
+            try
+            {
+                SceneCache::readCache(pDevice, key);
+            }
+            catch (const RuntimeError&)
+            {
+                failed = true;
+            }
+            EXPECT(failed);
+        }
+
+        // A corrupt manifest entry count is rejected before anything is allocated.
+        {
+            std::fstream fs(cachePath, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+            const uint64_t count = std::numeric_limits<uint64_t>::max() / 2;
+            fs.seekp(12); // Size of the header (magic and version).
+            fs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+        EXPECT(!SceneCache::hasValidCache(key));
+        bool failed = false;
+        try
+        {
+            SceneCache::readCache(pDevice, key);
+        }
+        catch (const RuntimeError&)
+        {
+            failed = true;
+        }
+        EXPECT(failed);
+
+        std::filesystem::remove(cachePath);
+    }
+}
+
+GPU_TEST(SceneCache_Benchmark, "Disabled for performance reasons")
+{
+    ref<Device> pDevice = ctx.getDevice();
+    Scene::SceneData sceneData = createSceneData(pDevice, 50000000);
+
+    for (auto format : {SceneCache::Format::V1, SceneCache::Format::V2})
+    {
+        SceneCache::Key key = createKey("SceneCache_Benchmark");
+
+        CpuTimer timer;
+        timer.update();
+        SceneCache::writeCache(sceneData, key, {}, format);
+        timer.update();
+        double writeTime = timer.delta();
+
+        Scene::SceneData loaded = SceneCache::readCache(pDevice, key);
+        timer.update();
+        double readTime = timer.delta();
+
+        std::filesystem::path cachePath = getCachePath(key);
+        logInfo(
+            "SceneCache format V{}: {} bytes, write {:.1f} ms, read {:.1f} ms", format == SceneCache::Format::V1 ? 1 : 2,
+            std::filesystem::file_size(cachePath), writeTime * 1000.0, readTime * 1000.0
+        );
+        EXPECT(isEqual(sceneData.meshStaticData, loaded.meshStaticData));
+
+        std::filesystem::remove(cachePath);
+    }
+}
+
+CPU_TEST(SceneCache_Manifest)
+{
+    std::filesystem::path path = getTempFilePath();
+    std::filesystem::path missingPath = getTempFilePath();
+    std::filesystem::remove(missingPath);
+    writeFile(path, "scene");
+
+    for (bool hashContents : {false, true})
+    {
+        // Duplicates are removed.
+        auto manifest = SceneCache::createManifest({path, missingPath, path}, hashContents);
+        EXPECT_EQ(manifest.size(), 2u);
+        EXPECT(SceneCache::isManifestValid(manifest));
+
+        for (const auto& entry : manifest)
+        {
+            EXPECT_EQ(entry.exists, entry.path == path);
+            EXPECT_EQ(entry.contentHash.has_value(), hashContents && entry.exists);
+        }
+
+        // Changing the file size invalidates the manifest.
+        writeFile(path, "scene2");
+        EXPECT(!SceneCache::isManifestValid(manifest));
+        writeFile(path, "scene");
+    }
+
+    // Creating a missing file invalidates the manifest.
+    auto manifest = SceneCache::createManifest({missingPath}, false);
+    EXPECT(SceneCache::isManifestValid(manifest));
+    writeFile(missingPath, "texture");
+    EXPECT(!SceneCache::isManifestValid(manifest));
+
+    // With content hashing, changes that keep the size and modification time are detected as well.
+    manifest = SceneCache::createManifest({path}, true);
+    auto modifiedTime = std::filesystem::last_write_time(path);
+    writeFile(path, "SCENE");
+    std::filesystem::last_write_time(path, modifiedTime);
+    EXPECT(!SceneCache::isManifestValid(manifest));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(missingPath);
+}
+} // namespace Falcor
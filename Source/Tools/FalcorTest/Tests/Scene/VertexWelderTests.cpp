@@ -0,0 +1,146 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/VertexWelder.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+using Mode = VertexWelder::Mode;
+
+/** Synthetic mesh with face-varying normals and texture coordinates.
+    A fraction of the face corners gets a normal/texcoord that differs from the other corners sharing the same
+    original vertex, creating splits like hard edges and UV seams. Some corners get tiny perturbations within the merge
+    threshold, and optionally some get NaN normals, to exercise the fuzzy comparison.
+*/
+struct SyntheticMesh
+{
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<float2> texCrds;
+    std::vector<uint32_t> indices;
+    SceneBuilder::Mesh mesh;
+
+    SyntheticMesh(uint32_t vertexCount, uint32_t faceCount, float splitRatio, bool addNaNs)
+    {
+        std::mt19937 rng(vertexCount + faceCount);
+        std::uniform_real_distribution<float> u;
+
+        positions.resize(vertexCount);
+        for (auto& p : positions)
+            p = float3(u(rng), u(rng), u(rng));
+
+        indices.resize(faceCount * 3);
+        for (auto& i : indices)
+            i = rng() % vertexCount;
+
+        normals.resize(indices.size());
+        texCrds.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            uint32_t origIndex = indices[i];
+            uint32_t split = u(rng) < splitRatio ? rng() % 8 : 0;
+            float eps = rng() % 4 == 0 ? 5e-7f : 0.f;
+            normals[i] = float3(float(origIndex % 7) + split * 0.25f + eps, 1.f, 0.f);
+            texCrds[i] = float2(float(origIndex % 13), float(split) - eps);
+            if (addNaNs && rng() % 64 == 0)
+                normals[i].y = std::numeric_limits<float>::quiet_NaN();
+        }
+
+        mesh.name = "synthetic";
+        mesh.faceCount = faceCount;
+        mesh.vertexCount = vertexCount;
+        mesh.indexCount = (uint32_t)indices.size();
+        mesh.pIndices = indices.data();
+        mesh.topology = Vao::Topology::TriangleList;
+        mesh.positions = {positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
+        mesh.normals = {normals.data(), SceneBuilder::Mesh::AttributeFrequency::FaceVarying};
+        mesh.texCrds = {texCrds.data(), SceneBuilder::Mesh::AttributeFrequency::FaceVarying};
+    }
+};
+
+bool isIdentical(const VertexWelder::Result& a, const VertexWelder::Result& b)
+{
+    if (a.indices != b.indices || a.corners != b.corners || a.vertices.size() != b.vertices.size())
+        return false;
+    return a.vertices.empty() || std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(a.vertices[0])) == 0;
+}
+
+void testWelder(CPUUnitTestContext& ctx, uint32_t vertexCount, uint32_t faceCount, float splitRatio, bool addNaNs)
+{
+    SyntheticMesh m(vertexCount, faceCount, splitRatio, addNaNs);
+
+    auto ref = VertexWelder::weld(m.mesh, Mode::LinkedList);
+    EXPECT_EQ(ref.indices.size(), m.indices.size());
+    EXPECT_EQ(ref.corners.size(), ref.vertices.size());
+    EXPECT_GE(ref.vertices.size(), vertexCount);
+
+    for (Mode mode : {Mode::Hash, Mode::ParallelHash})
+    {
+        auto result = VertexWelder::weld(m.mesh, mode);
+        EXPECT(isIdentical(ref, result)) << "mode = " << (int)mode << ", splitRatio = " << splitRatio;
+    }
+}
+} // namespace
+
+CPU_TEST(VertexWelder_Identical)
+{
+    testWelder(ctx, 100, 400, 0.05f, false);
+    testWelder(ctx, 100, 400, 0.9f, true);
+    testWelder(ctx, 20000, 80000, 0.05f, false);
+    testWelder(ctx, 20000, 80000, 0.9f, false);
+    testWelder(ctx, 20000, 80000, 0.5f, true);
+}
+
+CPU_TEST(VertexWelder_Benchmark, "Disabled for performance reasons")
+{
+    for (float splitRatio : {0.05f, 0.9f})
+    {
+        SyntheticMesh m(300000, 2400000, splitRatio, false);
+        VertexWelder::Result ref;
+        for (Mode mode : {Mode::LinkedList, Mode::Hash, Mode::ParallelHash})
+        {
+            CpuTimer timer;
+            timer.update();
+            auto result = VertexWelder::weld(m.mesh, mode);
+            timer.update();
+            logInfo("VertexWelder mode {} split ratio {}: {} vertices in {:.1f} ms", (int)mode, splitRatio, result.vertices.size(), timer.delta() * 1000.0);
+            if (mode == Mode::LinkedList)
+                ref = std::move(result);
+            else
+                EXPECT(isIdentical(ref, result));
+        }
+    }
+}
+} // namespace Falcor
@@ -29,6 +29,7 @@
 #include "Utils/Math/ScalarMath.h"
 #include <fstd/bit.h> // TODO C++20: Replace with <bit>
 #include <random>
+#include <vector>
 
 namespace Falcor
 {
@@ -162,4 +163,57 @@ CPU_TEST(Float16Scalar)
         EXPECT_EQ(fstd::bit_cast<uint16_t>(result), fstd::bit_cast<uint16_t>(expected));
     }
 }
+
+CPU_TEST(Float16BulkConversion)
+{
+    // Test conversion to float for all bit patterns. Odd sizes exercise the scalar tail of the SIMD kernels.
+    std::vector<float16_t> halfs(0x10000);
+    for (uint32_t bits = 0; bits < 0x10000; bits++)
+        halfs[bits] = fstd::bit_cast<float16_t>((uint16_t)bits);
+
+    for (size_t count : {size_t(0x10000), size_t(0x10000 - 3)})
+    {
+        std::vector<float> floats(count);
+        math::convertFloat16ToFloat32(fstd::span<const float16_t>(halfs.data(), count), floats);
+        for (size_t i = 0; i < count; i++)
+            EXPECT_EQ(fstd::bit_cast<uint32_t>(floats[i]), fstd::bit_cast<uint32_t>((float)halfs[i])) << "bits=" << i;
+    }
+
+    // Test conversion from float for values around all halfs (rounding ties and carries), specials and random bit patterns.
+    std::vector<float> floats;
+    for (uint32_t bits = 0; bits < 0x10000; bits++)
+    {
+        const uint32_t f = fstd::bit_cast<uint32_t>((float)halfs[bits]);
+        for (uint32_t offset : {0u, 1u, 0xfffu, 0x1000u, 0x1001u, 0x1fffu, 0xffffffffu})
+            floats.push_back(fstd::bit_cast<float>(f + offset));
+    }
+    for (float f : {65504.f, 65519.f, 65520.f, 1e10f, 0x1p-25f, 0x1p-24f, 0x1p-26f, 1e-45f})
+    {
+        floats.push_back(f);
+        floats.push_back(-f);
+    }
+    std::uniform_int_distribution<uint32_t> dist;
+    for (size_t i = 0; i < 100000; i++)
+        floats.push_back(fstd::bit_cast<float>(dist(rng)));
+
+    std::vector<float16_t> result(floats.size());
+    math::convertFloat32ToFloat16(floats, result);
+    for (size_t i = 0; i < floats.size(); i++)
+    {
+        EXPECT_EQ(fstd::bit_cast<uint16_t>(result[i]), fstd::bit_cast<uint16_t>((float16_t)floats[i]))
+            << "bits=" << fstd::bit_cast<uint32_t>(floats[i]);
+    }
+
+    // Test size mismatch.
+    bool thrown = false;
+    try
+    {
+        math::convertFloat32ToFloat16(floats, fstd::span<float16_t>(result.data(), 1));
+    }
+    catch (const ArgumentError&)
+    {
+        thrown = true;
+    }
+    EXPECT(thrown);
+}
 } // namespace Falcor
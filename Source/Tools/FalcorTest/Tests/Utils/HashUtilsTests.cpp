@@ -26,6 +26,8 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "Testing/UnitTest.h"
+#include "Utils/Math/XXHash.h"
+#include <cstring>
 #include <vector>
 
 // The perfect hash tests are disabled by default as they take a really long time to run.
@@ -118,4 +120,28 @@ GPU_TEST(JenkinsHash_PerfectHashGPU, "Disabled for performance reasons")
     }
     pResultBuffer->unmap();
 }
+
+CPU_TEST(XXHash64_ReferenceValues)
+{
+    // Reference values from the xxHash reference implementation.
+    const char* str = "Nobody inspects the spammish repetition";
+    EXPECT_EQ(xxHash64("", 0), 0xef46db3751d8e999ull);
+    EXPECT_EQ(xxHash64("abc", 3), 0x44bc2cf5ad770999ull);
+    EXPECT_EQ(xxHash64(str, std::strlen(str)), 0xfbcea83c8a378bf1ull);
+    EXPECT_EQ(xxHash64(str, std::strlen(str), 123), 0xa8ba45551f24b7aeull);
+
+    std::vector<uint8_t> data(100);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)i;
+    EXPECT_EQ(xxHash64(data.data(), data.size()), 0x6ac1e58032166597ull);
+
+    // Changing any byte changes the hash.
+    uint64_t hash = xxHash64(data.data(), data.size());
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] ^= 1;
+        EXPECT_NE(xxHash64(data.data(), data.size()), hash) << "i = " << i;
+        data[i] ^= 1;
+    }
+}
 } // namespace Falcor
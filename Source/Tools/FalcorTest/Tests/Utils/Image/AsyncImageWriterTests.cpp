@@ -0,0 +1,121 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/AsyncImageWriter.h"
+#include <vector>
+
+namespace Falcor
+{
+CPU_TEST(AsyncImageWriter)
+{
+    const uint32_t width = 64, height = 32;
+    const uint32_t imageCount = 8;
+
+    std::vector<uint8_t> data(width * height * 4);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = uint8_t(i * 7);
+
+    // Limit the queue to two images to exercise blocking writes.
+    AsyncImageWriter::Options options;
+    options.threadCount = 2;
+    options.maxQueuedBytes = 2 * data.size();
+    AsyncImageWriter writer(options);
+
+    std::vector<std::filesystem::path> paths;
+    for (uint32_t i = 0; i < imageCount; i++)
+    {
+        paths.push_back(getTempFilePath().replace_extension("png"));
+        writer.write(
+            paths.back(), width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, data
+        );
+    }
+
+    writer.flush();
+
+    auto stats = writer.getStats();
+    EXPECT_EQ(stats.queueSize, 0);
+    EXPECT_EQ(stats.queuedBytes, 0);
+    EXPECT_EQ(stats.writtenCount, imageCount);
+    EXPECT_EQ(stats.failedCount, 0);
+
+    uint64_t bytesWritten = 0;
+    for (const auto& path : paths)
+    {
+        auto pBitmap = Bitmap::createFromFile(path, true);
+        ASSERT(pBitmap != nullptr);
+        EXPECT_EQ(pBitmap->getWidth(), width);
+        EXPECT_EQ(pBitmap->getHeight(), height);
+        bytesWritten += std::filesystem::file_size(path);
+        std::filesystem::remove(path);
+    }
+    EXPECT_EQ(stats.bytesWritten, bytesWritten);
+}
+
+CPU_TEST(AsyncImageWriter_Replace)
+{
+    const uint32_t width = 16, height = 16;
+
+    AsyncImageWriter writer;
+
+    // Writing to an existing file replaces it.
+    std::filesystem::path path = getTempFilePath().replace_extension("png");
+    for (uint8_t value : {uint8_t(50), uint8_t(200)})
+    {
+        std::vector<uint8_t> data(width * height * 4, value);
+        writer.write(path, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, data);
+        writer.flush();
+    }
+    auto pBitmap = Bitmap::createFromFile(path, true);
+    ASSERT(pBitmap != nullptr);
+    EXPECT_EQ(pBitmap->getData()[0], 200);
+    std::filesystem::remove(path);
+
+    // Failed writes leave the destination untouched and don't leave temporary files behind.
+    std::filesystem::path directory = getTempFilePath();
+    std::filesystem::create_directories(directory / "dest.png" / "child");
+    std::vector<uint8_t> data(width * height * 4, 100);
+    writer.write(
+        directory / "dest.png", width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, data
+    );
+    writer.flush();
+
+    auto stats = writer.getStats();
+    EXPECT_EQ(stats.writtenCount, 2);
+    EXPECT_EQ(stats.failedCount, 1);
+    EXPECT_EQ(stats.queuedBytes, 0);
+    EXPECT(std::filesystem::is_directory(directory / "dest.png" / "child"));
+    size_t fileCount = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        (void)entry;
+        fileCount++;
+    }
+    EXPECT_EQ(fileCount, 1);
+    std::filesystem::remove_all(directory);
+}
+} // namespace Falcor
@@ -0,0 +1,215 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/AsyncTextureLoader.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace Falcor
+{
+namespace
+{
+const size_t kTextureCount = 6;
+
+std::filesystem::path getTestPath(size_t i)
+{
+    return getRuntimeDirectory() / ("data/tests/texture" + std::to_string(i + 1) + ".png");
+}
+} // namespace
+
+GPU_TEST(AsyncTextureLoader_Load)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    std::atomic<size_t> callbackCount{0};
+    {
+        AsyncTextureLoader::Options options;
+        options.threadCount = 2;
+        options.maxDecodedBytes = 1; // Only allow a single decoded texture waiting for upload.
+        AsyncTextureLoader loader(pDevice, options);
+
+        std::vector<std::future<ref<Texture>>> futures;
+        for (size_t i = 0; i < kTextureCount; i++)
+        {
+            auto callback = [&callbackCount](ref<Texture> pTexture, const AsyncTextureLoader::Analysis& analysis)
+            {
+                if (pTexture && analysis)
+                    callbackCount++;
+            };
+            futures.push_back(loader.loadFromFile(getTestPath(i), false, false, ResourceBindFlags::ShaderResource, callback, int(i % 3)));
+        }
+
+        for (auto& future : futures)
+        {
+            auto pTexture = future.get();
+            ASSERT(pTexture != nullptr);
+            EXPECT_EQ(pTexture->getMipCount(), 1);
+        }
+
+        auto stats = loader.getStats();
+        EXPECT_EQ(stats.decodeQueueSize, 0);
+        EXPECT_EQ(stats.uploadQueueSize, 0);
+        EXPECT_EQ(stats.decodedBytesInFlight, 0);
+        EXPECT_EQ(stats.decodedCount, kTextureCount);
+        EXPECT_EQ(stats.uploadedCount, kTextureCount);
+        EXPECT_EQ(stats.uploadedBytes, stats.decodedBytes);
+        EXPECT_EQ(stats.cancelledCount, 0);
+        EXPECT_EQ(stats.failedCount, 0);
+    }
+
+    // Callbacks are called after the futures are ready. The loader destructor waits for all requests to finish.
+    EXPECT_EQ(callbackCount.load(), kTextureCount);
+}
+
+GPU_TEST(AsyncTextureLoader_Analysis)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    AsyncTextureLoader::Analysis analysis;
+    {
+        AsyncTextureLoader loader(pDevice, 1);
+
+        // texture1.png has a constant color.
+        auto future = loader.loadFromFile(
+            getTestPath(0), true, false, ResourceBindFlags::ShaderResource,
+            [&analysis](ref<Texture> pTexture, const AsyncTextureLoader::Analysis& result) { analysis = result; }
+        );
+        ASSERT(future.get() != nullptr);
+    }
+
+    ASSERT(analysis.has_value());
+    EXPECT(analysis->isConstant(TextureChannelFlags::RGBA));
+    EXPECT_EQ(analysis->value.x, 128 / 255.f);
+    EXPECT_EQ(analysis->value.y, 255 / 255.f);
+    EXPECT_EQ(analysis->value.z, 64 / 255.f);
+    EXPECT_EQ(analysis->value.w, 1.f);
+}
+
+GPU_TEST(AsyncTextureLoader_MipRange)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    AsyncTextureLoader loader(pDevice, 1);
+    const std::filesystem::path path = getTestPath(1);
+
+    auto pFull = loader.loadFromFile(path, true, false).get();
+    ASSERT(pFull != nullptr);
+    ASSERT(pFull->getMipCount() > 1);
+    const uint64_t fullBytes = loader.getStats().decodedBytes;
+
+    // Skipped mips are dropped on the decode thread, so only the downsampled image counts towards the decoded bytes.
+    auto pTexture = loader.loadMipRange(fstd::span<const std::filesystem::path>(&path, 1), true, false, 1, Texture::kMaxPossible).get();
+    ASSERT(pTexture != nullptr);
+    EXPECT_EQ(pTexture->getWidth(), pFull->getWidth(1));
+    EXPECT_EQ(pTexture->getHeight(), pFull->getHeight(1));
+    EXPECT_EQ(pTexture->getMipCount(), pFull->getMipCount() - 1);
+
+    const uint64_t expectedBytes = uint64_t(pTexture->getWidth()) * pTexture->getHeight() * getFormatBytesPerBlock(pTexture->getFormat());
+    auto stats = loader.getStats();
+    EXPECT_EQ(stats.decodedBytes - fullBytes, expectedBytes);
+    EXPECT_EQ(stats.decodedBytesInFlight, 0);
+    EXPECT_EQ(stats.uploadedCount, 2);
+}
+
+GPU_TEST(AsyncTextureLoader_Priority)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    std::promise<void> blockerStarted;
+    std::promise<void> releaseBlocker;
+    std::shared_future<void> release = releaseBlocker.get_future().share();
+
+    // Requests of the same priority complete in request order.
+    const int priorities[] = {1, 3, 0, 3, 2};
+    const std::vector<size_t> expectedOrder = {1, 3, 4, 0, 2};
+    std::vector<size_t> order;
+    {
+        AsyncTextureLoader::Options options;
+        options.threadCount = 1;
+        options.maxDecodedBytes = 1; // Decoding pauses while a decoded texture is waiting for upload.
+        AsyncTextureLoader loader(pDevice, options);
+
+        // Stall the loader: The upload thread blocks in the callback of the first request while the second request is
+        // waiting for upload, so the decode thread can't start on any of the following requests.
+        auto blockCallback = [&](ref<Texture> pTexture, const AsyncTextureLoader::Analysis& analysis)
+        {
+            blockerStarted.set_value();
+            release.wait();
+        };
+        loader.loadFromFile(getTestPath(0), false, false, ResourceBindFlags::ShaderResource, blockCallback);
+        loader.loadFromFile(getTestPath(0), false, false);
+        blockerStarted.get_future().wait();
+        while (loader.getStats().uploadQueueSize == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        for (size_t i = 0; i < std::size(priorities); i++)
+        {
+            auto callback = [&order, i](ref<Texture> pTexture, const AsyncTextureLoader::Analysis& analysis) { order.push_back(i); };
+            loader.loadFromFile(getTestPath(i + 1), false, false, ResourceBindFlags::ShaderResource, callback, priorities[i]);
+        }
+        EXPECT_EQ(loader.getStats().decodeQueueSize, std::size(priorities));
+
+        releaseBlocker.set_value();
+    }
+
+    // All callbacks are called on the single upload thread, which has terminated when the loader is destroyed.
+    EXPECT(order == expectedOrder);
+}
+
+GPU_TEST(AsyncTextureLoader_Cancel)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    bool callbackCalled = false;
+    {
+        AsyncTextureLoader loader(pDevice, 1);
+
+        auto token = AsyncTextureLoader::CancellationToken::create();
+        token.cancel();
+
+        auto future = loader.loadFromFile(
+            getTestPath(0), false, false, ResourceBindFlags::ShaderResource,
+            [&callbackCalled](ref<Texture> pTexture, const AsyncTextureLoader::Analysis& analysis)
+            { callbackCalled = !pTexture && !analysis; },
+            0, token
+        );
+        EXPECT(future.get() == nullptr);
+
+        // Requests without a token are not affected.
+        EXPECT(loader.loadFromFile(getTestPath(1), false, false).get() != nullptr);
+
+        auto stats = loader.getStats();
+        EXPECT_EQ(stats.cancelledCount, 1);
+        EXPECT_EQ(stats.uploadedCount, 1);
+    }
+
+    EXPECT(callbackCalled);
+}
+} // namespace Falcor
@@ -0,0 +1,271 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/EXRWriter.h"
+#include "Utils/Image/Bitmap.h"
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+float getTestValue(uint32_t x, uint32_t y, uint32_t c)
+{
+    return float(x) + float(y) * 0.5f + float(c) * 1000.f;
+}
+} // namespace
+
+CPU_TEST(EXRWriter)
+{
+    // Use a size that is not a multiple of the tile size to get partial tiles.
+    const uint32_t width = 100, height = 70;
+    EXRWriter::Options options;
+    options.tileSize = 32;
+
+    const std::vector<EXRWriter::Layer> layers = {
+        {"", TextureChannelFlags::RGBA, false},
+        {"depth", TextureChannelFlags::Red, true},
+    };
+
+    const auto path = getTempFilePath().replace_extension("exr");
+    {
+        EXRWriter writer(path, width, height, layers, options);
+        EXPECT_EQ(writer.getTileSize(), options.tileSize);
+
+        std::vector<float> data;
+        while (!writer.isComplete())
+        {
+            const uint2 bandRows = writer.getBandRows();
+            const uint32_t tileY = bandRows.x / options.tileSize;
+
+            // Write the color layer as tiles.
+            for (uint32_t tileX = 0; tileX * options.tileSize < width; tileX++)
+            {
+                const uint32_t x0 = tileX * options.tileSize;
+                const uint32_t x1 = std::min(x0 + options.tileSize, width);
+                data.clear();
+                for (uint32_t y = bandRows.x; y < bandRows.y; y++)
+                    for (uint32_t x = x0; x < x1; x++)
+                        for (uint32_t c = 0; c < 4; c++)
+                            data.push_back(getTestValue(x, y, c));
+                writer.writeTile(0, tileX, tileY, data.data());
+            }
+
+            // Write the depth layer as rows.
+            EXPECT(!writer.isComplete());
+            data.assign((size_t)width * (bandRows.y - bandRows.x), 1.f);
+            writer.writeRows(1, bandRows.x, bandRows.y - bandRows.x, data.data());
+        }
+        writer.finish();
+    }
+
+    auto pBitmap = Bitmap::createFromFile(path, true);
+    ASSERT(pBitmap != nullptr);
+    ASSERT_EQ(pBitmap->getWidth(), width);
+    ASSERT_EQ(pBitmap->getHeight(), height);
+    ASSERT_EQ(pBitmap->getFormat(), ResourceFormat::RGBA32Float);
+
+    const float* pData = reinterpret_cast<const float*>(pBitmap->getData());
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+                EXPECT_EQ(pData[((size_t)y * width + x) * 4 + c], getTestValue(x, y, c)) << "x=" << x << " y=" << y << " c=" << c;
+        }
+    }
+
+    pBitmap.reset();
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(EXRWriterLayers)
+{
+    const uint32_t width = 40, height = 24;
+    EXRWriter::Options options;
+    options.tileSize = 16;
+
+    // A half precision default layer and named full and half precision layers with channel subsets.
+    const std::vector<EXRWriter::Layer> layers = {
+        {"", TextureChannelFlags::RGB, true},
+        {"normal", TextureChannelFlags::RGB, false},
+        {"depth", TextureChannelFlags::Red, true},
+        {"mask", TextureChannelFlags::Green | TextureChannelFlags::Alpha, false},
+    };
+
+    // Values are chosen to be exactly representable in half precision, except for one channel of the half layer.
+    auto getValue = [](size_t layer, uint32_t x, uint32_t y, uint32_t c)
+    { return float(layer * 64 + c * 16) + float(x) * 0.25f + float(y) * 0.5f; };
+    const float kInexact = 1.f / 3.f;
+
+    const auto path = getTempFilePath().replace_extension("exr");
+    {
+        EXRWriter writer(path, width, height, layers, options);
+        std::vector<float> data;
+        while (!writer.isComplete())
+        {
+            const uint2 bandRows = writer.getBandRows();
+            for (size_t i = 0; i < layers.size(); i++)
+            {
+                data.clear();
+                for (uint32_t y = bandRows.x; y < bandRows.y; y++)
+                {
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        for (uint32_t c = 0; c < 4; c++)
+                        {
+                            if (!is_set(layers[i].channels, TextureChannelFlags(1u << c)))
+                                continue;
+                            data.push_back(i == 0 && c == 2 ? kInexact : getValue(i, x, y, c));
+                        }
+                    }
+                }
+                writer.writeRows((uint32_t)i, bandRows.x, bandRows.y - bandRows.x, data.data());
+            }
+        }
+        writer.finish();
+    }
+
+    const char* kChannelNames[] = {"R", "G", "B", "A"};
+    auto getChannelName = [&](size_t layer, uint32_t c)
+    { return layers[layer].name.empty() ? std::string(kChannelNames[c]) : layers[layer].name + "." + kChannelNames[c]; };
+
+    auto pFile = std::make_unique<Imf::InputFile>(path.string().c_str());
+    const Imf::Header& header = pFile->header();
+    const Imath::Box2i dataWindow = header.dataWindow();
+    EXPECT_EQ(dataWindow.max.x - dataWindow.min.x + 1, (int)width);
+    EXPECT_EQ(dataWindow.max.y - dataWindow.min.y + 1, (int)height);
+
+    // Check the channel names and types.
+    size_t channelCount = 0;
+    for (auto it = header.channels().begin(); it != header.channels().end(); ++it)
+        channelCount++;
+    EXPECT_EQ(channelCount, 9);
+
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            const std::string name = getChannelName(i, c);
+            const Imf::Channel* pChannel = header.channels().findChannel(name);
+            if (!is_set(layers[i].channels, TextureChannelFlags(1u << c)))
+            {
+                EXPECT(pChannel == nullptr) << name;
+                continue;
+            }
+            ASSERT(pChannel != nullptr) << name;
+            EXPECT_EQ(pChannel->type, layers[i].useHalf ? Imf::HALF : Imf::FLOAT) << name;
+        }
+    }
+
+    // Read all channels as 32-bit floats and compare the values.
+    std::vector<std::vector<float>> channelData;
+    Imf::FrameBuffer frameBuffer;
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (!is_set(layers[i].channels, TextureChannelFlags(1u << c)))
+                continue;
+            auto& buffer = channelData.emplace_back((size_t)width * height);
+            char* pBase = reinterpret_cast<char*>(buffer.data());
+            frameBuffer.insert(getChannelName(i, c), Imf::Slice(Imf::FLOAT, pBase, sizeof(float), width * sizeof(float)));
+        }
+    }
+    pFile->setFrameBuffer(frameBuffer);
+    pFile->readPixels(dataWindow.min.y, dataWindow.max.y);
+    pFile.reset();
+
+    size_t channelIndex = 0;
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (!is_set(layers[i].channels, TextureChannelFlags(1u << c)))
+                continue;
+            const auto& buffer = channelData[channelIndex++];
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    const float value = buffer[(size_t)y * width + x];
+                    if (i == 0 && c == 2)
+                    {
+                        // Rounded to half precision.
+                        EXPECT_NE(value, kInexact);
+                        EXPECT_LE(std::abs(value - kInexact), 1e-3f);
+                    }
+                    else
+                    {
+                        EXPECT_EQ(value, getValue(i, x, y, c)) << getChannelName(i, c) << " x=" << x << " y=" << y;
+                    }
+                }
+            }
+        }
+    }
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(EXRWriterInvalidRegion)
+{
+    EXRWriter::Options options;
+    options.tileSize = 16;
+    const auto path = getTempFilePath().replace_extension("exr");
+    {
+        EXRWriter writer(path, 32, 32, {{"", TextureChannelFlags::Red, false}}, options);
+        std::vector<float> data(32 * 32, 0.f);
+
+        // Rows outside of the current band are rejected.
+        bool thrown = false;
+        try
+        {
+            writer.writeRows(0, 16, 16, data.data());
+        }
+        catch (const ArgumentError&)
+        {
+            thrown = true;
+        }
+        EXPECT(thrown);
+
+        writer.writeRows(0, 0, 16, data.data());
+        EXPECT_EQ(writer.getBandRows().x, 16);
+        EXPECT_EQ(writer.getBandRows().y, 32);
+        writer.writeRows(0, 16, 16, data.data());
+        writer.finish();
+    }
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
@@ -0,0 +1,165 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/PixelConversion.h"
+#include <fstd/bit.h> // TODO C++20: Replace with <bit>
+#include <random>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+std::mt19937 rng;
+
+void testCopyChannels(CPUUnitTestContext& ctx, uint32_t width, uint32_t height)
+{
+    for (uint32_t srcChannelCount = 1; srcChannelCount <= 4; srcChannelCount++)
+    {
+        for (uint32_t dstChannelCount = 1; dstChannelCount <= 4; dstChannelCount++)
+        {
+            for (bool swapRB : {false, true})
+            {
+                std::vector<float> src(width * height * srcChannelCount);
+                for (auto& v : src)
+                    v = (float)rng();
+
+                std::vector<float> dst(width * height * dstChannelCount);
+                copyChannels<float>(
+                    width, height, src.data(), srcChannelCount, width * srcChannelCount * sizeof(float), dst.data(), dstChannelCount,
+                    width * dstChannelCount * sizeof(float), 0.5f, swapRB
+                );
+
+                for (uint32_t i = 0; i < width * height; i++)
+                {
+                    float expected[4] = {0.f, 0.f, 0.f, 0.5f};
+                    for (uint32_t c = 0; c < srcChannelCount; c++)
+                        expected[c] = src[i * srcChannelCount + c];
+                    if (swapRB)
+                        std::swap(expected[0], expected[2]);
+                    for (uint32_t c = 0; c < dstChannelCount; c++)
+                        EXPECT_EQ(dst[i * dstChannelCount + c], expected[c])
+                            << "i=" << i << " c=" << c << " src=" << srcChannelCount << " dst=" << dstChannelCount << " swapRB=" << swapRB;
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+CPU_TEST(PixelConversion_CopyChannels)
+{
+    testCopyChannels(ctx, 1, 1);
+    testCopyChannels(ctx, 7, 3);
+    // Large enough to be split into tasks.
+    testCopyChannels(ctx, 1023, 129);
+}
+
+CPU_TEST(PixelConversion_CopyChannelsFlip)
+{
+    // Copy RGBA to RGB with a negative row pitch to flip the image.
+    const uint32_t width = 513;
+    const uint32_t height = 200;
+    std::vector<float> src(width * height * 4);
+    for (auto& v : src)
+        v = (float)rng();
+
+    std::vector<float> dst(width * height * 3);
+    copyChannels<float>(
+        width, height, src.data(), 4, width * 4 * sizeof(float), dst.data() + (height - 1) * width * 3, 3,
+        -ptrdiff_t(width * 3 * sizeof(float))
+    );
+
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+            for (uint32_t c = 0; c < 3; c++)
+                EXPECT_EQ(dst[((height - 1 - y) * width + x) * 3 + c], src[(y * width + x) * 4 + c]) << "x=" << x << " y=" << y;
+}
+
+CPU_TEST(PixelConversion_ConvertHalfToRGBA32Float)
+{
+    const uint32_t width = 1001;
+    const uint32_t height = 97;
+
+    for (ResourceFormat format : {ResourceFormat::R16Float, ResourceFormat::RG16Float, ResourceFormat::RGBA16Float})
+    {
+        const uint32_t channelCount = getFormatChannelCount(format);
+        std::vector<float16_t> src(width * height * channelCount);
+        for (auto& v : src)
+            v = fstd::bit_cast<float16_t>((uint16_t)rng());
+
+        std::vector<float> dst(width * height * 4);
+        convertToRGBA32Float(format, width, height, src.data(), width * channelCount * sizeof(float16_t), dst.data(), width * 16);
+
+        for (uint32_t i = 0; i < width * height; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                float expected = c < channelCount ? (float)src[i * channelCount + c] : (c == 3 ? 1.f : 0.f);
+                EXPECT_EQ(fstd::bit_cast<uint32_t>(dst[i * 4 + c]), fstd::bit_cast<uint32_t>(expected))
+                    << "i=" << i << " c=" << c << " format=" << to_string(format);
+            }
+        }
+    }
+}
+
+CPU_TEST(PixelConversion_ConvertIntToRGBA32Float)
+{
+    const uint32_t width = 333;
+    const uint32_t height = 45;
+
+    {
+        std::vector<uint16_t> src(width * height * 2);
+        for (auto& v : src)
+            v = (uint16_t)rng();
+
+        std::vector<float> dst(width * height * 4);
+        convertToRGBA32Float(ResourceFormat::RG16Uint, width, height, src.data(), width * 4, dst.data(), width * 16);
+
+        for (uint32_t i = 0; i < width * height; i++)
+        {
+            EXPECT_EQ(dst[i * 4 + 0], (float)src[i * 2 + 0] / 65535.f);
+            EXPECT_EQ(dst[i * 4 + 1], (float)src[i * 2 + 1] / 65535.f);
+            EXPECT_EQ(dst[i * 4 + 2], 0.f);
+            EXPECT_EQ(dst[i * 4 + 3], 1.f);
+        }
+    }
+
+    {
+        std::vector<int32_t> src(width * height * 4);
+        for (auto& v : src)
+            v = (int32_t)rng();
+
+        std::vector<float> dst(width * height * 4);
+        convertToRGBA32Float(ResourceFormat::RGBA32Int, width, height, src.data(), width * 16, dst.data(), width * 16);
+
+        for (uint32_t i = 0; i < width * height * 4; i++)
+            EXPECT_EQ(dst[i], (float)src[i] / (float)std::numeric_limits<int32_t>::max());
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,176 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/TextureBaker.h"
+#include <vector>
+
+namespace Falcor
+{
+CPU_TEST(TextureBaker_CompressionMode)
+{
+    using Usage = TextureBaker::Usage;
+    using Mode = ImageIO::CompressionMode;
+
+    auto choose = [](ResourceFormat format, Usage usage, bool hasAlpha = false, bool compactColor = false)
+    { return TextureBaker::chooseCompressionMode(format, usage, hasAlpha, compactColor); };
+
+    EXPECT(choose(ResourceFormat::BGRA8Unorm, Usage::Color) == Mode::BC7);
+    EXPECT(choose(ResourceFormat::BGRX8Unorm, Usage::Color, false, true) == Mode::BC1);
+    EXPECT(choose(ResourceFormat::BGRA8Unorm, Usage::Color, true, true) == Mode::BC7);
+    EXPECT(choose(ResourceFormat::RGBA16Float, Usage::Color) == Mode::BC6);
+    EXPECT(choose(ResourceFormat::RGB32Float, Usage::Color) == Mode::BC6);
+
+    // Float images that BC6H can't store are stored uncompressed instead of being clamped.
+    EXPECT(choose(ResourceFormat::RGBA16Float, Usage::Color, true) == Mode::None);
+    EXPECT(choose(ResourceFormat::RGBA32Float, Usage::Color, true, true) == Mode::None);
+    EXPECT(choose(ResourceFormat::RG32Float, Usage::Color) == Mode::None);
+    EXPECT(choose(ResourceFormat::R16Float, Usage::Color) == Mode::None);
+    EXPECT(choose(ResourceFormat::R32Float, Usage::Scalar) == Mode::None);
+
+    EXPECT(choose(ResourceFormat::R8Unorm, Usage::Color) == Mode::BC4);
+    EXPECT(choose(ResourceFormat::RG8Unorm, Usage::Color) == Mode::BC5);
+    EXPECT(choose(ResourceFormat::BGRX8Unorm, Usage::Normal) == Mode::BC5);
+    EXPECT(choose(ResourceFormat::RGBA32Float, Usage::Normal) == Mode::BC5);
+    EXPECT(choose(ResourceFormat::BGRA8Unorm, Usage::Scalar) == Mode::BC4);
+    EXPECT(choose(ResourceFormat::BGRA8Unorm, Usage::Scalar, true) == Mode::BC4);
+    EXPECT(choose(ResourceFormat::BGRA8Unorm, Usage::Lossless) == Mode::None);
+}
+
+CPU_TEST(TextureBaker_Cache)
+{
+    std::filesystem::path cacheDirectory = getTempFilePath();
+    std::filesystem::path path = getTempFilePath().replace_extension("png");
+    std::filesystem::path copyPath = getTempFilePath().replace_extension("png");
+
+    // Write a test image.
+    const uint32_t width = 64, height = 32;
+    std::vector<uint8_t> data(width * height * 4);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = uint8_t(i * 7);
+    Bitmap::saveImage(
+        path, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, true /* top-down */,
+        data.data()
+    );
+    std::filesystem::copy_file(path, copyPath, std::filesystem::copy_options::overwrite_existing);
+
+    TextureBaker::Options options;
+    options.cacheDirectory = cacheDirectory;
+
+    {
+        TextureBaker baker(options);
+
+        // Baking produces a block-compressed DDS file.
+        auto colorPath = baker.bake(path, TextureBaker::Usage::Color);
+        ASSERT(!colorPath.empty());
+        EXPECT(colorPath.parent_path() == cacheDirectory);
+        auto pBitmap = ImageIO::loadBitmapFromDDS(colorPath);
+        ASSERT(pBitmap != nullptr);
+        EXPECT_EQ(pBitmap->getWidth(), width);
+        EXPECT_EQ(pBitmap->getHeight(), height);
+        EXPECT(pBitmap->getFormat() == ResourceFormat::BC7Unorm);
+
+        // Normal maps are baked to a different file.
+        auto normalPath = baker.bake(path, TextureBaker::Usage::Normal);
+        EXPECT(!normalPath.empty());
+        EXPECT(normalPath != colorPath);
+        pBitmap = ImageIO::loadBitmapFromDDS(normalPath);
+        ASSERT(pBitmap != nullptr);
+        EXPECT(pBitmap->getFormat() == ResourceFormat::BC5Unorm);
+
+        // Files with identical contents map to the same cache entry.
+        EXPECT(baker.bake(copyPath, TextureBaker::Usage::Color) == colorPath);
+
+        // DDS files are not baked again.
+        EXPECT(baker.bake(colorPath, TextureBaker::Usage::Color) == colorPath);
+
+        // Missing files fail.
+        EXPECT(baker.bake(cacheDirectory / "missing.png", TextureBaker::Usage::Color).empty());
+
+        auto stats = baker.getStats();
+        EXPECT_EQ(stats.bakedCount, 2);
+        EXPECT_EQ(stats.cacheHitCount, 1);
+        EXPECT_EQ(stats.failedCount, 1);
+    }
+
+    // The cache persists across instances.
+    {
+        TextureBaker baker(options);
+        EXPECT(!baker.bake(path, TextureBaker::Usage::Color).empty());
+        auto stats = baker.getStats();
+        EXPECT_EQ(stats.bakedCount, 0);
+        EXPECT_EQ(stats.cacheHitCount, 1);
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(copyPath);
+    std::filesystem::remove_all(cacheDirectory);
+}
+
+CPU_TEST(TextureBaker_FloatAlpha)
+{
+    std::filesystem::path cacheDirectory = getTempFilePath();
+    std::filesystem::path path = getTempFilePath().replace_extension("exr");
+
+    // Write an HDR image with transparent texels.
+    const uint32_t width = 16, height = 16;
+    std::vector<float> data(width * height * 4);
+    for (size_t i = 0; i < width * height; i++)
+    {
+        data[i * 4 + 0] = 4.f;
+        data[i * 4 + 1] = 0.5f;
+        data[i * 4 + 2] = 2.f;
+        data[i * 4 + 3] = (i % 3 == 0) ? 0.25f : 1.f;
+    }
+    Bitmap::saveImage(
+        path, width, height, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA32Float,
+        true /* top-down */, reinterpret_cast<const uint8_t*>(data.data())
+    );
+
+    TextureBaker::Options options;
+    options.cacheDirectory = cacheDirectory;
+
+    {
+        TextureBaker baker(options);
+
+        // BC6H can't store alpha, so the image is stored uncompressed. Alpha is detected without compactColor set.
+        auto bakedPath = baker.bake(path, TextureBaker::Usage::Color);
+        ASSERT(!bakedPath.empty());
+        auto pBitmap = ImageIO::loadBitmapFromDDS(bakedPath);
+        ASSERT(pBitmap != nullptr);
+        EXPECT(!isCompressedFormat(pBitmap->getFormat()));
+        EXPECT(pBitmap->getFormat() == ResourceFormat::RGBA32Float);
+
+        const float* pTexels = reinterpret_cast<const float*>(pBitmap->getData());
+        EXPECT_EQ(pTexels[3], 0.25f);
+        EXPECT_EQ(pTexels[7], 1.f);
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove_all(cacheDirectory);
+}
+} // namespace Falcor
@@ -28,6 +28,9 @@
 #include "Testing/UnitTest.h"
 #include "Utils/Image/TextureManager.h"
 
+#include <chrono>
+#include <thread>
+
 namespace Falcor
 {
 GPU_TEST(TextureManager_LoadMips)
@@ -51,4 +54,167 @@ GPU_TEST(TextureManager_LoadMips)
     EXPECT_EQ(tex->getMipCount(), 3);
     EXPECT_EQ(tex->getArraySize(), 1);
 }
+
+GPU_TEST(TextureManager_Dedup)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    TextureManager textureManager(pDevice, 10);
+
+    // Copy a texture to a different path.
+    std::filesystem::path path = getRuntimeDirectory() / "data/tests/texture1.png";
+    std::filesystem::path copyPath = getTempFilePath();
+    std::filesystem::copy_file(path, copyPath, std::filesystem::copy_options::overwrite_existing);
+
+    // Textures with identical contents share a handle.
+    auto handle = textureManager.loadTexture(path, false, false, ResourceBindFlags::ShaderResource, false);
+    auto copyHandle = textureManager.loadTexture(copyPath, false, false, ResourceBindFlags::ShaderResource, false);
+    ASSERT(handle.isValid());
+    EXPECT(copyHandle == handle);
+
+    // Textures loaded with different flags don't.
+    auto srgbHandle = textureManager.loadTexture(copyPath, false, true, ResourceBindFlags::ShaderResource, false);
+    EXPECT(srgbHandle.isValid());
+    EXPECT(!(srgbHandle == handle));
+
+    auto stats = textureManager.getStats();
+    EXPECT_EQ(stats.textureCount, 2);
+    EXPECT_EQ(stats.textureDedupCount, 1);
+    EXPECT_EQ(stats.textureDedupMemoryInBytes, textureManager.getTexture(handle)->getTextureSizeInBytes());
+
+    // Removing the texture removes it for all paths.
+    textureManager.removeTexture(handle);
+    EXPECT(!textureManager.getTextureDesc(copyHandle).isValid());
+    stats = textureManager.getStats();
+    EXPECT_EQ(stats.textureCount, 1);
+    EXPECT_EQ(stats.textureDedupCount, 0);
+
+    std::filesystem::remove(copyPath);
+}
+
+GPU_TEST(TextureManager_DedupDeferred)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    TextureManager textureManager(pDevice, 10);
+
+    std::filesystem::path path = getRuntimeDirectory() / "data/tests/texture1.png";
+    std::filesystem::path copyPath = getTempFilePath();
+    std::filesystem::copy_file(path, copyPath, std::filesystem::copy_options::overwrite_existing);
+
+    // Handles of deferred loads are returned before loading. Duplicates keep their handle but share the texture.
+    textureManager.beginDeferredLoading();
+    auto handle = textureManager.loadTexture(path, false, false);
+    auto copyHandle = textureManager.loadTexture(copyPath, false, false);
+    textureManager.endDeferredLoading();
+
+    ASSERT(handle.isValid());
+    ASSERT(copyHandle.isValid());
+    EXPECT(!(copyHandle == handle));
+    EXPECT(textureManager.getTexture(handle) != nullptr);
+    EXPECT(textureManager.getTexture(copyHandle) == textureManager.getTexture(handle));
+
+    auto stats = textureManager.getStats();
+    EXPECT_EQ(stats.textureCount, 1);
+    EXPECT_EQ(stats.textureDedupCount, 1);
+
+    // The texture stays alive until all handles sharing it are removed.
+    auto pTexture = textureManager.getTexture(handle);
+    textureManager.removeTexture(handle);
+    EXPECT(textureManager.getTexture(copyHandle) == pTexture);
+    EXPECT(textureManager.findTexture(pTexture.get()) == copyHandle);
+    stats = textureManager.getStats();
+    EXPECT_EQ(stats.textureCount, 1);
+    EXPECT_EQ(stats.textureDedupCount, 0);
+
+    std::filesystem::remove(copyPath);
+}
+
+GPU_TEST(TextureManager_Residency)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = pDevice->getRenderContext();
+
+    TextureManager textureManager(pDevice, 10);
+    TextureResidency::Options options;
+    options.mipTailDimension = 8;
+    textureManager.enableResidency(options);
+
+    // Only the mip tail is loaded. The 33x59 texture has 6 mips and a tail starting at the 4x7 mip.
+    std::filesystem::path path = getRuntimeDirectory() / "data/tests/texture1.png";
+    auto handle = textureManager.loadTexture(path, true, false, ResourceBindFlags::ShaderResource, false);
+    ASSERT(handle.isValid());
+    auto pTail = textureManager.getTexture(handle);
+    ASSERT(pTail != nullptr);
+    EXPECT_EQ(pTail->getWidth(), 4);
+    EXPECT_EQ(pTail->getHeight(), 7);
+    EXPECT_EQ(pTail->getMipCount(), 3);
+    EXPECT(textureManager.findTexture(pTail.get()) == handle);
+
+    // Finer mips are streamed in asynchronously over several updates.
+    auto startTime = std::chrono::steady_clock::now();
+    ref<Texture> pTexture = pTail;
+    while (pTexture->getWidth() != 33 && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10))
+    {
+        textureManager.requestMipLevel(handle, 0);
+        textureManager.updateResidency(pRenderContext);
+        pTexture = textureManager.getTexture(handle);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(pTexture->getWidth(), 33);
+    EXPECT_EQ(pTexture->getHeight(), 59);
+    EXPECT_EQ(pTexture->getMipCount(), 6);
+
+    // The streamed texture matches the fully loaded texture.
+    ref<Texture> pReference = Texture::createFromFile(pDevice, path, true, false);
+    ASSERT(pReference != nullptr);
+    EXPECT(pRenderContext->readTextureSubresource(pTexture.get(), 0) == pRenderContext->readTextureSubresource(pReference.get(), 0));
+
+    // Evicting all finer mips returns the mip tail.
+    textureManager.setResidencyBudget(0);
+    EXPECT(textureManager.updateResidency(pRenderContext));
+    EXPECT(textureManager.getTexture(handle) == pTail);
+}
+
+GPU_TEST(TextureManager_Baking)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    TextureManager textureManager(pDevice, 10);
+    TextureBaker::Options options;
+    options.cacheDirectory = getTempFilePath();
+    textureManager.enableTextureBaking(options);
+
+    // Write a test image with dimensions that are a multiple of the block size.
+    std::filesystem::path path = getTempFilePath().replace_extension("png");
+    std::vector<uint8_t> data(64 * 64 * 4, 128);
+    Bitmap::saveImage(
+        path, 64, 64, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, true /* top-down */, data.data()
+    );
+
+    // The format depends on the usage of the texture.
+    auto colorHandle = textureManager.loadTexture(path, true, true, ResourceBindFlags::ShaderResource, false);
+    auto normalHandle = textureManager.loadTexture(
+        path, true, false, ResourceBindFlags::ShaderResource, false, nullptr, nullptr, TextureBaker::Usage::Normal
+    );
+    auto pColor = textureManager.getTexture(colorHandle);
+    auto pNormal = textureManager.getTexture(normalHandle);
+    ASSERT(pColor != nullptr);
+    ASSERT(pNormal != nullptr);
+    EXPECT(pColor->getFormat() == ResourceFormat::BC7UnormSrgb);
+    EXPECT(pNormal->getFormat() == ResourceFormat::BC5Unorm);
+    EXPECT_EQ(pColor->getMipCount(), 7);
+    EXPECT_EQ(pNormal->getMipCount(), 7);
+
+    // Baked textures keep the path of their source file.
+    EXPECT(std::filesystem::equivalent(pColor->getSourcePath(), path));
+    EXPECT(std::filesystem::equivalent(pNormal->getSourcePath(), path));
+
+    auto stats = textureManager.getTextureBakingStats();
+    EXPECT_EQ(stats.bakedCount, 2);
+    EXPECT_EQ(stats.failedCount, 0);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove_all(options.cacheDirectory);
+}
 } // namespace Falcor
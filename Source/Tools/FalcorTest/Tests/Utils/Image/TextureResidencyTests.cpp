@@ -0,0 +1,348 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/TextureResidency.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+// 4 mips with mip 2 and 3 in the tail. The tail is 5 bytes, the full texture 85 bytes.
+const std::vector<uint64_t> kMipSizes = {64, 16, 4, 1};
+const uint32_t kTailMip = 2;
+
+TextureResidency::Options getOptions(uint64_t budgetInBytes)
+{
+    TextureResidency::Options options;
+    options.budgetInBytes = budgetInBytes;
+    return options;
+}
+
+std::vector<uint64_t> getMipSizes(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t bytesPerTexel)
+{
+    std::vector<uint64_t> mipSizes(mipCount);
+    for (uint32_t i = 0; i < mipCount; i++)
+        mipSizes[i] = uint64_t(std::max(1u, width >> i)) * std::max(1u, height >> i) * bytesPerTexel;
+    return mipSizes;
+}
+} // namespace
+
+CPU_TEST(TextureResidency_Helpers)
+{
+    EXPECT_EQ(TextureResidency::computeTailMip(4096, 4096, 13, 128), 5);
+    EXPECT_EQ(TextureResidency::computeTailMip(4096, 1024, 13, 128), 5);
+    EXPECT_EQ(TextureResidency::computeTailMip(4096, 4096, 3, 128), 2);
+    EXPECT_EQ(TextureResidency::computeTailMip(128, 128, 8, 128), 0);
+    EXPECT_EQ(TextureResidency::computeTailMip(4096, 4096, 13, 128, 4), 5);
+    // Mip 1 is 50x30, which is not a multiple of the block size.
+    EXPECT_EQ(TextureResidency::computeTailMip(100, 60, 7, 16, 4), 0);
+    EXPECT_EQ(TextureResidency::computeTailMip(100, 60, 7, 16, 1), 3);
+
+    // 1024 texels over 1 unit at distance 10 with 1 mrad pixels is 10.24 texels per pixel.
+    EXPECT_EQ(TextureResidency::computeMipFromDistance(1024, 512, 1.f, 10.f, 0.001f), 3);
+    EXPECT_EQ(TextureResidency::computeMipFromDistance(1024, 512, 1.f, 0.5f, 0.001f), 0);
+    EXPECT_EQ(TextureResidency::computeMipFromDistance(1024, 512, 0.f, 10.f, 0.001f), 0);
+}
+
+CPU_TEST(TextureResidency_StreamIn)
+{
+    TextureResidency residency(getOptions(1000));
+
+    auto id = residency.addTexture(kMipSizes, kTailMip);
+    EXPECT_EQ(residency.getResidentMip(id), kTailMip);
+    EXPECT_EQ(residency.getStats().residentBytes, 5);
+    EXPECT_EQ(residency.getStats().tailBytes, 5);
+
+    // No requests, no changes.
+    EXPECT(residency.update().empty());
+
+    // Requests coarser than the tail don't change anything.
+    residency.requestMip(id, 3);
+    EXPECT(residency.update().empty());
+
+    // Multiple requests are combined.
+    residency.requestMip(id, 1);
+    residency.requestMip(id, 0);
+    residency.requestMip(id, 1);
+    auto changes = residency.update();
+    ASSERT(changes.size() == 1);
+    EXPECT_EQ(changes[0].id, id);
+    EXPECT_EQ(changes[0].previousMip, 2);
+    EXPECT_EQ(changes[0].residentMip, 0);
+    EXPECT(changes[0].isStreamIn());
+    EXPECT_EQ(residency.getResidentMip(id), 0);
+
+    const auto& stats = residency.getStats();
+    EXPECT_EQ(stats.residentBytes, 85);
+    EXPECT_EQ(stats.requestedBytes, 85);
+    EXPECT_EQ(stats.streamedInBytes, 80);
+    EXPECT_EQ(stats.streamInCount, 2);
+    EXPECT_EQ(stats.evictionCount, 0);
+
+    // Resident mips are kept while within budget, even if not requested.
+    EXPECT(residency.update().empty());
+    EXPECT_EQ(residency.getResidentMip(id), 0);
+}
+
+CPU_TEST(TextureResidency_EvictLRU)
+{
+    // Budget fits the tails and one full texture.
+    TextureResidency residency(getOptions(15 + 80));
+
+    auto a = residency.addTexture(kMipSizes, kTailMip);
+    auto b = residency.addTexture(kMipSizes, kTailMip);
+    auto c = residency.addTexture(kMipSizes, kTailMip);
+
+    residency.requestMip(a, 0);
+    residency.update();
+    EXPECT_EQ(residency.getResidentMip(a), 0);
+    EXPECT_EQ(residency.getStats().residentBytes, 95);
+
+    // Requesting b evicts a, as it's not used anymore.
+    residency.requestMip(b, 0);
+    auto changes = residency.update();
+    EXPECT_EQ(changes.size(), 2);
+    EXPECT_EQ(residency.getResidentMip(a), 2);
+    EXPECT_EQ(residency.getResidentMip(b), 0);
+    EXPECT_EQ(residency.getStats().residentBytes, 95);
+
+    // Requesting mip 1 of a and c only needs to evict mip 0 of b.
+    residency.requestMip(a, 1);
+    residency.requestMip(c, 1);
+    changes = residency.update();
+    EXPECT_EQ(changes.size(), 3);
+    EXPECT_EQ(residency.getResidentMip(a), 1);
+    EXPECT_EQ(residency.getResidentMip(b), 1);
+    EXPECT_EQ(residency.getResidentMip(c), 1);
+    EXPECT_EQ(residency.getStats().residentBytes, 63);
+    EXPECT_EQ(residency.getStats().evictionCount, 3);
+    EXPECT_EQ(residency.getStats().evictedBytes, 144);
+
+    // Nothing is evicted if the requested mips don't fit the budget.
+    residency.requestMip(a, 0);
+    residency.requestMip(c, 1);
+    EXPECT(residency.update().empty());
+    EXPECT_EQ(residency.getStats().residentBytes, 63);
+
+    // Mips finer than requested are evicted after the least recently used texture.
+    residency.requestMip(a, 2);
+    residency.requestMip(c, 0);
+    changes = residency.update();
+    EXPECT_EQ(changes.size(), 3);
+    EXPECT_EQ(residency.getResidentMip(a), 2);
+    EXPECT_EQ(residency.getResidentMip(b), 2);
+    EXPECT_EQ(residency.getResidentMip(c), 0);
+    EXPECT_EQ(residency.getStats().residentBytes, 95);
+}
+
+CPU_TEST(TextureResidency_Budget)
+{
+    TextureResidency residency(getOptions(1000));
+
+    std::vector<TextureResidency::TextureID> ids;
+    for (size_t i = 0; i < 4; i++)
+        ids.push_back(residency.addTexture(kMipSizes, kTailMip));
+
+    for (auto id : ids)
+        residency.requestMip(id, 0);
+    residency.update();
+    EXPECT_EQ(residency.getStats().residentBytes, 4 * 85);
+
+    // Lowering the budget evicts textures on the next update.
+    residency.setBudget(100);
+    auto changes = residency.update();
+    EXPECT_EQ(changes.size(), 3);
+    EXPECT_LE(residency.getStats().residentBytes, 100);
+    for (const auto& change : changes)
+        EXPECT(!change.isStreamIn());
+
+    // Requested mips are evicted if the budget can't be met otherwise.
+    residency.setBudget(40);
+    for (auto id : ids)
+        residency.requestMip(id, 0);
+    residency.update();
+    EXPECT_EQ(residency.getStats().residentBytes, 4 * 5 + 16);
+    for (auto id : ids)
+        EXPECT_GE(residency.getResidentMip(id), 1);
+}
+
+CPU_TEST(TextureResidency_MaxStreamIn)
+{
+    auto options = getOptions(1000);
+    options.maxStreamInBytesPerUpdate = 20;
+    TextureResidency residency(options);
+
+    auto a = residency.addTexture(kMipSizes, kTailMip);
+    auto b = residency.addTexture({256, 64, 16, 4, 1}, 3);
+
+    // Textures missing the most mips are streamed in first.
+    residency.requestMip(a, 0);
+    residency.requestMip(b, 0);
+    auto changes = residency.update();
+    ASSERT(changes.size() == 1);
+    EXPECT_EQ(changes[0].id, b);
+    EXPECT_EQ(residency.getResidentMip(b), 2);
+
+    // At least one mip is streamed in, even if larger than the limit.
+    residency.requestMip(a, 0);
+    residency.requestMip(b, 0);
+    residency.update();
+    EXPECT_EQ(residency.getResidentMip(a), 1);
+    EXPECT_EQ(residency.getResidentMip(b), 2);
+
+    residency.requestMip(a, 0);
+    residency.requestMip(b, 0);
+    residency.update();
+    EXPECT_EQ(residency.getResidentMip(b), 1);
+}
+
+CPU_TEST(TextureResidency_Remove)
+{
+    TextureResidency residency(getOptions(1000));
+
+    auto a = residency.addTexture(kMipSizes, kTailMip);
+    residency.requestMip(a, 0);
+    residency.update();
+
+    // Remove a texture with a pending request and reuse its ID.
+    auto b = residency.addTexture(kMipSizes, kTailMip);
+    residency.requestMip(b, 1);
+    residency.removeTexture(b);
+    auto c = residency.addTexture(kMipSizes, kTailMip);
+    EXPECT_EQ(b, c);
+    EXPECT_EQ(residency.getStats().textureCount, 2);
+    EXPECT(residency.update().empty());
+
+    residency.requestMip(c, 1);
+    residency.update();
+    EXPECT_EQ(residency.getResidentMip(c), 1);
+
+    residency.removeTexture(a);
+    residency.removeTexture(c);
+    EXPECT_EQ(residency.getStats().textureCount, 0);
+    EXPECT_EQ(residency.getStats().residentBytes, 0);
+    EXPECT_EQ(residency.getStats().tailBytes, 0);
+
+    // Failed loads are corrected by the caller.
+    auto d = residency.addTexture(kMipSizes, kTailMip);
+    residency.requestMip(d, 0);
+    residency.update();
+    residency.setResidentMip(d, kTailMip);
+    EXPECT_EQ(residency.getResidentMip(d), kTailMip);
+    EXPECT_EQ(residency.getStats().residentBytes, 5);
+}
+
+CPU_TEST(TextureResidency_Benchmark, "Disabled for performance reasons")
+{
+    // Simulate a camera flying over a large set of objects, each with its own texture.
+    const size_t kTextureCount = 20000;
+    const size_t kFrameCount = 1000;
+    const float kWorldSize = 1000.f;
+    const float kObjectSize = 10.f;
+    const float kPixelAngle = 1.f / 4000.f;
+    const float kMaxDistance = 200.f;
+
+    TextureResidency::Options options;
+    options.budgetInBytes = 2ull << 30;
+    TextureResidency residency(options);
+
+    struct Object
+    {
+        float2 position;
+        uint32_t width;
+        uint32_t height;
+        TextureResidency::TextureID id;
+    };
+    std::vector<Object> objects(kTextureCount);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> positionDist(0.f, kWorldSize);
+    std::uniform_int_distribution<uint32_t> sizeDist(9, 12);
+    uint64_t totalBytes = 0;
+    for (auto& object : objects)
+    {
+        object.position = float2(positionDist(rng), positionDist(rng));
+        uint32_t log2Width = sizeDist(rng);
+        uint32_t log2Height = sizeDist(rng);
+        object.width = 1u << log2Width;
+        object.height = 1u << log2Height;
+        uint32_t mipCount = 1 + std::max(log2Width, log2Height);
+        auto mipSizes = getMipSizes(object.width, object.height, mipCount, 4);
+        for (auto size : mipSizes)
+            totalBytes += size;
+        object.id = residency.addTexture(
+            std::move(mipSizes), TextureResidency::computeTailMip(object.width, object.height, mipCount, options.mipTailDimension)
+        );
+    }
+
+    double requestTime = 0.0;
+    double updateTime = 0.0;
+    uint64_t maxResidentBytes = 0;
+    CpuTimer timer;
+    for (size_t frame = 0; frame < kFrameCount; frame++)
+    {
+        float t = float(frame) / kFrameCount;
+        float2 camera = float2(t * kWorldSize, kWorldSize * 0.5f);
+
+        timer.update();
+        for (const auto& object : objects)
+        {
+            float distance = length(object.position - camera);
+            if (distance < kMaxDistance)
+            {
+                uint32_t mip = TextureResidency::computeMipFromDistance(object.width, object.height, kObjectSize, distance, kPixelAngle);
+                residency.requestMip(object.id, mip);
+            }
+        }
+        timer.update();
+        requestTime += timer.delta();
+
+        residency.update();
+        timer.update();
+        updateTime += timer.delta();
+
+        maxResidentBytes = std::max(maxResidentBytes, residency.getStats().residentBytes);
+    }
+
+    const auto& stats = residency.getStats();
+    EXPECT_LE(maxResidentBytes, options.budgetInBytes);
+    logInfo(
+        "TextureResidency: {} textures with {:.1f} GB, budget {:.1f} GB, tails {:.1f} GB, max resident {:.1f} GB", kTextureCount,
+        totalBytes / double(1ull << 30), options.budgetInBytes / double(1ull << 30), stats.tailBytes / double(1ull << 30),
+        maxResidentBytes / double(1ull << 30)
+    );
+    logInfo(
+        "TextureResidency: {} frames, request {:.3f} ms/frame, update {:.3f} ms/frame, streamed in {:.1f} GB, evicted {:.1f} GB",
+        kFrameCount, requestTime * 1000.0 / kFrameCount, updateTime * 1000.0 / kFrameCount,
+        stats.streamedInBytes / double(1ull << 30), stats.evictedBytes / double(1ull << 30)
+    );
+}
+} // namespace Falcor
@@ -27,9 +27,12 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Math/Matrix.h"
+#include "Utils/Math/MatrixSIMD.h"
 
 #include <fmt/format.h>
+#include <cstring>
 #include <iostream>
+#include <random>
 
 namespace Falcor
 {
@@ -275,6 +278,51 @@ CPU_TEST(Matrix_inverse)
     }
 }
 
+CPU_TEST(Matrix_inverseTransposeAffine)
+{
+    EXPECT(math::isAffine(float4x4::identity()));
+    EXPECT(!math::isAffine(math::perspective(math::radians(45.f), 1.f, 0.1f, 100.f)));
+
+    float4x4 T = math::matrixFromTranslation(float3(1, -2, 3));
+    float4x4 R = math::matrixFromQuat(math::quatFromAngleAxis(math::radians(60.f), normalize(float3(1, 1, 1))));
+    float4x4 S = math::matrixFromScaling(float3(2, 0.5f, 3));
+    float4x4 m = mul(mul(T, R), S);
+    EXPECT(math::isAffine(m));
+
+    float4x4 expected = transpose(inverse(m));
+    float4x4 result = math::inverseTransposeAffine(m);
+    for (int r = 0; r < 4; ++r)
+        EXPECT_ALMOST_EQ(result[r], expected[r]);
+}
+
+CPU_TEST(Matrix_SIMD)
+{
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> dist(-10.f, 10.f);
+    auto randomMatrix = [&](bool affine)
+    {
+        float4x4 m;
+        for (int r = 0; r < (affine ? 3 : 4); ++r)
+            for (int c = 0; c < 4; ++c)
+                m[r][c] = dist(rng);
+        return m;
+    };
+    auto bitwiseEqual = [](const float4x4& a, const float4x4& b) { return std::memcmp(&a, &b, sizeof(float4x4)) == 0; };
+
+    // The SIMD kernels must produce exactly the same results as the scalar code.
+    for (uint32_t i = 0; i < 10000; ++i)
+    {
+        float4x4 a = randomMatrix(false);
+        float4x4 b = randomMatrix(false);
+        EXPECT(bitwiseEqual(math::mulSIMD(a, b), mul(a, b)));
+
+        float4x4 m = randomMatrix(true);
+        float4x4 result = math::inverseTransposeAffineSIMD(m);
+        EXPECT(bitwiseEqual(result, math::inverseTransposeAffine(m)));
+        EXPECT(math::isAffine(transpose(result)));
+    }
+}
+
 CPU_TEST(Matrix_extractEulerAngleXYZ)
 {
     {
@@ -27,6 +27,8 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Image/TextureAnalyzer.h"
+#include "Utils/Image/Bitmap.h"
+#include <cmath>
 
 namespace Falcor
 {
@@ -118,6 +120,45 @@ const TextureAnalyzer::Result kExpectedResult[] = {
         float4(0.f, 0.f, 0.f, 1 / 256.f),
     },
 };
+
+void verifyResults(UnitTestContext& ctx, const TextureAnalyzer::Result* result)
+{
+    // Verify results.
+    for (size_t i = 0; i < kNumTests; i++)
+    {
+        EXPECT_EQ(result[i].mask, kExpectedResult[i].mask) << "i = " << i;
+
+        uint32_t rangeFlags = 0;
+        for (int c = 0; c < 4; c++)
+        {
+            bool isConstant = (kExpectedResult[i].mask & (1u << c)) == 0;
+            rangeFlags |= kExpectedResult[i].mask >> (4 + 4 * c);
+
+            EXPECT_EQ(result[i].isConstant(1u << c), isConstant) << " c = " << c;
+            EXPECT_EQ(result[i].minValue[c], kExpectedResult[i].minValue[c]) << "i = " << i << " c = " << c;
+            EXPECT_EQ(result[i].maxValue[c], kExpectedResult[i].maxValue[c]) << "i = " << i << " c = " << c;
+
+            if (isConstant)
+            {
+                EXPECT_EQ(result[i].value[c], kExpectedResult[i].value[c]) << "i = " << i << " c = " << c;
+            }
+        }
+
+        EXPECT_EQ(result[i].isPos(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::Pos) != 0)
+            << "i = " << i;
+        EXPECT_EQ(result[i].isNeg(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::Neg) != 0)
+            << "i = " << i;
+        EXPECT_EQ(result[i].isInf(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::Inf) != 0)
+            << "i = " << i;
+        EXPECT_EQ(result[i].isNaN(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::NaN) != 0)
+            << "i = " << i;
+    }
+}
+
+std::string getTestFilename(size_t i)
+{
+    return "tests/texture" + std::to_string(i + 1) + (i < kNumPNGs ? ".png" : ".exr");
+}
 } // namespace
 
 GPU_TEST(TextureAnalyzer)
@@ -130,7 +171,7 @@ GPU_TEST(TextureAnalyzer)
     std::vector<ref<Texture>> textures(kNumTests);
     for (size_t i = 0; i < kNumTests; i++)
     {
-        std::string fn = "tests/texture" + std::to_string(i + 1) + (i < kNumPNGs ? ".png" : ".exr");
+        std::string fn = getTestFilename(i);
         textures[i] = Texture::createFromFile(pDevice, fn, false, false);
         if (!textures[i])
             throw RuntimeError("Failed to load {}", fn);
@@ -148,37 +189,8 @@ GPU_TEST(TextureAnalyzer)
 
     auto verify = [&ctx](ref<Buffer> pResult)
     {
-        // Verify results.
         const TextureAnalyzer::Result* result = static_cast<const TextureAnalyzer::Result*>(pResult->map(Buffer::MapType::Read));
-        for (size_t i = 0; i < kNumTests; i++)
-        {
-            EXPECT_EQ(result[i].mask, kExpectedResult[i].mask) << "i = " << i;
-
-            uint32_t rangeFlags = 0;
-            for (int c = 0; c < 4; c++)
-            {
-                bool isConstant = (kExpectedResult[i].mask & (1u << c)) == 0;
-                rangeFlags |= kExpectedResult[i].mask >> (4 + 4 * c);
-
-                EXPECT_EQ(result[i].isConstant(1u << c), isConstant) << " c = " << c;
-                EXPECT_EQ(result[i].minValue[c], kExpectedResult[i].minValue[c]) << "i = " << i << " c = " << c;
-                EXPECT_EQ(result[i].maxValue[c], kExpectedResult[i].maxValue[c]) << "i = " << i << " c = " << c;
-
-                if (isConstant)
-                {
-                    EXPECT_EQ(result[i].value[c], kExpectedResult[i].value[c]) << "i = " << i << " c = " << c;
-                }
-            }
-
-            EXPECT_EQ(result[i].isPos(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::Pos) != 0)
-                << "i = " << i;
-            EXPECT_EQ(result[i].isNeg(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::Neg) != 0)
-                << "i = " << i;
-            EXPECT_EQ(result[i].isInf(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::Inf) != 0)
-                << "i = " << i;
-            EXPECT_EQ(result[i].isNaN(TextureChannelFlags::RGBA), (rangeFlags & (uint32_t)TextureAnalyzer::Result::RangeFlags::NaN) != 0)
-                << "i = " << i;
-        }
+        verifyResults(ctx, result);
         pResult->unmap();
     };
 
@@ -190,4 +202,99 @@ GPU_TEST(TextureAnalyzer)
 
     verify(pResult);
 }
+
+CPU_TEST(TextureAnalyzerImage)
+{
+    // Analyze the test images on the CPU. The results should match the GPU analysis.
+    std::vector<TextureAnalyzer::Result> results(kNumTests);
+    for (size_t i = 0; i < kNumTests; i++)
+    {
+        std::string fn = getTestFilename(i);
+        auto pBitmap = Bitmap::createFromFile(fn, true);
+        if (!pBitmap)
+            throw RuntimeError("Failed to load {}", fn);
+
+        auto result = TextureAnalyzer::analyzeImage(
+            pBitmap->getFormat(), pBitmap->getWidth(), pBitmap->getHeight(), pBitmap->getData(), pBitmap->getRowPitch()
+        );
+        ASSERT(result.has_value());
+        results[i] = *result;
+    }
+
+    verifyResults(ctx, results.data());
+}
+
+CPU_TEST(TextureAnalyzerImageFormats)
+{
+    using RangeFlags = TextureAnalyzer::Result::RangeFlags;
+
+    // BGRA sRGB: color channels are swizzled and decoded to linear, alpha is linear.
+    {
+        const uint8_t texels[2][4] = {{0, 128, 255, 128}, {0, 128, 255, 128}};
+        auto result = TextureAnalyzer::analyzeImage(ResourceFormat::BGRA8UnormSrgb, 2, 1, texels, sizeof(texels));
+        ASSERT(result.has_value());
+        EXPECT(result->isConstant(TextureChannelFlags::RGBA));
+        EXPECT_EQ(result->value.x, 1.f);
+        EXPECT(std::abs(result->value.y - 0.2158605f) < 1e-6f);
+        EXPECT_EQ(result->value.z, 0.f);
+        EXPECT_EQ(result->value.w, 128 / 255.f);
+        EXPECT_EQ(result->getRange(TextureChannelFlags::Blue), 0u);
+        EXPECT_EQ(result->getRange(TextureChannelFlags::Alpha), (uint32_t)RangeFlags::Pos);
+    }
+
+    // BGRX: the alpha channel is ignored and reads as one.
+    {
+        const uint8_t texels[2][4] = {{10, 20, 30, 0}, {10, 20, 30, 255}};
+        auto result = TextureAnalyzer::analyzeImage(ResourceFormat::BGRX8Unorm, 2, 1, texels, sizeof(texels));
+        ASSERT(result.has_value());
+        EXPECT(result->isConstant(TextureChannelFlags::RGBA));
+        EXPECT_EQ(result->value.x, 30 / 255.f);
+        EXPECT_EQ(result->value.w, 1.f);
+    }
+
+    // Single channel: green and blue read as zero, alpha as one.
+    {
+        const uint16_t texels[2][2] = {{0, 65535}, {32768, 65535}};
+        auto result = TextureAnalyzer::analyzeImage(ResourceFormat::R16Unorm, 2, 2, texels, sizeof(texels[0]));
+        ASSERT(result.has_value());
+        EXPECT_EQ(result->mask, 0x00010011u);
+        EXPECT_EQ(result->minValue.x, 0.f);
+        EXPECT_EQ(result->maxValue.x, 1.f);
+        EXPECT_EQ(result->maxValue.y, 0.f);
+        EXPECT_EQ(result->minValue.w, 1.f);
+    }
+
+    // Snorm: the most negative value is clamped to -1. Min/max values are clamped to zero.
+    {
+        const int16_t texels[2][2] = {{-32768, -16384}, {-32767, -16384}};
+        auto result = TextureAnalyzer::analyzeImage(ResourceFormat::RG16Snorm, 2, 1, texels, sizeof(texels));
+        ASSERT(result.has_value());
+        EXPECT(result->isConstant(TextureChannelFlags::RGBA));
+        EXPECT_EQ(result->value.x, -1.f);
+        EXPECT_EQ(result->getRange(TextureChannelFlags::RGBA), uint32_t(RangeFlags::Neg | RangeFlags::Pos));
+        EXPECT_EQ(result->minValue.x, 0.f);
+        EXPECT_EQ(result->maxValue.x, 0.f);
+    }
+
+    // Large image processed in parallel, with a single varying texel.
+    {
+        const uint32_t width = 1000, height = 700;
+        std::vector<float> texels(width * height * 3, 0.5f);
+        texels[(width * height - 1) * 3 + 1] = -2.f;
+        auto result = TextureAnalyzer::analyzeImage(ResourceFormat::RGB32Float, width, height, texels.data(), width * 3 * sizeof(float));
+        ASSERT(result.has_value());
+        EXPECT_EQ(result->mask & 0xf, (uint32_t)TextureChannelFlags::Green);
+        EXPECT_EQ(result->getRange(TextureChannelFlags::Green), uint32_t(RangeFlags::Pos | RangeFlags::Neg));
+        EXPECT_EQ(result->minValue.y, 0.f);
+        EXPECT_EQ(result->maxValue.y, 0.5f);
+        EXPECT_EQ(result->value.y, 0.5f);
+        EXPECT_EQ(result->value.w, 1.f);
+    }
+
+    // Unsupported formats.
+    const uint8_t data[16] = {};
+    EXPECT(!TextureAnalyzer::analyzeImage(ResourceFormat::BC1Unorm, 4, 4, data, 8).has_value());
+    EXPECT(!TextureAnalyzer::analyzeImage(ResourceFormat::RGBA8Uint, 2, 2, data, 8).has_value());
+    EXPECT(!TextureAnalyzer::analyzeImage(ResourceFormat::RGB10A2Unorm, 2, 2, data, 8).has_value());
+}
 } // namespace Falcor
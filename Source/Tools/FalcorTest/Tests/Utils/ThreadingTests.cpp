@@ -0,0 +1,148 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Threading.h"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace Falcor
+{
+CPU_TEST(Threading_DispatchTask)
+{
+    std::atomic<uint32_t> counter{0};
+    std::vector<Threading::Task> tasks;
+    for (uint32_t i = 0; i < 1000; ++i)
+        tasks.push_back(Threading::dispatchTask([&]() { counter++; }));
+    for (auto& task : tasks)
+    {
+        task.finish();
+        EXPECT(!task.isRunning());
+    }
+    EXPECT_EQ(counter.load(), 1000u);
+}
+
+CPU_TEST(Threading_DispatchTaskResult)
+{
+    std::vector<Threading::Future<uint64_t>> futures;
+    for (uint64_t i = 0; i < 100; ++i)
+        futures.push_back(Threading::dispatchTask([i]() { return i * i; }));
+    for (uint64_t i = 0; i < 100; ++i)
+        EXPECT_EQ(futures[i].get(), i * i);
+}
+
+CPU_TEST(Threading_TaskException)
+{
+    auto task = Threading::dispatchTask([]() { throw std::runtime_error("test"); });
+    bool caught = false;
+    try
+    {
+        task.finish();
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    EXPECT(caught);
+}
+
+CPU_TEST(Threading_ParallelFor)
+{
+    const size_t count = 100000;
+    std::vector<uint32_t> data(count, 0);
+    Threading::parallelFor(0, count, [&](size_t i) { data[i] += uint32_t(i); });
+    for (size_t i = 0; i < count; ++i)
+        EXPECT_EQ(data[i], uint32_t(i));
+
+    // Empty and single element ranges.
+    Threading::parallelFor(5, 5, [&](size_t i) { data[i] = 0; });
+    EXPECT_EQ(data[5], 5u);
+    Threading::parallelFor(5, 6, [&](size_t i) { data[i] = 0; });
+    EXPECT_EQ(data[5], 0u);
+}
+
+CPU_TEST(Threading_ParallelForNested)
+{
+    std::atomic<uint32_t> counter{0};
+    Threading::parallelFor(0, 64, [&](size_t) { Threading::parallelFor(0, 64, [&](size_t) { counter++; }); });
+    EXPECT_EQ(counter.load(), 64u * 64u);
+
+    // Waiting on nested tasks from within a task must not deadlock.
+    auto task = Threading::dispatchTask(
+        [&]()
+        {
+            std::vector<Threading::Task> inner;
+            for (uint32_t i = 0; i < 64; ++i)
+                inner.push_back(Threading::dispatchTask([&]() { counter++; }));
+            for (auto& t : inner)
+                t.finish();
+        }
+    );
+    task.finish();
+    EXPECT_EQ(counter.load(), 64u * 64u + 64u);
+}
+
+CPU_TEST(Threading_ParallelReduce)
+{
+    const size_t count = 1000001;
+    uint64_t sum = Threading::parallelReduce(
+        0, count, uint64_t(0),
+        [](size_t begin, size_t end, uint64_t acc)
+        {
+            for (size_t i = begin; i < end; ++i)
+                acc += i;
+            return acc;
+        },
+        [](uint64_t a, uint64_t b) { return a + b; }
+    );
+    EXPECT_EQ(sum, uint64_t(count - 1) * count / 2);
+
+    // Reduction order must be deterministic for non-associative operations.
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i)
+        values[i] = 1.f / float(i + 1);
+    auto reduceFloat = [&]()
+    {
+        return Threading::parallelReduce(
+            0, count, 0.f,
+            [&](size_t begin, size_t end, float acc)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    acc += values[i];
+                return acc;
+            },
+            [](float a, float b) { return a + b; }
+        );
+    };
+    float ref = reduceFloat();
+    for (uint32_t i = 0; i < 10; ++i)
+        EXPECT_EQ(reduceFloat(), ref);
+}
+} // namespace Falcor
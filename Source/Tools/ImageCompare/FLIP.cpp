@@ -0,0 +1,449 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "FLIP.h"
+#include "Filter.h"
+#include "Utils/Threading.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// The color transforms, tone mapper and constants below mirror FLIPPass.cs.slang, ToneMappers.slang and ColorHelpers.slang.
+
+namespace
+{
+const float kPi = 3.14159265358979323846f;
+const float kSqrtHalf = 0.70710678118654752440f;
+
+const float gqc = 0.7f;
+const float gpc = 0.4f;
+const float gpt = 0.95f;
+const float gw = 0.082f;
+const float gqf = 0.5f;
+
+struct float3
+{
+    float x, y, z;
+};
+
+/// Coefficients a1, a2, b1, b2 of the contrast sensitivity functions for the A, RG and BY channels.
+const float kCSFParams[3][4] = {
+    {1.0f, 0.0f, 0.0047f, 1.0e-5f},
+    {1.0f, 0.0f, 0.0053f, 1.0e-5f},
+    {34.1f, 13.5f, 0.04f, 0.025f},
+};
+
+const float3 kD65ReferenceIlluminant = {0.950428545f, 1.000000000f, 1.088900371f};
+const float3 kInvD65ReferenceIlluminant = {1.052156925f, 1.000000000f, 0.918357670f};
+
+float3 linearRGBToXYZ(float3 c)
+{
+    const float a11 = 10135552.0f / 24577794.0f;
+    const float a12 = 8788810.0f / 24577794.0f;
+    const float a13 = 4435075.0f / 24577794.0f;
+    const float a21 = 2613072.0f / 12288897.0f;
+    const float a22 = 8788810.0f / 12288897.0f;
+    const float a23 = 887015.0f / 12288897.0f;
+    const float a31 = 1425312.0f / 73733382.0f;
+    const float a32 = 8788810.0f / 73733382.0f;
+    const float a33 = 70074185.0f / 73733382.0f;
+    return {a11 * c.x + a12 * c.y + a13 * c.z, a21 * c.x + a22 * c.y + a23 * c.z, a31 * c.x + a32 * c.y + a33 * c.z};
+}
+
+float3 XYZToLinearRGB(float3 c)
+{
+    const float a11 = 3.241003275f;
+    const float a12 = -1.537398934f;
+    const float a13 = -0.498615861f;
+    const float a21 = -0.969224334f;
+    const float a22 = 1.875930071f;
+    const float a23 = 0.041554224f;
+    const float a31 = 0.055639423f;
+    const float a32 = -0.204011202f;
+    const float a33 = 1.057148933f;
+    return {a11 * c.x + a12 * c.y + a13 * c.z, a21 * c.x + a22 * c.y + a23 * c.z, a31 * c.x + a32 * c.y + a33 * c.z};
+}
+
+float3 XYZToCIELab(float3 c)
+{
+    float3 t = {c.x * kInvD65ReferenceIlluminant.x, c.y * kInvD65ReferenceIlluminant.y, c.z * kInvD65ReferenceIlluminant.z};
+
+    const float delta = 6.0f / 29.0f;
+    const float deltaSquare = delta * delta;
+    const float deltaCube = delta * deltaSquare;
+    const float factor = 1.0f / (3.0f * deltaSquare);
+    const float term = 4.0f / 29.0f;
+    auto f = [&](float v) { return v > deltaCube ? std::pow(v, 1.0f / 3.0f) : factor * v + term; };
+    t = {f(t.x), f(t.y), f(t.z)};
+
+    return {116.0f * t.y - 16.0f, 500.0f * (t.x - t.y), 200.0f * (t.y - t.z)};
+}
+
+float3 XYZToYCxCz(float3 c)
+{
+    float3 t = {c.x * kInvD65ReferenceIlluminant.x, c.y * kInvD65ReferenceIlluminant.y, c.z * kInvD65ReferenceIlluminant.z};
+    return {116.0f * t.y - 16.0f, 500.0f * (t.x - t.y), 200.0f * (t.y - t.z)};
+}
+
+float3 YCxCzToXYZ(float3 c)
+{
+    float y = (c.x + 16.0f) / 116.0f;
+    float x = c.y / 500.0f + y;
+    float z = y - c.z / 200.0f;
+    return {x * kD65ReferenceIlluminant.x, y * kD65ReferenceIlluminant.y, z * kD65ReferenceIlluminant.z};
+}
+
+float3 Hunt(float3 c)
+{
+    float huntValue = 0.01f * c.x;
+    return {c.x, huntValue * c.y, huntValue * c.z};
+}
+
+float HyAB(float3 a, float3 b)
+{
+    float3 d = {a.x - b.x, a.y - b.y, a.z - b.z};
+    return std::fabs(d.x) + std::sqrt(d.y * d.y + d.z * d.z);
+}
+
+float toneMapACES(float c)
+{
+    // ACES approximation with pre-exposure cancellation included in the constants.
+    const float k0 = 0.6f * 0.6f * 2.51f;
+    const float k1 = 0.6f * 0.03f;
+    const float k2 = 0.0f;
+    const float k3 = 0.6f * 0.6f * 2.43f;
+    const float k4 = 0.6f * 0.59f;
+    const float k5 = 0.14f;
+
+    float nom = k0 * c * c + k1 * c + k2;
+    float denom = k3 * c * c + k4 * c + k5;
+    if (std::isinf(denom))
+        denom = 1.0f;
+    return std::clamp(nom / denom, 0.0f, 1.0f);
+}
+
+const float kMaxDistance = std::pow(HyAB(Hunt(XYZToCIELab(linearRGBToXYZ({0, 1, 0}))), Hunt(XYZToCIELab(linearRGBToXYZ({0, 0, 1})))), gqc);
+
+float redistributeErrors(float colorDifference, float featureDifference)
+{
+    float error = std::pow(colorDifference, gqc);
+
+    // Normalization.
+    float perceptualCutoff = gpc * kMaxDistance;
+    if (error < perceptualCutoff)
+        error *= gpt / perceptualCutoff;
+    else
+        error = gpt + ((error - perceptualCutoff) / (kMaxDistance - perceptualCutoff)) * (1.0f - gpt);
+
+    return std::pow(error, 1.0f - featureDifference);
+}
+
+/**
+ * Compute the exposure range for HDR-FLIP from the median and maximum luminance of the reference image.
+ * See FLIPPass::computeExposureParameters().
+ */
+void computeExposures(const float* reference, size_t pixelCount, std::vector<float>& exposures)
+{
+    std::vector<float> luminance(pixelCount);
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        const float* p = reference + i * 4;
+        luminance[i] = 0.2126f * p[0] + 0.7152f * p[1] + 0.0722f * p[2];
+    }
+
+    float Ymax = *std::max_element(luminance.begin(), luminance.end());
+    float Ymedian;
+    auto mid = luminance.begin() + pixelCount / 2;
+    std::nth_element(luminance.begin(), mid, luminance.end());
+    if (pixelCount & 1)
+        Ymedian = *mid;
+    else
+        Ymedian = (*std::max_element(luminance.begin(), mid) + *mid) * 0.5f;
+
+    // Images without positive luminance are compared at a single exposure.
+    if (!(Ymax > 0.0f))
+    {
+        exposures = {0.0f};
+        return;
+    }
+    if (!(Ymedian > 0.0f))
+        Ymedian = Ymax;
+
+    // Solve a * x^2 + b * x + c = 0 for the ACES tone mapper coefficients.
+    const float t = 0.85f;
+    const float a = 0.6f * 0.6f * 2.51f - t * 0.6f * 0.6f * 2.43f;
+    const float b = 0.6f * 0.03f - t * 0.6f * 0.59f;
+    const float c = 0.0f - t * 0.14f;
+    float d1 = -0.5f * (b / a);
+    float d2 = std::sqrt((d1 * d1) - (c / a));
+    float xMax = d1 + d2;
+
+    float startExposure = std::log2(xMax / Ymax);
+    float stopExposure = std::log2(xMax / Ymedian);
+    uint32_t numExposures = uint32_t(std::max(2.0f, std::ceil(stopExposure - startExposure)));
+    float exposureDelta = (stopExposure - startExposure) / (numExposures - 1.0f);
+
+    exposures.resize(numExposures);
+    for (uint32_t i = 0; i < numExposures; ++i)
+        exposures[i] = startExposure + i * exposureDelta;
+}
+
+/**
+ * Filter kernels used by FLIP. The 2D kernels of FLIPPass are all separable or sums of separable kernels.
+ */
+struct FLIPKernels
+{
+    struct CSFTerm
+    {
+        float weight;
+        std::vector<float> kernel;
+    };
+
+    std::vector<CSFTerm> csfTerms[3]; ///< Gaussian terms of the contrast sensitivity functions per channel.
+    float csfSum[3];                  ///< Sum of the 2D contrast sensitivity function kernels per channel.
+
+    std::vector<float> gaussian; ///< Gaussian for feature detection.
+    std::vector<float> point;    ///< Normalized first factor of the point detection kernel.
+    std::vector<float> edge;     ///< Normalized first factor of the edge detection kernel.
+
+    FLIPKernels(const FLIPOptions& options)
+    {
+        const float ppd = options.monitorDistanceMeters * (options.monitorWidthPixels / options.monitorWidthMeters) * (kPi / 180.0f);
+        const float dx = 1.0f / ppd;
+
+        // Use radius of the spatial filter kernel, as it is always greater than or equal to the radius of the feature detection kernel.
+        const int radius = int(std::ceil(3.0f * std::sqrt(0.04f / (2.0f * kPi * kPi)) * ppd));
+
+        // The CSF weight a * sqrt(pi / b) * exp(-pi^2 * (x^2 + y^2) * dx^2 / b) is a product of 1D Gaussians.
+        for (int c = 0; c < 3; ++c)
+        {
+            csfSum[c] = 0.0f;
+            for (int i = 0; i < 2; ++i)
+            {
+                const float a = kCSFParams[c][i];
+                const float b = kCSFParams[c][i + 2];
+                if (a == 0.0f)
+                    continue;
+                CSFTerm term;
+                term.weight = a * std::sqrt(kPi / b);
+                term.kernel = createKernel(radius, [&](float x) { return std::exp(-kPi * kPi * x * x * dx * dx / b); });
+                float sum = 0.0f;
+                for (float w : term.kernel)
+                    sum += w;
+                csfSum[c] += term.weight * sum * sum;
+                csfTerms[c].push_back(std::move(term));
+            }
+        }
+
+        // The feature kernels are products of a 1D detector and a 1D Gaussian. The detectors are normalized by the sums of the
+        // positive and negative weights of the 2D kernels.
+        const float sigma = 0.5f * gw * ppd;
+        const float sigmaSquared = sigma * sigma;
+        gaussian = createKernel(radius, [&](float x) { return std::exp(-x * x / (2.0f * sigmaSquared)); });
+        point = createKernel(radius, [&](float x) { return (x * x / sigmaSquared - 1.0f) * std::exp(-x * x / (2.0f * sigmaSquared)); });
+        edge = createKernel(radius, [&](float x) { return -x * std::exp(-x * x / (2.0f * sigmaSquared)); });
+
+        float gaussianSum = 0.0f, positivePointSum = 0.0f, negativePointSum = 0.0f, positiveEdgeSum = 0.0f;
+        for (size_t i = 0; i < gaussian.size(); ++i)
+        {
+            gaussianSum += gaussian[i];
+            positivePointSum += std::max(point[i], 0.0f);
+            negativePointSum += std::max(-point[i], 0.0f);
+            positiveEdgeSum += std::max(edge[i], 0.0f);
+        }
+        for (size_t i = 0; i < point.size(); ++i)
+        {
+            point[i] /= (point[i] >= 0.0f ? positivePointSum : negativePointSum) * gaussianSum;
+            edge[i] /= positiveEdgeSum * gaussianSum;
+        }
+    }
+};
+
+/**
+ * Filtered image data for one image and exposure.
+ */
+struct FilteredImage
+{
+    Plane color[3]; ///< Image filtered by the contrast sensitivity functions in YCxCz space.
+    Plane pointX;   ///< Point detection in x.
+    Plane pointY;   ///< Point detection in y.
+    Plane edgeX;    ///< Edge detection in x.
+    Plane edgeY;    ///< Edge detection in y.
+
+    FilteredImage(
+        const float* image,
+        uint32_t width,
+        uint32_t height,
+        bool isHDR,
+        float exposure,
+        const FLIPKernels& kernels
+    )
+    {
+        // Convert to YCxCz.
+        Plane ycxcz[3] = {Plane(width, height), Plane(width, height), Plane(width, height)};
+        Plane luminance(width, height);
+        const float exposureScale = std::exp2(exposure);
+        Falcor::Threading::parallelForRange(
+            0, height,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin * width; i < end * width; ++i)
+                {
+                    const float* p = image + i * 4;
+                    float3 c;
+                    if (isHDR)
+                    {
+                        auto f = [&](float v) { return toneMapACES(exposureScale * std::max(v, 0.0f)); };
+                        c = {f(p[0]), f(p[1]), f(p[2])};
+                    }
+                    else
+                    {
+                        c = {std::clamp(p[0], 0.0f, 1.0f), std::clamp(p[1], 0.0f, 1.0f), std::clamp(p[2], 0.0f, 1.0f)};
+                    }
+                    c = XYZToYCxCz(linearRGBToXYZ(c));
+                    ycxcz[0].data[i] = c.x;
+                    ycxcz[1].data[i] = c.y;
+                    ycxcz[2].data[i] = c.z;
+                    luminance.data[i] = (c.x + 16.0f) / 116.0f; // Normalized Y from YCxCz.
+                }
+            }
+        );
+
+        // Color pipeline.
+        for (int c = 0; c < 3; ++c)
+        {
+            color[c] = Plane(width, height);
+            for (const auto& term : kernels.csfTerms[c])
+            {
+                Plane filtered;
+                filterSeparable(ycxcz[c], filtered, term.kernel, term.kernel);
+                const float scale = term.weight / kernels.csfSum[c];
+                for (size_t i = 0; i < filtered.data.size(); ++i)
+                    color[c].data[i] += scale * filtered.data[i];
+            }
+        }
+
+        // Feature pipeline.
+        Plane tmp;
+        filterRows(luminance, tmp, kernels.point);
+        filterColumns(tmp, pointX, kernels.gaussian);
+        filterRows(luminance, tmp, kernels.edge);
+        filterColumns(tmp, edgeX, kernels.gaussian);
+        filterRows(luminance, tmp, kernels.gaussian);
+        filterColumns(tmp, pointY, kernels.point);
+        filterColumns(tmp, edgeY, kernels.edge);
+    }
+};
+
+float computePixelFLIP(const FilteredImage& reference, const FilteredImage& test, size_t i)
+{
+    auto getColor = [i](const FilteredImage& image)
+    {
+        float3 c = XYZToLinearRGB(YCxCzToXYZ({image.color[0].data[i], image.color[1].data[i], image.color[2].data[i]}));
+        c = {std::clamp(c.x, 0.0f, 1.0f), std::clamp(c.y, 0.0f, 1.0f), std::clamp(c.z, 0.0f, 1.0f)};
+        return Hunt(XYZToCIELab(linearRGBToXYZ(c)));
+    };
+    float colorDifference = HyAB(getColor(reference), getColor(test));
+
+    auto length = [i](const Plane& x, const Plane& y) { return std::sqrt(x.data[i] * x.data[i] + y.data[i] * y.data[i]); };
+    float edgeDifference = std::fabs(length(reference.edgeX, reference.edgeY) - length(test.edgeX, test.edgeY));
+    float pointDifference = std::fabs(length(reference.pointX, reference.pointY) - length(test.pointX, test.pointY));
+    float featureDifference = std::pow(std::max(pointDifference, edgeDifference) * kSqrtHalf, gqf);
+
+    return redistributeErrors(colorDifference, featureDifference);
+}
+} // namespace
+
+double computeFLIP(
+    const float* reference,
+    const float* test,
+    uint32_t width,
+    uint32_t height,
+    const FLIPOptions& options,
+    float* errorMap
+)
+{
+    const size_t pixelCount = size_t(width) * height;
+    const FLIPKernels kernels(options);
+
+    std::vector<float> exposures = {0.0f};
+    if (options.isHDR)
+        computeExposures(reference, pixelCount, exposures);
+
+    // HDR-FLIP is the maximum LDR-FLIP over a range of exposures.
+    std::vector<float> flip(pixelCount, 0.0f);
+    for (float exposure : exposures)
+    {
+        FilteredImage filteredReference(reference, width, height, options.isHDR, exposure, kernels);
+        FilteredImage filteredTest(test, width, height, options.isHDR, exposure, kernels);
+        Falcor::Threading::parallelForRange(
+            0, height,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin * width; i < end * width; ++i)
+                {
+                    float value = computePixelFLIP(filteredReference, filteredTest, i);
+                    if (!options.isHDR || value > flip[i])
+                        flip[i] = value;
+                }
+            }
+        );
+    }
+
+    // Invalid errors are reported as the maximum error.
+    for (float& value : flip)
+    {
+        if (std::isnan(value) || std::isinf(value) || value < 0.0f || value > 1.0f)
+            value = 1.0f;
+    }
+
+    if (errorMap)
+        std::copy(flip.begin(), flip.end(), errorMap);
+
+    // Rows are summed in order to get deterministic results.
+    std::vector<double> rowSums(height);
+    Falcor::Threading::parallelForRange(
+        0, height,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t y = uint32_t(begin); y < end; ++y)
+            {
+                double rowSum = 0.0;
+                for (uint32_t x = 0; x < width; ++x)
+                    rowSum += flip[size_t(y) * width + x];
+                rowSums[y] = rowSum;
+            }
+        }
+    );
+
+    double total = 0.0;
+    for (double rowSum : rowSums)
+        total += rowSum;
+    return total / double(pixelCount);
+}
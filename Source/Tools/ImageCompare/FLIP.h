@@ -0,0 +1,64 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Options for computing FLIP.
+ * The defaults match the defaults of FLIPPass.
+ */
+struct FLIPOptions
+{
+    bool isHDR = false;                 ///< Compute HDR-FLIP. The exposure range is determined from the reference image.
+    uint32_t monitorWidthPixels = 3840; ///< Horizontal monitor resolution.
+    float monitorWidthMeters = 0.7f;    ///< Width of the monitor in meters.
+    float monitorDistanceMeters = 0.7f; ///< Distance of the monitor from the viewer in meters.
+};
+
+/**
+ * Compute the FLIP error between a reference and a test image.
+ * This is a CPU implementation of the FLIP evaluator in FLIPPass. It produces the same per-pixel errors up to floating-point
+ * differences, using separable filters instead of evaluating the full 2D kernels. HDR-FLIP uses the ACES tone mapper.
+ * Per-pixel errors that are not finite or outside [0, 1] are set to 1.
+ * @param[in] reference Reference image in RGBA32Float format.
+ * @param[in] test Test image in RGBA32Float format.
+ * @param[in] width Image width.
+ * @param[in] height Image height.
+ * @param[in] options FLIP options.
+ * @param[out] errorMap Optional. Per-pixel FLIP error (width * height values).
+ * @return Mean FLIP error over all pixels.
+ */
+double computeFLIP(
+    const float* reference,
+    const float* test,
+    uint32_t width,
+    uint32_t height,
+    const FLIPOptions& options,
+    float* errorMap
+);
@@ -0,0 +1,95 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Filter.h"
+#include "Utils/Threading.h"
+
+#include <algorithm>
+
+// The inner loops run over contiguous pixels with the kernel tap in the outer loop,
+// which allows the compiler to vectorize them.
+
+void filterRows(const Plane& src, Plane& dst, const std::vector<float>& kernel)
+{
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+    const int radius = int(kernel.size() / 2);
+    dst = Plane(width, height);
+
+    Falcor::Threading::parallelForRange(
+        0, height,
+        [&](size_t begin, size_t end)
+        {
+            // Copy each row into a buffer padded by clamping to the edge pixels.
+            std::vector<float> padded(width + 2 * radius);
+            for (uint32_t y = uint32_t(begin); y < end; ++y)
+            {
+                const float* srcRow = src.getRow(y);
+                std::fill(padded.begin(), padded.begin() + radius, srcRow[0]);
+                std::copy(srcRow, srcRow + width, padded.begin() + radius);
+                std::fill(padded.begin() + radius + width, padded.end(), srcRow[width - 1]);
+
+                float* dstRow = dst.getRow(y);
+                std::fill(dstRow, dstRow + width, 0.f);
+                for (size_t k = 0; k < kernel.size(); ++k)
+                {
+                    const float w = kernel[k];
+                    const float* p = padded.data() + k;
+                    for (uint32_t x = 0; x < width; ++x)
+                        dstRow[x] += w * p[x];
+                }
+            }
+        }
+    );
+}
+
+void filterColumns(const Plane& src, Plane& dst, const std::vector<float>& kernel)
+{
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+    const int radius = int(kernel.size() / 2);
+    dst = Plane(width, height);
+
+    Falcor::Threading::parallelForRange(
+        0, height,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t y = uint32_t(begin); y < end; ++y)
+            {
+                float* dstRow = dst.getRow(y);
+                std::fill(dstRow, dstRow + width, 0.f);
+                for (int k = -radius; k <= radius; ++k)
+                {
+                    const float w = kernel[k + radius];
+                    const float* srcRow = src.getRow(uint32_t(std::clamp(int(y) + k, 0, int(height) - 1)));
+                    for (uint32_t x = 0; x < width; ++x)
+                        dstRow[x] += w * srcRow[x];
+                }
+            }
+        }
+    );
+}
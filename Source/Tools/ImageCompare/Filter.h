@@ -0,0 +1,91 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Single channel image stored as a dense array of rows.
+ */
+struct Plane
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> data;
+
+    Plane() = default;
+    Plane(uint32_t width, uint32_t height) : width(width), height(height), data(size_t(width) * height) {}
+
+    float* getRow(uint32_t y) { return data.data() + size_t(y) * width; }
+    const float* getRow(uint32_t y) const { return data.data() + size_t(y) * width; }
+};
+
+/**
+ * Create a symmetric filter kernel of size 2 * radius + 1 by evaluating a function at integer offsets.
+ */
+template<typename Func>
+std::vector<float> createKernel(int radius, const Func& func)
+{
+    std::vector<float> kernel(2 * radius + 1);
+    for (int i = -radius; i <= radius; ++i)
+        kernel[i + radius] = func(float(i));
+    return kernel;
+}
+
+/**
+ * Convolve the rows of an image with a 1D kernel. Pixels outside the image are clamped to the edge.
+ * @param[in] src Source image.
+ * @param[out] dst Destination image. Resized to the size of the source image.
+ * @param[in] kernel Kernel of odd size.
+ */
+void filterRows(const Plane& src, Plane& dst, const std::vector<float>& kernel);
+
+/**
+ * Convolve the columns of an image with a 1D kernel. Pixels outside the image are clamped to the edge.
+ * @param[in] src Source image.
+ * @param[out] dst Destination image. Resized to the size of the source image.
+ * @param[in] kernel Kernel of odd size.
+ */
+void filterColumns(const Plane& src, Plane& dst, const std::vector<float>& kernel);
+
+/**
+ * Convolve an image with a separable 2D kernel given by the outer product of a row and a column kernel.
+ */
+inline void filterSeparable(
+    const Plane& src,
+    Plane& dst,
+    const std::vector<float>& rowKernel,
+    const std::vector<float>& columnKernel
+)
+{
+    Plane tmp;
+    filterRows(src, tmp, rowKernel);
+    filterColumns(tmp, dst, columnKernel);
+}
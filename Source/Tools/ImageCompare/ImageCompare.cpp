@@ -25,10 +25,17 @@
  # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
+#include "FLIP.h"
+#include "SSIM.h"
+#include "Utils/Threading.h"
+
 #include <FreeImage.h>
 #include <args.hxx>
+#include <nlohmann/json.hpp>
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <memory>
 #include <string>
 #include <vector>
@@ -36,6 +43,9 @@
 #include <map>
 #include <functional>
 #include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 
 #include <cmath>
 #include <cstring>
@@ -182,75 +192,150 @@ private:
     std::unique_ptr<float[]> mData;
 };
 
+struct CompareOptions
+{
+    bool alpha = false;                                                  ///< Include alpha channel.
+    double earlyExitThreshold = std::numeric_limits<double>::infinity(); ///< Stop evaluating once the error exceeds this value.
+};
+
+// Per-pixel error metrics. The channel count is a template parameter so that the
+// per-row loops in compare() can be vectorized by the compiler.
+
 struct MSE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    template<uint32_t N>
+    static float eval(const float* a, const float* b)
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
+        float error = 0.f;
+        for (uint32_t i = 0; i < N; ++i)
             error += sqr(a[i] - b[i]);
-        return error / count;
+        return error / N;
     }
 };
 
 struct RMSE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    template<uint32_t N>
+    static float eval(const float* a, const float* b)
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
-            error += sqr(a[i] - b[i]) / (sqr(a[i]) + 1e-3);
-        return error / count;
+        float error = 0.f;
+        for (uint32_t i = 0; i < N; ++i)
+            error += sqr(a[i] - b[i]) / (sqr(a[i]) + 1e-3f);
+        return error / N;
     }
 };
 
 struct MAE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    template<uint32_t N>
+    static float eval(const float* a, const float* b)
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
+        float error = 0.f;
+        for (uint32_t i = 0; i < N; ++i)
             error += std::fabs(sqr(a[i] - b[i]));
-        return error / count;
+        return error / N;
     }
 };
 
 struct MAPE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    template<uint32_t N>
+    static float eval(const float* a, const float* b)
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
-            error += std::fabs((a[i] - b[i]) / (a[i] + 1e-3));
-        return 100.0 * error / count;
+        float error = 0.f;
+        for (uint32_t i = 0; i < N; ++i)
+            error += std::fabs((a[i] - b[i]) / (a[i] + 1e-3f));
+        return 100.f * error / N;
     }
 };
 
+template<typename Metric, uint32_t N>
+void evalRow(const float* a, const float* b, uint32_t width, float* error)
+{
+    for (uint32_t x = 0; x < width; ++x)
+        error[x] = Metric::template eval<N>(a + 4 * x, b + 4 * x);
+}
+
 template<typename Metric>
-double compare(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)
+double compare(const Image& imageA, const Image& imageB, const CompareOptions& options, float* errorMap)
+{
+    const uint32_t width = imageA.getWidth();
+    const uint32_t height = imageA.getHeight();
+    const double count = double(width) * height;
+    const bool earlyExit = std::isfinite(options.earlyExitThreshold);
+
+    // Row sums are added up in order at the end to get deterministic results. The running total is only used to stop
+    // early once the mean error is known to exceed the threshold. This works as all metrics are non-negative.
+    std::vector<double> rowSums(height, 0.0);
+    std::atomic<double> runningTotal{0.0};
+    std::atomic<bool> exceeded{false};
+
+    Falcor::Threading::parallelForRange(
+        0, height,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<float> rowError(errorMap ? 0 : width);
+            for (uint32_t y = uint32_t(begin); y < end && !exceeded; ++y)
+            {
+                const float* a = imageA.getData() + size_t(y) * width * 4;
+                const float* b = imageB.getData() + size_t(y) * width * 4;
+                float* error = errorMap ? errorMap + size_t(y) * width : rowError.data();
+                if (options.alpha)
+                    evalRow<Metric, 4>(a, b, width, error);
+                else
+                    evalRow<Metric, 3>(a, b, width, error);
+
+                double sum = 0.0;
+                for (uint32_t x = 0; x < width; ++x)
+                    sum += error[x];
+                rowSums[y] = sum;
+
+                if (earlyExit)
+                {
+                    double total = runningTotal.load();
+                    while (!runningTotal.compare_exchange_weak(total, total + sum))
+                        ;
+                    if ((total + sum) / count > options.earlyExitThreshold)
+                        exceeded = true;
+                }
+            }
+        }
+    );
+
+    // The running total is a lower bound of the error.
+    if (exceeded)
+        return runningTotal.load() / count;
+
+    double total = 0.0;
+    for (double sum : rowSums)
+        total += sum;
+    return total / count;
+}
+
+static double compareSSIM(const Image& imageA, const Image& imageB, const CompareOptions& options, float* errorMap)
 {
-    Metric metric;
-    double sum = 0.0;
-    const float* a = imageA.getData();
-    const float* b = imageB.getData();
-    size_t count = imageA.getWidth() * imageA.getHeight();
-    for (size_t i = 0; i < count; ++i)
-    {
-        double error = metric(a, b, alpha ? 4 : 3);
-        if (errorMap)
-            *errorMap++ = float(error);
-        sum += error;
-        a += 4;
-        b += 4;
+    double ssim = computeSSIM(imageA.getData(), imageB.getData(), imageA.getWidth(), imageA.getHeight(), options.alpha ? 4 : 3, errorMap);
+    if (errorMap)
+    {
+        for (size_t i = 0; i < size_t(imageA.getWidth()) * imageA.getHeight(); ++i)
+            errorMap[i] = 1.f - errorMap[i];
     }
-    return sum / count;
+    return 1.0 - ssim;
+}
+
+template<bool IsHDR>
+double compareFLIP(const Image& imageA, const Image& imageB, const CompareOptions& options, float* errorMap)
+{
+    FLIPOptions flipOptions;
+    flipOptions.isHDR = IsHDR;
+    return computeFLIP(imageA.getData(), imageB.getData(), imageA.getWidth(), imageA.getHeight(), flipOptions, errorMap);
 }
 
 struct ErrorMetric
 {
     std::string name;
     std::string desc;
-    std::function<double(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)> compare;
+    std::function<double(const Image& imageA, const Image& imageB, const CompareOptions& options, float* errorMap)> compare;
 };
 
 static const std::vector<ErrorMetric> errorMetrics = {
@@ -258,6 +343,9 @@ static const std::vector<ErrorMetric> errorMetrics = {
     {"rmse", "Relative Mean Squared Error", compare<RMSE>},
     {"mae", "Mean Absolute Error", compare<MAE>},
     {"mape", "Mean Absolute Percentage Error", compare<MAPE>},
+    {"ssim", "Structural Dissimilarity (1 - SSIM)", compareSSIM},
+    {"flip", "FLIP (first image is the reference)", compareFLIP<false>},
+    {"hdrflip", "HDR-FLIP (first image is the reference)", compareFLIP<true>},
 };
 
 static std::shared_ptr<Image> generateHeatMap(uint32_t width, uint32_t height, const float* errorMap)
@@ -292,16 +380,25 @@ static std::shared_ptr<Image> generateHeatMap(uint32_t width, uint32_t height, c
     return image;
 }
 
-static bool compareImages(
+struct CompareResult
+{
+    double error = 0.0;
+    bool success = false;
+    std::string message; ///< Error message if the images could not be compared.
+};
+
+static CompareResult compareImages(
     const std::filesystem::path& pathA,
     const std::filesystem::path& pathB,
-    ErrorMetric metric,
+    const ErrorMetric& metric,
     float threshold,
-    bool alpha,
+    CompareOptions options,
     const std::filesystem::path& heatMapPath
 )
 {
-    auto loadImage = [](const std::filesystem::path& path)
+    CompareResult result;
+
+    auto loadImage = [&result](const std::filesystem::path& path)
     {
         try
         {
@@ -309,7 +406,7 @@ static bool compareImages(
         }
         catch (const std::runtime_error& e)
         {
-            std::cerr << "Cannot load image from '" << path.string() << "' (Error: " << e.what() << ")." << std::endl;
+            result.message = "Cannot load image from '" + path.string() + "' (Error: " + e.what() + ").";
             return std::shared_ptr<Image>{};
         }
     };
@@ -329,24 +426,26 @@ static bool compareImages(
     // Load images.
     auto imageA = loadImage(pathA);
     if (!imageA)
-        return false;
+        return result;
     auto imageB = loadImage(pathB);
     if (!imageB)
-        return false;
+        return result;
 
     // Check resolution.
     if (imageA->getWidth() != imageB->getWidth() || imageA->getHeight() != imageB->getHeight())
     {
-        std::cerr << "Cannot compare images with different resolutions." << std::endl;
-        return false;
+        result.message = "Cannot compare images with different resolutions.";
+        return result;
     }
 
     uint32_t width = imageA->getWidth();
     uint32_t height = imageB->getHeight();
 
-    // Compare images.
+    // Compare images. The full error map is needed for the heat map, so exiting early is disabled in that case.
     std::unique_ptr<float[]> errorMap = heatMapPath.empty() ? nullptr : std::make_unique<float[]>(width * height);
-    double error = metric.compare(*imageA, *imageB, alpha, errorMap.get());
+    if (errorMap)
+        options.earlyExitThreshold = std::numeric_limits<double>::infinity();
+    result.error = metric.compare(*imageA, *imageB, options, errorMap.get());
 
     // Generate heat map.
     if (errorMap)
@@ -355,13 +454,190 @@ static bool compareImages(
         saveImage(*heatMap, heatMapPath);
     }
 
-    std::cout << error << std::endl;
-
     // Treat nans and infs as errors.
-    if (std::isnan(error) || std::isinf(error))
-        return false;
+    result.success = std::isfinite(result.error) && result.error <= threshold;
+    return result;
+}
+
+static const std::string kErrorImageSuffix = ".error.png";
+
+struct ImagePair
+{
+    std::string name;
+    std::filesystem::path pathA;
+    std::filesystem::path pathB;
+    std::filesystem::path heatMapPath;
+};
+
+/**
+ * Collect pairs of images with the same file name in two directories.
+ * Images without a counterpart are returned with an empty path.
+ */
+static std::vector<ImagePair> collectDirectoryPairs(
+    const std::filesystem::path& dirA,
+    const std::filesystem::path& dirB,
+    const std::filesystem::path& heatMapDir
+)
+{
+    auto isErrorImage = [](const std::string& name)
+    {
+        return name.size() >= kErrorImageSuffix.size() &&
+               name.compare(name.size() - kErrorImageSuffix.size(), kErrorImageSuffix.size(), kErrorImageSuffix) == 0;
+    };
+
+    std::map<std::string, ImagePair> pairs;
+    auto collectImages = [&](const std::filesystem::path& dir, std::filesystem::path ImagePair::*member)
+    {
+        if (!std::filesystem::is_directory(dir))
+            throw std::runtime_error("'" + dir.string() + "' is not a directory");
+        for (const auto& entry : std::filesystem::directory_iterator(dir))
+        {
+            if (!entry.is_regular_file())
+                continue;
+            auto name = entry.path().filename().string();
+            if (isErrorImage(name) || FreeImage_GetFIFFromFilename(name.c_str()) == FIF_UNKNOWN)
+                continue;
+            auto& pair = pairs[name];
+            pair.name = name;
+            pair.*member = entry.path();
+        }
+    };
+
+    collectImages(dirA, &ImagePair::pathA);
+    collectImages(dirB, &ImagePair::pathB);
+
+    std::vector<ImagePair> result;
+    for (auto& [name, pair] : pairs)
+    {
+        if (!heatMapDir.empty())
+            pair.heatMapPath = heatMapDir / (name + kErrorImageSuffix);
+        result.push_back(std::move(pair));
+    }
+    return result;
+}
 
-    return error <= threshold;
+/**
+ * Read pairs of images from a manifest file.
+ * Each line contains the paths of the two images and optionally the path of the heat map, separated by tabs.
+ * Empty lines and lines starting with '#' are ignored. Relative paths are relative to the manifest file.
+ */
+static std::vector<ImagePair> readManifestPairs(const std::filesystem::path& manifestPath, const std::filesystem::path& heatMapDir)
+{
+    std::ifstream file(manifestPath);
+    if (!file)
+        throw std::runtime_error("Cannot open manifest '" + manifestPath.string() + "'");
+
+    const auto baseDir = manifestPath.parent_path();
+    std::vector<ImagePair> pairs;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::vector<std::string> columns;
+        std::istringstream stream(line);
+        std::string column;
+        while (std::getline(stream, column, '\t'))
+            columns.push_back(column);
+        if (columns.size() < 2 || columns.size() > 3)
+            throw std::runtime_error("Invalid entry on line " + std::to_string(lineNumber) + " of '" + manifestPath.string() + "'");
+
+        ImagePair pair;
+        pair.name = columns[1];
+        pair.pathA = baseDir / columns[0];
+        pair.pathB = baseDir / columns[1];
+        if (columns.size() == 3)
+            pair.heatMapPath = baseDir / columns[2];
+        else if (!heatMapDir.empty())
+            pair.heatMapPath = heatMapDir / (pair.pathB.filename().string() + kErrorImageSuffix);
+        pairs.push_back(std::move(pair));
+    }
+    return pairs;
+}
+
+/**
+ * Compare a batch of image pairs. Pairs are compared concurrently on the thread pool, which is shared with the metrics.
+ */
+static std::vector<CompareResult> compareBatch(
+    const std::vector<ImagePair>& pairs,
+    const ErrorMetric& metric,
+    float threshold,
+    const CompareOptions& options
+)
+{
+    std::vector<CompareResult> results(pairs.size());
+
+    Falcor::Threading::parallelFor(
+        0, pairs.size(),
+        [&](size_t i)
+        {
+            const auto& pair = pairs[i];
+            if (pair.pathA.empty() || pair.pathB.empty())
+                results[i].message = "Image '" + (pair.pathA.empty() ? pair.pathB : pair.pathA).string() + "' has no counterpart.";
+            else
+                results[i] = compareImages(pair.pathA, pair.pathB, metric, threshold, options, pair.heatMapPath);
+        }
+    );
+
+    return results;
+}
+
+static void writeCSVReport(std::ostream& stream, const std::vector<ImagePair>& pairs, const std::vector<CompareResult>& results)
+{
+    auto quote = [](const std::string& str)
+    {
+        if (str.find_first_of(",\"\n") == std::string::npos)
+            return str;
+        std::string quoted = "\"";
+        for (char c : str)
+        {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    };
+
+    stream << "name,image1,image2,error,success,message" << std::endl;
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        stream << quote(pairs[i].name) << "," << quote(pairs[i].pathA.string()) << "," << quote(pairs[i].pathB.string()) << ","
+               << results[i].error << "," << (results[i].success ? "true" : "false") << "," << quote(results[i].message) << std::endl;
+    }
+}
+
+static void writeJSONReport(
+    std::ostream& stream,
+    const ErrorMetric& metric,
+    float threshold,
+    const std::vector<ImagePair>& pairs,
+    const std::vector<CompareResult>& results
+)
+{
+    nlohmann::json images = nlohmann::json::array();
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        nlohmann::json image;
+        image["name"] = pairs[i].name;
+        image["image1"] = pairs[i].pathA.string();
+        image["image2"] = pairs[i].pathB.string();
+        image["error"] = results[i].error;
+        image["success"] = results[i].success;
+        if (!results[i].message.empty())
+            image["message"] = results[i].message;
+        images.push_back(image);
+    }
+
+    nlohmann::json report;
+    report["metric"] = metric.name;
+    report["threshold"] = threshold;
+    report["images"] = images;
+    stream << report.dump(4) << std::endl;
 }
 
 static void printMetrics(std::ostream& stream = std::cout)
@@ -382,9 +658,22 @@ int main(int argc, char** argv)
     args::ValueFlag<std::string> metricFlag(parser, "metric", "The error metric.", {'m'});
     args::ValueFlag<float> thresholdFlag(parser, "threshold", "The error threshold.", {'t'});
     args::Flag alphaFlag(parser, "", "Include alpha channel.", {'a'});
-    args::ValueFlag<std::string> heatMapFlag(parser, "filename", "Generate error heat map.", {'e'});
-    args::Positional<std::string> image1(parser, "image1", "The first image.", args::Options::Required);
-    args::Positional<std::string> image2(parser, "image2", "The second image.", args::Options::Required);
+    args::ValueFlag<std::string> heatMapFlag(
+        parser, "path", "Generate error heat map. In batch mode, this is the directory for the heat maps.", {'e'}
+    );
+    args::ValueFlag<uint32_t> threadsFlag(parser, "count", "Number of threads (defaults to the number of cores).", {'j', "threads"});
+    args::Flag earlyExitFlag(
+        parser, "", "Stop evaluating once the error exceeds the threshold. The reported error is then a lower bound.", {"early-exit"}
+    );
+    args::Flag batchFlag(parser, "", "Compare all images with the same name in two directories.", {'b', "batch"});
+    args::ValueFlag<std::string> manifestFlag(
+        parser, "filename", "Compare the image pairs listed in a manifest file (one tab-separated pair per line).", {"manifest"}
+    );
+    args::ValueFlag<std::string> reportFlag(
+        parser, "filename", "Write the batch results to a JSON or CSV report (default is CSV to stdout).", {'r', "report"}
+    );
+    args::Positional<std::string> image1(parser, "image1", "The first image (or directory in batch mode).");
+    args::Positional<std::string> image2(parser, "image2", "The second image (or directory in batch mode).");
     args::CompletionFlag completionFlag(parser, {"complete"});
 
     try
@@ -435,9 +724,82 @@ int main(int argc, char** argv)
         metric = *it;
     }
 
-    bool success = compareImages(
-        args::get(image1), args::get(image2), metric, thresholdFlag ? args::get(thresholdFlag) : 0.f,
-        alphaFlag ? args::get(alphaFlag) : false, heatMapFlag ? args::get(heatMapFlag) : ""
-    );
+    const float threshold = thresholdFlag ? args::get(thresholdFlag) : 0.f;
+    const std::string heatMapPath = heatMapFlag ? args::get(heatMapFlag) : "";
+
+    // Metrics and batch comparisons run on the Falcor thread pool.
+    Falcor::Threading::start(threadsFlag ? std::max(1u, args::get(threadsFlag)) : 0);
+
+    CompareOptions options;
+    options.alpha = args::get(alphaFlag);
+    if (earlyExitFlag)
+        options.earlyExitThreshold = threshold;
+
+    const bool isBatch = batchFlag || manifestFlag;
+    if (!isBatch)
+    {
+        if (!image1 || !image2)
+        {
+            std::cerr << "Two images are required." << std::endl;
+            std::cerr << parser;
+            return 1;
+        }
+
+        auto result = compareImages(args::get(image1), args::get(image2), metric, threshold, options, heatMapPath);
+        if (!result.message.empty())
+        {
+            std::cerr << result.message << std::endl;
+            return 1;
+        }
+        std::cout << result.error << std::endl;
+        return result.success ? 0 : 1;
+    }
+
+    std::vector<ImagePair> pairs;
+    try
+    {
+        if (manifestFlag)
+        {
+            if (batchFlag || image1 || image2)
+                throw std::runtime_error("A manifest cannot be combined with directories.");
+            pairs = readManifestPairs(args::get(manifestFlag), heatMapPath);
+        }
+        else
+        {
+            if (!image1 || !image2)
+                throw std::runtime_error("Two directories are required.");
+            pairs = collectDirectoryPairs(args::get(image1), args::get(image2), heatMapPath);
+        }
+        if (!heatMapPath.empty())
+            std::filesystem::create_directories(heatMapPath);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    auto results = compareBatch(pairs, metric, threshold, options);
+
+    if (reportFlag)
+    {
+        std::filesystem::path reportPath = args::get(reportFlag);
+        std::ofstream file(reportPath);
+        if (!file)
+        {
+            std::cerr << "Cannot write report to '" << reportPath.string() << "'." << std::endl;
+            return 1;
+        }
+        if (reportPath.extension() == ".csv")
+            writeCSVReport(file, pairs, results);
+        else
+            writeJSONReport(file, metric, threshold, pairs, results);
+    }
+    else
+    {
+        writeCSVReport(std::cout, pairs, results);
+    }
+
+    bool success = std::all_of(results.begin(), results.end(), [](const CompareResult& result) { return result.success; });
     return success ? 0 : 1;
 }
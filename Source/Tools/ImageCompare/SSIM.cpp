@@ -0,0 +1,136 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "SSIM.h"
+#include "Filter.h"
+#include "Utils/Threading.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+const float kSigma = 1.5f;
+const int kRadius = 5;
+const float kC1 = 0.01f * 0.01f; // (k1 * L)^2 with k1 = 0.01 and dynamic range L = 1.
+const float kC2 = 0.03f * 0.03f; // (k2 * L)^2 with k2 = 0.03 and dynamic range L = 1.
+} // namespace
+
+double computeSSIM(
+    const float* imageA,
+    const float* imageB,
+    uint32_t width,
+    uint32_t height,
+    uint32_t channelCount,
+    float* ssimMap
+)
+{
+    auto kernel = createKernel(kRadius, [](float x) { return std::exp(-x * x / (2.f * kSigma * kSigma)); });
+    float kernelSum = 0.f;
+    for (float w : kernel)
+        kernelSum += w;
+    for (float& w : kernel)
+        w /= kernelSum;
+
+    // Accumulate the per-pixel SSIM over all channels.
+    Plane sum(width, height);
+
+    for (uint32_t c = 0; c < channelCount; ++c)
+    {
+        // Compute the local means, variances and covariance.
+        Plane a(width, height), b(width, height), aa(width, height), bb(width, height), ab(width, height);
+        Falcor::Threading::parallelForRange(
+            0, height,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin * width; i < end * width; ++i)
+                {
+                    float va = imageA[i * 4 + c];
+                    float vb = imageB[i * 4 + c];
+                    a.data[i] = va;
+                    b.data[i] = vb;
+                    aa.data[i] = va * va;
+                    bb.data[i] = vb * vb;
+                    ab.data[i] = va * vb;
+                }
+            }
+        );
+
+        Plane meanA, meanB, meanAA, meanBB, meanAB;
+        filterSeparable(a, meanA, kernel, kernel);
+        filterSeparable(b, meanB, kernel, kernel);
+        filterSeparable(aa, meanAA, kernel, kernel);
+        filterSeparable(bb, meanBB, kernel, kernel);
+        filterSeparable(ab, meanAB, kernel, kernel);
+
+        Falcor::Threading::parallelForRange(
+            0, height,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin * width; i < end * width; ++i)
+                {
+                    float ma = meanA.data[i];
+                    float mb = meanB.data[i];
+                    float varA = meanAA.data[i] - ma * ma;
+                    float varB = meanBB.data[i] - mb * mb;
+                    float cov = meanAB.data[i] - ma * mb;
+                    float num = (2.f * ma * mb + kC1) * (2.f * cov + kC2);
+                    float den = (ma * ma + mb * mb + kC1) * (varA + varB + kC2);
+                    sum.data[i] += num / den;
+                }
+            }
+        );
+    }
+
+    // Average over channels and pixels. Rows are summed in order to get deterministic results.
+    std::vector<double> rowSums(height);
+    Falcor::Threading::parallelForRange(
+        0, height,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t y = uint32_t(begin); y < end; ++y)
+            {
+                float* row = sum.getRow(y);
+                double rowSum = 0.0;
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    row[x] /= channelCount;
+                    rowSum += row[x];
+                }
+                rowSums[y] = rowSum;
+                if (ssimMap)
+                    std::copy(row, row + width, ssimMap + size_t(y) * width);
+            }
+        }
+    );
+
+    double total = 0.0;
+    for (double rowSum : rowSums)
+        total += rowSum;
+    return total / (double(width) * height);
+}
@@ -0,0 +1,206 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Utils/Image/TextureBaker.h"
+#include "Utils/Logger.h"
+#include "Utils/StringUtils.h"
+#include "Utils/Threading.h"
+
+#include <args.hxx>
+
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace Falcor;
+
+static const std::set<std::string> kImageExtensions = {
+    ".bmp", ".exr", ".hdr", ".jpeg", ".jpg", ".pfm", ".png", ".tga", ".tif", ".tiff",
+};
+
+static bool isImageFile(const std::filesystem::path& path)
+{
+    return kImageExtensions.count(toLowerCase(path.extension().string())) > 0;
+}
+
+/// Guess the usage of a texture from its file name if it's not specified.
+static TextureBaker::Usage guessUsage(const std::filesystem::path& path)
+{
+    std::string name = toLowerCase(path.stem().string());
+    return name.find("normal") != std::string::npos ? TextureBaker::Usage::Normal : TextureBaker::Usage::Color;
+}
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Utility to bake textures to block-compressed DDS files for fast loading.");
+    parser.helpParams.programName = "TextureBaker";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<std::string> outputFlag(parser, "dir", "Cache directory (default: texture cache in the app data directory).", {'o'});
+    args::ValueFlag<std::string> usageFlag(
+        parser,
+        "auto|color|normal|scalar|lossless",
+        "Texture usage (default: auto, which treats files with 'normal' in their name as normal maps).",
+        {'u', "usage"}
+    );
+    args::Flag noMipsFlag(parser, "", "Don't generate mips.", {"no-mips"});
+    args::Flag compactColorFlag(parser, "", "Compress opaque color textures to BC1 instead of BC7.", {"compact-color"});
+    args::Flag recursiveFlag(parser, "", "Search directories recursively.", {'r', "recursive"});
+    args::PositionalList<std::string> inputs(parser, "inputs", "Image files or directories of image files.", args::Options::Required);
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    catch (const args::RequiredError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::optional<TextureBaker::Usage> usage;
+    if (usageFlag)
+    {
+        const std::string& name = args::get(usageFlag);
+        if (name == "color")
+            usage = TextureBaker::Usage::Color;
+        else if (name == "normal")
+            usage = TextureBaker::Usage::Normal;
+        else if (name == "scalar")
+            usage = TextureBaker::Usage::Scalar;
+        else if (name == "lossless")
+            usage = TextureBaker::Usage::Lossless;
+        else if (name != "auto")
+        {
+            std::cerr << "Invalid usage '" << name << "', use 'auto', 'color', 'normal', 'scalar' or 'lossless'" << std::endl;
+            return 1;
+        }
+    }
+
+    // Collect the images to bake.
+    std::vector<std::filesystem::path> paths;
+    for (const auto& input : args::get(inputs))
+    {
+        std::filesystem::path path(input);
+        std::error_code ec;
+        if (std::filesystem::is_directory(path, ec))
+        {
+            auto addFile = [&](const std::filesystem::directory_entry& entry)
+            {
+                if (entry.is_regular_file() && isImageFile(entry.path()))
+                    paths.push_back(entry.path());
+            };
+            if (recursiveFlag)
+            {
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec))
+                    addFile(entry);
+            }
+            else
+            {
+                for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+                    addFile(entry);
+            }
+        }
+        else if (std::filesystem::is_regular_file(path, ec))
+        {
+            paths.push_back(path);
+        }
+        else
+        {
+            std::cerr << "Can't find '" << input << "'." << std::endl;
+            return 1;
+        }
+    }
+
+    TextureBaker::Options options;
+    if (outputFlag)
+        options.cacheDirectory = args::get(outputFlag);
+    options.compactColor = args::get(compactColorFlag);
+
+    Threading::start();
+
+    int result = 0;
+    try
+    {
+        TextureBaker baker(options);
+        bool generateMips = !args::get(noMipsFlag);
+
+        // Bake the images in parallel.
+        std::vector<std::filesystem::path> bakedPaths(paths.size());
+        std::atomic<size_t> bakedCount{0};
+        Threading::parallelFor(
+            0, paths.size(),
+            [&](size_t i)
+            {
+                bakedPaths[i] = baker.bake(paths[i], usage.value_or(guessUsage(paths[i])), generateMips);
+                logInfo("[{}/{}] {}", bakedCount.fetch_add(1) + 1, paths.size(), paths[i]);
+            }
+        );
+
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            if (!bakedPaths[i].empty())
+                std::cout << paths[i].string() << " -> " << bakedPaths[i].string() << std::endl;
+        }
+
+        auto stats = baker.getStats();
+        fmt::print(
+            "Baked {} textures to '{}', {} found in cache, {} failed.\n", stats.bakedCount, baker.getCacheDirectory(), stats.cacheHitCount,
+            stats.failedCount
+        );
+        result = stats.failedCount > 0 ? 1 : 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        result = 1;
+    }
+
+    Threading::shutdown();
+    return result;
+}
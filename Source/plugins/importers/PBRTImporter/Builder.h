@@ -258,6 +258,9 @@ public:
     const std::map<std::string, InstanceDefinitionSceneEntity>& getInstanceDefinitions() const { return mInstanceDefinitions; }
     const std::vector<InstanceSceneEntity>& getInstances() const { return mInstances; }
 
+    void addIncludedFile(const std::filesystem::path& path) { mIncludedFiles.push_back(path); }
+    const std::vector<std::filesystem::path>& getIncludedFiles() const { return mIncludedFiles; }
+
     /**
      * Get a named or unnamed material.
      */
@@ -290,6 +293,8 @@ private:
 
     std::map<std::string, InstanceDefinitionSceneEntity> mInstanceDefinitions;
     std::vector<InstanceSceneEntity> mInstances;
+
+    std::vector<std::filesystem::path> mIncludedFiles;
 };
 
 constexpr uint32_t kMaxTransforms = 2;
@@ -379,6 +384,7 @@ public:
     void onObjectEnd(FileLoc loc) override;
     void onObjectInstance(const std::string& name, FileLoc loc) override;
 
+    void onInclude(const std::filesystem::path& path, FileLoc loc) override;
     void onEndOfFiles() override;
 
 private:
@@ -329,6 +329,13 @@ namespace Falcor
             throw ImporterError(path, "Failed to open USD stage.");
         }
 
+        // Register all layers used by the stage as scene dependencies.
+        for (const auto& pLayer : pStage->GetUsedLayers())
+        {
+            const std::string& realPath = pLayer->GetRealPath();
+            if (!realPath.empty()) builder.addDependency(realPath);
+        }
+
         timeReport.measure("Open stage");
 
         ImporterContext ctx(path, pStage, builder, dict, timeReport);
@@ -0,0 +1,300 @@
+import csv
+import json
+import math
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+import unittest
+from pathlib import Path
+
+IMAGE_COMPARE = shutil.which("ImageCompare")
+
+WIDTH = 32
+HEIGHT = 24
+
+
+def write_pfm(path, pixel):
+    """Write an RGB PFM image. pixel(x, y) returns the color of a pixel, rows are counted from the top."""
+    with open(path, "wb") as f:
+        f.write(f"PF\n{WIDTH} {HEIGHT}\n-1.0\n".encode("ascii"))
+        # PFM stores the rows bottom-up.
+        for y in reversed(range(HEIGHT)):
+            for x in range(WIDTH):
+                f.write(struct.pack("<3f", *pixel(x, y)))
+
+
+def gradient(x, y):
+    return (x / WIDTH, y / HEIGHT, 0.5)
+
+
+def constant(value):
+    return lambda x, y: (value, value, value)
+
+
+def checker(x, y):
+    return (1.0, 1.0, 1.0) if (x // 4 + y // 4) % 2 == 0 else (0.0, 0.0, 0.0)
+
+
+def shifted_checker(x, y):
+    """Gradient with a red/blue shift that alternates in a checker pattern."""
+    d = 0.1 if (x // 4 + y // 4) % 2 == 0 else -0.1
+    r, g, b = gradient(x, y)
+    return (r + d, g, b - d)
+
+
+def linear_rgb_to_xyz(c):
+    r, g, b = c
+    return (
+        (10135552.0 * r + 8788810.0 * g + 4435075.0 * b) / 24577794.0,
+        (2613072.0 * r + 8788810.0 * g + 887015.0 * b) / 12288897.0,
+        (1425312.0 * r + 8788810.0 * g + 70074185.0 * b) / 73733382.0,
+    )
+
+
+def xyz_to_linear_rgb(c):
+    x, y, z = c
+    return (
+        3.241003275 * x - 1.537398934 * y - 0.498615861 * z,
+        -0.969224334 * x + 1.875930071 * y + 0.041554224 * z,
+        0.055639423 * x - 0.204011202 * y + 1.057148933 * z,
+    )
+
+
+D65 = (0.950428545, 1.000000000, 1.088900371)
+INV_D65 = (1.052156925, 1.000000000, 0.918357670)
+
+
+def xyz_to_ycxcz(c):
+    x, y, z = (c[i] * INV_D65[i] for i in range(3))
+    return (116.0 * y - 16.0, 500.0 * (x - y), 200.0 * (y - z))
+
+
+def ycxcz_to_xyz(c):
+    y = (c[0] + 16.0) / 116.0
+    x = c[1] / 500.0 + y
+    z = y - c[2] / 200.0
+    return (x * D65[0], y * D65[1], z * D65[2])
+
+
+def linear_rgb_to_cielab(c):
+    delta = 6.0 / 29.0
+
+    def f(t):
+        return t ** (1.0 / 3.0) if t > delta**3 else t / (3.0 * delta * delta) + 4.0 / 29.0
+
+    x, y, z = (f(v * INV_D65[i]) for i, v in enumerate(linear_rgb_to_xyz(c)))
+    return (116.0 * y - 16.0, 500.0 * (x - y), 200.0 * (y - z))
+
+
+def hunt(c):
+    h = 0.01 * c[0]
+    return (c[0], h * c[1], h * c[2])
+
+
+def hyab(a, b):
+    return abs(a[0] - b[0]) + math.hypot(a[1] - b[1], a[2] - b[2])
+
+
+def reference_flip(reference, test):
+    """
+    Mean LDR-FLIP error between two images given by their pixel functions.
+    This is a direct port of LDRFLIP() in FLIPPass.cs.slang, the reference for the CPU implementation in ImageCompare.
+    It evaluates the full 2D filter kernels for every pixel with the default viewing conditions of FLIPPass.
+    """
+    width, height = WIDTH, HEIGHT
+    gqc, gpc, gpt, gw, gqf = 0.7, 0.4, 0.95, 0.082, 0.5
+    max_distance = hyab(hunt(linear_rgb_to_cielab((0.0, 1.0, 0.0))), hunt(linear_rgb_to_cielab((0.0, 0.0, 1.0)))) ** gqc
+    ppd = 0.7 * (3840 / 0.7) * (math.pi / 180.0)
+    dx = 1.0 / ppd
+    radius = int(math.ceil(3.0 * math.sqrt(0.04 / (2.0 * math.pi * math.pi)) * ppd))
+    sigma2 = (0.5 * gw * ppd) ** 2
+    ab_values = [(1.0, 0.0, 0.0047, 1.0e-5), (1.0, 0.0, 0.0053, 1.0e-5), (34.1, 13.5, 0.04, 0.025)]
+
+    def csf_weight(dist2, ab):
+        a1, a2, b1, b2 = ab
+        return a1 * math.sqrt(math.pi / b1) * math.exp(dist2 / b1) + a2 * math.sqrt(math.pi / b2) * math.exp(dist2 / b2)
+
+    # Kernel weights only depend on the offset.
+    offsets = [(x, y) for y in range(-radius, radius + 1) for x in range(-radius, radius + 1)]
+    positive_sum = negative_sum = edge_sum = 0.0
+    for x, y in offsets:
+        g = math.exp(-(x * x + y * y) / (2.0 * sigma2))
+        point = (x * x / sigma2 - 1.0) * g
+        positive_sum += max(point, 0.0)
+        negative_sum += max(-point, 0.0)
+        edge_sum += max(-x * g, 0.0)
+    kernel = []
+    for x, y in offsets:
+        dist2 = -((x * dx) ** 2 + (y * dx) ** 2) * math.pi * math.pi
+        csf = tuple(csf_weight(dist2, ab) for ab in ab_values)
+        g = math.exp(-(x * x + y * y) / (2.0 * sigma2))
+        point = tuple(w / (positive_sum if w >= 0.0 else negative_sum) for w in ((x * x / sigma2 - 1.0) * g, (y * y / sigma2 - 1.0) * g))
+        edge = (-x * g / edge_sum, -y * g / edge_sum)
+        kernel.append((x, y, csf, point, edge))
+    csf_sum = [sum(k[2][c] for k in kernel) for c in range(3)]
+
+    def to_ycxcz(pixel):
+        clamped = [[tuple(min(max(v, 0.0), 1.0) for v in pixel(x, y)) for x in range(width)] for y in range(height)]
+        return [[xyz_to_ycxcz(linear_rgb_to_xyz(c)) for c in row] for row in clamped]
+
+    ref_ycxcz = to_ycxcz(reference)
+    test_ycxcz = to_ycxcz(test)
+
+    total = 0.0
+    for py in range(height):
+        for px in range(width):
+            color = [[0.0] * 3, [0.0] * 3]
+            point = [[0.0, 0.0], [0.0, 0.0]]
+            edge = [[0.0, 0.0], [0.0, 0.0]]
+            for x, y, csf, pw, ew in kernel:
+                nx = min(max(px + x, 0), width - 1)
+                ny = min(max(py + y, 0), height - 1)
+                for i, image in enumerate((ref_ycxcz, test_ycxcz)):
+                    c = image[ny][nx]
+                    for k in range(3):
+                        color[i][k] += csf[k] * c[k]
+                    lum = (c[0] + 16.0) / 116.0
+                    point[i][0] += lum * pw[0]
+                    point[i][1] += lum * pw[1]
+                    edge[i][0] += lum * ew[0]
+                    edge[i][1] += lum * ew[1]
+
+            filtered = []
+            for i in range(2):
+                rgb = xyz_to_linear_rgb(ycxcz_to_xyz(tuple(color[i][k] / csf_sum[k] for k in range(3))))
+                filtered.append(hunt(linear_rgb_to_cielab(tuple(min(max(v, 0.0), 1.0) for v in rgb))))
+            color_diff = hyab(filtered[0], filtered[1])
+
+            edge_diff = abs(math.hypot(*edge[0]) - math.hypot(*edge[1]))
+            point_diff = abs(math.hypot(*point[0]) - math.hypot(*point[1]))
+            feature_diff = (max(point_diff, edge_diff) * math.sqrt(0.5)) ** gqf
+
+            error = color_diff**gqc
+            cutoff = gpc * max_distance
+            if error < cutoff:
+                error *= gpt / cutoff
+            else:
+                error = gpt + ((error - cutoff) / (max_distance - cutoff)) * (1.0 - gpt)
+            error = error ** (1.0 - feature_diff)
+            total += error if 0.0 <= error <= 1.0 else 1.0
+
+    return total / (width * height)
+
+class TestImageCompare(unittest.TestCase):
+    def setUp(self):
+        self.assertIsNotNone(IMAGE_COMPARE, "ImageCompare executable not found")
+        self.dir = Path(tempfile.mkdtemp())
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def image(self, name, pixel):
+        path = self.dir / name
+        path.parent.mkdir(parents=True, exist_ok=True)
+        write_pfm(path, pixel)
+        return path
+
+    def run_compare(self, *args):
+        return subprocess.run([IMAGE_COMPARE] + [str(a) for a in args], capture_output=True, text=True)
+
+    def compare(self, metric, a, b):
+        result = self.run_compare("-m", metric, "-t", "1", a, b)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        return float(result.stdout)
+
+    def test_ssim(self):
+        a = self.image("a.pfm", gradient)
+        self.assertAlmostEqual(self.compare("ssim", a, a), 0.0, places=6)
+
+        # For constant images only the luminance term of SSIM remains: (2 * a * b + C1) / (a^2 + b^2 + C1).
+        c1 = 0.01**2
+        expected = 1.0 - (2 * 0.5 * 0.25 + c1) / (0.5**2 + 0.25**2 + c1)
+        b = self.image("b.pfm", constant(0.5))
+        c = self.image("c.pfm", constant(0.25))
+        self.assertAlmostEqual(self.compare("ssim", b, c), expected, places=4)
+
+        # Structural differences increase the error.
+        d = self.image("d.pfm", checker)
+        self.assertGreater(self.compare("ssim", a, d), self.compare("ssim", a, c))
+
+    def test_flip(self):
+        a = self.image("a.pfm", gradient)
+        for metric in ["flip", "hdrflip"]:
+            with self.subTest(metric=metric):
+                self.assertEqual(self.compare(metric, a, a), 0.0)
+
+        # The error grows with the difference and is at most 1.
+        small = self.image("small.pfm", lambda x, y: tuple(v + 0.02 for v in gradient(x, y)))
+        large = self.image("large.pfm", lambda x, y: tuple(1.0 - v for v in gradient(x, y)))
+        error_small = self.compare("flip", a, small)
+        error_large = self.compare("flip", a, large)
+        self.assertGreater(error_small, 0.0)
+        self.assertGreater(error_large, error_small)
+        self.assertLessEqual(error_large, 1.0)
+
+        # HDR-FLIP detects the difference as well.
+        self.assertGreater(self.compare("hdrflip", a, large), 0.0)
+
+    def test_flip_reference(self):
+        # ImageCompare uses separable filters, so its mean error matches the full-kernel evaluator up to floating-point differences.
+        expected = reference_flip(gradient, shifted_checker)
+        self.assertAlmostEqual(expected, 0.0795213, places=6)
+        a = self.image("a.pfm", gradient)
+        b = self.image("b.pfm", shifted_checker)
+        self.assertAlmostEqual(self.compare("flip", a, b), expected, delta=1e-5)
+
+    def test_batch_report(self):
+        self.image("a/same.pfm", gradient)
+        self.image("b/same.pfm", gradient)
+        self.image("a/diff.pfm", constant(0.5))
+        self.image("b/diff.pfm", constant(0.25))
+        self.image("a/only_a.pfm", gradient)
+        report_path = self.dir / "report.json"
+
+        result = self.run_compare("-m", "mse", "-t", "0.01", "--batch", self.dir / "a", self.dir / "b", "-r", report_path)
+        self.assertNotEqual(result.returncode, 0)
+
+        with open(report_path) as f:
+            report = json.load(f)
+        self.assertEqual(report["metric"], "mse")
+        self.assertAlmostEqual(report["threshold"], 0.01)
+        images = {image["name"]: image for image in report["images"]}
+        self.assertEqual(sorted(images.keys()), ["diff.pfm", "only_a.pfm", "same.pfm"])
+        self.assertTrue(images["same.pfm"]["success"])
+        self.assertEqual(images["same.pfm"]["error"], 0.0)
+        self.assertFalse(images["diff.pfm"]["success"])
+        self.assertAlmostEqual(images["diff.pfm"]["error"], 0.25**2, places=6)
+        self.assertFalse(images["only_a.pfm"]["success"])
+        self.assertIn("no counterpart", images["only_a.pfm"]["message"])
+
+        # All pairs passing returns success.
+        os.remove(self.dir / "a" / "only_a.pfm")
+        os.remove(self.dir / "a" / "diff.pfm")
+        os.remove(self.dir / "b" / "diff.pfm")
+        result = self.run_compare("-m", "mse", "--batch", self.dir / "a", self.dir / "b", "-r", report_path)
+        self.assertEqual(result.returncode, 0, result.stderr)
+
+    def test_manifest_report(self):
+        self.image("ref/x.pfm", gradient)
+        self.image("out/x.pfm", gradient)
+        self.image("ref/y.pfm", constant(0.5))
+        self.image("out/y.pfm", constant(0.25))
+        manifest_path = self.dir / "manifest.txt"
+        manifest_path.write_text("# reference\toutput\nref/x.pfm\tout/x.pfm\n\nref/y.pfm\tout/y.pfm\n")
+        report_path = self.dir / "report.csv"
+
+        result = self.run_compare("-m", "mae", "-t", "0.01", "--manifest", manifest_path, "-r", report_path)
+        self.assertNotEqual(result.returncode, 0)
+
+        with open(report_path, newline="") as f:
+            rows = list(csv.DictReader(f))
+        self.assertEqual([row["name"] for row in rows], ["out/x.pfm", "out/y.pfm"])
+        self.assertEqual(rows[0]["success"], "true")
+        self.assertEqual(rows[1]["success"], "false")
+        self.assertGreater(float(rows[1]["error"]), 0.01)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -11,6 +11,7 @@ import datetime
 import argparse
 import subprocess
 import shutil
+import tempfile
 from pathlib import Path
 from enum import Enum
 
@@ -259,7 +260,9 @@ class Test:
         image_reports = []
 
         # Compare every result image with the corresponding reference image and report missing references.
-        processes = {}
+        # All pairs are listed in a manifest and compared by a single ImageCompare process.
+        compared_images = []
+        manifest_lines = []
         for image in result_images:
             if not image in ref_images:
                 result = Test.Result.FAILED
@@ -269,30 +272,43 @@ class Test:
             ref_file = ref_dir / image
             result_file = result_dir / image
             error_file = result_dir / (str(image) + config.ERROR_IMAGE_SUFFIX)
-
-            args = [str(image_compare_exe), '-m', 'mse', '-t', str(self.tolerance), str(ref_file), str(result_file)]
-            if error_file:
-                args += ['-e', str(error_file)]
-            processes[image] = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
-            if not self.process_controller.add_process(self.name + ":image:" + str(image), processes[image]):
-                return Test.Result.FAILED, ['Process killed due to global exit']
-
-        for image, process in processes.items():
-
-            output = process.communicate()[0]
-            compare_success =  process.returncode == 0
-            compare_error = float(output.strip())
-
-            if not compare_success:
-                result = Test.Result.FAILED
-                messages.append(f'Test image "{image}" failed with error {compare_error}.')
-
-            image_reports.append({
-                'name': str(image),
-                'success': compare_success,
-                'error': compare_error,
-                'tolerance': self.tolerance
-            })
+            compared_images.append(image)
+            manifest_lines.append(f'{ref_file}\t{result_file}\t{error_file}\n')
+
+        if len(compared_images) > 0:
+            with tempfile.TemporaryDirectory() as temp_dir:
+                manifest_file = Path(temp_dir) / 'manifest.txt'
+                report_file = Path(temp_dir) / 'report.json'
+                manifest_file.write_text(''.join(manifest_lines))
+
+                args = [str(image_compare_exe), '-m', 'mse', '-t', str(self.tolerance), '--manifest', str(manifest_file), '-r', str(report_file)]
+                process = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+                if not self.process_controller.add_process(self.name + ":images", process):
+                    return Test.Result.FAILED, ['Process killed due to global exit'], []
+                output = process.communicate()[0]
+
+                if not report_file.exists():
+                    errors = list(map(lambda l: l.rstrip(), output.decode('utf-8').splitlines()))
+                    return Test.Result.FAILED, errors + [f'{image_compare_exe} exited with return code {process.returncode}'], []
+                report = json.loads(report_file.read_text())
+
+            for image, entry in zip(compared_images, report['images']):
+                compare_success = entry['success']
+                compare_error = entry['error']
+
+                if not compare_success:
+                    result = Test.Result.FAILED
+                    if 'message' in entry:
+                        messages.append(f'Test image "{image}" failed: {entry["message"]}')
+                    else:
+                        messages.append(f'Test image "{image}" failed with error {compare_error}.')
+
+                image_reports.append({
+                    'name': str(image),
+                    'success': compare_success,
+                    'error': compare_error,
+                    'tolerance': self.tolerance
+                })
 
         # Report missing result images for existing reference images.
         for image in ref_images: